@@ -0,0 +1,430 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures whether the host sustains a device at a sample rate: streams
+ * from a source into a null sink (or from a null source into a sink) for
+ * a while and reports the achieved rate, the overruns / underruns and
+ * drops from the stream statistics, the CPU time per channel and the
+ * latency percentiles. With --sweep the rates the device supports are
+ * tried one after another to find the highest sustainable one.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/null_source.h>
+
+#include <osmosdr/sink.h>
+#include <osmosdr/source.h>
+
+#define SUSTAINED_RATIO 0.99     // of the nominal rate a run must deliver
+
+/* counts the items passing, copying them through when it has an output */
+class counter : public gr::sync_block
+{
+public:
+  typedef std::shared_ptr<counter> sptr;
+
+  static sptr make( bool output )
+  {
+    return gnuradio::get_initial_sptr( new counter( output ) );
+  }
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items )
+  {
+    if ( output_items.size() )
+      memcpy( output_items[0], input_items[0], noutput_items * sizeof(gr_complex) );
+
+    _items.fetch_add( noutput_items, std::memory_order_relaxed );
+
+    return noutput_items;
+  }
+
+  uint64_t items() const { return _items.load( std::memory_order_relaxed ); }
+
+private:
+  counter( bool output ) :
+    gr::sync_block( "counter",
+                    gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+                    gr::io_signature::make( output ? 1 : 0, output ? 1 : 0,
+                                            sizeof(gr_complex) ) ),
+    _items(0)
+  {
+  }
+
+  std::atomic<uint64_t> _items;
+};
+
+struct options_t
+{
+  options_t() :
+    rate(0), freq(0), duration(10), warmup(1),
+    tx(false), sweep(false), sweep_min(0), sweep_max(0), step(1.25) {}
+
+  std::string args;
+  double rate;
+  double freq;
+  double duration;      // seconds measured per run
+  double warmup;        // seconds streamed before measuring
+  bool tx;
+  bool sweep;
+  double sweep_min;
+  double sweep_max;
+  double step;          // factor between the rates of continuous ranges
+};
+
+struct result_t
+{
+  double rate;
+  size_t nchan;
+  std::vector<double> achieved;
+  std::vector<osmosdr::stream_stats_t> stats;   // accumulated during the run
+  double cpu;           // seconds of process CPU time per second and channel
+
+  bool sustained() const
+  {
+    for (size_t chan = 0; chan < nchan; chan++)
+      if ( stats[chan].overruns || stats[chan].underruns || stats[chan].dropped ||
+           achieved[chan] < rate * SUSTAINED_RATIO )
+        return false;
+
+    return true;
+  }
+};
+
+static osmosdr::stream_stats_t stats_delta( const osmosdr::stream_stats_t &a,
+                                            const osmosdr::stream_stats_t &b )
+{
+  osmosdr::stream_stats_t d = b;
+
+  d.samples -= a.samples;
+  d.dropped -= a.dropped;
+  d.overruns -= a.overruns;
+  d.underruns -= a.underruns;
+  d.lost_packets -= a.lost_packets;
+  d.late -= a.late;
+  d.bursts -= a.bursts;
+  d.clipped -= a.clipped;
+  d.restarts -= a.restarts;
+
+  return d;
+}
+
+static double cpu_seconds()
+{
+  return double( std::clock() ) / CLOCKS_PER_SEC;
+}
+
+static void sleep_for( double seconds )
+{
+  std::this_thread::sleep_for( std::chrono::duration<double>( seconds ) );
+}
+
+/* a device accessed through the source or the sink interface */
+class device_t
+{
+public:
+  device_t( const options_t &opts )
+  {
+    if ( opts.tx )
+      _sink = osmosdr::sink::make( opts.args );
+    else
+      _source = osmosdr::source::make( opts.args );
+  }
+
+  gr::basic_block_sptr block()
+  {
+    if ( _sink )
+      return _sink;
+    return _source;
+  }
+
+  size_t get_num_channels()
+  {
+    return _sink ? _sink->get_num_channels() : _source->get_num_channels();
+  }
+
+  osmosdr::meta_range_t get_sample_rates()
+  {
+    return _sink ? _sink->get_sample_rates() : _source->get_sample_rates();
+  }
+
+  double set_sample_rate( double rate )
+  {
+    return _sink ? _sink->set_sample_rate( rate ) : _source->set_sample_rate( rate );
+  }
+
+  double get_sample_rate()
+  {
+    return _sink ? _sink->get_sample_rate() : _source->get_sample_rate();
+  }
+
+  void set_center_freq( double freq )
+  {
+    for (size_t chan = 0; chan < get_num_channels(); chan++)
+      if ( _sink )
+        _sink->set_center_freq( freq, chan );
+      else
+        _source->set_center_freq( freq, chan );
+  }
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan )
+  {
+    return _sink ? _sink->get_stream_stats( chan ) : _source->get_stream_stats( chan );
+  }
+
+private:
+  osmosdr::source::sptr _source;
+  osmosdr::sink::sptr _sink;
+};
+
+static result_t run( device_t &dev, double rate, const options_t &opts )
+{
+  result_t result;
+
+  /* 0 keeps the rate the device is at */
+  result.rate = rate ? dev.set_sample_rate( rate ) : dev.get_sample_rate();
+  result.nchan = dev.get_num_channels();
+
+  gr::top_block_sptr tb = gr::make_top_block( "osmocom_bench" );
+  std::vector<counter::sptr> counters;
+
+  for (size_t chan = 0; chan < result.nchan; chan++) {
+    counter::sptr count = counter::make( opts.tx );
+
+    if ( opts.tx ) {
+      gr::blocks::null_source::sptr null = gr::blocks::null_source::make( sizeof(gr_complex) );
+      tb->connect( null, 0, count, 0 );
+      tb->connect( count, 0, dev.block(), chan );
+    } else {
+      tb->connect( dev.block(), chan, count, 0 );
+    }
+
+    counters.push_back( count );
+  }
+
+  tb->start();
+  sleep_for( opts.warmup );
+
+  std::vector<osmosdr::stream_stats_t> stats0;
+  std::vector<uint64_t> items0;
+  for (size_t chan = 0; chan < result.nchan; chan++) {
+    stats0.push_back( dev.get_stream_stats( chan ) );
+    items0.push_back( counters[chan]->items() );
+  }
+  const double cpu0 = cpu_seconds();
+  const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+  sleep_for( opts.duration );
+
+  const double elapsed =
+      std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+  const double cpu = cpu_seconds() - cpu0;
+
+  for (size_t chan = 0; chan < result.nchan; chan++) {
+    result.stats.push_back( stats_delta( stats0[chan], dev.get_stream_stats( chan ) ) );
+    result.achieved.push_back( (counters[chan]->items() - items0[chan]) / elapsed );
+  }
+  result.cpu = cpu / elapsed / result.nchan;
+
+  tb->stop();
+  tb->wait();
+
+  return result;
+}
+
+static void print_header()
+{
+  printf( "%12s %4s %12s %9s %9s %10s %7s %9s %9s %9s\n",
+          "rate", "chan", "achieved", "overruns", "underruns", "dropped",
+          "cpu", "lat p50", "lat p99", "lat max" );
+}
+
+static void print_result( const result_t &result )
+{
+  for (size_t chan = 0; chan < result.nchan; chan++) {
+    const osmosdr::stream_stats_t &stats = result.stats[chan];
+
+    printf( "%12.0f %4zu %12.0f %9llu %9llu %10llu %6.1f%%",
+            result.rate, chan, result.achieved[chan],
+            (unsigned long long)stats.overruns, (unsigned long long)stats.underruns,
+            (unsigned long long)stats.dropped, result.cpu * 100 );
+
+    /* only measured when built with ENABLE_LATENCY_STATS */
+    if ( stats.latency_max > 0 )
+      printf( " %7.0fus %7.0fus %7.0fus\n",
+              stats.latency_p50, stats.latency_p99, stats.latency_max );
+    else
+      printf( " %9s %9s %9s\n", "-", "-", "-" );
+  }
+}
+
+/* the rates to try, discrete ones as given and continuous ranges in steps */
+static std::vector<double> sweep_rates( const osmosdr::meta_range_t &range,
+                                        const options_t &opts )
+{
+  std::vector<double> rates;
+
+  for (const osmosdr::range_t &r : range) {
+    if ( r.start() == r.stop() ) {
+      rates.push_back( r.start() );
+      continue;
+    }
+
+    for (double rate = r.start(); rate < r.stop(); rate *= opts.step)
+      rates.push_back( r.step() > 0 ? r.start() + std::round( (rate - r.start()) / r.step() ) * r.step()
+                                    : rate );
+    rates.push_back( r.stop() );
+  }
+
+  std::sort( rates.begin(), rates.end() );
+  rates.erase( std::unique( rates.begin(), rates.end() ), rates.end() );
+
+  std::vector<double> selected;
+  for (double rate : rates)
+    if ( rate >= opts.sweep_min && ( ! opts.sweep_max || rate <= opts.sweep_max ) )
+      selected.push_back( rate );
+
+  return selected;
+}
+
+static void usage( const char *name )
+{
+  fprintf( stderr,
+           "usage: %s [options] <device args>\n"
+           "  --rate=<sps>         sample rate, the device default if not given\n"
+           "  --freq=<Hz>          center frequency\n"
+           "  --time=<s>           seconds measured per run (10)\n"
+           "  --warmup=<s>         seconds streamed before measuring (1)\n"
+           "  --tx                 measure the sink, fed from a null source\n"
+           "  --sweep[=<min>:<max>] try the supported rates, slowest first, until one\n"
+           "                       isn't sustained\n"
+           "  --step=<factor>      between the rates of continuous ranges (1.25)\n",
+           name );
+}
+
+static bool parse_options( int argc, char **argv, options_t &opts )
+{
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find( '=' );
+    const std::string key = arg.substr( 0, eq );
+    const std::string value = eq == std::string::npos ? "" : arg.substr( eq + 1 );
+
+    if ( key == "--rate" )
+      opts.rate = std::stod( value );
+    else if ( key == "--freq" )
+      opts.freq = std::stod( value );
+    else if ( key == "--time" )
+      opts.duration = std::stod( value );
+    else if ( key == "--warmup" )
+      opts.warmup = std::stod( value );
+    else if ( key == "--tx" )
+      opts.tx = true;
+    else if ( key == "--step" )
+      opts.step = std::stod( value );
+    else if ( key == "--sweep" ) {
+      opts.sweep = true;
+      if ( value.size() ) {
+        const size_t colon = value.find( ':' );
+        opts.sweep_min = std::stod( value.substr( 0, colon ) );
+        if ( colon != std::string::npos )
+          opts.sweep_max = std::stod( value.substr( colon + 1 ) );
+      }
+    }
+    else if ( key.compare( 0, 2, "--" ) && opts.args.empty() )
+      opts.args = arg;
+    else
+      return false;
+  }
+
+  return opts.duration > 0 && opts.warmup >= 0 && opts.step > 1;
+}
+
+int main( int argc, char **argv )
+{
+  options_t opts;
+
+  try {
+    if ( ! parse_options( argc, argv, opts ) ) {
+      usage( argv[0] );
+      return 1;
+    }
+  } catch ( std::exception &ex ) {
+    usage( argv[0] );
+    return 1;
+  }
+
+  try {
+    device_t dev( opts );
+
+    if ( opts.freq )
+      dev.set_center_freq( opts.freq );
+
+    print_header();
+
+    if ( ! opts.sweep ) {
+      result_t result = run( dev, opts.rate, opts );
+      print_result( result );
+      return result.sustained() ? 0 : 2;
+    }
+
+    std::vector<double> rates = sweep_rates( dev.get_sample_rates(), opts );
+    double best = 0;
+
+    for (double rate : rates) {
+      result_t result = run( dev, rate, opts );
+      print_result( result );
+
+      if ( ! result.sustained() )
+        break;
+
+      best = result.rate;
+    }
+
+    if ( best > 0 )
+      printf( "highest sustained rate: %.0f\n", best );
+    else
+      printf( "no rate sustained\n" );
+
+    return best > 0 ? 0 : 2;
+  } catch ( std::exception &ex ) {
+    std::cerr << "osmocom_bench: " << ex.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,534 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures the host to air to host latency of a full-duplex device: a
+ * sink transmits markers, a source on the same device receives them, and
+ * the time between handing a marker to the flowgraph and seeing it come
+ * back is recorded. The markers go over the air, a cable with an
+ * attenuator, or a digital loopback of the device (xtrx with
+ * --rx=loopback). Every combination of the --buflen, --buffers and
+ * --transfers values is run in turn, each with freshly opened devices.
+ *
+ * A marker is a preamble followed by its 8 bit sequence number, keyed on
+ * and off in symbols of --symbol samples, so a late marker isn't taken
+ * for the next one. The times are taken by the host when the generator
+ * and the detector get the marker, so the latency includes the buffering
+ * of the flowgraph in front of the sink, which is kept to --gr-buffer
+ * items.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/top_block.h>
+
+#include <osmosdr/sink.h>
+#include <osmosdr/source.h>
+
+#define SEQ_BITS 8
+#define SEQ_COUNT (1 << SEQ_BITS)
+#define PREAMBLE_SYMBOLS 4
+
+typedef std::chrono::steady_clock clock_type;
+
+static double seconds_since( const clock_type::time_point &t0 )
+{
+  return std::chrono::duration<double>( clock_type::now() - t0 ).count();
+}
+
+/* the markers sent so far, by sequence number */
+struct marker_log_t
+{
+  marker_log_t() : sent(0), received(0), bad(0)
+  {
+    for (size_t i = 0; i < SEQ_COUNT; i++)
+      when[i] = -1;
+  }
+
+  std::mutex lock;
+  double when[SEQ_COUNT];       // seconds since the start, -1 if not sent
+  uint64_t sent;
+  uint64_t received;
+  uint64_t bad;                 // detected, but not as a marker sent
+  std::vector<double> latency;
+};
+
+/* transmits a marker every interval, zeros in between */
+class marker_source : public gr::sync_block
+{
+public:
+  typedef std::shared_ptr<marker_source> sptr;
+
+  static sptr make( marker_log_t &log, const clock_type::time_point &t0,
+                    size_t period, size_t symbol, float amplitude )
+  {
+    return gnuradio::get_initial_sptr( new marker_source( log, t0, period, symbol, amplitude ) );
+  }
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items )
+  {
+    gr_complex *out = (gr_complex *)output_items[0];
+    const size_t length = (PREAMBLE_SYMBOLS + SEQ_BITS) * _symbol;
+
+    for (int i = 0; i < noutput_items; i++, _pos++) {
+      const size_t phase = _pos % _period;
+
+      if ( 0 == phase ) {
+        std::lock_guard<std::mutex> lock( _log.lock );
+        _seq = _log.sent++ % SEQ_COUNT;
+        _log.when[_seq] = seconds_since( _t0 );
+      }
+
+      bool on = false;
+      if ( phase < PREAMBLE_SYMBOLS * _symbol )
+        on = true;
+      else if ( phase < length )
+        on = (_seq >> (phase / _symbol - PREAMBLE_SYMBOLS)) & 1;
+
+      out[i] = on ? gr_complex( _amplitude, 0 ) : gr_complex( 0, 0 );
+    }
+
+    return noutput_items;
+  }
+
+private:
+  marker_source( marker_log_t &log, const clock_type::time_point &t0,
+                 size_t period, size_t symbol, float amplitude ) :
+    gr::sync_block( "marker_source",
+                    gr::io_signature::make( 0, 0, 0 ),
+                    gr::io_signature::make( 1, 1, sizeof(gr_complex) ) ),
+    _log(log), _t0(t0), _period(period), _symbol(symbol), _amplitude(amplitude),
+    _pos(0), _seq(0)
+  {
+  }
+
+  marker_log_t &_log;
+  clock_type::time_point _t0;
+  size_t _period;               // samples from marker to marker
+  size_t _symbol;
+  float _amplitude;
+  uint64_t _pos;
+  size_t _seq;
+};
+
+/* finds the markers by their power and reads their sequence number */
+class marker_detector : public gr::sync_block
+{
+public:
+  typedef std::shared_ptr<marker_detector> sptr;
+
+  static sptr make( marker_log_t &log, const clock_type::time_point &t0,
+                    size_t symbol, float threshold )
+  {
+    return gnuradio::get_initial_sptr( new marker_detector( log, t0, symbol, threshold ) );
+  }
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items )
+  {
+    const gr_complex *in = (const gr_complex *)input_items[0];
+    const double now = seconds_since( _t0 );
+
+    for (int i = 0; i < noutput_items; i++, _pos++) {
+      /* mean power over a quarter symbol */
+      const float power = std::norm( in[i] );
+      _sum += power - _window[_pos % _window.size()];
+      _window[_pos % _window.size()] = power;
+      const bool on = _sum > _threshold * _window.size();
+
+      if ( ! _in_marker ) {
+        /* an edge only counts after at least a symbol of silence */
+        if ( on && _off >= _symbol ) {
+          _in_marker = true;
+          _edge = _pos;
+          _when = now;
+          _seq = 0;
+        }
+        _off = on ? 0 : _off + 1;
+        continue;
+      }
+
+      /* the middle of every bit after the preamble */
+      const uint64_t offset = _pos - _edge;
+      if ( offset < PREAMBLE_SYMBOLS * _symbol || (offset % _symbol) != _symbol / 2 )
+        continue;
+
+      const size_t bit = offset / _symbol - PREAMBLE_SYMBOLS;
+      if ( on )
+        _seq |= 1 << bit;
+
+      if ( bit == SEQ_BITS - 1 ) {
+        received();
+        _in_marker = false;
+        _off = 0;
+      }
+    }
+
+    return noutput_items;
+  }
+
+private:
+  marker_detector( marker_log_t &log, const clock_type::time_point &t0,
+                   size_t symbol, float threshold ) :
+    gr::sync_block( "marker_detector",
+                    gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+                    gr::io_signature::make( 0, 0, 0 ) ),
+    _log(log), _t0(t0), _symbol(symbol), _threshold(threshold),
+    _window( std::max( symbol / 4, size_t(1) ), 0.0f ), _sum(0),
+    _pos(0), _off(0), _in_marker(false), _edge(0), _when(0), _seq(0)
+  {
+  }
+
+  void received()
+  {
+    std::lock_guard<std::mutex> lock( _log.lock );
+
+    /* sent and not already taken, a marker can't come back before it left */
+    if ( _log.when[_seq] < 0 || _log.when[_seq] > _when ) {
+      _log.bad++;
+      return;
+    }
+
+    _log.latency.push_back( _when - _log.when[_seq] );
+    _log.when[_seq] = -1;
+    _log.received++;
+  }
+
+  marker_log_t &_log;
+  clock_type::time_point _t0;
+  size_t _symbol;
+  float _threshold;             // linear power
+  std::vector<float> _window;
+  double _sum;
+  uint64_t _pos;
+  uint64_t _off;                // samples below the threshold
+  bool _in_marker;
+  uint64_t _edge;               // sample the preamble started at
+  double _when;                 // host time of the work() call that saw it
+  size_t _seq;
+};
+
+struct options_t
+{
+  options_t() :
+    rate(2e6), freq(0), tx_gain(-1), rx_gain(-1), duration(10), warmup(1),
+    interval(0.1), symbol(128), amplitude(0.5), threshold(-30), gr_buffer(8192) {}
+
+  std::string args;
+  std::string rx_args;  // appended to args for the source only
+  std::string tx_args;  // and for the sink only
+  double rate;
+  double freq;
+  double tx_gain;       // dB, not set when negative
+  double rx_gain;
+  double duration;      // seconds measured per run
+  double warmup;        // seconds streamed before measuring
+  double interval;      // seconds from marker to marker
+  size_t symbol;        // samples per marker symbol
+  double amplitude;
+  double threshold;     // dBFS a symbol counts as on above
+  size_t gr_buffer;     // items between the marker source and the sink
+  std::vector<std::string> buflen;
+  std::vector<std::string> buffers;
+  std::vector<std::string> transfers;
+};
+
+struct result_t
+{
+  std::string buflen, buffers, transfers;
+  uint64_t sent;
+  uint64_t received;
+  uint64_t bad;
+  std::vector<double> latency;  // seconds, sorted
+};
+
+static void sleep_for( double seconds )
+{
+  std::this_thread::sleep_for( std::chrono::duration<double>( seconds ) );
+}
+
+static std::string join_args( const std::string &args, const std::string &extra )
+{
+  if ( extra.empty() )
+    return args;
+  return args.empty() ? extra : args + "," + extra;
+}
+
+static result_t run( const options_t &opts, const std::string &buflen,
+                     const std::string &buffers, const std::string &transfers )
+{
+  result_t result;
+  result.buflen = buflen;
+  result.buffers = buffers;
+  result.transfers = transfers;
+
+  std::string buf_args;
+  if ( buflen.size() )
+    buf_args = join_args( buf_args, "buflen=" + buflen );
+  if ( buffers.size() )
+    buf_args = join_args( buf_args, "buffers=" + buffers );
+  if ( transfers.size() )
+    buf_args = join_args( buf_args, "transfers=" + transfers );
+
+  const std::string args = join_args( opts.args, buf_args );
+
+  osmosdr::source::sptr source = osmosdr::source::make( join_args( args, opts.rx_args ) );
+  osmosdr::sink::sptr sink = osmosdr::sink::make( join_args( args, opts.tx_args ) );
+
+  const double rate = source->set_sample_rate( opts.rate );
+  if ( sink->set_sample_rate( opts.rate ) != rate )
+    throw std::runtime_error( "the source and the sink ended up at different rates" );
+
+  if ( opts.freq ) {
+    source->set_center_freq( opts.freq );
+    sink->set_center_freq( opts.freq );
+  }
+  if ( opts.rx_gain >= 0 )
+    source->set_gain( opts.rx_gain );
+  if ( opts.tx_gain >= 0 )
+    sink->set_gain( opts.tx_gain );
+
+  marker_log_t log;
+  const clock_type::time_point t0 = clock_type::now();
+  const size_t period = size_t( std::llround( opts.interval * rate ) );
+
+  if ( period < (PREAMBLE_SYMBOLS + SEQ_BITS + 2) * opts.symbol )
+    throw std::runtime_error( "the interval is too short for a marker at this rate" );
+
+  marker_source::sptr markers = marker_source::make( log, t0, period, opts.symbol,
+                                                     opts.amplitude );
+  marker_detector::sptr detector = marker_detector::make( log, t0, opts.symbol,
+                                                          std::pow( 10.0, opts.threshold / 10 ) );
+  markers->set_max_output_buffer( opts.gr_buffer );
+
+  gr::top_block_sptr tb = gr::make_top_block( "osmocom_loopback" );
+  tb->connect( markers, 0, sink, 0 );
+  tb->connect( source, 0, detector, 0 );
+
+  tb->start();
+  sleep_for( opts.warmup );
+
+  uint64_t sent0, received0, bad0;
+  {
+    std::lock_guard<std::mutex> lock( log.lock );
+    sent0 = log.sent;
+    received0 = log.received;
+    bad0 = log.bad;
+    log.latency.clear();
+  }
+
+  sleep_for( opts.duration );
+
+  tb->stop();
+  tb->wait();
+
+  result.sent = log.sent - sent0;
+  result.received = log.received - received0;
+  result.bad = log.bad - bad0;
+  result.latency = log.latency;
+  std::sort( result.latency.begin(), result.latency.end() );
+
+  return result;
+}
+
+static double percentile( const std::vector<double> &sorted, double p )
+{
+  if ( sorted.empty() )
+    return 0;
+
+  size_t index = size_t( std::ceil( p * sorted.size() ) );
+  return sorted[ std::min( index ? index - 1 : 0, sorted.size() - 1 ) ];
+}
+
+static void print_header()
+{
+  printf( "%8s %8s %9s %7s %7s %5s %9s %9s %9s %9s %9s\n",
+          "buflen", "buffers", "transfers", "sent", "recv", "bad",
+          "lat min", "lat p50", "lat p90", "lat p99", "lat max" );
+}
+
+static void print_result( const result_t &result )
+{
+  printf( "%8s %8s %9s %7llu %7llu %5llu",
+          result.buflen.size() ? result.buflen.c_str() : "-",
+          result.buffers.size() ? result.buffers.c_str() : "-",
+          result.transfers.size() ? result.transfers.c_str() : "-",
+          (unsigned long long)result.sent, (unsigned long long)result.received,
+          (unsigned long long)result.bad );
+
+  if ( result.latency.empty() ) {
+    printf( " %9s %9s %9s %9s %9s\n", "-", "-", "-", "-", "-" );
+    return;
+  }
+
+  const std::vector<double> &lat = result.latency;
+  printf( " %7.2fms %7.2fms %7.2fms %7.2fms %7.2fms\n",
+          lat.front() * 1e3, percentile( lat, 0.5 ) * 1e3, percentile( lat, 0.9 ) * 1e3,
+          percentile( lat, 0.99 ) * 1e3, lat.back() * 1e3 );
+}
+
+static std::vector<std::string> split_list( const std::string &value )
+{
+  std::vector<std::string> list;
+  std::stringstream ss( value );
+  std::string item;
+
+  while ( std::getline( ss, item, ',' ) )
+    if ( item.size() )
+      list.push_back( item );
+
+  return list;
+}
+
+static void usage( const char *name )
+{
+  fprintf( stderr,
+           "usage: %s [options] <device args>\n"
+           "  --rx=<args>          appended to the device args of the source\n"
+           "  --tx=<args>          appended to the device args of the sink\n"
+           "  --rate=<sps>         sample rate (2e6)\n"
+           "  --freq=<Hz>          center frequency of both\n"
+           "  --rx-gain=<dB>       receive gain\n"
+           "  --tx-gain=<dB>       transmit gain\n"
+           "  --time=<s>           seconds measured per run (10)\n"
+           "  --warmup=<s>         seconds streamed before measuring (1)\n"
+           "  --interval=<s>       from marker to marker (0.1)\n"
+           "  --symbol=<samples>   length of a marker symbol (128)\n"
+           "  --amplitude=<a>      of the markers (0.5)\n"
+           "  --threshold=<dBFS>   received power a symbol counts as on above (-30)\n"
+           "  --gr-buffer=<items>  in front of the sink (8192)\n"
+           "  --buflen=<n,...>     buflen= values to run with\n"
+           "  --buffers=<n,...>    buffers= values to run with\n"
+           "  --transfers=<n,...>  transfers= values to run with\n",
+           name );
+}
+
+static bool parse_options( int argc, char **argv, options_t &opts )
+{
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find( '=' );
+    const std::string key = arg.substr( 0, eq );
+    const std::string value = eq == std::string::npos ? "" : arg.substr( eq + 1 );
+
+    if ( key == "--rx" )
+      opts.rx_args = value;
+    else if ( key == "--tx" )
+      opts.tx_args = value;
+    else if ( key == "--rate" )
+      opts.rate = std::stod( value );
+    else if ( key == "--freq" )
+      opts.freq = std::stod( value );
+    else if ( key == "--rx-gain" )
+      opts.rx_gain = std::stod( value );
+    else if ( key == "--tx-gain" )
+      opts.tx_gain = std::stod( value );
+    else if ( key == "--time" )
+      opts.duration = std::stod( value );
+    else if ( key == "--warmup" )
+      opts.warmup = std::stod( value );
+    else if ( key == "--interval" )
+      opts.interval = std::stod( value );
+    else if ( key == "--symbol" )
+      opts.symbol = std::stoul( value );
+    else if ( key == "--amplitude" )
+      opts.amplitude = std::stod( value );
+    else if ( key == "--threshold" )
+      opts.threshold = std::stod( value );
+    else if ( key == "--gr-buffer" )
+      opts.gr_buffer = std::stoul( value );
+    else if ( key == "--buflen" )
+      opts.buflen = split_list( value );
+    else if ( key == "--buffers" )
+      opts.buffers = split_list( value );
+    else if ( key == "--transfers" )
+      opts.transfers = split_list( value );
+    else if ( key.compare( 0, 2, "--" ) && opts.args.empty() )
+      opts.args = arg;
+    else
+      return false;
+  }
+
+  return opts.rate > 0 && opts.duration > 0 && opts.warmup >= 0 &&
+         opts.interval > 0 && opts.symbol >= 4 && opts.gr_buffer > 0;
+}
+
+int main( int argc, char **argv )
+{
+  options_t opts;
+
+  try {
+    if ( ! parse_options( argc, argv, opts ) ) {
+      usage( argv[0] );
+      return 1;
+    }
+  } catch ( std::exception &ex ) {
+    usage( argv[0] );
+    return 1;
+  }
+
+  /* an empty value leaves the setting to the device */
+  if ( opts.buflen.empty() )
+    opts.buflen.push_back( "" );
+  if ( opts.buffers.empty() )
+    opts.buffers.push_back( "" );
+  if ( opts.transfers.empty() )
+    opts.transfers.push_back( "" );
+
+  try {
+    bool none = false;
+
+    print_header();
+
+    for (const std::string &buflen : opts.buflen)
+      for (const std::string &buffers : opts.buffers)
+        for (const std::string &transfers : opts.transfers) {
+          result_t result = run( opts, buflen, buffers, transfers );
+          print_result( result );
+          fflush( stdout );
+
+          if ( result.latency.empty() )
+            none = true;
+        }
+
+    return none ? 2 : 0;
+  } catch ( std::exception &ex ) {
+    std::cerr << "osmocom_loopback: " << ex.what() << std::endl;
+    return 1;
+  }
+}
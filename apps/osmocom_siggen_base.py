@@ -54,9 +54,13 @@ import sys
 import math
 import numpy
 import random
+from fractions import Fraction
 
 n2s = eng_notation.num_to_str
 
+# longest waveform handed to the sink to loop, in samples
+MAX_CYCLIC_LEN = 1 << 22
+
 waveforms = { analog.GR_SIN_WAVE    : "Sinusoid",
               analog.GR_CONST_WAVE  : "Constant",
               analog.GR_GAUSSIAN    : "Gaussian Noise",
@@ -136,6 +140,9 @@ class top_block(gr.top_block, pubsub):
         gr.top_block.__init__(self)
         pubsub.__init__(self)
         self._verbose = options.verbose
+        self._cyclic = options.cyclic
+        self._waveform_file = options.waveform_file
+        self._waveform_format = options.waveform_format
 
         #initialize values from options
         self._setup_osmosdr(options)
@@ -361,7 +368,9 @@ class top_block(gr.top_block, pubsub):
             print("Set frequency correction to:", ppm)
 
     def set_waveform_freq(self, freq):
-        if self[TYPE_KEY] == analog.GR_SIN_WAVE:
+        if self._looping():
+            self[TYPE_KEY] = self[TYPE_KEY]
+        elif self[TYPE_KEY] == analog.GR_SIN_WAVE:
             self._src.set_frequency(freq)
         elif self[TYPE_KEY] == "2tone":
             self._src1.set_frequency(freq)
@@ -374,16 +383,82 @@ class top_block(gr.top_block, pubsub):
         if freq is None:
             self[WAVEFORM2_FREQ_KEY] = -self[WAVEFORM_FREQ_KEY]
             return
-        if self[TYPE_KEY] == "2tone":
+        if self._looping():
+            self[TYPE_KEY] = self[TYPE_KEY]
+        elif self[TYPE_KEY] == "2tone":
             self._src2.set_frequency(freq)
         elif self[TYPE_KEY] == "sweep":
             self._src1.set_frequency(freq)
         return True
 
+    def _looping(self):
+        """The sink loops the waveform and the flowgraph only feeds it zeros"""
+        return (self._cyclic or self._waveform_file is not None) and self[TYPE_KEY] is not None
+
+    def _cyclic_period(self, freq):
+        """Samples and cycles of the shortest loop close to a tone of freq"""
+        ratio = Fraction(freq / self[SAMP_RATE_KEY]).limit_denominator(MAX_CYCLIC_LEN)
+        return (ratio.denominator, ratio.numerator)
+
+    def _cyclic_waveform(self, type):
+        """One period of the waveform, for the sink to loop"""
+        ampl = self[AMPLITUDE_KEY]
+        rate = self[SAMP_RATE_KEY]
+
+        if type == analog.GR_CONST_WAVE:
+            return numpy.full(1024, ampl, dtype=numpy.complex64)
+
+        if type == analog.GR_SIN_WAVE:
+            n, cycles = self._cyclic_period(self[WAVEFORM_FREQ_KEY])
+            phase = 2 * math.pi * cycles * numpy.arange(n) / n + self[WAVEFORM_OFFSET_KEY]
+            if self._verbose:
+                print("Looping %d samples, tone at %sHz" % (n, n2s(rate * cycles / n)))
+            return (ampl * numpy.exp(1j * phase)).astype(numpy.complex64)
+
+        if type == "2tone":
+            freq2 = self[WAVEFORM2_FREQ_KEY]
+            if freq2 is None:
+                freq2 = -self[WAVEFORM_FREQ_KEY]
+            n1, c1 = self._cyclic_period(self[WAVEFORM_FREQ_KEY])
+            n2, c2 = self._cyclic_period(freq2)
+            n = n1 * n2 // math.gcd(n1, n2)
+            if n > MAX_CYCLIC_LEN:
+                raise RuntimeError("The tones don't repeat within %d samples" % MAX_CYCLIC_LEN)
+            k = numpy.arange(n)
+            wave = numpy.exp(2j * math.pi * c1 * (n // n1) * k / n) + \
+                   numpy.exp(2j * math.pi * c2 * (n // n2) * k / n)
+            return (ampl / 2.0 * wave).astype(numpy.complex64)
+
+        if type == "sweep":
+            sweep_rate = self[WAVEFORM2_FREQ_KEY]
+            if sweep_rate is None:
+                sweep_rate = 0.1
+            n = int(round(rate / sweep_rate))
+            if n > MAX_CYCLIC_LEN:
+                raise RuntimeError("A sweep takes more than %d samples" % MAX_CYCLIC_LEN)
+            # triangle from -0.5 to 0.5 and back, the phase returns every period
+            tri = 0.5 - numpy.abs(numpy.arange(n) / n - 0.5) * 2
+            phase = numpy.cumsum(2 * math.pi * self[WAVEFORM_FREQ_KEY] * tri / rate)
+            return (ampl * numpy.exp(1j * phase)).astype(numpy.complex64)
+
+        if type == analog.GR_GAUSSIAN:
+            wave = numpy.random.normal(0, ampl / math.sqrt(2), (MAX_CYCLIC_LEN, 2))
+        elif type == analog.GR_UNIFORM:
+            wave = numpy.random.uniform(-ampl, ampl, (MAX_CYCLIC_LEN, 2))
+        else:
+            raise RuntimeError("This waveform type can't be looped by the sink")
+        return (wave[:, 0] + 1j * wave[:, 1]).astype(numpy.complex64)
+
     def set_waveform(self, type):
         self.lock()
         self.disconnect_all()
-        if type == analog.GR_SIN_WAVE or type == analog.GR_CONST_WAVE:
+        if self._waveform_file is not None:
+            self._src = blocks.null_source(gr.sizeof_gr_complex)
+            self._sink.load_waveform(self._waveform_file, self._waveform_format)
+        elif self._cyclic:
+            self._src = blocks.null_source(gr.sizeof_gr_complex)
+            self._sink.set_waveform(self._cyclic_waveform(type))
+        elif type == analog.GR_SIN_WAVE or type == analog.GR_CONST_WAVE:
             self._src = analog.sig_source_c(self[SAMP_RATE_KEY],        # Sample rate
                                         type,                       # Waveform type
                                         self[WAVEFORM_FREQ_KEY],    # Waveform frequency
@@ -453,7 +528,9 @@ class top_block(gr.top_block, pubsub):
                 print("Amplitude out of range:", amplitude)
             return False
 
-        if self[TYPE_KEY] in (analog.GR_SIN_WAVE, analog.GR_CONST_WAVE, analog.GR_GAUSSIAN, analog.GR_UNIFORM):
+        if self._looping():
+            self[TYPE_KEY] = self[TYPE_KEY]
+        elif self[TYPE_KEY] in (analog.GR_SIN_WAVE, analog.GR_CONST_WAVE, analog.GR_GAUSSIAN, analog.GR_UNIFORM):
             self._src.set_amplitude(amplitude)
         elif self[TYPE_KEY] == "2tone":
             self._src1.set_amplitude(amplitude/2.0)
@@ -514,6 +591,12 @@ def get_options():
     parser.add_option("", "--amplitude", type="eng_float", default=0.3,
                       help="Set output amplitude to AMPL (0.1-1.0) [default=%default]",
                       metavar="AMPL")
+    parser.add_option("", "--cyclic", action="store_true", default=False,
+                      help="Compute one period of the waveform and let the sink loop it")
+    parser.add_option("", "--waveform-file", type="string", default=None,
+                      help="Let the sink loop the waveform in FILE", metavar="FILE")
+    parser.add_option("", "--waveform-format", type="string", default="cf32",
+                      help="Set the sample format of the waveform file, cf32, cs16 or cs8 [default=%default]")
     parser.add_option("-v", "--verbose", action="store_true", default=False,
                       help="Use verbose console output [default=%default]")
 
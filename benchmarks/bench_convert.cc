@@ -0,0 +1,352 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Microbenchmarks of the sample conversion paths, run at the transfer
+ * sizes the backends use. Every kernel that takes part in a conversion
+ * is timed for all instruction sets the CPU supports.
+ *
+ * usage: osmosdr_bench_convert [--min-time=<s>] [filter]
+ *
+ * Only benchmarks whose name contains the filter are run. Cycles are
+ * counted with the time stamp counter on x86, which ticks at the
+ * nominal rate of the CPU and not the boosted one.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "sample_convert.h"
+#include "spsc_ring.h"
+#include "halfband_decimator.h"
+#include "airspy_fir_kernels.h"
+#include "airspy_iqconverter.h"
+
+/* transfer sizes in complex samples */
+#define RTL_TRANSFER      (16 * 32 * 512 / 2)   // BUF_LEN of bytes
+#define HACKRF_TRANSFER   (16 * 32 * 512 / 2)
+#define BLADERF_TRANSFER  4096                  // default buffer of libbladeRF
+#define RFSPACE16_TRANSFER 256                  // 1024 byte NetSDR packet
+#define RFSPACE24_TRANSFER 240                  // 1440 byte NetSDR packet
+#define SDRPLAY_TRANSFER  252                   // samples per packet in zero IF
+#define FREESRP_TRANSFER  2048
+#define AIRSPY_TRANSFER   (65536 / 4)           // 64 KiB of 16 bit values
+#define SINK_TRANSFER     8192
+
+struct result_t
+{
+  double samples_per_sec;
+  double cycles_per_sample;
+};
+
+static double g_min_time = 0.5;
+
+static uint64_t cycles()
+{
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* run fn, which converts nitems samples, until at least g_min_time passed */
+static result_t measure( size_t nitems, const std::function< void() > &fn )
+{
+  typedef std::chrono::steady_clock clock_t;
+
+  for (int i = 0; i < 16; i++)    // warm up caches and clocks
+    fn();
+
+  uint64_t iterations = 0;
+  const uint64_t c0 = cycles();
+  const clock_t::time_point t0 = clock_t::now();
+  double elapsed = 0;
+
+  do {
+    for (int i = 0; i < 64; i++)
+      fn();
+    iterations += 64;
+    elapsed = std::chrono::duration< double >( clock_t::now() - t0 ).count();
+  } while ( elapsed < g_min_time );
+
+  const uint64_t c1 = cycles();
+  const double samples = double(iterations) * nitems;
+
+  result_t result;
+  result.samples_per_sec = samples / elapsed;
+  result.cycles_per_sample = c1 > c0 ? (c1 - c0) / samples : 0;
+  return result;
+}
+
+static void report( const std::string &name, const char *isa, size_t nitems,
+                    const result_t &result )
+{
+  if ( result.cycles_per_sample > 0 )
+    printf( "%-28s %-8s %8zu %12.1f Msps %8.3f cyc/S\n", name.c_str(), isa,
+            nitems, result.samples_per_sec / 1e6, result.cycles_per_sample );
+  else
+    printf( "%-28s %-8s %8zu %12.1f Msps %8s\n", name.c_str(), isa,
+            nitems, result.samples_per_sec / 1e6, "-" );
+}
+
+template < typename T >
+static std::vector< T > random_values( size_t count, int low, int high )
+{
+  std::mt19937 gen( 42 );
+  std::uniform_int_distribution< int > dist( low, high );
+  std::vector< T > values( count );
+
+  for (T &value : values)
+    value = T( dist( gen ) );
+
+  return values;
+}
+
+static std::vector< float > random_floats( size_t count )
+{
+  std::mt19937 gen( 42 );
+  std::uniform_real_distribution< float > dist( -1.1f, 1.1f );  // some clip
+  std::vector< float > values( count );
+
+  for (float &value : values)
+    value = dist( gen );
+
+  return values;
+}
+
+static bool selected( const std::string &name, const std::string &filter )
+{
+  return filter.empty() || name.find( filter ) != std::string::npos;
+}
+
+static void bench_kernels( const convert_kernels_t &k, const std::string &filter )
+{
+  if ( selected( "rtl u8_f32", filter ) ) {
+    const size_t n = RTL_TRANSFER;
+    std::vector< uint8_t > in = random_values< uint8_t >( 2 * n, 0, 255 );
+    std::vector< float > out( 2 * n );
+    report( "rtl u8_f32", k.name, n,
+            measure( n, [&]() { k.u8_f32( &in[0], &out[0], 2 * n ); } ) );
+  }
+  if ( selected( "rtl u8_f32_lvl", filter ) ) {
+    const size_t n = RTL_TRANSFER;
+    std::vector< uint8_t > in = random_values< uint8_t >( 2 * n, 0, 255 );
+    std::vector< float > out( 2 * n );
+    convert_level_t level;
+    report( "rtl u8_f32_lvl", k.name, n,
+            measure( n, [&]() { k.u8_f32_lvl( &in[0], &out[0], 2 * n, &level ); } ) );
+  }
+
+
+  if ( selected( "rtl u8_s8", filter ) ) {
+    const size_t n = RTL_TRANSFER;
+    std::vector< uint8_t > in = random_values< uint8_t >( 2 * n, 0, 255 );
+    std::vector< int8_t > out( 2 * n );
+    report( "rtl u8_s8", k.name, n,
+            measure( n, [&]() { k.u8_s8( &in[0], &out[0], 2 * n ); } ) );
+  }
+
+  if ( selected( "hackrf s8_f32", filter ) ) {
+    const size_t n = HACKRF_TRANSFER;
+    std::vector< int8_t > in = random_values< int8_t >( 2 * n, -128, 127 );
+    std::vector< float > out( 2 * n );
+    report( "hackrf s8_f32", k.name, n,
+            measure( n, [&]() { k.s8_f32( &in[0], &out[0], 2 * n ); } ) );
+  }
+  if ( selected( "hackrf s8_f32_lvl", filter ) ) {
+    const size_t n = HACKRF_TRANSFER;
+    std::vector< int8_t > in = random_values< int8_t >( 2 * n, -128, 127 );
+    std::vector< float > out( 2 * n );
+    convert_level_t level;
+    report( "hackrf s8_f32_lvl", k.name, n,
+            measure( n, [&]() { k.s8_f32_lvl( &in[0], &out[0], 2 * n, &level ); } ) );
+  }
+
+
+  if ( selected( "hackrf sink f32_s8", filter ) ) {
+    const size_t n = HACKRF_TRANSFER;
+    std::vector< float > in = random_floats( 2 * n );
+    std::vector< int8_t > out( 2 * n );
+    report( "hackrf sink f32_s8", k.name, n,
+            measure( n, [&]() { k.f32_s8( &in[0], &out[0], 2 * n, 127.0f ); } ) );
+  }
+
+  if ( selected( "bladerf s16_f32", filter ) ) {
+    const size_t n = BLADERF_TRANSFER;
+    std::vector< int16_t > in = random_values< int16_t >( 2 * n, -2048, 2047 );
+    std::vector< float > out( 2 * n );
+    report( "bladerf s16_f32", k.name, n,
+            measure( n, [&]() { k.s16_f32( &in[0], &out[0], 2 * n, 1.0f / 2048 ); } ) );
+  }
+  if ( selected( "bladerf s16_f32_lvl", filter ) ) {
+    const size_t n = BLADERF_TRANSFER;
+    std::vector< int16_t > in = random_values< int16_t >( 2 * n, -2048, 2047 );
+    std::vector< float > out( 2 * n );
+    convert_level_t level;
+    report( "bladerf s16_f32_lvl", k.name, n,
+            measure( n, [&]() {
+              k.s16_f32_lvl( &in[0], &out[0], 2 * n, 1.0f / 2048, 2047, &level ); } ) );
+  }
+
+
+  if ( selected( "bladerf mimo s16_f32_deint", filter ) ) {
+    const size_t n = BLADERF_TRANSFER;
+    std::vector< int16_t > in = random_values< int16_t >( 4 * n, -2048, 2047 );
+    std::vector< float > out0( 2 * n ), out1( 2 * n );
+    float *out[] = { &out0[0], &out1[0] };
+    report( "bladerf mimo s16_f32_deint", k.name, n,
+            measure( n, [&]() { k.s16_f32_deint( &in[0], out, 2, n, 1.0f / 2048 ); } ) );
+  }
+
+  if ( selected( "bladerf sink f32_s16", filter ) ) {
+    const size_t n = BLADERF_TRANSFER;
+    std::vector< float > in = random_floats( 2 * n );
+    std::vector< int16_t > out( 2 * n );
+    report( "bladerf sink f32_s16", k.name, n,
+            measure( n, [&]() { k.f32_s16( &in[0], &out[0], 2 * n, 2047.0f ); } ) );
+  }
+
+  if ( selected( "bladerf mimo f32_s16_intl", filter ) ) {
+    const size_t n = BLADERF_TRANSFER;
+    std::vector< float > in0 = random_floats( 2 * n ), in1 = random_floats( 2 * n );
+    std::vector< int16_t > out( 4 * n );
+    const float *in[] = { &in0[0], &in1[0] };
+    report( "bladerf mimo f32_s16_intl", k.name, n,
+            measure( n, [&]() { k.f32_s16_intl( in, &out[0], 2, n, 2048.0f ); } ) );
+  }
+
+  if ( selected( "rfspace s16_f32", filter ) ) {
+    const size_t n = RFSPACE16_TRANSFER;
+    std::vector< int16_t > in = random_values< int16_t >( 2 * n, -32768, 32767 );
+    std::vector< float > out( 2 * n );
+    float *outs[] = { &out[0] };
+    report( "rfspace s16_f32", k.name, n,
+            measure( n, [&]() { k.s16_f32_deint( &in[0], outs, 1, n, 1.0f / 32768 ); } ) );
+  }
+
+  if ( selected( "rfspace s24_f32", filter ) ) {
+    const size_t n = RFSPACE24_TRANSFER;
+    std::vector< uint8_t > in = random_values< uint8_t >( 6 * n, 0, 255 );
+    std::vector< float > out( 2 * n );
+    float *outs[] = { &out[0] };
+    report( "rfspace s24_f32", k.name, n,
+            measure( n, [&]() { k.s24_f32_deint( &in[0], outs, 1, n, 1.0f / 8388608 ); } ) );
+  }
+
+  if ( selected( "sdrplay s16_f32_split", filter ) ) {
+    const size_t n = SDRPLAY_TRANSFER;
+    std::vector< int16_t > in_i = random_values< int16_t >( n, -2048, 2047 );
+    std::vector< int16_t > in_q = random_values< int16_t >( n, -2048, 2047 );
+    std::vector< float > out( 2 * n );
+    report( "sdrplay s16_f32_split", k.name, n,
+            measure( n, [&]() {
+              k.s16_f32_split( &in_i[0], &in_q[0], &out[0], n, 1.0f / 2048 ); } ) );
+  }
+
+  if ( selected( "freesrp s16_f32", filter ) ) {
+    const size_t n = FREESRP_TRANSFER;
+    std::vector< int16_t > in = random_values< int16_t >( 2 * n, -2048, 2047 );
+    std::vector< float > out( 2 * n );
+    report( "freesrp s16_f32", k.name, n,
+            measure( n, [&]() { k.s16_f32( &in[0], &out[0], 2 * n, 1.0f / 2048 ); } ) );
+  }
+}
+
+/* the paths that don't depend on the instruction set of the kernels */
+static void bench_other( const std::string &filter )
+{
+  if ( selected( "airspy ring push+pop", filter ) ) {
+    const size_t n = AIRSPY_TRANSFER;
+    spsc_ring< gr_complex > ring( 8 * n );
+    std::vector< gr_complex > in( n ), out( n );
+    report( "airspy ring push+pop", "-", n,
+            measure( n, [&]() { ring.push( &in[0], n ); ring.pop( &out[0], n ); } ) );
+  }
+
+  if ( selected( "airspy raw iqconverter", filter ) ) {
+    const size_t n = AIRSPY_TRANSFER / 2;
+    airspy_iqconverter conv;
+    conv.set_kernel( KERNEL_2_80, KERNEL_2_80_LEN );
+    std::vector< uint16_t > in = random_values< uint16_t >( 2 * n, 0, 4095 );
+    std::vector< gr_complex > out( n );
+    report( "airspy raw iqconverter", "-", n,
+            measure( n, [&]() { conv.process( &in[0], &out[0], n ); } ) );
+  }
+
+  if ( selected( "airspy packed unpack", filter ) ) {
+    const size_t nwords = AIRSPY_TRANSFER * 3 / 8;
+    std::vector< uint32_t > in = random_values< uint32_t >( nwords, 0, 0x7fffffff );
+    std::vector< uint16_t > out( AIRSPY_TRANSFER );
+    report( "airspy packed unpack", "-", AIRSPY_TRANSFER,
+            measure( AIRSPY_TRANSFER, [&]() {
+              airspy_iqconverter::unpack( &in[0], &out[0], nwords ); } ) );
+  }
+
+  if ( selected( "airspy decimator /4", filter ) ) {
+    const size_t n = AIRSPY_TRANSFER;
+    halfband_decimator decim;
+    decim.set_decimation( 4 );
+    std::vector< float > in = random_floats( 2 * n );
+    std::vector< gr_complex > out( n / 4 );
+    report( "airspy decimator /4", "-", n,
+            measure( n, [&]() {
+              decim.process( (const gr_complex *)&in[0], &out[0], n ); } ) );
+  }
+}
+
+int main( int argc, char **argv )
+{
+  std::string filter;
+
+  for (int i = 1; i < argc; i++) {
+    if ( ! strncmp( argv[i], "--min-time=", 11 ) ) {
+      g_min_time = atof( argv[i] + 11 );
+    } else if ( argv[i][0] == '-' ) {
+      fprintf( stderr, "usage: %s [--min-time=<s>] [filter]\n", argv[0] );
+      return 1;
+    } else {
+      filter = argv[i];
+    }
+  }
+
+  printf( "%-28s %-8s %8s %17s %14s\n", "benchmark", "isa", "samples",
+          "rate", "cycles" );
+
+  for (const convert_kernels_t *kernels : convert_supported_kernels())
+    bench_kernels( *kernels, filter );
+
+  bench_other( filter );
+
+  return 0;
+}
@@ -28,10 +28,17 @@ parameters:
 - id: type
   label: '${direction.title()}put Type'
   dtype: enum
+% if sourk == 'source':
+  options: [fc32, sc16, sc8]
+  option_labels: [Complex Float32, Complex Int16, Complex Int8]
+  option_attributes:
+      type: [fc32, sc16, sc8]
+% else:
   options: [fc32]
   option_labels: [Complex Float32]
   option_attributes:
       type: [fc32]
+% endif
   hide: part
 - id: args
   label: 'Device Arguments'
@@ -82,6 +89,9 @@ inputs:
 % if sourk == 'source':
 
 outputs:
+- domain: message
+  id: level
+  optional: true
 % endif
 - domain: stream
   dtype: ${'$'}{type.type}
@@ -100,7 +110,11 @@ templates:
      import time
   make: |
     osmosdr.${sourk}(
+% if sourk == 'source':
+        args="numchan=" + str(${'$'}{nchan}) + " type=${'$'}{type}" + " " + ${'$'}{args}
+% else:
         args="numchan=" + str(${'$'}{nchan}) + " " + ${'$'}{args}
+% endif
     )
     % for m in range(max_mboards):
     ${'%'} if context.get('num_mboards')() > ${m}:
@@ -180,7 +194,12 @@ documentation: |-
   By using the osmocom $sourk block you can take advantage of a common software api in your application(s) independent of the underlying radio hardware.
 
   Output Type:
+  % if sourk == 'source':
+  This parameter controls the data type of the stream in gnuradio. Complex int16 (sc16) and int8 (sc8) samples are scaled to the full integer range, devices without native support for the type are converted in software.
+  The type may also be given as type=fc32|sc16|sc8 in the device arguments, in which case it applies to all devices.
+  % else:
   This parameter controls the data type of the stream in gnuradio. Only complex float32 samples are supported at the moment.
+  % endif
 
   Device Arguments:
   The device argument is a comma delimited string used to locate devices on your system. Device arguments for multiple devices may be given by separating them with a space.
@@ -192,28 +211,74 @@ documentation: |-
   Lines ending with ... mean it's possible to bind devices together by specifying multiple device arguments separated with a space.
 
   % if sourk == 'source':
-    miri=0[,buffers=32] ...
+    miri=0[,buffers=32][,format=auto|252_s16|336_s16|384_s16|504_s16|504_s8] ...
     rtl=serial_number ...
     rtl=0[,rtl_xtal=28.8e6][,tuner_xtal=28.8e6] ...
-    rtl=1[,buffers=32][,buflen=N*512] ...
+    rtl=1[,buffers=32][,buflen=N*512][,zerocopy=0|1] ...
+    rtl=1[,min_buffers=0..N][,latency=<ms>] ...
     rtl=2[,direct_samp=0|1|2][,offset_tune=0|1][,bias=0|1] ...
+    rtl=0[,timekey=0|1][,settle=<samples>] (on retune the transfer in flight is dropped, then this many samples) ...
+    rtl=0|hackrf=0[,decim=2|4|8|16] (half-band decimation while converting, the rates are divided) ...
+    rtl=0|hackrf=0|airspy=0[,watchdog=<ms>] (restart the stream when it ends or stalls, the gap is tagged with rx_time) ...
+    rtl=0|hackrf=0|bladerf=0|airspy=0|netsdr=0|sdrplay=0[,level=<ms>] (mean power in dBFS and clipped ADC values every <ms> on the level port and in the stream stats, measured while converting, fc32 only) ...
+    rtl=0|hackrf=0|airspy=0[,linger=<ms>] (keep the device open that long after the flowgraph, for the next one with the same arguments) ...
+    rtl=0|hackrf=0|airspy=0[,snapshot=<len>:<period>] (stream only <len> ms of every <period> ms, each snapshot starts with rx_time and rx_freq) ...
+    airspyhf=0,rate=768e3 bladerf=0 (a device given a rate of its own keeps it when the rate of the group changes, each channel tells its rate with rx_rate tags) ...
+    bladerf=0|xtrx=0|soapy=0[,convert_threads=<n>] (convert the samples on n cores, 0 for all of them) ...
+    xtrx=0,sweep=<start>:<stop>:<step>[,sweep_dwell=<ms>][,sweep_settle=<ms>] (alternate both channels over NCO steps around one LO, tagged with rx_freq) ...
     rtl_tcp=127.0.0.1:1234[,psize=16384][,direct_samp=0|1|2][,offset_tune=0|1][,bias=0|1] ...
+    rtl_tcp=127.0.0.1:1234[,rcvbuf=<bytes>][,ring_size=<bytes>] ...
+    rtl_tcp=127.0.0.1:1234[,timeout=<s>][,reconnect=0|1] ...
+    rtl_tcp=127.0.0.1:1234[,decim=2|4|8|16][,payload=u8|cs16|cs8] (decimated and converted by an osmosdr rtl_tcp server) ...
     file='/path/to/your file',rate=1e6[,freq=100e6][,repeat=true][,throttle=true] ...
-    netsdr=127.0.0.1[:50000][,nchan=2]
+    file='/path/to/your file',rate=1e6[,mmap=true|false][,hugepages=true] ...
+    file='/path/to/your file',rate=1e6[,format=cf32|cs16|cs8|cu8] ...
+    file='/path/to/recording.sigmf-meta'[,rate=1e6][,freq=100e6] ...
+    file='/path/to/your file',rate=1e6,emulate=rtl|hackrf|airspy|bladerf|uhd[,chunk=<samples>][,buffers=N][,jitter=<us>][,drop=<p>][,seed=N] ...
+    netsdr=127.0.0.1[:50000][,nchan=2][,rcvbuf=<bytes>][,bits=16|24][,gapfill=zero|last][,timekey=0|1]
     sdr-ip=127.0.0.1[:50000]
     cloudiq=127.0.0.1[:50000]
     sdr-iq=/dev/ttyUSB0
-    airspy=0[,bias=0|1][,linearity][,sensitivity]
+    airspy=0[,bias=0|1][,linearity][,sensitivity][,timekey=0|1]
+    airspy=0[,pack=0|1][,sample_type=float|int16|raw][,decim=1|2|4|8|16]
+    airspyhf=0[,buffer_ms=500]
+    fcd=0[,device=hw:2][,type=1|2][,native=1][,period=<frames>][,periods=<n>] (native: mmap'ed ALSA capture and HID control without gr-funcube, xruns counted in the stream stats)
+    rtl=0,serve=[0.0.0.0:]1234[,control=first|all|none][,serve_ring=<bytes>]
+    hackrf=0,sweep=<start>:<stop>[:<step>][,sweep_offset=<Hz>][,sweep_dwell=<blocks>][,settle=<samples>]
+    uhd,native=1[,num_recv_frames=N][,recv_frame_size=<bytes>][,recv_buff_size=<bytes>] ...
+    sync=pps|time|host (aligns the first samples of several devices) ...
+    rtl=0[,corr_tau=<s>] (time constant of the software DC offset and IQ balance correction)
+    rtl=0,channels=<freq>:<bw>[,<freq>:<bw>...] (+/-<freq> is an offset, one output per channel in place of the first, fc32 only)
+    rtl=0,gate=<dBFS>[,gate_block=1024][,gate_hang=<ms>][,gate_pre=<ms>] (only blocks above the mean power come out, each segment starts with rx_time, fc32 only)
+    rtl=0[,buf_huge=0|1][,buf_lock=0|1][,buf_node=<numa node>] (stream buffers on huge pages, locked, from one node) ...
+    rtl=0[,rx_cpu=<core>[:<core>-<core>]][,rx_prio=<prio>][,rx_policy=fifo|rr|other] (placement of the streaming threads) ...
+    rtl=0|miri=0|hackrf=0|airspy=0|...,rx_cpu=<core>[:<core>-<core>],rx_spread=1 (every device streams on a core of the list of its own, the devices of the block take turns over the list in the order given) ...
+    sim=0[,rate=2.4e6][,format=u8|s8|s16][,xfer=<samples>][,buffers=16][,realtime=0|1][,overrun=<every n transfers>][,timekey=0|1] ...
+    shm=<name> (samples and tags of a shm=<name> sink in another process, rate and frequency are the sink's) ...
+    vita49=[<group or address>]:4991[,stream_id=N][,iface=<address>][,format=cs8|cs16][,rate=<Hz>][,rcvbuf=<bytes>][,ring_size=<samples>] (packets of osmosdr.vita49_sink) ...
   % endif
   % if sourk == 'sink':
     file='/path/to/your file',rate=1e6[,freq=100e6][,append=true][,throttle=true] ...
+    file='/path/to/your file',rate=1e6[,format=cf32|cs16|cs8][,ring_size=<bytes>][,direct=true][,async=false] ...
+    file='/path/to/recording.sigmf-data',rate=1e6[,freq=100e6] ...
+    file='/path/to/event.cs16',rate=1e6,pre=<s>,post=<s>[,trigger=<tag key>] ...
+    hackrf=0[,burst=0|1][,turnaround=0|1] (turnaround=1 pauses a source on the same HackRF during the bursts) ...
+    hackrf=0[,tx_cpu=<core>[:<core>-<core>]][,tx_prio=<prio>][,tx_policy=fifo|rr|other] (placement of the streaming threads) ...
+    sim=0[,rate=2.4e6][,format=u8|s8|s16][,xfer=<samples>][,buffers=16][,realtime=0|1][,underrun=<every n transfers>] ...
+    shm=<name>[,size=<samples>][,block=0|1][,unlink=0|1] (shared memory ring for shm= sources in other processes, block=1 waits for the slowest one) ...
+    sync=pps|time[,start_delay=0.5] (uhd, bladerf and xtrx devices start transmitting together) ...
+    hackrf=0|bladerf=0|soapy=0|xtrx|redpitaya=...[,prefill=<samples>][,underrun=zero|repeat|stop] (start of the stream and what an underrun sends) ...
+    tx_latency_ms=<ms> (all devices), or hackrf=0|bladerf=0|soapy=0|xtrx|redpitaya=...,tx_latency_ms=<ms> (samples queued at most, work() blocks above) ...
+    uhd|bladerf=0|soapy=0|xtrx (take tx_freq and tx_gain tags, the change is made at the tagged sample) ...
   % endif
-    redpitaya=192.168.1.100[:1001]
+    redpitaya=192.168.1.100[:1001][,ring_size=<bytes>][,rcvbuf=<bytes>][,sndbuf=<bytes>]
     freesrp=0[,fx3='path/to/fx3.img',fpga='path/to/fpga.bin',loopback]
-    hackrf=0[,buffers=32][,bias=0|1][,bias_tx=0|1]
+    hackrf=0[,buffers=32][,min_buffers=0..N][,latency=<ms>][,timekey=0|1][,settle=<samples>][,bias=0|1][,bias_tx=0|1]
     bladerf=0[,tamer=internal|external|external_1pps][,smb=25e6]
+    bladerf=0[,enable_metadata][,latency_ms=<ms>]
     uhd[,serial=...][,lo_offset=0][,mcr=52e6][,nchan=2][,subdev='\\\\'B:0 A:0\\\\''] ...
-    xtrx
+    soapy[,driver=...][,direct=0|1] ...
+    xtrx[,latency=<ms>] (packets of that many ms of samples, 1 by default, a burst ending in tx_eob is sent right away)
 
   Num Channels:
   Selects the total number of channels in this multi-device configuration. Required when specifying multiple device arguments.
@@ -226,6 +291,9 @@ documentation: |-
 
   Freq. Corr.:
   The frequency correction factor in parts per million (ppm). Set to 0 if unknown.
+  % if sourk == 'source':
+  Devices which can't correct it themselves get their samples shifted in software, by the software DC offset and IQ balance correction, or by a block of its own when those are off.
+  % endif
 
   % if sourk == 'source':
   DC Offset Mode:
@@ -234,7 +302,7 @@ documentation: |-
     Manual: Keep last estimated correction when switched from Automatic to Manual.
     Automatic: Periodicallly find the best solution to compensate for DC offset.
 
-  This functionality is available for USRP devices only.
+  Devices without a hardware correction get a software one with the same modes.
 
   IQ Balance Mode:
   Controls the behavior of software IQ imbalance corrrection.
@@ -243,6 +311,7 @@ documentation: |-
     Automatic: Periodicallly find the best solution to compensate for image signals.
 
   This functionality depends on http://cgit.osmocom.org/cgit/gr-iqbal/
+  Without it, devices lacking a hardware correction get a software one.
 
   Gain Mode:
   Chooses between the manual (default) and automatic gain mode where appropriate.
@@ -268,6 +337,12 @@ documentation: |-
   Bandwidth:
   Set the bandpass filter on the radio frontend. To use the default (automatic) bandwidth filter setting, this should be zero.
 
+  Command Port:
+  Takes PMT dicts with the keys freq, gain, antenna, bandwidth and rate, applied to every channel or the one given with chan. They are applied on a thread of their own, in the order they arrive, so the sender never waits for the device. A time (a tuple of integer and fractional seconds) holds the command back until the device time reaches it.
+  % if sourk == 'sink':
+  File sinks with a trigger also take their triggers from this port.
+  % endif
+
   See the OsmoSDR project page for more detailed documentation:
   http://sdr.osmocom.org/trac/wiki/GrOsmoSDR
   http://sdr.osmocom.org/trac/wiki/rtl-sdr
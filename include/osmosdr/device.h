@@ -104,6 +104,11 @@ namespace osmosdr {
      * The device hint "nofake" switches off dummy devices created
      * by "file" (and other) implementations.
      *
+     * The backends are probed concurrently. "driver=rtl|hackrf" probes
+     * only the backends named. What a backend found is reused for a
+     * couple of seconds, "cache=<seconds>" sets how long and "nocache"
+     * probes again.
+     *
      * \param hint a partially (or fully) filled in logical device
      * \return a vector of logical devices for all radios on the system
      */
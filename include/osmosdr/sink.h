@@ -21,8 +21,11 @@
 #define INCLUDED_OSMOSDR_SINK_H
 
 #include <osmosdr/api.h>
+#include <osmosdr/device.h>
 #include <osmosdr/ranges.h>
+#include <osmosdr/stream_stats.h>
 #include <osmosdr/time_spec.h>
+#include <gnuradio/gr_complex.h>
 #include <gnuradio/hier_block2.h>
 
 namespace osmosdr {
@@ -34,6 +37,11 @@ class sink;
  * \ingroup block
  *
  * This uses the preferred technique: subclassing gr::hier_block2.
+ *
+ * tx_freq and tx_gain tags holding a number change the frequency or gain
+ * of the channel they are on from the tagged sample on. uhd applies them
+ * at that sample, bladerf, soapy and xtrx devices in front of it, once
+ * the samples before it went out.
  */
 class OSMOSDR_API sink : virtual public gr::hier_block2
 {
@@ -275,6 +283,55 @@ public:
    */
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 ) = 0;
 
+  /*!
+   * Get the streaming statistics of a channel.
+   * \param chan the channel index 0 to N-1
+   * \return counters for delivered and dropped samples, over/underruns
+   * and the host ring fill level
+   */
+  virtual osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 ) = 0;
+
+  /*!
+   * Apply several settings of a channel at once.
+   * Backends where every setting is a transaction of its own (network
+   * devices) send them together, and skip the ones that don't change.
+   * Keys are rate, freq, freq_corr, gain_mode (0|1), gain, if_gain,
+   * bb_gain, gain:<name> for a named gain stage, antenna and bandwidth,
+   * applied in this order. The rate is the one of all channels.
+   * \param config the settings, e.g. "freq=100e6,gain=20"
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_config( const osmosdr::device_t &config, size_t chan = 0 ) = 0;
+
+  /*!
+   * Loop a waveform on the device instead of transmitting the input.
+   * The samples are converted into the device format once and replayed
+   * by the backend until the waveform gets cleared, without any work per
+   * sample on the host. Meanwhile the input of the channel is consumed
+   * and dropped, a null source may feed it. Supported by the hackrf,
+   * bladerf and sim backends, the others throw.
+   * \param samples one period of the waveform
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_waveform( const std::vector< gr_complex > &samples,
+                             size_t chan = 0 ) = 0;
+
+  /*!
+   * Loop the waveform stored in a file, see set_waveform().
+   * \param filename interleaved I/Q samples in host byte order
+   * \param format cf32, cs16 or cs8
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void load_waveform( const std::string &filename,
+                              const std::string &format = "cf32",
+                              size_t chan = 0 ) = 0;
+
+  /*!
+   * Go back to transmitting the input.
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void clear_waveform( size_t chan = 0 ) = 0;
+
   /*!
    * Set the time source for the device.
    * This sets the method of time synchronization,
@@ -21,8 +21,11 @@
 #define INCLUDED_OSMOSDR_SOURCE_H
 
 #include <osmosdr/api.h>
+#include <osmosdr/device.h>
 #include <osmosdr/ranges.h>
+#include <osmosdr/stream_stats.h>
 #include <osmosdr/time_spec.h>
+#include <gnuradio/gr_complex.h>
 #include <gnuradio/hier_block2.h>
 
 namespace osmosdr {
@@ -77,6 +80,8 @@ public:
   /*!
    * Set the sample rate for the underlying radio hardware.
    * This also will select the appropriate IF bandpass, if applicable.
+   * While streaming, rtl, hackrf and bladerf devices drop what they still
+   * hold at the old rate, the first sample at the new one gets rx_rate.
    * \param rate a new rate in Sps
    */
   virtual double set_sample_rate( double rate ) = 0;
@@ -88,6 +93,32 @@ public:
    */
   virtual double get_sample_rate( void ) = 0;
 
+  /*!
+   * Get the possible sample rates of the device behind a channel.
+   * \param chan the channel index 0 to N-1
+   * \return a range of rates in Sps
+   */
+  virtual osmosdr::meta_range_t get_sample_rates( size_t chan ) = 0;
+
+  /*!
+   * Set the sample rate of the device behind a channel, all of its channels
+   * change with it. In a group of devices this one leaves the group rate
+   * set with set_sample_rate( double ), like a device given rate=<sps>.
+   * \param rate a new rate in Sps
+   * \param chan the channel index 0 to N-1
+   * \return the actual rate of the channel in Sps
+   */
+  virtual double set_sample_rate( double rate, size_t chan ) = 0;
+
+  /*!
+   * Get the rate a channel comes out at. It is the one of its device, or
+   * the lower one of a channel extracted with channels=. The rx_rate tags
+   * on the stream tell the same.
+   * \param chan the channel index 0 to N-1
+   * \return the actual rate in Sps
+   */
+  virtual double get_sample_rate( size_t chan ) = 0;
+
   /*!
    * Get the tunable frequency range for the underlying radio hardware.
    * \param chan the channel index 0 to N-1
@@ -320,6 +351,94 @@ public:
    */
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 ) = 0;
 
+  /*!
+   * Get the streaming statistics of a channel.
+   * \param chan the channel index 0 to N-1
+   * \return counters for delivered and dropped samples, over/underruns
+   * and the host ring fill level
+   */
+  virtual osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 ) = 0;
+
+  /*!
+   * Prepare a table of center frequencies for hop_center_freq().
+   * Devices with quick tune support (bladeRF) tune to every entry once
+   * and keep the tuner settings, so a hop skips the PLL calibration.
+   * The current center frequency is restored afterwards.
+   * \param freqs the center frequencies in Hz
+   * \param chan the channel index 0 to N-1
+   * \return the number of entries prepared, 0 if not supported
+   */
+  virtual size_t set_hop_freqs( const std::vector<double> &freqs,
+                                size_t chan = 0 ) = 0;
+
+  /*!
+   * Hop to an entry of the table given to set_hop_freqs().
+   * \param index the entry of the table
+   * \param time when to retune in device time, 0 for now
+   * \param chan the channel index 0 to N-1
+   * \return the center frequency hopped to in Hz
+   */
+  virtual double hop_center_freq( size_t index,
+                                  const ::osmosdr::time_spec_t &time = ::osmosdr::time_spec_t(),
+                                  size_t chan = 0 ) = 0;
+
+  /*!
+   * Hop through a list of center frequencies, from a thread of the
+   * source, until the schedule is replaced. Hop i starts at \p start_time
+   * plus the dwell times of the hops before it, and the list repeats.
+   *
+   * Devices that take timed commands (UHD, bladeRF with enable_metadata)
+   * get every hop ahead of time and retune at the exact sample. The
+   * others are retuned when the hop is due, through the fast retune path
+   * of the backend where there is one. Either way the first sample on the
+   * new frequency is tagged with rx_freq by the backends that tag their
+   * retunes (exactly with native=1 for UHD).
+   *
+   * \param freqs the center frequencies in Hz, empty to stop hopping
+   * \param dwell seconds on every frequency, or a single value for all
+   * \param start_time when to start in device time (get_time_now()), 0 for now
+   * \param chan the channel index 0 to N-1
+   * \return true if the hops are timed by the device
+   */
+  virtual bool set_hop_schedule( const std::vector<double> &freqs,
+                                 const std::vector<double> &dwell,
+                                 const ::osmosdr::time_spec_t &start_time = ::osmosdr::time_spec_t(),
+                                 size_t chan = 0 ) = 0;
+
+  /*!
+   * Apply several settings of a channel at once.
+   * Backends where every setting is a transaction of its own (network
+   * devices) send them together, and skip the ones that don't change.
+   * Keys are rate, freq, freq_corr, gain_mode (0|1), gain, if_gain,
+   * bb_gain, gain:<name> for a named gain stage, antenna and bandwidth,
+   * applied in this order. The rate is set on the device behind the
+   * channel: for one pinned with rate= it is that device's alone,
+   * otherwise it is the group rate of all devices not pinned.
+   * \param config the settings, e.g. "freq=100e6,gain=20"
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_config( const osmosdr::device_t &config, size_t chan = 0 ) = 0;
+
+  /*!
+   * Read samples of a channel without running the block in a flowgraph.
+   * The device is started with the first call and streams until
+   * stop_read(), every call continues where the last one ended. The
+   * samples are written straight into \p samples by the backend.
+   * Only works with type=fc32, the software dc offset and iq balance
+   * corrections aren't applied. Must not be used while the block runs
+   * in a flowgraph.
+   * \param samples where to put the samples, room for \p nitems
+   * \param nitems the number of samples to read
+   * \param chan the channel index 0 to N-1
+   * \return the number of samples read, fewer only at the end of the stream
+   */
+  virtual size_t read( gr_complex *samples, size_t nitems, size_t chan = 0 ) = 0;
+
+  /*!
+   * Stop the devices started by read().
+   */
+  virtual void stop_read() = 0;
+
   /*!
    * Set the time source for the device.
    * This sets the method of time synchronization,
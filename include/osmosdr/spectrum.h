@@ -0,0 +1,70 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_SPECTRUM_H
+#define INCLUDED_OSMOSDR_SPECTRUM_H
+
+#include <osmosdr/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace osmosdr {
+
+/*!
+ * \brief Turns a stream of samples into averaged power spectra at a
+ * capped frame rate.
+ * \ingroup block
+ *
+ * Every 1 / \p frame_rate seconds worth of samples the block averages
+ * the FFTs of the first \p average blocks of \p fft_size samples and
+ * skips the rest, so the processing load follows the frame rate and not
+ * the sample rate. With \p average 0 every sample goes into the average.
+ *
+ * The frames go out as PDUs on the "power" message port, in the format
+ * of the sweeper: a dict with "freq" (center frequency), "rate" (sample
+ * rate) and "frame" (number of the frame) and a vector of floats with
+ * the power of every bin in dBFS, lowest frequency first. The rx_freq
+ * and rx_rate tags of the source keep freq and rate up to date.
+ */
+class OSMOSDR_API spectrum : virtual public gr::sync_block
+{
+public:
+  typedef std::shared_ptr< spectrum > sptr;
+
+  /*!
+   * \param sample_rate sample rate of the input in Hz
+   * \param fft_size number of bins
+   * \param frame_rate maximum number of frames per second
+   * \param average number of FFTs averaged per frame, 0 for all of them
+   * \param freq center frequency to report until the first rx_freq tag
+   */
+  static sptr make( double sample_rate, size_t fft_size = 1024,
+                    double frame_rate = 10, size_t average = 8,
+                    double freq = 0 );
+
+  virtual void set_sample_rate( double rate ) = 0;
+  virtual void set_center_freq( double freq ) = 0;
+  virtual void set_frame_rate( double frame_rate ) = 0;
+
+  /*! \return the number of frames published */
+  virtual uint64_t get_frames( void ) = 0;
+};
+
+} /* namespace osmosdr */
+
+#endif /* INCLUDED_OSMOSDR_SPECTRUM_H */
@@ -0,0 +1,101 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OSMOSDR_STREAM_STATS_H
+#define INCLUDED_OSMOSDR_STREAM_STATS_H
+
+#include <osmosdr/api.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmosdr{
+
+    /*!
+     * Streaming statistics of a single channel.
+     *
+     * Counters accumulate for the lifetime of the device, fill levels are
+     * given in samples. Backends that don't keep track of a value leave
+     * it at zero.
+     */
+    struct stream_stats_t{
+        stream_stats_t(void) :
+            samples(0), dropped(0), overruns(0), underruns(0),
+            lost_packets(0), late(0), bursts(0), clipped(0), restarts(0), fill(0), fill_max(0), capacity(0),
+            latency_p50(0), latency_p99(0), latency_max(0), fill_p50(0), fill_p99(0), power(0)
+        {}
+
+        //! samples delivered to (source) or taken from (sink) the flowgraph
+        uint64_t samples;
+
+        //! samples lost because the host did not keep up
+        uint64_t dropped;
+
+        //! number of overrun events ("O")
+        uint64_t overruns;
+
+        //! number of underrun events ("U")
+        uint64_t underruns;
+
+        //! packets lost on the way from the device (network radios), or out
+        //! of sequence on the way to it (sinks)
+        uint64_t lost_packets;
+
+        //! timed packets that reached the device after their time (sinks)
+        uint64_t late;
+
+        //! bursts the device acknowledged as sent completely (sinks)
+        uint64_t bursts;
+
+        //! I or Q values beyond full scale, saturated when quantizing (sinks)
+        //! or at the limits of the ADC (sources measuring level=)
+        uint64_t clipped;
+
+        //! times the stream was restarted after it ended or stalled (watchdog=)
+        uint64_t restarts;
+
+        //! samples currently held in the host ring buffer
+        size_t fill;
+
+        //! highest ring fill level seen so far
+        size_t fill_max;
+
+        //! size of the host ring buffer
+        size_t capacity;
+
+        /*!
+         * Time in microseconds from a transfer arriving from the device
+         * to work() taking its first sample, median, 99th percentile and
+         * highest. Only measured when built with ENABLE_LATENCY_STATS.
+         */
+        double latency_p50;
+        double latency_p99;
+        double latency_max;
+
+        //! ring fill seen by work(), median and 99th percentile
+        size_t fill_p50;
+        size_t fill_p99;
+
+        //! mean power of the last level= period in dBFS
+        double power;
+    };
+
+} //namespace osmosdr
+
+#endif /* INCLUDED_OSMOSDR_STREAM_STATS_H */
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_SWEEPER_H
+#define INCLUDED_OSMOSDR_SWEEPER_H
+
+#include <osmosdr/api.h>
+#include <osmosdr/source.h>
+#include <gnuradio/sync_block.h>
+
+namespace osmosdr {
+
+/*!
+ * \brief Sweeps a source over a frequency range, emitting the averaged
+ * power spectrum of every step.
+ * \ingroup block
+ *
+ * Connect the output of the source to the input of the sweeper. It tunes
+ * the source itself from its work function, one step after the other,
+ * drops what was received before the retune took effect and averages
+ * \p dwell FFTs of \p fft_size samples. The result goes out as a PDU on
+ * the "power" message port: a dict with "freq" (center frequency of the
+ * step), "rate" (sample rate), "step" (index of the step) and "sweep"
+ * (number of the sweep) and a vector of floats with the power of every
+ * bin in dBFS, lowest frequency first.
+ *
+ * With \p settle 0 the start of every step is found through the rx_freq
+ * tag backends with a fast retune path attach to the first sample after
+ * the settle interval (open the source with settle=<samples>). Otherwise
+ * that many samples are dropped after every retune, which also drops the
+ * samples still queued from before it.
+ */
+class OSMOSDR_API sweeper : virtual public gr::sync_block
+{
+public:
+  typedef std::shared_ptr< sweeper > sptr;
+
+  /*!
+   * \param src the source to tune, its output must feed the sweeper
+   * \param start center frequency of the first step in Hz
+   * \param stop the last step is at or below this center frequency in Hz
+   * \param step distance of the steps in Hz
+   * \param fft_size number of bins
+   * \param dwell number of FFTs averaged per step
+   * \param settle samples to drop after a retune, 0 to wait for the rx_freq tag
+   * \param chan channel of the source to tune
+   */
+  static sptr make( source::sptr src, double start, double stop, double step,
+                    size_t fft_size = 1024, size_t dwell = 8, size_t settle = 0,
+                    size_t chan = 0 );
+
+  /*! Change the range, takes effect when the current sweep ends. */
+  virtual void set_range( double start, double stop, double step ) = 0;
+
+  /*! \return the number of sweeps completed */
+  virtual uint64_t get_sweeps( void ) = 0;
+};
+
+} /* namespace osmosdr */
+
+#endif /* INCLUDED_OSMOSDR_SWEEPER_H */
@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_VITA49_SINK_H
+#define INCLUDED_OSMOSDR_VITA49_SINK_H
+
+#include <osmosdr/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace osmosdr {
+
+/*!
+ * \brief Sends a stream of samples as VITA-49 packets over UDP, to one
+ * host or to a multicast group, for any number of vita49 sources.
+ * \ingroup block
+ *
+ * The samples are requantized to cs8 or cs16 and go out as IF data
+ * packets of at most \p packet_bytes, so cs8 halves the bandwidth. Their
+ * timestamps follow the rx_time tags of the source, or the host clock
+ * when it has none. An IF context packet with the frequency, the sample
+ * rate and the payload format goes out first, whenever they change
+ * (with rx_freq and rx_rate tags or the setters) and every second, so
+ * receivers can join at any time. On Linux the packets are sent in
+ * batches with sendmmsg().
+ */
+class OSMOSDR_API vita49_sink : virtual public gr::sync_block
+{
+public:
+  typedef std::shared_ptr< vita49_sink > sptr;
+
+  /*!
+   * \param address host or multicast group to send to
+   * \param port UDP port
+   * \param sample_rate sample rate of the input in Hz
+   * \param format cs8 or cs16
+   * \param freq center frequency to report until the first rx_freq tag
+   * \param stream_id VITA-49 stream identifier of the packets
+   * \param scale gain applied before requantizing, 1 is full scale
+   * \param packet_bytes UDP payload size, the default fits a 1500 byte MTU
+   * \param ttl multicast time to live
+   */
+  static sptr make( const std::string &address, int port, double sample_rate,
+                    const std::string &format = "cs16", double freq = 0,
+                    uint32_t stream_id = 0, double scale = 1.0,
+                    size_t packet_bytes = 1472, int ttl = 1 );
+
+  virtual void set_sample_rate( double rate ) = 0;
+  virtual void set_center_freq( double freq ) = 0;
+  virtual void set_scale( double scale ) = 0;
+
+  /*! \return the number of data packets sent */
+  virtual uint64_t get_packets( void ) = 0;
+};
+
+} /* namespace osmosdr */
+
+#endif /* INCLUDED_OSMOSDR_VITA49_SINK_H */
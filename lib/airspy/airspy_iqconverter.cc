@@ -0,0 +1,148 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+
+#include "airspy_iqconverter.h"
+#include "airspy_fir_kernels.h"
+
+#define SAMPLE_OFFSET 2048    // 12 bit unsigned
+#define SAMPLE_MAX    4095
+#define SAMPLE_SCALE  (1.0f / 2048)
+#define DC_ALPHA      0.01f   // per block
+
+airspy_iqconverter::airspy_iqconverter() :
+  _delay(0), _dc(0), _odd(false)
+{
+  set_kernel( KERNEL_2_80, KERNEL_2_80_LEN );
+}
+
+void airspy_iqconverter::set_kernel( const float *kernel, size_t len )
+{
+  /* the odd taps are zero except for the center one, which is what the
+   * delay of the Q branch stands for */
+  _taps.clear();
+  for (size_t i = 0; i < len; i += 2)
+    _taps.push_back( kernel[i] * 2.0f );
+
+  _delay = (len / 2 + 1) / 2;
+
+  reset();
+}
+
+void airspy_iqconverter::reset()
+{
+  _i.assign( _taps.size() - 1, 0.0f );
+  _q.assign( _delay, 0.0f );
+  _dc = 0;
+  _odd = false;
+}
+
+void airspy_iqconverter::process( const uint16_t *in, gr_complex *out, size_t nitems,
+                                  convert_level_t *level )
+{
+  const size_t hist_i = _taps.size() - 1;
+  const size_t hist_q = _delay;
+
+  _i.resize( hist_i + nitems );
+  _q.resize( hist_q + nitems );
+  _acc.assign( nitems, 0.0f );
+
+  float *i = &_i[hist_i];
+  float *q = &_q[hist_q];
+  float sum = 0;
+
+  if ( level ) {
+    float power = 0;
+    uint64_t clipped = 0;
+
+    for (size_t m = 0; m < nitems; m++) {
+      const uint16_t a = in[2 * m];
+      const uint16_t b = in[2 * m + 1];
+      const float xi = (float(a) - SAMPLE_OFFSET) * SAMPLE_SCALE;
+      const float xq = (float(b) - SAMPLE_OFFSET) * SAMPLE_SCALE;
+
+      sum += xi + xq;
+      i[m] = xi - _dc;
+      q[m] = xq - _dc;
+      power += i[m] * i[m] + q[m] * q[m];
+      clipped += (0 == a) | (a >= SAMPLE_MAX);
+      clipped += (0 == b) | (b >= SAMPLE_MAX);
+    }
+
+    level->power += power;
+    level->values += 2 * nitems;
+    level->clipped += clipped;
+  } else {
+    for (size_t m = 0; m < nitems; m++) {
+      const float xi = (float(in[2 * m]) - SAMPLE_OFFSET) * SAMPLE_SCALE;
+      const float xq = (float(in[2 * m + 1]) - SAMPLE_OFFSET) * SAMPLE_SCALE;
+
+      sum += xi + xq;
+      i[m] = xi - _dc;
+      q[m] = xq - _dc;
+    }
+  }
+
+  /* moving down by fs/4 negates every other pair of real samples */
+  for (size_t m = _odd ? 1 : 0; m < nitems; m += 2) {
+    i[m] = -i[m];
+    q[m] = -q[m];
+  }
+
+  _odd ^= (nitems & 1);
+
+  if (nitems)
+    _dc += DC_ALPHA * (sum / (2 * nitems) - _dc);
+
+  /* tap by tap, so the inner loop runs over contiguous samples */
+  float *acc = &_acc[0];
+  for (size_t j = 0; j < _taps.size(); j++) {
+    const float tap = _taps[j];
+    const float *src = &_i[j];
+
+    for (size_t m = 0; m < nitems; m++)
+      acc[m] += tap * src[m];
+  }
+
+  for (size_t m = 0; m < nitems; m++)
+    out[m] = gr_complex( acc[m], _q[m] );
+
+  std::copy( _i.end() - hist_i, _i.end(), _i.begin() );
+  std::copy( _q.end() - hist_q, _q.end(), _q.begin() );
+}
+
+size_t airspy_iqconverter::unpack( const uint32_t *in, uint16_t *out, size_t nwords )
+{
+  size_t j = 0;
+
+  for (size_t i = 0; i + 3 <= nwords; i += 3, j += 8) {
+    out[j + 0] = (in[i] >> 20) & 0xfff;
+    out[j + 1] = (in[i] >> 8) & 0xfff;
+    out[j + 2] = ((in[i] << 4) & 0xfff) | ((in[i + 1] >> 28) & 0xf);
+    out[j + 3] = (in[i + 1] >> 16) & 0xfff;
+    out[j + 4] = (in[i + 1] >> 4) & 0xfff;
+    out[j + 5] = ((in[i + 1] << 8) & 0xfff) | ((in[i + 2] >> 24) & 0xff);
+    out[j + 6] = (in[i + 2] >> 12) & 0xfff;
+    out[j + 7] = in[i + 2] & 0xfff;
+  }
+
+  return j;
+}
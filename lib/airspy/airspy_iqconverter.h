@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_AIRSPY_IQCONVERTER_H
+#define INCLUDED_AIRSPY_IQCONVERTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gnuradio/gr_complex.h>
+
+#include "sample_convert.h"
+
+/*!
+ * Turns the raw real samples of the Airspy (12 bit unsigned, at twice the
+ * IQ rate) into complex samples, doing on the host what libairspy does on
+ * its consumer thread for the float and int16 sample types.
+ *
+ * The signal is moved down by fs/4, the I branch gets half-band filtered
+ * and the Q branch is delayed to match, then both are decimated by 2.
+ * The DC estimate is updated once per block instead of per sample, so the
+ * inner loops can be vectorized by the compiler.
+ */
+class airspy_iqconverter
+{
+public:
+  airspy_iqconverter();
+
+  /*! \p kernel is one of the half-band kernels from airspy_fir_kernels.h */
+  void set_kernel( const float *kernel, size_t len );
+
+  void reset();
+
+  /*!
+   * Convert 2 * \p nitems values of \p in into \p nitems samples. With
+   * \p level the ADC values are measured on the way, without their DC,
+   * the lowest and the highest code count as clipped.
+   */
+  void process( const uint16_t *in, gr_complex *out, size_t nitems,
+                convert_level_t *level = NULL );
+
+  /*!
+   * Unpack \p nwords 32 bit words of packed samples, 3 words carry 8
+   * samples. Returns the number of samples written to \p out.
+   */
+  static size_t unpack( const uint32_t *in, uint16_t *out, size_t nwords );
+
+private:
+  std::vector<float> _taps;     // even taps of the half-band kernel, doubled
+  size_t _delay;                // Q branch delay in samples
+  std::vector<float> _i;        // I history followed by the current block
+  std::vector<float> _q;        // Q history followed by the current block
+  std::vector<float> _acc;      // filtered I of the current block
+  float _dc;
+  bool _odd;                    // sign of the fs/4 shift for the next sample
+};
+
+#endif /* INCLUDED_AIRSPY_IQCONVERTER_H */
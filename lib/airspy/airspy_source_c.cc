@@ -42,6 +42,8 @@
 #include "airspy_fir_kernels.h"
 
 #include "arg_helpers.h"
+#include "device_pool.h"
+#include "sample_convert.h"
 
 using namespace boost::assign;
 
@@ -58,6 +60,20 @@ using namespace boost::assign;
 #define AIRSPY_FUNC_STR(func, arg) \
   boost::str(boost::format(func "(%1%)") % arg) + " has failed"
 
+/* half-band kernels selected by set_bandwidth(), widest first */
+static const struct {
+  const float *taps;
+  size_t len;
+} airspy_kernels[] = {
+  { KERNEL_2_80, KERNEL_2_80_LEN },
+  { KERNEL_4_90, KERNEL_4_90_LEN },
+  { KERNEL_8_100, KERNEL_8_100_LEN },
+  { KERNEL_16_110, KERNEL_16_110_LEN },
+};
+
+/* a multiple of the 6 values holding 8 packed raw samples */
+#define RAW_FIFO_SIZE (6 * 1666666)
+
 airspy_source_c_sptr make_airspy_source_c (const std::string & args)
 {
   return gnuradio::get_initial_sptr(new airspy_source_c (args));
@@ -77,6 +93,18 @@ static const int MAX_IN = 0;	// maximum number of input streams
 static const int MIN_OUT = 1;	// minimum number of output streams
 static const int MAX_OUT = 1;	// maximum number of output streams
 
+/* kept open with linger=, airspy_open() takes the first one that's free */
+static device_pool< airspy_device > _pool;
+
+static void close_device( airspy_device *dev )
+{
+  int ret = airspy_close( dev );
+  if ( ret != AIRSPY_SUCCESS )
+  {
+    std::cerr << AIRSPY_FORMAT_ERROR(ret, "Failed to close AirSpy") << std::endl;
+  }
+}
+
 /*
  * The private constructor
  */
@@ -85,6 +113,12 @@ airspy_source_c::airspy_source_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
+    _sample_type(AIRSPY_SAMPLE_FLOAT32_IQ),
+    _packing(false),
+    _iqconv_kernel(0),
+    _iqconv_kernel_used(0),
+    _watchdog_timeout(0),
+    _running(false),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -99,9 +133,24 @@ airspy_source_c::airspy_source_c (const std::string &args)
 
   dict_t dict = params_to_dict(args);
 
-  _dev = NULL;
-  ret = airspy_open( &_dev );
-  AIRSPY_THROW_ON_ERROR(ret, "Failed to open AirSpy device")
+  buffer_opts_t buf_opts = buffer_opts_from_dict(dict);
+  _fifo.set_buffer_opts(buf_opts);
+  _raw_fifo.set_buffer_opts(buf_opts);
+  _sched = thread_sched_once( thread_sched_from_dict( dict ) );
+
+  /* host side decimation, the sample rates are divided accordingly */
+  if ( dict.count( "decim" ) )
+    _decimator.set_decimation( boost::lexical_cast<size_t>( dict["decim"] ) );
+
+  bool reused = false;
+  _handle = _pool.acquire( "", false, device_pool< airspy_device >::linger_from_dict( dict ),
+    []() {
+      airspy_device *dev = NULL;
+      int ret = airspy_open( &dev );
+      AIRSPY_THROW_ON_ERROR(ret, "Failed to open AirSpy device")
+      return std::shared_ptr< airspy_device >( dev, close_device );
+    }, &reused );
+  _dev = _handle.get();
 
   uint8_t board_id;
   ret = airspy_board_id_read( _dev, &board_id );
@@ -151,9 +200,10 @@ airspy_source_c::airspy_source_c (const std::string &args)
 
   set_if_gain( 5 ); /* preset to a reasonable default (non-GRC use case) */
 
-  if ( dict.count( "bias" ) )
+  /* a device left open keeps what its last user set */
+  if ( dict.count( "bias" ) || reused )
   {
-    bool bias = boost::lexical_cast<bool>( dict["bias"] );
+    bool bias = dict.count( "bias" ) && boost::lexical_cast<bool>( dict["bias"] );
     int ret = airspy_set_rf_bias(_dev, (uint8_t)bias);
     AIRSPY_THROW_ON_ERROR(ret, "Failed to enable DC bias")
   }
@@ -161,18 +211,71 @@ airspy_source_c::airspy_source_c (const std::string &args)
 /* pack 4 sets of 12 bits into 3 sets 16 bits for the data transfer across the
  * USB bus. The default is is unpacked, to transfer 12 bits across the USB bus
  * in 16 bit words. libairspy transparently unpacks if packing is enabled */
-  if ( dict.count( "pack" ) )
+  if ( dict.count( "pack" ) || reused )
   {
-    bool pack = boost::lexical_cast<bool>( dict["pack"] );
+    bool pack = dict.count( "pack" ) && boost::lexical_cast<bool>( dict["pack"] );
     int ret = airspy_set_packing(_dev, (uint8_t)pack);
     AIRSPY_THROW_ON_ERROR(ret, "Failed to set USB bit packing")
+    _packing = pack;
+  }
+
+/* int16 skips the float conversion of libairspy, raw all of its DSP. Both
+ * are converted to gr_complex in work(), off the libairspy thread. */
+  if ( dict.count( "sample_type" ) )
+  {
+    std::string type = dict["sample_type"];
+
+    if ( "float" == type )
+      _sample_type = AIRSPY_SAMPLE_FLOAT32_IQ;
+    else if ( "int16" == type )
+      _sample_type = AIRSPY_SAMPLE_INT16_IQ;
+    else if ( "raw" == type )
+      _sample_type = AIRSPY_SAMPLE_RAW;
+    else
+      throw std::runtime_error("Unsupported sample_type, use float, int16 or raw");
   }
 
-  _fifo = new boost::circular_buffer<gr_complex>(5000000);
-  if (!_fifo) {
-    throw std::runtime_error( std::string(__FUNCTION__) + " " +
-                              "Failed to allocate a sample FIFO!" );
+  if ( dict.count( "sample_type" ) || reused )
+  {
+    int ret = airspy_set_sample_type(_dev, _sample_type);
+    AIRSPY_THROW_ON_ERROR(ret, "Failed to set sample type")
+  }
+
+  /* 8 packed raw samples make 4 complex ones */
+  if ( AIRSPY_SAMPLE_RAW == _sample_type && _packing )
+    set_output_multiple( 4 );
+
+  /* rx_time / rx_rate / rx_freq tags from the host clock */
+  if ( dict.count( "timekey" ) )
+    _tagger.enable( boost::lexical_cast<bool>( dict["timekey"] ) );
+  _tagger.set_id( pmt::string_to_symbol(args) );
+
+  /* restart streaming when it ends or stalls, the gap is told by the
+   * rx_time tag after it */
+  _watchdog_timeout = stream_watchdog::timeout_from_dict( dict );
+  if ( _watchdog_timeout > 0 )
+    _tagger.enable( true );
+
+  /* stream only in windows, each one starts with rx_time */
+  _snapshot.configure( dict );
+  if ( _snapshot.enabled() ) {
+    if ( _watchdog_timeout > 0 )
+      throw std::runtime_error("snapshot= can't be combined with watchdog=.");
+    _tagger.enable( true );
   }
+
+  /* the floats of libairspy come in ready made, only our own conversion
+   * measures the level */
+  const double level_period = level_meter::period_from_dict( dict );
+  if ( level_period > 0 && AIRSPY_SAMPLE_FLOAT32_IQ == _sample_type )
+    std::cerr << "level= needs sample_type=int16 or raw, ignored" << std::endl;
+  else if ( level_period > 0 )
+    _level.attach( this, level_period );
+
+  if ( AIRSPY_SAMPLE_FLOAT32_IQ == _sample_type )
+    _fifo.resize( 5000000 );
+  else
+    _raw_fifo.resize( RAW_FIFO_SIZE );
 }
 
 /*
@@ -182,6 +285,9 @@ airspy_source_c::~airspy_source_c ()
 {
   int ret;
 
+  _watchdog.stop();
+  _snapshot.stop();
+
   if (_dev) {
     if ( airspy_is_streaming( _dev ) == AIRSPY_TRUE )
     {
@@ -192,58 +298,66 @@ airspy_source_c::~airspy_source_c ()
       }
     }
 
-    ret = airspy_close( _dev );
-    if ( ret != AIRSPY_SUCCESS )
-    {
-      std::cerr << AIRSPY_FORMAT_ERROR(ret, "Failed to close AirSpy") << std::endl;
-    }
+    _handle.reset();
     _dev = NULL;
   }
-
-  if (_fifo)
-  {
-    delete _fifo;
-    _fifo = NULL;
-  }
 }
 
 int airspy_source_c::_airspy_rx_callback(airspy_transfer *transfer)
 {
   airspy_source_c *obj = (airspy_source_c *)transfer->ctx;
 
+  obj->_sched.apply();
+
   return obj->airspy_rx_callback((float *)transfer->samples, transfer->sample_count);
 }
 
 int airspy_source_c::airspy_rx_callback(void *samples, int sample_count)
 {
-  size_t i, n_avail, to_copy, num_samples = sample_count;
-  float *sample = (float *)samples;
-
-  _fifo_lock.lock();
-
-  n_avail = _fifo->capacity() - _fifo->size();
-  to_copy = (n_avail < num_samples ? n_avail : num_samples);
-
-  for (i = 0; i < to_copy; i++ )
-  {
-    /* Push sample to the fifo */
-    _fifo->push_back( gr_complex( *sample, *(sample+1) ) );
-
-    /* offset to the next I+Q sample */
-    sample += 2;
+  size_t to_copy, num_samples = sample_count;
+
+  /* what's past the snapshot is dropped until the timer stops streaming,
+   * raw transfers are kept whole for the I/Q order */
+  if ( _snapshot.enabled() ) {
+    const bool raw = AIRSPY_SAMPLE_RAW == _sample_type;
+    const size_t taken = _snapshot.take( raw ? num_samples / 2 : num_samples );
+    if ( ! taken )
+      return 0;
+    if ( ! raw )
+      num_samples = taken;
   }
 
-  _fifo_lock.unlock();
+  if ( AIRSPY_SAMPLE_FLOAT32_IQ == _sample_type ) {
+    /* interleaved float I/Q has the same layout as gr_complex */
+    to_copy = std::min( num_samples, _fifo.space() );
+    _tagger.transfer( to_copy );
+    _latency_stats.arrival( _fifo.write_count() );
+    _fifo.push( (gr_complex *)samples, to_copy );
+  } else {
+    size_t num_values = num_samples * 2;
+
+    /* raw transfers count the real samples at twice the rate */
+    if ( AIRSPY_SAMPLE_RAW == _sample_type ) {
+      num_values = _packing ? num_samples / 8 * 6 : num_samples;
+      num_samples /= 2;
+    }
 
-  /* We have made some new samples available to the consumer in work() */
-  if (to_copy) {
-    //std::cerr << "+" << std::flush;
-    _samp_avail.notify_one();
+    /* whole transfers only, a partial one would break the I/Q order */
+    to_copy = _raw_fifo.space() >= num_values ? num_samples : 0;
+    _tagger.transfer( to_copy );
+    if ( to_copy ) {
+      _latency_stats.arrival( _raw_fifo.write_count() );
+      _raw_fifo.push( (uint16_t *)samples, num_values );
+    }
   }
+  _watchdog.feed();
 
   /* Indicate overrun, if neccesary */
-  if (to_copy < num_samples)
+  if (to_copy < num_samples) {
+    _stats.overrun( num_samples - to_copy );
+    _tagger.overrun( num_samples - to_copy );
     std::cerr << "O" << std::flush;
+  }
 
   return 0; // TODO: return -1 on error/stop
 }
@@ -253,21 +367,77 @@ bool airspy_source_c::start()
   if ( ! _dev )
     return false;
 
+  _fifo.reset();
+  _raw_fifo.reset();
+  _latency_stats.reset();
+  _sched.reset();
+  _iqconv.reset();
+  _decimator.reset();
+  /* the tagger counts the samples before decimation */
+  _tagger.start( _sample_rate, get_center_freq() );
+  _level.set_sample_rate( _sample_rate );
+
+  /* the windows are streamed on the timer thread */
+  if ( _snapshot.enabled() ) {
+    _running = true;
+    _snapshot.start( [this]() { return _sample_rate; },
+                     [this]() {
+                       if ( airspy_start_rx( _dev, _airspy_rx_callback, (void *)this ) != AIRSPY_SUCCESS )
+                         return false;
+                       _tagger.set_rate( _sample_rate );
+                       return true;
+                     },
+                     [this]() { airspy_stop_rx( _dev ); } );
+    return true;
+  }
+
   int ret = airspy_start_rx( _dev, _airspy_rx_callback, (void *)this );
   if ( ret != AIRSPY_SUCCESS ) {
     std::cerr << "Failed to start RX streaming (" << ret << ")" << std::endl;
     return false;
   }
 
+  _running = true;
+  _watchdog.start( _watchdog_timeout, [this]() { return restart_stream(); } );
+
+  return true;
+}
+
+/* streaming is restarted on the open handle, which keeps the settings */
+bool airspy_source_c::restart_stream()
+{
+  if ( ! _dev )
+    return false;
+
+  airspy_stop_rx( _dev );
+
+  int ret = airspy_start_rx( _dev, _airspy_rx_callback, (void *)this );
+  if ( ret != AIRSPY_SUCCESS ) {
+    std::cerr << "Failed to restart RX streaming (" << ret << ")" << std::endl;
+    return false;
+  }
+
+  _tagger.set_rate( _sample_rate );
+  _stats.restarted();
+
   return true;
 }
 
 bool airspy_source_c::stop()
 {
+  _running = false;
+  _watchdog.stop();
+  _snapshot.stop();
+
   if ( ! _dev )
     return false;
 
   int ret = airspy_stop_rx( _dev );
+
+  /* release work() if it is waiting for samples */
+  _fifo.close();
+  _raw_fifo.close();
+
   if ( ret != AIRSPY_SUCCESS ) {
     std::cerr << "Failed to stop RX streaming (" << ret << ")" << std::endl;
     return false;
@@ -284,25 +454,52 @@ int airspy_source_c::work( int noutput_items,
 
   bool running = false;
 
-  if ( _dev )
+  /* a stream the watchdog restarts is waited for, as are the snapshots */
+  if ( _dev && ( _watchdog.enabled() || _snapshot.enabled() ) )
+    running = _running;
+  else if ( _dev )
     running = (airspy_is_streaming( _dev ) == AIRSPY_TRUE);
 
   if ( ! running )
     return WORK_DONE;
 
-  std::unique_lock<std::mutex> lock(_fifo_lock);
+  const size_t decim = _decimator.decimation();
+  int ninput_items = noutput_items * decim;
+  gr_complex *in = out;
 
-  /* Wait until we have the requested number of samples */
-  int n_samples_avail = _fifo->size();
+  if ( decim > 1 ) {
+    _decim_buf.resize( ninput_items );
+    in = &_decim_buf[0];
+  }
+
+  if ( AIRSPY_SAMPLE_FLOAT32_IQ != _sample_type ) {
+    ninput_items = convert_samples( in, ninput_items );
+    if ( ninput_items < 0 )
+      return WORK_DONE;
+  } else {
+    /* Wait until we have the requested number of samples */
+    if ( ! _fifo.wait( ninput_items ) )
+      return WORK_DONE;
 
-  while (n_samples_avail < noutput_items) {
-    _samp_avail.wait(lock);
-    n_samples_avail = _fifo->size();
+    _fifo.pop( in, ninput_items );
+    _latency_stats.consumed( _fifo.read_count(), _fifo.size() );
   }
 
-  for(int i = 0; i < noutput_items; ++i) {
-    out[i] = _fifo->at(0);
-    _fifo->pop_front();
+  if ( decim > 1 )
+    noutput_items = _decimator.process( in, out, ninput_items - ninput_items % decim );
+  else
+    noutput_items = ninput_items;
+
+  _stats.produced( noutput_items );
+
+  if ( _tagger.enabled() ) {
+    _tagger.get_tags( 0, ninput_items, _tags );
+    for (gr::tag_t &tag : _tags) {
+      tag.offset = nitems_written(0) + tag.offset / decim;
+      if ( decim > 1 && pmt::eq( tag.key, stream_tagger::RATE_KEY() ) )
+        tag.value = pmt::from_double( get_sample_rate() );
+      add_item_tag( 0, tag );
+    }
   }
 
   //std::cerr << "-" << std::flush;
@@ -310,6 +507,64 @@ int airspy_source_c::work( int noutput_items,
   return noutput_items;
 }
 
+/* convert from the int16 or raw ring, returns -1 once the ring is closed */
+int airspy_source_c::convert_samples( gr_complex *out, int noutput_items )
+{
+  const bool raw = ( AIRSPY_SAMPLE_RAW == _sample_type );
+  const bool packed = raw && _packing;
+
+  /* ring values per group of output samples */
+  const size_t unit_items = packed ? 4 : 1;
+  const size_t unit_values = packed ? 6 : 2;
+
+  if ( ! _raw_fifo.wait( noutput_items / unit_items * unit_values ) )
+    return -1;
+
+  size_t kernel = _iqconv_kernel.load( std::memory_order_relaxed );
+  if ( raw && kernel != _iqconv_kernel_used ) {
+    _iqconv.set_kernel( airspy_kernels[kernel].taps, airspy_kernels[kernel].len );
+    _iqconv_kernel_used = kernel;
+  }
+
+  int produced = 0;
+  convert_level_t level;
+  convert_level_t *metered = _level.enabled() ? &level : NULL;
+
+  while ( produced < noutput_items ) {
+    size_t len;
+    const uint16_t *in = _raw_fifo.read_ptr( len );
+    const size_t units = std::min( len / unit_values,
+                                   (noutput_items - produced) / unit_items );
+    const size_t nitems = units * unit_items;
+
+    if ( ! units )
+      break;
+
+    if ( ! raw && metered ) {
+      convert_s16_fc32_level( (const int16_t *)in, out, nitems, 1.0f / 32768,
+                              INT16_MAX, metered );
+    } else if ( ! raw ) {
+      convert_s16_fc32( (const int16_t *)in, out, nitems, 1.0f / 32768 );
+    } else if ( packed ) {
+      _unpacked.resize( units * 8 );
+      airspy_iqconverter::unpack( (const uint32_t *)in, &_unpacked[0], units * 3 );
+      _iqconv.process( &_unpacked[0], out, nitems, metered );
+    } else {
+      _iqconv.process( in, out, nitems, metered );
+    }
+
+    _raw_fifo.consume( units * unit_values );
+    out += nitems;
+    produced += nitems;
+  }
+
+  _latency_stats.consumed( _raw_fifo.read_count(), _raw_fifo.size() );
+  if ( level.values )
+    _level.add( 0, level );
+
+  return produced;
+}
+
 std::vector<std::string> airspy_source_c::get_devices()
 {
   std::vector<std::string> devices;
@@ -350,7 +605,7 @@ osmosdr::meta_range_t airspy_source_c::get_sample_rates()
   osmosdr::meta_range_t range;
 
   for (size_t i = 0; i < _sample_rates.size(); i++)
-    range += osmosdr::range_t( _sample_rates[i].first );
+    range += osmosdr::range_t( _sample_rates[i].first / _decimator.decimation() );
 
   return range;
 }
@@ -365,7 +620,7 @@ double airspy_source_c::set_sample_rate( double rate )
 
     for( unsigned int i = 0; i < _sample_rates.size(); i++ )
     {
-      if( _sample_rates[i].first == rate )
+      if( _sample_rates[i].first == rate * _decimator.decimation() )
       {
         samp_rate_index = _sample_rates[i].second;
 
@@ -381,7 +636,9 @@ double airspy_source_c::set_sample_rate( double rate )
 
     ret = airspy_set_samplerate( _dev, samp_rate_index );
     if ( AIRSPY_SUCCESS == ret ) {
-      _sample_rate = rate;
+      _sample_rate = rate * _decimator.decimation();
+      _tagger.set_rate( _sample_rate );
+      _level.set_sample_rate( _sample_rate );
     } else {
       AIRSPY_THROW_ON_ERROR( ret, AIRSPY_FUNC_STR( "airspy_set_samplerate", rate ) )
     }
@@ -392,7 +649,7 @@ double airspy_source_c::set_sample_rate( double rate )
 
 double airspy_source_c::get_sample_rate()
 {
-  return _sample_rate;
+  return _sample_rate / _decimator.decimation();
 }
 
 osmosdr::freq_range_t airspy_source_c::get_freq_range( size_t chan )
@@ -415,6 +672,7 @@ double airspy_source_c::set_center_freq( double freq, size_t chan )
     ret = airspy_set_freq( _dev, uint64_t(corr_freq) );
     if ( AIRSPY_SUCCESS == ret ) {
       _center_freq = freq;
+      _tagger.retune( freq );
     } else {
       AIRSPY_THROW_ON_ERROR( ret, AIRSPY_FUNC_STR( "airspy_set_freq", corr_freq ) )
     }
@@ -665,26 +923,21 @@ double airspy_source_c::set_bandwidth( double bandwidth, size_t chan )
 //      size = 0;
 //    }
 //    else
+    size_t index;
     if (decim < 4)
-    {
-      kernel = KERNEL_2_80;
-      size = KERNEL_2_80_LEN;
-    }
+      index = 0;
     else if (decim < 8)
-    {
-      kernel = KERNEL_4_90;
-      size = KERNEL_4_90_LEN;
-    }
+      index = 1;
     else if (decim < 16)
-    {
-      kernel = KERNEL_8_100;
-      size = KERNEL_8_100_LEN;
-    }
+      index = 2;
     else
-    {
-      kernel = KERNEL_16_110;
-      size = KERNEL_16_110_LEN;
-    }
+      index = 3;
+
+    kernel = airspy_kernels[index].taps;
+    size = airspy_kernels[index].len;
+
+    /* the raw sample type is converted in work() */
+    _iqconv_kernel = index;
 
     if (size)
     {
@@ -700,7 +953,7 @@ double airspy_source_c::set_bandwidth( double bandwidth, size_t chan )
 
 double airspy_source_c::get_bandwidth( size_t chan )
 {
-  return _sample_rate;
+  return get_sample_rate();
 }
 
 osmosdr::freq_range_t airspy_source_c::get_bandwidth_range( size_t chan )
@@ -711,3 +964,29 @@ osmosdr::freq_range_t airspy_source_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr::stream_stats_t airspy_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats;
+
+  _stats.get_stats( stats );
+
+  if ( AIRSPY_SAMPLE_FLOAT32_IQ == _sample_type ) {
+    stats.fill = _fifo.size();
+    stats.fill_max = _fifo.fill_max();
+    stats.capacity = _fifo.capacity();
+    _latency_stats.get_stats( stats );
+  } else {
+    /* ring values per output sample, 6 values carry 4 packed samples */
+    const double values = ( AIRSPY_SAMPLE_RAW == _sample_type && _packing ) ? 1.5 : 2;
+
+    stats.fill = _raw_fifo.size() / values;
+    stats.fill_max = _raw_fifo.fill_max() / values;
+    stats.capacity = _raw_fifo.capacity() / values;
+    _latency_stats.get_stats( stats, values );
+  }
+
+  _level.get_stats( chan, stats );
+
+  return stats;
+}
@@ -22,16 +22,24 @@
 #ifndef INCLUDED_AIRSPY_SOURCE_C_H
 #define INCLUDED_AIRSPY_SOURCE_C_H
 
-#include <boost/circular_buffer.hpp>
-
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <memory>
 
 #include <gnuradio/sync_block.h>
 
 #include <libairspy/airspy.h>
 
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "airspy_iqconverter.h"
+#include "halfband_decimator.h"
+#include "latency_stats.h"
+#include "level_meter.h"
+#include "stream_tagger.h"
+#include "snapshot_timer.h"
+#include "stream_watchdog.h"
+#include "thread_sched.h"
+#include "stream_counters.h"
 
 class airspy_source_c;
 
@@ -122,15 +130,41 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   static int _airspy_rx_callback(airspy_transfer* transfer);
   int airspy_rx_callback(void *samples, int sample_count);
+  int convert_samples( gr_complex *out, int noutput_items );
+  bool restart_stream();
 
   airspy_device *_dev;
-
-  boost::circular_buffer<gr_complex> *_fifo;
-  std::mutex _fifo_lock;
-  std::condition_variable _samp_avail;
+  std::shared_ptr< airspy_device > _handle;  // owns _dev, from the device pool
+
+  spsc_ring<gr_complex> _fifo;
+
+  /* int16 and raw sample types, converted in work() */
+  enum airspy_sample_type _sample_type;
+  bool _packing;
+  spsc_ring<uint16_t> _raw_fifo;
+  thread_sched_once _sched;
+  airspy_iqconverter _iqconv;
+  std::atomic<size_t> _iqconv_kernel;  // set_bandwidth() choice, for work()
+  size_t _iqconv_kernel_used;
+  std::vector<uint16_t> _unpacked;
+
+  halfband_decimator _decimator;
+  std::vector<gr_complex> _decim_buf;
+  stream_counters _stats;
+  latency_stats _latency_stats;
+  level_meter _level;
+  stream_tagger _tagger;
+  std::vector<gr::tag_t> _tags;
+
+  stream_watchdog _watchdog;
+  double _watchdog_timeout;
+  std::atomic<bool> _running;
+  snapshot_timer _snapshot;     // snapshot=, starts and stops streaming
 
   std::vector< std::pair<double, uint32_t> > _sample_rates;
   double _sample_rate;
@@ -43,6 +43,9 @@
 
 using namespace boost::assign;
 
+#define BUFFER_MS_DEFAULT 500     // host FIFO depth
+#define FIFO_MIN_SIZE     65536   // a few transfers at the lowest rates
+
 #define AIRSPYHF_FORMAT_ERROR(ret, msg) \
   boost::str( boost::format(msg " (%1%)") % ret )
 
@@ -82,6 +85,7 @@ airspyhf_source_c::airspyhf_source_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
+    _buffer_ms(BUFFER_MS_DEFAULT),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0)
@@ -90,6 +94,16 @@ airspyhf_source_c::airspyhf_source_c (const std::string &args)
 
   dict_t dict = params_to_dict(args);
 
+  _fifo.set_buffer_opts(buffer_opts_from_dict(dict));
+  _sched = thread_sched_once( thread_sched_from_dict( dict ) );
+
+  /* the FIFO holds that many ms of samples at the current rate */
+  if ( dict.count( "buffer_ms" ) )
+    _buffer_ms = boost::lexical_cast<double>( dict["buffer_ms"] );
+
+  if ( _buffer_ms <= 0 )
+    _buffer_ms = BUFFER_MS_DEFAULT;
+
   _dev = NULL;
   ret = airspyhf_open( &_dev );
   AIRSPYHF_THROW_ON_ERROR(ret, "Failed to open Airspy HF+ device")
@@ -115,12 +129,6 @@ airspyhf_source_c::airspyhf_source_c (const std::string &args)
 
   set_center_freq( (get_freq_range().start() + get_freq_range().stop()) / 2.0 );
   set_sample_rate( get_sample_rates().start() );
-
-  _fifo = new boost::circular_buffer<gr_complex>(5000000);
-  if (!_fifo) {
-    throw std::runtime_error( std::string(__FUNCTION__) + " " +
-                              "Failed to allocate a sample FIFO!" );
-  }
 }
 
 /*
@@ -147,51 +155,30 @@ airspyhf_source_c::~airspyhf_source_c ()
     }
     _dev = NULL;
   }
-
-  if (_fifo)
-  {
-    delete _fifo;
-    _fifo = NULL;
-  }
 }
 
 int airspyhf_source_c::_airspyhf_rx_callback(airspyhf_transfer_t *transfer)
 {
   airspyhf_source_c *obj = (airspyhf_source_c *)transfer->ctx;
 
+  obj->_sched.apply();
+
   return obj->airspyhf_rx_callback((float *)transfer->samples, transfer->sample_count);
 }
 
 int airspyhf_source_c::airspyhf_rx_callback(void *samples, int sample_count)
 {
-  size_t i, n_avail, to_copy, num_samples = sample_count;
-  float *sample = (float *)samples;
+  size_t to_copy, num_samples = sample_count;
 
-  _fifo_lock.lock();
-
-  n_avail = _fifo->capacity() - _fifo->size();
-  to_copy = (n_avail < num_samples ? n_avail : num_samples);
-
-  for (i = 0; i < to_copy; i++ )
-  {
-    /* Push sample to the fifo */
-    _fifo->push_back( gr_complex( *sample, *(sample+1) ) );
-
-    /* offset to the next I+Q sample */
-    sample += 2;
-  }
-
-  _fifo_lock.unlock();
-
-  /* We have made some new samples available to the consumer in work() */
-  if (to_copy) {
-    //std::cerr << "+" << std::flush;
-    _samp_avail.notify_one();
-  }
+  /* interleaved float I/Q has the same layout as gr_complex */
+  _latency_stats.arrival( _fifo.write_count() );
+  to_copy = _fifo.push( (gr_complex *)samples, num_samples );
 
   /* Indicate overrun, if neccesary */
-  if (to_copy < num_samples)
+  if (to_copy < num_samples) {
+    _stats.overrun( num_samples - to_copy );
     std::cerr << "O" << std::flush;
+  }
 
   return 0; // TODO: return -1 on error/stop
 }
@@ -201,6 +188,12 @@ bool airspyhf_source_c::start()
   if ( ! _dev )
     return false;
 
+  /* a rate change while streaming takes effect here */
+  resize_fifo();
+  _fifo.reset();
+  _latency_stats.reset();
+  _sched.reset();
+
   int ret = airspyhf_start( _dev, _airspyhf_rx_callback, (void *)this );
   if ( ret != AIRSPYHF_SUCCESS ) {
     std::cerr << "Failed to start RX streaming (" << ret << ")" << std::endl;
@@ -216,6 +209,10 @@ bool airspyhf_source_c::stop()
     return false;
 
   int ret = airspyhf_stop( _dev );
+
+  /* release work() if it is waiting for samples */
+  _fifo.close();
+
   if ( ret != AIRSPYHF_SUCCESS ) {
     std::cerr << "Failed to stop RX streaming (" << ret << ")" << std::endl;
     return false;
@@ -238,20 +235,13 @@ int airspyhf_source_c::work( int noutput_items,
   if ( ! running )
     return WORK_DONE;
 
-  std::unique_lock<std::mutex> lock(_fifo_lock);
-
   /* Wait until we have the requested number of samples */
-  int n_samples_avail = _fifo->size();
-
-  while (n_samples_avail < noutput_items) {
-    _samp_avail.wait(lock);
-    n_samples_avail = _fifo->size();
-  }
+  if ( ! _fifo.wait( noutput_items ) )
+    return WORK_DONE;
 
-  for(int i = 0; i < noutput_items; ++i) {
-    out[i] = _fifo->at(0);
-    _fifo->pop_front();
-  }
+  _fifo.pop( out, noutput_items );
+  _latency_stats.consumed( _fifo.read_count(), _fifo.size() );
+  _stats.produced( noutput_items );
 
   return noutput_items;
 }
@@ -316,6 +306,10 @@ double airspyhf_source_c::set_sample_rate( double rate )
     ret = airspyhf_set_samplerate( _dev, samp_rate_index );
     if ( AIRSPYHF_SUCCESS == ret ) {
       _sample_rate = rate;
+
+      /* the callback is writing to the FIFO while streaming */
+      if ( ! airspyhf_is_streaming( _dev ) )
+        resize_fifo();
     } else {
       AIRSPYHF_THROW_ON_ERROR( ret, AIRSPYHF_FUNC_STR( "airspyhf_set_samplerate", rate ) )
     }
@@ -324,6 +318,14 @@ double airspyhf_source_c::set_sample_rate( double rate )
   return get_sample_rate();
 }
 
+void airspyhf_source_c::resize_fifo()
+{
+  size_t size = std::max<size_t>( _sample_rate * _buffer_ms / 1e3, FIFO_MIN_SIZE );
+
+  if ( size != _fifo.capacity() )
+    _fifo.resize( size );
+}
+
 double airspyhf_source_c::get_sample_rate()
 {
   return _sample_rate;
@@ -435,3 +437,17 @@ std::string airspyhf_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t airspyhf_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats;
+
+  _stats.get_stats( stats );
+
+  stats.fill = _fifo.size();
+  stats.fill_max = _fifo.fill_max();
+  stats.capacity = _fifo.capacity();
+  _latency_stats.get_stats( stats );
+
+  return stats;
+}
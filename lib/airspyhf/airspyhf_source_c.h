@@ -22,16 +22,15 @@
 #ifndef INCLUDED_AIRSPYHF_SOURCE_C_H
 #define INCLUDED_AIRSPYHF_SOURCE_C_H
 
-#include <boost/circular_buffer.hpp>
-
-#include <mutex>
-#include <condition_variable>
-
 #include <gnuradio/sync_block.h>
 
 #include <libairspyhf/airspyhf.h>
 
+#include "latency_stats.h"
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+#include "stream_counters.h"
 
 class airspyhf_source_c;
 
@@ -98,16 +97,20 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
 
 private:
   static int _airspyhf_rx_callback(airspyhf_transfer_t* transfer);
   int airspyhf_rx_callback(void *samples, int sample_count);
+  void resize_fifo();
 
   airspyhf_device *_dev;
 
-  boost::circular_buffer<gr_complex> *_fifo;
-  std::mutex _fifo_lock;
-  std::condition_variable _samp_avail;
+  spsc_ring<gr_complex> _fifo;
+  thread_sched_once _sched;
+  stream_counters _stats;
+  latency_stats _latency_stats;
+  double _buffer_ms;
 
   std::vector< std::pair<double, uint32_t> > _sample_rates;
   double _sample_rate;
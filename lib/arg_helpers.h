@@ -24,6 +24,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <stdexcept>
 
 #include <gnuradio/io_signature.h>
 
@@ -109,15 +110,124 @@ inline dict_t params_to_dict( const std::string &params )
   return result;
 }
 
-struct is_nchan_argument
+/* drop key from a set_config() dict when the cache holds its value
+ * already, take the value into the cache otherwise */
+template< typename T >
+inline void filter_cached( dict_t &config, const std::string &key, T &cached )
+{
+  if ( ! config.count( key ) )
+    return;
+
+  T value = boost::lexical_cast< T >( config[ key ] );
+
+  if ( value == cached )
+    config.erase( key );
+  else
+    cached = value;
+}
+
+/* sample types which can be selected with type= */
+inline bool is_item_type( const std::string &type )
+{
+  return "fc32" == type || "sc16" == type || "sc8" == type;
+}
+
+inline size_t item_type_to_size( const std::string &type )
+{
+  if ( "sc16" == type )
+    return 2 * sizeof(int16_t);
+
+  if ( "sc8" == type )
+    return 2 * sizeof(int8_t);
+
+  return sizeof(gr_complex);
+}
+
+/* type= may be given globally or with a device, other values of type
+ * (like the uhd device type) are left to the backends */
+inline std::string args_to_item_type( const std::string &args )
+{
+  std::string type;
+
+  for (std::string arg : args_to_vector( args ))
+  {
+    dict_t dict = params_to_dict( arg );
+    if ( dict.count("type") && is_item_type( dict["type"] ) )
+    {
+      if ( type.size() && type != dict["type"] )
+        throw std::runtime_error("Conflicting sample types given via type=.");
+
+      type = dict["type"];
+    }
+  }
+
+  return type.size() ? type : "fc32";
+}
+
+/* channels=f1:bw1,f2:bw2 goes with a device and lists channels to extract
+ * from it, the items after the first one are told apart from the other
+ * parameters by the colon. they are taken out of the device arguments. */
+inline std::vector< std::string > split_channels_arg( std::string &arg )
+{
+  std::vector< std::string > specs;
+
+  if ( arg.find( "channels=" ) == std::string::npos )
+    return specs;
+
+  std::string rest;
+  bool in_list = false;
+
+  for (std::string param : params_to_vector( arg ))
+  {
+    if ( param.find( "channels=" ) == 0 ) {
+      specs.push_back( param.substr( 9 ) );
+      in_list = true;
+      continue;
+    }
+
+    if ( in_list && param.find( ':' ) != std::string::npos &&
+         param.find( '=' ) == std::string::npos ) {
+      specs.push_back( param );
+      continue;
+    }
+
+    in_list = false;
+
+    /* quote again what the tokenizer took the quotes off */
+    pair_t pair = param_to_pair( param );
+    if ( pair.second.find_first_of( ", " ) != std::string::npos )
+      param = pair.first + "='" + pair.second + "'";
+
+    if ( rest.size() ) rest += ",";
+    rest += param;
+  }
+
+  arg = rest;
+
+  return specs;
+}
+
+/* tokens like numchan=2, type=sc16, sync=pps, start_delay=0.5 or
+ * tx_latency_ms=20 are options of the block, not a device */
+struct is_global_argument
 {
   bool operator ()(const std::string &str)
   {
-    return str.find("numchan=") == 0;
+    for (const dict_t::value_type &pair : params_to_dict( str ))
+      if ( "numchan" != pair.first && "type" != pair.first &&
+           "sync" != pair.first && "start_delay" != pair.first &&
+           "tx_latency_ms" != pair.first )
+        return false;
+
+    return true;
   }
 };
 
-inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
+/* with channelize every channel given with channels= is an output of its
+ * own, in place of the first channel of the device */
+inline gr::io_signature::sptr args_to_io_signature( const std::string &args,
+                                                    size_t itemsize = sizeof(gr_complex),
+                                                    bool channelize = false )
 {
   size_t max_nchan = 0;
   size_t dev_nchan = 0;
@@ -132,16 +242,25 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
     }
   }
 
-  arg_list.erase( std::remove_if( // remove any global nchan tokens
+  arg_list.erase( std::remove_if( // remove any global tokens
                     arg_list.begin(),
                     arg_list.end(),
-                    is_nchan_argument() ),
+                    is_global_argument() ),
                   arg_list.end() );
 
   // try to parse device specific nchan values, assume 1 channel if none given
 
+  size_t extracted = 0;
+
   for (std::string arg : arg_list)
   {
+    if ( channelize )
+    {
+      std::vector< std::string > specs = split_channels_arg( arg );
+      if ( specs.size() )
+        extracted += specs.size() - 1;
+    }
+
     dict_t dict = params_to_dict(arg);
     if (dict.count("nchan"))
     {
@@ -157,8 +276,10 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
   if ( max_nchan && dev_nchan && max_nchan != dev_nchan )
     throw std::runtime_error("Wrong device arguments specified. Missing nchan?");
 
+  dev_nchan += extracted;
+
   const size_t nchan = std::max<size_t>(dev_nchan, 1); // assume at least one
-  return gr::io_signature::make(nchan, nchan, sizeof(gr_complex));
+  return gr::io_signature::make(nchan, nchan, itemsize);
 }
 
 #endif // OSMOSDR_ARG_HELPERS_H
@@ -0,0 +1,226 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+#ifdef ENABLE_BACKEND_MODULES
+#include <cstdlib>
+#include <set>
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <boost/algorithm/string.hpp>
+#endif
+
+#include "backend_registry.h"
+
+/* both are constructed on first use, the registrars of the backends run
+ * during static initialization. The mutex is taken again when a module
+ * registers its backends from within dlopen(). */
+static std::recursive_mutex &registry_mutex()
+{
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+static std::vector< backend_t > &registry()
+{
+  static std::vector< backend_t > backends;
+  return backends;
+}
+
+bool backend_t::handles( const dict_t &dict ) const
+{
+  if ( dict.count( name ) )
+    return true;
+
+  for (const std::string &alias : aliases)
+    if ( dict.count( alias ) )
+      return true;
+
+  return false;
+}
+
+void register_backend( const backend_t &backend )
+{
+  std::lock_guard< std::recursive_mutex > lock( registry_mutex() );
+
+  std::vector< backend_t > &list = registry();
+
+  list.insert( std::upper_bound( list.begin(), list.end(), backend,
+                                 []( const backend_t &a, const backend_t &b ) {
+                                   return a.order < b.order;
+                                 } ),
+               backend );
+}
+
+#ifdef ENABLE_BACKEND_MODULES
+#define MODULE_PREFIX "osmosdr-"
+
+/* GR_OSMOSDR_MODULE_PATH overrides the directory the modules were
+ * installed to */
+static std::string module_dir()
+{
+  const char *path = std::getenv( "GR_OSMOSDR_MODULE_PATH" );
+
+  return path ? path : GR_OSMOSDR_MODULE_DIR;
+}
+
+/* the modules looked for, loaded or not */
+static std::set< std::string > &tried_modules()
+{
+  static std::set< std::string > names;
+  return names;
+}
+
+/* the module of a device argument key, the keys of a module besides its
+ * name are known from the build */
+static std::string module_of( const std::string &key )
+{
+  std::vector< std::string > aliases;
+  boost::split( aliases, GR_OSMOSDR_MODULE_ALIASES, boost::is_any_of(",") );
+
+  for (const std::string &alias : aliases) {
+    size_t pos = alias.find( '=' );
+    if ( pos != std::string::npos && alias.substr( 0, pos ) == key )
+      return alias.substr( pos + 1 );
+  }
+
+  return key;
+}
+
+/* the backends of a module register themselves while it is loaded.
+ * Modules stay loaded, the blocks made by them may outlive any source. */
+static void load_module( const std::string &name )
+{
+  if ( ! tried_modules().insert( name ).second )
+    return;
+
+  const std::string path = module_dir() + "/" MODULE_PREFIX + name +
+                           GR_OSMOSDR_MODULE_SUFFIX;
+
+  if ( access( path.c_str(), F_OK ) != 0 )
+    return;
+
+  if ( ! dlopen( path.c_str(), RTLD_NOW | RTLD_LOCAL ) )
+    std::cerr << "Loading " << path << " failed: " << dlerror() << std::endl;
+}
+
+static std::vector< std::string > installed_modules()
+{
+  std::vector< std::string > names;
+  const std::string prefix = MODULE_PREFIX;
+  const std::string suffix = GR_OSMOSDR_MODULE_SUFFIX;
+
+  DIR *dir = opendir( module_dir().c_str() );
+  if ( ! dir )
+    return names;
+
+  while ( struct dirent *entry = readdir( dir ) ) {
+    const std::string file = entry->d_name;
+
+    if ( file.size() > prefix.size() + suffix.size() &&
+         boost::starts_with( file, prefix ) && boost::ends_with( file, suffix ) )
+      names.push_back( file.substr( prefix.size(),
+                                    file.size() - prefix.size() - suffix.size() ) );
+  }
+
+  closedir( dir );
+
+  std::sort( names.begin(), names.end() );
+
+  return names;
+}
+#endif
+
+std::vector< backend_t > get_backends()
+{
+  std::lock_guard< std::recursive_mutex > lock( registry_mutex() );
+
+#ifdef ENABLE_BACKEND_MODULES
+  for (const std::string &name : installed_modules())
+    load_module( name );
+#endif
+
+  return registry();
+}
+
+bool find_backend( const dict_t &dict, backend_t &backend )
+{
+  std::lock_guard< std::recursive_mutex > lock( registry_mutex() );
+
+  auto find = [&]() -> bool {
+    for (const backend_t &candidate : registry())
+      if ( candidate.handles( dict ) ) {
+        backend = candidate;
+        return true;
+      }
+
+    return false;
+  };
+
+  if ( find() )
+    return true;
+
+#ifdef ENABLE_BACKEND_MODULES
+  for (const dict_t::value_type &entry : dict)
+    load_module( module_of( entry.first ) );
+
+  return find();
+#else
+  return false;
+#endif
+}
+
+std::vector< std::string > get_backend_names( bool sink )
+{
+  std::lock_guard< std::recursive_mutex > lock( registry_mutex() );
+
+  std::vector< std::string > names;
+
+  for (const backend_t &backend : registry())
+    if ( sink ? bool( backend.make_sink ) : bool( backend.make_source ) )
+      names.push_back( backend.name );
+
+  return names;
+}
+
+std::vector< std::string > get_unloaded_modules()
+{
+  std::vector< std::string > names;
+
+#ifdef ENABLE_BACKEND_MODULES
+  std::lock_guard< std::recursive_mutex > lock( registry_mutex() );
+
+  for (const std::string &name : installed_modules())
+    if ( ! tried_modules().count( name ) )
+      names.push_back( name );
+#endif
+
+  return names;
+}
@@ -0,0 +1,110 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_BACKEND_REGISTRY_H
+#define OSMOSDR_BACKEND_REGISTRY_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <gnuradio/basic_block.h>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+#include "source_iface.h"
+#include "sink_iface.h"
+
+/*!
+ * A device backend, as the source, the sink and osmosdr::device::find
+ * see it. The source and sink factories and device lists are empty when
+ * the backend has none.
+ */
+struct backend_t
+{
+  struct source_t
+  {
+    gr::basic_block_sptr block;
+    source_iface *iface;
+  };
+
+  struct sink_t
+  {
+    gr::basic_block_sptr block;
+    sink_iface *iface;
+  };
+
+  backend_t() : order(0), fakes(false), slow_open(false) {}
+
+  std::string name;                   // device argument key, listed as type
+  std::vector< std::string > aliases; // further device argument keys
+  int order;                          // of listing and auto-detection
+  bool fakes;                         // lists fake devices when asked to
+  bool slow_open;                     // devices are opened all at once
+
+  std::function< std::vector< std::string >( bool fake ) > source_devices;
+  std::function< source_t( const std::string &args ) > make_source;
+
+  std::function< std::vector< std::string >( bool fake ) > sink_devices;
+  std::function< sink_t( const std::string &args ) > make_sink;
+
+  /*! \return whether \p dict names the backend */
+  bool handles( const dict_t &dict ) const;
+};
+
+/*!
+ * Adds a backend. Every backend calls it through a backend_registrar of
+ * its own, so it is registered when the library or its module is loaded.
+ */
+OSMOSDR_API void register_backend( const backend_t &backend );
+
+struct backend_registrar
+{
+  backend_registrar( const backend_t &backend ) { register_backend( backend ); }
+};
+
+/*!
+ * All backends in backend_t::order, hardware first. Built as modules,
+ * every module is loaded for it.
+ */
+std::vector< backend_t > get_backends();
+
+/*!
+ * Finds the backend handling one of the keys of \p dict. Built as
+ * modules, the module of a key is loaded when no loaded backend handles
+ * it, the other modules stay unloaded.
+ *
+ * \return false when no backend handles \p dict
+ */
+bool find_backend( const dict_t &dict, backend_t &backend );
+
+/*!
+ * \return the names of the loaded backends with a source, or with a sink
+ * when \p sink is set
+ */
+std::vector< std::string > get_backend_names( bool sink );
+
+/*!
+ * \return the names of the modules not loaded yet, empty unless the
+ * backends are built as modules
+ */
+std::vector< std::string > get_unloaded_modules();
+
+#endif // OSMOSDR_BACKEND_REGISTRY_H
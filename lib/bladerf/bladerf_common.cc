@@ -44,6 +44,11 @@
 static size_t const NUM_BUFFERS = 512;
 static size_t const NUM_SAMPLES_PER_BUFFER = (4 * 1024);
 static size_t const NUM_TRANSFERS = 32;
+
+/* limits of the latency_ms buffer sizing */
+static size_t const AUTO_MIN_TRANSFERS = 4;
+static size_t const AUTO_MAX_SAMPLES_PER_BUFFER = (64 * 1024);
+static size_t const AUTO_HEADROOM = 4;  /* buffers per active transfer */
 static size_t const STREAM_TIMEOUT_MS = 3000;
 
 using namespace boost::assign;
@@ -139,6 +144,7 @@ bladerf_common::bladerf_common() :
   _num_buffers(NUM_BUFFERS),
   _samples_per_buffer(NUM_SAMPLES_PER_BUFFER),
   _num_transfers(NUM_TRANSFERS),
+  _latency_ms(0),
   _stream_timeout(STREAM_TIMEOUT_MS),
   _format(BLADERF_FORMAT_SC16_Q11)
 {
@@ -158,6 +164,8 @@ void bladerf_common::init(dict_t const &dict, bladerf_direction direction)
   _pfx = boost::str(boost::format("[bladeRF %s] ")
           % (direction == BLADERF_TX ? "sink" : "source"));
 
+  _buf_opts = buffer_opts_from_dict(dict);
+
   /* libbladeRF verbosity */
   if (dict.count("verbosity")) {
     set_verbosity(_get(dict, "verbosity"));
@@ -313,6 +321,10 @@ void bladerf_common::init(dict_t const &dict, bladerf_direction direction)
     _stream_timeout = boost::lexical_cast<unsigned int>(_get(dict, "stream_timeout_ms"));
   }
 
+  if (dict.count("latency_ms")) {
+    _latency_ms = boost::lexical_cast<double>(_get(dict, "latency_ms"));
+  }
+
   if (dict.count("enable_metadata") > 0) {
     _format = BLADERF_FORMAT_SC16_Q11_META;
   }
@@ -353,6 +365,81 @@ void bladerf_common::init(dict_t const &dict, bladerf_direction direction)
                 % _num_transfers));
 }
 
+/* The active transfers are what a sample has to wait through, they get
+ * sized to the latency target. The buffers behind them are a multiple of
+ * that, so a slow work() call does not immediately cause an overrun. */
+bool bladerf_common::size_buffers(double rate)
+{
+  if (_latency_ms <= 0) {
+    return false;
+  }
+
+  size_t target = static_cast<size_t>(rate * _latency_ms / 1e3);
+
+  size_t buflen = (target / AUTO_MIN_TRANSFERS) / 1024 * 1024;
+  buflen = std::min(std::max(buflen, size_t(1024)), AUTO_MAX_SAMPLES_PER_BUFFER);
+
+  size_t transfers = std::min(std::max(target / buflen, AUTO_MIN_TRANSFERS),
+                              NUM_TRANSFERS);
+  size_t buffers = transfers * AUTO_HEADROOM;
+
+  if (buflen == _samples_per_buffer && transfers == _num_transfers &&
+      buffers == _num_buffers) {
+    return false;
+  }
+
+  _samples_per_buffer = buflen;
+  _num_transfers = transfers;
+  _num_buffers = buffers;
+
+  BLADERF_INFO(boost::str(boost::format("Buffers: %d, samples per buffer: "
+                "%d, active transfers: %d (%.1f ms)")
+                % _num_buffers
+                % _samples_per_buffer
+                % _num_transfers
+                % (_num_transfers * _samples_per_buffer * 1e3 / rate)));
+
+  return true;
+}
+
+size_t bladerf_common::max_samples_per_buffer()
+{
+  return (_latency_ms > 0) ? AUTO_MAX_SAMPLES_PER_BUFFER : _samples_per_buffer;
+}
+
+void bladerf_common::restart_stream(bladerf_direction direction,
+                                    bladerf_channel_layout layout)
+{
+  int status;
+
+  for (size_t ch = 0; ch < get_max_channels(direction); ++ch) {
+    bladerf_channel brfch = (direction == BLADERF_TX) ? BLADERF_CHANNEL_TX(ch)
+                                                      : BLADERF_CHANNEL_RX(ch);
+    if (get_channel_enable(brfch)) {
+      status = bladerf_enable_module(_dev.get(), brfch, false);
+      if (status != 0) {
+        BLADERF_THROW_STATUS(status, "bladerf_enable_module failed");
+      }
+    }
+  }
+
+  status = bladerf_sync_config(_dev.get(), layout, _format, _num_buffers,
+                               _samples_per_buffer, _num_transfers,
+                               _stream_timeout);
+  if (status != 0) {
+    BLADERF_THROW_STATUS(status, "bladerf_sync_config failed");
+  }
+
+  for (size_t ch = 0; ch < get_max_channels(direction); ++ch) {
+    bladerf_channel brfch = (direction == BLADERF_TX) ? BLADERF_CHANNEL_TX(ch)
+                                                      : BLADERF_CHANNEL_RX(ch);
+    status = bladerf_enable_module(_dev.get(), brfch, get_channel_enable(brfch));
+    if (status != 0) {
+      BLADERF_THROW_STATUS(status, "bladerf_enable_module failed");
+    }
+  }
+}
+
 std::vector<std::string> bladerf_common::devices()
 {
   struct bladerf_devinfo *devices;
@@ -631,6 +718,59 @@ double bladerf_common::get_center_freq(bladerf_channel ch)
   return static_cast<double>(freq);
 }
 
+size_t bladerf_common::set_hop_freqs(std::vector<double> const &freqs,
+                                     bladerf_channel ch)
+{
+  int status;
+  double current = get_center_freq(ch);
+  std::vector<bladerf_hop> &hops = _hops[ch];
+
+  hops.clear();
+
+  for (double freq : freqs) {
+    bladerf_hop hop;
+
+    if (freq < freq_range(ch).start() || freq > freq_range(ch).stop()) {
+      BLADERF_THROW(boost::str(boost::format("Hop frequency %d Hz is outside "
+                    "range") % freq));
+    }
+
+    hop.freq = set_center_freq(freq, ch);
+
+    status = bladerf_get_quick_tune(_dev.get(), ch, &hop.quick_tune);
+    if (status != 0) {
+      BLADERF_THROW_STATUS(status, "bladerf_get_quick_tune failed");
+    }
+
+    hops.push_back(hop);
+  }
+
+  set_center_freq(current, ch);
+
+  return hops.size();
+}
+
+double bladerf_common::hop_center_freq(size_t index, uint64_t timestamp,
+                                       bladerf_channel ch)
+{
+  int status;
+  std::vector<bladerf_hop> &hops = _hops[ch];
+
+  if (index >= hops.size()) {
+    BLADERF_THROW(boost::str(boost::format("Hop index %d is out of range, "
+                  "the table has %d entries") % index % hops.size()));
+  }
+
+  /* the frequency is ignored when quick tune parameters are given */
+  status = bladerf_schedule_retune(_dev.get(), ch, timestamp, 0,
+                                   &hops[index].quick_tune);
+  if (status != 0) {
+    BLADERF_THROW_STATUS(status, "bladerf_schedule_retune failed");
+  }
+
+  return hops[index].freq;
+}
+
 osmosdr::freq_range_t bladerf_common::filter_bandwidths(bladerf_channel ch)
 {
   osmosdr::freq_range_t bandwidths;
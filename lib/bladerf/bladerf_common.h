@@ -32,6 +32,7 @@
 
 #include "osmosdr/ranges.h"
 #include "arg_helpers.h"
+#include "buffer_pool.h"
 
 #include "bladerf_compat.h"
 
@@ -58,6 +59,14 @@ typedef std::map<bladerf_channel, bool> bladerf_channel_enable_map;
 /* Mapping of bladerf_channel to gnuradio port/chan */
 typedef std::map<bladerf_channel, int> bladerf_channel_map;
 
+/* Frequency hopping table entry */
+typedef struct {
+  double freq;
+  struct bladerf_quick_tune quick_tune;
+} bladerf_hop;
+
+typedef std::map<bladerf_channel, std::vector<bladerf_hop>> bladerf_hop_map;
+
 /* Convenience macros for throwing a runtime error */
 #define BLADERF_THROW(message)                                              \
   {                                                                         \
@@ -127,6 +136,8 @@ protected:
    * USB INTERFACE CONTROL:
    *  buffers         (default: NUM_BUFFERS)
    *  buflen          (default: NUM_SAMPLES_PER_BUFFER)
+   *  latency_ms      size buffers, buflen and transfers for this latency
+   *                  at the current sample rate, overrides the above
    *  stream_timeout  valid time in milliseconds (default: 3000)
    *  transfers       (default: NUM_TRANSFERS)
    * FPGA CONTROL:
@@ -152,6 +163,15 @@ protected:
    */
   void init(dict_t const &dict, bladerf_direction direction);
 
+  /* With latency_ms, derive the stream buffers from the rate (in samples
+   * per second summed over all channels). Returns true if they changed. */
+  bool size_buffers(double rate);
+  /* Largest buflen work() has to be prepared for */
+  size_t max_samples_per_buffer();
+  /* Apply a new buffer configuration to a running stream */
+  void restart_stream(bladerf_direction direction,
+                      bladerf_channel_layout layout);
+
   /* Get a vector of available devices */
   static std::vector<std::string> devices();
   /* Get the type of the open bladeRF board */
@@ -189,6 +209,11 @@ protected:
   /* Get the center RF frequency of channel ch */
   double get_center_freq(bladerf_channel ch);
 
+  /* Tune to every frequency once and keep the quick tune parameters */
+  size_t set_hop_freqs(std::vector<double> const &freqs, bladerf_channel ch);
+  /* Retune to a table entry at timestamp (BLADERF_RETUNE_NOW for now) */
+  double hop_center_freq(size_t index, uint64_t timestamp, bladerf_channel ch);
+
   /* Get range of supported bandwidths for channel ch */
   osmosdr::freq_range_t filter_bandwidths(bladerf_channel ch);
   /* Set the bandwidth on channel ch to bandwidth */
@@ -250,12 +275,15 @@ protected:
   size_t _num_buffers;          /**< number of buffers to allocate */
   size_t _samples_per_buffer;   /**< how many samples per buffer */
   size_t _num_transfers;        /**< number of active backend transfers */
+  double _latency_ms;           /**< latency target, 0 for fixed buffers */
   unsigned int _stream_timeout; /**< timeout for backend transfers */
+  buffer_opts_t _buf_opts;      /**< allocation of the conversion buffers */
 
   bladerf_format _format;       /**< sample format to use */
 
   bladerf_channel_map _chanmap; /**< map of antennas to channels */
   bladerf_channel_enable_map _enables;  /**< enabled channels */
+  bladerf_hop_map _hops;        /**< frequency hopping tables */
 
   /*****************************************************************************
    * Protected constants
@@ -28,7 +28,9 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -41,6 +43,7 @@
 #include "arg_helpers.h"
 #include "bladerf_sink_c.h"
 #include "osmosdr/sink.h"
+#include "sample_convert.h"
 
 using namespace boost::assign;
 
@@ -69,9 +72,12 @@ bladerf_sink_c::bladerf_sink_c(const std::string &args) :
                   args_to_io_signature(args),
                   gr::io_signature::make(0, 0, 0)),
   _16icbuf(NULL),
-  _32fcbuf(NULL),
   _in_burst(false),
-  _running(false)
+  _start_pending(false),
+  _running(false),
+  _rate_changed(false),
+  _last_count(0),
+  _wave_pos(0)
 {
   dict_t dict = params_to_dict(args);
 
@@ -95,6 +101,23 @@ bladerf_sink_c::bladerf_sink_c(const std::string &args) :
     set_biastee_mode(dict["biastee"]);
   }
 
+  /* There is no underrun report on the sync interface, the pacer tells
+   * them from the host clock */
+  tx_policy_t policy = tx_policy_from_dict(dict);
+
+  if (BLADERF_FORMAT_SC16_Q11_META == _format && policy.prefill) {
+    BLADERF_WARNING("Warning: 'prefill' has no effect with 'enable_metadata', "
+                    "bursts start with their tx_sob tag.");
+    policy.prefill = 0;
+  }
+
+  /* tx_latency_ms= sizes the transfers too, unless latency_ms= does */
+  if (policy.latency > 0 && _latency_ms <= 0) {
+    _latency_ms = policy.latency * 1e3;
+  }
+
+  _pacer.init(policy, get_num_channels());
+
   /* Initialize channel <-> antenna map */
   for (std::string ant : get_antennas()) {
     _chanmap[str2channel(ant)] = -1;
@@ -115,7 +138,7 @@ bladerf_sink_c::bladerf_sink_c(const std::string &args) :
   /* Set up constraints */
   int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
   set_alignment(std::max(1,alignment_multiple));
-  set_max_noutput_items(_samples_per_buffer);
+  set_max_noutput_items(max_samples_per_buffer());
   set_output_multiple(get_num_channels());
 
   /* Set channel layout */
@@ -164,6 +187,9 @@ bool bladerf_sink_c::start()
   gr::thread::scoped_lock guard(d_mutex);
 
   _in_burst = false;
+  _start_pending = static_cast<bool>(_timed_start);
+
+  size_buffers(get_sample_rate() * get_num_channels());
 
   status = bladerf_sync_config(_dev.get(), _layout, _format, _num_buffers,
                                _samples_per_buffer, _num_transfers,
@@ -181,11 +207,11 @@ bool bladerf_sink_c::start()
   }
 
   /* Allocate memory for conversions in work() */
-  size_t alignment = volk_get_alignment();
-
-  _16icbuf = reinterpret_cast<int16_t *>(volk_malloc(2*_samples_per_buffer*sizeof(int16_t), alignment));
-  _32fcbuf = reinterpret_cast<gr_complex *>(volk_malloc(_samples_per_buffer*sizeof(gr_complex), alignment));
+  _16icbuf = reinterpret_cast<int16_t *>(buffer_acquire(2*max_samples_per_buffer()*sizeof(int16_t), _buf_opts));
 
+  _rate_changed = false;
+  _last_count = 0;
+  _pacer.start(get_sample_rate());
   _running = true;
 
   return true;
@@ -206,6 +232,10 @@ bool bladerf_sink_c::stop()
 
   _running = false;
 
+  if (_timed_start) {
+    _timed_start->reset();
+  }
+
   for (size_t ch = 0; ch < get_max_channels(); ++ch) {
     bladerf_channel brfch = BLADERF_CHANNEL_TX(ch);
     status = bladerf_enable_module(_dev.get(), brfch, get_channel_enable(brfch));
@@ -215,10 +245,8 @@ bool bladerf_sink_c::stop()
   }
 
   /* Deallocate conversion memory */
-  volk_free(_16icbuf);
-  volk_free(_32fcbuf);
+  buffer_release(_16icbuf);
   _16icbuf = NULL;
-  _32fcbuf = NULL;
 
   return true;
 }
@@ -228,7 +256,6 @@ int bladerf_sink_c::work(int noutput_items,
                           gr_vector_void_star &output_items)
 {
   int status;
-  size_t nstreams = num_streams(_layout);
 
   gr::thread::scoped_lock guard(d_mutex);
 
@@ -237,34 +264,17 @@ int bladerf_sink_c::work(int noutput_items,
     return 0;
   }
 
-  // copy the samples from input_items
-  gr_complex const **in = reinterpret_cast<gr_complex const **>(&input_items[0]);
-
-  if (nstreams > 1) {
-    // we need to interleave the streams as we copy
-    gr_complex *intl_out = _32fcbuf;
-
-    for (size_t i = 0; i < (noutput_items/nstreams); ++i) {
-      for (size_t n = 0; n < nstreams; ++n) {
-        memcpy(intl_out++, in[n]++, sizeof(gr_complex));
-      }
-    }
-  } else {
-    // no interleaving to do: simply copy everything
-    memcpy(_32fcbuf, in[0], noutput_items * sizeof(gr_complex));
+  if (_rate_changed.exchange(false) &&
+      size_buffers(get_sample_rate() * get_num_channels())) {
+    restart_stream(BLADERF_TX, _layout);
   }
 
-  // convert floating point to fixed point and scale
-  // input_items is gr_complex (2x float), so num_points is 2*noutput_items
-  volk_32f_s32f_convert_16i(_16icbuf, reinterpret_cast<float const *>(_32fcbuf),
-                            SCALING_FACTOR, 2*noutput_items);
-
-  // transmit the samples from the temp buffer
-  if (BLADERF_FORMAT_SC16_Q11_META == _format) {
-    status = transmit_with_tags(_16icbuf, noutput_items);
+  // a looped waveform replaces the input, which gets dropped
+  if (!_wave.empty()) {
+    status = transmit_waveform(noutput_items);
   } else {
-    status = bladerf_sync_tx(_dev.get(), static_cast<void const *>(_16icbuf),
-                             noutput_items, NULL, _stream_timeout);
+    noutput_items = apply_tune_tags(noutput_items);
+    status = transmit_paced(input_items, noutput_items);
   }
 
   // handle failure
@@ -283,10 +293,211 @@ int bladerf_sink_c::work(int noutput_items,
   return noutput_items;
 }
 
+int bladerf_sink_c::transmit_input(gr_vector_const_void_star &input_items,
+                                   int noutput_items)
+{
+  size_t nstreams = num_streams(_layout);
+  gr_complex const *const *in = reinterpret_cast<gr_complex const *const *>(&input_items[0]);
+
+  // interleave, scale and saturate in one pass, noutput_items samples
+  // in total, straight from the input buffers
+  convert_fc32_s16_interleave(in, _16icbuf, nstreams, noutput_items / nstreams,
+                              SCALING_FACTOR);
+
+  // transmit the samples from the temp buffer
+  if (_start_pending) {
+    return transmit_timed_start(_16icbuf, noutput_items);
+  }
+
+  if (BLADERF_FORMAT_SC16_Q11_META == _format) {
+    return transmit_with_tags(_16icbuf, noutput_items);
+  }
+
+  return bladerf_sync_tx(_dev.get(), static_cast<void const *>(_16icbuf),
+                         noutput_items, NULL, _stream_timeout);
+}
+
+/* Retuning takes effect right away, the scheduled retunes of libbladerf
+ * only cover the frequency and need the timestamps of metadata mode. So
+ * the samples in front of a tx_freq or tx_gain tag are sent on their own,
+ * and the change is made once they went out. */
+int bladerf_sink_c::apply_tune_tags(int noutput_items)
+{
+  const uint64_t start = nitems_read(0);
+  std::vector<tx_tune_t> tunes(get_num_channels());
+  std::vector<gr::tag_t> tags;
+  bool tune = false;
+
+  for (size_t ch = 0; ch < get_num_channels(); ++ch) {
+    get_tags_in_range(tags, ch, start, start + noutput_items);
+    noutput_items = tx_tune_from_tags(tags, start, noutput_items, tunes[ch]);
+    tune |= !tunes[ch].empty();
+  }
+
+  /* whole frames of the interleaved channels */
+  int frame = static_cast<int>(get_num_channels());
+  noutput_items = std::max(frame, noutput_items - noutput_items % frame);
+
+  if (!tune) {
+    return noutput_items;
+  }
+
+  _pacer.drain();
+
+  for (size_t ch = 0; ch < get_num_channels(); ++ch) {
+    if (tunes[ch].has_freq) {
+      set_center_freq(tunes[ch].freq, ch);
+    }
+    if (tunes[ch].has_gain) {
+      set_gain(tunes[ch].gain, ch);
+    }
+  }
+
+  return noutput_items;
+}
+
+/* The samples of the prefill are held back and sent together, the
+ * underrun policy applies when the pacer finds the device ran dry */
+int bladerf_sink_c::transmit_paced(gr_vector_const_void_star &input_items,
+                                   int noutput_items)
+{
+  int status = 0;
+
+  if (_pacer.starved()) {
+    handle_underrun();
+  }
+
+  if (_pacer.prefill(input_items, noutput_items)) {
+    while (_pacer.held() > 0 && status == 0) {
+      int count = std::min(_pacer.held(), max_samples_per_buffer());
+      count -= count % get_num_channels();
+
+      gr_vector_const_void_star held = _pacer.held_items();
+      status = transmit_input(held, count);
+
+      _pacer.consume_held(count);
+      _pacer.written(count);
+      _last_count = count;
+    }
+
+    _stats.samples += noutput_items;
+    return status;
+  }
+
+  _pacer.throttle();
+
+  status = transmit_input(input_items, noutput_items);
+
+  _pacer.written(noutput_items);
+  _last_count = noutput_items;
+  _stats.samples += noutput_items;
+
+  return status;
+}
+
+/* _16icbuf still holds what went out last */
+void bladerf_sink_c::handle_underrun()
+{
+  int status = 0;
+
+  _stats.underruns++;
+  std::cerr << "U" << std::flush;
+
+  switch (_pacer.policy().underrun) {
+  case tx_policy_t::UNDERRUN_REPEAT:
+    if (_last_count > 0 && BLADERF_FORMAT_SC16_Q11 == _format) {
+      status = bladerf_sync_tx(_dev.get(), static_cast<void const *>(_16icbuf),
+                               _last_count, NULL, _stream_timeout);
+    }
+    break;
+
+  case tx_policy_t::UNDERRUN_STOP:
+    // the pacer prefills again, a burst with metadata ends here
+    if (BLADERF_FORMAT_SC16_Q11_META == _format && _in_burst) {
+      struct bladerf_metadata meta;
+      int16_t const zeros[8] = { 0 };
+
+      memset(&meta, 0, sizeof(meta));
+      meta.flags = BLADERF_META_FLAG_TX_BURST_END;
+
+      status = bladerf_sync_tx(_dev.get(), static_cast<void const *>(zeros),
+                               4, &meta, _stream_timeout);
+      _in_burst = false;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  if (status != 0) {
+    BLADERF_WARNING("bladerf_sync_tx error: " << bladerf_strerror(status));
+  }
+}
+
+/* the waveform is in device format already, it goes out as it is */
+int bladerf_sink_c::transmit_waveform(int noutput_items)
+{
+  size_t const len = _wave.size() / 2;
+  size_t left = noutput_items;
+
+  while (left > 0) {
+    size_t count = std::min(left, len - _wave_pos);
+
+    int status = bladerf_sync_tx(_dev.get(), &_wave[2 * _wave_pos], count,
+                                 NULL, _stream_timeout);
+    if (status != 0) {
+      return status;
+    }
+
+    left -= count;
+    _wave_pos = (_wave_pos + count) % len;
+  }
+
+  return 0;
+}
+
+/* The first samples after a start open a burst at the common start time.
+ * The timestamps count samples since the FPGA was loaded, the start is
+ * turned into one from the host time, so devices are only as close as
+ * the host can read their counters. The rest of the stream goes out
+ * within this burst. */
+int bladerf_sink_c::transmit_timed_start(int16_t const *samples,
+                                         int noutput_items)
+{
+  struct bladerf_metadata meta;
+  uint64_t now;
+
+  int status = bladerf_get_timestamp(_dev.get(), BLADERF_TX, &now);
+  if (status != 0) {
+    return status;
+  }
+
+  osmosdr::time_spec_t host = osmosdr::time_spec_t::get_system_time();
+  double lead = (_timed_start->get(host) - host).get_real_secs();
+
+  memset(&meta, 0, sizeof(meta));
+  meta.flags = BLADERF_META_FLAG_TX_BURST_START;
+  meta.timestamp = now + static_cast<uint64_t>(std::max(0.0, lead) * get_sample_rate());
+
+  BLADERF_DEBUG("starting burst at timestamp " << meta.timestamp);
+
+  status = bladerf_sync_tx(_dev.get(), static_cast<void const *>(samples),
+                           noutput_items, &meta, _stream_timeout);
+  if (status != 0) {
+    return status;
+  }
+
+  _start_pending = false;
+  _in_burst = true;
+
+  return 0;
+}
+
 int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
                                         int noutput_items)
 {
-  int status;
+  int status = 0;
   int count = 0;
 
   // For a long burst, we may be transmitting the burst contents over
@@ -296,7 +507,7 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
   int end_idx = (noutput_items - 1);
 
   struct bladerf_metadata meta;
-  std::vector<gr::tag_t> tags;
+  std::vector<gr::tag_t> &tags = _burst_tags;
 
   int const INVALID_IDX = -1;
   int16_t const zeros[8] = { 0 };
@@ -305,13 +516,19 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
 
   BLADERF_DEBUG("transmit_with_tags(" << noutput_items << ")");
 
-  // Important Note: We assume that these tags are ordered by their offsets.
-  // This is true for GNU Radio 3.7.7.x, since the GR runtime libs store
-  // these in a multimap.
-  //
-  // If you're using an earlier GNU Radio version, you may have to sort
-  // the tags vector.
-  get_tags_in_window(tags, 0, 0, noutput_items);
+  // Only the burst tags are looked up, the other tags of the stream
+  // (rx_time, tx_freq, ...) don't have to be copied out and compared.
+  // The two lookups are merged back into offset order.
+  static const pmt::pmt_t SOB_KEY = pmt::string_to_symbol("tx_sob");
+  static const pmt::pmt_t EOB_KEY = pmt::string_to_symbol("tx_eob");
+
+  get_tags_in_window(tags, 0, 0, noutput_items, SOB_KEY);
+  get_tags_in_window(_eob_tags, 0, 0, noutput_items, EOB_KEY);
+
+  if (!_eob_tags.empty()) {
+    tags.insert(tags.end(), _eob_tags.begin(), _eob_tags.end());
+    std::stable_sort(tags.begin(), tags.end(), gr::tag_t::offset_compare);
+  }
 
   if (tags.size() == 0) {
     if (_in_burst) {
@@ -325,11 +542,11 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
     }
   }
 
-  for (gr::tag_t tag : tags) {
+  for (const gr::tag_t &tag : tags) {
     // Upon seeing an SOB tag, update our offset. We'll TX the start of the
     // burst when we see an EOB or at the end of this function - whichever
     // occurs first.
-    if (pmt::symbol_to_string(tag.key) == "tx_sob") {
+    if (pmt::eq(tag.key, SOB_KEY)) {
       if (_in_burst) {
         BLADERF_WARNING("Got SOB while already within a burst");
 
@@ -343,7 +560,7 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
         _in_burst = true;
       }
 
-    } else if (pmt::symbol_to_string(tag.key) == "tx_eob") {
+    } else if (pmt::eq(tag.key, EOB_KEY)) {
       if (!_in_burst) {
         BLADERF_WARNING("Got EOB while not in burst");
         return BLADERF_ERR_INVAL;
@@ -417,7 +634,15 @@ osmosdr::meta_range_t bladerf_sink_c::get_sample_rates()
 
 double bladerf_sink_c::set_sample_rate(double rate)
 {
-  return bladerf_common::set_sample_rate(rate, chan2channel(BLADERF_TX, 0));
+  double actual;
+
+  actual = bladerf_common::set_sample_rate(rate, chan2channel(BLADERF_TX, 0));
+
+  // applied by work() between two transfers, so the caller doesn't have
+  // to wait for a pending one to complete
+  _rate_changed = true;
+
+  return actual;
 }
 
 double bladerf_sink_c::get_sample_rate()
@@ -584,6 +809,53 @@ std::string bladerf_sink_c::get_clock_source(size_t mboard)
   return bladerf_common::get_clock_source(mboard);
 }
 
+bool bladerf_sink_c::set_waveform(const std::vector<gr_complex> &samples,
+                                  size_t chan)
+{
+  if (BLADERF_FORMAT_SC16_Q11_META == _format && !samples.empty()) {
+    throw std::runtime_error("bladeRF: a waveform can't be looped with "
+                             "enable_metadata or a timed start");
+  }
+
+  if (chan >= get_num_channels()) {
+    return false;
+  }
+
+  gr::thread::scoped_lock guard(d_mutex);
+
+  _wave_chans.resize(get_num_channels());
+  _wave_chans[chan] = samples;
+
+  // the channels are interleaved, they have to loop at the same length
+  size_t len = 0;
+  for (std::vector<gr_complex> const &w : _wave_chans) {
+    if (!w.empty() && len && w.size() != len) {
+      _wave_chans[chan].clear();
+      throw std::runtime_error("bladeRF: the waveforms of all channels must "
+                               "have the same length");
+    }
+    len = std::max(len, w.size());
+  }
+
+  size_t nstreams = num_streams(_layout);
+  std::vector<gr_complex> intl(len * nstreams);
+
+  for (size_t n = 0; n < _wave_chans.size() && len; ++n) {
+    for (size_t i = 0; i < _wave_chans[n].size(); ++i) {
+      intl[i * nstreams + n] = _wave_chans[n][i];
+    }
+  }
+
+  _wave.resize(2 * intl.size());
+  if (!intl.empty()) {
+    volk_32f_s32f_convert_16i(&_wave[0], reinterpret_cast<float const *>(&intl[0]),
+                              SCALING_FACTOR, 2 * intl.size());
+  }
+  _wave_pos = 0;
+
+  return true;
+}
+
 void bladerf_sink_c::set_biastee_mode(const std::string &mode)
 {
   int status;
@@ -603,3 +875,31 @@ void bladerf_sink_c::set_biastee_mode(const std::string &mode)
     BLADERF_THROW_STATUS(status, "Failed to set bias-tee");
   }
 }
+
+bool bladerf_sink_c::set_timed_start(const timed_start_sptr &start)
+{
+  gr::thread::scoped_lock guard(d_mutex);
+
+  if (!_wave.empty()) {
+    throw std::runtime_error("bladeRF: a looped waveform can't be started "
+                             "at a given time");
+  }
+
+  // the start time goes with the metadata of the first samples
+  _format = BLADERF_FORMAT_SC16_Q11_META;
+  _timed_start = start;
+
+  return true;
+}
+
+osmosdr::stream_stats_t bladerf_sink_c::get_stream_stats(size_t chan)
+{
+  gr::thread::scoped_lock guard(d_mutex);
+
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _pacer.queued();
+  stats.capacity = _pacer.policy().latency_samples(get_sample_rate());
+
+  return stats;
+}
@@ -21,9 +21,14 @@
 #ifndef INCLUDED_BLADERF_SINK_C_H
 #define INCLUDED_BLADERF_SINK_C_H
 
+#include <atomic>
+#include <vector>
+
 #include <gnuradio/sync_block.h>
 #include "sink_iface.h"
 #include "bladerf_common.h"
+#include "tx_policy.h"
+#include "tx_tune.h"
 
 #include "osmosdr/ranges.h"
 
@@ -119,18 +124,45 @@ public:
 
   void set_biastee_mode(const std::string &mode);
 
+  bool set_waveform(const std::vector<gr_complex> &samples, size_t chan = 0);
+
+  bool set_timed_start(const timed_start_sptr &start);
+
+  osmosdr::stream_stats_t get_stream_stats(size_t chan = 0);
+
 private:
   int transmit_with_tags(int16_t const *samples, int noutput_items);
+  int transmit_timed_start(int16_t const *samples, int noutput_items);
+  int transmit_input(gr_vector_const_void_star &input_items,
+                     int noutput_items);
+  int transmit_waveform(int noutput_items);
+  int apply_tune_tags(int noutput_items);
+  int transmit_paced(gr_vector_const_void_star &input_items,
+                     int noutput_items);
+  void handle_underrun();
 
   // Sample-handling buffers
   int16_t *_16icbuf;              /**< raw samples to bladeRF */
-  gr_complex *_32fcbuf;           /**< intermediate buffer for conversions */
 
   bool _in_burst;                 /**< are we currently in a burst? */
+  std::vector<gr::tag_t> _burst_tags; /**< tx_sob and tx_eob of this call */
+  std::vector<gr::tag_t> _eob_tags;   /**< tx_eob lookup, merged into it */
+  timed_start_sptr _timed_start;  /**< common start of the sink, if any */
+  bool _start_pending;            /**< next samples are the first after start() */
   bool _running;                  /**< is the sink running? */
   bladerf_channel_layout _layout; /**< channel layout */
 
   gr::thread::mutex d_mutex;      /**< mutex to protect set/work access */
+  std::atomic<bool> _rate_changed; /**< work() has to apply a new rate */
+
+  tx_pacer _pacer;                /**< prefill and underrun detection */
+  int _last_count;                /**< samples of _16icbuf sent last */
+  osmosdr::stream_stats_t _stats; /**< stream statistics */
+
+  /* Looped instead of the input, converted and interleaved once */
+  std::vector<std::vector<gr_complex>> _wave_chans; /**< per channel */
+  std::vector<int16_t> _wave;     /**< interleaved SC16 Q11 samples */
+  size_t _wave_pos;               /**< next sample of _wave to send */
 
   /* Scaling factor used when converting from float to int16_t */
   const float SCALING_FACTOR = 2048.0f;
@@ -28,6 +28,7 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
 #include <iostream>
 
 #include <boost/assign.hpp>
@@ -41,9 +42,15 @@
 #include "arg_helpers.h"
 #include "bladerf_source_c.h"
 #include "osmosdr/source.h"
+#include "sample_convert.h"
+#include "stream_tagger.h"
+#include "tick_time.h"
 
 using namespace boost::assign;
 
+/* buffers of libbladeRF one work() call takes at most, with fixed buffers */
+static size_t const BUFFERS_PER_CALL = 4;
+
 /******************************************************************************
  * Functions
  ******************************************************************************/
@@ -69,9 +76,16 @@ bladerf_source_c::bladerf_source_c(const std::string &args) :
                   gr::io_signature::make(0, 0, 0),
                   args_to_io_signature(args)),
   _16icbuf(NULL),
-  _32fcbuf(NULL),
+  _max_items(0),
   _running(false),
-  _agcmode(BLADERF_GAIN_DEFAULT)
+  _agcmode(BLADERF_GAIN_DEFAULT),
+  _rate_changed(false),
+  _rate_ts(0),
+  _flush_ts(0),
+  _flush_left(0),
+  _tag_rate(false),
+  _have_ts(false),
+  _next_ts(0)
 {
   int status;
 
@@ -80,6 +94,17 @@ bladerf_source_c::bladerf_source_c(const std::string &args) :
   /* Perform src/sink agnostic initializations */
   init(dict, BLADERF_RX);
 
+  /* Both RX channels of the bladeRF 2.0 are mixed by the single RX LO of
+   * the AD9361 and there is no per channel NCO, so one can't be retuned
+   * while the other keeps capturing */
+  if (dict.count("sweep")) {
+    throw std::runtime_error("bladeRF: sweep= needs independently tuned RX "
+                             "channels, which the bladeRF doesn't have");
+  }
+
+  /* Spread the conversion over several cores at the highest rates */
+  _convert.set_threads(convert_pool::threads_from_dict(dict));
+
   /* Handle setting of sampling mode */
   if (dict.count("sampling")) {
     bladerf_sampling sampling = BLADERF_SAMPLING_UNKNOWN;
@@ -172,8 +197,18 @@ bladerf_source_c::bladerf_source_c(const std::string &args) :
   /* Set up constraints */
   int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
   set_alignment(std::max(1,alignment_multiple));
-  set_max_noutput_items(_samples_per_buffer);
-  set_output_multiple(get_num_channels());
+  /* with fixed buffers work() reads whole ones, a few at a time, and the
+   * output buffer takes that. latency_ms resizes them with the rate, so
+   * it stays at one buffer of the largest size per call. */
+  if (_latency_ms > 0) {
+    _max_items = max_samples_per_buffer();
+    set_output_multiple(get_num_channels());
+  } else {
+    _max_items = BUFFERS_PER_CALL * _samples_per_buffer;
+    set_output_multiple(_samples_per_buffer);
+    set_min_output_buffer(2 * _max_items);
+  }
+  set_max_noutput_items(_max_items);
 
   /* Set channel layout */
   _layout = (get_num_channels() > 1) ? BLADERF_RX_X2 : BLADERF_RX_X1;
@@ -184,6 +219,12 @@ bladerf_source_c::bladerf_source_c(const std::string &args) :
     _chanmap[BLADERF_CHANNEL_RX(ch)] = ch;
   }
 
+  /* Measure the ADC level of every channel while converting */
+  double level_period = level_meter::period_from_dict(dict);
+  if (level_period > 0) {
+    _level.attach(this, level_period, get_num_channels());
+  }
+
   BLADERF_DEBUG("initialization complete");
 }
 
@@ -230,6 +271,9 @@ bool bladerf_source_c::start()
 
   gr::thread::scoped_lock guard(d_mutex);
 
+  size_buffers(get_sample_rate() * get_num_channels());
+  _level.set_sample_rate(get_sample_rate());
+
   status = bladerf_sync_config(_dev.get(), _layout, _format, _num_buffers,
                                _samples_per_buffer, _num_transfers,
                                _stream_timeout);
@@ -246,11 +290,13 @@ bool bladerf_source_c::start()
   }
 
   /* Allocate memory for conversions in work() */
-  size_t alignment = volk_get_alignment();
-
-  _16icbuf = reinterpret_cast<int16_t *>(volk_malloc(2*_samples_per_buffer*sizeof(int16_t), alignment));
-  _32fcbuf = reinterpret_cast<gr_complex *>(volk_malloc(_samples_per_buffer*sizeof(gr_complex), alignment));
+  _16icbuf = reinterpret_cast<int16_t *>(buffer_acquire(2*_max_items*sizeof(int16_t), _buf_opts));
 
+  _have_ts = false;
+  _rate_changed = false;
+  _flush_ts = 0;
+  _flush_left = 0;
+  _tag_rate = false;
   _running = true;
 
   return true;
@@ -282,10 +328,8 @@ bool bladerf_source_c::stop()
   }
 
   /* Deallocate conversion memory */
-  volk_free(_16icbuf);
-  volk_free(_32fcbuf);
+  buffer_release(_16icbuf);
   _16icbuf = NULL;
-  _32fcbuf = NULL;
 
   return true;
 }
@@ -306,6 +350,24 @@ int bladerf_source_c::work(int noutput_items,
     return 0;
   }
 
+  if (_rate_changed.exchange(false)) {
+    // the rx_time tags have to be re-anchored
+    _have_ts = false;
+
+    if (size_buffers(get_sample_rate() * get_num_channels())) {
+      restart_stream(BLADERF_RX, _layout);
+    } else if (BLADERF_FORMAT_SC16_Q11_META == _format) {
+      // the buffers libbladeRF filled before are at the old rate, skipped
+      // by their timestamps without reconfiguring the stream
+      _flush_ts = _rate_ts;
+    } else {
+      // without timestamps all it may hold is skipped
+      _flush_left = _num_buffers * _samples_per_buffer / nstreams;
+    }
+
+    _tag_rate = BLADERF_FORMAT_SC16_Q11_META != _format;
+  }
+
   // set up metadata
   if (BLADERF_FORMAT_SC16_Q11_META == _format) {
     memset(&meta, 0, sizeof(meta));
@@ -327,33 +389,197 @@ int bladerf_source_c::work(int noutput_items,
     }
   } else {
     _failures = 0;
+
+    // on overrun libbladeRF returns what it got before the gap
+    if (meta_ptr && meta.actual_count < (unsigned int)noutput_items) {
+      noutput_items = meta.actual_count - meta.actual_count % nstreams;
+    }
   }
 
-  // convert from int16_t to float
-  // output_items is gr_complex (2x float), so num_points is 2*noutput_items
-  volk_16i_s32f_convert_32f(reinterpret_cast<float *>(_32fcbuf), _16icbuf,
-                            SCALING_FACTOR, 2*noutput_items);
+  // what is left from before a rate change
+  size_t skip = 0;
+  if (meta_ptr && status == 0 && _flush_ts > meta.timestamp) {
+    skip = std::min<uint64_t>(_flush_ts - meta.timestamp, noutput_items/nstreams);
+  } else if (!meta_ptr && _flush_left) {
+    skip = std::min<size_t>(_flush_left, noutput_items/nstreams);
+    _flush_left -= skip;
+  }
 
-  // copy the samples into output_items
-  gr_complex **out = reinterpret_cast<gr_complex **>(&output_items[0]);
+  if (skip) {
+    noutput_items -= skip * nstreams;
+    if (meta_ptr) {
+      meta.timestamp += skip;
+    }
+    if (!noutput_items) {
+      return 0;
+    }
+  }
 
-  if (nstreams > 1) {
-    // we need to deinterleave the multiplex as we copy
-    gr_complex const *deint_in = _32fcbuf;
+  // convert from int16_t to float straight into output_items
+  gr_complex **out = reinterpret_cast<gr_complex **>(&output_items[0]);
 
-    for (size_t i = 0; i < (noutput_items/nstreams); ++i) {
-      for (size_t n = 0; n < nstreams; ++n) {
-        memcpy(out[n]++, deint_in++, sizeof(gr_complex));
+  // each chunk is a range of samples of every channel
+  _convert.run(noutput_items/nstreams, [&](size_t begin, size_t end) {
+    const int16_t *in = _16icbuf + 2 * nstreams * (skip + begin);
+
+    // with level= the chunk measures as it converts
+    std::vector<convert_level_t> level(_level.enabled() ? nstreams : 0);
+
+    if (nstreams > 1) {
+      // we need to deinterleave the multiplex as we convert
+      std::vector<gr_complex *> chunk_out(nstreams);
+      for (size_t i = 0; i < nstreams; ++i)
+        chunk_out[i] = out[i] + begin;
+
+      if (level.size()) {
+        convert_s16_fc32_deinterleave_level(in, &chunk_out[0], nstreams,
+                                            end - begin, 1.0f/SCALING_FACTOR,
+                                            CLIP_LEVEL, &level[0]);
+      } else {
+        convert_s16_fc32_deinterleave(in, &chunk_out[0], nstreams,
+                                      end - begin, 1.0f/SCALING_FACTOR);
       }
+    } else if (level.size()) {
+      convert_s16_fc32_level(in, out[0] + begin, end - begin,
+                             1.0f/SCALING_FACTOR, CLIP_LEVEL, &level[0]);
+    } else {
+      convert_s16_fc32(in, out[0] + begin, end - begin, 1.0f/SCALING_FACTOR);
     }
-  } else {
-    // no deinterleaving to do: simply copy everything
-    memcpy(out[0], _32fcbuf, sizeof(gr_complex) * noutput_items);
+
+    for (size_t i = 0; i < level.size(); ++i)
+      _level.add(i, level[i]);
+  });
+
+  if (meta_ptr && status == 0) {
+    tag_timestamp(meta.timestamp, noutput_items/nstreams);
+    tag_hops(meta.timestamp, noutput_items/nstreams);
   }
 
+  if (_tag_rate) {
+    for (size_t n = 0; n < nstreams; ++n) {
+      add_item_tag(n, nitems_written(n), stream_tagger::RATE_KEY(),
+                   pmt::from_double(get_sample_rate()), alias_pmt());
+    }
+    _tag_rate = false;
+  }
+
+  _stats.samples += noutput_items/nstreams;
+
   return noutput_items/(get_num_channels());
 }
 
+/* The timestamp counts samples since the FPGA was loaded. It is turned
+ * into rx_time at stream start and whenever it does not continue where
+ * the last read ended, which means samples got lost. */
+void bladerf_source_c::tag_timestamp(uint64_t timestamp, size_t nitems)
+{
+  bool gap = _have_ts && timestamp != _next_ts;
+
+  if (gap) {
+    ++_stats.overruns;
+    if (timestamp > _next_ts) {
+      _stats.dropped += timestamp - _next_ts;
+    }
+    std::cerr << "O" << std::flush;
+  }
+
+  if (gap || !_have_ts) {
+    double rate = get_sample_rate();
+    pmt::pmt_t time = tick_time_t(timestamp, rate).to_rx_time();
+
+    for (size_t n = 0; n < num_streams(_layout); ++n) {
+      add_item_tag(n, nitems_written(n), stream_tagger::TIME_KEY(), time, alias_pmt());
+      add_item_tag(n, nitems_written(n), stream_tagger::RATE_KEY(),
+                   pmt::from_double(rate), alias_pmt());
+      add_item_tag(n, nitems_written(n), stream_tagger::FREQ_KEY(),
+                   pmt::from_double(get_center_freq(n)), alias_pmt());
+    }
+  }
+
+  _have_ts = true;
+  _next_ts = timestamp + nitems;
+}
+
+/* rx_freq at the first sample of every scheduled hop in this read */
+void bladerf_source_c::tag_hops(uint64_t timestamp, size_t nitems)
+{
+  std::lock_guard<std::mutex> lock(_hop_mutex);
+
+  while (!_hop_tags.empty() && _hop_tags.front().timestamp < timestamp + nitems) {
+    const hop_tag_t &hop = _hop_tags.front();
+    uint64_t offset = hop.timestamp > timestamp ? hop.timestamp - timestamp : 0;
+
+    if (hop.chan < num_streams(_layout)) {
+      add_item_tag(hop.chan, nitems_written(hop.chan) + offset,
+                   stream_tagger::FREQ_KEY(), pmt::from_double(hop.freq),
+                   alias_pmt());
+    }
+
+    _hop_tags.pop_front();
+  }
+}
+
+osmosdr::stream_stats_t bladerf_source_c::get_stream_stats(size_t chan)
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  _level.get_stats(chan, stats);
+
+  return stats;
+}
+
+size_t bladerf_source_c::set_hop_freqs(const std::vector<double> &freqs,
+                                       size_t chan)
+{
+  return bladerf_common::set_hop_freqs(freqs, chan2channel(BLADERF_RX, chan));
+}
+
+/* the device time is the sample counter, as in the rx_time tags */
+double bladerf_source_c::hop_center_freq(size_t index,
+                                         const osmosdr::time_spec_t &time,
+                                         size_t chan)
+{
+  uint64_t timestamp = BLADERF_RETUNE_NOW;
+
+  if (time.get_real_secs() > 0) {
+    timestamp = static_cast<uint64_t>(time.get_real_secs() * get_sample_rate() + 0.5);
+  }
+
+  double freq = bladerf_common::hop_center_freq(index, timestamp,
+                                                chan2channel(BLADERF_RX, chan));
+
+  if (timestamp != BLADERF_RETUNE_NOW) {
+    hop_tag_t hop = { timestamp, chan, freq };
+
+    std::lock_guard<std::mutex> lock(_hop_mutex);
+    auto pos = std::upper_bound(_hop_tags.begin(), _hop_tags.end(), hop,
+                                [](const hop_tag_t &a, const hop_tag_t &b) {
+                                  return a.timestamp < b.timestamp;
+                                });
+    _hop_tags.insert(pos, hop);
+  }
+
+  return freq;
+}
+
+/* scheduling ahead needs the timestamps of the metadata format */
+bool bladerf_source_c::has_timed_hops(size_t chan)
+{
+  return BLADERF_FORMAT_SC16_Q11_META == _format;
+}
+
+/* the sample counter, the clock of the rx_time tags and the hops */
+osmosdr::time_spec_t bladerf_source_c::get_time_now(size_t mboard)
+{
+  uint64_t timestamp;
+  int status = bladerf_get_timestamp(_dev.get(), BLADERF_RX, &timestamp);
+  if (status != 0) {
+    BLADERF_THROW_STATUS(status, "bladerf_get_timestamp failed");
+  }
+
+  return osmosdr::time_spec_t::from_ticks((long long)timestamp, get_sample_rate());
+}
+
 osmosdr::meta_range_t bladerf_source_c::get_sample_rates()
 {
   return sample_rates(chan2channel(BLADERF_RX, 0));
@@ -361,7 +587,23 @@ osmosdr::meta_range_t bladerf_source_c::get_sample_rates()
 
 double bladerf_source_c::set_sample_rate(double rate)
 {
-  return bladerf_common::set_sample_rate(rate, chan2channel(BLADERF_RX, 0));
+  double actual;
+  uint64_t timestamp;
+
+  actual = bladerf_common::set_sample_rate(rate, chan2channel(BLADERF_RX, 0));
+
+  // the first sample at the new rate, what came before is flushed
+  if (_running && BLADERF_FORMAT_SC16_Q11_META == _format &&
+      bladerf_get_timestamp(_dev.get(), BLADERF_RX, &timestamp) == 0) {
+    _rate_ts = timestamp;
+  }
+
+  // applied by work() between two transfers, so the caller doesn't have
+  // to wait for a pending one to complete
+  _rate_changed = true;
+  _level.set_sample_rate(actual);
+
+  return actual;
 }
 
 double bladerf_source_c::get_sample_rate()
@@ -21,9 +21,15 @@
 #ifndef INCLUDED_BLADERF_SOURCE_C_H
 #define INCLUDED_BLADERF_SOURCE_C_H
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+
 #include <gnuradio/sync_block.h>
 #include "source_iface.h"
 #include "bladerf_common.h"
+#include "convert_pool.h"
+#include "level_meter.h"
 
 #include "osmosdr/ranges.h"
 
@@ -108,9 +114,11 @@ public:
 
   void set_dc_offset_mode(int mode, size_t chan = 0);
   void set_dc_offset(const std::complex<double> &offset, size_t chan = 0);
+  bool has_dc_offset_correction(size_t chan = 0) { return true; }
 
   void set_iq_balance_mode(int mode, size_t chan = 0);
   void set_iq_balance(const std::complex<double> &balance, size_t chan = 0);
+  bool has_iq_balance_correction(size_t chan = 0) { return true; }
 
   osmosdr::freq_range_t get_bandwidth_range(size_t chan = 0);
   double set_bandwidth(double bandwidth, size_t chan = 0);
@@ -126,19 +134,54 @@ public:
   void set_rx_mux_mode(const std::string &rxmux);
   void set_agc_mode(const std::string &agcmode);
 
+  osmosdr::stream_stats_t get_stream_stats(size_t chan = 0);
+
+  size_t set_hop_freqs(const std::vector<double> &freqs, size_t chan = 0);
+  double hop_center_freq(size_t index, const osmosdr::time_spec_t &time,
+                         size_t chan = 0);
+  bool has_timed_hops(size_t chan = 0);
+
+  osmosdr::time_spec_t get_time_now(size_t mboard = 0);
+
 private:
+  void tag_timestamp(uint64_t timestamp, size_t nitems);
+  void tag_hops(uint64_t timestamp, size_t nitems);
+
   // Sample-handling buffers
   int16_t *_16icbuf;              /**< raw samples from bladeRF */
-  gr_complex *_32fcbuf;           /**< intermediate buffer to gnuradio */
+  size_t _max_items;              /**< most samples per work(), _16icbuf size */
+  convert_pool _convert;          /**< threads converting _16icbuf */
 
   bool _running;                  /**< is the source running? */
   bladerf_channel_layout _layout; /**< channel layout */
   bladerf_gain_mode _agcmode;     /**< gain mode when AGC is enabled */
 
   gr::thread::mutex d_mutex;      /**< mutex to protect set/work access */
+  std::atomic<bool> _rate_changed; /**< work() has to apply a new rate */
+  std::atomic<uint64_t> _rate_ts; /**< timestamp when the rate changed */
+  uint64_t _flush_ts;             /**< reads before it are at the old rate */
+  size_t _flush_left;             /**< same without timestamps, in samples */
+  bool _tag_rate;                 /**< rx_rate at the next sample without timestamps */
+
+  osmosdr::stream_stats_t _stats; /**< stream statistics */
+  level_meter _level;             /**< level= measured while converting */
+  bool _have_ts;                  /**< _next_ts is valid */
+  uint64_t _next_ts;              /**< expected timestamp of the next read */
+
+  /* Scheduled hops, tagged with rx_freq once their sample is read */
+  struct hop_tag_t {
+    uint64_t timestamp;
+    size_t chan;
+    double freq;
+  };
+  std::mutex _hop_mutex;
+  std::deque<hop_tag_t> _hop_tags; /**< ordered by timestamp */
 
   /* Scaling factor used when converting from int16_t to float */
   const float SCALING_FACTOR = 2048.0f;
+
+  /* Full scale of the 12 bit ADC in the SC16Q11 samples */
+  const int16_t CLIP_LEVEL = 2047;
 };
 
 #endif // INCLUDED_BLADERF_SOURCE_C_H
@@ -0,0 +1,254 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "buffer_pool.h"
+
+#define HUGE_PAGE_SIZE (2 << 20)
+#define POOL_MAX_FREE (256 << 20)   // bytes kept for reuse at most
+#define MPOL_PREFERRED 1
+
+namespace {
+
+struct block_t
+{
+  size_t bytes;
+  buffer_opts_t opts;
+};
+
+struct pool_t
+{
+  pool_t() : free_bytes(0), warned_huge(false), warned_lock(false), warned_node(false) {}
+
+  std::mutex lock;
+  std::map< void *, block_t > used;
+  std::multimap< size_t, std::pair< void *, buffer_opts_t > > free;
+  size_t free_bytes;
+
+  bool warned_huge;
+  bool warned_lock;
+  bool warned_node;
+};
+
+/* never destroyed, rings in static objects may give their buffers back
+ * after it would have been */
+pool_t &pool()
+{
+  static pool_t *p = new pool_t;
+  return *p;
+}
+
+size_t page_size()
+{
+#ifdef _WIN32
+  return 4096;
+#else
+  static const size_t size = sysconf( _SC_PAGESIZE );
+  return size;
+#endif
+}
+
+size_t round_up( size_t bytes, size_t align )
+{
+  return (bytes + align - 1) / align * align;
+}
+
+#ifdef _WIN32
+
+void *map_block( pool_t &, size_t bytes, const buffer_opts_t & )
+{
+  void *buf = _aligned_malloc( bytes, page_size() );
+  if ( ! buf )
+    throw std::bad_alloc();
+
+  return buf;
+}
+
+void unmap_block( void *buf, const block_t & )
+{
+  _aligned_free( buf );
+}
+
+#else
+
+/* pages are placed when first touched, so the policy is set before */
+void bind_block( pool_t &p, void *buf, size_t bytes, int node )
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  const size_t bits = sizeof(unsigned long) * CHAR_BIT;
+  std::vector< unsigned long > mask( node / bits + 1 );
+  mask[ node / bits ] |= 1UL << (node % bits);
+
+  if ( 0 == syscall( SYS_mbind, buf, bytes, MPOL_PREFERRED,
+                     &mask[0], mask.size() * bits + 1, 0 ) )
+    return;
+#else
+  (void)buf; (void)bytes; (void)node;
+#endif
+
+  if ( ! p.warned_node )
+    std::cerr << "Could not bind the stream buffers to NUMA node " << node
+              << "." << std::endl;
+  p.warned_node = true;
+}
+
+void *map_block( pool_t &p, size_t bytes, const buffer_opts_t &opts )
+{
+  void *buf = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if ( opts.huge )
+    buf = mmap( NULL, bytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+#endif
+
+  if ( MAP_FAILED == buf )
+  {
+    buf = mmap( NULL, bytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( MAP_FAILED == buf )
+      throw std::bad_alloc();
+
+    bool huge = false;
+#ifdef MADV_HUGEPAGE
+    if ( opts.huge )
+      huge = ( 0 == madvise( buf, bytes, MADV_HUGEPAGE ) );
+#endif
+    if ( opts.huge && ! huge && ! p.warned_huge )
+    {
+      std::cerr << "Huge pages are not available for the stream buffers."
+                << std::endl;
+      p.warned_huge = true;
+    }
+  }
+
+  if ( opts.node >= 0 )
+    bind_block( p, buf, bytes, opts.node );
+
+  if ( opts.lock && mlock( buf, bytes ) && ! p.warned_lock )
+  {
+    std::cerr << "Could not lock the stream buffers into memory, "
+              << "check RLIMIT_MEMLOCK (ulimit -l)." << std::endl;
+    p.warned_lock = true;
+  }
+
+  return buf;
+}
+
+void unmap_block( void *buf, const block_t &block )
+{
+  munmap( buf, block.bytes );
+}
+
+#endif
+
+} // namespace
+
+buffer_opts_t buffer_opts_from_dict( const dict_t &dict )
+{
+  buffer_opts_t opts;
+
+  if ( dict.count("buf_huge") )
+    opts.huge = boost::lexical_cast< bool >( dict.at("buf_huge") );
+
+  if ( dict.count("buf_lock") )
+    opts.lock = boost::lexical_cast< bool >( dict.at("buf_lock") );
+
+  if ( dict.count("buf_node") )
+    opts.node = boost::lexical_cast< int >( dict.at("buf_node") );
+
+  return opts;
+}
+
+void *buffer_acquire( size_t bytes, const buffer_opts_t &opts )
+{
+  pool_t &p = pool();
+
+  block_t block;
+  block.bytes = round_up( std::max( bytes, size_t(1) ),
+                          opts.huge ? HUGE_PAGE_SIZE : page_size() );
+  block.opts = opts;
+
+  std::lock_guard< std::mutex > lock( p.lock );
+
+  auto range = p.free.equal_range( block.bytes );
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if ( it->second.second != opts )
+      continue;
+
+    void *buf = it->second.first;
+    p.free.erase( it );
+    p.free_bytes -= block.bytes;
+    p.used[ buf ] = block;
+    return buf;
+  }
+
+  void *buf = map_block( p, block.bytes, opts );
+  p.used[ buf ] = block;
+  return buf;
+}
+
+void buffer_release( void *buf )
+{
+  if ( ! buf )
+    return;
+
+  pool_t &p = pool();
+  std::lock_guard< std::mutex > lock( p.lock );
+
+  auto it = p.used.find( buf );
+  if ( it == p.used.end() )
+    return;
+
+  const block_t block = it->second;
+  p.used.erase( it );
+
+  if ( p.free_bytes + block.bytes > POOL_MAX_FREE )
+  {
+    unmap_block( buf, block );
+    return;
+  }
+
+  p.free.insert( std::make_pair( block.bytes, std::make_pair( buf, block.opts ) ) );
+  p.free_bytes += block.bytes;
+}
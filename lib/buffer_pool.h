@@ -0,0 +1,65 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_BUFFER_POOL_H
+#define OSMOSDR_BUFFER_POOL_H
+
+#include <cstddef>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * How the streaming buffers of a device are allocated, taken from the
+ * buf_huge=, buf_lock= and buf_node= device arguments.
+ */
+struct buffer_opts_t
+{
+  buffer_opts_t() : huge(false), lock(false), node(-1) {}
+
+  bool huge;    // back with huge pages, transparent ones if none are reserved
+  bool lock;    // mlock() the pages, so they are never paged out
+  int node;     // NUMA node to take the pages from, -1 for the local one
+
+  bool operator ==( const buffer_opts_t &other ) const
+  {
+    return huge == other.huge && lock == other.lock && node == other.node;
+  }
+
+  bool operator !=( const buffer_opts_t &other ) const { return !(*this == other); }
+};
+
+OSMOSDR_API buffer_opts_t buffer_opts_from_dict( const dict_t &dict );
+
+/*!
+ * Page aligned buffer of at least \p bytes. Released buffers are kept in
+ * a pool and handed out again for the same size and options, so a block
+ * which is stopped and started or re-created does not get new pages.
+ *
+ * Buffers are not cleared. Options which can't be honored are reported
+ * once and ignored, allocation failures throw std::bad_alloc.
+ */
+OSMOSDR_API void *buffer_acquire( size_t bytes, const buffer_opts_t &opts = buffer_opts_t() );
+
+/*! give a buffer from buffer_acquire() back to the pool, NULL is ignored */
+OSMOSDR_API void buffer_release( void *buf );
+
+#endif // OSMOSDR_BUFFER_POOL_H
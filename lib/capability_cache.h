@@ -0,0 +1,124 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CAPABILITY_CACHE_H
+#define OSMOSDR_CAPABILITY_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <osmosdr/ranges.h>
+
+/*! a value taken from the device the first time it is asked for */
+template< typename T >
+class cached_value
+{
+public:
+  cached_value() : _valid(false) {}
+
+  template< typename F >
+  const T &get( F fetch )
+  {
+    if ( ! _valid ) {
+      _value = fetch();
+      _valid = true;
+    }
+
+    return _value;
+  }
+
+private:
+  T _value;
+  bool _valid;
+};
+
+/*!
+ * What a device can do, per channel of the block, as it was when first
+ * asked for. GRC callbacks ask again and again, and with remote devices
+ * every question is a round trip to them.
+ *
+ * The ranges and lists may change with the antenna and the sample rate,
+ * forget() is called when those change. A fetch happens with the cache
+ * locked, so the device isn't asked twice for the same thing.
+ */
+class capability_cache
+{
+public:
+  struct entry_t
+  {
+    cached_value< osmosdr::freq_range_t > freq_range;
+    cached_value< std::vector< std::string > > gain_names;
+    cached_value< osmosdr::gain_range_t > gain_range;
+    std::map< std::string, cached_value< osmosdr::gain_range_t > > named_gain_range;
+    cached_value< std::vector< std::string > > antennas;
+    cached_value< osmosdr::freq_range_t > bandwidth_range;
+    cached_value< osmosdr::meta_range_t > sample_rates;   // of the device of the channel
+  };
+
+  void resize( size_t nchan )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _chans.resize( nchan );
+  }
+
+  /*! \p field of channel \p chan, from \p fetch while it isn't cached */
+  template< typename T, typename F >
+  T get( size_t chan, cached_value< T > entry_t::*field, F fetch )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    return ( _chans[ chan ].*field ).get( fetch );
+  }
+
+  template< typename F >
+  osmosdr::gain_range_t gain_range( size_t chan, const std::string &name, F fetch )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    return _chans[ chan ].named_gain_range[ name ].get( fetch );
+  }
+
+  /* the sample rates of the group, the devices not given a rate of their own */
+  template< typename F >
+  osmosdr::meta_range_t sample_rates( F fetch )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    return _sample_rates.get( fetch );
+  }
+
+  void forget( size_t chan )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _chans[ chan ] = entry_t();
+  }
+
+  void forget_all()
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    _chans.assign( _chans.size(), entry_t() );
+    _sample_rates = cached_value< osmosdr::meta_range_t >();
+  }
+
+private:
+  std::mutex _mutex;
+  std::vector< entry_t > _chans;
+  cached_value< osmosdr::meta_range_t > _sample_rates;
+};
+
+#endif // OSMOSDR_CAPABILITY_CACHE_H
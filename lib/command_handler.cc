@@ -0,0 +1,169 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "command_handler.h"
+
+command_handler_sptr make_command_handler(
+    const std::function< void( const pmt::pmt_t &cmd ) > &apply,
+    const std::function< ::osmosdr::time_spec_t() > &time_now )
+{
+  return gnuradio::get_initial_sptr(new command_handler( apply, time_now ));
+}
+
+command_handler::command_handler(
+    const std::function< void( const pmt::pmt_t &cmd ) > &apply,
+    const std::function< ::osmosdr::time_spec_t() > &time_now )
+  : gr::block ("command_handler",
+        gr::io_signature::make(0, 0, 0),
+        gr::io_signature::make(0, 0, 0)),
+    _apply(apply),
+    _time_now(time_now),
+    _running(false)
+{
+  message_port_register_in( pmt::mp("command") );
+  set_msg_handler( pmt::mp("command"),
+                   [this]( pmt::pmt_t msg ) { this->post( msg ); } );
+}
+
+command_handler::~command_handler()
+{
+  stop();
+}
+
+bool command_handler::start()
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( _running )
+    return true;
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &command_handler::control_task, this ) );
+
+  return true;
+}
+
+bool command_handler::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    _running = false;
+  }
+
+  _cond.notify_one();
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+/* runs on the thread delivering the messages, must not block */
+void command_handler::post( pmt::pmt_t msg )
+{
+  /* a single key/value pair, as gr-uhd takes it too */
+  if ( ! pmt::is_dict( msg ) && pmt::is_pair( msg ) )
+    msg = pmt::dict_add( pmt::make_dict(), pmt::car( msg ), pmt::cdr( msg ) );
+
+  if ( ! pmt::is_dict( msg ) )
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    _queue.push_back( msg );
+  }
+
+  _cond.notify_one();
+}
+
+/* false if stopped while waiting */
+bool command_handler::wait_until( const ::osmosdr::time_spec_t &time )
+{
+  ::osmosdr::time_spec_t now = _time_now();
+
+  if ( now.get_real_secs() <= 0 )
+    now = ::osmosdr::time_spec_t::get_system_time();
+
+  ::osmosdr::time_spec_t delay = time;
+  delay -= now;
+
+  const std::chrono::steady_clock::time_point deadline =
+    std::chrono::steady_clock::now() +
+    std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+      std::chrono::duration< double >( std::max( 0.0, delay.get_real_secs() ) ) );
+
+  std::unique_lock<std::mutex> lock( _lock );
+
+  _cond.wait_until( lock, deadline, [this]() { return ! _running; } );
+
+  return _running;
+}
+
+void command_handler::control_task()
+{
+  std::unique_lock<std::mutex> lock( _lock );
+
+  while ( true )
+  {
+    _cond.wait( lock, [this]() { return ! _running || ! _queue.empty(); } );
+
+    if ( ! _running )
+      break;
+
+    pmt::pmt_t cmd = _queue.front();
+    _queue.pop_front();
+
+    lock.unlock();
+
+    try {
+      const pmt::pmt_t time = pmt::dict_ref( cmd, pmt::mp("time"), pmt::PMT_NIL );
+
+      bool run = true;
+
+      if ( pmt::is_tuple( time ) )
+        run = wait_until( ::osmosdr::time_spec_t(
+                            time_t( pmt::to_uint64( pmt::tuple_ref( time, 0 ) ) ),
+                            pmt::to_double( pmt::tuple_ref( time, 1 ) ) ) );
+      else if ( pmt::is_number( time ) )
+        run = wait_until( ::osmosdr::time_spec_t( pmt::to_double( time ) ) );
+
+      if ( run )
+        _apply( cmd );
+    } catch ( std::exception &e ) {
+      std::cerr << "Failed to apply command: " << e.what() << std::endl;
+    }
+
+    lock.lock();
+  }
+}
@@ -0,0 +1,131 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_COMMAND_HANDLER_H
+#define INCLUDED_COMMAND_HANDLER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include <gnuradio/block.h>
+#include <gnuradio/thread/thread.h>
+#include <pmt/pmt.h>
+
+#include "osmosdr/time_spec.h"
+
+class command_handler;
+
+typedef std::shared_ptr<command_handler> command_handler_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of command_handler.
+ * \param apply called from the control thread for every command
+ * \param time_now the device time commands with a time are scheduled by
+ */
+command_handler_sptr make_command_handler(
+    const std::function< void( const pmt::pmt_t &cmd ) > &apply,
+    const std::function< ::osmosdr::time_spec_t() > &time_now );
+
+/*!
+ * \brief Applies the commands sent to the "command" port of a source or
+ * sink on a thread of its own.
+ *
+ * Commands are PMT dicts (or a single key/value pair) in the spirit of
+ * gr-uhd, with freq, gain, antenna, bandwidth and rate, optionally
+ * restricted to one channel with chan. Whoever sends them never waits
+ * for the device. They are applied in the order they arrive.
+ *
+ * A command with a time (a tuple of integer and fractional seconds, or
+ * seconds as a double) is held back until the device clock reaches it,
+ * the host clock is used for devices without one. This is only as exact
+ * as the host can sleep, the position of the change in the stream is
+ * told by the rx_freq tag of the backends that tag their retunes.
+ */
+class command_handler : public gr::block
+{
+private:
+  friend command_handler_sptr make_command_handler(
+      const std::function< void( const pmt::pmt_t &cmd ) > &apply,
+      const std::function< ::osmosdr::time_spec_t() > &time_now );
+
+  command_handler( const std::function< void( const pmt::pmt_t &cmd ) > &apply,
+                   const std::function< ::osmosdr::time_spec_t() > &time_now );
+
+public:
+  ~command_handler();
+
+  bool start();
+  bool stop();
+
+private:
+  void post( pmt::pmt_t msg );
+  void control_task();
+  bool wait_until( const ::osmosdr::time_spec_t &time );
+
+  std::function< void( const pmt::pmt_t &cmd ) > _apply;
+  std::function< ::osmosdr::time_spec_t() > _time_now;
+
+  std::mutex _lock;
+  std::condition_variable _cond;
+  std::deque< pmt::pmt_t > _queue;
+  bool _running;
+  gr::thread::thread _thread;
+};
+
+/*!
+ * Apply a command to \p dev, a source_impl or a sink_impl. The rate goes
+ * first since retuning may depend on it, unknown keys are ignored so the
+ * commands of other blocks on the same port (e.g. triggers) pass.
+ */
+template< class T >
+void apply_command( T &dev, const pmt::pmt_t &cmd )
+{
+  const pmt::pmt_t rate = pmt::dict_ref( cmd, pmt::mp("rate"), pmt::PMT_NIL );
+  const pmt::pmt_t freq = pmt::dict_ref( cmd, pmt::mp("freq"), pmt::PMT_NIL );
+  const pmt::pmt_t gain = pmt::dict_ref( cmd, pmt::mp("gain"), pmt::PMT_NIL );
+  const pmt::pmt_t antenna = pmt::dict_ref( cmd, pmt::mp("antenna"), pmt::PMT_NIL );
+  const pmt::pmt_t bandwidth = pmt::dict_ref( cmd, pmt::mp("bandwidth"), pmt::PMT_NIL );
+  const pmt::pmt_t chan = pmt::dict_ref( cmd, pmt::mp("chan"), pmt::PMT_NIL );
+
+  size_t first = 0, last = dev.get_num_channels();
+
+  if ( pmt::is_number( chan ) ) {
+    first = pmt::to_long( chan );
+    last = std::min( first + 1, last );
+  }
+
+  if ( pmt::is_number( rate ) )
+    dev.set_sample_rate( pmt::to_double( rate ) );
+
+  for (size_t i = first; i < last; i++) {
+    if ( pmt::is_number( freq ) )
+      dev.set_center_freq( pmt::to_double( freq ), i );
+    if ( pmt::is_number( gain ) )
+      dev.set_gain( pmt::to_double( gain ), i );
+    if ( pmt::is_symbol( antenna ) )
+      dev.set_antenna( pmt::symbol_to_string( antenna ), i );
+    if ( pmt::is_number( bandwidth ) )
+      dev.set_bandwidth( pmt::to_double( bandwidth ), i );
+  }
+}
+
+#endif /* INCLUDED_COMMAND_HANDLER_H */
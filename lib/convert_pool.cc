@@ -0,0 +1,136 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+
+#include <boost/lexical_cast.hpp>
+
+#include "convert_pool.h"
+
+/* items per chunk below which the wakeups cost more than they gain */
+#define MIN_CHUNK 8192
+
+convert_pool::convert_pool( size_t nthreads ) :
+  _generation(0),
+  _pending(0),
+  _stop(false),
+  _fn(NULL),
+  _nitems(0),
+  _chunk(0)
+{
+  set_threads( nthreads );
+}
+
+convert_pool::~convert_pool()
+{
+  stop();
+}
+
+size_t convert_pool::threads_from_dict( const dict_t &dict )
+{
+  if ( ! dict.count( "convert_threads" ) )
+    return 1;
+
+  /* 0 for one per core */
+  size_t nthreads = boost::lexical_cast< size_t >( dict.at( "convert_threads" ) );
+  if ( 0 == nthreads )
+    nthreads = std::thread::hardware_concurrency();
+
+  return std::max< size_t >( 1, nthreads );
+}
+
+void convert_pool::set_threads( size_t nthreads )
+{
+  stop();
+
+  _stop = false;
+  for ( size_t i = 1; i < std::max< size_t >( 1, nthreads ); i++ )
+    _workers.push_back( std::thread( &convert_pool::worker, this, i, _generation ) );
+}
+
+void convert_pool::stop()
+{
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _stop = true;
+  }
+  _start.notify_all();
+
+  for ( std::thread &t : _workers )
+    t.join();
+  _workers.clear();
+}
+
+void convert_pool::run( size_t nitems, const chunk_fn &fn, size_t align )
+{
+  const size_t nthreads = threads();
+
+  if ( 1 == nthreads || nitems < 2 * MIN_CHUNK ) {
+    if ( nitems )
+      fn( 0, nitems );
+    return;
+  }
+
+  align = std::max< size_t >( 1, align );
+  size_t chunk = ( nitems + nthreads - 1 ) / nthreads;
+  chunk = ( chunk + align - 1 ) / align * align;
+
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _fn = &fn;
+    _nitems = nitems;
+    _chunk = chunk;
+    _pending = _workers.size();
+    _generation++;
+  }
+  _start.notify_all();
+
+  fn( 0, std::min( chunk, nitems ) );
+
+  std::unique_lock< std::mutex > lock( _mutex );
+  _done.wait( lock, [this]() { return 0 == _pending; } );
+}
+
+/* \p seen is the run() the worker was started after, it may only get to
+ * lock the mutex once the next one is already waiting for it */
+void convert_pool::worker( size_t index, uint64_t seen )
+{
+  std::unique_lock< std::mutex > lock( _mutex );
+
+  while ( true )
+  {
+    _start.wait( lock, [&]() { return _stop || _generation != seen; } );
+    if ( _stop )
+      break;
+
+    seen = _generation;
+    const size_t begin = std::min( _nitems, index * _chunk );
+    const size_t end = std::min( _nitems, begin + _chunk );
+    const chunk_fn *fn = _fn;
+
+    lock.unlock();
+    if ( begin < end )
+      (*fn)( begin, end );
+    lock.lock();
+
+    if ( 0 == --_pending )
+      _done.notify_one();
+  }
+}
@@ -0,0 +1,85 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CONVERT_POOL_H
+#define OSMOSDR_CONVERT_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * Worker threads for the sample conversion of the high rate backends,
+ * enabled with convert_threads=<n>.
+ *
+ * run() splits the items of one transfer into a chunk per thread, the
+ * calling thread takes the first one, and returns when every chunk got
+ * converted. So work() still hands out complete buffers, only the time
+ * it takes is spread over n cores. Transfers too small to be worth the
+ * wakeups, and a pool of one thread, are converted inline.
+ */
+class OSMOSDR_API convert_pool
+{
+public:
+  typedef std::function< void( size_t begin, size_t end ) > chunk_fn;
+
+  /*! threads in total, counting the calling one */
+  explicit convert_pool( size_t nthreads = 1 );
+  ~convert_pool();
+
+  /*! the thread count from convert_threads=, 1 when not given */
+  static size_t threads_from_dict( const dict_t &dict );
+
+  void set_threads( size_t nthreads );
+  size_t threads() const { return _workers.size() + 1; }
+
+  /*!
+   * Call \p fn for consecutive parts of [0, \p nitems), concurrently.
+   * Chunk boundaries are multiples of \p align items.
+   */
+  void run( size_t nitems, const chunk_fn &fn, size_t align = 1 );
+
+private:
+  void stop();
+  void worker( size_t index, uint64_t seen );
+
+  std::vector< std::thread > _workers;
+
+  std::mutex _mutex;
+  std::condition_variable _start;
+  std::condition_variable _done;
+  uint64_t _generation;       // bumped for every run()
+  size_t _pending;            // chunks still being converted
+  bool _stop;
+
+  /* the current run() */
+  const chunk_fn *_fn;
+  size_t _nitems;
+  size_t _chunk;
+};
+
+#endif // OSMOSDR_CONVERT_POOL_H
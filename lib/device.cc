@@ -21,7 +21,14 @@
 #include <osmosdr/device.h>
 #include <stdexcept>
 #include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
 #include <mutex>
 #include <sstream>
 
@@ -29,67 +36,9 @@
 #include "config.h"
 #endif
 
-#ifdef ENABLE_FCD
-#include <fcd_source_c.h>
-#endif
-
-#ifdef ENABLE_FILE
-#include <file_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL
-#include <rtl_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL_TCP
-#include <rtl_tcp_source_c.h>
-#endif
-
-#ifdef ENABLE_UHD
-#include <uhd_source_c.h>
-#endif
-
-#ifdef ENABLE_MIRI
-#include <miri_source_c.h>
-#endif
-
-#ifdef ENABLE_SDRPLAY
-#include <sdrplay_source_c.h>
-#endif
-
-#ifdef ENABLE_HACKRF
-#include <hackrf_source_c.h>
-#endif
-
-#ifdef ENABLE_BLADERF
-#include <bladerf_source_c.h>
-#endif
-
-#ifdef ENABLE_RFSPACE
-#include <rfspace_source_c.h>
-#endif
-
-#ifdef ENABLE_AIRSPY
-#include <airspy_source_c.h>
-#endif
-
-#ifdef ENABLE_AIRSPYHF
-#include <airspyhf_source_c.h>
-#endif
-
-#ifdef ENABLE_SOAPY
-#include <soapy_source_c.h>
-#endif
-
-#ifdef ENABLE_REDPITAYA
-#include <redpitaya_source_c.h>
-#endif
-
-#ifdef ENABLE_FREESRP
-#include <freesrp_source_c.h>
-#endif
-
 #include "arg_helpers.h"
+#include "backend_registry.h"
+#include "device_cache.h"
 
 using namespace osmosdr;
 
@@ -134,6 +83,21 @@ std::string device_t::to_string(void) const
   return ss.str();
 }
 
+/* how long the devices found by a backend are reused, in seconds */
+#define CACHE_TTL 2.0
+
+namespace {
+
+struct cache_entry_t
+{
+  std::chrono::steady_clock::time_point time;
+  std::vector< std::string > devices;
+};
+
+}
+
+static std::map< std::pair< std::string, bool >, cache_entry_t > _device_cache;
+
 devices_t device::find(const device_t &hint)
 {
   std::lock_guard<std::mutex> lock(_device_mutex);
@@ -143,73 +107,106 @@ devices_t device::find(const device_t &hint)
   if ( hint.count("nofake") )
     fake = false;
 
-  devices_t devices;
+  double ttl = CACHE_TTL;
 
-#ifdef ENABLE_FCD
-  for (std::string dev : fcd_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_RTL
-  for (std::string dev : rtl_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_UHD
-  for (std::string dev : uhd_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_MIRI
-  for (std::string dev : miri_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_SDRPLAY
-  for (std::string dev : sdrplay_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_BLADERF
-  for (std::string dev : bladerf_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_HACKRF
-  for (std::string dev : hackrf_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_RFSPACE
-  for (std::string dev : rfspace_source_c::get_devices( fake ))
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_AIRSPY
-  for (std::string dev : airspy_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_AIRSPYHF
-  for (std::string dev : airspyhf_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_FREESRP
-  for (std::string dev : freesrp_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_SOAPY
-  for (std::string dev : soapy_source_c::get_devices())
-    devices.push_back( device_t(dev) );
-#endif
+  if ( hint.count("nocache") )
+    ttl = 0;
 
-  /* software-only sources should be appended at the very end,
-   * hopefully resulting in hardware sources to be shown first
-   * in a graphical interface etc... */
+  if ( hint.count("cache") )
+    ttl = boost::lexical_cast< double >( hint.at("cache") );
 
-#ifdef ENABLE_RTL_TCP
-  for (std::string dev : rtl_tcp_source_c::get_devices( fake ))
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_REDPITAYA
-  for (std::string dev : redpitaya_source_c::get_devices( fake ))
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_FILE
-  for (std::string dev : file_source_c::get_devices( fake ))
-    devices.push_back( device_t(dev) );
-#endif
+  /* driver=rtl|hackrf only probes the backends named */
+  std::vector< std::string > drivers;
+
+  if ( hint.count("driver") )
+    boost::split( drivers, hint.at("driver"), boost::is_any_of("|") );
+
+  /* in the order the devices are listed, software-only sources should be
+   * at the very end, hopefully resulting in hardware sources to be shown
+   * first in a graphical interface etc... */
+  std::vector< backend_t > list;
+  for (const backend_t &backend : get_backends())
+    if ( backend.source_devices )
+      list.push_back( backend );
+
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  std::vector< const std::vector< std::string > * > results( list.size(), NULL );
+  std::vector< std::future< std::vector< std::string > > > probes( list.size() );
+
+  /* every backend takes its own time to probe, run them all at once */
+  for (size_t i = 0; i < list.size(); i++) {
+    const backend_t &backend = list[i];
+
+    if ( drivers.size() &&
+         std::find( drivers.begin(), drivers.end(), backend.name ) == drivers.end() &&
+         std::find_first_of( drivers.begin(), drivers.end(),
+                             backend.aliases.begin(), backend.aliases.end() ) == drivers.end() )
+      continue;
+
+    /* backends without fake devices share the entry with auto-detection */
+    auto cached = _device_cache.find( std::make_pair( backend.name, fake && backend.fakes ) );
+
+    if ( cached != _device_cache.end() &&
+         std::chrono::duration<double>( now - cached->second.time ).count() < ttl ) {
+      results[i] = &cached->second.devices;
+      continue;
+    }
+
+    probes[i] = std::async( std::launch::async, backend.source_devices, fake );
+  }
+
+  for (size_t i = 0; i < list.size(); i++) {
+    if ( ! probes[i].valid() )
+      continue;
+
+    cache_entry_t &entry = _device_cache[ std::make_pair( list[i].name, fake && list[i].fakes ) ];
+
+    try {
+      entry.devices = probes[i].get();
+    } catch ( std::exception &e ) {
+      std::cerr << "Probing for " << list[i].name << " devices failed: "
+                << e.what() << std::endl;
+      entry.devices.clear();
+    }
+
+    entry.time = now;
+    results[i] = &entry.devices;
+  }
+
+  devices_t devices;
+
+  for (const std::vector< std::string > *result : results)
+    if ( result )
+      for (const std::string &dev : *result)
+        devices.push_back( device_t(dev) );
 
   return devices;
 }
+
+std::vector< std::string >
+cached_devices( const std::string &name,
+                const std::function< std::vector< std::string >() > &get_devices )
+{
+  std::lock_guard<std::mutex> lock(_device_mutex);
+
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  cache_entry_t &entry = _device_cache[ std::make_pair( name, false ) ];
+
+  if ( entry.time != std::chrono::steady_clock::time_point() &&
+       std::chrono::duration<double>( now - entry.time ).count() < CACHE_TTL )
+    return entry.devices;
+
+  try {
+    entry.devices = get_devices();
+  } catch ( std::exception &e ) {
+    std::cerr << "Probing for " << name << " devices failed: "
+              << e.what() << std::endl;
+    entry.devices.clear();
+  }
+
+  entry.time = now;
+
+  return entry.devices;
+}
@@ -0,0 +1,39 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DEVICE_CACHE_H
+#define OSMOSDR_DEVICE_CACHE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*!
+ * The devices \p get_devices lists, taken from the cache of
+ * osmosdr::device::find while the entry of \p name is fresh and probed
+ * (and cached) otherwise. A backend that throws lists no devices.
+ *
+ * \p name is the device argument key of the backend, the source and sink
+ * of a backend may only share it when they list the same devices.
+ */
+std::vector< std::string >
+cached_devices( const std::string &name,
+                const std::function< std::vector< std::string >() > &get_devices );
+
+#endif // OSMOSDR_DEVICE_CACHE_H
@@ -0,0 +1,223 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DEVICE_POOL_H
+#define OSMOSDR_DEVICE_POOL_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "arg_helpers.h"
+
+/*!
+ * The opened devices of a backend, kept open for a while after their last
+ * user let go of them. A flowgraph built again with the same arguments
+ * gets the device back as it was left, without opening and setting it up
+ * again, which takes seconds on some of them.
+ *
+ * What acquire() returns shares the ownership of the device by its own
+ * count, so the pool learns when the last copy is gone. The device is
+ * then parked under its key until taken again or until it lingered long
+ * enough, when it's closed from the thread of the pool. Backends that
+ * leave settings behind in the device must set them again on a parked
+ * one, or make them part of the key.
+ */
+template< typename T >
+class device_pool
+{
+public:
+  typedef std::shared_ptr< T > sptr;
+
+  device_pool() : _stopping(false) {}
+
+  ~device_pool()
+  {
+    {
+      std::lock_guard< std::mutex > lock( _lock );
+      _stopping = true;
+    }
+    _wake.notify_all();
+
+    if ( _reaper.joinable() )
+      _reaper.join();
+
+    _parked.clear();
+  }
+
+  /*! how long a device stays open after its flowgraph, from linger=<ms> */
+  static double linger_from_dict( const dict_t &dict )
+  {
+    if ( ! dict.count( "linger" ) )
+      return 0;
+
+    return std::max( 0.0, boost::lexical_cast< double >( dict.at( "linger" ) ) / 1e3 );
+  }
+
+  /*!
+   * The device under \p key: with \p share the one in use if there is,
+   * else a parked one, else what \p open returns or throws. When its last
+   * copy is gone it's parked for \p linger seconds, 0 closes it right away.
+   * \p reused tells whether it was a parked one, which still has the
+   * settings of its last user.
+   */
+  sptr acquire( const std::string &key, bool share, double linger,
+                const std::function< sptr() > &open, bool *reused = NULL )
+  {
+    sptr dev;
+
+    {
+      std::lock_guard< std::mutex > lock( _lock );
+
+      auto live = _live.find( key );
+      if ( share && live != _live.end() ) {
+        sptr in_use = live->second.lock();
+        if ( in_use ) {
+          if ( reused )
+            *reused = false;
+          return in_use;
+        }
+      }
+
+      auto parked = _parked.find( key );
+      if ( parked != _parked.end() ) {
+        dev = parked->second.dev;
+        _parked.erase( parked );
+      }
+    }
+
+    if ( reused )
+      *reused = bool( dev );
+
+    /* opening is slow, the others aren't held up by it */
+    if ( ! dev )
+      dev = open();
+
+    /* the deleter may outlive the last copy in the control block _live
+     * points to, so it only carries the pointer */
+    sptr user( dev.get(), [this, key, linger]( T *p ) { park( key, p, linger ); } );
+
+    std::lock_guard< std::mutex > lock( _lock );
+    _owners[ dev.get() ] = dev;
+    _live[ key ] = user;
+
+    return user;
+  }
+
+  /*! closes \p dev with its last copy instead of parking it, when it failed */
+  void discard( const sptr &dev )
+  {
+    std::lock_guard< std::mutex > lock( _lock );
+
+    _discarded.insert( dev.get() );
+  }
+
+private:
+  typedef std::chrono::steady_clock clock;
+
+  struct parked_t
+  {
+    sptr dev;
+    clock::time_point until;
+  };
+
+  void park( const std::string &key, T *p, double linger )
+  {
+    sptr dev;   /* closed here when not parked, after the lock */
+
+    {
+      std::lock_guard< std::mutex > lock( _lock );
+
+      auto owner = _owners.find( p );
+      dev = owner->second;
+      _owners.erase( owner );
+
+      if ( _discarded.erase( p ) || linger <= 0 || _stopping )
+        return;
+
+      parked_t parked;
+      parked.dev = dev;
+      parked.until = clock::now() +
+                     std::chrono::duration_cast< clock::duration >( std::chrono::duration< double >( linger ) );
+      _parked.insert( std::make_pair( key, parked ) );
+
+      if ( ! _reaper.joinable() )
+        _reaper = std::thread( &device_pool::reap, this );
+    }
+
+    _wake.notify_all();
+  }
+
+  void reap()
+  {
+    std::unique_lock< std::mutex > lock( _lock );
+
+    while ( ! _stopping ) {
+      if ( _parked.empty() ) {
+        _wake.wait( lock );
+        continue;
+      }
+
+      clock::time_point next = clock::time_point::max();
+      for (const auto &p : _parked)
+        next = std::min( next, p.second.until );
+
+      if ( clock::now() < next ) {
+        _wake.wait_until( lock, next );
+        continue;
+      }
+
+      std::vector< sptr > expired;
+      for (auto it = _parked.begin(); it != _parked.end(); ) {
+        if ( it->second.until <= clock::now() ) {
+          expired.push_back( it->second.dev );
+          it = _parked.erase( it );
+        } else {
+          ++it;
+        }
+      }
+
+      lock.unlock();
+      expired.clear();
+      lock.lock();
+    }
+  }
+
+  std::mutex _lock;
+  std::condition_variable _wake;
+  std::thread _reaper;
+  bool _stopping;
+
+  std::map< std::string, std::weak_ptr< T > > _live;   // handed out, by key
+  std::multimap< std::string, parked_t > _parked;      // waiting to be taken again
+  std::map< const T *, sptr > _owners;                 // of the ones handed out
+  std::set< const T * > _discarded;
+};
+
+#endif // OSMOSDR_DEVICE_POOL_H
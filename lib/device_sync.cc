@@ -0,0 +1,46 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <iostream>
+
+#include "device_sync.h"
+
+::osmosdr::time_spec_t timed_start::get( const ::osmosdr::time_spec_t &now )
+{
+  std::lock_guard<std::mutex> lock( _mutex );
+
+  if ( ! _set ) {
+    _time = now + ::osmosdr::time_spec_t( _delay );
+    _set = true;
+  } else if ( now > _time ) {
+    std::cerr << "gr-osmosdr: a device started " << (now - _time).get_real_secs()
+              << " s after the common start time, increase start_delay"
+              << std::endl;
+  }
+
+  return _time;
+}
+
+void timed_start::reset()
+{
+  std::lock_guard<std::mutex> lock( _mutex );
+
+  _set = false;
+}
@@ -0,0 +1,96 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_DEVICE_SYNC_H
+#define INCLUDED_OSMOSDR_DEVICE_SYNC_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "osmosdr/ranges.h"
+#include "osmosdr/time_spec.h"
+
+/* Puts the clocks of all devices of a block on the host time. With pps
+ * the time is taken over at the next PPS edge by the devices that
+ * support it, with time it is set right away, with host the backends
+ * timestamp from the host clock anyway. */
+template <typename iface_t>
+void sync_device_time( const std::vector< iface_t * > &devs, const std::string &mode )
+{
+  typedef std::chrono::duration< double > seconds;
+
+  if ( "pps" == mode ) {
+    ::osmosdr::time_spec_t now = ::osmosdr::time_spec_t::get_system_time();
+
+    /* tell all of them well ahead of the edge, so they latch the same one */
+    if ( now.get_frac_secs() > 0.5 ) {
+      std::this_thread::sleep_for( seconds( 1.1 - now.get_frac_secs() ) );
+      now = ::osmosdr::time_spec_t::get_system_time();
+    }
+
+    const ::osmosdr::time_spec_t next( now.get_full_secs() + 1 );
+
+    for (iface_t *dev : devs)
+      dev->set_time_next_pps( next );
+
+    /* streaming may only start once the time has been taken over */
+    std::this_thread::sleep_for( seconds( 1.1 - now.get_frac_secs() ) );
+  } else if ( "time" == mode ) {
+    for (iface_t *dev : devs)
+      dev->set_time_now( ::osmosdr::time_spec_t::get_system_time(), osmosdr::ALL_MBOARDS );
+  }
+}
+
+class timed_start;
+
+typedef std::shared_ptr< timed_start > timed_start_sptr;
+
+/*!
+ * The moment the devices of a sink begin to transmit at, so their first
+ * samples leave together.
+ *
+ * The first device to start picks it, \p delay seconds after its time,
+ * the others get the same one. The devices hold their samples until
+ * then. Times are those the devices were synchronized to, the host time
+ * for devices without a clock of their own.
+ */
+class timed_start
+{
+public:
+  timed_start( double delay ) : _delay( delay ), _set( false ) {}
+
+  ::osmosdr::time_spec_t get( const ::osmosdr::time_spec_t &now );
+
+  /*! called when a device stops, the next start picks a new time */
+  void reset();
+
+  double delay() const { return _delay; }
+
+private:
+  std::mutex _mutex;
+  double _delay;
+  bool _set;
+  ::osmosdr::time_spec_t _time;
+};
+
+#endif /* INCLUDED_OSMOSDR_DEVICE_SYNC_H */
@@ -0,0 +1,60 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "fc32_convert.h"
+#include "arg_helpers.h"
+#include "sample_convert.h"
+
+fc32_convert_sptr make_fc32_convert (const std::string & type)
+{
+  return gnuradio::get_initial_sptr(new fc32_convert (type));
+}
+
+fc32_convert::fc32_convert (const std::string & type)
+  : gr::sync_block ("fc32_convert",
+        gr::io_signature::make(1, 1, sizeof (gr_complex)),
+        gr::io_signature::make(1, 1, item_type_to_size(type))),
+    _sc8("sc8" == type)
+{
+  if ( "sc16" != type && "sc8" != type )
+    throw std::runtime_error("Unsupported sample type " + type + ".");
+}
+
+int fc32_convert::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+
+  if ( _sc8 )
+    convert_fc32_sc8( in, (int8_t *)output_items[0], noutput_items );
+  else
+    convert_fc32_sc16( in, (int16_t *)output_items[0], noutput_items );
+
+  return noutput_items;
+}
@@ -0,0 +1,57 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_FC32_CONVERT_H
+#define INCLUDED_FC32_CONVERT_H
+
+#include <gnuradio/sync_block.h>
+
+class fc32_convert;
+
+typedef std::shared_ptr<fc32_convert> fc32_convert_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of fc32_convert.
+ * \param type the output item type, "sc16" or "sc8"
+ */
+fc32_convert_sptr make_fc32_convert (const std::string & type);
+
+/*!
+ * \brief Converts gr_complex samples to complex int16 or int8.
+ *
+ * Used by the source to provide the item type selected with type= for
+ * backends that can't deliver it natively. +/-1.0 maps to full scale.
+ */
+class fc32_convert : public gr::sync_block
+{
+private:
+  friend fc32_convert_sptr make_fc32_convert (const std::string & type);
+
+  fc32_convert (const std::string & type);  	// private constructor
+
+public:
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  bool _sc8;
+};
+
+#endif /* INCLUDED_FC32_CONVERT_H */
@@ -0,0 +1,241 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <gnuradio/io_signature.h>
+
+#include "fcd_alsa_source_c.h"
+#include "sample_convert.h"
+
+#define WAIT_TIMEOUT 100 // ms, lets the scheduler see a stop() request
+
+fcd_alsa_source_c_sptr make_fcd_alsa_source_c( const std::string &device,
+                                               unsigned int rate,
+                                               unsigned int period,
+                                               unsigned int periods )
+{
+  return gnuradio::get_initial_sptr(new fcd_alsa_source_c( device, rate, period, periods ));
+}
+
+static void _check( int err, const std::string &what )
+{
+  if ( err < 0 )
+    throw std::runtime_error( "FUNcube Dongle: " + what + ": " + snd_strerror( err ) );
+}
+
+fcd_alsa_source_c::fcd_alsa_source_c( const std::string &device,
+                                      unsigned int rate,
+                                      unsigned int period,
+                                      unsigned int periods ) :
+  gr::sync_block("fcd_alsa_source_c",
+                 gr::io_signature::make(0, 0, 0),
+                 gr::io_signature::make(1, 1, sizeof (gr_complex))),
+  _pcm(NULL),
+  _samples(0),
+  _overruns(0),
+  _fill(0),
+  _fill_max(0)
+{
+  _check( snd_pcm_open( &_pcm, device.c_str(), SND_PCM_STREAM_CAPTURE, 0 ),
+          "cannot open " + device );
+
+  snd_pcm_hw_params_t *hw;
+  snd_pcm_hw_params_alloca( &hw );
+
+  try {
+    _check( snd_pcm_hw_params_any( _pcm, hw ), "no configuration" );
+    /* no resampling by alsa-lib, the rate is the sample clock of the dongle */
+    _check( snd_pcm_hw_params_set_rate_resample( _pcm, hw, 0 ), "set_rate_resample" );
+    _check( snd_pcm_hw_params_set_access( _pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED ),
+            "mmap access not supported" );
+    _check( snd_pcm_hw_params_set_format( _pcm, hw, SND_PCM_FORMAT_S16_LE ),
+            "S16_LE not supported" );
+    _check( snd_pcm_hw_params_set_channels( _pcm, hw, 2 ), "stereo not supported" );
+    _check( snd_pcm_hw_params_set_rate( _pcm, hw, rate, 0 ),
+            "rate " + std::to_string( rate ) + " not supported" );
+
+    _period = period;
+    int dir = 0;
+    _check( snd_pcm_hw_params_set_period_size_near( _pcm, hw, &_period, &dir ),
+            "set_period_size" );
+    _check( snd_pcm_hw_params_set_periods_near( _pcm, hw, &periods, &dir ),
+            "set_periods" );
+    _check( snd_pcm_hw_params( _pcm, hw ), "set_hw_params" );
+
+    _check( snd_pcm_hw_params_get_period_size( hw, &_period, &dir ), "get_period_size" );
+    _check( snd_pcm_hw_params_get_buffer_size( hw, &_buffer ), "get_buffer_size" );
+
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca( &sw );
+
+    _check( snd_pcm_sw_params_current( _pcm, sw ), "sw_params_current" );
+    _check( snd_pcm_sw_params_set_avail_min( _pcm, sw, _period ), "set_avail_min" );
+    /* started explicitly in start() */
+    _check( snd_pcm_sw_params_set_start_threshold( _pcm, sw, _buffer + 1 ),
+            "set_start_threshold" );
+    _check( snd_pcm_sw_params( _pcm, sw ), "set_sw_params" );
+  } catch ( ... ) {
+    snd_pcm_close( _pcm );
+    throw;
+  }
+
+  std::cerr << "Using ALSA " << device << " directly, period " << _period
+            << " of " << _buffer << " frames" << std::endl;
+}
+
+fcd_alsa_source_c::~fcd_alsa_source_c()
+{
+  if ( _pcm )
+    snd_pcm_close( _pcm );
+}
+
+bool fcd_alsa_source_c::start()
+{
+  int err = snd_pcm_prepare( _pcm );
+  if ( err >= 0 )
+    err = snd_pcm_start( _pcm );
+
+  if ( err < 0 ) {
+    std::cerr << "FUNcube Dongle: failed to start capture: " << snd_strerror( err ) << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool fcd_alsa_source_c::stop()
+{
+  snd_pcm_drop( _pcm );
+
+  return true;
+}
+
+/* restart after an overrun (-EPIPE) or a suspend (-ESTRPIPE) */
+bool fcd_alsa_source_c::recover( int err )
+{
+  if ( -EPIPE == err ) {
+    _overruns++;
+    std::cerr << "O" << std::flush;
+  } else if ( -ESTRPIPE == err ) {
+    while ( -EAGAIN == (err = snd_pcm_resume( _pcm )) )
+      usleep( 1000 );
+
+    if ( err >= 0 )
+      return true;
+  } else {
+    std::cerr << "FUNcube Dongle: " << snd_strerror( err ) << std::endl;
+    return false;
+  }
+
+  err = snd_pcm_prepare( _pcm );
+  if ( err >= 0 )
+    err = snd_pcm_start( _pcm );
+
+  return err >= 0;
+}
+
+int fcd_alsa_source_c::work( int noutput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  const float scale = 1.0f / CONVERT_SC16_SCALE;
+
+  snd_pcm_sframes_t avail = snd_pcm_avail_update( _pcm );
+
+  if ( 0 == avail ) {
+    int err = snd_pcm_wait( _pcm, WAIT_TIMEOUT );
+    if ( err < 0 && ! recover( err ) )
+      return WORK_DONE;
+
+    avail = snd_pcm_avail_update( _pcm );
+  }
+
+  if ( avail < 0 ) {
+    if ( ! recover( avail ) )
+      return WORK_DONE;
+
+    return 0;
+  }
+
+  _fill = avail;
+  if ( (size_t)avail > _fill_max )
+    _fill_max = avail;
+
+  snd_pcm_uframes_t todo = std::min< snd_pcm_uframes_t >( avail, noutput_items );
+  int produced = 0;
+
+  /* the readable part may wrap around the end of the ring */
+  while ( todo )
+  {
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset, frames = todo;
+
+    int err = snd_pcm_mmap_begin( _pcm, &areas, &offset, &frames );
+    if ( err < 0 ) {
+      if ( ! recover( err ) ) {
+        if ( ! produced )
+          return WORK_DONE;
+        return produced;
+      }
+      break;
+    }
+
+    /* interleaved, both channels share one area and step */
+    const int16_t *in = (const int16_t *)((const char *)areas[0].addr +
+                                          areas[0].first / 8 +
+                                          offset * (areas[0].step / 8));
+
+    convert_s16_fc32( in, out + produced, frames, scale );
+
+    snd_pcm_sframes_t committed = snd_pcm_mmap_commit( _pcm, offset, frames );
+    if ( committed < 0 || (snd_pcm_uframes_t)committed != frames ) {
+      /* the data was overwritten while converting it */
+      recover( committed < 0 ? committed : -EPIPE );
+      break;
+    }
+
+    produced += frames;
+    todo -= frames;
+  }
+
+  _samples += produced;
+
+  return produced;
+}
+
+osmosdr::stream_stats_t fcd_alsa_source_c::get_stream_stats() const
+{
+  osmosdr::stream_stats_t stats;
+
+  stats.samples = _samples;
+  stats.overruns = _overruns;
+  stats.fill = _fill;
+  stats.fill_max = _fill_max;
+  stats.capacity = _buffer;
+
+  return stats;
+}
@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FCD_ALSA_SOURCE_C_H
+#define FCD_ALSA_SOURCE_C_H
+
+#include <atomic>
+#include <string>
+
+#include <alsa/asoundlib.h>
+
+#include <gnuradio/sync_block.h>
+
+#include "osmosdr/stream_stats.h"
+
+class fcd_alsa_source_c;
+
+typedef std::shared_ptr< fcd_alsa_source_c > fcd_alsa_source_c_sptr;
+
+fcd_alsa_source_c_sptr make_fcd_alsa_source_c( const std::string &device,
+                                               unsigned int rate,
+                                               unsigned int period,
+                                               unsigned int periods );
+
+/*!
+ * Captures the IQ audio of a FUNcube Dongle straight from the ALSA hw
+ * device, bypassing gr::audio.
+ *
+ * The device is opened with mmap access in its native format (S16 stereo,
+ * left is I), without any plugin in between, and work() converts out of
+ * the mmap'ed ring buffer. \p period frames are transferred per interrupt,
+ * the ring holds \p periods of them, both are rounded by the driver.
+ */
+class fcd_alsa_source_c : public gr::sync_block
+{
+private:
+  friend fcd_alsa_source_c_sptr make_fcd_alsa_source_c( const std::string &device,
+                                                        unsigned int rate,
+                                                        unsigned int period,
+                                                        unsigned int periods );
+
+  fcd_alsa_source_c( const std::string &device,
+                     unsigned int rate,
+                     unsigned int period,
+                     unsigned int periods );
+
+public:
+  ~fcd_alsa_source_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  osmosdr::stream_stats_t get_stream_stats() const;
+
+private:
+  bool recover( int err );
+
+  snd_pcm_t *_pcm;
+  snd_pcm_uframes_t _period;
+  snd_pcm_uframes_t _buffer;
+
+  std::atomic<uint64_t> _samples;
+  std::atomic<uint64_t> _overruns;
+  std::atomic<size_t> _fill;
+  std::atomic<size_t> _fill_max;
+};
+
+#endif // FCD_ALSA_SOURCE_C_H
@@ -0,0 +1,188 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "fcd_hid.h"
+
+#define FCD_VID "000004D8"
+#define FCD_V1_PID "0000FB56"
+#define FCD_V2_PID "0000FB31"
+
+#define FCD_CMD_APP_SET_FREQ_HZ     101
+#define FCD_CMD_APP_SET_LNA_GAIN    110
+#define FCD_CMD_APP_SET_MIXER_GAIN  114
+#define FCD_CMD_APP_SET_IF_GAIN     117
+
+#define FCD_REPORT_SIZE 64
+#define FCD_REPLY_TIMEOUT 1000 // ms
+
+static std::string _realpath( const std::string &path )
+{
+  char buf[PATH_MAX];
+
+  if ( ! realpath( path.c_str(), buf ) )
+    return "";
+
+  return buf;
+}
+
+static bool _is_fcd( const std::string &hidraw )
+{
+  std::ifstream uevent( "/sys/class/hidraw/" + hidraw + "/device/uevent" );
+  std::string line;
+
+  while ( getline( uevent, line ) )
+  {
+    if ( line.compare( 0, 7, "HID_ID=" ) )
+      continue;
+
+    return line.find( FCD_VID ":" FCD_V1_PID ) != std::string::npos ||
+           line.find( FCD_VID ":" FCD_V2_PID ) != std::string::npos;
+  }
+
+  return false;
+}
+
+/* USB device the sound card of "hw:N" belongs to, empty if unknown */
+static std::string _usb_device( const std::string &alsa_dev )
+{
+  size_t colon = alsa_dev.find( ':' );
+  if ( colon == std::string::npos )
+    return "";
+
+  char *end = NULL;
+  const std::string card = alsa_dev.substr( colon + 1 );
+  long id = strtol( card.c_str(), &end, 10 );
+  if ( end == card.c_str() || (*end && *end != ',') )
+    return "";
+
+  /* .../1-2/1-2:1.0 is the audio interface, .../1-2 the dongle */
+  std::string intf = _realpath( "/sys/class/sound/card" + std::to_string( id ) + "/device" );
+  size_t slash = intf.rfind( '/' );
+  if ( slash == std::string::npos )
+    return "";
+
+  return intf.substr( 0, slash + 1 );
+}
+
+fcd_hid::fcd_hid( const std::string &alsa_dev ) :
+  _fd(-1)
+{
+  const std::string usb = _usb_device( alsa_dev );
+  std::string node;
+
+  DIR *dir = opendir( "/sys/class/hidraw" );
+  if ( dir )
+  {
+    struct dirent *ent;
+    while ( (ent = readdir( dir )) )
+    {
+      const std::string hidraw = ent->d_name;
+      if ( hidraw.compare( 0, 6, "hidraw" ) || ! _is_fcd( hidraw ) )
+        continue;
+
+      const std::string path = _realpath( "/sys/class/hidraw/" + hidraw + "/device" );
+      if ( usb.size() && path.compare( 0, usb.size(), usb ) )
+        continue;
+
+      node = "/dev/" + hidraw;
+      break;
+    }
+    closedir( dir );
+  }
+
+  if ( node.empty() )
+    throw std::runtime_error( "No FUNcube Dongle HID device found for " + alsa_dev + "." );
+
+  _fd = open( node.c_str(), O_RDWR | O_CLOEXEC );
+  if ( _fd < 0 )
+    throw std::runtime_error( "Failed to open " + node + ": " + strerror( errno ) );
+}
+
+fcd_hid::~fcd_hid()
+{
+  if ( _fd >= 0 )
+    close( _fd );
+}
+
+bool fcd_hid::command( uint8_t cmd, const uint8_t *data, size_t len )
+{
+  /* report id 0 is not part of the report, but hidraw wants it up front */
+  uint8_t buf[FCD_REPORT_SIZE + 1];
+
+  memset( buf, 0, sizeof(buf) );
+  buf[1] = cmd;
+  memcpy( &buf[2], data, len );
+
+  if ( write( _fd, buf, sizeof(buf) ) != (ssize_t)sizeof(buf) )
+    return false;
+
+  struct pollfd pfd;
+  pfd.fd = _fd;
+  pfd.events = POLLIN;
+
+  if ( poll( &pfd, 1, FCD_REPLY_TIMEOUT ) <= 0 )
+    return false;
+
+  if ( read( _fd, buf, FCD_REPORT_SIZE ) < 2 )
+    return false;
+
+  /* the dongle echoes the command and puts 1 behind it on success */
+  return buf[0] == cmd && buf[1] == 1;
+}
+
+bool fcd_hid::set_freq( uint32_t hz )
+{
+  uint8_t data[4];
+
+  data[0] = hz & 0xff;
+  data[1] = (hz >> 8) & 0xff;
+  data[2] = (hz >> 16) & 0xff;
+  data[3] = (hz >> 24) & 0xff;
+
+  return command( FCD_CMD_APP_SET_FREQ_HZ, data, sizeof(data) );
+}
+
+bool fcd_hid::set_lna_gain( uint8_t value )
+{
+  return command( FCD_CMD_APP_SET_LNA_GAIN, &value, 1 );
+}
+
+bool fcd_hid::set_mixer_gain( uint8_t value )
+{
+  return command( FCD_CMD_APP_SET_MIXER_GAIN, &value, 1 );
+}
+
+bool fcd_hid::set_if_gain( uint8_t value )
+{
+  return command( FCD_CMD_APP_SET_IF_GAIN, &value, 1 );
+}
@@ -0,0 +1,55 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FCD_HID_H
+#define FCD_HID_H
+
+#include <cstdint>
+#include <string>
+
+/*!
+ * Minimal control of a FUNcube Dongle through its Linux hidraw node, for
+ * the native capture path where gr-funcube isn't instantiated (its audio
+ * source would hold the ALSA device).
+ *
+ * The hidraw node is found by the VID:PID of the dongle and, if the ALSA
+ * identifier gives a card number, by sitting on the same USB device as the
+ * sound card.
+ */
+class fcd_hid
+{
+public:
+  /*! \p alsa_dev is the ALSA identifier of the dongle, e.g. "hw:2" */
+  explicit fcd_hid( const std::string &alsa_dev );
+  ~fcd_hid();
+
+  bool set_freq( uint32_t hz );
+
+  /* raw register values, as enumerated by the firmware */
+  bool set_lna_gain( uint8_t value );
+  bool set_mixer_gain( uint8_t value );
+  bool set_if_gain( uint8_t value );
+
+private:
+  bool command( uint8_t cmd, const uint8_t *data, size_t len );
+
+  int _fd;
+};
+
+#endif // FCD_HID_H
@@ -18,7 +18,9 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <string>
 #include <sstream>
 
@@ -32,6 +34,9 @@
 
 using namespace boost::assign;
 
+#define NATIVE_PERIOD 256   // frames, 2.7 ms for the V1 and 1.3 ms for the V2
+#define NATIVE_PERIODS 4
+
 fcd_source_c_sptr make_fcd_source_c(const std::string &args)
 {
   return gnuradio::get_initial_sptr(new fcd_source_c(args));
@@ -91,7 +96,9 @@ fcd_source_c::fcd_source_c(const std::string &args) :
   gr::hier_block2("fcd_source_c",
                  gr::io_signature::make(0, 0, 0),
                  gr::io_signature::make(1, 1, sizeof (gr_complex))),
-  _type( FUNCUBE_UNKNOWN )
+  _type( FUNCUBE_UNKNOWN ),
+  _freq( 0 ),
+  _correct( 0 )
 {
   std::string dev_name;
   unsigned int dev_index = 0;
@@ -141,20 +148,43 @@ fcd_source_c::fcd_source_c(const std::string &args) :
 
   std::cerr << "Using " << name() << " (" << dev_name << ")" << std::endl;
 
-  if ( FUNCUBE_V1 == _type )
+  if (dict.count("native") && dict["native"] != "0")
+  {
+#ifdef HAVE_ALSA
+    unsigned int period = NATIVE_PERIOD, periods = NATIVE_PERIODS;
+
+    if (dict.count("period"))
+      period = boost::lexical_cast< unsigned int >( dict["period"] );
+
+    if (dict.count("periods"))
+      periods = boost::lexical_cast< unsigned int >( dict["periods"] );
+
+    _hid.reset( new fcd_hid( dev_name ) );
+    _alsa = make_fcd_alsa_source_c( dev_name, get_sample_rate(), period, periods );
+    connect( _alsa, 0, self(), 0 );
+#else
+    throw std::runtime_error("FUNcube Dongle: native=1 needs gr-osmosdr built with ALSA.");
+#endif
+  }
+  else if ( FUNCUBE_V1 == _type )
   {
     _src_v1 = gr::funcube::fcd::make( dev_name );
     connect( _src_v1, 0, self(), 0 );
+  }
+  else if ( FUNCUBE_V2 == _type )
+  {
+    _src_v2 = gr::funcube::fcdpp::make( dev_name );
+    connect( _src_v2, 0, self(), 0 );
+  }
 
+  if ( FUNCUBE_V1 == _type )
+  {
     set_gain( 20, "LNA" );
     set_gain( 12, "MIX" );
   }
 
   if ( FUNCUBE_V2 == _type )
   {
-    _src_v2 = gr::funcube::fcdpp::make( dev_name );
-    connect( _src_v2, 0, self(), 0 );
-
     set_gain( 1, "LNA" );
     set_gain( 1, "MIX" );
     set_gain( 15, "BB" );
@@ -236,6 +266,18 @@ osmosdr::freq_range_t fcd_source_c::get_freq_range( size_t chan )
 
 double fcd_source_c::set_center_freq( double freq, size_t chan )
 {
+#ifdef HAVE_ALSA
+  if ( _hid )
+  {
+    if ( ! _hid->set_freq( uint32_t( freq * (1.0 + _correct * 1e-6) + 0.5 ) ) )
+      std::cerr << "FUNcube Dongle: failed to tune to " << freq << " Hz" << std::endl;
+
+    _freq = freq;
+
+    return get_center_freq(chan);
+  }
+#endif
+
   if ( FUNCUBE_V1 == _type )
     _src_v1->set_freq( freq );
 
@@ -254,6 +296,18 @@ double fcd_source_c::get_center_freq( size_t chan )
 
 double fcd_source_c::set_freq_corr( double ppm, size_t chan )
 {
+#ifdef HAVE_ALSA
+  if ( _hid )
+  {
+    _correct = ppm;
+
+    if ( _freq > 0 )
+      set_center_freq( _freq, chan );
+
+    return get_freq_corr( chan );
+  }
+#endif
+
   if ( FUNCUBE_V1 == _type )
     _src_v1->set_freq_corr( ppm );
 
@@ -328,8 +382,72 @@ double fcd_source_c::set_gain( double gain, size_t chan )
   return get_gain(chan);
 }
 
+#ifdef HAVE_ALSA
+/* register values of the V1 LNA gain, -5 to +30 dB, firmware enumeration */
+static uint8_t _v1_lna_gain( double gain )
+{
+  static const struct { double db; uint8_t value; } steps[] = {
+    { -5.0, 0 }, { -2.5, 1 }, { 0.0, 4 }, { 2.5, 5 }, { 5.0, 6 }, { 7.5, 7 },
+    { 10.0, 8 }, { 12.5, 9 }, { 15.0, 10 }, { 17.5, 11 }, { 20.0, 12 },
+    { 25.0, 13 }, { 30.0, 14 }
+  };
+  const size_t count = sizeof(steps) / sizeof(steps[0]);
+
+  size_t i = 0;
+  while ( i + 1 < count && steps[i + 1].db <= gain )
+    i++;
+
+  return steps[i].value;
+}
+#endif
+
 double fcd_source_c::set_gain( double gain, const std::string & name, size_t chan )
 {
+#ifdef HAVE_ALSA
+  if ( _hid )
+  {
+    bool ok = true;
+
+    if ( FUNCUBE_V1 == _type )
+    {
+      if ( "LNA" == name )
+      {
+        _lna_gain = gain;
+        ok = _hid->set_lna_gain( _v1_lna_gain( gain ) );
+      }
+      else if ( "MIX" == name )
+      {
+        _mix_gain = gain > 4 ? 12 : 4;
+        ok = _hid->set_mixer_gain( _mix_gain > 4 ? 1 : 0 );
+      }
+    }
+
+    if ( FUNCUBE_V2 == _type )
+    {
+      if ( "LNA" == name )
+      {
+        _lna_gain = gain > 0 ? 1 : 0;
+        ok = _hid->set_lna_gain( _lna_gain );
+      }
+      else if ( "MIX" == name )
+      {
+        _mix_gain = gain > 0 ? 1 : 0;
+        ok = _hid->set_mixer_gain( _mix_gain );
+      }
+      else if ( "BB" == name )
+      {
+        _bb_gain = std::max( 0.0, std::min( 59.0, gain ) );
+        ok = _hid->set_if_gain( uint8_t( _bb_gain + 0.5 ) );
+      }
+    }
+
+    if ( ! ok )
+      std::cerr << "FUNcube Dongle: failed to set " << name << " gain" << std::endl;
+
+    return get_gain( name, chan );
+  }
+#endif
+
   if ( FUNCUBE_V1 == _type )
   {
     if ( "LNA" == name )
@@ -416,3 +534,13 @@ std::string fcd_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t fcd_source_c::get_stream_stats( size_t chan )
+{
+#ifdef HAVE_ALSA
+  if ( _alsa )
+    return _alsa->get_stream_stats();
+#endif
+
+  return osmosdr::stream_stats_t();
+}
@@ -20,11 +20,18 @@
 #ifndef FCD_SOURCE_C_H
 #define FCD_SOURCE_C_H
 
+#include <memory>
+
 #include <gnuradio/hier_block2.h>
 
 #include <funcube/fcd.h>
 #include <funcube/fcdpp.h>
 
+#ifdef HAVE_ALSA
+#include "fcd_alsa_source_c.h"
+#include "fcd_hid.h"
+#endif
+
 #include "source_iface.h"
 
 class fcd_source_c;
@@ -79,10 +86,17 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   dongle_type _type;
   gr::funcube::fcd::sptr _src_v1;
   gr::funcube::fcdpp::sptr _src_v2;
+#ifdef HAVE_ALSA
+  /* native=1: ALSA capture and HID control without gr-funcube */
+  fcd_alsa_source_c_sptr _alsa;
+  std::unique_ptr<fcd_hid> _hid;
+#endif
   double _lna_gain, _mix_gain, _bb_gain, _freq;
   double _correct;
 };
@@ -0,0 +1,387 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/fft/window.h>
+#include <gnuradio/io_signature.h>
+
+#include <volk/volk.h>
+
+#include "fft_channelizer.h"
+#include "stream_tagger.h"
+
+#define MIN_FFT 1024              // points of the wideband FFT
+#define MAX_FFT (1 << 18)
+#define MIN_CHAN_FFT 128          // wanted for the narrowest channel
+#define MIN_CHAN_BINS 16          // inverse FFT points of a channel at least
+#define OVERSAMPLE 1.25           // channel rate / bandwidth at least
+
+channel_spec_t channel_spec_from_string( const std::string &spec )
+{
+  channel_spec_t result;
+
+  const size_t colon = spec.find(':');
+  if ( colon == std::string::npos )
+    throw std::runtime_error( "Channel " + spec + " isn't given as <freq>:<bandwidth>." );
+
+  const std::string freq = spec.substr( 0, colon );
+
+  result.freq = boost::lexical_cast< double >( freq );
+  result.bandwidth = boost::lexical_cast< double >( spec.substr( colon + 1 ) );
+  result.offset = freq.size() && ( '+' == freq[0] || '-' == freq[0] );
+
+  if ( ! ( result.bandwidth > 0 ) )
+    throw std::runtime_error( "Channel " + spec + " needs a positive bandwidth." );
+
+  return result;
+}
+
+fft_channelizer_sptr make_fft_channelizer( const std::vector< channel_spec_t > &specs,
+                                           double rate, double freq )
+{
+  return gnuradio::get_initial_sptr(new fft_channelizer( specs, rate, freq ));
+}
+
+fft_channelizer::fft_channelizer( const std::vector< channel_spec_t > &specs,
+                                  double rate, double freq )
+  : gr::block ("fft_channelizer",
+        gr::io_signature::make(1, 1, sizeof(gr_complex)),
+        gr::io_signature::make(specs.size(), specs.size(), sizeof(gr_complex))),
+    _rate(rate),
+    _freq(freq),
+    _reconfigure(true),
+    _nfft(0),
+    _fill(0),
+    _blocks(0),
+    _in_origin(0)
+{
+  if ( specs.empty() )
+    throw std::runtime_error( "No channels to extract." );
+
+  _chans.resize( specs.size() );
+  for (size_t i = 0; i < specs.size(); i++) {
+    _chans[i].spec = specs[i];
+    _chans[i].nfft = 0;
+  }
+
+  /* the rates of the outputs have nothing in common, only rx_time goes
+   * through, moved to the matching sample */
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+/* the narrowest channel gets MIN_CHAN_FFT points if the FFT can be that large */
+static size_t wide_fft_size( double rate, const std::vector< double > &bandwidths )
+{
+  double narrowest = rate;
+  for (double bandwidth : bandwidths)
+    narrowest = std::min( narrowest, bandwidth );
+
+  size_t n = MIN_FFT;
+  while ( n < MAX_FFT && n * OVERSAMPLE * narrowest < MIN_CHAN_FFT * rate )
+    n *= 2;
+
+  return n;
+}
+
+static size_t chan_fft_size( double rate, double bandwidth, size_t n )
+{
+  size_t nfft = MIN_CHAN_BINS;
+  while ( nfft < n && nfft * rate < OVERSAMPLE * bandwidth * n )
+    nfft *= 2;
+
+  return nfft;
+}
+
+void fft_channelizer::set_sample_rate( double rate )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( rate != _rate ) {
+    _rate = rate;
+    _reconfigure = true;
+  }
+}
+
+void fft_channelizer::set_center_freq( double freq )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( freq != _freq ) {
+    _freq = freq;
+    _reconfigure = true;
+  }
+}
+
+double fft_channelizer::get_sample_rate( size_t chan )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( chan >= _chans.size() || ! ( _rate > 0 ) )
+    return 0;
+
+  std::vector< double > bandwidths;
+  for (const channel_t &ch : _chans)
+    bandwidths.push_back( ch.spec.bandwidth );
+
+  const size_t n = wide_fft_size( _rate, bandwidths );
+
+  return _rate * chan_fft_size( _rate, _chans[chan].spec.bandwidth, n ) / n;
+}
+
+/* lays out the filter bank for the current rate and center frequency,
+ * called from work() with _lock held */
+void fft_channelizer::configure()
+{
+  std::vector< double > bandwidths;
+  for (const channel_t &ch : _chans)
+    bandwidths.push_back( ch.spec.bandwidth );
+
+  const size_t n = wide_fft_size( _rate, bandwidths );
+
+  if ( n != _nfft ) {
+    _nfft = n;
+    _fft.reset( new gr::fft::fft_complex_fwd( n ) );
+  }
+
+  /* a quarter of zeros in front puts the first output sample at the first
+   * input sample, see process_block() */
+  _buf.assign( n, gr_complex(0) );
+  _fill = n / 4;
+  _blocks = 0;
+  _in_origin = nitems_read(0);
+
+  for (size_t i = 0; i < _chans.size(); i++) {
+    channel_t &ch = _chans[i];
+
+    const size_t nfft = chan_fft_size( _rate, ch.spec.bandwidth, n );
+    const double out_rate = _rate * nfft / n;
+    const double offset = ch.spec.offset ? ch.spec.freq : ch.spec.freq - _freq;
+
+    ch.in_band = std::abs( offset ) + ch.spec.bandwidth / 2 <= _rate / 2;
+    if ( ! ch.in_band )
+      std::cerr << "Channel " << i << " at " << ( _freq + offset ) << " Hz is outside "
+                << "of the received band, it gets zeros." << std::endl;
+
+    /* the center bin, the rest is left to the rotator */
+    ch.bin = std::lround( offset * n / _rate );
+    const double residual = offset - ch.bin * _rate / n;
+
+    ch.phase = gr_complex(1);
+    ch.phase_inc = std::polar( 1.0f, float( -2.0 * M_PI * residual / out_rate ) );
+
+    if ( nfft != ch.nfft || ! ch.ifft ) {
+      ch.nfft = nfft;
+      ch.ifft.reset( new gr::fft::fft_complex_rev( nfft ) );
+    }
+    ch.decim = n / nfft;
+
+    /* zero phase lowpass with nfft / 4 taps on either side of the center,
+     * what overlap-save with half of every block kept allows, cut off
+     * half way between the band edge and the Nyquist rate of the channel */
+    const long half = nfft / 4;
+    const double cutoff = ( ch.spec.bandwidth / 2 + out_rate / 2 ) / 2 / out_rate;
+    const std::vector< float > window = gr::fft::window::blackmanharris( 2 * half + 1 );
+
+    gr::fft::fft_complex_fwd design( nfft );
+    gr_complex *taps = design.get_inbuf();
+    std::fill( taps, taps + nfft, gr_complex(0) );
+
+    double sum = 0;
+    for (long k = -half; k <= half; k++) {
+      const double x = M_PI * 2 * cutoff * k;
+      const double tap = 2 * cutoff * ( k ? std::sin( x ) / x : 1.0 ) * window[ k + half ];
+
+      taps[ ( k + long(nfft) ) % long(nfft) ] = gr_complex( tap );
+      sum += tap;
+    }
+
+    design.execute();
+
+    /* unity gain, and the 1 / N the FFTs leave out */
+    ch.resp.resize( nfft );
+    for (size_t j = 0; j < nfft; j++)
+      ch.resp[j] = design.get_outbuf()[j].real() / ( sum * n );
+
+    ch.pending.clear();
+    ch.pending_pos = 0;
+    ch.out_origin = nitems_written(i);
+
+    add_item_tag( i, ch.out_origin, stream_tagger::RATE_KEY(),
+                  pmt::from_double( out_rate ), alias_pmt() );
+    add_item_tag( i, ch.out_origin, stream_tagger::FREQ_KEY(),
+                  pmt::from_double( _freq + offset ), alias_pmt() );
+  }
+}
+
+/* weight the bins around the center of the channel with its response,
+ * the upper half of them goes to the front of the inverse FFT */
+void fft_channelizer::gather( channel_t &ch, const gr_complex *spectrum )
+{
+  gr_complex *in = ch.ifft->get_inbuf();
+  const long n = _nfft;
+  const size_t half = ch.nfft / 2;
+
+  auto copy = [&]( long first, size_t count, size_t dst ) {
+    while ( count ) {
+      const long start = ( ( first % n ) + n ) % n;
+      const size_t len = std::min( count, size_t( n - start ) );
+
+      volk_32fc_32f_multiply_32fc( in + dst, spectrum + start, &ch.resp[dst], len );
+
+      first += len;
+      dst += len;
+      count -= len;
+    }
+  };
+
+  copy( ch.bin, half, 0 );
+  copy( ch.bin - long(half), half, half );
+}
+
+/*
+ * One overlap-save step over the N samples in _buf, the second half of
+ * which is new. The channels keep the middle half of their inverse FFT,
+ * which the N / 4 taps on either side of the lowpass leave untouched by
+ * the wrap around, that is input samples N / 4 to 3N / 4 of the block.
+ */
+void fft_channelizer::process_block()
+{
+  std::copy( _buf.begin(), _buf.end(), _fft->get_inbuf() );
+  _fft->execute();
+
+  const gr_complex *spectrum = _fft->get_outbuf();
+
+  for (channel_t &ch : _chans) {
+    const size_t nout = ch.nfft / 2;
+
+    ch.pending.resize( nout );
+    ch.pending_pos = 0;
+
+    if ( ! ch.in_band ) {
+      std::fill( ch.pending.begin(), ch.pending.end(), gr_complex(0) );
+      continue;
+    }
+
+    gather( ch, spectrum );
+    ch.ifft->execute();
+
+    /* the blocks advance by N / 2, which turns a shift by an odd bin
+     * around by pi from one block to the next */
+    const bool flip = ( ch.bin & 1 ) && ( _blocks & 1 );
+    gr_complex phase = flip ? -ch.phase : ch.phase;
+
+    volk_32fc_s32fc_x2_rotator_32fc( &ch.pending[0], ch.ifft->get_outbuf() + ch.nfft / 4,
+                                     ch.phase_inc, &phase, nout );
+
+    ch.phase = flip ? -phase : phase;
+  }
+
+  std::copy( _buf.begin() + _nfft / 2, _buf.end(), _buf.begin() );
+  _fill = _nfft / 2;
+  _blocks++;
+}
+
+void fft_channelizer::forecast( int noutput_items, gr_vector_int &ninput_items_required )
+{
+  /* the input is gathered into whole blocks here */
+  ninput_items_required[0] = 1;
+}
+
+int fft_channelizer::general_work( int noutput_items,
+                                   gr_vector_int &ninput_items,
+                                   gr_vector_const_void_star &input_items,
+                                   gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    if ( _reconfigure ) {
+      configure();
+      _reconfigure = false;
+    }
+  }
+
+  std::vector< size_t > produced( _chans.size(), 0 );
+  std::vector< gr::tag_t > tags;
+  size_t consumed = 0;
+
+  while ( true )
+  {
+    /* the outputs don't need to have room for a whole block */
+    bool blocked = false;
+
+    for (size_t i = 0; i < _chans.size(); i++) {
+      channel_t &ch = _chans[i];
+      const size_t n = std::min( ch.pending.size() - ch.pending_pos,
+                                 size_t(noutput_items) - produced[i] );
+
+      std::copy( ch.pending.begin() + ch.pending_pos, ch.pending.begin() + ch.pending_pos + n,
+                 (gr_complex *)output_items[i] + produced[i] );
+
+      ch.pending_pos += n;
+      produced[i] += n;
+
+      if ( ch.pending_pos < ch.pending.size() )
+        blocked = true;
+    }
+
+    if ( blocked || consumed == size_t(ninput_items[0]) )
+      break;
+
+    const size_t take = std::min( size_t(ninput_items[0]) - consumed, _nfft - _fill );
+    const uint64_t start = nitems_read(0) + consumed;
+
+    get_tags_in_range( tags, 0, start, start + take, stream_tagger::TIME_KEY() );
+    for (const gr::tag_t &tag : tags)
+      for (size_t i = 0; i < _chans.size(); i++) {
+        const channel_t &ch = _chans[i];
+        const uint64_t offset = ch.out_origin +
+                                ( tag.offset - _in_origin + ch.decim / 2 ) / ch.decim;
+
+        add_item_tag( i, offset, tag.key, tag.value, alias_pmt() );
+      }
+
+    std::copy( in + consumed, in + consumed + take, _buf.begin() + _fill );
+    consumed += take;
+    _fill += take;
+
+    if ( _fill == _nfft )
+      process_block();
+  }
+
+  for (size_t i = 0; i < _chans.size(); i++)
+    produce( i, produced[i] );
+
+  consume( 0, consumed );
+
+  return WORK_CALLED_PRODUCE;
+}
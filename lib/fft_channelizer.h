@@ -0,0 +1,134 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_FFT_CHANNELIZER_H
+#define INCLUDED_FFT_CHANNELIZER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gnuradio/block.h>
+#include <gnuradio/fft/fft.h>
+
+/*! one channel of channels=<freq>:<bandwidth>,... */
+struct channel_spec_t
+{
+  double freq;          // Hz, absolute or from the center when offset
+  double bandwidth;     // Hz
+  bool offset;          // the frequency was given with a sign
+};
+
+/*!
+ * Parse "<freq>:<bandwidth>", a frequency starting with + or - is taken
+ * as an offset from the center frequency.
+ */
+channel_spec_t channel_spec_from_string( const std::string &spec );
+
+class fft_channelizer;
+
+typedef std::shared_ptr<fft_channelizer> fft_channelizer_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of fft_channelizer.
+ * \param specs the channels to extract, one output each
+ * \param rate the sample rate of the input
+ * \param freq the center frequency of the input
+ */
+fft_channelizer_sptr make_fft_channelizer( const std::vector< channel_spec_t > &specs,
+                                           double rate, double freq );
+
+/*!
+ * \brief Extracts any number of narrow channels from one wideband stream
+ * with a single FFT of every input block.
+ *
+ * A fast convolution filter bank: the input goes through an overlap-save
+ * FFT of N points with 50% overlap. Every channel takes the bins around
+ * its frequency, weights them with the response of a Blackman-Harris
+ * windowed lowpass and turns them back into samples with an inverse FFT
+ * of its own, N / decimation points. The frequency left between the
+ * channel and its center bin is removed with a VOLK rotator. The wide
+ * band is read once however many channels there are, each costs a small
+ * inverse FFT per block.
+ *
+ * The channels come out at power of two fractions of the input rate, at
+ * least 1.25 times their bandwidth, which the rx_rate tag on every output
+ * tells along with rx_freq. rx_time tags are passed on to the matching
+ * samples. A new rate or center frequency restarts the filter bank, the
+ * channels given as absolute frequencies stay where they are then.
+ */
+class fft_channelizer : public gr::block
+{
+private:
+  friend fft_channelizer_sptr make_fft_channelizer( const std::vector< channel_spec_t > &specs,
+                                                    double rate, double freq );
+
+  fft_channelizer( const std::vector< channel_spec_t > &specs, double rate, double freq );
+
+public:
+  void set_sample_rate( double rate );
+  void set_center_freq( double freq );
+
+  /*! the sample rate of output \p chan */
+  double get_sample_rate( size_t chan );
+
+  void forecast( int noutput_items, gr_vector_int &ninput_items_required );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  struct channel_t
+  {
+    channel_spec_t spec;
+    size_t nfft;                  // points of the inverse FFT
+    size_t decim;                 // of the input rate
+    long bin;                     // center bin, from -N/2 to N/2
+    bool in_band;
+    std::vector< float > resp;    // lowpass response, in FFT order
+    std::unique_ptr< gr::fft::fft_complex_rev > ifft;
+    gr_complex phase;             // of the rotator
+    gr_complex phase_inc;
+    std::vector< gr_complex > pending;  // output of the last block
+    size_t pending_pos;
+    uint64_t out_origin;          // output offset of input sample _in_origin
+  };
+
+  void configure();
+  void process_block();
+  void gather( channel_t &ch, const gr_complex *spectrum );
+
+  std::mutex _lock;               // _rate, _freq and _reconfigure
+  double _rate;
+  double _freq;
+  bool _reconfigure;
+
+  size_t _nfft;                   // N
+  std::unique_ptr< gr::fft::fft_complex_fwd > _fft;
+  std::vector< gr_complex > _buf; // input of the next block
+  size_t _fill;
+  uint64_t _blocks;
+  uint64_t _in_origin;            // input offset of the first sample since configure()
+  std::vector< channel_t > _chans;
+};
+
+#endif /* INCLUDED_FFT_CHANNELIZER_H */
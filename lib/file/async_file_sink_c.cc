@@ -0,0 +1,687 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "async_file_sink_c.h"
+#include "sample_convert.h"
+#include "sigmf.h"
+#include "stream_tagger.h"
+
+#define BLOCK_SIZE  (4 << 20)   // bytes, a multiple of every sample size
+#define BLOCK_ALIGN 4096        // satisfies O_DIRECT on the usual filesystems
+#define MIN_BLOCKS  4
+
+async_file_sink_c_sptr make_async_file_sink_c(const std::string &filename,
+                                              file_format_t format,
+                                              bool append,
+                                              size_t buffer_size,
+                                              bool direct,
+                                              const std::string &trigger,
+                                              uint64_t pre,
+                                              uint64_t post)
+{
+  return gnuradio::get_initial_sptr(new async_file_sink_c(filename, format, append,
+                                                          buffer_size, direct,
+                                                          trigger, pre, post));
+}
+
+/* name of the file of an event, the number goes in front of the extension */
+static std::string event_filename( const std::string &filename, uint64_t id )
+{
+  size_t slash = filename.find_last_of( "/\\" );
+  size_t dot = filename.find( '.', slash == std::string::npos ? 0 : slash + 1 );
+
+  if ( dot == std::string::npos )
+    dot = filename.size();
+
+  char number[32];
+  snprintf( number, sizeof(number), "-%06llu", (unsigned long long)id );
+
+  return filename.substr( 0, dot ) + number + filename.substr( dot );
+}
+
+async_file_sink_c::async_file_sink_c(const std::string &filename,
+                                     file_format_t format,
+                                     bool append,
+                                     size_t buffer_size,
+                                     bool direct,
+                                     const std::string &trigger,
+                                     uint64_t pre,
+                                     uint64_t post) :
+  gr::sync_block("async_file_sink_c",
+                 gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                 gr::io_signature::make(0, 0, 0)),
+  _fd(-1),
+  _filename(filename),
+  _format(format),
+  _item_size(file_format_size(format)),
+  _direct_wanted(direct),
+  _direct(false),
+  _offset(0),
+  _current(NULL),
+  _full_max(0),
+  _running(false),
+  _meta_rate(0),
+  _meta_freq(0),
+  _meta_pending(false),
+  _pre_bytes(pre * file_format_size(format)),
+  _post_items(post),
+  _history_bytes(0),
+  _event(0),
+  _recording(false),
+  _post_left(0),
+  _finish_pending(false),
+  _trigger_msg(false),
+  _file_event(0),
+  _samples(0),
+  _dropped(0),
+  _overruns(0),
+  _clipped(0),
+  _failed(false)
+{
+  if ( FILE_FORMAT_CU8 == _format )
+    throw std::runtime_error("Sample format cu8 is not supported for recording.");
+
+#ifndef O_DIRECT
+  if ( direct ) {
+    std::cerr << "O_DIRECT is not supported on this system." << std::endl;
+    _direct_wanted = false;
+  }
+#endif
+
+  size_t nblocks = std::max( size_t(MIN_BLOCKS), buffer_size / BLOCK_SIZE );
+
+  if ( trigger.empty() ) {
+    if ( ! open_file( filename, append ) )
+      throw std::runtime_error( "Failed to open " + filename + ": " + strerror(errno) );
+  } else {
+    _trigger_key = pmt::string_to_symbol( trigger );
+
+    /* the files are opened per event, the pool also has to hold the history */
+    nblocks = std::max( nblocks, size_t(_pre_bytes / BLOCK_SIZE) + 2 + MIN_BLOCKS );
+  }
+
+  message_port_register_in( pmt::mp("command") );
+  set_msg_handler( pmt::mp("command"),
+                   [this]( pmt::pmt_t msg ) { this->handle_command( msg ); } );
+
+  for (size_t i = 0; i < nblocks; i++) {
+    void *data;
+    if ( posix_memalign( &data, BLOCK_ALIGN, BLOCK_SIZE ) ) {
+      for (block_t &block : _blocks)
+        free( block.data );
+      if ( _fd >= 0 )
+        ::close( _fd );
+      throw std::runtime_error("Failed to allocate the recording buffers.");
+    }
+
+    block_t block;
+    block.data = (char *)data;
+    block.start = 0;
+    block.len = 0;
+    block.event = 0;
+    block.last = false;
+    _blocks.push_back( block );
+  }
+}
+
+async_file_sink_c::~async_file_sink_c()
+{
+  stop();
+
+  for (block_t &block : _blocks)
+    free( block.data );
+
+  if ( _fd >= 0 )
+    ::close( _fd );
+}
+
+bool async_file_sink_c::open_file( const std::string &filename, bool append )
+{
+  int flags = O_WRONLY | O_CREAT | ( append ? 0 : O_TRUNC );
+
+  _direct = _direct_wanted;
+#ifdef O_DIRECT
+  if ( _direct )
+    flags |= O_DIRECT;
+#endif
+
+  _fd = ::open( filename.c_str(), flags, 0644 );
+#ifdef O_DIRECT
+  if ( _fd < 0 && _direct ) {
+    std::cerr << "Opening " << filename << " with O_DIRECT failed: "
+              << strerror(errno) << ", using buffered writes." << std::endl;
+    _fd = ::open( filename.c_str(), flags & ~O_DIRECT, 0644 );
+    _direct = false;
+  }
+#endif
+  if ( _fd < 0 )
+    return false;
+
+  _offset = append ? uint64_t( lseek( _fd, 0, SEEK_END ) ) : 0;
+
+  return true;
+}
+
+/* writer side, switch over to the file of the given event */
+void async_file_sink_c::open_event( uint64_t id )
+{
+  if ( _fd >= 0 )
+    ::close( _fd );
+  _fd = -1;
+  _file_event = id;
+
+  event_t event = { id, 0, 0 };
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    while ( ! _events.empty() && _events.front().id <= id ) {
+      event = _events.front();
+      _events.pop_front();
+    }
+  }
+
+  std::string filename = event_filename( _filename, id );
+
+  if ( ! open_file( filename, false ) ) {
+    std::cerr << "Failed to open " << filename << ": " << strerror(errno) << std::endl;
+    return;
+  }
+
+  if ( ! _meta.empty() ) {
+    try {
+      sigmf_write_meta( event_filename( _meta, id ), _format, _meta_rate, _meta_freq,
+                        event.secs, event.frac );
+    } catch ( std::runtime_error &e ) {
+      std::cerr << e.what() << std::endl;
+    }
+  }
+}
+
+bool async_file_sink_c::start()
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( _running )
+    return true;
+
+  _free.clear();
+  _full.clear();
+  for (block_t &block : _blocks) {
+    block.len = 0;
+    _free.push_back( &block );
+  }
+
+  _current = NULL;
+  _history.clear();
+  _history_bytes = 0;
+  _recording = false;
+  _finish_pending = false;
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &async_file_sink_c::writer_task, this ) );
+
+  return true;
+}
+
+bool async_file_sink_c::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    if ( ! _running )
+      return true;
+
+    /* the writer empties the queue before it quits, and closes the
+     * file of an event still being recorded */
+    if ( _current && ( _trigger_key ? _recording : _current->len > 0 ) ) {
+      _current->event = _event;
+      _current->last = _recording;
+      _full.push_back( _current );
+    }
+    _current = NULL;
+    _recording = false;
+
+    _running = false;
+  }
+
+  _cond.notify_one();
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+async_file_sink_c::block_t *async_file_sink_c::get_block()
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( _free.empty() )
+    return NULL;
+
+  block_t *block = _free.front();
+  _free.pop_front();
+  block->start = 0;
+  block->len = 0;
+  block->event = 0;
+  block->last = false;
+
+  return block;
+}
+
+void async_file_sink_c::recycle_block( block_t *block )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  _free.push_back( block );
+}
+
+void async_file_sink_c::queue_block( block_t *block )
+{
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    _full.push_back( block );
+    _full_max = std::max( _full_max, _full.size() );
+  }
+
+  _cond.notify_one();
+}
+
+bool async_file_sink_c::write_block( block_t *block )
+{
+  const char *data = block->data + block->start;
+  const size_t used = block->len - block->start;
+  size_t len = used;
+
+#ifdef O_DIRECT
+  /* appended to an unaligned file, or restarted after a padded tail */
+  if ( _direct && ( _offset % BLOCK_ALIGN ) ) {
+    fcntl( _fd, F_SETFL, fcntl( _fd, F_GETFL ) & ~O_DIRECT );
+    _direct = false;
+  }
+
+  /* only the last block can be partial, it is padded and cut off again */
+  if ( _direct && ( len % BLOCK_ALIGN ) ) {
+    len += BLOCK_ALIGN - len % BLOCK_ALIGN;
+    memset( block->data + block->len, 0, len - used );
+  }
+#endif
+
+  size_t done = 0;
+
+  while ( done < len ) {
+    ssize_t ret = pwrite( _fd, data + done, len - done, off_t(_offset + done) );
+
+    if ( ret < 0 ) {
+      if ( EINTR == errno )
+        continue;
+
+      std::cerr << "Writing " << _filename << " failed: " << strerror(errno) << std::endl;
+      return false;
+    }
+
+    done += size_t(ret);
+  }
+
+  _offset += used;
+
+  if ( len != used && ftruncate( _fd, off_t(_offset) ) < 0 )
+    std::cerr << "Truncating " << _filename << " failed: " << strerror(errno) << std::endl;
+
+  return true;
+}
+
+void async_file_sink_c::writer_task()
+{
+  std::unique_lock<std::mutex> lock( _lock );
+
+  while ( true ) {
+    _cond.wait( lock, [this] { return ! _full.empty() || ! _running; } );
+
+    if ( _full.empty() )
+      break;
+
+    block_t *block = _full.front();
+    _full.pop_front();
+
+    lock.unlock();
+
+    if ( ! _trigger_key ) {
+      if ( ! _failed && ! write_block( block ) )
+        _failed = true;
+    } else {
+      /* a failing event is given up, the next one gets a new chance */
+      if ( block->event != _file_event )
+        open_event( block->event );
+
+      if ( _fd >= 0 && ! write_block( block ) ) {
+        ::close( _fd );
+        _fd = -1;
+      }
+
+      if ( block->last && _fd >= 0 ) {
+        ::close( _fd );
+        _fd = -1;
+      }
+    }
+
+    lock.lock();
+    _free.push_back( block );
+  }
+}
+
+void async_file_sink_c::set_sigmf( const std::string &meta, double rate, double freq )
+{
+  _meta = meta;
+  _meta_rate = rate;
+  _meta_freq = freq;
+  _meta_pending = ! meta.empty();
+}
+
+void async_file_sink_c::write_meta()
+{
+  std::chrono::duration<double> now =
+      std::chrono::system_clock::now().time_since_epoch();
+  uint64_t secs = uint64_t( now.count() );
+  double frac = now.count() - secs;
+  double freq = _meta_freq;
+
+  std::vector<gr::tag_t> tags;
+  get_tags_in_range( tags, 0, nitems_read(0), nitems_read(0) + 1 );
+
+  for (const gr::tag_t &tag : tags) {
+    if ( pmt::equal( tag.key, stream_tagger::TIME_KEY() ) ) {
+      secs = pmt::to_uint64( pmt::tuple_ref( tag.value, 0 ) );
+      frac = pmt::to_double( pmt::tuple_ref( tag.value, 1 ) );
+    } else if ( pmt::equal( tag.key, stream_tagger::FREQ_KEY() ) ) {
+      freq = pmt::to_double( tag.value );
+    }
+  }
+
+  try {
+    sigmf_write_meta( _meta, _format, _meta_rate, freq, secs, frac );
+  } catch ( std::runtime_error &e ) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+/* values the quantization will saturate */
+static size_t count_clipped( const float *in, size_t nvalues )
+{
+  size_t clipped = 0;
+
+  for (size_t i = 0; i < nvalues; i++)
+    clipped += ( in[i] > 1.0f ) | ( in[i] < -1.0f );
+
+  return clipped;
+}
+
+/* quantize into the blocks, which go to the writer or the history */
+void async_file_sink_c::store( const gr_complex *in, size_t nitems )
+{
+  while ( nitems ) {
+    if ( ! _current ) {
+      _current = get_block();
+
+      /* rather lose the oldest history than the newest samples */
+      if ( ! _current && ! _recording && ! _history.empty() ) {
+        _current = _history.front();
+        _history.pop_front();
+        _history_bytes -= _current->len;
+        _current->start = 0;
+        _current->len = 0;
+      }
+
+      if ( _current && _finish_pending ) {
+        _finish_pending = false;
+        finish_event();
+        continue;
+      }
+    }
+
+    /* the writer is that far behind, rather drop than stall the radio */
+    if ( ! _current ) {
+      _overruns++;
+      _dropped += nitems;
+      std::cerr << "O" << std::flush;
+
+      if ( _recording ) {
+        _post_left -= std::min( _post_left, uint64_t(nitems) );
+        if ( ! _post_left ) {
+          _recording = false;
+          _finish_pending = true;
+        }
+      }
+      break;
+    }
+
+    size_t n = std::min( nitems, ( BLOCK_SIZE - _current->len ) / _item_size );
+    if ( _recording )
+      n = std::min( uint64_t(n), _post_left );
+
+    char *dst = _current->data + _current->len;
+
+    switch ( _format ) {
+    case FILE_FORMAT_CS16:
+      _clipped += count_clipped( (const float *)in, n * 2 );
+      convert_fc32_sc16( in, (int16_t *)dst, n );
+      break;
+    case FILE_FORMAT_CS8:
+      _clipped += count_clipped( (const float *)in, n * 2 );
+      convert_fc32_sc8( in, (int8_t *)dst, n );
+      break;
+    default:
+      memcpy( dst, in, n * sizeof(gr_complex) );
+      break;
+    }
+
+    _current->len += n * _item_size;
+    in += n;
+    nitems -= n;
+
+    if ( _recording ) {
+      _post_left -= n;
+      if ( ! _post_left ) {
+        _recording = false;
+        finish_event();
+        continue;
+      }
+    }
+
+    if ( BLOCK_SIZE == _current->len ) {
+      if ( ! _trigger_key || _recording ) {
+        _current->event = _event;
+        queue_block( _current );
+      } else {
+        _history.push_back( _current );
+        _history_bytes += _current->len;
+
+        /* what is left has to cover pre samples along with the next block */
+        while ( ! _history.empty() &&
+                _history_bytes - _history.front()->len >= _pre_bytes ) {
+          _history_bytes -= _history.front()->len;
+          recycle_block( _history.front() );
+          _history.pop_front();
+        }
+      }
+      _current = NULL;
+    }
+  }
+}
+
+/* the block being filled closes the event's file */
+void async_file_sink_c::finish_event()
+{
+  _current->event = _event;
+  _current->last = true;
+  queue_block( _current );
+  _current = NULL;
+}
+
+void async_file_sink_c::trigger()
+{
+  if ( _recording || _finish_pending ) {
+    _post_left = _post_items;
+    _recording = _post_left > 0;
+    _finish_pending = false;
+    return;
+  }
+
+  uint64_t total = _history_bytes + ( _current ? _current->len : 0 );
+  uint64_t skip = total > _pre_bytes ? total - _pre_bytes : 0;
+
+  /* keeps the file offsets aligned for O_DIRECT */
+  skip -= skip % BLOCK_ALIGN;
+
+  std::chrono::duration<double> now =
+      std::chrono::system_clock::now().time_since_epoch();
+  double first = now.count();
+  if ( _meta_rate > 0 )
+    first -= ( total - skip ) / _item_size / _meta_rate;
+
+  _event++;
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    event_t event = { _event, uint64_t( first ), first - uint64_t( first ) };
+    _events.push_back( event );
+  }
+
+  while ( ! _history.empty() ) {
+    block_t *block = _history.front();
+    _history.pop_front();
+
+    if ( skip >= block->len ) {
+      skip -= block->len;
+      recycle_block( block );
+      continue;
+    }
+
+    block->start = skip;
+    block->event = _event;
+    skip = 0;
+    queue_block( block );
+  }
+  _history_bytes = 0;
+
+  if ( _current )
+    _current->start = skip;
+
+  _post_left = _post_items;
+  _recording = _post_left > 0;
+
+  if ( ! _recording ) {
+    if ( _current )
+      finish_event();
+    else
+      _finish_pending = true;
+  }
+}
+
+void async_file_sink_c::handle_command( pmt::pmt_t msg )
+{
+  if ( ! _trigger_key )
+    return;
+
+  if ( ( pmt::is_symbol( msg ) && "trigger" == pmt::symbol_to_string( msg ) ) ||
+       ( pmt::is_dict( msg ) && pmt::dict_has_key( msg, pmt::mp("trigger") ) ) )
+    _trigger_msg = true;
+}
+
+int async_file_sink_c::work( int noutput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+
+  if ( _failed )
+    return WORK_DONE;
+
+  if ( _meta_pending ) {
+    write_meta();
+    _meta_pending = false;
+  }
+
+  if ( ! _trigger_key ) {
+    store( in, noutput_items );
+    _samples += noutput_items;
+    return noutput_items;
+  }
+
+  std::vector< uint64_t > triggers;
+
+  if ( _trigger_msg.exchange( false ) )
+    triggers.push_back( 0 );
+
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, nitems_read(0), nitems_read(0) + noutput_items, _trigger_key );
+  for (const gr::tag_t &tag : tags)
+    triggers.push_back( tag.offset - nitems_read(0) );
+
+  std::sort( triggers.begin(), triggers.end() );
+
+  uint64_t done = 0;
+  for (uint64_t at : triggers) {
+    store( in + done, at - done );
+    done = at;
+    trigger();
+  }
+  store( in + done, noutput_items - done );
+
+  _samples += noutput_items;
+
+  return noutput_items;
+}
+
+osmosdr::stream_stats_t async_file_sink_c::get_stream_stats() const
+{
+  osmosdr::stream_stats_t stats;
+
+  stats.samples = _samples;
+  stats.dropped = _dropped;
+  stats.overruns = _overruns;
+  stats.clipped = _clipped;
+  stats.capacity = _blocks.size() * ( BLOCK_SIZE / _item_size );
+
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+    stats.fill = _full.size() * ( BLOCK_SIZE / _item_size );
+    stats.fill_max = _full_max * ( BLOCK_SIZE / _item_size );
+  }
+
+  return stats;
+}
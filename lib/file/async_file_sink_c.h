@@ -0,0 +1,183 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef ASYNC_FILE_SINK_C_H
+#define ASYNC_FILE_SINK_C_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include "osmosdr/stream_stats.h"
+#include "file_format.h"
+
+class async_file_sink_c;
+
+typedef std::shared_ptr< async_file_sink_c > async_file_sink_c_sptr;
+
+async_file_sink_c_sptr make_async_file_sink_c(const std::string &filename,
+                                              file_format_t format,
+                                              bool append,
+                                              size_t buffer_size,
+                                              bool direct,
+                                              const std::string &trigger = "",
+                                              uint64_t pre = 0,
+                                              uint64_t post = 0);
+
+/*!
+ * Records complex float samples in place of gr::blocks::file_sink, with
+ * the disk writes done by a thread of its own.
+ *
+ * work() quantizes the samples into the file's format straight into one
+ * of a pool of large, page aligned blocks and hands every full block to
+ * the writer thread. The pool holds \p buffer_size bytes, which is how
+ * long a filesystem stall may last before samples are dropped ("O") -
+ * the flowgraph and the radio upstream never wait for the disk.
+ *
+ * With \p direct the file is opened with O_DIRECT so the recording does
+ * not push everything else out of the page cache.
+ *
+ * Given a \p trigger tag key the sink records events instead of the
+ * whole stream. The blocks of the last \p pre samples are kept in memory
+ * and on a trigger - a tag with that key, or a "trigger" message on the
+ * command port - they are written along with the next \p post samples
+ * to a file of their own, numbered after \p filename. A trigger during
+ * an event extends it.
+ */
+class async_file_sink_c : public gr::sync_block
+{
+private:
+  friend async_file_sink_c_sptr make_async_file_sink_c(const std::string &filename,
+                                                       file_format_t format,
+                                                       bool append,
+                                                       size_t buffer_size,
+                                                       bool direct,
+                                                       const std::string &trigger,
+                                                       uint64_t pre,
+                                                       uint64_t post);
+
+  async_file_sink_c(const std::string &filename, file_format_t format,
+                    bool append, size_t buffer_size, bool direct,
+                    const std::string &trigger, uint64_t pre, uint64_t post);
+
+public:
+  ~async_file_sink_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  osmosdr::stream_stats_t get_stream_stats() const;
+
+  /*!
+   * Write a SigMF metadata file next to the recording once the first
+   * sample arrives. Its time and frequency come from rx_time and rx_freq
+   * tags on that sample if there are any, from the host clock and \p freq
+   * otherwise.
+   */
+  void set_sigmf( const std::string &meta, double rate, double freq );
+
+private:
+  struct block_t
+  {
+    char *data;
+    size_t start;               // bytes at the front not to be written
+    size_t len;                 // bytes used
+    uint64_t event;             // file the block belongs to, 0 without trigger
+    bool last;                  // closes the event's file
+  };
+
+  struct event_t
+  {
+    uint64_t id;
+    uint64_t secs;              // host time of the first sample
+    double frac;
+  };
+
+  bool open_file( const std::string &filename, bool append );
+  void open_event( uint64_t id );
+  void writer_task();
+  bool write_block( block_t *block );
+  block_t *get_block();
+  void queue_block( block_t *block );
+  void recycle_block( block_t *block );
+  void write_meta();
+  void store( const gr_complex *in, size_t nitems );
+  void trigger();
+  void finish_event();
+  void handle_command( pmt::pmt_t msg );
+
+  int _fd;
+  std::string _filename;
+  file_format_t _format;
+  size_t _item_size;
+  bool _direct_wanted;
+  bool _direct;
+  uint64_t _offset;             // where the next block goes in the file
+
+  std::vector< block_t > _blocks;
+  block_t *_current;            // being filled by work()
+
+  mutable std::mutex _lock;
+  std::condition_variable _cond;
+  std::deque< block_t * > _free;
+  std::deque< block_t * > _full;
+  size_t _full_max;
+  bool _running;
+  gr::thread::thread _thread;
+
+  std::string _meta;            // SigMF sidecar, empty for none
+  double _meta_rate;
+  double _meta_freq;
+  bool _meta_pending;
+
+  /* event recording, work() side */
+  pmt::pmt_t _trigger_key;      // null without trigger
+  uint64_t _pre_bytes;
+  uint64_t _post_items;
+  std::deque< block_t * > _history;
+  uint64_t _history_bytes;
+  uint64_t _event;              // last event started
+  bool _recording;
+  uint64_t _post_left;
+  bool _finish_pending;         // event ended while samples were dropped
+  std::atomic<bool> _trigger_msg;
+
+  /* event recording, writer side */
+  std::deque< event_t > _events;
+  uint64_t _file_event;         // event the open file belongs to
+
+  std::atomic<uint64_t> _samples;
+  std::atomic<uint64_t> _dropped;
+  std::atomic<uint64_t> _overruns;
+  std::atomic<uint64_t> _clipped;
+  std::atomic<bool> _failed;    // a write failed, stop taking samples
+};
+
+#endif // ASYNC_FILE_SINK_C_H
@@ -0,0 +1,48 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "backend_registry.h"
+#include "file_source_c.h"
+#include "file_sink_c.h"
+
+static backend_t file_backend()
+{
+  backend_t backend;
+
+  backend.name = "file";
+  backend.order = 160;
+  backend.fakes = true;
+
+  backend.source_devices = []( bool fake ) { return file_source_c::get_devices( fake ); };
+  backend.make_source = []( const std::string &args ) -> backend_t::source_t {
+    file_source_c_sptr src = make_file_source_c( args );
+    return backend_t::source_t{ src, src.get() };
+  };
+
+  backend.sink_devices = []( bool fake ) { return file_sink_c::get_devices( fake ); };
+  backend.make_sink = []( const std::string &args ) -> backend_t::sink_t {
+    file_sink_c_sptr sink = make_file_sink_c( args );
+    return backend_t::sink_t{ sink, sink.get() };
+  };
+
+  return backend;
+}
+
+static backend_registrar registrar( file_backend() );
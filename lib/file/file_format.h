@@ -0,0 +1,63 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FILE_FORMAT_H
+#define FILE_FORMAT_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <gnuradio/gr_complex.h>
+
+/* sample formats of the IQ files, interleaved I/Q in host byte order */
+enum file_format_t
+{
+  FILE_FORMAT_CF32,
+  FILE_FORMAT_CS16,
+  FILE_FORMAT_CS8,
+  FILE_FORMAT_CU8
+};
+
+inline file_format_t file_format_from_string( const std::string &format )
+{
+  if ( "cf32" == format )
+    return FILE_FORMAT_CF32;
+  if ( "cs16" == format )
+    return FILE_FORMAT_CS16;
+  if ( "cs8" == format )
+    return FILE_FORMAT_CS8;
+  if ( "cu8" == format )
+    return FILE_FORMAT_CU8;
+
+  throw std::runtime_error("Sample format must be cf32, cs16, cs8 or cu8.");
+}
+
+/* bytes per complex sample */
+inline size_t file_format_size( file_format_t format )
+{
+  switch ( format ) {
+  case FILE_FORMAT_CS16: return 2 * sizeof(short);
+  case FILE_FORMAT_CS8:
+  case FILE_FORMAT_CU8:  return 2;
+  default:               return sizeof(gr_complex);
+  }
+}
+
+#endif // FILE_FORMAT_H
@@ -30,6 +30,9 @@
 #include "file_sink_c.h"
 
 #include "arg_helpers.h"
+#include "sigmf.h"
+
+#define RING_SIZE (256 << 20) // bytes buffered for the writer thread
 
 using namespace boost::assign;
 
@@ -46,6 +49,12 @@ file_sink_c::file_sink_c(const std::string &args) :
   std::string filename;
   bool append = false;
   bool throttle = false;
+  bool async = true;
+  bool direct = false;
+  size_t ring_size = RING_SIZE;
+  file_format_t format = FILE_FORMAT_CF32;
+  std::string trigger;
+  double pre = 0, post = 0;
   _freq = 0;
   _rate = 0;
 
@@ -66,6 +75,30 @@ file_sink_c::file_sink_c(const std::string &args) :
   if (dict.count("append"))
     append = ("true" == dict["append"] ? true : false);
 
+  if (dict.count("async"))
+    async = ("true" == dict["async"] ? true : false);
+
+  if (dict.count("direct"))
+    direct = ("true" == dict["direct"] ? true : false);
+
+  if (dict.count("ring_size"))
+    ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
+  if (dict.count("format"))
+    format = file_format_from_string( dict["format"] );
+
+  if (dict.count("pre"))
+    pre = boost::lexical_cast< double >( dict["pre"] );
+
+  if (dict.count("post"))
+    post = boost::lexical_cast< double >( dict["post"] );
+
+  /* given pre or post seconds, only the events around triggers are recorded */
+  if (dict.count("trigger"))
+    trigger = dict["trigger"];
+  else if (dict.count("pre") || dict.count("post"))
+    trigger = "trigger";
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
@@ -75,20 +108,61 @@ file_sink_c::file_sink_c(const std::string &args) :
   if (0 == _rate && throttle)
     throw std::runtime_error("Parameter 'rate' is missing in arguments.");
 
+  if (trigger.length() && (0 == _rate || pre < 0 || post < 0))
+    throw std::runtime_error("Recording on triggers needs 'rate' and non-negative 'pre'/'post'.");
+
   _file_rate = _rate;
 
-  _sink = gr::blocks::file_sink::make( sizeof(gr_complex),
-                                           filename.c_str(),
-                                           append);
+  /* a SigMF recording gets its metadata written next to it */
+  std::string data_file, meta_file;
+  bool sigmf = sigmf_split_path( filename, data_file, meta_file );
+  if (sigmf)
+    filename = data_file;
+
+  gr::basic_block_sptr sink;
+
+#ifndef _WIN32
+  if (async) {
+    _async_sink = make_async_file_sink_c( filename, format, append, ring_size, direct,
+                                          trigger,
+                                          uint64_t( pre * _rate ),
+                                          uint64_t( post * _rate ) );
+
+    /* appending continues a recording, whose metadata stays as it is */
+    if (sigmf && !(append && std::ifstream( meta_file.c_str() )))
+      _async_sink->set_sigmf( meta_file, _rate, _freq );
+
+    sink = _async_sink;
+  }
+#endif
+
+  if (!sink) {
+    if (FILE_FORMAT_CF32 != format || sigmf || trigger.length())
+      throw std::runtime_error("Sample formats other than cf32, SigMF and triggers require async=true.");
+
+    _sink = gr::blocks::file_sink::make( sizeof(gr_complex),
+                                             filename.c_str(),
+                                             append);
+    sink = _sink;
+  }
 
   _throttle = gr::blocks::throttle::make( sizeof(gr_complex), _file_rate );
 
   if (throttle) {
     connect( self(), 0, _throttle, 0 );
-    connect( _throttle, 0, _sink, 0 );
+    connect( _throttle, 0, sink, 0 );
   } else {
-    connect( self(), 0, _sink, 0 );
+    connect( self(), 0, sink, 0 );
   }
+
+#ifndef _WIN32
+  if (trigger.length()) {
+    message_port_register_hier_in( pmt::mp("command") );
+    msg_connect( self(), pmt::mp("command"), _async_sink, pmt::mp("command") );
+  }
+#endif
+
+  _trigger = !trigger.empty();
 }
 
 file_sink_c::~file_sink_c()
@@ -107,7 +181,7 @@ std::vector<std::string> file_sink_c::get_devices( bool fake )
   if ( fake )
   {
     std::string args = "file='/path/to/your/file'";
-    args += ",rate=1e6,freq=100e6,throttle=true";
+    args += ",rate=1e6,freq=100e6,throttle=true,async=true";
     args += ",label='Complex Sampled (IQ) File'";
     devices.push_back( args );
   }
@@ -224,3 +298,18 @@ std::string file_sink_c::get_antenna( size_t chan )
 {
   return "";
 }
+
+bool file_sink_c::has_trigger()
+{
+  return _trigger;
+}
+
+osmosdr::stream_stats_t file_sink_c::get_stream_stats( size_t chan )
+{
+#ifndef _WIN32
+  if ( _async_sink )
+    return _async_sink->get_stream_stats();
+#endif
+
+  return osmosdr::stream_stats_t();
+}
@@ -26,6 +26,10 @@
 
 #include "sink_iface.h"
 
+#ifndef _WIN32
+#include "async_file_sink_c.h"
+#endif
+
 class file_sink_c;
 
 typedef std::shared_ptr< file_sink_c > file_sink_c_sptr;
@@ -72,11 +76,20 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  /*! records events, triggered through the "command" message port too */
+  bool has_trigger();
+
 private:
   gr::blocks::file_sink::sptr _sink;
+#ifndef _WIN32
+  async_file_sink_c_sptr _async_sink;
+#endif
   gr::blocks::throttle::sptr _throttle;
   double _file_rate;
   double _freq, _rate;
+  bool _trigger;
 };
 
 #endif // FILE_SINK_C_H
@@ -30,6 +30,22 @@
 #include "file_source_c.h"
 
 #include "arg_helpers.h"
+#include "sigmf.h"
+
+#ifndef _WIN32
+/* transfer sizes and counts the backends use by default */
+static const struct {
+  const char *name;
+  size_t chunk;                 // samples
+  size_t buffers;
+} emulation_presets[] = {
+  { "rtl",     16 * 32 * 512 / 2, 15 },
+  { "hackrf",  16 * 32 * 512 / 2, 15 },
+  { "airspy",  65536,             16 },
+  { "bladerf", 4096,              32 },
+  { "uhd",     2000,              32 },
+};
+#endif
 
 using namespace boost::assign;
 
@@ -46,6 +62,11 @@ file_source_c::file_source_c(const std::string &args) :
   std::string filename;
   bool repeat = true;
   bool throttle = true;
+  bool mmap = true;
+  bool hugepages = false;
+  file_format_t format = FILE_FORMAT_CF32;
+  sigmf_meta_t meta;
+  bool sigmf = false;
   _freq = 0;
   _rate = 0;
 
@@ -54,6 +75,21 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("file"))
     filename = dict["file"];
 
+  /* a SigMF recording provides the defaults for the arguments below */
+  std::string data_file, meta_file;
+  if (sigmf_split_path( filename, data_file, meta_file )) {
+    meta = sigmf_read_meta( meta_file );
+    filename = data_file;
+    format = meta.format;
+    _rate = meta.sample_rate;
+    for (const sigmf_capture_t &capture : meta.captures)
+      if (capture.has_frequency) {
+        _freq = capture.frequency;
+        break;
+      }
+    sigmf = true;
+  }
+
   if (dict.count("freq"))
     _freq = boost::lexical_cast< double >( dict["freq"] );
 
@@ -66,6 +102,59 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("throttle"))
     throttle = ("true" == dict["throttle"] ? true : false);
 
+  if (dict.count("mmap"))
+    mmap = ("true" == dict["mmap"] ? true : false);
+
+  if (dict.count("hugepages"))
+    hugepages = ("true" == dict["hugepages"] ? true : false);
+
+  if (dict.count("format"))
+    format = file_format_from_string( dict["format"] );
+
+#ifndef _WIN32
+  /* replay with the transfer size and timing of a backend */
+  bool emulate = false;
+  mmap_file_source_c::emulation_t emulation = { 0, 0, 0, 0, 0, 0 };
+
+  if (dict.count("emulate")) {
+    for (const auto &preset : emulation_presets)
+      if (dict["emulate"] == preset.name) {
+        emulation.chunk = preset.chunk;
+        emulation.buffers = preset.buffers;
+      }
+
+    if (!emulation.chunk)
+      throw std::runtime_error("Emulation must be one of rtl, hackrf, airspy, bladerf or uhd.");
+
+    emulate = true;
+  }
+
+  if (dict.count("chunk")) {
+    emulation.chunk = boost::lexical_cast< size_t >( dict["chunk"] );
+    emulation.buffers = emulation.buffers ? emulation.buffers : 16;
+    emulate = true;
+  }
+
+  if (dict.count("buffers"))
+    emulation.buffers = boost::lexical_cast< size_t >( dict["buffers"] );
+
+  if (dict.count("jitter"))
+    emulation.jitter = boost::lexical_cast< double >( dict["jitter"] ) * 1e-6;
+
+  if (dict.count("drop"))
+    emulation.drop = boost::lexical_cast< double >( dict["drop"] );
+
+  if (dict.count("seed"))
+    emulation.seed = boost::lexical_cast< unsigned int >( dict["seed"] );
+
+  /* the chunks are paced by the emulation, the throttle is not needed */
+  if (emulate) {
+    if (!mmap)
+      throw std::runtime_error("Emulation requires mmap=true.");
+    throttle = false;
+  }
+#endif
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
@@ -77,17 +166,40 @@ file_source_c::file_source_c(const std::string &args) :
 
   _file_rate = _rate;
 
-  _source = gr::blocks::file_source::make( sizeof(gr_complex),
-                                           filename.c_str(),
-                                           repeat );
+  gr::basic_block_sptr source;
+
+#ifndef _WIN32
+  if (mmap) {
+    _mmap_source = make_mmap_file_source_c( filename, format, repeat, hugepages );
+    if (sigmf)
+      _mmap_source->set_captures( meta.captures, _rate );
+    if (emulate) {
+      if (0 == _rate)
+        throw std::runtime_error("Parameter 'rate' is missing in arguments.");
+      emulation.rate = _rate;
+      _mmap_source->set_emulation( emulation );
+    }
+    source = _mmap_source;
+  }
+#endif
+
+  if (!source) {
+    if (FILE_FORMAT_CF32 != format)
+      throw std::runtime_error("Sample formats other than cf32 require mmap=true.");
+
+    _source = gr::blocks::file_source::make( sizeof(gr_complex),
+                                             filename.c_str(),
+                                             repeat );
+    source = _source;
+  }
 
   _throttle = gr::blocks::throttle::make( sizeof(gr_complex), _file_rate );
 
   if (throttle) {
-    connect( _source, 0, _throttle, 0 );
+    connect( source, 0, _throttle, 0 );
     connect( _throttle, 0, self(), 0 );
   } else {
-    connect( _source, 0, self(), 0 );
+    connect( source, 0, self(), 0 );
   }
 }
 
@@ -107,7 +219,7 @@ std::vector<std::string> file_source_c::get_devices( bool fake )
   if ( fake )
   {
     std::string args = "file='/path/to/your/file'";
-    args += ",rate=1e6,freq=100e6,repeat=true,throttle=true";
+    args += ",rate=1e6,freq=100e6,repeat=true,throttle=true,mmap=true";
     args += ",label='Complex Sampled (IQ) File'";
     devices.push_back( args );
   }
@@ -122,7 +234,12 @@ size_t file_source_c::get_num_channels( void )
 
 bool file_source_c::seek( long seek_point, int whence , size_t chan )
 {
-    return _source->seek( seek_point, whence );
+#ifndef _WIN32
+  if ( _mmap_source )
+    return _mmap_source->seek( seek_point, whence );
+#endif
+
+  return _source->seek( seek_point, whence );
 }
 
 osmosdr::meta_range_t file_source_c::get_sample_rates( void )
@@ -229,3 +346,13 @@ std::string file_source_c::get_antenna( size_t chan )
 {
   return "";
 }
+
+osmosdr::stream_stats_t file_source_c::get_stream_stats( size_t chan )
+{
+#ifndef _WIN32
+  if ( _mmap_source )
+    return _mmap_source->get_stream_stats();
+#endif
+
+  return osmosdr::stream_stats_t();
+}
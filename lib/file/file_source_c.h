@@ -26,6 +26,10 @@
 
 #include "source_iface.h"
 
+#ifndef _WIN32
+#include "mmap_file_source_c.h"
+#endif
+
 class file_source_c;
 
 typedef std::shared_ptr< file_source_c > file_source_c_sptr;
@@ -74,8 +78,13 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   gr::blocks::file_source::sptr _source;
+#ifndef _WIN32
+  mmap_file_source_c_sptr _mmap_source;
+#endif
   gr::blocks::throttle::sptr _throttle;
   double _file_rate;
   double _freq, _rate;
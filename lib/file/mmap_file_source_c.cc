@@ -0,0 +1,488 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "mmap_file_source_c.h"
+#include "sample_convert.h"
+#include "stream_tagger.h"
+#include "tick_time.h"
+
+#define READ_AHEAD_BYTES (64 << 20) // faulted in ahead of the read position
+
+#define CS16_SCALE (1.0f / 32768.0f)
+
+mmap_file_source_c_sptr make_mmap_file_source_c(const std::string &filename,
+                                                file_format_t format,
+                                                bool repeat,
+                                                bool hugepages)
+{
+  return gnuradio::get_initial_sptr(new mmap_file_source_c(filename, format,
+                                                           repeat, hugepages));
+}
+
+mmap_file_source_c::mmap_file_source_c(const std::string &filename,
+                                       file_format_t format,
+                                       bool repeat,
+                                       bool hugepages) :
+  gr::sync_block("mmap_file_source_c",
+                 gr::io_signature::make(0, 0, 0),
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _map(NULL),
+  _map_size(0),
+  _format(format),
+  _item_size(file_format_size(format)),
+  _nitems(0),
+  _repeat(repeat),
+  _rate(0),
+  _next_capture(0),
+  _tag_pos(false),
+  _pos(0),
+  _advised(0),
+  _emulate(false),
+  _ring_written(0),
+  _ring_read(0),
+  _running(false),
+  _samples(0),
+  _dropped(0),
+  _overruns(0)
+{
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    throw std::runtime_error( "Failed to open " + filename + ": " + strerror(errno) );
+
+  struct stat st;
+  if ( fstat( fd, &st ) < 0 ) {
+    int err = errno;
+    ::close( fd );
+    throw std::runtime_error( "Failed to stat " + filename + ": " + strerror(err) );
+  }
+
+  _nitems = uint64_t(st.st_size) / _item_size;
+  if ( 0 == _nitems ) {
+    ::close( fd );
+    throw std::runtime_error( "File " + filename + " holds no samples." );
+  }
+
+  _map_size = size_t(st.st_size);
+
+  void *map = mmap( NULL, _map_size, PROT_READ, MAP_SHARED, fd, 0 );
+  int err = errno;
+
+  /* the mapping keeps its own reference to the file */
+  ::close( fd );
+
+  if ( MAP_FAILED == map )
+    throw std::runtime_error( "Failed to map " + filename + ": " + strerror(err) );
+
+  _map = (const char *)map;
+
+  madvise( map, _map_size, MADV_SEQUENTIAL );
+
+  if ( hugepages ) {
+#ifdef MADV_HUGEPAGE
+    if ( madvise( map, _map_size, MADV_HUGEPAGE ) < 0 )
+      std::cerr << "Huge pages are not available for " << filename << ": "
+                << strerror(errno) << std::endl;
+#else
+    std::cerr << "Huge pages are not supported on this system." << std::endl;
+#endif
+  }
+
+  read_ahead();
+}
+
+mmap_file_source_c::~mmap_file_source_c()
+{
+  stop();
+
+  if ( _map )
+    munmap( (void *)_map, _map_size );
+}
+
+/* Ask for the next window once half of the previous one has been read,
+ * so the disk stays busy while work() copies out of resident pages. */
+void mmap_file_source_c::read_ahead()
+{
+  const uint64_t window = READ_AHEAD_BYTES / _item_size;
+
+  if ( _advised > _pos + window / 2 || _advised >= _nitems )
+    return;
+
+  static const uint64_t page = sysconf( _SC_PAGESIZE );
+
+  uint64_t begin = std::max( _advised, _pos ) * _item_size;
+  uint64_t end = std::min( _pos + window, _nitems ) * _item_size;
+
+  begin -= begin % page;
+
+  madvise( (char *)_map + begin, end - begin, MADV_WILLNEED );
+
+  _advised = end / _item_size;
+}
+
+void mmap_file_source_c::set_captures( const std::vector< sigmf_capture_t > &captures,
+                                       double rate )
+{
+  std::lock_guard<std::mutex> lock( _pos_lock );
+
+  _captures = captures;
+  _rate = rate;
+  _next_capture = 0;
+  _tag_pos = false;
+}
+
+/* tags for sample pos of the file, which lies in the given segment */
+static gr::tag_t make_tag( uint64_t offset, const pmt::pmt_t &key, const pmt::pmt_t &value )
+{
+  gr::tag_t tag;
+
+  tag.offset = offset;
+  tag.key = key;
+  tag.value = value;
+
+  return tag;
+}
+
+void mmap_file_source_c::add_capture_tags( const sigmf_capture_t &capture,
+                                           uint64_t pos, uint64_t offset,
+                                           std::vector< gr::tag_t > &tags )
+{
+  if ( capture.has_time ) {
+    pmt::pmt_t time = pmt::make_tuple( pmt::from_uint64( capture.secs ),
+                                       pmt::from_double( capture.frac ) );
+
+    if ( _rate > 0 )
+      time = ( tick_time_t::from_secs( capture.secs, capture.frac, _rate ) +
+               int64_t( pos - capture.sample_start ) ).to_rx_time();
+
+    tags.push_back( make_tag( offset, stream_tagger::TIME_KEY(), time ) );
+
+    if ( _rate > 0 )
+      tags.push_back( make_tag( offset, stream_tagger::RATE_KEY(),
+                                pmt::from_double( _rate ) ) );
+  }
+
+  if ( capture.has_frequency )
+    tags.push_back( make_tag( offset, stream_tagger::FREQ_KEY(),
+                              pmt::from_double( capture.frequency ) ) );
+}
+
+bool mmap_file_source_c::seek( int64_t seek_point, int whence )
+{
+  std::lock_guard<std::mutex> lock( _pos_lock );
+
+  int64_t pos;
+
+  switch ( whence ) {
+  case SEEK_SET: pos = seek_point; break;
+  case SEEK_CUR: pos = int64_t(_pos) + seek_point; break;
+  case SEEK_END: pos = int64_t(_nitems) + seek_point; break;
+  default:
+    std::cerr << "seek: invalid whence " << whence << std::endl;
+    return false;
+  }
+
+  if ( pos < 0 || uint64_t(pos) > _nitems ) {
+    std::cerr << "seek: outside of the file" << std::endl;
+    return false;
+  }
+
+  set_pos( uint64_t(pos) );
+
+  return true;
+}
+
+void mmap_file_source_c::set_pos( uint64_t pos )
+{
+  _pos = pos;
+  _advised = _pos;
+  read_ahead();
+
+  _next_capture = 0;
+  while ( _next_capture < _captures.size() &&
+          _captures[_next_capture].sample_start < _pos )
+    _next_capture++;
+
+  _tag_pos = ( _next_capture > 0 );
+}
+
+/* convert up to nitems samples, tags get offsets counted from offset */
+size_t mmap_file_source_c::read( gr_complex *out, size_t nitems, uint64_t offset,
+                                 std::vector< gr::tag_t > &tags )
+{
+  size_t produced = 0;
+
+  while ( produced < nitems ) {
+    if ( _pos >= _nitems ) {
+      if ( ! _repeat )
+        break;
+
+      _pos = 0;
+      _advised = 0;
+      _next_capture = 0;
+      _tag_pos = false;
+    }
+
+    read_ahead();
+
+    size_t n = std::min( uint64_t(nitems - produced), _nitems - _pos );
+    const char *in = _map + _pos * _item_size;
+
+    switch ( _format ) {
+    case FILE_FORMAT_CS16:
+      convert_s16_fc32( (const int16_t *)in, out + produced, n, CS16_SCALE );
+      break;
+    case FILE_FORMAT_CS8:
+      convert_s8_fc32( (const int8_t *)in, out + produced, n );
+      break;
+    case FILE_FORMAT_CU8:
+      convert_u8_fc32( (const uint8_t *)in, out + produced, n );
+      break;
+    default:
+      memcpy( out + produced, in, n * sizeof(gr_complex) );
+      break;
+    }
+
+    const uint64_t at = offset + produced;
+
+    if ( _tag_pos ) {
+      add_capture_tags( _captures[_next_capture - 1], _pos, at, tags );
+      _tag_pos = false;
+    }
+
+    while ( _next_capture < _captures.size() &&
+            _captures[_next_capture].sample_start < _pos + n ) {
+      const sigmf_capture_t &capture = _captures[_next_capture++];
+      add_capture_tags( capture, capture.sample_start,
+                        at + (capture.sample_start - _pos), tags );
+    }
+
+    _pos += n;
+    produced += n;
+  }
+
+  return produced;
+}
+
+void mmap_file_source_c::set_emulation( const emulation_t &emulation )
+{
+  if ( emulation.rate <= 0 || 0 == emulation.chunk || 0 == emulation.buffers )
+    throw std::runtime_error("Emulation needs a sample rate, chunk size and buffer count.");
+
+  _emulation = emulation;
+  _emulate = true;
+}
+
+bool mmap_file_source_c::start()
+{
+  if ( ! _emulate || _running )
+    return true;
+
+  _ring.resize( _emulation.chunk * _emulation.buffers );
+  _ring_tags.clear();
+  _ring_written = 0;
+  _ring_read = 0;
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &mmap_file_source_c::emulate_task, this ) );
+
+  return true;
+}
+
+bool mmap_file_source_c::stop()
+{
+  _running = false;
+  _ring.close();
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+/* Chunk k is due k chunk durations after the start, plus a lateness drawn
+ * from the jitter. A late chunk holds back the ones behind it, which then
+ * arrive in a burst, like transfers queued up in the USB stack do. */
+void mmap_file_source_c::emulate_task()
+{
+  typedef std::chrono::steady_clock clock;
+
+  const emulation_t &emu = _emulation;
+  const std::chrono::duration<double> interval( emu.chunk / emu.rate );
+
+  std::mt19937 rng( emu.seed );
+  std::normal_distribution<double> late( 0.0, emu.jitter > 0 ? emu.jitter : 1.0 );
+  std::uniform_real_distribution<double> lose( 0.0, 1.0 );
+
+  const clock::time_point t0 = clock::now();
+  clock::time_point last = t0;
+  std::vector< gr::tag_t > tags;
+
+  for (uint64_t k = 1; _running; k++) {
+    std::chrono::duration<double> due = interval * double(k);
+    if ( emu.jitter > 0 )
+      due += std::chrono::duration<double>( std::fabs( late( rng ) ) );
+
+    clock::time_point at = t0 + std::chrono::duration_cast<clock::duration>( due );
+    last = std::max( last, at );
+
+    /* in slices, so stop() doesn't wait for a long chunk */
+    for (clock::time_point now = clock::now(); _running && now < last; now = clock::now())
+      std::this_thread::sleep_for( std::min< clock::duration >( last - now,
+                                                                std::chrono::milliseconds(100) ) );
+
+    if ( ! _running )
+      break;
+
+    bool eof = false;
+    bool lost = ( emu.drop > 0 && lose( rng ) < emu.drop ) ||
+                _ring.space() < emu.chunk;
+
+    tags.clear();
+    {
+      std::lock_guard<std::mutex> lock( _pos_lock );
+
+      if ( lost ) {
+        /* the samples of the chunk are gone, as if the host missed them */
+        uint64_t pos = _pos + emu.chunk;
+        if ( pos >= _nitems )
+          pos = _repeat ? pos % _nitems : _nitems;
+        eof = ( pos >= _nitems );
+        set_pos( pos );
+      } else {
+        size_t left = emu.chunk;
+
+        while ( left ) {
+          size_t count;
+          gr_complex *buf = _ring.write_ptr( count );
+          size_t n = read( buf, std::min( count, left ), _ring_written, tags );
+
+          _ring.commit( n );
+          _ring_written += n;
+          _samples += n;
+          left -= n;
+
+          if ( ! n ) {
+            eof = true;
+            break;
+          }
+        }
+      }
+    }
+
+    if ( lost ) {
+      _overruns++;
+      _dropped += emu.chunk;
+      std::cerr << "O" << std::flush;
+    }
+
+    if ( ! tags.empty() ) {
+      std::lock_guard<std::mutex> lock( _tags_lock );
+      _ring_tags.insert( _ring_tags.end(), tags.begin(), tags.end() );
+    }
+
+    if ( eof ) {
+      _ring.close();
+      break;
+    }
+  }
+}
+
+int mmap_file_source_c::work( int noutput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  std::vector< gr::tag_t > tags;
+  size_t produced;
+
+  if ( ! _emulate ) {
+    {
+      std::lock_guard<std::mutex> lock( _pos_lock );
+      produced = read( out, noutput_items, nitems_written(0), tags );
+    }
+
+    _samples += produced;
+
+    for (const gr::tag_t &tag : tags)
+      add_item_tag( 0, tag.offset, tag.key, tag.value, alias_pmt() );
+
+    if ( ! produced )
+      return WORK_DONE;
+
+    return produced;
+  }
+
+  while ( ! _ring.wait_for( 1, std::chrono::milliseconds(100) ) )
+    if ( ! _running )
+      return WORK_DONE;
+
+  produced = _ring.pop( out, noutput_items );
+  if ( ! produced )
+    return WORK_DONE;
+
+  {
+    std::lock_guard<std::mutex> lock( _tags_lock );
+
+    while ( ! _ring_tags.empty() && _ring_tags.front().offset < _ring_read + produced ) {
+      const gr::tag_t &tag = _ring_tags.front();
+      add_item_tag( 0, nitems_written(0) + ( tag.offset - _ring_read ),
+                    tag.key, tag.value, alias_pmt() );
+      _ring_tags.pop_front();
+    }
+  }
+
+  _ring_read += produced;
+
+  return produced;
+}
+
+osmosdr::stream_stats_t mmap_file_source_c::get_stream_stats() const
+{
+  osmosdr::stream_stats_t stats;
+
+  stats.samples = _samples;
+  stats.dropped = _dropped;
+  stats.overruns = _overruns;
+  stats.fill = _ring.size();
+  stats.fill_max = _ring.fill_max();
+  stats.capacity = _ring.capacity();
+
+  return stats;
+}
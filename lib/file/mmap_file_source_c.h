@@ -0,0 +1,151 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef MMAP_FILE_SOURCE_C_H
+#define MMAP_FILE_SOURCE_C_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include "osmosdr/stream_stats.h"
+#include "file_format.h"
+#include "sigmf.h"
+#include "spsc_ring.h"
+
+class mmap_file_source_c;
+
+typedef std::shared_ptr< mmap_file_source_c > mmap_file_source_c_sptr;
+
+mmap_file_source_c_sptr make_mmap_file_source_c(const std::string &filename,
+                                                file_format_t format,
+                                                bool repeat,
+                                                bool hugepages);
+
+/*!
+ * Reads IQ samples out of a read-only mapping of the file, in place of
+ * gr::blocks::file_source.
+ *
+ * Samples go from the page cache straight into the output buffer, there
+ * is no read() into an intermediate buffer. The compact formats are
+ * converted to complex float on the way with the shared SIMD kernels.
+ * The whole file is mapped, the kernel is told the access is sequential
+ * and is asked to fault in a window ahead of the read position, which
+ * follows seeks. With \p hugepages the mapping is backed by transparent
+ * huge pages where the kernel and filesystem support it.
+ *
+ * With set_emulation() the samples are instead delivered the way a radio
+ * backend does it: a thread of its own puts them into a ring in chunks
+ * of the backend's transfer size, at the pace of the sample rate with
+ * some jitter, and work() takes them out of the ring. A chunk which does
+ * not fit, or is picked to be lost, counts as an overrun ("O").
+ */
+class mmap_file_source_c : public gr::sync_block
+{
+private:
+  friend mmap_file_source_c_sptr make_mmap_file_source_c(const std::string &filename,
+                                                         file_format_t format,
+                                                         bool repeat,
+                                                         bool hugepages);
+
+  mmap_file_source_c(const std::string &filename, file_format_t format,
+                     bool repeat, bool hugepages);
+
+public:
+  ~mmap_file_source_c();
+
+  /*! same semantics as gr::blocks::file_source::seek, in samples */
+  bool seek( int64_t seek_point, int whence );
+
+  /*!
+   * Emit rx_time, rx_rate and rx_freq tags where each capture segment
+   * starts, and for the segment a seek lands in.
+   */
+  void set_captures( const std::vector< sigmf_capture_t > &captures, double rate );
+
+  struct emulation_t
+  {
+    double rate;                // samples per second
+    size_t chunk;               // samples per transfer
+    size_t buffers;             // transfers the ring holds
+    double jitter;              // standard deviation of the lateness, seconds
+    double drop;                // probability a transfer is lost
+    unsigned int seed;          // makes runs with jitter and drops repeatable
+  };
+
+  /*! replay with the timing of a radio, call before the flowgraph starts */
+  void set_emulation( const emulation_t &emulation );
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  osmosdr::stream_stats_t get_stream_stats() const;
+
+private:
+  void read_ahead();
+  void set_pos( uint64_t pos );
+  size_t read( gr_complex *out, size_t nitems, uint64_t offset,
+               std::vector< gr::tag_t > &tags );
+  void add_capture_tags( const sigmf_capture_t &capture, uint64_t pos, uint64_t offset,
+                         std::vector< gr::tag_t > &tags );
+  void emulate_task();
+
+  const char *_map;
+  size_t _map_size;             // bytes
+  file_format_t _format;
+  size_t _item_size;            // bytes per sample in the file
+  uint64_t _nitems;             // whole samples in the file
+  bool _repeat;
+
+  std::vector< sigmf_capture_t > _captures;
+  double _rate;
+  size_t _next_capture;         // first capture starting at or after _pos
+  bool _tag_pos;                // a seek landed inside a segment
+
+  std::mutex _pos_lock;         // seek() is called from other threads
+  uint64_t _pos;                // next sample to output
+  uint64_t _advised;            // end of the window asked for
+
+  /* emulated delivery */
+  bool _emulate;
+  emulation_t _emulation;
+  spsc_ring< gr_complex > _ring;
+  std::mutex _tags_lock;
+  std::deque< gr::tag_t > _ring_tags;   // offsets counted in ring items
+  uint64_t _ring_written;       // items put into the ring since start()
+  uint64_t _ring_read;          // items taken out of it
+  std::atomic<bool> _running;
+  gr::thread::thread _thread;
+
+  std::atomic<uint64_t> _samples;
+  std::atomic<uint64_t> _dropped;
+  std::atomic<uint64_t> _overruns;
+};
+
+#endif // MMAP_FILE_SOURCE_C_H
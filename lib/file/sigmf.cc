@@ -0,0 +1,204 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "sigmf.h"
+
+static bool ends_with( const std::string &s, const std::string &suffix )
+{
+  return s.size() >= suffix.size() &&
+         0 == s.compare( s.size() - suffix.size(), suffix.size(), suffix );
+}
+
+bool sigmf_split_path( const std::string &path, std::string &data, std::string &meta )
+{
+  static const char *suffixes[] = { ".sigmf-data", ".sigmf-meta", ".sigmf" };
+
+  for (const char *suffix : suffixes) {
+    if ( ends_with( path, suffix ) ) {
+      std::string base = path.substr( 0, path.size() - strlen(suffix) );
+      data = base + ".sigmf-data";
+      meta = base + ".sigmf-meta";
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* the samples are taken in host byte order, so only little endian ones */
+static file_format_t sigmf_datatype( const std::string &datatype )
+{
+  if ( "cf32_le" == datatype )
+    return FILE_FORMAT_CF32;
+  if ( "ci16_le" == datatype )
+    return FILE_FORMAT_CS16;
+  if ( "ci8" == datatype )
+    return FILE_FORMAT_CS8;
+  if ( "cu8" == datatype )
+    return FILE_FORMAT_CU8;
+
+  throw std::runtime_error("Unsupported SigMF datatype " + datatype + ".");
+}
+
+static const char *sigmf_datatype( file_format_t format )
+{
+  switch ( format ) {
+  case FILE_FORMAT_CS16: return "ci16_le";
+  case FILE_FORMAT_CS8:  return "ci8";
+  case FILE_FORMAT_CU8:  return "cu8";
+  default:               return "cf32_le";
+  }
+}
+
+/* ISO 8601 in UTC as SigMF mandates, e.g. 2026-01-01T12:00:00.123456Z */
+static bool sigmf_datetime( const std::string &datetime, uint64_t &secs, double &frac )
+{
+  struct tm tm = {};
+
+  if ( 6 != sscanf( datetime.c_str(), "%d-%d-%dT%d:%d:%d",
+                    &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec ) )
+    return false;
+
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+
+#ifdef _WIN32
+  time_t t = _mkgmtime( &tm );
+#else
+  time_t t = timegm( &tm );
+#endif
+  if ( t < 0 )
+    return false;
+
+  secs = uint64_t(t);
+  frac = 0;
+
+  size_t dot = datetime.find( '.' );
+  if ( dot != std::string::npos )
+    frac = strtod( datetime.c_str() + dot, NULL );
+
+  return true;
+}
+
+sigmf_meta_t sigmf_read_meta( const std::string &meta )
+{
+  namespace pt = boost::property_tree;
+
+  pt::ptree root;
+
+  try {
+    pt::read_json( meta, root );
+  } catch ( pt::json_parser_error &e ) {
+    throw std::runtime_error( "Failed to parse " + meta + ": " + e.what() );
+  }
+
+  sigmf_meta_t result;
+
+  std::string datatype = root.get< std::string >( "global.core:datatype", "" );
+  if ( datatype.empty() )
+    throw std::runtime_error( "No core:datatype in " + meta + "." );
+
+  result.format = sigmf_datatype( datatype );
+  result.sample_rate = root.get< double >( "global.core:sample_rate", 0 );
+
+  boost::optional< pt::ptree & > captures = root.get_child_optional( "captures" );
+  if ( captures ) {
+    for (pt::ptree::value_type &entry : *captures) {
+      const pt::ptree &c = entry.second;
+      sigmf_capture_t capture;
+
+      capture.sample_start = c.get< uint64_t >( "core:sample_start", 0 );
+
+      boost::optional< double > freq = c.get_optional< double >( "core:frequency" );
+      capture.has_frequency = bool(freq);
+      capture.frequency = freq ? *freq : 0;
+
+      capture.secs = 0;
+      capture.frac = 0;
+      capture.has_time = sigmf_datetime( c.get< std::string >( "core:datetime", "" ),
+                                         capture.secs, capture.frac );
+
+      result.captures.push_back( capture );
+    }
+  }
+
+  std::sort( result.captures.begin(), result.captures.end(),
+             []( const sigmf_capture_t &a, const sigmf_capture_t &b )
+             { return a.sample_start < b.sample_start; } );
+
+  return result;
+}
+
+void sigmf_write_meta( const std::string &meta, file_format_t format,
+                       double sample_rate, double frequency,
+                       uint64_t secs, double frac )
+{
+  time_t t = time_t(secs);
+  struct tm tm;
+#ifdef _WIN32
+  gmtime_s( &tm, &t );
+#else
+  gmtime_r( &t, &tm );
+#endif
+
+  char datetime[64];
+  strftime( datetime, sizeof(datetime), "%Y-%m-%dT%H:%M:%S", &tm );
+
+  char fraction[16];
+  snprintf( fraction, sizeof(fraction), "%.6f", std::min( frac, 0.999999 ) );
+
+  std::ofstream out( meta.c_str(), std::ios::trunc );
+  if ( !out )
+    throw std::runtime_error( "Failed to create " + meta + "." );
+
+  out << std::setprecision(17)
+      << "{\n"
+      << "    \"global\": {\n"
+      << "        \"core:datatype\": \"" << sigmf_datatype( format ) << "\",\n"
+      << "        \"core:sample_rate\": " << sample_rate << ",\n"
+      << "        \"core:version\": \"1.0.0\",\n"
+      << "        \"core:recorder\": \"gr-osmosdr\"\n"
+      << "    },\n"
+      << "    \"captures\": [\n"
+      << "        {\n"
+      << "            \"core:sample_start\": 0,\n"
+      << "            \"core:frequency\": " << frequency << ",\n"
+      << "            \"core:datetime\": \"" << datetime << (fraction + 1) << "Z\"\n"
+      << "        }\n"
+      << "    ],\n"
+      << "    \"annotations\": []\n"
+      << "}\n";
+
+  if ( !out.flush() )
+    throw std::runtime_error( "Failed to write " + meta + "." );
+}
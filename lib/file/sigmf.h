@@ -0,0 +1,66 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef SIGMF_H
+#define SIGMF_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "file_format.h"
+
+/* one entry of the captures array */
+struct sigmf_capture_t
+{
+  uint64_t sample_start;
+  bool has_frequency;
+  double frequency;
+  bool has_time;              // core:datetime
+  uint64_t secs;              // since the epoch, UTC
+  double frac;
+};
+
+/* the parts of a SigMF recording's metadata we make use of */
+struct sigmf_meta_t
+{
+  file_format_t format;       // from core:datatype
+  double sample_rate;         // 0 if not given
+  std::vector< sigmf_capture_t > captures;  // sorted by sample_start
+};
+
+/*!
+ * If \p path names a SigMF recording (ends in .sigmf-data, .sigmf-meta or
+ * .sigmf), fill in the names of the dataset and metadata files and return
+ * true. Otherwise return false and leave them untouched.
+ */
+bool sigmf_split_path( const std::string &path, std::string &data, std::string &meta );
+
+/*! parse a .sigmf-meta file, throws std::runtime_error */
+sigmf_meta_t sigmf_read_meta( const std::string &meta );
+
+/*!
+ * Write the metadata of a recording with a single capture segment, which
+ * starts at the given UTC time. Throws std::runtime_error.
+ */
+void sigmf_write_meta( const std::string &meta, file_format_t format,
+                       double sample_rate, double frequency,
+                       uint64_t secs, double frac );
+
+#endif // SIGMF_H
@@ -1,5 +1,10 @@
 #include "freesrp_source_c.h"
 
+#include <algorithm>
+#include <chrono>
+
+#include "sample_convert.h"
+
 using namespace FreeSRP;
 using namespace std;
 
@@ -22,6 +27,11 @@ static const int MAX_IN = 0;	// maximum number of input streams
 static const int MIN_OUT = 1;	// minimum number of output streams
 static const int MAX_OUT = 1;	// maximum number of output streams
 
+// The AD9364 delivers 12 bit samples in 16 bit words
+#define FREESRP_SCALE (1.0f / 2048.0f)
+
+static_assert(sizeof(sample) == 2 * sizeof(int16_t), "FreeSRP::sample must be interleaved int16 I/Q");
+
 freesrp_source_c::freesrp_source_c (const string & args) : gr::sync_block ("freesrp_source_c",
                                                                 gr::io_signature::make (MIN_IN, MAX_IN, sizeof (gr_complex)),
                                                                 gr::io_signature::make (MIN_OUT, MAX_OUT, sizeof (gr_complex))),
@@ -31,6 +41,8 @@ freesrp_source_c::freesrp_source_c (const string & args) : gr::sync_block ("free
     {
         throw runtime_error("FreeSRP not initialized!");
     }
+
+    _sched = thread_sched_once(thread_sched_from_dict(params_to_dict(args)));
 }
 
 bool freesrp_source_c::start()
@@ -40,6 +52,9 @@ bool freesrp_source_c::start()
     {
         return false;
     }
+    _buf_ring.reset();
+    _latency_stats.reset();
+    _sched.reset();
     _srp->start_rx(std::bind(&freesrp_source_c::freesrp_rx_callback, this, std::placeholders::_1));
 
     _running = true;
@@ -54,65 +69,79 @@ bool freesrp_source_c::stop()
 
     _running = false;
 
+    // Release work() if it is waiting for samples
+    _buf_ring.close();
+
     return true;
 }
 
 void freesrp_source_c::freesrp_rx_callback(const vector<sample> &samples)
 {
-    unique_lock<std::mutex> lk(_buf_mut);
+    _sched.apply();
+
+    // Queue the whole transfer at once, as many samples as fit
+    const size_t nvalues = 2 * samples.size();
+    _latency_stats.arrival(_buf_ring.write_count());
+    const size_t pushed = _buf_ring.push(reinterpret_cast<const int16_t *>(samples.data()), nvalues);
 
-    for(const sample &s : samples)
+    if(pushed < nvalues)
     {
-        if(!_buf_queue.try_enqueue(s))
+        _stats.overruns++;
+        _stats.dropped += (nvalues - pushed) / 2;
+        if(!_ignore_overflow)
         {
-	    if(!_ignore_overflow)
-	    {
-		throw runtime_error("RX buffer overflow");
-	    }
-        }
-        else
-        {
-            _buf_num_samples++;
+            cerr << "O" << flush;
         }
     }
-
-    _buf_cond.notify_one();
 }
 
 int freesrp_source_c::work(int noutput_items, gr_vector_const_void_star& input_items, gr_vector_void_star& output_items)
 {
     gr_complex *out = static_cast<gr_complex *>(output_items[0]);
 
-    unique_lock<std::mutex> lk(_buf_mut);
-
     if(!_running)
     {
 	return WORK_DONE;
     }
 
-    // Wait until enough samples collected
-    while(_buf_num_samples < (unsigned int) noutput_items)
+    // Wait for samples, but take whatever arrived by then
+    while(!_buf_ring.wait_for(2, chrono::milliseconds(100)))
     {
-        _buf_cond.wait(lk);
+        if(!_running)
+        {
+            return WORK_DONE;
+        }
     }
 
-    for(int i = 0; i < noutput_items; ++i)
+    int produced = 0;
+
+    // The readable values may wrap around the end of the ring
+    for(int i = 0; i < 2 && produced < noutput_items; ++i)
     {
-        sample s;
-        if(!_buf_queue.try_dequeue(s))
-        {
-            // This should not be happening
-            throw runtime_error("Failed to get sample from buffer. This should never happen. Number of available samples reported to be " + to_string(_buf_num_samples) + ", noutput_items=" + to_string(noutput_items) + ", i=" + to_string(i));
-        }
-        else
+        size_t count = 0;
+        const int16_t *src = _buf_ring.read_ptr(count);
+
+        size_t nitems = min(count / 2, size_t(noutput_items - produced));
+        if(nitems == 0)
         {
-            _buf_num_samples--;
+            break;
         }
 
-        out[i] = gr_complex(((float) s.i) / 2048.0f, ((float) s.q) / 2048.0f);
+        convert_s16_fc32(src, out + produced, nitems, FREESRP_SCALE);
+        _buf_ring.consume(2 * nitems);
+        produced += nitems;
+    }
+
+    if(produced == 0)
+    {
+        // Closed by stop()
+        return WORK_DONE;
     }
 
-    return noutput_items;
+    _latency_stats.consumed(_buf_ring.read_count(), _buf_ring.size());
+    _stats.samples += produced;
+
+    return produced;
 }
 
 double freesrp_source_c::set_sample_rate( double rate )
@@ -339,3 +368,15 @@ double freesrp_source_c::get_bandwidth(size_t chan)
         return static_cast<double>(r.param);
     }
 }
+
+osmosdr::stream_stats_t freesrp_source_c::get_stream_stats(size_t chan)
+{
+    osmosdr::stream_stats_t stats = _stats;
+
+    stats.fill = _buf_ring.size() / 2;
+    stats.fill_max = _buf_ring.fill_max() / 2;
+    stats.capacity = _buf_ring.capacity() / 2;
+    _latency_stats.get_stats(stats, 2);
+
+    return stats;
+}
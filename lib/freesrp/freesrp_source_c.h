@@ -26,11 +26,13 @@
 #include <gnuradio/sync_block.h>
 
 #include "osmosdr/ranges.h"
+#include "latency_stats.h"
 #include "source_iface.h"
 
 #include "freesrp_common.h"
 
-#include "readerwriterqueue/readerwriterqueue.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
 
 #include <freesrp.hpp>
 
@@ -116,16 +118,19 @@ public:
     double set_bandwidth( double bandwidth, size_t chan = 0 );
     double get_bandwidth( size_t chan = 0 );
 
+    osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
 
     void freesrp_rx_callback(const std::vector<FreeSRP::sample> &samples);
 
     bool _running = false;
 
-    std::mutex _buf_mut{};
-    std::condition_variable _buf_cond{};
-    size_t _buf_num_samples = 0;
-    moodycamel::ReaderWriterQueue<FreeSRP::sample> _buf_queue{FREESRP_RX_TX_QUEUE_SIZE};
+    // Interleaved I/Q values, filled a whole callback at a time
+    spsc_ring<int16_t> _buf_ring{2 * FREESRP_RX_TX_QUEUE_SIZE};
+    thread_sched_once _sched;
+    osmosdr::stream_stats_t _stats;
+    latency_stats _latency_stats;
 };
 
 #endif /* INCLUDED_FREESRP_SOURCE_C_H */
@@ -0,0 +1,47 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "backend_registry.h"
+#include "hackrf_source_c.h"
+#include "hackrf_sink_c.h"
+
+static backend_t hackrf_backend()
+{
+  backend_t backend;
+
+  backend.name = "hackrf";
+  backend.order = 70;
+
+  backend.source_devices = []( bool ) { return hackrf_source_c::get_devices(); };
+  backend.make_source = []( const std::string &args ) -> backend_t::source_t {
+    hackrf_source_c_sptr src = make_hackrf_source_c( args );
+    return backend_t::source_t{ src, src.get() };
+  };
+
+  backend.sink_devices = []( bool ) { return hackrf_sink_c::get_devices(); };
+  backend.make_sink = []( const std::string &args ) -> backend_t::sink_t {
+    hackrf_sink_c_sptr sink = make_hackrf_sink_c( args );
+    return backend_t::sink_t{ sink, sink.get() };
+  };
+
+  return backend;
+}
+
+static backend_registrar registrar( hackrf_backend() );
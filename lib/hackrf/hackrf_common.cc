@@ -28,11 +28,13 @@
 int hackrf_common::_usage = 0;
 std::mutex hackrf_common::_usage_mutex;
 
-std::map<std::string, std::weak_ptr<hackrf_device>> hackrf_common::_devs;
 std::mutex hackrf_common::_devs_mutex;
+device_pool<hackrf_device> hackrf_common::_devs;  /* closed before _usage goes */
+std::map<std::string, std::weak_ptr<hackrf_common::duplex_t>> hackrf_common::_duplexes;
 
 hackrf_common::hackrf_common(const std::string &args) :
   _dev(NULL),
+  _reused(false),
   _sample_rate(0),
   _center_freq(0),
   _freq_corr(0),
@@ -105,13 +107,19 @@ hackrf_common::hackrf_common(const std::string &args) :
   {
     std::lock_guard<std::mutex> guard(_devs_mutex);
 
-    if (_devs.count(final_serial) > 0 && !_devs[final_serial].expired()) {
-      _dev = hackrf_sptr(_devs[final_serial]);
-    } else {
-      ret = hackrf_device_list_open(list, dev_index, &raw_dev);
-      HACKRF_THROW_ON_ERROR(ret, "Failed to open HackRF device")
-      _dev = hackrf_sptr(raw_dev, hackrf_common::close);
-      _devs[final_serial] = static_cast<std::weak_ptr<struct hackrf_device>>(_dev);
+    _dev = _devs.acquire(final_serial, true, device_pool<hackrf_device>::linger_from_dict(dict),
+      [&]() {
+        ret = hackrf_device_list_open(list, dev_index, &raw_dev);
+        HACKRF_THROW_ON_ERROR(ret, "Failed to open HackRF device")
+        return hackrf_sptr(raw_dev, hackrf_common::close);
+      }, &_reused);
+
+    _duplex = _duplexes[final_serial].lock();
+    if (!_duplex) {
+      _duplex = std::make_shared<duplex_t>();
+      _duplex->rx = NULL;
+      _duplex->paused = false;
+      _duplexes[final_serial] = _duplex;
     }
   }
 
@@ -425,3 +433,81 @@ void hackrf_common::stop()
 {
   _started = false;
 }
+
+void hackrf_common::set_rx_hooks( const std::function<void()> &pause,
+                                  const std::function<bool()> &resume )
+{
+  std::lock_guard<std::mutex> guard(_duplex->lock);
+
+  _duplex->rx = this;
+  _duplex->pause = pause;
+  _duplex->resume = resume;
+  _duplex->paused = false;
+}
+
+void hackrf_common::clear_rx_hooks()
+{
+  std::lock_guard<std::mutex> guard(_duplex->lock);
+
+  if (_duplex->rx != this)
+    return;
+
+  _duplex->rx = NULL;
+  _duplex->pause = nullptr;
+  _duplex->resume = nullptr;
+  _duplex->paused = false;
+}
+
+/* the settings of the other direction are still on the device, only the
+ * ones that differ get sent */
+void hackrf_common::retune_from( const hackrf_common &current )
+{
+  _started = true;
+
+  if (_sample_rate != current._sample_rate)
+    set_sample_rate(_sample_rate);
+  if (_bandwidth != current._bandwidth)
+    set_bandwidth(_requested_bandwidth);
+  if (_center_freq != current._center_freq || _freq_corr != current._freq_corr)
+    set_center_freq(_center_freq);
+  if (_amp_gain != current._amp_gain)
+    set_gain(_amp_gain);
+  if (_bias != current._bias)
+    set_bias(_bias);
+}
+
+void hackrf_common::turn_to_tx()
+{
+  std::lock_guard<std::mutex> guard(_duplex->lock);
+
+  if (_duplex->paused)
+    return;
+
+  /* nothing receives, the settings only need to go out once */
+  if (!_duplex->rx) {
+    if (!_started)
+      start();
+    return;
+  }
+
+  _duplex->pause();
+  _duplex->paused = true;
+
+  retune_from(*_duplex->rx);
+}
+
+void hackrf_common::turn_to_rx()
+{
+  std::lock_guard<std::mutex> guard(_duplex->lock);
+
+  if (!_duplex->paused)
+    return;
+
+  /* what the sink sets until the next burst is kept for then */
+  _started = false;
+  _duplex->paused = false;
+
+  _duplex->rx->retune_from(*this);
+  if (!_duplex->resume())
+    std::cerr << "Failed to resume RX streaming after the burst" << std::endl;
+}
@@ -20,6 +20,7 @@
 #ifndef INCLUDED_HACKRF_COMMON_H
 #define INCLUDED_HACKRF_COMMON_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -31,6 +32,8 @@
 #include <osmosdr/ranges.h>
 #include <libhackrf/hackrf.h>
 
+#include "device_pool.h"
+
 #define BUF_LEN  (16 * 32 * 512) /* must be multiple of 512 */
 #define BUF_NUM   15
 
@@ -88,16 +91,47 @@ protected:
   void start();
   void stop();
 
+  /*
+   * Half-duplex turnaround between a source and a sink sharing the
+   * device. The source registers how to pause and resume its stream,
+   * turn_to_tx() pauses it and applies only the settings of the sink that
+   * differ from the source's, turn_to_rx() goes the other way. Both keep
+   * their buffers and libhackrf its transfers, so a turnaround costs the
+   * transceiver mode switch and the changed settings only.
+   */
+  void set_rx_hooks( const std::function<void()> &pause,
+                     const std::function<bool()> &resume );
+  void clear_rx_hooks();
+  void turn_to_tx();
+  void turn_to_rx();
+
   hackrf_sptr _dev;
+  bool _reused;                         // left open by an earlier flowgraph, with linger=
 
 private:
   static void close(void *dev);
 
+  void retune_from( const hackrf_common &current );
+
+  /* one per device, shared by its source and sink */
+  struct duplex_t
+  {
+    std::mutex lock;
+    hackrf_common *rx;                  // the source, when streaming
+    std::function<void()> pause;
+    std::function<bool()> resume;
+    bool paused;                        // by turn_to_tx()
+  };
+
   static int _usage;
   static std::mutex _usage_mutex;
 
-  static std::map<std::string, std::weak_ptr<hackrf_device>> _devs;
+  /* by serial, shared by the source and sink of a device */
+  static device_pool<hackrf_device> _devs;
   static std::mutex _devs_mutex;
+  static std::map<std::string, std::weak_ptr<duplex_t>> _duplexes;  // _devs_mutex held
+
+  std::shared_ptr<duplex_t> _duplex;
 
   double _sample_rate;
   double _center_freq;
@@ -32,23 +32,20 @@
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
-#ifdef USE_AVX
-#include <immintrin.h>
-#elif USE_SSE2
-#include <emmintrin.h>
-#endif
+#include <chrono>
 
 #include <gnuradio/io_signature.h>
 
 #include "hackrf_sink_c.h"
 
 #include "arg_helpers.h"
+#include "buffer_pool.h"
+#include "sample_convert.h"
 
-static inline bool cb_init(circular_buffer_t *cb, size_t capacity, size_t sz)
+static inline bool cb_init(circular_buffer_t *cb, size_t capacity, size_t sz,
+                           const buffer_opts_t &opts)
 {
-  cb->buffer = malloc(capacity * sz);
-  if(cb->buffer == NULL)
-    return false; // handle error
+  cb->buffer = buffer_acquire(capacity * sz, opts);
   cb->buffer_end = (int8_t *)cb->buffer + capacity * sz;
   cb->capacity = capacity;
   cb->count = 0;
@@ -60,7 +57,7 @@ static inline bool cb_init(circular_buffer_t *cb, size_t capacity, size_t sz)
 
 static inline void cb_free(circular_buffer_t *cb)
 {
-  free(cb->buffer);
+  buffer_release(cb->buffer);
   cb->buffer = NULL;
   // clear out other fields too, just to be safe
   cb->buffer_end = 0;
@@ -83,11 +80,17 @@ static inline bool cb_is_empty(circular_buffer_t *cb)
   return cb->count == 0;
 }
 
-static inline bool cb_push_back(circular_buffer_t *cb, const void *item)
+/* the slot at the head may be filled in place as long as there is room,
+ * the consumer only touches the slots counted in */
+static inline int8_t *cb_head(circular_buffer_t *cb)
+{
+  return (int8_t *)cb->head;
+}
+
+static inline bool cb_commit(circular_buffer_t *cb)
 {
   if(cb->count == cb->capacity)
     return false; // handle error
-  memcpy(cb->head, item, cb->sz);
   cb->head = (int8_t *)cb->head + cb->sz;
   if(cb->head == cb->buffer_end)
     cb->head = cb->buffer;
@@ -95,6 +98,17 @@ static inline bool cb_push_back(circular_buffer_t *cb, const void *item)
   return true;
 }
 
+static inline bool cb_drop_front(circular_buffer_t *cb)
+{
+  if(cb->count == 0)
+    return false;
+  cb->tail = (int8_t *)cb->tail + cb->sz;
+  if(cb->tail == cb->buffer_end)
+    cb->tail = cb->buffer;
+  cb->count--;
+  return true;
+}
+
 static inline bool cb_pop_front(circular_buffer_t *cb, void *item)
 {
   if(cb->count == 0)
@@ -134,11 +148,34 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     hackrf_common::hackrf_common(args),
-    _buf(NULL),
+    _burst(false),
+    _turnaround(false),
+    _in_burst(false),
+    _tx_pending(false),
+    _tx_running(false),
+    _burst_end(false),
+    _tx_done(false),
+    _prefill_bufs(1),
+    _underrun_stop(false),
+    _wave_pos(0),
     _vga_gain(0)
 {
   dict_t dict = params_to_dict(args);
 
+  _sched = thread_sched_once( thread_sched_from_dict( dict, "tx" ) );
+
+  /* only transmit between tx_sob and tx_eob, idle in between */
+  if (dict.count("burst"))
+    _burst = std::stoi(dict["burst"]) != 0;
+
+  /* half duplex with a source on the same device, which gets paused
+   * from tx_sob until the burst has gone out */
+  if (dict.count("turnaround"))
+    _turnaround = std::stoi(dict["turnaround"]) != 0;
+
+  if (_turnaround)
+    _burst = true;
+
   _buf_num = 0;
 
   if (dict.count("buffers"))
@@ -154,6 +191,22 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
               << std::endl;
   }
 
+  /* the stream starts once the prefill is queued, in whole buffers */
+  _policy = tx_policy_from_dict( dict );
+
+  const size_t buf_samples = BUF_LEN / BYTES_PER_SAMPLE;
+  _prefill_bufs = (_policy.prefill + buf_samples - 1) / buf_samples;
+  if ( _prefill_bufs > _buf_num ) {
+    std::cerr << "Prefill limited to the " << _buf_num << " buffers." << std::endl;
+    _prefill_bufs = _buf_num;
+  }
+  _prefill_bufs = std::max( _prefill_bufs, 1u );
+
+  if ( tx_policy_t::UNDERRUN_REPEAT == _policy.underrun )
+    _last.assign( BUF_LEN, 0 );
+
+  _queue_bufs = _buf_num;
+
   set_center_freq( (get_freq_range().start() + get_freq_range().stop()) / 2.0 );
   set_sample_rate( get_sample_rates().start() );
   set_bandwidth( 0 );
@@ -162,14 +215,13 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
 
   set_if_gain( 16 ); /* preset to a reasonable default (non-GRC use case) */
 
-  // Check device args to find out if bias/phantom power is desired.
-  if ( dict.count("bias_tx") ) {
+  // Check device args to find out if bias/phantom power is desired,
+  // a device left open may still have it on.
+  if ( dict.count("bias_tx") || _reused ) {
     hackrf_common::set_bias(dict["bias_tx"] == "1");
   }
 
-  _buf = (int8_t *) malloc( BUF_LEN );
-
-  cb_init( &_cbuf, _buf_num, BUF_LEN );
+  cb_init( &_cbuf, _buf_num, BUF_LEN, buffer_opts_from_dict( dict ) );
 }
 
 /*
@@ -177,15 +229,13 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
  */
 hackrf_sink_c::~hackrf_sink_c ()
 {
-  free(_buf);
-  _buf = NULL;
-
   cb_free( &_cbuf );
 }
 
 int hackrf_sink_c::_hackrf_tx_callback(hackrf_transfer *transfer)
 {
   hackrf_sink_c *obj = (hackrf_sink_c *)transfer->tx_ctx;
+  obj->_sched.apply();
   return obj->hackrf_tx_callback(transfer->buffer, transfer->valid_length);
 }
 
@@ -198,16 +248,48 @@ int hackrf_sink_c::hackrf_tx_callback(unsigned char *buffer, uint32_t length)
   {
     std::lock_guard<std::mutex> lock(_buf_mutex);
 
+    if ( ! _wave.empty() ) {
+      /* what work() queued before the waveform was set is stale */
+      while ( cb_drop_front( &_cbuf ) )
+        ;
+
+      if (_stopping) {
+        memset(buffer, 0, length);
+        _tx_done = true;
+        _buf_cond.notify_one();
+        return -1;
+      }
+
+      fill_waveform(buffer, length);
+      _stats.samples += length / BYTES_PER_SAMPLE;
+      _buf_cond.notify_one();
+      return 0;
+    }
+
     if ( ! cb_pop_front( &_cbuf, buffer ) ) {
       memset(buffer, 0, length);
-      if (_stopping) {
+      if (_stopping || _burst_end) {
+        _tx_done = true;
         _buf_cond.notify_one();
         return -1;
       } else {
+        _stats.underruns++;
         std::cerr << "U" << std::flush;
+
+        if ( tx_policy_t::UNDERRUN_REPEAT == _policy.underrun ) {
+          memcpy(buffer, &_last[0], std::min(size_t(length), _last.size()));
+        } else if ( tx_policy_t::UNDERRUN_STOP == _policy.underrun ) {
+          /* work() restarts the stream, prefilled, with the next samples */
+          _underrun_stop = true;
+          _tx_done = true;
+          _buf_cond.notify_one();
+          return -1;
+        }
       }
     } else {
 //      std::cerr << "-" << std::flush;
+      if ( ! _last.empty() )
+        memcpy(&_last[0], buffer, std::min(size_t(length), _last.size()));
       _buf_cond.notify_one();
     }
   }
@@ -215,19 +297,77 @@ int hackrf_sink_c::hackrf_tx_callback(unsigned char *buffer, uint32_t length)
   return 0; // TODO: return -1 on error/stop
 }
 
+/* the waveform is in device format already, this is a plain copy */
+void hackrf_sink_c::fill_waveform(unsigned char *buffer, uint32_t length)
+{
+  size_t done = 0;
+
+  while (done < length) {
+    size_t count = std::min(size_t(length) - done, _wave.size() - _wave_pos);
+
+    memcpy(buffer + done, &_wave[_wave_pos], count);
+    done += count;
+
+    _wave_pos += count;
+    if (_wave_pos == _wave.size())
+      _wave_pos = 0;
+  }
+}
+
 bool hackrf_sink_c::start()
 {
   if ( ! _dev.get() )
     return false;
 
   _stopping = false;
+  _underrun_stop = false;
   _buf_used = 0;
-  hackrf_common::start();
+
+  /* the latency cap counts whole buffers, libhackrf adds its transfers */
+  const size_t buf_samples = BUF_LEN / BYTES_PER_SAMPLE;
+  const size_t cap = _policy.latency_samples( get_sample_rate() );
+
+  _queue_bufs = _buf_num;
+  if ( cap ) {
+    _queue_bufs = (cap + buf_samples - 1) / buf_samples;
+    _queue_bufs = std::max( 1u, std::min( _queue_bufs, _buf_num ) );
+
+    if ( _prefill_bufs > _queue_bufs )
+      std::cerr << "Prefill limited to the " << _queue_bufs
+                << " buffers of the latency cap." << std::endl;
+
+    if ( buf_samples > cap )
+      std::cerr << "Latency cap of " << _policy.latency * 1e3 << " ms is below the "
+                << buf_samples / get_sample_rate() * 1e3
+                << " ms buffer length at this sample rate." << std::endl;
+  }
+
+  /* with turnaround the settings go out with every burst, the source
+   * keeps its own in between */
+  if ( ! _turnaround )
+    hackrf_common::start();
+
+  /* the stream gets started by the first burst */
+  if ( _burst ) {
+    _in_burst = _tx_pending = _tx_running = false;
+    return true;
+  }
+
+  /* or by work() once the prefill is queued */
+  if ( _policy.prefill && _wave.empty() ) {
+    _tx_pending = true;
+    _tx_running = false;
+    return true;
+  }
+
+  _sched.reset();
   int ret = hackrf_start_tx( _dev.get(), _hackrf_tx_callback, (void *)this );
   if ( ret != HACKRF_SUCCESS ) {
     std::cerr << "Failed to start TX streaming (" << ret << ")" << std::endl;
     return false;
   }
+  _tx_pending = false;
+  _tx_running = true;
   return true;
 }
 
@@ -238,24 +378,39 @@ bool hackrf_sink_c::stop()
   if ( ! _dev.get() )
     return false;
 
-  {
-    std::unique_lock<std::mutex> lock(_buf_mutex);
+  if ( _burst ) {
+    if ( _in_burst )
+      end_burst();
 
-    while ( ! cb_has_room(&_cbuf) )
-      _buf_cond.wait( lock );
+    hackrf_common::stop();
+    return true;
+  }
 
-    // Fill the rest of the current buffer with silence.
-    memset(_buf + _buf_used, 0, BUF_LEN - _buf_used);
-    cb_push_back( &_cbuf, _buf );
-    _buf_used = 0;
+  /* what is queued still goes out, even if it is less than the prefill */
+  if ( _tx_pending )
+    start_tx();
 
-    // Add some more silence so the end doesn't get cut off.
-    memset(_buf, 0, BUF_LEN);
-    for (i = 0; i < 5; i++) {
+  {
+    std::unique_lock<std::mutex> lock(_buf_mutex);
+
+    /* a looped waveform just stops, there is no queue to play out */
+    if ( _wave.empty() ) {
       while ( ! cb_has_room(&_cbuf) )
         _buf_cond.wait( lock );
 
-      cb_push_back( &_cbuf, _buf );
+      // Fill the rest of the current buffer with silence.
+      memset(cb_head(&_cbuf) + _buf_used, 0, BUF_LEN - _buf_used);
+      cb_commit( &_cbuf );
+      _buf_used = 0;
+
+      // Add some more silence so the end doesn't get cut off.
+      for (i = 0; i < 5; i++) {
+        while ( ! cb_has_room(&_cbuf) )
+          _buf_cond.wait( lock );
+
+        memset(cb_head(&_cbuf), 0, BUF_LEN);
+        cb_commit( &_cbuf );
+      }
     }
 
     _stopping = true;
@@ -273,124 +428,232 @@ bool hackrf_sink_c::stop()
   return true;
 }
 
-#ifdef USE_AVX
-void convert_avx(const float* inbuf, int8_t* outbuf,const unsigned int count)
+int hackrf_sink_c::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
 {
-  __m256 mulme = _mm256_set_ps(127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f);
-  for(unsigned int i=0; i<count;i++){
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  int items_consumed;
 
-  __m256i itmp3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inbuf[i*16+0]), mulme));
-  __m256i itmp4 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inbuf[i*16+8]), mulme));
+  {
+    std::unique_lock<std::mutex> lock(_buf_mutex);
 
-  __m128i a1 = _mm256_extractf128_si256(itmp3, 1);
-  __m128i a0 = _mm256_castsi256_si128(itmp3);
-  __m128i a3 = _mm256_extractf128_si256(itmp4, 1);
-  __m128i a2 = _mm256_castsi256_si128(itmp4);
+    /* the callback loops the waveform, the input only gets dropped at
+     * the pace the device takes buffers */
+    if ( ! _wave.empty() ) {
+      /* there is no prefill to wait for */
+      if ( _tx_pending && ! _burst ) {
+        lock.unlock();
+        start_tx();
+        lock.lock();
+      }
 
-  __m128i outshorts1 = _mm_packs_epi32(a0, a1);
-  __m128i outshorts2 = _mm_packs_epi32(a2, a3);
+      _buf_cond.wait_for( lock, std::chrono::milliseconds(100) );
+      consume_each(noutput_items);
+      return 0;
+    }
+  }
 
-  __m128i outbytes = _mm_packs_epi16(outshorts1, outshorts2);
+  if (_burst)
+    items_consumed = work_burst(in, noutput_items);
+  else
+    items_consumed = queue_samples(in, noutput_items);
 
-  _mm_storeu_si128 ((__m128i*)&outbuf[i*16], outbytes);
-  }
+  // Tell runtime system how many input items we consumed on
+  // each input stream.
+  consume_each(items_consumed);
+
+  // Tell runtime system how many output items we produced.
+  return 0;
 }
 
-#elif USE_SSE2
-void convert_sse2(const float* inbuf, int8_t* outbuf,const unsigned int count)
+int hackrf_sink_c::queue_samples( const gr_complex *in, int nitems )
 {
-  const register __m128 mulme = _mm_set_ps( 127.0f, 127.0f, 127.0f, 127.0f );
-  __m128 itmp1,itmp2,itmp3,itmp4;
-  __m128i otmp1,otmp2,otmp3,otmp4;
+  int items_consumed = 0;
+
+  resume_after_underrun();
+
+  /* convert straight into the free slots until we run out of input or
+   * room, only waiting for room if nothing could be taken yet */
+  while (items_consumed < nitems) {
+    {
+      std::unique_lock<std::mutex> lock(_buf_mutex);
 
-  __m128i outshorts1,outshorts2;
-  __m128i outbytes;
+      while ( ! items_consumed && ! queue_has_room() )
+        _buf_cond.wait( lock );
+
+      if ( ! queue_has_room() )
+        break;
+    }
 
-  for(unsigned int i=0; i<count;i++){
+    unsigned int remaining = (BUF_LEN-_buf_used)/2; //complex
+    unsigned int count = std::min((unsigned int)(nitems - items_consumed), remaining);
 
-  itmp1 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+0]), mulme);
-  itmp2 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+4]), mulme);
-  itmp3 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+8]), mulme);
-  itmp4 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+12]), mulme);
+    convert_fc32_sc8(in + items_consumed, cb_head(&_cbuf) + _buf_used, count);
 
-  otmp1 = _mm_cvtps_epi32(itmp1);
-  otmp2 = _mm_cvtps_epi32(itmp2);
-  otmp3 = _mm_cvtps_epi32(itmp3);
-  otmp4 = _mm_cvtps_epi32(itmp4);
+    _buf_used += count*2;
+    items_consumed += count;
 
-  outshorts1 = _mm_packs_epi32(otmp1, otmp2);
-  outshorts2 = _mm_packs_epi32(otmp3, otmp4);
+    if (_buf_used == BUF_LEN) {
+      bool prefilled;
+      {
+        std::lock_guard<std::mutex> lock(_buf_mutex);
 
-  outbytes = _mm_packs_epi16(outshorts1, outshorts2);
+        cb_commit( &_cbuf );
+//        std::cerr << "+" << std::flush;
+        _buf_used = 0;
+        _stats.fill_max = std::max(_stats.fill_max, _cbuf.count * BUF_LEN / BYTES_PER_SAMPLE);
+        prefilled = _cbuf.count >= std::min( _prefill_bufs, _queue_bufs );
+      }
 
-  _mm_storeu_si128 ((__m128i*)&outbuf[i*16], outbytes);
+      if (_tx_pending && prefilled)
+        start_tx();
+    }
   }
+
+  _stats.samples += items_consumed;
+
+  return items_consumed;
 }
-#endif
 
-void convert_default(float* inbuf, int8_t* outbuf,const unsigned int count)
+/* samples outside of tx_sob ... tx_eob (inclusive) are dropped */
+int hackrf_sink_c::work_burst( const gr_complex *in, int nitems )
 {
-  for(unsigned int i=0; i<count;i++){
-    outbuf[i]= inbuf[i]*127;
+  static const pmt::pmt_t SOB_KEY = pmt::string_to_symbol("tx_sob");
+  static const pmt::pmt_t EOB_KEY = pmt::string_to_symbol("tx_eob");
+
+  int pos = 0;
+
+  get_tags_in_window(_tags, 0, 0, nitems);
+  std::sort(_tags.begin(), _tags.end(), gr::tag_t::offset_compare);
+
+  for (const gr::tag_t &tag : _tags) {
+    const int idx = int(tag.offset - nitems_read(0));
+
+    if (pmt::eq(tag.key, SOB_KEY)) {
+      if (_in_burst) {
+        std::cerr << "Got tx_sob while already within a burst" << std::endl;
+        continue;
+      }
+
+      pos = idx;
+      begin_burst();
+    } else if (pmt::eq(tag.key, EOB_KEY)) {
+      if (!_in_burst) {
+        std::cerr << "Got tx_eob while not in a burst" << std::endl;
+        continue;
+      }
+
+      /* the tags get looked at again if the queue is full */
+      const int count = idx + 1 - pos;
+      const int queued = queue_samples(in + pos, count);
+
+      pos += queued;
+      if (queued < count)
+        return pos;
+
+      end_burst();
+    }
   }
+
+  if (_in_burst)
+    pos += queue_samples(in + pos, nitems - pos);
+  else
+    pos = nitems;
+
+  return pos;
 }
 
-int hackrf_sink_c::work( int noutput_items,
-                         gr_vector_const_void_star &input_items,
-                         gr_vector_void_star &output_items )
+void hackrf_sink_c::begin_burst()
 {
-  const gr_complex *in = (const gr_complex *) input_items[0];
+  std::lock_guard<std::mutex> lock(_buf_mutex);
 
+  _burst_end = false;
+  _tx_done = false;
+  _underrun_stop = false;
+  _in_burst = true;
+  _tx_pending = true;
+}
+
+/* pad the partial buffer with silence and let the queue drain */
+void hackrf_sink_c::end_burst()
+{
   {
     std::unique_lock<std::mutex> lock(_buf_mutex);
 
-    while ( ! cb_has_room(&_cbuf) )
-      _buf_cond.wait( lock );
+    if (_buf_used) {
+      while ( ! cb_has_room(&_cbuf) )
+        _buf_cond.wait( lock );
+
+      memset(cb_head(&_cbuf) + _buf_used, 0, BUF_LEN - _buf_used);
+      cb_commit( &_cbuf );
+      _buf_used = 0;
+    }
+
+    _burst_end = true;
   }
 
-  int8_t *buf = _buf + _buf_used;
-  unsigned int prev_buf_used = _buf_used;
+  _in_burst = false;
 
-  unsigned int remaining = (BUF_LEN-_buf_used)/2; //complex
+  if (_tx_pending)
+    start_tx();
 
-  unsigned int count = std::min((unsigned int)noutput_items,remaining);
-  unsigned int sse_rem = count/8; // 8 complex = 16f==512bit for avx
-  unsigned int nosse_rem = count%8; // remainder
+  {
+    std::unique_lock<std::mutex> lock(_buf_mutex);
 
-#ifdef USE_AVX
-  convert_avx((float*)in, buf, sse_rem);
-  convert_default((float*)(in+sse_rem*8), buf+(sse_rem*8*2), nosse_rem*2);
-#elif USE_SSE2
-  convert_sse2((float*)in, buf, sse_rem);
-  convert_default((float*)(in+sse_rem*8), buf+(sse_rem*8*2), nosse_rem*2);
-#else
-  convert_default((float*)in, buf, count*2);
-#endif
+    while ( _tx_running && ! _tx_done )
+      _buf_cond.wait( lock );
+  }
 
-  _buf_used += (sse_rem*8+nosse_rem)*2;
-  int items_consumed = sse_rem*8+nosse_rem;
+  /* turns the transmitter off until the next burst */
+  if (_tx_running) {
+    _tx_running = false;
+    _underrun_stop = false;
 
-  if((unsigned int)noutput_items >= remaining) {
-    {
-      std::lock_guard<std::mutex> lock(_buf_mutex);
+    int ret = hackrf_stop_tx( _dev.get() );
+    if ( ret != HACKRF_SUCCESS )
+      std::cerr << "Failed to stop TX streaming (" << ret << ")" << std::endl;
+  }
 
-      if ( ! cb_push_back( &_cbuf, _buf ) ) {
-        _buf_used = prev_buf_used;
-        items_consumed = 0;
-        std::cerr << "O" << std::flush;
-      } else {
-//        std::cerr << "+" << std::flush;
-        _buf_used = 0;
-      }
-    }
+  if ( _turnaround )
+    turn_to_rx();
+}
+
+/* the callback ended the stream when the queue ran empty, it starts
+ * again once the prefill is queued */
+void hackrf_sink_c::resume_after_underrun()
+{
+  {
+    std::lock_guard<std::mutex> lock(_buf_mutex);
+
+    if ( ! _underrun_stop )
+      return;
+
+    _underrun_stop = false;
+    _tx_done = false;
   }
 
-  // Tell runtime system how many input items we consumed on
-  // each input stream.
-  consume_each(items_consumed);
+  int ret = hackrf_stop_tx( _dev.get() );
+  if ( ret != HACKRF_SUCCESS )
+    std::cerr << "Failed to stop TX streaming (" << ret << ")" << std::endl;
 
-  // Tell runtime system how many output items we produced.
-  return 0;
+  _tx_running = false;
+  _tx_pending = true;
+}
+
+void hackrf_sink_c::start_tx()
+{
+  _tx_pending = false;
+
+  /* the prefill is queued already, only the mode switch is left */
+  if ( _turnaround )
+    turn_to_tx();
+
+  _sched.reset();
+  int ret = hackrf_start_tx( _dev.get(), _hackrf_tx_callback, (void *)this );
+  HACKRF_THROW_ON_ERROR( ret, "Failed to start TX streaming" )
+
+  _tx_running = true;
 }
 
 std::vector<std::string> hackrf_sink_c::get_devices()
@@ -565,3 +828,34 @@ osmosdr::freq_range_t hackrf_sink_c::get_bandwidth_range( size_t chan )
 {
   return hackrf_common::get_bandwidth_range(chan);
 }
+
+bool hackrf_sink_c::set_waveform( const std::vector< gr_complex > &samples, size_t chan )
+{
+  if ( _burst && ! samples.empty() )
+    throw std::runtime_error("hackrf: a waveform can't be looped with burst=1");
+
+  /* converted once, the callback copies it out as it is */
+  std::vector<int8_t> wave( samples.size() * BYTES_PER_SAMPLE );
+  if ( ! samples.empty() )
+    convert_fc32_sc8( &samples[0], &wave[0], samples.size() );
+
+  std::lock_guard<std::mutex> lock(_buf_mutex);
+
+  _wave.swap( wave );
+  _wave_pos = 0;
+  _buf_cond.notify_one();
+
+  return true;
+}
+
+osmosdr::stream_stats_t hackrf_sink_c::get_stream_stats( size_t chan )
+{
+  std::lock_guard<std::mutex> lock(_buf_mutex);
+
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _cbuf.count * BUF_LEN / BYTES_PER_SAMPLE;
+  stats.capacity = _queue_bufs * BUF_LEN / BYTES_PER_SAMPLE;
+
+  return stats;
+}
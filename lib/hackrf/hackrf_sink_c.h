@@ -25,11 +25,14 @@
 
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 #include <libhackrf/hackrf.h>
 
 #include "sink_iface.h"
 #include "hackrf_common.h"
+#include "thread_sched.h"
+#include "tx_policy.h"
 
 class hackrf_sink_c;
 
@@ -123,17 +126,49 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  bool set_waveform( const std::vector< gr_complex > &samples, size_t chan = 0 );
+
 private:
   static int _hackrf_tx_callback(hackrf_transfer* transfer);
   int hackrf_tx_callback(unsigned char *buffer, uint32_t length);
 
+  int queue_samples( const gr_complex *in, int nitems );
+  int work_burst( const gr_complex *in, int nitems );
+  void begin_burst();
+  void end_burst();
+  void start_tx();
+  void resume_after_underrun();
+  bool queue_has_room() const { return _cbuf.count < _queue_bufs; }   // _buf_mutex held
+  void fill_waveform( unsigned char *buffer, uint32_t length );
+
   circular_buffer_t _cbuf;
-  int8_t *_buf;
+  thread_sched_once _sched;
   unsigned int _buf_num;
   unsigned int _buf_used;
   bool _stopping;
+  osmosdr::stream_stats_t _stats;
   std::mutex _buf_mutex;
   std::condition_variable _buf_cond;
+  std::vector<gr::tag_t> _tags;
+
+  bool _burst;          // tx_sob / tx_eob tags gate the transmission
+  bool _turnaround;     // and pause a source on the same device meanwhile
+  bool _in_burst;
+  bool _tx_pending;     // start with the first buffer of the burst
+  bool _tx_running;
+  bool _burst_end;      // stop streaming once the queue ran empty
+  bool _tx_done;
+
+  tx_policy_t _policy;
+  unsigned int _prefill_bufs;   // queued before the stream starts
+  unsigned int _queue_bufs;     // queued at most, from tx_latency_ms=
+  std::vector<unsigned char> _last;   // sent again on an underrun=repeat
+  bool _underrun_stop;  // the callback ended the stream on an underrun=stop
+
+  std::vector<int8_t> _wave;  // looped by the callback instead of the queue
+  size_t _wave_pos;
 
   double _vga_gain;
 };
@@ -31,12 +31,21 @@
 #include <stdexcept>
 #include <iostream>
 #include <chrono>
+#include <cmath>
+
+#include <boost/algorithm/string.hpp>
 
 #include <gnuradio/io_signature.h>
 
 #include "hackrf_source_c.h"
 
 #include "arg_helpers.h"
+#include "sample_convert.h"
+
+/* every sweep block starts with 0x7f 0x7f and the frequency as uint64 LE */
+#define SWEEP_HEADER_LEN  10
+
+#define OUT_TRANSFERS  4 /* transfers the output buffer takes at least */
 
 hackrf_source_c_sptr make_hackrf_source_c (const std::string & args)
 {
@@ -65,13 +74,34 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     hackrf_common::hackrf_common(args),
-    _buf(NULL),
+    _min_buffers(3),
+    _latency(0),
+    _sc8(false),
+    _watchdog_timeout(0),
+    _running(false),
+    _paused(false),
+    _fast_retune(false),
+    _settle(0),
+    _settle_left(0),
+    _retune(false),
+    _retune_freq(0),
+    _flush_mark(0),
+    _rerate(false),
+    _rerate_rate(0),
+    _sweep(false),
+    _sweep_step(0),
+    _sweep_offset(0),
+    _sweep_dwell(1),
+    _sweep_freq(0),
     _lna_gain(0),
     _vga_gain(0)
 {
   dict_t dict = params_to_dict(args);
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _ring.set_buffer_opts( buffer_opts_from_dict( dict ) );
+  _sched = thread_sched_once( thread_sched_from_dict( dict ) );
+
+  _buf_num = _buf_len = 0;
 
   if (dict.count("buffers"))
     _buf_num = std::stoi(dict["buffers"]);
@@ -79,24 +109,111 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
 //  if (dict.count("buflen"))
 //    _buf_len = std::stoi(dict["buflen"]);
 
+  /* libhackrf uses fixed size transfers, so a latency target (in ms)
+   * can only be met by draining each transfer as soon as it arrives */
+  if (dict.count("latency")) {
+    _latency = std::stod(dict["latency"]) / 1e3;
+    _min_buffers = 0;
+  }
+
+  if (dict.count("min_buffers"))
+    _min_buffers = std::stoi(dict["min_buffers"]);
+
+  /* host side decimation while converting, the sample rates are divided
+   * accordingly */
+  if (dict.count("decim"))
+    _decimator.set_decimation( std::stoul(dict["decim"]) );
+
+  /* rx_time / rx_rate / rx_freq tags from the host clock */
+  _tagger.enable_rate_tags( true );
+  if (dict.count("timekey"))
+    _tagger.enable( std::stoi(dict["timekey"]) != 0 );
+  _tagger.set_id( pmt::string_to_symbol(args) );
+
+  /* restart streaming when it ends or stalls, the gap is told by the
+   * rx_time tag after it */
+  _watchdog_timeout = stream_watchdog::timeout_from_dict( dict );
+  if (_watchdog_timeout > 0)
+    _tagger.enable( true );
+
+  /* measured at the rate of the device, ahead of the decimator */
+  const double level_period = level_meter::period_from_dict( dict );
+  if (level_period > 0)
+    _level.attach( this, level_period );
+
+  /* on retune drop what was queued before, the transfer in flight and
+   * this many samples after it, the first one after is tagged with rx_freq */
+  if (dict.count("settle")) {
+    _fast_retune = true;
+    _settle = std::stoul(dict["settle"]);
+    _tagger.enable_freq_tags( true );
+  }
+
+  /* the firmware retunes by itself, every block is tagged with rx_freq */
+  if (dict.count("sweep")) {
+    std::vector< std::string > tokens;
+    boost::algorithm::split( tokens, dict["sweep"], boost::is_any_of(":") );
+
+    if ( tokens.size() < 2 || tokens.size() > 3 )
+      throw std::runtime_error("Sweep must be given as <start>:<stop>[:<step>] in Hz");
+
+    double start = std::stod( tokens[0] );
+    double stop = std::stod( tokens[1] );
+    if ( start < 0 || stop <= start || stop > get_freq_range().stop() )
+      throw std::runtime_error("Invalid sweep range " + dict["sweep"]);
+
+    _sweep_range[0] = uint16_t( start / 1e6 );
+    _sweep_range[1] = uint16_t( std::ceil( stop / 1e6 ) );
+
+    if ( tokens.size() > 2 )
+      _sweep_step = uint32_t( std::stod( tokens[2] ) );
+
+    if (dict.count("sweep_offset"))
+      _sweep_offset = uint32_t( std::stod(dict["sweep_offset"]) );
+
+    if (dict.count("sweep_dwell"))
+      _sweep_dwell = std::max( 1, std::stoi(dict["sweep_dwell"]) );
+
+    _sweep = true;
+    _tagger.enable_freq_tags( true );
+
+    if (_decimator.decimation() > 1)
+      throw std::runtime_error("decim= can't be combined with sweep=.");
+  }
+
+  /* stream only in windows, each one starts with rx_time and is handed
+   * out as soon as it arrives */
+  _snapshot.configure( dict );
+  if (_snapshot.enabled()) {
+    if (_sweep || _watchdog_timeout > 0)
+      throw std::runtime_error("snapshot= can't be combined with sweep= or watchdog=.");
+    _tagger.enable( true );
+    _min_buffers = 0;
+  }
+
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
 
+  if (_min_buffers > _buf_num)
+    _min_buffers = _buf_num;
+
   if (0 == _buf_len || _buf_len % 512 != 0) /* len must be multiple of 512 */
     _buf_len = BUF_LEN;
 
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
-
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i <= 0xff; i++) {
-    _lut.push_back( float(int8_t(i)) * (1.0f/128.0f) );
-  }
-
   if ( BUF_NUM != _buf_num || BUF_LEN != _buf_len ) {
     std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
               << std::endl;
   }
 
+  /* work() is asked for whole transfers, with room for a few of them, so
+   * a call drains what arrived rather than a bit of it. The blocks of a
+   * sweep lose their headers on the way. */
+  if ( ! _sweep ) {
+    const int transfer = _buf_len / BYTES_PER_SAMPLE / _decimator.decimation();
+    set_output_multiple( transfer );
+    set_min_output_buffer( OUT_TRANSFERS * transfer );
+  }
+
   set_center_freq( (get_freq_range().start() + get_freq_range().stop()) / 2.0 );
   set_sample_rate( get_sample_rates().start() );
   set_bandwidth( 0 );
@@ -107,17 +224,13 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
 
   set_bb_gain( 20 ); /* preset to a reasonable default (non-GRC use case) */
 
-  // Check device args to find out if bias/phantom power is desired.
-  if ( dict.count("bias") ) {
+  // Check device args to find out if bias/phantom power is desired,
+  // a device left open may still have it on.
+  if ( dict.count("bias") || _reused ) {
     hackrf_common::set_bias(dict["bias"] == "1");
   }
 
-  _buf = (unsigned char **) malloc(_buf_num * sizeof(unsigned char *));
-
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned char *) malloc(_buf_len);
-  }
+  _ring.resize( _buf_num * _buf_len );
 }
 
 /*
@@ -125,41 +238,125 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
  */
 hackrf_source_c::~hackrf_source_c ()
 {
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-  }
+  _watchdog.stop();
+  _snapshot.stop();
 }
 
 int hackrf_source_c::_hackrf_rx_callback(hackrf_transfer *transfer)
 {
   hackrf_source_c *obj = (hackrf_source_c *)transfer->rx_ctx;
+
+  obj->_sched.apply();
+
+  if (obj->_sweep)
+    return obj->hackrf_sweep_callback(transfer->buffer, transfer->valid_length);
+
   return obj->hackrf_rx_callback(transfer->buffer, transfer->valid_length);
 }
 
 int hackrf_source_c::hackrf_rx_callback(unsigned char *buf, uint32_t len)
 {
-  {
-    std::lock_guard<std::mutex> lock(_buf_mutex);
+  /* what's past the snapshot is dropped until the timer stops streaming */
+  if (_snapshot.enabled()) {
+    const uint32_t taken = _snapshot.take( len / BYTES_PER_SAMPLE ) * BYTES_PER_SAMPLE;
+    if (!taken)
+      return 0;
+    len = taken;
+  }
 
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
+  /* work() may still be converting the oldest transfer, so drop the new one */
+  if (_ring.space() < len) {
+    _stats.overrun( len / BYTES_PER_SAMPLE );
+    _tagger.overrun( len / BYTES_PER_SAMPLE );
+    std::cerr << "O" << std::flush;
+    return 0;
+  }
 
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
+  const size_t skip = settle_samples( len / BYTES_PER_SAMPLE ) * BYTES_PER_SAMPLE;
+  if (skip == len)
+    return 0;
+
+  _tagger.transfer( (len - skip) / BYTES_PER_SAMPLE );
+  _latency_stats.arrival( _ring.write_count() );
+  _ring.push((int8_t *)buf + skip, len - skip);
+  _watchdog.feed();
+
+  return 0; // TODO: return -1 on error/stop
+}
+
+int hackrf_source_c::hackrf_sweep_callback(unsigned char *buf, uint32_t len)
+{
+  if (_ring.space() < len) {
+    _stats.overrun( len / BYTES_PER_SAMPLE );
+    _tagger.overrun( len / BYTES_PER_SAMPLE );
+    std::cerr << "O" << std::flush;
+    return 0;
+  }
+
+  const size_t nsamples = (BYTES_PER_BLOCK - SWEEP_HEADER_LEN) / BYTES_PER_SAMPLE;
+
+  for (uint32_t i = 0; i + BYTES_PER_BLOCK <= len; i += BYTES_PER_BLOCK) {
+    const unsigned char *block = buf + i;
+
+    if (block[0] != 0x7f || block[1] != 0x7f) {
+      _tagger.skip( BYTES_PER_BLOCK / BYTES_PER_SAMPLE );
+      continue;
+    }
+
+    uint64_t freq = 0;
+    for (int b = SWEEP_HEADER_LEN - 1; b >= 2; b--)
+      freq = (freq << 8) | block[b];
+
+    /* the settle interval applies to the first block after each step */
+    if (freq != _sweep_freq) {
+      _sweep_freq = freq;
+      _settle_left = _settle;
+      _tagger.retune( double(freq + _sweep_offset) );
     }
+
+    /* the header took the place of the first samples */
+    const size_t skip = std::min( nsamples, _settle_left );
+    _settle_left -= skip;
+    _tagger.skip( SWEEP_HEADER_LEN / BYTES_PER_SAMPLE + skip );
+
+    if (skip == nsamples)
+      continue;
+
+    _tagger.transfer( nsamples - skip );
+    _latency_stats.arrival( _ring.write_count() );
+    _ring.push((const int8_t *)block + SWEEP_HEADER_LEN + skip * BYTES_PER_SAMPLE,
+               (nsamples - skip) * BYTES_PER_SAMPLE);
   }
 
-  _buf_cond.notify_one();
+  return 0;
+}
+
+/* number of leading samples of a transfer that belong to the settle interval */
+size_t hackrf_source_c::settle_samples( size_t nsamples )
+{
+  if (_retune.exchange( false, std::memory_order_acquire )) {
+    /* everything committed so far was captured before the retune, and
+     * so was most of this transfer, the settle interval counts from its
+     * end, the earliest the retune is known to have taken effect */
+    _flush_mark.store( _ring.write_count(), std::memory_order_release );
+    _settle_left = nsamples + _settle;
+    _tagger.retune( _retune_freq.load() );
+  }
 
-  return 0; // TODO: return -1 on error/stop
+  /* the same for a rate change, this transfer may still be partly at the
+   * old rate and goes as well, rx_rate comes with the next one */
+  if (_rerate.exchange( false, std::memory_order_acquire )) {
+    _flush_mark.store( _ring.write_count(), std::memory_order_release );
+    _settle_left = std::max( _settle, nsamples );
+    _tagger.rerate( _rerate_rate.load() );
+  }
+
+  const size_t skip = std::min( nsamples, _settle_left );
+
+  _settle_left -= skip;
+  _tagger.skip( skip );
+
+  return skip;
 }
 
 bool hackrf_source_c::start()
@@ -167,8 +364,72 @@ bool hackrf_source_c::start()
   if ( ! _dev.get() )
     return false;
 
+  _ring.reset();
+  _latency_stats.reset();
+  _sched.reset();
+  _decimator.reset();
+  /* the tagger counts the samples before decimation */
+  _tagger.start( hackrf_common::get_sample_rate(), get_center_freq() );
+  _level.set_sample_rate( hackrf_common::get_sample_rate() );
+  _retune = false;
+  _rerate = false;
+  _settle_left = 0;
+  _flush_mark = 0;
+  _sweep_freq = 0;
+
+  double transfer = _buf_len / BYTES_PER_SAMPLE / hackrf_common::get_sample_rate();
+  if ( _latency > 0 && transfer > _latency )
+    std::cerr << "Latency target of " << _latency * 1e3 << " ms is below the "
+              << transfer * 1e3 << " ms transfer length at this sample rate."
+              << std::endl;
+
   hackrf_common::start();
-  int ret = hackrf_start_rx( _dev.get(), _hackrf_rx_callback, (void *)this );
+
+  _running = true;
+  _paused = false;
+
+  /* the windows are streamed on the timer thread, a window that would
+   * fall into a burst of the sink is skipped */
+  if ( _snapshot.enabled() ) {
+    _snapshot.start( [this]() { return hackrf_common::get_sample_rate(); },
+                     [this]() {
+                       if ( _paused || ! start_rx() )
+                         return false;
+                       _tagger.set_rate( hackrf_common::get_sample_rate() );
+                       return true;
+                     },
+                     [this]() { hackrf_stop_rx( _dev.get() ); } );
+  } else if ( ! start_rx() ) {
+    _running = false;
+    return false;
+  }
+
+  _watchdog.start( _watchdog_timeout, [this]() { return restart_stream(); } );
+
+  /* a sink on the same device with turnaround=1 pauses us for its bursts */
+  set_rx_hooks( [this]() { pause_rx(); }, [this]() { return resume_rx(); } );
+
+  return true;
+}
+
+bool hackrf_source_c::start_rx()
+{
+  int ret;
+  if ( _sweep ) {
+    uint32_t step = _sweep_step ? _sweep_step : uint32_t(hackrf_common::get_sample_rate());
+
+    ret = hackrf_init_sweep( _dev.get(), _sweep_range, 1,
+                             _sweep_dwell * BYTES_PER_BLOCK, step, _sweep_offset,
+                             LINEAR );
+    if ( ret != HACKRF_SUCCESS ) {
+      std::cerr << "Failed to set up the sweep (" << ret << ")" << std::endl;
+      return false;
+    }
+
+    ret = hackrf_start_rx_sweep( _dev.get(), _hackrf_rx_callback, (void *)this );
+  } else {
+    ret = hackrf_start_rx( _dev.get(), _hackrf_rx_callback, (void *)this );
+  }
   if ( ret != HACKRF_SUCCESS ) {
     std::cerr << "Failed to start RX streaming (" << ret << ")" << std::endl;
     return false;
@@ -176,8 +437,72 @@ bool hackrf_source_c::start()
   return true;
 }
 
+/* The handle is shared with the sink, so streaming is restarted in place
+ * rather than by reopening the device. */
+bool hackrf_source_c::restart_stream()
+{
+  if ( ! _dev.get() )
+    return false;
+
+  /* no stall, the sink is transmitting */
+  if ( _paused )
+    return true;
+
+  hackrf_stop_rx( _dev.get() );
+
+  /* puts the cached frequency, rate and gains back */
+  hackrf_common::start();
+
+  if ( ! start_rx() )
+    return false;
+
+  _tagger.set_rate( hackrf_common::get_sample_rate() );
+  _stats.restarted();
+
+  return true;
+}
+
+/* The ring and the tagger carry on across the pause, the gap shows as
+ * a new rx_time once the stream resumes. */
+void hackrf_source_c::pause_rx()
+{
+  _paused = true;
+
+  int ret = hackrf_stop_rx( _dev.get() );
+  if ( ret != HACKRF_SUCCESS )
+    std::cerr << "Failed to pause RX streaming (" << ret << ")" << std::endl;
+
+  _snapshot.cut();
+}
+
+bool hackrf_source_c::resume_rx()
+{
+  /* the next window starts the stream */
+  if ( _snapshot.enabled() ) {
+    _paused = false;
+    return true;
+  }
+
+  /* the callback isn't running, the transmitter fades out meanwhile */
+  _settle_left = _settle;
+
+  if ( ! start_rx() )
+    return false;
+
+  _tagger.set_rate( hackrf_common::get_sample_rate() );
+  _paused = false;
+
+  return true;
+}
+
 bool hackrf_source_c::stop()
 {
+  clear_rx_hooks();
+
+  _running = false;
+  _watchdog.stop();
+  _snapshot.stop();
+
   if ( ! _dev.get() )
     return false;
 
@@ -190,66 +515,138 @@ bool hackrf_source_c::stop()
   return true;
 }
 
+/* a stream the watchdog restarts is waited for */
+bool hackrf_source_c::is_running()
+{
+  if ( _paused )
+    return true;
+
+  /* between snapshots the device doesn't stream on purpose */
+  if ( _watchdog.enabled() || _snapshot.enabled() )
+    return _running;
+
+  return hackrf_is_streaming( _dev.get() ) == HACKRF_TRUE;
+}
+
 int hackrf_source_c::work( int noutput_items,
                         gr_vector_const_void_star &input_items,
                         gr_vector_void_star &output_items )
 {
   gr_complex *out = (gr_complex *)output_items[0];
+  int8_t *out8 = (int8_t *)output_items[0];
+  int produced = 0;
+  convert_level_t level;
 
   bool running = false;
 
   if ( _dev.get() )
-    running = (hackrf_is_streaming( _dev.get() ) == HACKRF_TRUE);
-
-  {
-    std::unique_lock<std::mutex> lock(_buf_mutex);
+    running = is_running();
 
-    while (_buf_used < 3 && running) { // collect at least 3 buffers
-      _buf_cond.wait_for( lock , std::chrono::milliseconds(100));
+  size_t min_fill = std::max(_min_buffers * _buf_len, (unsigned int)BYTES_PER_SAMPLE);
 
-      // Re-check whether the device has closed or stopped streaming
-      if ( _dev.get() )
-        running = (hackrf_is_streaming( _dev.get() ) == HACKRF_TRUE);
-      else
-        running = false;
-    }
+  while (running && !_ring.wait_for( min_fill, std::chrono::milliseconds(100) )) {
+    // Re-check whether the device has closed or stopped streaming
+    if ( _dev.get() )
+      running = is_running();
+    else
+      running = false;
   }
 
   if ( ! running )
     return WORK_DONE;
 
-  const uint8_t *buf = _buf[_buf_head] + _buf_offset * BYTES_PER_SAMPLE;
-#define TO_COMPLEX(p) gr_complex( _lut[(p)[0]], _lut[(p)[1]] )
+  const size_t flushed = _ring.discard( _flush_mark.load( std::memory_order_acquire ) );
+  if (flushed) {
+    _tagger.discard( flushed / BYTES_PER_SAMPLE );
+    _latency_stats.discarded( _ring.read_count() );
+    _decimator.reset();
+  }
 
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; ++i)
-      *out++ = TO_COMPLEX( buf + i*BYTES_PER_SAMPLE );
+  if (_decimator.decimation() > 1)
+    return work_decimated( noutput_items, out );
 
-    _buf_offset += noutput_items;
-    _samp_avail -= noutput_items;
-  } else {
-    for (int i = 0; i < _samp_avail; ++i)
-      *out++ = TO_COMPLEX( buf + i*BYTES_PER_SAMPLE );
+  while (produced < noutput_items) {
+    size_t len;
+    const int8_t *buf = _ring.read_ptr( len );
+    const int nout = std::min<size_t>(noutput_items - produced, len / BYTES_PER_SAMPLE);
 
-    {
-      std::lock_guard<std::mutex> lock(_buf_mutex);
+    if (!nout)
+      break;
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+    if (_sc8)
+      memcpy( out8, buf, nout * BYTES_PER_SAMPLE );
+    else if (_level.enabled())
+      convert_s8_fc32_level( buf, out, nout, &level );
+    else
+      convert_s8_fc32( buf, out, nout );
+    out += nout;
+    out8 += nout * 2;
+
+    produced += nout;
+    _ring.consume( nout * BYTES_PER_SAMPLE );
+  }
+
+  _latency_stats.consumed( _ring.read_count(), _ring.size() );
+  _stats.produced( produced );
+  if (level.values)
+    _level.add( 0, level );
+
+  if (_tagger.enabled()) {
+    _tagger.get_tags( nitems_written(0), produced, _tags );
+    for (const gr::tag_t &tag : _tags)
+      add_item_tag( 0, tag );
+  }
+
+  return produced;
+}
+
+/* converts and decimates in one pass, the full rate samples never reach
+ * the output buffer */
+int hackrf_source_c::work_decimated( int noutput_items, gr_complex *out )
+{
+  const size_t decim = _decimator.decimation();
+  const size_t held = _decimator.pending();
+  size_t consumed = 0;
+  int produced = 0;
+  convert_level_t level;
 
-    buf = _buf[_buf_head];
+  while (true) {
+    size_t len;
+    const int8_t *buf = _ring.read_ptr( len );
+    const size_t nin = std::min<size_t>( noutput_items * decim - held - consumed,
+                                         len / BYTES_PER_SAMPLE );
 
-    int remaining = noutput_items - _samp_avail;
+    if (!nin)
+      break;
 
-    for (int i = 0; i < remaining; ++i)
-      *out++ = TO_COMPLEX( buf + i*BYTES_PER_SAMPLE );
+    if (_level.enabled())
+      produced += _decimator.convert( buf, nin, out + produced,
+          [&level]( const int8_t *in, gr_complex *to, size_t n ) {
+            convert_s8_fc32_level( in, to, n, &level ); } );
+    else
+      produced += _decimator.convert( buf, nin, out + produced, convert_s8_fc32 );
+
+    consumed += nin;
+    _ring.consume( nin * BYTES_PER_SAMPLE );
+  }
 
-    _buf_offset = remaining;
-    _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
+  _latency_stats.consumed( _ring.read_count(), _ring.size() );
+  _stats.produced( produced );
+  if (level.values)
+    _level.add( 0, level );
+
+  if (_tagger.enabled()) {
+    /* the samples held back come first in the next output sample */
+    _tagger.get_tags( 0, consumed, _tags );
+    for (gr::tag_t &tag : _tags) {
+      tag.offset = nitems_written(0) + (tag.offset + held) / decim;
+      if ( pmt::eq( tag.key, stream_tagger::RATE_KEY() ) )
+        tag.value = pmt::from_double( get_sample_rate() );
+      add_item_tag( 0, tag );
+    }
   }
 
-  return noutput_items;
+  return produced;
 }
 
 std::vector<std::string> hackrf_source_c::get_devices()
@@ -264,17 +661,34 @@ size_t hackrf_source_c::get_num_channels()
 
 osmosdr::meta_range_t hackrf_source_c::get_sample_rates()
 {
-  return hackrf_common::get_sample_rates();
+  const double decim = _decimator.decimation();
+  osmosdr::meta_range_t range;
+
+  for (const osmosdr::range_t &r : hackrf_common::get_sample_rates())
+    range.push_back( osmosdr::range_t( r.start() / decim, r.stop() / decim, r.step() / decim ) );
+
+  return range;
 }
 
 double hackrf_source_c::set_sample_rate( double rate )
 {
-  return hackrf_common::set_sample_rate(rate);
+  double actual = hackrf_common::set_sample_rate(rate * _decimator.decimation());
+  _level.set_sample_rate( actual );
+
+  if ( _running && ! _sweep && ! _snapshot.enabled() ) {
+    /* the callback flushes what came at the old rate and tags the new one */
+    _rerate_rate.store( actual );
+    _rerate.store( true, std::memory_order_release );
+  } else {
+    _tagger.set_rate( actual );
+  }
+
+  return actual / _decimator.decimation();
 }
 
 double hackrf_source_c::get_sample_rate()
 {
-  return hackrf_common::get_sample_rate();
+  return hackrf_common::get_sample_rate() / _decimator.decimation();
 }
 
 osmosdr::freq_range_t hackrf_source_c::get_freq_range( size_t chan )
@@ -284,7 +698,21 @@ osmosdr::freq_range_t hackrf_source_c::get_freq_range( size_t chan )
 
 double hackrf_source_c::set_center_freq( double freq, size_t chan )
 {
-  return hackrf_common::set_center_freq(freq, chan);
+  /* retuning from the host would get in the way of the firmware */
+  if ( _sweep && _dev.get() && hackrf_is_streaming( _dev.get() ) == HACKRF_TRUE )
+    return get_center_freq( chan );
+
+  double actual = hackrf_common::set_center_freq(freq, chan);
+
+  if (_fast_retune) {
+    /* the libhackrf thread picks it up with the next transfer */
+    _retune_freq.store( actual );
+    _retune.store( true, std::memory_order_release );
+  } else {
+    _tagger.retune( actual );
+  }
+
+  return actual;
 }
 
 double hackrf_source_c::get_center_freq( size_t chan )
@@ -450,3 +878,31 @@ osmosdr::freq_range_t hackrf_source_c::get_bandwidth_range( size_t chan )
 {
   return hackrf_common::get_bandwidth_range(chan);
 }
+
+osmosdr::stream_stats_t hackrf_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats;
+
+  _stats.get_stats( stats );
+
+  stats.fill = _ring.size() / BYTES_PER_SAMPLE;
+  stats.fill_max = _ring.fill_max() / BYTES_PER_SAMPLE;
+  stats.capacity = _ring.capacity() / BYTES_PER_SAMPLE;
+  _latency_stats.get_stats( stats, BYTES_PER_SAMPLE );
+  _level.get_stats( chan, stats );
+
+  return stats;
+}
+
+/* 8 bit samples are handed out as they come, without going through float */
+bool hackrf_source_c::set_output_type( const std::string &type )
+{
+  /* decimated samples are fc32, source_impl converts them */
+  if ( "sc8" != type || _decimator.decimation() > 1 )
+    return "fc32" == type;
+
+  _sc8 = true;
+  set_output_signature( gr::io_signature::make(MIN_OUT, MAX_OUT, item_type_to_size(type)) );
+
+  return true;
+}
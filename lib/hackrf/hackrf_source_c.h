@@ -23,13 +23,19 @@
 
 #include <gnuradio/sync_block.h>
 
-#include <condition_variable>
-#include <mutex>
-
 #include <libhackrf/hackrf.h>
 
 #include "source_iface.h"
 #include "hackrf_common.h"
+#include "halfband_decimator.h"
+#include "latency_stats.h"
+#include "stream_counters.h"
+#include "level_meter.h"
+#include "spsc_ring.h"
+#include "stream_tagger.h"
+#include "snapshot_timer.h"
+#include "stream_watchdog.h"
+#include "thread_sched.h"
 
 class hackrf_source_c;
 
@@ -119,22 +125,59 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  bool set_output_type( const std::string &type );
+
 private:
   static int _hackrf_rx_callback(hackrf_transfer* transfer);
   int hackrf_rx_callback(unsigned char *buf, uint32_t len);
-
-  std::vector<float> _lut;
-
-  unsigned char **_buf;
+  int hackrf_sweep_callback(unsigned char *buf, uint32_t len);
+  int work_decimated( int noutput_items, gr_complex *out );
+  size_t settle_samples( size_t nsamples );
+  bool start_rx();
+  bool restart_stream();
+  bool is_running();
+  void pause_rx();
+  bool resume_rx();
+
+  spsc_ring<int8_t> _ring;
+  thread_sched_once _sched;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  std::mutex _buf_mutex;
-  std::condition_variable _buf_cond;
-
-  unsigned int _buf_offset;
-  int _samp_avail;
+  unsigned int _min_buffers;
+  double _latency;
+  stream_counters _stats;
+  latency_stats _latency_stats;
+  level_meter _level;
+  bool _sc8;
+  halfband_decimator _decimator;
+  stream_tagger _tagger;
+  std::vector<gr::tag_t> _tags;
+
+  stream_watchdog _watchdog;
+  double _watchdog_timeout;
+  std::atomic<bool> _running;
+  std::atomic<bool> _paused;    // while the sink transmits, see turn_to_tx()
+  snapshot_timer _snapshot;     // snapshot=, starts and stops streaming
+
+  bool _fast_retune;
+  size_t _settle;
+  size_t _settle_left;
+  std::atomic<bool> _retune;
+  std::atomic<double> _retune_freq;
+  std::atomic<size_t> _flush_mark;
+
+  /* a rate change while streaming, applied by the callback like a retune */
+  std::atomic<bool> _rerate;
+  std::atomic<double> _rerate_rate;
+
+  bool _sweep;
+  uint16_t _sweep_range[2];   // MHz, as the firmware wants it
+  uint32_t _sweep_step;
+  uint32_t _sweep_offset;
+  unsigned int _sweep_dwell;  // blocks per step
+  uint64_t _sweep_freq;       // of the last block header
 
   double _lna_gain;
   double _vga_gain;
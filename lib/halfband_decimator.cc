@@ -0,0 +1,133 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "halfband_decimator.h"
+#include "airspy_fir_kernels.h"
+
+halfband_decimator::halfband_decimator() :
+  _decim(1),
+  _pending(0)
+{
+}
+
+void halfband_decimator::set_decimation( size_t decim )
+{
+  _stages.clear();
+
+  /* the kernel is named after the decimation still ahead of the stage */
+  for (size_t left = decim; left > 1; left /= 2) {
+    const float *kernel;
+    size_t len;
+
+    switch (left) {
+    case 16: kernel = KERNEL_16_110; len = KERNEL_16_110_LEN; break;
+    case 8:  kernel = KERNEL_8_100;  len = KERNEL_8_100_LEN;  break;
+    case 4:  kernel = KERNEL_4_90;   len = KERNEL_4_90_LEN;   break;
+    case 2:  kernel = KERNEL_2_80;   len = KERNEL_2_80_LEN;   break;
+    default:
+      throw std::runtime_error("Decimation must be 1, 2, 4, 8 or 16");
+    }
+
+    stage_t stage;
+    for (size_t i = 0; i < len; i += 2)
+      stage.taps.push_back( kernel[i] );
+    stage.delay = (len / 2 + 1) / 2;
+
+    _stages.push_back( stage );
+  }
+
+  _decim = decim;
+
+  reset();
+}
+
+void halfband_decimator::reset()
+{
+  _pending = 0;
+
+  for (stage_t &stage : _stages) {
+    stage.even.assign( 2 * (stage.taps.size() - 1), 0.0f );
+    stage.odd.assign( 2 * stage.delay, 0.0f );
+  }
+}
+
+void halfband_decimator::process_stage( stage_t &stage, const float *in, float *out, size_t nout )
+{
+  const size_t hist_even = 2 * (stage.taps.size() - 1);
+  const size_t hist_odd = 2 * stage.delay;
+
+  stage.even.resize( hist_even + 2 * nout );
+  stage.odd.resize( hist_odd + 2 * nout );
+
+  float *even = &stage.even[hist_even];
+  float *odd = &stage.odd[hist_odd];
+
+  for (size_t m = 0; m < nout; m++) {
+    even[2 * m]     = in[4 * m];
+    even[2 * m + 1] = in[4 * m + 1];
+    odd[2 * m]      = in[4 * m + 2];
+    odd[2 * m + 1]  = in[4 * m + 3];
+  }
+
+  /* the center tap of every half-band kernel is 0.5 */
+  for (size_t k = 0; k < 2 * nout; k++)
+    out[k] = 0.5f * stage.odd[k];
+
+  for (size_t j = 0; j < stage.taps.size(); j++) {
+    const float tap = stage.taps[j];
+    const float *src = &stage.even[2 * j];
+
+    for (size_t k = 0; k < 2 * nout; k++)
+      out[k] += tap * src[k];
+  }
+
+  std::copy( stage.even.end() - hist_even, stage.even.end(), stage.even.begin() );
+  std::copy( stage.odd.end() - hist_odd, stage.odd.end(), stage.odd.begin() );
+}
+
+size_t halfband_decimator::process( const gr_complex *in, gr_complex *out, size_t nitems )
+{
+  if (_stages.empty()) {
+    std::copy( in, in + nitems, out );
+    return nitems;
+  }
+
+  const float *src = (const float *)in;
+
+  for (size_t i = 0; i < _stages.size(); i++) {
+    nitems /= 2;
+
+    float *dst;
+    if (i + 1 == _stages.size()) {
+      dst = (float *)out;
+    } else {
+      _buf[i % 2].resize( nitems );
+      dst = (float *)&_buf[i % 2][0];
+    }
+
+    process_stage( _stages[i], src, dst, nitems );
+    src = dst;
+  }
+
+  return nitems;
+}
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_HALFBAND_DECIMATOR_H
+#define INCLUDED_HALFBAND_DECIMATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <gnuradio/gr_complex.h>
+
+/*!
+ * Cascade of complex half-band decimators by 2, using the kernels from
+ * airspy_fir_kernels.h. The first stages run at the highest rate and get
+ * the short kernels, the last one gets the sharpest (KERNEL_2_80), the
+ * same way the airspy libraries cascade them. Shared by the backends
+ * taking decim=.
+ *
+ * Every stage is split into its two polyphase branches. Only the even
+ * taps of a half-band kernel are nonzero besides the center one, so the
+ * odd branch is a plain delay. The even branch is filtered tap by tap
+ * over contiguous floats, which the compiler vectorizes.
+ */
+class halfband_decimator
+{
+public:
+  halfband_decimator();
+
+  /*! \p decim must be a power of 2 up to 16, 1 passes samples through */
+  void set_decimation( size_t decim );
+  size_t decimation() const { return _decim; }
+
+  void reset();
+
+  /*!
+   * Decimate \p nitems samples, which must be a multiple of decimation().
+   * Returns the number of samples written to \p out.
+   */
+  size_t process( const gr_complex *in, gr_complex *out, size_t nitems );
+
+  /*!
+   * Convert \p nitems raw samples with \p convert( in, out, nitems ) and
+   * decimate them, a slice that stays in the cache at a time, so only the
+   * decimated samples get written to \p out. Any \p nitems is taken, what
+   * falls short of a multiple of decimation() is held back for the next
+   * call, see pending(). Returns the number of samples written to \p out.
+   */
+  template< typename T, typename F >
+  size_t convert( const T *in, size_t nitems, gr_complex *out, F convert )
+  {
+    size_t nout = 0;
+
+    _slice.resize( SLICE );
+
+    while ( nitems ) {
+      const size_t n = std::min( nitems, size_t(SLICE) - _pending );
+
+      convert( in, &_slice[ _pending ], n );
+      in += n;
+      nitems -= n;
+      _pending += n;
+
+      const size_t usable = _pending - _pending % _decim;
+      nout += process( &_slice[0], out + nout, usable );
+
+      std::copy( _slice.begin() + usable, _slice.begin() + _pending, _slice.begin() );
+      _pending -= usable;
+    }
+
+    return nout;
+  }
+
+  /*! samples convert() holds back, they come before the ones of the next call */
+  size_t pending() const { return _pending; }
+
+private:
+  enum { SLICE = 4096 };              // samples converted at a time, 32 KB
+  struct stage_t
+  {
+    std::vector<float> taps;    // even taps of the half-band kernel
+    size_t delay;               // odd branch delay in samples
+    std::vector<float> even;    // I/Q history followed by the current block
+    std::vector<float> odd;
+  };
+
+  void process_stage( stage_t &stage, const float *in, float *out, size_t nout );
+
+  size_t _decim;
+  std::vector<stage_t> _stages;
+  std::vector<gr_complex> _buf[2];  // between the stages
+  std::vector<gr_complex> _slice;   // converted, ahead of the first stage
+  size_t _pending;
+};
+
+#endif /* INCLUDED_HALFBAND_DECIMATOR_H */
@@ -0,0 +1,159 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include "hop_scheduler.h"
+
+#define HOP_LEAD 0.02             // seconds a timed hop goes out early
+#define HOP_MAX_PENDING 8         // timed hops queued in the device at most
+#define WAIT_SLICE 0.1            // seconds, longest sleep between clock reads
+
+hop_scheduler::hop_scheduler(
+    const std::function< void( size_t index, const ::osmosdr::time_spec_t &time ) > &hop,
+    const std::function< ::osmosdr::time_spec_t() > &time_now,
+    size_t nhops, const std::vector<double> &dwell,
+    const ::osmosdr::time_spec_t &start, bool timed )
+  : _hop(hop),
+    _time_now(time_now),
+    _nhops(nhops),
+    _dwell(dwell),
+    _start(start),
+    _timed(timed),
+    _running(true)
+{
+  if ( ! _nhops )
+    throw std::runtime_error("The hop schedule is empty.");
+
+  if ( _dwell.size() != 1 && _dwell.size() != _nhops )
+    throw std::runtime_error("Give one dwell time, or one per frequency.");
+
+  for (double d : _dwell)
+    if ( ! ( d > 0 ) )
+      throw std::runtime_error("Dwell times must be positive.");
+
+  _thread = gr::thread::thread( boost::bind( &hop_scheduler::control_task, this ) );
+}
+
+hop_scheduler::~hop_scheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock( _lock );
+
+    _running = false;
+  }
+
+  _cond.notify_one();
+
+  if ( _thread.joinable() )
+    _thread.join();
+}
+
+double hop_scheduler::dwell( size_t index ) const
+{
+  return _dwell.size() == 1 ? _dwell[0] : _dwell[index];
+}
+
+::osmosdr::time_spec_t hop_scheduler::now()
+{
+  ::osmosdr::time_spec_t now = _time_now();
+
+  if ( now.get_real_secs() <= 0 )
+    now = ::osmosdr::time_spec_t::get_system_time();
+
+  return now;
+}
+
+/* false if stopped while waiting. The device clock is read again after
+ * every slice, it need not run at the pace of the host clock. */
+bool hop_scheduler::wait_until( const ::osmosdr::time_spec_t &time )
+{
+  while ( true )
+  {
+    ::osmosdr::time_spec_t delay = time;
+    delay -= now();
+
+    const double secs = delay.get_real_secs();
+
+    std::unique_lock<std::mutex> lock( _lock );
+
+    if ( ! _running )
+      return false;
+
+    if ( secs <= 0 )
+      return true;
+
+    _cond.wait_for( lock, std::chrono::duration< double >( std::min( secs, WAIT_SLICE ) ),
+                    [this]() { return ! _running; } );
+  }
+}
+
+void hop_scheduler::control_task()
+{
+  /* the device can't hold more than a few timed hops */
+  double min_dwell = *std::min_element( _dwell.begin(), _dwell.end() );
+  const ::osmosdr::time_spec_t lead( _timed ? std::min( HOP_LEAD, HOP_MAX_PENDING * min_dwell ) : 0.0 );
+
+  ::osmosdr::time_spec_t next = _start;
+  if ( next.get_real_secs() <= 0 )
+    next = now() + lead;
+
+  size_t index = 0;
+
+  while ( wait_until( next - lead ) )
+  {
+    /* skip what can no longer be hopped to in time: timed hops that are
+     * due already, untimed ones whose dwell is over */
+    const ::osmosdr::time_spec_t t = now();
+    size_t missed = 0;
+
+    while ( ( _timed ? ! ( t < next ) :
+              ! ( t < next + ::osmosdr::time_spec_t( dwell( index ) ) ) ) )
+    {
+      next += ::osmosdr::time_spec_t( dwell( index ) );
+      index = ( index + 1 ) % _nhops;
+      missed++;
+    }
+
+    if ( missed ) {
+      std::cerr << "Frequency hopping fell behind, skipped " << missed
+                << " hops." << std::endl;
+      continue;
+    }
+
+    try {
+      _hop( index, _timed ? next : ::osmosdr::time_spec_t() );
+    } catch ( std::exception &e ) {
+      std::cerr << "Failed to hop: " << e.what() << std::endl;
+    }
+
+    next += ::osmosdr::time_spec_t( dwell( index ) );
+    index = ( index + 1 ) % _nhops;
+  }
+}
@@ -0,0 +1,81 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_HOP_SCHEDULER_H
+#define INCLUDED_HOP_SCHEDULER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <gnuradio/thread/thread.h>
+
+#include "osmosdr/time_spec.h"
+
+/*!
+ * \brief Walks a frequency hopping schedule on a thread of its own.
+ *
+ * Hop i of the list starts at \p start plus the dwell times of the hops
+ * before it, and the list repeats until the scheduler is destroyed. The
+ * times are absolute, so a late wakeup delays one hop but not the ones
+ * after it, and hops whose time already passed are skipped.
+ *
+ * With \p timed the hops are handed to the device HOP_LEAD seconds early,
+ * together with their time, and the device retunes at that time.
+ * Otherwise \p hop is called when \p time_now reaches the hop, with a
+ * time of 0, which is as exact as the host can sleep.
+ */
+class hop_scheduler
+{
+public:
+  /*!
+   * \param hop retunes to entry \p index, at \p time or now if it is 0
+   * \param time_now the device time the schedule is given in
+   * \param nhops entries of the hop list
+   * \param dwell seconds spent on every entry, a single value for all
+   * \param start time of the first hop, 0 for as soon as possible
+   * \param timed whether \p hop takes a time the device retunes at
+   */
+  hop_scheduler( const std::function< void( size_t index, const ::osmosdr::time_spec_t &time ) > &hop,
+                 const std::function< ::osmosdr::time_spec_t() > &time_now,
+                 size_t nhops, const std::vector<double> &dwell,
+                 const ::osmosdr::time_spec_t &start, bool timed );
+  ~hop_scheduler();
+
+private:
+  void control_task();
+  bool wait_until( const ::osmosdr::time_spec_t &time );
+  ::osmosdr::time_spec_t now();
+  double dwell( size_t index ) const;
+
+  std::function< void( size_t index, const ::osmosdr::time_spec_t &time ) > _hop;
+  std::function< ::osmosdr::time_spec_t() > _time_now;
+  size_t _nhops;
+  std::vector<double> _dwell;
+  ::osmosdr::time_spec_t _start;
+  bool _timed;
+
+  std::mutex _lock;
+  std::condition_variable _cond;
+  bool _running;
+  gr::thread::thread _thread;
+};
+
+#endif /* INCLUDED_HOP_SCHEDULER_H */
@@ -0,0 +1,258 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "osmosdr/source.h"
+#include "iq_correct.h"
+
+#define LANES 8   // independent accumulators, so the sums vectorize too
+#define ROT_LANES 8       // phasors of the frequency shift
+#define ROT_RESYNC 1024   // samples between two exact phasors
+
+iq_correct_sptr make_iq_correct (double tau)
+{
+  return gnuradio::get_initial_sptr(new iq_correct (tau));
+}
+
+iq_correct::iq_correct (double tau)
+  : gr::sync_block ("iq_correct",
+        gr::io_signature::make(1, 1, sizeof (gr_complex)),
+        gr::io_signature::make(1, 1, sizeof (gr_complex))),
+    _tau(tau),
+    _rate(0),
+    _dc_mode(osmosdr::source::DCOffsetOff),
+    _dc(0),
+    _iq_mode(osmosdr::source::IQBalanceOff),
+    _coef(0),
+    _sq(0),
+    _pow(0),
+    _shift(0),
+    _phase(0)
+{
+  if ( tau <= 0 )
+    throw std::runtime_error("The correction time constant must be positive.");
+}
+
+void iq_correct::set_sample_rate( double rate )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  _rate = rate;
+}
+
+void iq_correct::set_dc_offset_mode( int mode )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  /* off starts the average over, manual holds the last one */
+  if ( osmosdr::source::DCOffsetOff == mode )
+    _dc = 0;
+
+  _dc_mode = mode;
+}
+
+void iq_correct::set_dc_offset( const std::complex<double> &offset )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( osmosdr::source::DCOffsetAutomatic != _dc_mode )
+    _dc = gr_complex( offset.real(), offset.imag() );
+}
+
+void iq_correct::set_iq_balance_mode( int mode )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( osmosdr::source::IQBalanceOff == mode ) {
+    _coef = 0;
+    _sq = 0;
+    _pow = 0;
+  }
+
+  _iq_mode = mode;
+}
+
+void iq_correct::set_iq_balance( const std::complex<double> &balance )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  if ( osmosdr::source::IQBalanceAutomatic != _iq_mode )
+    _coef = gr_complex( balance.real(), balance.imag() );
+}
+
+void iq_correct::set_freq_shift( double hz )
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  _shift = hz;
+}
+
+bool iq_correct::enabled()
+{
+  std::lock_guard<std::mutex> lock( _lock );
+
+  bool dc = osmosdr::source::DCOffsetAutomatic == _dc_mode ||
+            ( osmosdr::source::DCOffsetManual == _dc_mode && _dc != 0.0f );
+  bool iq = osmosdr::source::IQBalanceAutomatic == _iq_mode ||
+            ( osmosdr::source::IQBalanceManual == _iq_mode && _coef != 0.0f );
+
+  return dc || iq || _shift != 0;
+}
+
+int iq_correct::work( int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items )
+{
+  const float *in = (const float *)input_items[0];
+  float *out = (float *)output_items[0];
+  const size_t nitems = noutput_items;
+  const size_t n = 2 * nitems;  // floats, I and Q interleaved
+
+  std::lock_guard<std::mutex> lock( _lock );
+
+  /* weight of this call in the averages */
+  float alpha = 1.0f;
+  if ( _rate > 0 )
+    alpha = 1.0f - std::exp( -double(nitems) / ( _tau * _rate ) );
+
+  if ( osmosdr::source::DCOffsetAutomatic == _dc_mode ) {
+    float acc[LANES] = { 0 };
+    size_t i = 0;
+
+    for (; i + LANES <= n; i += LANES)
+      for (size_t j = 0; j < LANES; j++)
+        acc[j] += in[i + j];
+    for (; i < n; i++)
+      acc[i % 2] += in[i];
+
+    gr_complex sum( 0 );
+    for (size_t j = 0; j < LANES; j += 2)
+      sum += gr_complex( acc[j], acc[j + 1] );
+
+    _dc += alpha * ( sum / float(nitems) - _dc );
+  }
+
+  const gr_complex dc = osmosdr::source::DCOffsetOff == _dc_mode ? 0 : _dc;
+  const float dc_i = dc.real(), dc_q = dc.imag();
+
+  /* to first order c = -E[in^2] / (2 E[|in|^2]) cancels the image */
+  if ( osmosdr::source::IQBalanceAutomatic == _iq_mode ) {
+    float ii[LANES] = { 0 }, qq[LANES] = { 0 }, iq[LANES] = { 0 };
+    size_t k = 0;
+
+    for (; k + LANES <= nitems; k += LANES)
+      for (size_t j = 0; j < LANES; j++) {
+        const float x = in[2 * (k + j)] - dc_i, y = in[2 * (k + j) + 1] - dc_q;
+        ii[j] += x * x;
+        qq[j] += y * y;
+        iq[j] += x * y;
+      }
+    for (; k < nitems; k++) {
+      const float x = in[2 * k] - dc_i, y = in[2 * k + 1] - dc_q;
+      ii[0] += x * x;
+      qq[0] += y * y;
+      iq[0] += x * y;
+    }
+
+    float sii = 0, sqq = 0, siq = 0;
+    for (size_t j = 0; j < LANES; j++) {
+      sii += ii[j];
+      sqq += qq[j];
+      siq += iq[j];
+    }
+
+    _sq += alpha * ( gr_complex( sii - sqq, 2 * siq ) / float(nitems) - _sq );
+    _pow += alpha * ( ( sii + sqq ) / float(nitems) - _pow );
+
+    if ( _pow > 0 )
+      _coef = -_sq / ( 2.0f * _pow );
+  }
+
+  const gr_complex coef = osmosdr::source::IQBalanceOff == _iq_mode ? 0 : _coef;
+  const float c_r = coef.real(), c_i = coef.imag();
+
+  if ( _shift == 0 || _rate <= 0 ) {
+    if ( dc == 0.0f && coef == 0.0f ) {
+      std::copy( in, in + n, out );
+      return noutput_items;
+    }
+
+    for (size_t i = 0; i < n; i += 2) {
+      const float x = in[i] - dc_i, y = in[i + 1] - dc_q;
+      out[i] = x + c_r * x + c_i * y;
+      out[i + 1] = y + c_i * x - c_r * y;
+    }
+
+    return noutput_items;
+  }
+
+  /* the offset, the balance and the rotation in the one pass writing the
+   * output. Each lane has its own phasor, all stepped by the rotation of
+   * ROT_LANES samples, and they are set from the phase in double every
+   * ROT_RESYNC samples so the float rounding can't build up. */
+  const double step = 2 * M_PI * _shift / _rate;
+  float p_r[ROT_LANES], p_i[ROT_LANES];
+  const float s_r = std::cos( step * ROT_LANES ), s_i = std::sin( step * ROT_LANES );
+
+  for (size_t k = 0; k < nitems; k += ROT_RESYNC) {
+    const size_t end = std::min( nitems, k + ROT_RESYNC );
+    size_t m = k;
+
+    for (size_t j = 0; j < ROT_LANES; j++) {
+      const double phi = _phase + step * double(k + j);
+      p_r[j] = std::cos( phi );
+      p_i[j] = std::sin( phi );
+    }
+
+    for (; m + ROT_LANES <= end; m += ROT_LANES) {
+      for (size_t j = 0; j < ROT_LANES; j++) {
+        const float x = in[2 * (m + j)] - dc_i, y = in[2 * (m + j) + 1] - dc_q;
+        const float u = x + c_r * x + c_i * y, v = y + c_i * x - c_r * y;
+        out[2 * (m + j)] = u * p_r[j] - v * p_i[j];
+        out[2 * (m + j) + 1] = u * p_i[j] + v * p_r[j];
+      }
+      for (size_t j = 0; j < ROT_LANES; j++) {
+        const float r = p_r[j];
+        p_r[j] = r * s_r - p_i[j] * s_i;
+        p_i[j] = r * s_i + p_i[j] * s_r;
+      }
+    }
+
+    for (size_t j = 0; m < end; m++, j++) {
+      const float x = in[2 * m] - dc_i, y = in[2 * m + 1] - dc_q;
+      const float u = x + c_r * x + c_i * y, v = y + c_i * x - c_r * y;
+      out[2 * m] = u * p_r[j] - v * p_i[j];
+      out[2 * m + 1] = u * p_i[j] + v * p_r[j];
+    }
+  }
+
+  _phase = std::remainder( _phase + step * double(nitems), 2 * M_PI );
+
+  return noutput_items;
+}
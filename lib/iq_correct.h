@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_IQ_CORRECT_H
+#define INCLUDED_IQ_CORRECT_H
+
+#include <complex>
+#include <mutex>
+
+#include <gnuradio/sync_block.h>
+
+class iq_correct;
+
+typedef std::shared_ptr<iq_correct> iq_correct_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of iq_correct.
+ * \param tau the time constant of the estimation in seconds
+ */
+iq_correct_sptr make_iq_correct (double tau);
+
+/*!
+ * \brief Corrects the DC offset and IQ balance of a channel in software.
+ *
+ * Used by the source for devices that can't do it themselves. The modes
+ * are the ones of osmosdr::source. The balance is the coefficient c of
+ * out = in + c * conj(in), like the one UHD and SoapySDR take.
+ *
+ * In automatic mode the offset is the long-run average of the signal and
+ * c the one cancelling its image, both averaged over tau seconds. The
+ * estimates move once per call of work(), so the loops over the samples
+ * are plain float arithmetic the compiler vectorizes.
+ *
+ * A frequency shift, for the ppm correction of devices that have none,
+ * is applied by the same loop that writes the corrected samples. That
+ * only comes for free along with a software offset or balance correction,
+ * on its own the block is one more pass and copy in the path of the
+ * channel, and setting it while running rewires the path.
+ */
+class iq_correct : public gr::sync_block
+{
+private:
+  friend iq_correct_sptr make_iq_correct (double tau);
+
+  iq_correct (double tau);  	// private constructor
+
+public:
+  void set_sample_rate( double rate );
+
+  void set_dc_offset_mode( int mode );
+  void set_dc_offset( const std::complex<double> &offset );
+
+  void set_iq_balance_mode( int mode );
+  void set_iq_balance( const std::complex<double> &balance );
+
+  /*! move the signal up by \p hz, 0 turns the rotation off */
+  void set_freq_shift( double hz );
+
+  /*! \return whether samples are changed at all, the source leaves the
+   * block out of the path of the channel otherwise */
+  bool enabled();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  std::mutex _lock;
+  double _tau;
+  double _rate;
+
+  int _dc_mode;
+  gr_complex _dc;               // subtracted offset
+
+  int _iq_mode;
+  gr_complex _coef;             // applied balance
+  gr_complex _sq;               // average of in^2
+  float _pow;                   // average of |in|^2
+
+  double _shift;                // in Hz
+  double _phase;                // of the next sample, in radians
+};
+
+#endif /* INCLUDED_IQ_CORRECT_H */
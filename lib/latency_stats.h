@@ -0,0 +1,217 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_LATENCY_STATS_H
+#define OSMOSDR_LATENCY_STATS_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include <osmosdr/stream_stats.h>
+
+#ifdef ENABLE_LATENCY_STATS
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include "spsc_ring.h"
+
+#define LATENCY_EVENTS 1024       // transfers in flight that can be timed
+#define LATENCY_SUB_BUCKETS 8     // histogram resolution, per power of two
+#define LATENCY_BUCKETS (40 * LATENCY_SUB_BUCKETS)
+
+/*!
+ * Time from a transfer arriving in the device callback to work() taking
+ * its first sample, and the ring fill work() sees.
+ *
+ * The producer notes the ring position and the time of every transfer
+ * with arrival(), work() calls consumed() after taking items out of the
+ * ring. Both only touch their own end of a small spsc_ring of events and
+ * update log scaled histograms with 8 buckets per power of two, which
+ * get_stats() reads the percentiles from.
+ *
+ * Positions and fill levels are in ring items, get_stats() divides them
+ * by the number of items per sample.
+ *
+ * Only built when configured with ENABLE_LATENCY_STATS, a class with the
+ * same interface that does nothing is used otherwise.
+ */
+class latency_stats
+{
+public:
+  latency_stats() : _events( LATENCY_EVENTS )
+  {
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      _latency[i].store( 0, std::memory_order_relaxed );
+      _fill[i].store( 0, std::memory_order_relaxed );
+    }
+    _latency_max.store( 0, std::memory_order_relaxed );
+  }
+
+  /* forget the transfers in flight along with a reset() of the ring, the
+   * histograms are kept for the lifetime of the device */
+  void reset() { _events.reset(); }
+
+  /* producer: a transfer starts at ring position pos */
+  void arrival( uint64_t pos )
+  {
+    event_t event;
+    event.pos = pos;
+    event.ns = now();
+    _events.push( &event, 1 );  // untimed when there are too many in flight
+  }
+
+  /* consumer: everything before pos has been read, fill is still left */
+  void consumed( uint64_t pos, size_t fill )
+  {
+    add( _fill, fill );
+
+    const int64_t t = now();
+    size_t count;
+    const event_t *event;
+
+    while ( (event = _events.read_ptr( count )) && count && event->pos < pos ) {
+      const uint64_t us = uint64_t( std::max< int64_t >( 0, t - event->ns ) / 1000 );
+
+      add( _latency, us );
+      if ( us > _latency_max.load( std::memory_order_relaxed ) )
+        _latency_max.store( us, std::memory_order_relaxed );
+
+      _events.consume( 1 );
+    }
+  }
+
+  /* consumer: the items before pos were dropped instead of read */
+  void discarded( uint64_t pos )
+  {
+    size_t count;
+    const event_t *event;
+
+    while ( (event = _events.read_ptr( count )) && count && event->pos < pos )
+      _events.consume( 1 );
+  }
+
+  void get_stats( osmosdr::stream_stats_t &stats, double items_per_sample = 1 ) const
+  {
+    stats.latency_p50 = percentile( _latency, 0.5 );
+    stats.latency_p99 = percentile( _latency, 0.99 );
+    stats.latency_max = _latency_max.load( std::memory_order_relaxed );
+    stats.fill_p50 = size_t( percentile( _fill, 0.5 ) / items_per_sample );
+    stats.fill_p99 = size_t( percentile( _fill, 0.99 ) / items_per_sample );
+  }
+
+private:
+  struct event_t
+  {
+    uint64_t pos;
+    int64_t ns;
+  };
+
+  typedef std::atomic< uint32_t > histogram_t[LATENCY_BUCKETS];
+
+  static int64_t now()
+  {
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+          std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  /* values below LATENCY_SUB_BUCKETS get a bucket each, every power of
+   * two above is split into LATENCY_SUB_BUCKETS linear ones */
+  static size_t bucket( uint64_t value )
+  {
+    if ( value < LATENCY_SUB_BUCKETS )
+      return value;
+
+    int msb = 63;
+    while ( ! (value >> msb) )
+      msb--;
+
+    const int shift = msb - 3;  // log2(LATENCY_SUB_BUCKETS)
+    const size_t idx = (shift + 1) * LATENCY_SUB_BUCKETS +
+                       ((value >> shift) - LATENCY_SUB_BUCKETS);
+
+    return std::min( idx, size_t(LATENCY_BUCKETS - 1) );
+  }
+
+  /* the lowest value falling into bucket idx */
+  static double bucket_value( size_t idx )
+  {
+    if ( idx < LATENCY_SUB_BUCKETS )
+      return idx;
+
+    const int shift = int(idx / LATENCY_SUB_BUCKETS) - 1;
+    return std::ldexp( double(LATENCY_SUB_BUCKETS + idx % LATENCY_SUB_BUCKETS), shift );
+  }
+
+  /* only the consumer writes, so a relaxed load and store is enough */
+  static void add( histogram_t &histogram, uint64_t value )
+  {
+    std::atomic< uint32_t > &count = histogram[ bucket( value ) ];
+    count.store( count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+  }
+
+  static double percentile( const histogram_t &histogram, double p )
+  {
+    uint64_t total = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+      total += histogram[i].load( std::memory_order_relaxed );
+
+    if ( ! total )
+      return 0;
+
+    const uint64_t rank = uint64_t( std::ceil( p * total ) );
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      seen += histogram[i].load( std::memory_order_relaxed );
+      if ( seen >= rank )
+        return bucket_value( i );
+    }
+
+    return bucket_value( LATENCY_BUCKETS - 1 );
+  }
+
+  spsc_ring< event_t > _events;
+  histogram_t _latency;             // microseconds
+  histogram_t _fill;                // ring items
+  std::atomic< uint64_t > _latency_max;
+};
+
+#else
+
+class latency_stats
+{
+public:
+  void reset() {}
+  void arrival( uint64_t ) {}
+  void consumed( uint64_t, size_t ) {}
+  void discarded( uint64_t ) {}
+  void get_stats( osmosdr::stream_stats_t &, double = 1 ) const {}
+};
+
+#endif // ENABLE_LATENCY_STATS
+
+#endif // OSMOSDR_LATENCY_STATS_H
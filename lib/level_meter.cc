@@ -0,0 +1,111 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/lexical_cast.hpp>
+
+#include "level_meter.h"
+
+#define LEVEL_FLOOR -200.0    // dBFS reported for silence
+
+level_meter::level_meter() :
+  _block(NULL),
+  _period(0),
+  _period_values(0)
+{
+}
+
+double level_meter::period_from_dict( const dict_t &dict )
+{
+  if ( ! dict.count( "level" ) )
+    return 0;
+
+  return std::max( 0.0, boost::lexical_cast< double >( dict.at( "level" ) ) / 1e3 );
+}
+
+void level_meter::attach( gr::basic_block *block, double period, size_t nchan )
+{
+  _block = block;
+  _period = period;
+
+  for (size_t i = 0; i < nchan; i++) {
+    _chans.push_back( std::unique_ptr< channel_t >( new channel_t ) );
+    _chans.back()->clipped.store( 0 );
+    _chans.back()->power.store( LEVEL_FLOOR );
+  }
+
+  _block->message_port_register_out( pmt::mp("level") );
+}
+
+void level_meter::set_sample_rate( double rate )
+{
+  std::lock_guard< std::mutex > lock( _mutex );
+
+  /* I and Q values, like the kernels count them */
+  _period_values = rate > 0 ? uint64_t( std::max( 1.0, 2 * rate * _period ) ) : 0;
+}
+
+void level_meter::add( size_t chan, const convert_level_t &level )
+{
+  if ( ! enabled() || chan >= _chans.size() )
+    return;
+
+  channel_t &ch = *_chans[chan];
+  convert_level_t done;
+
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+
+    ch.period.power += level.power;
+    ch.period.values += level.values;
+    ch.period.clipped += level.clipped;
+    ch.clipped.fetch_add( level.clipped, std::memory_order_relaxed );
+
+    if ( ! _period_values || ch.period.values < _period_values )
+      return;
+
+    done = ch.period;
+    ch.period = convert_level_t();
+  }
+
+  /* the power of a complex sample is that of its I and Q value */
+  const double power = done.power ?
+      std::max( LEVEL_FLOOR, 10 * std::log10( 2 * done.power / done.values ) ) : LEVEL_FLOOR;
+  ch.power.store( power, std::memory_order_relaxed );
+
+  pmt::pmt_t msg = pmt::make_dict();
+  msg = pmt::dict_add( msg, pmt::mp("chan"), pmt::from_long( chan ) );
+  msg = pmt::dict_add( msg, pmt::mp("power"), pmt::from_double( power ) );
+  msg = pmt::dict_add( msg, pmt::mp("clipped"), pmt::from_uint64( done.clipped ) );
+  msg = pmt::dict_add( msg, pmt::mp("samples"), pmt::from_uint64( done.values / 2 ) );
+
+  _block->message_port_pub( pmt::mp("level"), msg );
+}
+
+void level_meter::get_stats( size_t chan, osmosdr::stream_stats_t &stats ) const
+{
+  if ( chan >= _chans.size() )
+    return;
+
+  stats.clipped = _chans[chan]->clipped.load( std::memory_order_relaxed );
+  stats.power = _chans[chan]->power.load( std::memory_order_relaxed );
+}
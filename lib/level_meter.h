@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_LEVEL_METER_H
+#define OSMOSDR_LEVEL_METER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gnuradio/basic_block.h>
+
+#include <osmosdr/api.h>
+#include <osmosdr/stream_stats.h>
+
+#include "arg_helpers.h"
+#include "sample_convert.h"
+
+/*!
+ * ADC level and clipping of a source, enabled with level=<ms>.
+ *
+ * Rather than another pass over the stream, the backend converts with the
+ * _level kernels of sample_convert.h and hands what they accumulated to
+ * add(). Once a period is complete a dict with chan, power (mean power in
+ * dBFS), clipped (I or Q values at full scale) and samples is published
+ * on the "level" message port of the block, which the source passes on.
+ *
+ * add() may be called from several converting threads at once.
+ */
+class OSMOSDR_API level_meter
+{
+public:
+  level_meter();
+
+  /*! the period from level=<ms> in seconds, 0 when not given */
+  static double period_from_dict( const dict_t &dict );
+
+  /*!
+   * Register the "level" port of \p block, from its constructor, and
+   * measure \p nchan channels from now on.
+   */
+  void attach( gr::basic_block *block, double period, size_t nchan = 1 );
+
+  bool enabled() const { return _block != NULL; }
+
+  /*! periods are counted in samples, none complete while the rate is 0 */
+  void set_sample_rate( double rate );
+
+  void add( size_t chan, const convert_level_t &level );
+
+  /*! clipped and power of \p chan */
+  void get_stats( size_t chan, osmosdr::stream_stats_t &stats ) const;
+
+private:
+  struct channel_t
+  {
+    convert_level_t period;             // of the period in progress
+    std::atomic< uint64_t > clipped;    // lifetime of the device
+    std::atomic< double > power;        // dBFS of the last period
+  };
+
+  gr::basic_block *_block;
+  double _period;
+  uint64_t _period_values;
+  std::mutex _mutex;
+  std::vector< std::unique_ptr< channel_t > > _chans;
+};
+
+#endif // OSMOSDR_LEVEL_METER_H
@@ -33,7 +33,9 @@
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
+#include <boost/algorithm/string.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
@@ -41,15 +43,22 @@
 #include <mirisdr.h>
 
 #include "arg_helpers.h"
+#include "sample_convert.h"
 
 using namespace boost::assign;
 
 #define BUF_SIZE  2304 * 8 * 2
 #define BUF_NUM   15
 #define BUF_SKIP  1 // buffers to skip due to garbage
+#define OUT_TRANSFERS  4 // transfers the output buffer takes at least
 
-#define BYTES_PER_SAMPLE  4 // mirisdr device delivers 16 bit signed IQ data
-                            // containing 12 bits of information
+/* libmirisdr unpacks every 1024 byte USB packet before the callback, into
+ * this many bytes: 252 (14 bit), 336 (12 bit), 384 (10+2 bit) or 504
+ * (8 bit) samples of 16 bit I/Q each, or 504 samples of 8 bit I/Q */
+#define USB_PACKET_SIZE    1024
+#define PACKET_OUT_MAX     (504 * 4)
+
+#define S16_SCALE  (1.0f/4096.0f)
 
 /*
  * Create a new instance of miri_source_c and return
@@ -91,11 +100,13 @@ miri_source_c::miri_source_c (const std::string &args)
 
   dict_t dict = params_to_dict(args);
 
+  _ring.set_buffer_opts(buffer_opts_from_dict(dict));
+  _sched = thread_sched_from_dict(dict);
+
   if (dict.count("miri"))
     dev_index = boost::lexical_cast< unsigned int >( dict["miri"] );
 
-  _buf_num = _buf_head = _buf_used = _buf_offset = 0;
-  _samp_avail = BUF_SIZE / BYTES_PER_SAMPLE;
+  _buf_num = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -108,6 +119,17 @@ miri_source_c::miri_source_c (const std::string &args)
               << std::endl;
   }
 
+  /* AUTO lets the library pick one of the 16 bit formats by sample rate */
+  std::string format = "AUTO";
+  if (dict.count("format"))
+    format = boost::to_upper_copy( dict["format"] );
+
+  if ( format != "AUTO" && format != "252_S16" && format != "336_S16" &&
+       format != "384_S16" && format != "504_S16" && format != "504_S8" )
+    throw std::runtime_error("Sample format must be auto, 252_s16, 336_s16, 384_s16, 504_s16 or 504_s8.");
+
+  _sample_bytes = ( format == "504_S8" ) ? 2 : 4;
+
   if ( dev_index >= mirisdr_get_device_count() )
     throw std::runtime_error("Wrong mirisdr device index given.");
 
@@ -128,17 +150,26 @@ miri_source_c::miri_source_c (const std::string &args)
   if (ret < 0)
     throw std::runtime_error("Failed to enable manual gain mode.");
 #endif
+  ret = mirisdr_set_sample_format( _dev, (char *)format.c_str() );
+  if (ret < 0)
+    throw std::runtime_error("Failed to set sample format " + format + ".");
+
   ret = mirisdr_reset_buffer( _dev );
   if (ret < 0)
     throw std::runtime_error("Failed to reset usb buffers.");
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
-  _buf_lens = (unsigned int *) malloc(_buf_num * sizeof(unsigned int));
+  /* room for all transfers in flight, unpacked in the largest format, a
+   * multiple of the sample size so samples never wrap */
+  _ring.resize( _buf_num * (BUF_SIZE / USB_PACKET_SIZE) * PACKET_OUT_MAX );
 
-  if (_buf && _buf_lens) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(BUF_SIZE);
-  }
+  /* work() is asked for whole transfers, with room for a few of them, so
+   * a call drains what arrived rather than a bit of it. With AUTO the
+   * samples per packet follow the rate, the buffer is then sized for the
+   * most of them. */
+  const int packets = BUF_SIZE / USB_PACKET_SIZE;
+  if ( format != "AUTO" )
+    set_output_multiple( packets * boost::lexical_cast< int >( format.substr(0, 3) ) );
+  set_min_output_buffer( OUT_TRANSFERS * packets * 504 );
 
   _thread = gr::thread::thread(_mirisdr_wait, this);
 }
@@ -155,17 +186,6 @@ miri_source_c::~miri_source_c ()
     mirisdr_close( _dev );
     _dev = NULL;
   }
-
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-    free(_buf_lens);
-    _buf_lens = NULL;
-  }
 }
 
 void miri_source_c::_mirisdr_callback(unsigned char *buf, uint32_t len, void *ctx)
@@ -181,25 +201,17 @@ void miri_source_c::mirisdr_callback(unsigned char *buf, uint32_t len)
     return;
   }
 
-  {
-    std::lock_guard<std::mutex> lock( _buf_mutex );
+  len -= len % _sample_bytes;
 
-    if (len > BUF_SIZE)
-      throw std::runtime_error("Buffer too small.");
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-    _buf_lens[buf_tail] = len;
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
+  /* work() may still be converting the oldest transfer, so drop the new one */
+  if (_ring.space() < len) {
+    _stats.overrun( len / _sample_bytes );
+    std::cerr << "O" << std::flush;
+    return;
   }
 
-  _buf_cond.notify_one();
+  _latency_stats.arrival( _ring.write_count() );
+  _ring.push(buf, len);
 }
 
 void miri_source_c::_mirisdr_wait(miri_source_c *obj)
@@ -209,6 +221,8 @@ void miri_source_c::_mirisdr_wait(miri_source_c *obj)
 
 void miri_source_c::mirisdr_wait()
 {
+  thread_sched_apply( _sched );
+
   int ret = mirisdr_read_async( _dev, _mirisdr_callback, (void *)this, _buf_num, BUF_SIZE );
 
   _running = false;
@@ -216,7 +230,7 @@ void miri_source_c::mirisdr_wait()
   if ( ret != 0 )
     std::cerr << "mirisdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _ring.close();
 }
 
 int miri_source_c::work( int noutput_items,
@@ -225,50 +239,34 @@ int miri_source_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
-  {
-    std::unique_lock<std::mutex> lock( _buf_mutex );
-
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
+  _ring.wait( 3 * BUF_SIZE ); // collect at least 3 buffers
 
   if (!_running)
     return WORK_DONE;
 
-  short *buf = (short *)_buf[_buf_head] + _buf_offset;
-
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+  while (noutput_items) {
+    size_t len;
+    const unsigned char *buf = _ring.read_ptr( len );
+    const int nout = std::min<size_t>(noutput_items, len / _sample_bytes);
 
-    _buf_offset += noutput_items * 2;
-    _samp_avail -= noutput_items;
-  } else {
-    for (int i = 0; i < _samp_avail; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+    if (!nout)
+      break;
 
-    {
-      std::lock_guard<std::mutex> lock( _buf_mutex );
+    if (2 == _sample_bytes)
+      convert_s8_fc32( (const int8_t *)buf, out, nout );
+    else
+      convert_s16_fc32( (const int16_t *)buf, out, nout, S16_SCALE );
+    out += nout;
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
-
-    buf = (short *)_buf[_buf_head];
+    noutput_items -= nout;
+    _ring.consume( nout * _sample_bytes );
+  }
 
-    int remaining = noutput_items - _samp_avail;
+  _latency_stats.consumed( _ring.read_count(), _ring.size() );
 
-    for (int i = 0; i < remaining; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+  _stats.produced( out - ((gr_complex *)output_items[0]) );
 
-    _buf_offset = remaining * 2;
-    _samp_avail = (_buf_lens[_buf_head] / BYTES_PER_SAMPLE) - remaining;
-  }
-
-  return noutput_items;
+  return (out - ((gr_complex *)output_items[0]));
 }
 
 std::vector<std::string> miri_source_c::get_devices()
@@ -449,3 +447,17 @@ std::string miri_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t miri_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats;
+
+  _stats.get_stats( stats );
+
+  stats.fill = _ring.size() / _sample_bytes;
+  stats.fill_max = _ring.fill_max() / _sample_bytes;
+  stats.capacity = _ring.capacity() / _sample_bytes;
+  _latency_stats.get_stats( stats, _sample_bytes );
+
+  return stats;
+}
@@ -24,10 +24,11 @@
 
 #include <gnuradio/thread/thread.h>
 
-#include <mutex>
-#include <condition_variable>
-
+#include "latency_stats.h"
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+#include "stream_counters.h"
 
 class miri_source_c;
 typedef struct mirisdr_dev mirisdr_dev_t;
@@ -97,6 +98,8 @@ private:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   static void _mirisdr_callback(unsigned char *buf, uint32_t len, void *ctx);
   void mirisdr_callback(unsigned char *buf, uint32_t len);
@@ -105,17 +108,13 @@ private:
 
   mirisdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
-  unsigned int *_buf_lens;
+  thread_sched_t _sched;
+  spsc_ring<unsigned char> _ring;   // I/Q in the format the library converted to
   unsigned int _buf_num;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  std::mutex _buf_mutex;
-  std::condition_variable _buf_cond;
+  size_t _sample_bytes;             // 4 for the *_S16 formats, 2 for 504_S8
   bool _running;
-
-  unsigned int _buf_offset;
-  int _samp_avail;
+  stream_counters _stats;
+  latency_stats _latency_stats;
 
   bool _auto_gain;
   unsigned int _skipped;
@@ -0,0 +1,151 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "pingpong_sweep.h"
+
+bool pingpong_sweep_from_dict( const dict_t &dict, pingpong_sweep_opts_t &opts )
+{
+  if ( ! dict.count( "sweep" ) )
+    return false;
+
+  std::vector< std::string > range;
+  boost::algorithm::split( range, dict.at( "sweep" ), boost::is_any_of( ":" ) );
+  if ( range.size() != 3 )
+    throw std::runtime_error( "sweep must be given as <start>:<stop>:<step>." );
+
+  opts.start = boost::lexical_cast< double >( range[0] );
+  opts.stop = boost::lexical_cast< double >( range[1] );
+  opts.step = boost::lexical_cast< double >( range[2] );
+
+  if ( dict.count( "sweep_dwell" ) )
+    opts.dwell = boost::lexical_cast< double >( dict.at( "sweep_dwell" ) ) / 1e3;
+  if ( dict.count( "sweep_settle" ) )
+    opts.settle = boost::lexical_cast< double >( dict.at( "sweep_settle" ) ) / 1e3;
+
+  if ( opts.step <= 0 || opts.stop - opts.start < opts.step )
+    throw std::runtime_error( "sweep needs a positive step and at least two steps." );
+  if ( opts.dwell < 0 || opts.settle < 0 )
+    throw std::runtime_error( "sweep_dwell and sweep_settle can't be negative." );
+
+  return true;
+}
+
+pingpong_sweep::pingpong_sweep( const pingpong_sweep_opts_t &opts, const tune_fn &tune ) :
+  _tune( tune ),
+  _dwell_time( opts.dwell ),
+  _settle_time( opts.settle ),
+  _dwell( 0 ),
+  _settle( 0 ),
+  _active( 0 ),
+  _dwell_left( 0 ),
+  _next( 0 ),
+  _started( false )
+{
+  /* in steps from start, so the error doesn't add up */
+  size_t nsteps = size_t( std::floor( (opts.stop - opts.start) / opts.step + 1e-9 ) ) + 1;
+  for ( size_t i = 0; i < nsteps; i++ )
+    _steps.push_back( opts.start + i * opts.step );
+
+  _freq[0] = _freq[1] = _steps[0];
+  _settle_left[0] = _settle_left[1] = 0;
+}
+
+void pingpong_sweep::reset( double rate )
+{
+  _dwell = std::max( size_t( std::llround( _dwell_time * rate ) ), size_t( 1 ) );
+  _settle = size_t( std::llround( _settle_time * rate ) );
+
+  _freq[0] = _tune( 0, _steps[0] );
+  _freq[1] = _tune( 1, _steps[1] );
+  _settle_left[0] = _settle_left[1] = _settle;
+
+  _active = 0;
+  _dwell_left = _dwell;
+  _next = 2 % _steps.size();
+  _started = false;
+}
+
+size_t pingpong_sweep::process( const gr_complex *in0, const gr_complex *in1, size_t nitems,
+                                gr_complex *out, size_t &skipped,
+                                std::vector< std::pair< size_t, double > > &hops )
+{
+  const gr_complex *in[2] = { in0, in1 };
+  size_t i = 0, produced = 0;
+  bool retune = false;
+
+  skipped = 0;
+
+  if ( ! _started ) {
+    /* both were tuned by reset(), the second one settles meanwhile */
+    size_t n = std::min( nitems, _settle_left[_active] );
+    _settle_left[0] -= std::min( n, _settle_left[0] );
+    _settle_left[1] -= std::min( n, _settle_left[1] );
+    skipped = i = n;
+
+    if ( i == nitems )
+      return 0;
+
+    _started = true;
+    hops.push_back( std::make_pair( size_t( 0 ), _freq[_active] ) );
+  }
+
+  while ( i < nitems ) {
+    size_t idle = 1 - _active;
+    size_t n = nitems - i;
+
+    if ( _dwell_left ) {
+      n = std::min( n, _dwell_left );
+    } else if ( _settle_left[idle] && ! retune ) {
+      n = std::min( n, _settle_left[idle] );
+    } else if ( ! retune ) {
+      /* the old one gets retuned after this block, which ends before
+       * that took effect, so it doesn't settle until the next one */
+      _active = idle;
+      _dwell_left = _dwell;
+      _settle_left[1 - _active] = _settle;
+      retune = true;
+      hops.push_back( std::make_pair( produced, _freq[_active] ) );
+      continue;
+    }
+
+    memcpy( out + produced, in[_active] + i, n * sizeof(gr_complex) );
+    produced += n;
+    i += n;
+
+    _dwell_left -= std::min( n, _dwell_left );
+    if ( ! retune )
+      _settle_left[idle] -= std::min( n, _settle_left[idle] );
+  }
+
+  if ( retune ) {
+    size_t idle = 1 - _active;
+    _freq[idle] = _tune( idle, _steps[_next] );
+    _next = (_next + 1) % _steps.size();
+  }
+
+  return produced;
+}
@@ -0,0 +1,105 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_PINGPONG_SWEEP_H
+#define OSMOSDR_PINGPONG_SWEEP_H
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <gnuradio/gr_complex.h>
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*! sweep=<start>:<stop>:<step>[,sweep_dwell=<ms>][,sweep_settle=<ms>] */
+struct pingpong_sweep_opts_t
+{
+  pingpong_sweep_opts_t() : start(0), stop(0), step(0), dwell(0.01), settle(0.005) {}
+
+  double start;         // Hz, first step
+  double stop;          // Hz, last step at most
+  double step;          // Hz
+  double dwell;         // s captured per step at least
+  double settle;        // s after a retune before the samples are used
+};
+
+/*! false when \p dict doesn't ask for a sweep */
+OSMOSDR_API bool pingpong_sweep_from_dict( const dict_t &dict, pingpong_sweep_opts_t &opts );
+
+/*!
+ * Stitches the two receive channels of a device into one sweep.
+ *
+ * One channel is captured while the other one is tuned to the next step
+ * and settles, then they swap, so no samples are lost to the retune as
+ * long as the dwell is at least the settle time. A channel is kept in
+ * capture past its dwell until the one tuned next has settled. Only the
+ * first settle after reset() is dropped.
+ *
+ * The retunes are done from process(), after the samples it got, and the
+ * settle time counts from the next call. So it has to cover whatever the
+ * device buffers between receiving a sample and handing it out.
+ */
+class OSMOSDR_API pingpong_sweep
+{
+public:
+  /*! tunes \p chan to \p freq and returns the frequency it got */
+  typedef std::function< double( size_t chan, double freq ) > tune_fn;
+
+  pingpong_sweep( const pingpong_sweep_opts_t &opts, const tune_fn &tune );
+
+  const std::vector<double> &steps() const { return _steps; }
+
+  /*! the frequency of the channel in capture */
+  double freq() const { return _freq[_active]; }
+
+  /*! tunes both channels to the first two steps, for a stream at \p rate */
+  void reset( double rate );
+
+  /*!
+   * Copies \p nitems of the channel in capture into \p out and returns
+   * how many were written. \p skipped tells how many of the input were
+   * dropped before the first one written, which is only the case while
+   * settling after reset(). Every switch, and the first sample written,
+   * appends the index into \p out and the frequency to \p hops.
+   */
+  size_t process( const gr_complex *in0, const gr_complex *in1, size_t nitems,
+                  gr_complex *out, size_t &skipped,
+                  std::vector< std::pair< size_t, double > > &hops );
+
+private:
+  tune_fn _tune;
+  std::vector<double> _steps;
+  double _dwell_time;
+  double _settle_time;
+
+  size_t _dwell;                // samples per step
+  size_t _settle;               // samples after a retune
+
+  size_t _active;               // channel in capture
+  double _freq[2];
+  size_t _settle_left[2];
+  size_t _dwell_left;
+  size_t _next;                 // step the next retune goes to
+  bool _started;                // the first sample went out
+};
+
+#endif /* OSMOSDR_PINGPONG_SWEEP_H */
@@ -0,0 +1,265 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+#include <volk/volk.h>
+
+#include "power_gate.h"
+#include "stream_tagger.h"
+
+bool power_gate_from_dict( const dict_t &dict, power_gate_opts_t &opts )
+{
+  if ( ! dict.count( "gate" ) )
+    return false;
+
+  opts.threshold = boost::lexical_cast< double >( dict.at( "gate" ) );
+
+  if ( dict.count( "gate_block" ) )
+    opts.block = boost::lexical_cast< size_t >( dict.at( "gate_block" ) );
+  if ( dict.count( "gate_hang" ) )
+    opts.hang = boost::lexical_cast< double >( dict.at( "gate_hang" ) ) / 1e3;
+  if ( dict.count( "gate_pre" ) )
+    opts.pre = boost::lexical_cast< double >( dict.at( "gate_pre" ) ) / 1e3;
+
+  if ( 0 == opts.block )
+    throw std::runtime_error( "gate_block must be at least one sample." );
+
+  return true;
+}
+
+power_gate_sptr make_power_gate( const power_gate_opts_t &opts, double rate )
+{
+  return gnuradio::get_initial_sptr( new power_gate( opts, rate ) );
+}
+
+power_gate::power_gate( const power_gate_opts_t &opts, double rate ) :
+  gr::block( "power_gate",
+             gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+             gr::io_signature::make( 1, 1, sizeof(gr_complex) ) ),
+  _opts( opts ),
+  _threshold( float( std::pow( 10.0, opts.threshold / 10 ) * opts.block ) ),
+  _rate( rate ),
+  _open( false ),
+  _hang_left( 0 ),
+  _segment( false ),
+  _hist_offset( 0 ),
+  _have_time( false ),
+  _time_offset( 0 ),
+  _dropped( 0 )
+{
+  _freq = pmt::PMT_NIL;
+
+  set_output_multiple( int( opts.block ) );
+
+  /* the tags of dropped samples are gone, the ones that still count are
+   * put on the first sample of the next segment */
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+void power_gate::set_sample_rate( double rate )
+{
+  _rate = rate;
+}
+
+size_t power_gate::hang_samples() const
+{
+  return size_t( std::llround( _opts.hang * _rate ) );
+}
+
+/* whole blocks, as that's what the estimate is made of */
+size_t power_gate::pre_samples() const
+{
+  const size_t n = size_t( std::llround( _opts.pre * _rate ) );
+
+  return ( n + _opts.block - 1 ) / _opts.block * _opts.block;
+}
+
+void power_gate::forecast( int noutput_items, gr_vector_int &ninput_items_required )
+{
+  ninput_items_required[0] = std::max( noutput_items, int( _opts.block ) );
+}
+
+/* picks up the time, rate and frequency the segments are tagged with */
+void power_gate::read_tags( uint64_t offset, size_t nitems )
+{
+  get_tags_in_range( _tags, 0, offset, offset + nitems );
+
+  for ( const gr::tag_t &tag : _tags ) {
+    if ( pmt::eq( tag.key, stream_tagger::TIME_KEY() ) ) {
+      _time = tick_time_t::from_rx_time( tag.value, _rate );
+      _time_offset = tag.offset;
+      _have_time = true;
+    } else if ( pmt::eq( tag.key, stream_tagger::RATE_KEY() ) ) {
+      const double rate = pmt::to_double( tag.value );
+
+      /* move the reference to the tag, counted at the new rate from there */
+      if ( _have_time && rate > 0 ) {
+        const tick_time_t at = _time + int64_t( tag.offset - _time_offset );
+        _time = tick_time_t::from_time_spec( at.to_time_spec(), rate );
+        _time_offset = tag.offset;
+      }
+      if ( rate > 0 )
+        _rate = rate;
+    } else if ( pmt::eq( tag.key, stream_tagger::FREQ_KEY() ) ) {
+      _freq = tag.value;
+    }
+  }
+}
+
+/* copies samples out, the first of a segment gets rx_time, rx_rate and
+ * rx_freq, the tags among \p tags that are within the samples are moved
+ * along with them */
+void power_gate::emit( const gr_complex *in, uint64_t offset, size_t nitems,
+                       gr_complex *out, uint64_t out_offset,
+                       const std::vector< gr::tag_t > &tags )
+{
+  memcpy( out, in, nitems * sizeof(gr_complex) );
+
+  if ( _segment ) {
+    const tick_time_t time = _time + int64_t( offset - _time_offset );
+
+    add_item_tag( 0, out_offset, stream_tagger::TIME_KEY(), time.to_rx_time(), alias_pmt() );
+    add_item_tag( 0, out_offset, stream_tagger::RATE_KEY(),
+                  pmt::from_double( _rate ), alias_pmt() );
+    if ( ! pmt::is_null( _freq ) )
+      add_item_tag( 0, out_offset, stream_tagger::FREQ_KEY(), _freq, alias_pmt() );
+  }
+
+  for ( const gr::tag_t &tag : tags ) {
+    if ( tag.offset < offset || tag.offset >= offset + nitems )
+      continue;
+
+    /* already there */
+    if ( _segment && tag.offset == offset &&
+         ( pmt::eq( tag.key, stream_tagger::TIME_KEY() ) ||
+           pmt::eq( tag.key, stream_tagger::RATE_KEY() ) ||
+           pmt::eq( tag.key, stream_tagger::FREQ_KEY() ) ) )
+      continue;
+
+    add_item_tag( 0, out_offset + ( tag.offset - offset ), tag.key, tag.value, tag.srcid );
+  }
+
+  _segment = false;
+}
+
+int power_gate::general_work( int noutput_items,
+                              gr_vector_int &ninput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  gr_complex *out = (gr_complex *)output_items[0];
+  const size_t block = _opts.block;
+  const size_t ninput = ninput_items[0];
+  const uint64_t base = nitems_read(0);
+  size_t consumed = 0;
+  size_t produced = 0;
+
+  /* without rx_time tags the segments are timed by the host clock */
+  if ( ! _have_time ) {
+    _time = tick_time_t::from_time_spec( osmosdr::time_spec_t::get_system_time(), _rate );
+    _time_offset = base;
+    _have_time = true;
+  }
+
+  while ( true ) {
+    /* the pre-roll goes out first once the gate opened */
+    if ( _open && ! _hist.empty() ) {
+      const size_t n = std::min( _hist.size(), size_t( noutput_items ) - produced );
+      if ( ! n )
+        break;
+
+      emit( &_hist[0], _hist_offset, n, out + produced,
+            nitems_written(0) + produced, _hist_tags );
+      produced += n;
+
+      _hist.erase( _hist.begin(), _hist.begin() + n );
+      _hist_offset += n;
+      continue;
+    }
+
+    if ( ninput - consumed < block || size_t( noutput_items ) - produced < block )
+      break;
+
+    const gr_complex *blk = in + consumed;
+    const uint64_t offset = base + consumed;
+
+    read_tags( offset, block );
+
+    /* sum of I^2 + Q^2 over the block */
+    float energy = 0;
+    volk_32f_x2_dot_prod_32f( &energy, (const float *)blk, (const float *)blk, 2 * block );
+
+    if ( energy >= _threshold ) {
+      if ( ! _open )
+        _segment = true;
+      _open = true;
+      _hang_left = hang_samples();
+    } else if ( _open ) {
+      if ( _hang_left >= block )
+        _hang_left -= block;
+      else
+        _open = false;
+    }
+
+    consumed += block;
+
+    if ( _open && _hist.empty() ) {
+      emit( blk, offset, block, out + produced, nitems_written(0) + produced, _tags );
+      produced += block;
+      continue;
+    }
+
+    /* held back for the pre-roll, or behind it when the gate just opened */
+    if ( _hist.empty() ) {
+      _hist_offset = offset;
+      _hist_tags.clear();
+    }
+    _hist.insert( _hist.end(), blk, blk + block );
+    _hist_tags.insert( _hist_tags.end(), _tags.begin(), _tags.end() );
+
+    if ( _open )
+      continue;
+
+    const size_t keep = pre_samples();
+    if ( _hist.size() > keep ) {
+      const size_t drop = _hist.size() - keep;
+
+      _hist.erase( _hist.begin(), _hist.begin() + drop );
+      _hist_offset += drop;
+      _dropped += drop;
+
+      _hist_tags.erase( std::remove_if( _hist_tags.begin(), _hist_tags.end(),
+                          [this]( const gr::tag_t &tag ) { return tag.offset < _hist_offset; } ),
+                        _hist_tags.end() );
+    }
+  }
+
+  consume_each( consumed );
+
+  return produced;
+}
@@ -0,0 +1,122 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_POWER_GATE_H
+#define INCLUDED_POWER_GATE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gnuradio/block.h>
+
+#include "arg_helpers.h"
+#include "tick_time.h"
+
+/*! gate=<dBFS>[,gate_block=<samples>][,gate_hang=<ms>][,gate_pre=<ms>] */
+struct power_gate_opts_t
+{
+  power_gate_opts_t() : threshold(0), block(1024), hang(0.1), pre(0.01) {}
+
+  double threshold;     // dBFS, mean power of a block
+  size_t block;         // samples the power is estimated over
+  double hang;          // s kept open after the last active block
+  double pre;           // s passed on before the first one
+};
+
+/*! false when \p dict doesn't ask for a gate */
+bool power_gate_from_dict( const dict_t &dict, power_gate_opts_t &opts );
+
+class power_gate;
+
+typedef std::shared_ptr<power_gate> power_gate_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of power_gate.
+ * \param opts the threshold and timing
+ * \param rate the sample rate until an rx_rate tag tells otherwise
+ */
+power_gate_sptr make_power_gate( const power_gate_opts_t &opts, double rate );
+
+/*!
+ * \brief Passes on only the parts of the stream above a power threshold.
+ *
+ * The mean power of every block of samples (a single VOLK dot product)
+ * is compared with the threshold. The gate opens with the first block
+ * above it, the blocks of the pre-roll before it come out first, and
+ * closes once the hangover after the last one ran out. Everything in
+ * between is dropped here, before the rest of the flowgraph sees it.
+ *
+ * The first sample of every segment carries rx_time, rx_rate and
+ * rx_freq. The time continues from the rx_time tags of the input, or
+ * the host clock at the first sample if there are none. Other tags are
+ * passed on with their samples.
+ */
+class power_gate : public gr::block
+{
+private:
+  friend power_gate_sptr make_power_gate( const power_gate_opts_t &opts, double rate );
+
+  power_gate( const power_gate_opts_t &opts, double rate );
+
+public:
+  void set_sample_rate( double rate );
+
+  /*! samples dropped so far */
+  uint64_t dropped() const { return _dropped.load(); }
+
+  void forecast( int noutput_items, gr_vector_int &ninput_items_required );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  void read_tags( uint64_t offset, size_t nitems );
+  void emit( const gr_complex *in, uint64_t offset, size_t nitems,
+             gr_complex *out, uint64_t out_offset,
+             const std::vector< gr::tag_t > &tags );
+  size_t hang_samples() const;
+  size_t pre_samples() const;
+
+  power_gate_opts_t _opts;
+  float _threshold;             // linear, times the block length
+  std::atomic<double> _rate;
+
+  bool _open;
+  size_t _hang_left;            // samples the gate stays open without activity
+  bool _segment;                // the next sample out starts a segment
+
+  /* dropped blocks the pre-roll is taken from, with their tags */
+  std::vector< gr_complex > _hist;
+  uint64_t _hist_offset;        // input offset of _hist[0]
+  std::vector< gr::tag_t > _hist_tags;
+
+  /* for rx_time of the segments and the tags put on them */
+  bool _have_time;
+  uint64_t _time_offset;        // input offset of _time
+  tick_time_t _time;
+  pmt::pmt_t _freq;
+  std::vector< gr::tag_t > _tags;
+
+  std::atomic<uint64_t> _dropped;
+};
+
+#endif /* INCLUDED_POWER_GATE_H */
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <gnuradio/fft/window.h>
+
+#include <volk/volk.h>
+
+#include "power_spectrum.h"
+
+power_spectrum::power_spectrum( size_t fft_size ) :
+  _size(fft_size), _count(0)
+{
+  _fft.reset( new gr::fft::fft_complex_fwd( _size ) );
+
+  _window = gr::fft::window::blackmanharris( _size );
+  double sum = 0;
+  for (float w : _window)
+    sum += w;
+  _window_power = float( sum * sum );
+
+  _mag.resize( _size );
+  _acc.resize( _size );
+}
+
+void power_spectrum::reset()
+{
+  _count = 0;
+  std::fill( _acc.begin(), _acc.end(), 0.0f );
+}
+
+void power_spectrum::add( const gr_complex *in )
+{
+  gr_complex *buf = _fft->get_inbuf();
+
+  volk_32fc_32f_multiply_32fc( buf, in, &_window[0], _size );
+  _fft->execute();
+  volk_32fc_magnitude_squared_32f( &_mag[0], _fft->get_outbuf(), _size );
+  volk_32f_x2_add_32f( &_acc[0], &_acc[0], &_mag[0], _size );
+
+  _count++;
+}
+
+std::vector< float > power_spectrum::dbfs() const
+{
+  const float scale = 1.0f / ( std::max< size_t >( _count, 1 ) * _window_power );
+  const size_t half = _size / 2;
+  std::vector< float > power( _size );
+
+  for (size_t i = 0; i < _size; i++) {
+    const float p = _acc[ (i + _size - half) % _size ] * scale;
+    power[i] = 10.0f * std::log10( std::max( p, 1e-20f ) );
+  }
+
+  return power;
+}
@@ -0,0 +1,64 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_POWER_SPECTRUM_H
+#define INCLUDED_OSMOSDR_POWER_SPECTRUM_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <gnuradio/fft/fft.h>
+#include <gnuradio/gr_complex.h>
+
+/*!
+ * Averages the power spectra of blocks of samples, Blackman-Harris
+ * windowed and computed with VOLK, and hands them out in dBFS relative
+ * to a full scale tone, shifted so the lowest frequency comes first.
+ */
+class power_spectrum
+{
+public:
+  explicit power_spectrum( size_t fft_size );
+
+  size_t size() const { return _size; }
+
+  /*! number of spectra averaged since the last reset() */
+  size_t count() const { return _count; }
+
+  void reset();
+
+  /*! add the spectrum of the size() samples at \p in */
+  void add( const gr_complex *in );
+
+  /*! the average of the spectra added so far in dBFS */
+  std::vector< float > dbfs() const;
+
+private:
+  size_t _size;
+  size_t _count;
+
+  std::unique_ptr< gr::fft::fft_complex_fwd > _fft;
+  std::vector< float > _window;
+  float _window_power;                // (sum of the window)^2, full scale tone
+  std::vector< float > _mag;
+  std::vector< float > _acc;
+};
+
+#endif // INCLUDED_OSMOSDR_POWER_SPECTRUM_H
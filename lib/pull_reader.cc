@@ -0,0 +1,159 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <gnuradio/buffer.h>
+
+#include "pull_reader.h"
+
+/* what the scheduler typically hands a source with the default buffers */
+#define DEFAULT_CHUNK 8192
+
+pull_reader::pull_reader( gr::basic_block_sptr block, size_t nchan ) :
+  _block( std::dynamic_pointer_cast< gr::sync_block >( block ) ),
+  _nchan( nchan ),
+  _chunk( DEFAULT_CHUNK ),
+  _running( false ),
+  _done( false ),
+  _held_pos( 0 ),
+  _held( 0 )
+{
+  if ( ! _block )
+    throw std::runtime_error( "The backend can't be read from without a flowgraph." );
+}
+
+pull_reader::~pull_reader()
+{
+  stop();
+}
+
+void pull_reader::start()
+{
+  const size_t multiple = std::max( _block->output_multiple(), 1 );
+
+  _chunk = DEFAULT_CHUNK;
+  if ( _block->max_noutput_items() > 0 )
+    _chunk = std::min( _chunk, size_t( _block->max_noutput_items() ) );
+  _chunk = std::max( _chunk - _chunk % multiple, multiple );
+
+  /* the buffers only count, they must hold more than one call produces */
+  _detail = gr::make_block_detail( 0, _nchan );
+  for (size_t i = 0; i < _nchan; i++) {
+#ifdef GR_HAVE_CUSTOM_BUFFERS
+    _detail->set_output( i, gr::make_buffer( 2 * _chunk, sizeof(gr_complex),
+                                             multiple, multiple, _block, _block ) );
+#else
+    _detail->set_output( i, gr::make_buffer( 2 * _chunk, sizeof(gr_complex), _block ) );
+#endif
+  }
+  _block->set_detail( _detail );
+
+  _scratch.assign( _nchan, std::vector< gr_complex >( _chunk ) );
+  _out.resize( _nchan );
+
+  if ( ! _block->start() ) {
+    _block->set_detail( gr::block_detail_sptr() );
+    _detail.reset();
+    throw std::runtime_error( "Failed to start the backend." );
+  }
+
+  _running = true;
+  _done = false;
+  _held_pos = _held = 0;
+}
+
+void pull_reader::stop()
+{
+  if ( ! _running )
+    return;
+
+  _running = false;
+  _block->stop();
+
+  _block->set_detail( gr::block_detail_sptr() );
+  _detail.reset();
+}
+
+size_t pull_reader::read( gr_complex *out, size_t nitems, size_t chan )
+{
+  if ( chan >= _nchan )
+    throw std::runtime_error( "Channel " + std::to_string( chan ) + " doesn't exist." );
+
+  if ( ! _running )
+    start();
+
+  const size_t multiple = std::max( _block->output_multiple(), 1 );
+  size_t done = 0;
+
+  /* what the last tail left in the scratch buffers comes first */
+  if ( _held ) {
+    done = std::min( _held, nitems );
+    std::copy( _scratch[chan].begin() + _held_pos,
+               _scratch[chan].begin() + _held_pos + done, out );
+    _held_pos += done;
+    _held -= done;
+  }
+
+  while ( done < nitems && ! _done ) {
+    size_t n = std::min( nitems - done, _chunk );
+    n -= n % multiple;
+
+    /* a tail shorter than the output multiple goes through the scratch
+     * buffers, the rest of what work() produced is kept for the next call */
+    const bool tail = ( 0 == n );
+    if ( tail )
+      n = multiple;
+
+    for (size_t i = 0; i < _nchan; i++)
+      _out[i] = ( i == chan && ! tail ) ? (void *)( out + done ) : (void *)&_scratch[i][0];
+
+    const int ret = _block->work( int(n), _in, _out );
+
+    if ( gr::block::WORK_DONE == ret ) {
+      _done = true;
+      break;
+    }
+
+    if ( ret <= 0 )
+      continue;
+
+    size_t got = ret;
+    if ( tail ) {
+      got = std::min( got, nitems - done );
+      std::copy( _scratch[chan].begin(), _scratch[chan].begin() + got, out + done );
+      _held_pos = got;
+      _held = ret - got;
+    }
+
+    _detail->produce_each( ret );
+    for (size_t i = 0; i < _nchan; i++)
+      _detail->output( i )->prune_tags( _block->nitems_written( i ) );
+
+    done += got;
+  }
+
+  return done;
+}
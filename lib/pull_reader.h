@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_PULL_READER_H
+#define INCLUDED_OSMOSDR_PULL_READER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <gnuradio/block_detail.h>
+#include <gnuradio/sync_block.h>
+
+#include <osmosdr/api.h>
+
+/*!
+ * Reads from a source backend without a flowgraph, by calling its
+ * start(), work() and stop() the way the scheduler would.
+ *
+ * work() writes straight into the buffer of the caller, the channels
+ * that aren't asked for go into scratch buffers and get dropped. The
+ * block gets a block_detail of its own while it is read from, so
+ * nitems_written() and add_item_tag() work as usual. Its output buffers
+ * never hold any samples, the tags the backend adds are discarded.
+ *
+ * A read shorter than the output multiple of the block goes through the
+ * scratch buffers too, what work() produced beyond it is served first by
+ * the next read(), so no samples get lost in between.
+ */
+class OSMOSDR_API pull_reader
+{
+public:
+  pull_reader( gr::basic_block_sptr block, size_t nchan );
+  ~pull_reader();
+
+  /*!
+   * Read \p nitems samples of channel \p chan into \p out, starting the
+   * block with the first call. Returns fewer only at the end of the
+   * stream.
+   */
+  size_t read( gr_complex *out, size_t nitems, size_t chan );
+
+  void stop();
+  bool running() const { return _running; }
+
+private:
+  void start();
+
+  std::shared_ptr< gr::sync_block > _block;
+  size_t _nchan;
+  size_t _chunk;                      // samples per work() call
+  gr::block_detail_sptr _detail;
+  bool _running;
+  bool _done;                         // work() returned WORK_DONE
+
+  std::vector< std::vector< gr_complex > > _scratch;
+  size_t _held_pos;                   // in _scratch, of what the last tail left
+  size_t _held;
+  gr_vector_const_void_star _in;
+  gr_vector_void_star _out;
+};
+
+#endif // INCLUDED_OSMOSDR_PULL_READER_H
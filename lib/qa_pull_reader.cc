@@ -0,0 +1,85 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+
+#include "pull_reader.h"
+
+/* every sample is its index in the stream, work() only produces whole
+ * multiples like the rtl and hackrf sources do with their transfers */
+class counter_source : public gr::sync_block
+{
+public:
+  counter_source( int multiple ) :
+    gr::sync_block( "counter_source",
+                    gr::io_signature::make( 0, 0, 0 ),
+                    gr::io_signature::make( 1, 1, sizeof(gr_complex) ) ),
+    _count( 0 )
+  {
+    set_output_multiple( multiple );
+  }
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &, /* no inputs */
+            gr_vector_void_star &output_items )
+  {
+    gr_complex *out = (gr_complex *)output_items[0];
+
+    for (int i = 0; i < noutput_items; i++)
+      out[i] = gr_complex( float( _count++ ), 0 );
+
+    return noutput_items;
+  }
+
+private:
+  size_t _count;
+};
+
+BOOST_AUTO_TEST_CASE( t_odd_sized_reads )
+{
+  std::shared_ptr< counter_source > src( new counter_source( 1000 ) );
+  pull_reader reader( src, 1 );
+
+  const size_t sizes[] = { 1, 7, 999, 1001, 3, 12345, 500, 2 };
+  std::vector< gr_complex > buf;
+  size_t expected = 0;
+
+  for (int round = 0; round < 4; round++) {
+    for (size_t size : sizes) {
+      buf.assign( size, gr_complex( -1, 0 ) );
+
+      BOOST_REQUIRE_EQUAL( reader.read( &buf[0], size, 0 ), size );
+
+      for (size_t i = 0; i < size; i++, expected++)
+        BOOST_REQUIRE_EQUAL( buf[i].real(), float( expected ) );
+    }
+  }
+
+  reader.stop();
+}
@@ -20,6 +20,7 @@
  */
 
 #include <fstream>
+#include <iostream>
 #include <string>
 #include <sstream>
 #include <stdexcept>
@@ -46,3 +47,29 @@ void redpitaya_send_command( SOCKET socket, uint32_t command )
     throw std::runtime_error( message.str() );
   }
 }
+
+void redpitaya_set_buffer( SOCKET socket, int option, int bytes )
+{
+  if ( bytes <= 0 )
+    return;
+
+  if ( ::setsockopt( socket, SOL_SOCKET, option, (const char *)&bytes, sizeof(bytes) ) < 0 )
+    std::cerr << "Could not set TCP socket buffer size to " << bytes << " bytes." << std::endl;
+}
+
+int redpitaya_wait_socket( SOCKET socket, bool write, int timeout_ms )
+{
+  fd_set fds;
+  struct timeval tv;
+
+  FD_ZERO( &fds );
+  FD_SET( socket, &fds );
+
+  tv.tv_sec = timeout_ms / 1000;
+  tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+  if ( write )
+    return ::select( socket + 1, NULL, &fds, NULL, &tv );
+
+  return ::select( socket + 1, &fds, NULL, NULL, &tv );
+}
@@ -50,6 +50,16 @@
 #endif
 #endif
 
+#define REDPITAYA_RING_SIZE  (8 * 1024 * 1024) // bytes, ~0.8 s at 1.25 Msps
+#define REDPITAYA_POLL_MS    100 // how often the I/O threads check for stop()
+
 void redpitaya_send_command( SOCKET socket, uint32_t command );
 
+/* set SO_RCVBUF or SO_SNDBUF, before connecting so the TCP window scales */
+void redpitaya_set_buffer( SOCKET socket, int option, int bytes );
+
+/* wait up to timeout_ms for the socket to become readable resp. writable,
+ * returns > 0 when it is, 0 on timeout and < 0 on error */
+int redpitaya_wait_socket( SOCKET socket, bool write, int timeout_ms );
+
 #endif // REDPITAYA_COMMON_H
@@ -19,12 +19,17 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <fstream>
+#include <iostream>
 #include <string>
 #include <sstream>
 #include <stdexcept>
 
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -44,13 +49,19 @@ redpitaya_sink_c_sptr make_redpitaya_sink_c(const std::string &args)
 redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
   gr::sync_block("redpitaya_sink_c",
                  gr::io_signature::make(1, 1, sizeof(gr_complex)),
-                 gr::io_signature::make(0, 0, 0))
+                 gr::io_signature::make(0, 0, 0)),
+  _running(false),
+  _prefill_bytes(0),
+  _queue_limit(0),
+  _sent_queued(0)
 {
   std::string host = "192.168.1.100";
   std::stringstream message;
   unsigned short ptt = 0, port = 1001;
   struct sockaddr_in addr;
   uint32_t command;
+  size_t ring_size = REDPITAYA_RING_SIZE;
+  int sndbuf = 0;
 
 #if defined(_WIN32)
   WSADATA wsaData;
@@ -63,6 +74,10 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
 
   dict_t dict = params_to_dict( args );
 
+  _ring.set_buffer_opts( buffer_opts_from_dict( dict ) );
+  _sched = thread_sched_from_dict( dict, "tx" );
+  _pacer.init( tx_policy_from_dict( dict ), 1 );
+
   if ( dict.count( "redpitaya" ) )
   {
     std::vector< std::string > tokens;
@@ -78,12 +93,23 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
   if ( dict.count("ptt") )
     ptt = boost::lexical_cast< unsigned short >( dict["ptt"] );
 
+  if ( dict.count( "ring_size" ) )
+    ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
+  /* kernel socket buffer, gives slack on top of the ring */
+  if ( dict.count( "sndbuf" ) )
+    sndbuf = boost::lexical_cast< int >( dict["sndbuf"] );
+
   if ( !host.length() )
     host = "192.168.1.100";
 
   if ( 0 == port )
     port = 1001;
 
+  /* whole samples only, so they never wrap around the end of the ring */
+  ring_size -= ring_size % sizeof(gr_complex);
+  _ring.resize( std::max( ring_size, size_t(64 * 1024) ) );
+
   for ( size_t i = 0; i < 2; ++i )
   {
     if ( ( _sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
@@ -91,6 +117,9 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
       throw std::runtime_error( "Could not create TCP socket." );
     }
 
+    if ( 1 == i )
+      redpitaya_set_buffer( _sockets[i], SO_SNDBUF, sndbuf );
+
     memset( &addr, 0, sizeof(addr) );
     addr.sin_family = AF_INET;
     inet_pton( AF_INET, host.c_str(), &addr.sin_addr );
@@ -112,6 +141,8 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
 
 redpitaya_sink_c::~redpitaya_sink_c()
 {
+  stop();
+
 #if defined(_WIN32)
   ::closesocket( _sockets[1] );
   ::closesocket( _sockets[0] );
@@ -122,26 +153,179 @@ redpitaya_sink_c::~redpitaya_sink_c()
 #endif
 }
 
+bool redpitaya_sink_c::start()
+{
+  if ( _running )
+    return true;
+
+  _ring.reset();
+  _pacer.start( _rate );
+  _queue_limit = _pacer.policy().latency_samples( _rate );
+  _sent_queued = 0;
+
+  /* the prefill has to fit in the ring and under the latency cap */
+  size_t prefill = _pacer.policy().prefill;
+  if ( _queue_limit )
+    prefill = std::min( prefill, _queue_limit );
+  _prefill_bytes = std::min( prefill * sizeof(gr_complex), _ring.capacity() );
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &redpitaya_sink_c::writer_task, this ) );
+
+  return true;
+}
+
+/* the samples still queued are sent before the writer exits */
+bool redpitaya_sink_c::stop()
+{
+  _ring.close();
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  _running = false;
+
+  return true;
+}
+
+/* send the ring to the socket as fast as it takes it, so work() never
+ * waits for the network */
+void redpitaya_sink_c::writer_task()
+{
+  thread_sched_apply( _sched );
+
+  int idle = 0;
+  bool prefilling = _prefill_bytes > 0;
+  std::vector< char > last;     /* for underrun=repeat */
+
+  while ( true )
+  {
+    /* nothing goes out before the prefill is queued, or the ring closed */
+    size_t want = prefilling ? _prefill_bytes : 1;
+
+    if ( !_ring.wait_for( want, std::chrono::milliseconds(REDPITAYA_POLL_MS) ) &&
+         !_ring.closed() )
+      continue;
+
+    prefilling = false;
+
+    size_t len;
+    const char *buf = _ring.read_ptr( len );
+
+    if ( !len )
+      break;      /* closed by stop() and drained */
+
+    if ( _pacer.starved() )
+      handle_underrun( last, prefilling );
+
+    if ( prefilling )
+      continue;
+
+    _pacer.throttle();
+    _sent_queued = _pacer.queued();
+
+    int ready = redpitaya_wait_socket( _sockets[1], true, REDPITAYA_POLL_MS );
+
+    if ( ready == 0 )
+    {
+      /* give up on the rest if the server stopped taking samples */
+      if ( _ring.closed() && ++idle * REDPITAYA_POLL_MS >= 1000 )
+        break;
+      continue;
+    }
+
+    if ( ready > 0 )
+    {
+#if defined(_WIN32)
+      int size = ::send( _sockets[1], buf, (int)len, 0 );
+#else
+      ssize_t size = ::send( _sockets[1], buf, len, MSG_NOSIGNAL );
+#endif
+
+      if ( size > 0 )
+      {
+        if ( _pacer.policy().underrun == tx_policy_t::UNDERRUN_REPEAT )
+          last.assign( buf, buf + size - size % sizeof(gr_complex) );
+
+        _ring.consume( size );
+        _pacer.written( size / sizeof(gr_complex) );
+        _sent_queued = _pacer.queued();
+        idle = 0;
+        continue;
+      }
+
+      if ( size < 0 && ( EINTR == errno || EAGAIN == errno ) )
+        continue;
+
+      std::cerr << "Sending samples failed." << std::endl;
+    }
+    else
+    {
+      if ( EINTR == errno )
+        continue;
+
+      std::cerr << "Waiting for the socket failed." << std::endl;
+    }
+
+    break;
+  }
+
+  _running = false;
+}
+
+/* The server doesn't tell when it ran dry, the pacer guesses it from the
+ * host clock. underrun=repeat sends the last chunk again, underrun=stop
+ * waits for a new prefill. */
+void redpitaya_sink_c::handle_underrun( std::vector< char > &last, bool &prefilling )
+{
+  _stats.underruns++;
+  std::cerr << "U" << std::flush;
+
+  if ( _pacer.policy().underrun == tx_policy_t::UNDERRUN_REPEAT && !last.empty() )
+  {
+#if defined(_WIN32)
+    ::send( _sockets[1], &last[0], (int)last.size(), 0 );
+#else
+    ::send( _sockets[1], &last[0], last.size(), MSG_NOSIGNAL );
+#endif
+  }
+  else if ( _pacer.policy().underrun == tx_policy_t::UNDERRUN_STOP )
+  {
+    prefilling = _prefill_bytes > 0 && !_ring.closed();
+  }
+}
+
 int redpitaya_sink_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
   const gr_complex *in = (const gr_complex *)input_items[0];
+  size_t nitems = 0;
 
-#if defined(_WIN32)
-  int size;
-  int total = sizeof(gr_complex) * noutput_items;
-  size = ::send( _sockets[1], (char *)in, total, 0 );
-#else
-  ssize_t size;
-  ssize_t total = sizeof(gr_complex) * noutput_items;
-  size = ::send( _sockets[1], in, total, MSG_NOSIGNAL );
-#endif
+  /* queue as many samples as fit, only waiting if none do */
+  while ( true )
+  {
+    if ( !_running )
+      return WORK_DONE;
+
+    nitems = std::min( size_t(noutput_items), _ring.space() / sizeof(gr_complex) );
+
+    /* tx_latency_ms= counts the ring and what the server holds */
+    if ( _queue_limit )
+    {
+      size_t queued = _ring.size() / sizeof(gr_complex) + _sent_queued;
+      nitems = std::min( nitems, queued < _queue_limit ? _queue_limit - queued : 0 );
+    }
+
+    if ( nitems )
+      break;
 
-  if ( size != total )
-    throw std::runtime_error( "Sending samples failed." );
+    boost::this_thread::sleep_for( boost::chrono::milliseconds(1) );
+  }
 
-  consume(0, noutput_items);
+  _ring.push( (const char *)in, nitems * sizeof(gr_complex) );
+  _stats.samples += nitems;
+
+  consume(0, nitems);
 
   return 0;
 }
@@ -295,3 +479,14 @@ std::string redpitaya_sink_c::get_antenna( size_t chan )
 {
   return "TX";
 }
+
+osmosdr::stream_stats_t redpitaya_sink_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _ring.size() / sizeof(gr_complex) + _sent_queued;
+  stats.fill_max = _ring.fill_max() / sizeof(gr_complex);
+  stats.capacity = _queue_limit ? _queue_limit : _ring.capacity() / sizeof(gr_complex);
+
+  return stats;
+}
@@ -21,9 +21,15 @@
 #ifndef REDPITAYA_SINK_C_H
 #define REDPITAYA_SINK_C_H
 
+#include <atomic>
+
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "sink_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+#include "tx_policy.h"
 
 #include "redpitaya_common.h"
 
@@ -45,6 +51,9 @@ private:
 public:
   ~redpitaya_sink_c();
 
+  bool start();
+  bool stop();
+
   int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -77,9 +86,25 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
+  void writer_task();
+  void handle_underrun( std::vector< char > &last, bool &prefilling );
+
   double _freq, _rate, _corr;
   SOCKET _sockets[2];
+
+  /* work() fills the ring, its own thread writes it to the data socket */
+  spsc_ring< char > _ring;
+  gr::thread::thread _thread;
+  thread_sched_t _sched;
+  std::atomic< bool > _running;
+  tx_pacer _pacer;                    // used by the writer only
+  size_t _prefill_bytes;
+  size_t _queue_limit;                // samples, from tx_latency_ms=, 0 for none
+  std::atomic< size_t > _sent_queued; // sent but not played, by the pacer
+  osmosdr::stream_stats_t _stats;
 };
 
 #endif // REDPITAYA_SINK_C_H
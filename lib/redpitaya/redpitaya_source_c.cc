@@ -19,12 +19,17 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <fstream>
+#include <iostream>
 #include <string>
 #include <sstream>
 #include <stdexcept>
 
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -44,13 +49,16 @@ redpitaya_source_c_sptr make_redpitaya_source_c(const std::string &args)
 redpitaya_source_c::redpitaya_source_c(const std::string &args) :
   gr::sync_block("redpitaya_source_c",
                  gr::io_signature::make(0, 0, 0),
-                 gr::io_signature::make(1, 1, sizeof(gr_complex)))
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _running(false)
 {
   std::string host = "192.168.1.100";
   std::stringstream message;
   unsigned short port = 1001;
   struct sockaddr_in addr;
   uint32_t command;
+  size_t ring_size = REDPITAYA_RING_SIZE;
+  int rcvbuf = 0;
 
 #if defined(_WIN32)
   WSADATA wsaData;
@@ -63,6 +71,9 @@ redpitaya_source_c::redpitaya_source_c(const std::string &args) :
 
   dict_t dict = params_to_dict( args );
 
+  _ring.set_buffer_opts( buffer_opts_from_dict( dict ) );
+  _sched = thread_sched_from_dict( dict );
+
   if ( dict.count( "redpitaya" ) )
   {
     std::vector< std::string > tokens;
@@ -75,17 +86,31 @@ redpitaya_source_c::redpitaya_source_c(const std::string &args) :
       port = boost::lexical_cast< unsigned short >( tokens[1] );
   }
 
+  if ( dict.count( "ring_size" ) )
+    ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
+  /* kernel socket buffer, gives slack on top of the ring */
+  if ( dict.count( "rcvbuf" ) )
+    rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
   if ( !host.length() )
     host = "192.168.1.100";
 
   if ( 0 == port )
     port = 1001;
 
+  /* whole samples only, so they never wrap around the end of the ring */
+  ring_size -= ring_size % sizeof(gr_complex);
+  _ring.resize( std::max( ring_size, size_t(64 * 1024) ) );
+
   for ( size_t i = 0; i < 2; ++i )
   {
     if ( ( _sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
       throw std::runtime_error( "Could not create TCP socket." );
 
+    if ( 1 == i )
+      redpitaya_set_buffer( _sockets[i], SO_RCVBUF, rcvbuf );
+
     memset( &addr, 0, sizeof(addr) );
     addr.sin_family = AF_INET;
     inet_pton( AF_INET, host.c_str(), &addr.sin_addr );
@@ -104,6 +129,8 @@ redpitaya_source_c::redpitaya_source_c(const std::string &args) :
 
 redpitaya_source_c::~redpitaya_source_c()
 {
+  stop();
+
 #if defined(_WIN32)
   ::closesocket( _sockets[1] );
   ::closesocket( _sockets[0] );
@@ -114,26 +141,120 @@ redpitaya_source_c::~redpitaya_source_c()
 #endif
 }
 
+bool redpitaya_source_c::start()
+{
+  if ( _running )
+    return true;
+
+  _ring.reset();
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &redpitaya_source_c::reader_task, this ) );
+
+  return true;
+}
+
+bool redpitaya_source_c::stop()
+{
+  _running = false;
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+/* read whatever the socket has into the ring, so a late work() call
+ * doesn't hold up the TCP stream and short reads don't matter */
+void redpitaya_source_c::reader_task()
+{
+  thread_sched_apply( _sched );
+
+  bool full = false;
+
+  while ( _running )
+  {
+    size_t len;
+    char *buf = _ring.write_ptr( len );
+
+    if ( !len )
+    {
+      /* ring is full, leave the rest to the kernel buffer and let TCP
+       * flow control slow down the server */
+      if ( !full )
+      {
+        _stats.overruns++;
+        std::cerr << "O" << std::flush;
+      }
+      full = true;
+      boost::this_thread::sleep_for( boost::chrono::milliseconds(1) );
+      continue;
+    }
+
+    full = false;
+
+    int ready = redpitaya_wait_socket( _sockets[1], false, REDPITAYA_POLL_MS );
+
+    if ( ready == 0 )
+      continue;
+
+    if ( ready > 0 )
+    {
+#if defined(_WIN32)
+      int size = ::recv( _sockets[1], buf, (int)len, 0 );
+#else
+      ssize_t size = ::recv( _sockets[1], buf, len, 0 );
+#endif
+
+      if ( size > 0 )
+      {
+        _ring.commit( size );
+        continue;
+      }
+
+      if ( size < 0 && ( EINTR == errno || EAGAIN == errno ) )
+        continue;
+
+      if ( size == 0 )
+        std::cerr << "Red Pitaya closed the connection." << std::endl;
+      else
+        std::cerr << "Receiving samples failed." << std::endl;
+    }
+    else
+    {
+      if ( EINTR == errno )
+        continue;
+
+      std::cerr << "Waiting for samples failed." << std::endl;
+    }
+
+    break;
+  }
+
+  _running = false;
+
+  /* release work() if it is waiting for samples */
+  _ring.close();
+}
+
 int redpitaya_source_c::work( int noutput_items,
                               gr_vector_const_void_star &input_items,
                               gr_vector_void_star &output_items )
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
-#if defined(_WIN32)
-  int size;
-  int total = sizeof(gr_complex) * noutput_items;
-  size = ::recv( _sockets[1], (char *)out, total, MSG_WAITALL );
-#else
-  ssize_t size;
-  ssize_t total = sizeof(gr_complex) * noutput_items;
-  size = ::recv( _sockets[1], out, total, MSG_WAITALL );
-#endif
+  /* wait for the reader, but take whatever it has by then */
+  while ( !_ring.wait_for( sizeof(gr_complex), std::chrono::milliseconds(REDPITAYA_POLL_MS) ) )
+    if ( !_running )
+      return WORK_DONE;
 
-  if ( size != total )
-    throw std::runtime_error( "Receiving samples failed." );
+  size_t nitems = std::min( size_t(noutput_items), _ring.size() / sizeof(gr_complex) );
+  if ( !nitems )
+    return WORK_DONE;   /* connection lost */
 
-  return noutput_items;
+  _ring.pop( (char *)out, nitems * sizeof(gr_complex) );
+  _stats.samples += nitems;
+
+  return nitems;
 }
 
 std::string redpitaya_source_c::name()
@@ -285,3 +406,14 @@ std::string redpitaya_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t redpitaya_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _ring.size() / sizeof(gr_complex);
+  stats.fill_max = _ring.fill_max() / sizeof(gr_complex);
+  stats.capacity = _ring.capacity() / sizeof(gr_complex);
+
+  return stats;
+}
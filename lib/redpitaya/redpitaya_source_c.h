@@ -21,9 +21,14 @@
 #ifndef REDPITAYA_SOURCE_C_H
 #define REDPITAYA_SOURCE_C_H
 
+#include <atomic>
+
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
 
 #include "redpitaya_common.h"
 
@@ -45,6 +50,9 @@ private:
 public:
   ~redpitaya_source_c();
 
+  bool start();
+  bool stop();
+
   int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -77,9 +85,20 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
+  void reader_task();
+
   double _freq, _rate, _corr;
   SOCKET _sockets[2];
+
+  /* the data socket is read by its own thread, work() takes from the ring */
+  spsc_ring< char > _ring;
+  gr::thread::thread _thread;
+  thread_sched_t _sched;
+  std::atomic< bool > _running;
+  osmosdr::stream_stats_t _stats;
 };
 
 #endif // REDPITAYA_SOURCE_C_H
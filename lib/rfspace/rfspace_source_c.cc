@@ -43,6 +43,7 @@
 #include <libgen.h> /* basename */
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -56,6 +57,7 @@
 #include <gnuradio/io_signature.h>
 
 #include "arg_helpers.h"
+#include "sample_convert.h"
 #include "rfspace_source_c.h"
 
 using namespace boost::assign;
@@ -63,6 +65,12 @@ using namespace boost::assign;
 #define DEFAULT_HOST  "127.0.0.1" /* We assume a running "siqs" from CuteSDR project */
 #define DEFAULT_PORT  50000
 
+#define UDP_RCVBUF      (4 * 1024 * 1024) /* bytes, socket receive buffer */
+#define UDP_BATCH       64                /* datagrams per recvmmsg() */
+#define UDP_PACKET_MAX  2048              /* bytes, larger than any data packet */
+#define UDP_FIFO_SIZE   (3 << 21)         /* bytes, a multiple of every frame size */
+#define UDP_GAP_MAX     256               /* datagrams, larger gaps are not filled */
+
 /*
  * Create a new instance of rfspace_source_c and return
  * a boost shared_ptr.  This is effectively the public constructor.
@@ -103,13 +111,25 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     _nchan(1),
     _sample_rate(NAN),
     _bandwidth(0.0f),
-    _fifo(NULL)
+    _flush_mark(0),
+    _run_udp_read_task(false),
+    _rcvbuf(UDP_RCVBUF),
+    _sample_bytes(2),
+    _gap_fill(GAP_FILL_NONE),
+    _gap_items(0),
+    _udp_written(0),
+    _udp_read(0)
 {
   std::string host = "";
   unsigned short port = 0;
 
   dict_t dict = params_to_dict(args);
 
+  buffer_opts_t buf_opts = buffer_opts_from_dict(dict);
+  _fifo.set_buffer_opts(buf_opts);
+  _udp_fifo.set_buffer_opts(buf_opts);
+  _sched = thread_sched_from_dict(dict);
+
   if ( dict.count("sdr-iq") )
     dict["rfspace"] = dict["sdr-iq"];
 
@@ -173,6 +193,42 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
   if ( _nchan < 1 || _nchan > 2 )
     throw std::runtime_error("Number of channels (nchan) must be 1 or 2");
 
+  if (dict.count("rcvbuf"))
+    _rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
+  if (dict.count("bits"))
+  {
+    size_t bits = boost::lexical_cast< size_t >( dict["bits"] );
+
+    if ( 16 != bits && 24 != bits )
+      throw std::runtime_error("Sample size (bits) must be 16 or 24");
+
+    _sample_bytes = bits / 8;
+  }
+
+  /* measured by the 16 bit conversion, the 24 bit samples don't clip */
+  const double level_period = level_meter::period_from_dict( dict );
+  if ( level_period > 0 && 3 == _sample_bytes )
+    std::cerr << "level= needs bits=16, ignored" << std::endl;
+  else if ( level_period > 0 )
+    _level.attach( this, level_period, _nchan );
+
+  /* keep the sample count contiguous over lost datagrams */
+  if (dict.count("gapfill"))
+  {
+    if ( "zero" == dict["gapfill"] )
+      _gap_fill = GAP_FILL_ZERO;
+    else if ( "last" == dict["gapfill"] )
+      _gap_fill = GAP_FILL_LAST;
+    else
+      throw std::runtime_error("Gap filling (gapfill) must be zero or last");
+  }
+
+  /* rx_time / rx_rate / rx_freq tags from the host clock */
+  if (dict.count("timekey"))
+    _tagger.enable( boost::lexical_cast< bool >( dict["timekey"] ) );
+  _tagger.set_id( pmt::string_to_symbol(args) );
+
   if ( ! host.length() )
     host = DEFAULT_HOST;
 
@@ -191,6 +247,9 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
 
   if ( stat(host.c_str(), &sb) == 0 && (sb.st_mode & S_IFMT) == S_IFCHR ) /* is character device */
   {
+    if ( 2 != _sample_bytes )
+      throw std::runtime_error("24 bit samples are supported by network radios only");
+
     _usb = open( host.c_str(), O_RDWR | O_NOCTTY );
     if ( _usb < 0 )
         throw std::runtime_error("Could not open " + host + ": " + std::string(strerror(errno)));
@@ -216,9 +275,7 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
 
     _radio = RFSPACE_SDR_IQ; /* legitimate assumption */
 
-    _fifo = new boost::circular_buffer<gr_complex>( 200000 );
-    if ( ! _fifo )
-      throw std::runtime_error( "Failed to allocate sample FIFO" );
+    _fifo.resize( 200000 );
 
     _run_usb_read_task = true;
 
@@ -306,6 +363,19 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
       throw std::runtime_error("Bind of UDP socket failed: " + std::string(strerror(errno)));
     }
 
+    /* ride out scheduling hiccups of the receive thread */
+    if ( _rcvbuf > 0 )
+      if ( setsockopt(_udp, SOL_SOCKET, SO_RCVBUF, &_rcvbuf, sizeof(_rcvbuf)) < 0 )
+        std::cerr << "Could not set SO_RCVBUF: " << strerror(errno) << std::endl;
+
+    /* let the receive thread check for shutdown now and then */
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000;
+    setsockopt(_udp, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    _udp_fifo.resize( UDP_FIFO_SIZE );
+
   }
 
   /* Wait 10 ms before sending queries to device (required for networked radios). */
@@ -477,6 +547,12 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
  */
 rfspace_source_c::~rfspace_source_c ()
 {
+  if ( _run_udp_read_task )
+  {
+    _run_udp_read_task = false;
+    _udp_thread.join();
+  }
+
   close(_tcp);
   close(_udp);
 
@@ -494,12 +570,6 @@ rfspace_source_c::~rfspace_source_c ()
   }
 
   close(_usb);
-
-  if ( _fifo )
-  {
-    delete _fifo;
-    _fifo = NULL;
-  }
 }
 
 void rfspace_source_c::apply_channel( unsigned char *cmd, size_t chan )
@@ -631,6 +701,8 @@ void rfspace_source_c::usb_read_task()
   if ( -1 == _usb )
     return;
 
+  thread_sched_apply( _sched );
+
   while ( _run_usb_read_task )
   {
     size_t nbytes = read_bytes( _usb, data, 2, _run_usb_read_task );
@@ -660,41 +732,45 @@ void rfspace_source_c::usb_read_task()
 
     if ( 1024*8 == length )
     {
-      /* push samples into the fifo */
-
-      _fifo_lock.lock();
+      /* convert samples straight into the fifo */
 
       size_t num_samples = length / 4;
-      n_avail = _fifo->capacity() - _fifo->size();
-      to_copy = (n_avail < num_samples ? n_avail : num_samples);
+      int16_t *sample = (int16_t *)(data + 2);
 
       #define SCALE_16  (1.0f/32768.0f)
 
-      int16_t *sample = (int16_t *)(data + 2);
+      to_copy = 0;
+      convert_level_t level;
 
-      for ( size_t i = 0; i < to_copy; i++ )
+      /* the free space may wrap around the end of the fifo */
+      for ( int i = 0; i < 2 && to_copy < num_samples; i++ )
       {
-        /* Push sample to the fifo */
-        _fifo->push_back( gr_complex( *(sample+0) * SCALE_16,
-                                      *(sample+1) * SCALE_16 ) );
-
-        /* offset to the next I+Q sample */
-        sample += 2;
+        n_avail = 0;
+        gr_complex *dst = _fifo.write_ptr( n_avail );
+        n_avail = std::min( n_avail, num_samples - to_copy );
+        if ( ! n_avail )
+          break;
+
+        if ( _level.enabled() )
+          convert_s16_fc32_level( sample + to_copy * 2, dst, n_avail, SCALE_16,
+                                  INT16_MAX, &level );
+        else
+          convert_s16_fc32( sample + to_copy * 2, dst, n_avail, SCALE_16 );
+        _fifo.commit( n_avail );
+        to_copy += n_avail;
       }
 
       #undef SCALE_16
 
-      _fifo_lock.unlock();
-
-      /* We have made some new samples available to the consumer in work() */
-      if (to_copy) {
-//        std::cerr << "+" << std::flush;
-        _samp_avail.notify_one();
-      }
+      if ( level.values )
+        _level.add( 0, level );
 
       /* Indicate overrun, if neccesary */
-      if (to_copy < num_samples)
+      if (to_copy < num_samples) {
+        _stats.overruns++;
+        _stats.dropped += num_samples - to_copy;
         std::cerr << "O" << std::flush;
+      }
     }
     else
     {
@@ -711,6 +787,9 @@ void rfspace_source_c::usb_read_task()
       _resp_avail.notify_one();
     }
   }
+
+  /* release work() if it is waiting for samples */
+  _fifo.close();
 }
 
 /* send periodic status requests to keep TCP connection alive */
@@ -722,6 +801,8 @@ void rfspace_source_c::tcp_keepalive_task()
   if ( -1 == _tcp )
     return;
 
+  thread_sched_apply( _sched );
+
   while ( _run_tcp_keepalive_task )
   {
     boost::this_thread::sleep_for(boost::chrono::seconds(60));
@@ -735,6 +816,21 @@ bool rfspace_source_c::start()
   _running = true;
   _keep_running = false;
 
+  if ( RFSPACE_SDR_IQ != _radio && ! _run_udp_read_task )
+  {
+    _udp_fifo.reset();
+    _last_frame.assign( 2 * _nchan * _sample_bytes, 0 );
+    _gap_items = 0;
+    _udp_written = 0;
+    _udp_read = 0;
+    _gaps.clear();
+    _tagger.start( std::isnan(_sample_rate) ? 0 : _sample_rate, get_center_freq() );
+    _level.set_sample_rate( std::isnan(_sample_rate) ? 0 : _sample_rate );
+
+    _run_udp_read_task = true;
+    _udp_thread = gr::thread::thread( boost::bind(&rfspace_source_c::udp_read_task, this) );
+  }
+
   /* SDR-IP 4.2.1 Receiver State */
   /* NETSDR 4.2.1 Receiver State */
   unsigned char start[] = { 0x08, 0x00, 0x18, 0x00, 0x80, 0x02, 0x00, 0x00 };
@@ -745,7 +841,7 @@ bool rfspace_source_c::start()
 
   unsigned char mode = 0; /* 0 = 16 bit Contiguous Mode */
 
-  if ( 0 ) /* TODO: 24 bit Contiguous mode */
+  if ( 3 == _sample_bytes ) /* 24 bit Contiguous mode */
     mode |= 0x80;
 
   if ( 0 ) /* TODO: Hardware Triggered Pulse mode */
@@ -762,9 +858,6 @@ bool rfspace_source_c::stop()
     _running = false;
   _keep_running = false;
 
-  if ( _fifo )
-    _fifo->clear();
-
   /* SDR-IP 4.2.1 Receiver State */
   /* NETSDR 4.2.1 Receiver State */
   unsigned char stop[] = { 0x08, 0x00, 0x18, 0x00, 0x00, 0x01, 0x00, 0x00 };
@@ -773,7 +866,19 @@ bool rfspace_source_c::stop()
   if ( RFSPACE_SDR_IQ == _radio )
     stop[sizeof(stop)-4] = 0x81;
 
-  return transaction( stop, sizeof(stop) );
+  bool ok = transaction( stop, sizeof(stop) );
+
+  /* the reader keeps running for the replies, so the fifo can't be
+   * cleared from here; work() drops what was received up to now */
+  _flush_mark.store( _fifo.write_count(), std::memory_order_release );
+
+  if ( _run_udp_read_task && ! _running )
+  {
+    _run_udp_read_task = false;
+    _udp_thread.join();
+  }
+
+  return ok;
 }
 
 /* Main work function, pull samples from the socket */
@@ -781,8 +886,6 @@ int rfspace_source_c::work( int noutput_items,
                            gr_vector_const_void_star &input_items,
                            gr_vector_void_star &output_items )
 {
-  unsigned char data[1024*2];
-
   if ( ! _running )
     return WORK_DONE;
 
@@ -792,22 +895,14 @@ int rfspace_source_c::work( int noutput_items,
     {
       gr_complex *out = (gr_complex *)output_items[0];
 
-      std::unique_lock<std::mutex> lock(_fifo_lock);
+      _fifo.discard( _flush_mark.load( std::memory_order_acquire ) );
 
       /* Wait until we have the requested number of samples */
-      int n_samples_avail = _fifo->size();
+      if ( ! _fifo.wait( noutput_items ) )
+        return WORK_DONE;
 
-      while ( n_samples_avail < noutput_items )
-      {
-        _samp_avail.wait(lock);
-        n_samples_avail = _fifo->size();
-      }
-
-      for ( int i = 0; i < noutput_items; ++i )
-      {
-        out[i] = _fifo->at(0);
-        _fifo->pop_front();
-      }
+      _fifo.pop( out, noutput_items );
+      _stats.samples += noutput_items;
 
 //      std::cerr << "-" << std::flush;
     }
@@ -815,88 +910,269 @@ int rfspace_source_c::work( int noutput_items,
     return noutput_items;
   }
 
-  struct sockaddr_in sa_in;           /* remote address */
-  socklen_t addrlen = sizeof(sa_in);  /* length of addresses */
-  ssize_t rx_bytes = recvfrom(_udp, data, sizeof(data), 0, (struct sockaddr *)&sa_in, &addrlen);
-  if ( rx_bytes <= 0 )
+  const size_t frame = 2 * _nchan * _sample_bytes; /* bytes per sample of all channels */
+
+  /* wait for the receive thread, but take whatever it has by then */
+  while ( ! _udp_fifo.wait_for( frame, std::chrono::milliseconds(100) ) )
+    if ( ! _running || _udp_fifo.closed() )
+      return WORK_DONE;
+
+  #define SCALE_16  (1.0f/32768.0f)
+  #define SCALE_24  (1.0f/8388608.0f)
+
+  int produced = 0;
+  convert_level_t level[2];
+
+  /* the readable values may wrap around the end of the fifo */
+  for ( int i = 0; i < 2 && produced < noutput_items; i++ )
   {
-    std::cerr << "recvfrom returned " << rx_bytes << std::endl;
-    return WORK_DONE;
+    size_t count = 0;
+    const uint8_t *src = _udp_fifo.read_ptr( count );
+
+    size_t nitems = std::min( count / frame, size_t(noutput_items - produced) );
+    if ( ! nitems )
+      break;
+
+    gr_complex *out[2] = { (gr_complex *)output_items[0] + produced,
+                           2 == _nchan ? (gr_complex *)output_items[1] + produced : NULL };
+
+    if ( 3 == _sample_bytes )
+      convert_s24_fc32_deinterleave( src, out, _nchan, nitems, SCALE_24 );
+    else if ( _level.enabled() && 1 == _nchan )
+      convert_s16_fc32_level( (const int16_t *)src, out[0], nitems, SCALE_16,
+                              INT16_MAX, &level[0] );
+    else if ( _level.enabled() )
+      convert_s16_fc32_deinterleave_level( (const int16_t *)src, out, 2, nitems,
+                                           SCALE_16, INT16_MAX, level );
+    else if ( 1 == _nchan )
+      convert_s16_fc32( (const int16_t *)src, out[0], nitems, SCALE_16 );
+    else
+      convert_s16_fc32_deinterleave( (const int16_t *)src, out, 2, nitems, SCALE_16 );
+
+    _udp_fifo.consume( nitems * frame );
+    produced += nitems;
+  }
+
+  #undef SCALE_16
+  #undef SCALE_24
+
+  for ( size_t chan = 0; chan < _nchan; chan++ )
+    if ( level[chan].values )
+      _level.add( chan, level[chan] );
+
+  _stats.samples += produced;
+
+  add_gap_tags( produced );
+
+  if ( _tagger.enabled() )
+  {
+    _tagger.get_tags( nitems_written(0), produced, _tags );
+    for ( size_t chan = 0; chan < _nchan; chan++ )
+      for ( const gr::tag_t &tag : _tags )
+        add_item_tag( chan, tag );
   }
 
+  return produced;
+}
+
+/* rx_gap with the number of samples missing, at the first sample after
+ * the gap or the first one filled in for it */
+void rfspace_source_c::add_gap_tags( int noutput_items )
+{
+  static const pmt::pmt_t gap_key = pmt::string_to_symbol("rx_gap");
+
+  std::lock_guard<std::mutex> lock( _gap_lock );
+
+  while ( _gaps.size() && _gaps.front().first < _udp_read + noutput_items )
+  {
+    const uint64_t pos = _gaps.front().first;
+    const uint64_t offset = nitems_written(0) + (pos > _udp_read ? pos - _udp_read : 0);
+
+    for ( size_t chan = 0; chan < _nchan; chan++ )
+      add_item_tag( chan, offset, gap_key, pmt::from_uint64( _gaps.front().second ), alias_pmt() );
+
+    _gaps.pop_front();
+  }
+
+  _udp_read += noutput_items;
+}
+
+/* queue nitems samples of all channels to stand in for lost ones */
+void rfspace_source_c::udp_fill( size_t nitems )
+{
+  const size_t frame = _last_frame.size();
+  size_t left = nitems * frame;
+
+  while ( left )
+  {
+    size_t count = 0;
+    uint8_t *dst = _udp_fifo.write_ptr( count );
+
+    /* whole frames, the fifo capacity is a multiple of them */
+    count = std::min( count, left );
+
+    if ( GAP_FILL_LAST == _gap_fill )
+      for ( size_t i = 0; i < count; i += frame )
+        memcpy( dst + i, &_last_frame[0], frame );
+    else
+      memset( dst, 0, count );
+
+    _udp_fifo.commit( count );
+    left -= count;
+  }
+}
+
+/* Parse one data datagram and queue its samples for work() */
+void rfspace_source_c::udp_packet( const unsigned char *data, size_t size )
+{
   #define HEADER_SIZE 2
   #define SEQNUM_SIZE 2
 
-//  bool is_24_bit = false;   // TODO: implement 24 bit sample format
+  if ( size <= HEADER_SIZE + SEQNUM_SIZE )
+    return;
 
-  /* check header */
-  if ( (0x04 == data[0] && (0x84 == data[1] || 0x82 == data[1])) )
+  /* check header, only the contiguous data of the configured sample size */
+  if ( 2 == _sample_bytes )
   {
-//    is_24_bit = false;
+    if ( ! (0x04 == data[0] && (0x84 == data[1] || 0x82 == data[1])) )
+      return;
   }
-  else if ( (0xA4 == data[0] && 0x85 == data[1]) ||
-            (0x84 == data[0] && 0x81 == data[1]) )
+  else
   {
-//    is_24_bit = true;
-    return 0;
+    if ( ! ((0xA4 == data[0] && 0x85 == data[1]) || (0x84 == data[0] && 0x81 == data[1])) )
+      return;
   }
-  else
-    return 0;
 
   uint16_t sequence = *((uint16_t *)(data + HEADER_SIZE));
 
   uint16_t diff = sequence - _sequence;
+  uint16_t lost = 0;
 
   if ( diff > 1 )
   {
-    std::cerr << "Lost " << diff << " packets from "
-              << inet_ntoa(sa_in.sin_addr) << ":" << ntohs(sa_in.sin_port)
-              << std::endl;
+    lost = diff - 1;
+
+    std::cerr << "Lost " << diff << " packets" << std::endl;
   }
 
   _sequence = (0xffff == sequence) ? 0 : sequence;
 
-  /* get pointer to samples */
-  int16_t *sample = (int16_t *)(data + HEADER_SIZE + SEQNUM_SIZE);
+  const uint8_t *sample = data + HEADER_SIZE + SEQNUM_SIZE;
 
-  size_t rx_samples = (rx_bytes - HEADER_SIZE - SEQNUM_SIZE) / (sizeof(int16_t) * 2);
+  /* whole samples of all channels only */
+  const size_t frame = 2 * _nchan * _sample_bytes;
+  size_t nitems = (size - HEADER_SIZE - SEQNUM_SIZE) / frame;
 
-  #define SCALE_16  (1.0f/32768.0f)
+  if ( lost )
+  {
+    _stats.overruns++;
+    _stats.dropped += lost * nitems;
+    _stats.lost_packets += lost;
+    _gap_items += lost * nitems;
+  }
+
+  size_t fill = 0;
+  if ( _gap_items && GAP_FILL_NONE != _gap_fill && _gap_items <= UDP_GAP_MAX * nitems )
+    fill = _gap_items;
+
+  /* all or nothing, so the channels stay aligned in the fifo */
+  if ( _udp_fifo.space() < (fill + nitems) * frame )
+  {
+    _stats.overruns++;
+    _stats.dropped += nitems;
+    _gap_items += nitems;
+    std::cerr << "O" << std::flush;
+    return;
+  }
 
-  if ( 1 == _nchan )
+  if ( _gap_items )
   {
-    gr_complex *out = (gr_complex *)output_items[0];
-    for ( size_t i = 0; i < rx_samples; i++ )
     {
-      out[i] = gr_complex( *(sample+0) * SCALE_16,
-                           *(sample+1) * SCALE_16 );
+      std::lock_guard<std::mutex> lock( _gap_lock );
+      _gaps.push_back( std::make_pair( _udp_written, _gap_items ) );
+    }
 
-      sample += 2;
+    if ( fill )
+    {
+      _tagger.transfer( fill );
+      udp_fill( fill );
+      _udp_written += fill;
     }
+    else
+    {
+      _tagger.overrun( _gap_items );
+    }
+
+    _gap_items = 0;
   }
-  else if ( 2 == _nchan )
-  {
-    rx_samples /= 2;
 
-    gr_complex *out1 = (gr_complex *)output_items[0];
-    gr_complex *out2 = (gr_complex *)output_items[1];
-    for ( size_t i = 0; i < rx_samples; i++ )
-    {
-      out1[i] = gr_complex( *(sample+0) * SCALE_16,
-                            *(sample+1) * SCALE_16 );
+  _tagger.transfer( nitems );
+  _udp_fifo.push( sample, nitems * frame );
+  _udp_written += nitems;
 
-      out2[i] = gr_complex( *(sample+2) * SCALE_16,
-                            *(sample+3) * SCALE_16 );
+  if ( nitems )
+    memcpy( &_last_frame[0], sample + (nitems - 1) * frame, frame );
 
-      sample += 4;
-    }
+  #undef HEADER_SIZE
+  #undef SEQNUM_SIZE
+}
+
+/* receive datagrams in batches, away from the scheduler */
+void rfspace_source_c::udp_read_task()
+{
+  thread_sched_apply( _sched );
+
+  std::vector< unsigned char > buf( UDP_BATCH * UDP_PACKET_MAX );
+
+#ifdef __linux__
+  struct mmsghdr msgs[UDP_BATCH];
+  struct iovec iovs[UDP_BATCH];
+
+  memset( msgs, 0, sizeof(msgs) );
+  for ( size_t i = 0; i < UDP_BATCH; i++ )
+  {
+    iovs[i].iov_base = &buf[i * UDP_PACKET_MAX];
+    iovs[i].iov_len = UDP_PACKET_MAX;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
   }
+#endif
 
-  #undef SCALE_16
+  while ( _run_udp_read_task )
+  {
+#ifdef __linux__
+    /* blocks for the first datagram only, then takes what is queued */
+    int n = recvmmsg( _udp, msgs, UDP_BATCH, MSG_WAITFORONE, NULL );
+    if ( n < 0 )
+    {
+      if ( EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno )
+      {
+        std::cerr << "recvmmsg failed: " << strerror(errno) << std::endl;
+        break;
+      }
+      continue;
+    }
+
+    for ( int i = 0; i < n; i++ )
+      udp_packet( &buf[i * UDP_PACKET_MAX], msgs[i].msg_len );
+#else
+    ssize_t rx_bytes = recv( _udp, &buf[0], UDP_PACKET_MAX, 0 );
+    if ( rx_bytes < 0 )
+    {
+      if ( EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno )
+      {
+        std::cerr << "recv failed: " << strerror(errno) << std::endl;
+        break;
+      }
+      continue;
+    }
 
-  noutput_items = rx_samples;
+    udp_packet( &buf[0], rx_bytes );
+#endif
+  }
 
-  return noutput_items;
+  /* release work() if it is waiting for samples */
+  _udp_fifo.close();
 }
 
 /* discovery protocol internals taken from CuteSDR project */
@@ -1346,6 +1622,8 @@ double rfspace_source_c::set_sample_rate( double rate )
   u32_rate |= response[sizeof(samprate)-1] << 24;
 
   _sample_rate = u32_rate;
+  _tagger.set_rate( _sample_rate );
+  _level.set_sample_rate( _sample_rate );
 
   if ( rate != _sample_rate )
     std::cerr << "Radio reported a sample rate of " << (uint32_t)_sample_rate << " Hz"
@@ -1422,7 +1700,12 @@ double rfspace_source_c::set_center_freq( double freq, size_t chan )
 
   transaction( tune, sizeof(tune) );
 
-  return get_center_freq( chan );
+  double actual = get_center_freq( chan );
+
+  if ( 0 == chan )
+    _tagger.retune( actual );
+
+  return actual;
 }
 
 double rfspace_source_c::get_center_freq( size_t chan )
@@ -1628,3 +1911,27 @@ osmosdr::freq_range_t rfspace_source_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr::stream_stats_t rfspace_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  if ( RFSPACE_SDR_IQ == _radio )
+  {
+    stats.fill = _fifo.size();
+    stats.fill_max = _fifo.fill_max();
+    stats.capacity = _fifo.capacity();
+  }
+  else
+  {
+    const size_t frame = 2 * _nchan * _sample_bytes;
+
+    stats.fill = _udp_fifo.size() / frame;
+    stats.fill_max = _udp_fifo.fill_max() / frame;
+    stats.capacity = _udp_fifo.capacity() / frame;
+  }
+
+  _level.get_stats( chan, stats );
+
+  return stats;
+}
@@ -24,13 +24,16 @@
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
 
-#include <boost/circular_buffer.hpp>
-
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 
 #include "osmosdr/ranges.h"
+#include "level_meter.h"
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "stream_tagger.h"
+#include "thread_sched.h"
 class rfspace_source_c;
 
 #ifndef SOCKET
@@ -112,6 +115,8 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private: /* functions */
   void apply_channel( unsigned char *cmd, size_t chan = 0 );
 
@@ -121,7 +126,11 @@ private: /* functions */
                     std::vector< unsigned char > &response );
 
   void usb_read_task();
+  void udp_read_task();
   void tcp_keepalive_task();
+  void udp_packet( const unsigned char *data, size_t size );
+  void udp_fill( size_t nitems );
+  void add_gap_tags( int noutput_items );
 
 private: /* members */
   enum radio_type
@@ -148,13 +157,41 @@ private: /* members */
   double _bandwidth;
 
   gr::thread::thread _thread;
+  thread_sched_t _sched;
   bool _run_usb_read_task;
   bool _run_tcp_keepalive_task;
   std::mutex _tcp_lock;
 
-  boost::circular_buffer<gr_complex> *_fifo;
-  std::mutex _fifo_lock;
-  std::condition_variable _samp_avail;
+  spsc_ring<gr_complex> _fifo;
+  std::atomic<size_t> _flush_mark;  // work() drops what came before it
+  osmosdr::stream_stats_t _stats;
+  level_meter _level;
+
+  /* network radios, raw I/Q bytes of all channels interleaved */
+  gr::thread::thread _udp_thread;
+  bool _run_udp_read_task;
+  int _rcvbuf;
+  size_t _sample_bytes;         /* 2 or 3, per I or Q value */
+  spsc_ring<uint8_t> _udp_fifo;
+
+  /* sequence gaps, bridged with GAP_FILL_ZERO / GAP_FILL_LAST samples */
+  enum gap_fill
+  {
+    GAP_FILL_NONE = 0,
+    GAP_FILL_ZERO,
+    GAP_FILL_LAST
+  };
+
+  gap_fill _gap_fill;
+  std::vector< uint8_t > _last_frame;
+  uint64_t _gap_items;          /* missing since the last queued datagram */
+  uint64_t _udp_written;        /* samples queued, resp. taken out of the fifo */
+  uint64_t _udp_read;
+  std::mutex _gap_lock;
+  std::deque< std::pair< uint64_t, uint64_t > > _gaps; /* position, samples missing */
+
+  stream_tagger _tagger;
+  std::vector< gr::tag_t > _tags;
 
   std::vector< unsigned char > _resp;
   std::mutex _resp_lock;
@@ -41,12 +41,16 @@
 #include <rtl-sdr.h>
 
 #include "arg_helpers.h"
+#include "device_pool.h"
+#include "sample_convert.h"
 
 using namespace boost::assign;
 
 #define BUF_LEN  (16 * 32 * 512) /* must be multiple of 512 */
 #define BUF_NUM   15
 #define BUF_SKIP  1 // buffers to skip due to initial garbage
+#define BUF_MIN   3 // buffers to collect before work() starts draining
+#define OUT_TRANSFERS  4 // transfers the output buffer takes at least
 
 #define BYTES_PER_SAMPLE  2 // rtl device delivers 8 bit unsigned IQ data
 
@@ -60,6 +64,20 @@ make_rtl_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new rtl_source_c (args));
 }
 
+/* the dongles kept open with linger=, under their serial or index and the
+ * xtal frequencies, which librtlsdr can't set back to the defaults */
+static device_pool< rtlsdr_dev_t > _pool;
+
+static std::shared_ptr< rtlsdr_dev_t > open_device( unsigned int index )
+{
+  rtlsdr_dev_t *dev = NULL;
+
+  if ( rtlsdr_open( &dev, index ) < 0 )
+    throw std::runtime_error("Failed to open rtlsdr device.");
+
+  return std::shared_ptr< rtlsdr_dev_t >( dev, rtlsdr_close );
+}
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -82,12 +100,31 @@ rtl_source_c::rtl_source_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
-    _buf(NULL),
+    _buf_drop(NULL),
+    _min_buffers(BUF_MIN),
+    _latency(0),
     _running(false),
+    _zero_copy(false),
+    _sc8(false),
+    _fast_retune(false),
+    _settle(0),
+    _settle_left(0),
+    _retune(false),
+    _retune_freq(0),
+    _flush_mark(0),
+    _rerate(false),
+    _rerate_rate(0),
+    _resize(false),
     _no_tuner(false),
     _auto_gain(false),
     _if_gain(0),
-    _skipped(0)
+    _skipped(0),
+    _watchdog_timeout(0),
+    _restarting(false),
+    _linger(0),
+    _dev_index(0),
+    _bias_tee(0),
+    _resume()
 {
   int ret;
   int index;
@@ -100,6 +137,10 @@ rtl_source_c::rtl_source_c (const std::string &args)
 
   dict_t dict = params_to_dict(args);
 
+  _buf_opts = buffer_opts_from_dict( dict );
+  _ring.set_buffer_opts( _buf_opts );
+  _sched = thread_sched_from_dict( dict );
+
   if (dict.count("rtl")) {
     std::string value = dict["rtl"];
 
@@ -120,6 +161,8 @@ rtl_source_c::rtl_source_c (const std::string &args)
   if ( dev_index >= rtlsdr_get_device_count() )
     throw std::runtime_error("Wrong rtlsdr device index given.");
 
+  _dev_index = dev_index;
+
   std::cerr << "Using device #" << dev_index;
 
   memset(manufact, 0, sizeof(manufact));
@@ -132,6 +175,7 @@ rtl_source_c::rtl_source_c (const std::string &args)
       std::cerr << " " << product;
     if (strlen(serial))
       std::cerr << " SN: " << serial;
+    _serial = serial;
   } else {
     std::cerr << " " << rtlsdr_get_device_name(dev_index);
   }
@@ -152,8 +196,9 @@ rtl_source_c::rtl_source_c (const std::string &args)
 
   if (dict.count("bias"))
     bias_tee = boost::lexical_cast<bool>( dict["bias"] );
+  _bias_tee = bias_tee;
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _buf_num = _buf_len = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -161,27 +206,93 @@ rtl_source_c::rtl_source_c (const std::string &args)
   if (dict.count("buflen"))
     _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
 
+  if (dict.count("zerocopy"))
+    _zero_copy = boost::lexical_cast< bool >( dict["zerocopy"] );
+
+  /* rx_time / rx_rate / rx_freq tags from the host clock */
+  _tagger.enable_rate_tags( true );
+  if (dict.count("timekey"))
+    _tagger.enable( boost::lexical_cast< bool >( dict["timekey"] ) );
+  _tagger.set_id( pmt::string_to_symbol(args) );
+
+  /* on retune drop what was queued before, the transfer in flight and
+   * this many samples after it, the first one after is tagged with rx_freq */
+  if (dict.count("settle")) {
+    _fast_retune = true;
+    _settle = boost::lexical_cast< size_t >( dict["settle"] );
+    _tagger.enable_freq_tags( true );
+  }
+
+  /* target latency in ms, buflen is then derived from the sample rate */
+  if (dict.count("latency")) {
+    _latency = boost::lexical_cast< double >( dict["latency"] ) / 1e3;
+    _min_buffers = 1;
+  }
+
+  /* 0 lets work() drain a transfer as soon as it arrives */
+  if (dict.count("min_buffers"))
+    _min_buffers = boost::lexical_cast< unsigned int >( dict["min_buffers"] );
+
+  /* host side decimation while converting, the sample rates are divided
+   * accordingly */
+  if (dict.count("decim"))
+    _decimator.set_decimation( boost::lexical_cast< size_t >( dict["decim"] ) );
+
+  /* reopen the dongle when its stream ends or stalls, the gap is told by
+   * the rx_time tag after it */
+  _watchdog_timeout = stream_watchdog::timeout_from_dict( dict );
+  if (_watchdog_timeout > 0)
+    _tagger.enable( true );
+
+  /* stream only in windows, each one starts with rx_time and is handed
+   * out as soon as it arrives */
+  _snapshot.configure( dict );
+  if (_snapshot.enabled()) {
+    if (_zero_copy || _watchdog_timeout > 0)
+      throw std::runtime_error("snapshot= can't be combined with zerocopy= or watchdog=.");
+    _tagger.enable( true );
+    _min_buffers = 0;
+  }
+
+  /* measured at the rate of the dongle, ahead of the decimator */
+  const double level_period = level_meter::period_from_dict( dict );
+  if (level_period > 0)
+    _level.attach( this, level_period );
+
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
 
   if (0 == _buf_len || _buf_len % 512 != 0) /* len must be multiple of 512 */
     _buf_len = BUF_LEN;
 
+  if (_min_buffers > _buf_num)
+    _min_buffers = _buf_num;
+
   if ( BUF_NUM != _buf_num || BUF_LEN != _buf_len ) {
     std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
               << std::endl;
   }
 
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+  /* work() is asked for whole transfers, with room for a few of them, so
+   * a call drains what arrived rather than a bit of it. With latency= the
+   * transfers are only sized in start(), after the buffers are made. */
+  if (_latency <= 0) {
+    const int transfer = _buf_len / BYTES_PER_SAMPLE / _decimator.decimation();
+    set_output_multiple( transfer );
+    set_min_output_buffer( OUT_TRANSFERS * transfer );
+  }
 
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i < 0x100; i++)
-    _lut.push_back((i - 127.4f) / 128.0f);
+  _linger = device_pool< rtlsdr_dev_t >::linger_from_dict( dict );
+  _pool_key = str( boost::format("%s/%u/%u")
+                   % ( _serial.size() ? _serial : std::to_string( dev_index ) )
+                   % rtl_freq % tuner_freq );
 
-  _dev = NULL;
-  ret = rtlsdr_open( &_dev, dev_index );
-  if (ret < 0)
-    throw std::runtime_error("Failed to open rtlsdr device.");
+  bool reused = false;
+  _handle = _pool.acquire( _pool_key, false, _linger,
+                           [dev_index]() { return open_device( dev_index ); }, &reused );
+  _dev = _handle.get();
+  if (reused)
+    std::cerr << "Using the device left open by the last flowgraph." << std::endl;
 
   if (rtl_freq > 0 || tuner_freq > 0) {
     if (rtl_freq)
@@ -207,14 +318,15 @@ rtl_source_c::rtl_source_c (const std::string &args)
   if (ret < 0)
     throw std::runtime_error("Failed to set agc mode.");
 
-  if (direct_samp) {
+  /* a device left open may still have them on */
+  if (direct_samp || reused) {
     ret = rtlsdr_set_direct_sampling(_dev, direct_samp);
     if (ret < 0)
       throw std::runtime_error("Failed to enable direct sampling.");
-    _no_tuner = true;
+    _no_tuner = direct_samp != 0;
   }
 
-  if (offset_tune) {
+  if (offset_tune || (reused && rtlsdr_get_offset_tuning(_dev) > 0)) {
     ret = rtlsdr_set_offset_tuning(_dev, offset_tune);
     if (ret < 0)
       throw std::runtime_error("Failed to enable offset tuning.");
@@ -230,11 +342,13 @@ rtl_source_c::rtl_source_c (const std::string &args)
 
   set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
 
-  _buf = (unsigned char **)malloc(_buf_num * sizeof(unsigned char *));
+  _ring.resize( _buf_num * _buf_len );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned char *)malloc(_buf_len);
+  /* in zero copy mode the samples are read straight into the ring,
+   * data arriving while the ring is full goes to the drop buffer instead */
+  if (_zero_copy) {
+    _buf_drop = (unsigned char *)buffer_acquire( _buf_len, _buf_opts );
+    std::cerr << "Using zero copy transfers." << std::endl;
   }
 }
 
@@ -243,46 +357,181 @@ rtl_source_c::rtl_source_c (const std::string &args)
  */
 rtl_source_c::~rtl_source_c ()
 {
+  _watchdog.stop();
+
   if (_dev) {
     if (_running)
     {
       _running = false;
       rtlsdr_cancel_async( _dev );
-      _thread.join();
+      _snapshot.stop();
+      if (_thread.joinable())
+        _thread.join();
     }
 
-    rtlsdr_close( _dev );
+    _handle.reset();
     _dev = NULL;
   }
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-  }
+  buffer_release( _buf_drop );
+  _buf_drop = NULL;
 }
 
 bool rtl_source_c::start()
 {
+  apply_latency();
+  _level.set_sample_rate( get_device_rate() );
+
+  _ring.reset();
+  _latency_stats.reset();
+  _decimator.reset();
+  /* the tagger counts the samples before decimation */
+  _tagger.start( get_device_rate(), get_center_freq() );
+  _retune = false;
+  _rerate = false;
+  _resize = false;
+  _settle_left = 0;
+  _flush_mark = 0;
   _running = true;
-  _thread = gr::thread::thread(_rtlsdr_wait, this);
+  _restarting = false;
+
+  if (_snapshot.enabled())
+    _snapshot.start( [this]() { return get_device_rate(); },
+                     [this]() { return read_snapshot(); },
+                     []() {} );
+  else
+    _thread = gr::thread::thread(_rtlsdr_wait, this);
+
+  /* a blocking read can't be interrupted, so with zero copy only a
+   * stream that ended gets restarted */
+  _watchdog.start( _watchdog_timeout, [this]() { return restart_stream(); }, !_zero_copy );
 
   return true;
 }
 
 bool rtl_source_c::stop()
 {
+  _watchdog.stop();
+
   _running = false;
   if (_dev)
     rtlsdr_cancel_async( _dev );
-  _thread.join();
+  _snapshot.stop();
+  if (_thread.joinable())
+    _thread.join();
+
+  /* the reader leaves the ring open when the watchdog was to restart it */
+  _ring.close();
+
+  return true;
+}
+
+/* opens the dongle again with the settings it had, called from the
+ * watchdog thread after the stream ended or stalled */
+bool rtl_source_c::restart_stream()
+{
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
+  _restarting = true;
+
+  if (_dev) {
+    rtlsdr_cancel_async( _dev );
+    if (_thread.joinable())
+      _thread.join();
+
+    /* librtlsdr answers these from what it set, even with the dongle gone */
+    _resume.rate = rtlsdr_get_sample_rate( _dev );
+    _resume.freq = rtlsdr_get_center_freq( _dev );
+    _resume.ppm = rtlsdr_get_freq_correction( _dev );
+    _resume.gain = rtlsdr_get_tuner_gain( _dev );
+    _resume.direct_samp = rtlsdr_get_direct_sampling( _dev );
+    _resume.offset_tune = rtlsdr_get_offset_tuning( _dev );
+    rtlsdr_get_xtal_freq( _dev, &_resume.rtl_xtal, &_resume.tuner_xtal );
+
+    /* not to be handed to the next flowgraph */
+    _pool.discard( _handle );
+    _handle.reset();
+    _dev = NULL;
+  }
+
+  /* the index may have changed when the dongle got plugged in again */
+  int index = _dev_index;
+  if (_serial.size())
+    index = rtlsdr_get_index_by_serial( _serial.c_str() );
+
+  if (index < 0)
+    return false;
+
+  try {
+    _handle = _pool.acquire( _pool_key, false, _linger,
+                             [index]() { return open_device( index ); } );
+  } catch ( const std::exception & ) {
+    return false;
+  }
+  _dev = _handle.get();
+
+  rtlsdr_set_xtal_freq( _dev, _resume.rtl_xtal, _resume.tuner_xtal );
+  rtlsdr_set_sample_rate( _dev, _resume.rate );
+  if (_resume.direct_samp > 0)
+    rtlsdr_set_direct_sampling( _dev, _resume.direct_samp );
+  if (_resume.offset_tune > 0)
+    rtlsdr_set_offset_tuning( _dev, _resume.offset_tune );
+  rtlsdr_set_bias_tee( _dev, _bias_tee );
+  rtlsdr_set_freq_correction( _dev, _resume.ppm );
+  rtlsdr_set_center_freq( _dev, _resume.freq );
+
+  set_gain_mode( _auto_gain );
+  if (!_auto_gain)
+    rtlsdr_set_tuner_gain( _dev, _resume.gain );
+  set_if_gain( _if_gain );
+
+  rtlsdr_reset_buffer( _dev );
+
+  std::cerr << "Restarted streaming from device #" << index << "." << std::endl;
+
+  /* the first transfer gets a fresh rx_time */
+  _tagger.set_rate( _resume.rate );
+  _stats.restarted();
+  _skipped = 0;
+
+  _restarting = false;
+  _thread = gr::thread::thread(_rtlsdr_wait, this);
 
   return true;
 }
 
+/* the transfer length for the latency target at the current rate */
+unsigned int rtl_source_c::latency_len()
+{
+  unsigned int len = (unsigned int)(get_device_rate() * BYTES_PER_SAMPLE * _latency);
+
+  len = std::max(1u, (len + 511) / 512) * 512; /* len must be multiple of 512 */
+  return std::min(len, (unsigned int)BUF_LEN);
+}
+
+/* size the transfers to the requested latency at the current sample rate */
+void rtl_source_c::apply_latency()
+{
+  if (_latency <= 0)
+    return;
+
+  unsigned int len = latency_len();
+
+  if (len == _buf_len)
+    return;
+
+  _buf_len = len;
+  _ring.resize( _buf_num * _buf_len );
+
+  if (_buf_drop) {
+    buffer_release( _buf_drop );
+    _buf_drop = (unsigned char *)buffer_acquire( _buf_len, _buf_opts );
+  }
+
+  std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
+            << std::endl;
+}
+
 void rtl_source_c::_rtlsdr_callback(unsigned char *buf, uint32_t len, void *ctx)
 {
   rtl_source_c *obj = (rtl_source_c *)ctx;
@@ -291,26 +540,38 @@ void rtl_source_c::_rtlsdr_callback(unsigned char *buf, uint32_t len, void *ctx)
 
 void rtl_source_c::rtlsdr_callback(unsigned char *buf, uint32_t len)
 {
+  _watchdog.feed();
+
   if (_skipped < BUF_SKIP) {
     _skipped++;
     return;
   }
 
-  {
-    std::lock_guard<std::mutex> lock( _buf_mutex );
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
+  /* what's past the snapshot is dropped, the stream ends with it */
+  if (_snapshot.enabled()) {
+    const uint32_t taken = _snapshot.take( len / BYTES_PER_SAMPLE ) * BYTES_PER_SAMPLE;
+    if (taken < len)
+      rtlsdr_cancel_async( _dev );
+    if (!taken)
+      return;
+    len = taken;
+  }
 
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
+  /* work() may still be converting the oldest transfer, so drop the new one */
+  if (_ring.space() < len) {
+    _stats.overrun( len / BYTES_PER_SAMPLE );
+    _tagger.overrun( len / BYTES_PER_SAMPLE );
+    std::cerr << "O" << std::flush;
+    return;
   }
 
-  _buf_cond.notify_one();
+  const size_t skip = settle_samples( len / BYTES_PER_SAMPLE ) * BYTES_PER_SAMPLE;
+  if (skip == len)
+    return;
+
+  _tagger.transfer( (len - skip) / BYTES_PER_SAMPLE );
+  _latency_stats.arrival( _ring.write_count() );
+  _ring.push(buf + skip, len - skip);
 }
 
 void rtl_source_c::_rtlsdr_wait(rtl_source_c *obj)
@@ -320,14 +581,148 @@ void rtl_source_c::_rtlsdr_wait(rtl_source_c *obj)
 
 void rtl_source_c::rtlsdr_wait()
 {
+  thread_sched_apply( _sched );
+
+  if (_zero_copy) {
+    rtlsdr_read_loop();
+    return;
+  }
+
+  int ret;
+
+  while (true) {
+    ret = rtlsdr_read_async( _dev, _rtlsdr_callback, (void *)this, _buf_num, _buf_len );
+
+    /* cancelled by a rate change, the transfers are sized for it while
+     * the ring stays, so they can only get as long as it allows */
+    if ( ret != 0 || !_running || _restarting || !_resize.exchange( false ) )
+      break;
+
+    _buf_len = std::min( latency_len(), (unsigned int)(_ring.capacity() / _buf_num) / 512 * 512 );
+    std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
+              << std::endl;
+  }
+
+  if ( ret != 0 )
+    std::cerr << "rtlsdr_read_async returned with " << ret << std::endl;
+
+  stream_ended();
+}
+
+/* streams one snapshot on the timer thread, until the callback took it */
+bool rtl_source_c::read_snapshot()
+{
+  if (!_running)
+    return false;
+
+  _skipped = 0;
+  rtlsdr_reset_buffer( _dev );
+  _tagger.set_rate( get_device_rate() );
+
   int ret = rtlsdr_read_async( _dev, _rtlsdr_callback, (void *)this, _buf_num, _buf_len );
+  if ( ret != 0 )
+    std::cerr << "rtlsdr_read_async returned with " << ret << std::endl;
+
+  return false;
+}
+
+/* the watchdog restarts the stream unless it got stopped */
+void rtl_source_c::stream_ended()
+{
+  if (_restarting)
+    return;
+
+  if (_running && _watchdog.enabled()) {
+    _watchdog.ended();
+    return;
+  }
 
   _running = false;
+  _ring.close();
+}
+
+void rtl_source_c::rtlsdr_read_loop()
+{
+  int ret = 0;
+
+  while (_running && !_restarting) {
+    size_t len;
+    int n_read = 0;
+
+    /* we only ever commit whole transfers, so a free slot is contiguous */
+    unsigned char *buf = _ring.write_ptr(len);
+    if (len < _buf_len) {
+      _stats.overrun( _buf_len / BYTES_PER_SAMPLE );
+      _tagger.overrun( _buf_len / BYTES_PER_SAMPLE );
+      std::cerr << "O" << std::flush;
+      buf = _buf_drop;
+    }
+
+    ret = rtlsdr_read_sync( _dev, buf, _buf_len, &n_read );
+    if (ret < 0)
+      break;
+
+    _watchdog.feed();
+
+    if (_skipped < BUF_SKIP) {
+      _skipped++;
+      continue;
+    }
+
+    if (buf == _buf_drop)
+      continue;
+
+    if (n_read != int(_buf_len)) {
+      _tagger.overrun( n_read / BYTES_PER_SAMPLE );
+      continue;
+    }
+
+    /* only whole transfers may go into the ring, so the settle interval
+     * gets rounded up to the end of the transfer */
+    const size_t nsamples = _buf_len / BYTES_PER_SAMPLE;
+    const size_t skip = settle_samples( nsamples );
+    if (skip) {
+      _tagger.skip( nsamples - skip );
+      continue;
+    }
+
+    _tagger.transfer( _buf_len / BYTES_PER_SAMPLE );
+    _latency_stats.arrival( _ring.write_count() );
+    _ring.commit(_buf_len);
+  }
 
   if ( ret != 0 )
-    std::cerr << "rtlsdr_read_async returned with " << ret << std::endl;
+    std::cerr << "rtlsdr_read_sync returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  stream_ended();
+}
+
+/* number of leading samples of a transfer that belong to the settle interval */
+size_t rtl_source_c::settle_samples( size_t nsamples )
+{
+  if (_retune.exchange( false, std::memory_order_acquire )) {
+    /* everything committed so far was captured before the retune, and
+     * so was most of this transfer, the settle interval counts from its
+     * end, the earliest the retune is known to have taken effect */
+    _flush_mark.store( _ring.write_count(), std::memory_order_release );
+    _settle_left = nsamples + _settle;
+    _tagger.retune( _retune_freq.load() );
+  }
+
+  /* the same for a rate change, this transfer may still be partly at the
+   * old rate and goes as well, rx_rate comes with the next one */
+  if (_rerate.exchange( false, std::memory_order_acquire )) {
+    _flush_mark.store( _ring.write_count(), std::memory_order_release );
+    _settle_left = std::max( _settle, nsamples );
+    _tagger.rerate( _rerate_rate.load() );
+  }
+
+  const size_t skip = std::min( nsamples, _settle_left );
+
+  _settle_left -= skip;
+  _tagger.skip( skip );
+
+  return skip;
 }
 
 int rtl_source_c::work( int noutput_items,
@@ -335,42 +730,108 @@ int rtl_source_c::work( int noutput_items,
                         gr_vector_void_star &output_items )
 {
   gr_complex *out = (gr_complex *)output_items[0];
+  int8_t *out8 = (int8_t *)output_items[0];
+  int produced = 0;
+  convert_level_t level;
 
-  {
-    std::unique_lock<std::mutex> lock( _buf_mutex );
-
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
+  _ring.wait( std::max(_min_buffers * _buf_len, (unsigned int)BYTES_PER_SAMPLE) );
 
   if (!_running)
     return WORK_DONE;
 
-  while (noutput_items && _buf_used) {
-    const int nout = std::min(noutput_items, _samp_avail);
-    const unsigned char *buf = _buf[_buf_head] + _buf_offset * 2;
+  const size_t flushed = _ring.discard( _flush_mark.load( std::memory_order_acquire ) );
+  if (flushed) {
+    _tagger.discard( flushed / BYTES_PER_SAMPLE );
+    _latency_stats.discarded( _ring.read_count() );
+    _decimator.reset();
+  }
 
-    for (int i = 0; i < nout; ++i)
-      *out++ = gr_complex(_lut[buf[i * 2]], _lut[buf[i * 2 + 1]]);
+  const size_t decim = _decimator.decimation();
+  if (decim > 1)
+    return work_decimated( noutput_items, out );
+
+  while (produced < noutput_items) {
+    size_t len;
+    const unsigned char *buf = _ring.read_ptr( len );
+    const int nout = std::min<size_t>(noutput_items - produced, len / BYTES_PER_SAMPLE);
+
+    if (!nout)
+      break;
+
+    if (_sc8)
+      convert_u8_sc8( buf, out8, nout );
+    else if (_level.enabled())
+      convert_u8_fc32_level( buf, out, nout, &level );
+    else
+      convert_u8_fc32( buf, out, nout );
+    out += nout;
+    out8 += nout * 2;
+
+    produced += nout;
+    _ring.consume( nout * BYTES_PER_SAMPLE );
+  }
 
-    noutput_items -= nout;
-    _samp_avail -= nout;
+  _latency_stats.consumed( _ring.read_count(), _ring.size() );
+  _stats.produced( produced );
+  if (level.values)
+    _level.add( 0, level );
 
-    if (!_samp_avail) {
-      {
-        std::lock_guard<std::mutex> lock( _buf_mutex );
+  if (_tagger.enabled()) {
+    _tagger.get_tags( nitems_written(0), produced, _tags );
+    for (const gr::tag_t &tag : _tags)
+      add_item_tag( 0, tag );
+  }
 
-        _buf_head = (_buf_head + 1) % _buf_num;
-        _buf_used--;
-      }
-      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
-      _buf_offset = 0;
-    } else {
-      _buf_offset += nout;
+  return produced;
+}
+
+/* converts and decimates in one pass, the full rate samples never reach
+ * the output buffer */
+int rtl_source_c::work_decimated( int noutput_items, gr_complex *out )
+{
+  const size_t decim = _decimator.decimation();
+  const size_t held = _decimator.pending();
+  size_t consumed = 0;
+  int produced = 0;
+  convert_level_t level;
+
+  while (true) {
+    size_t len;
+    const unsigned char *buf = _ring.read_ptr( len );
+    const size_t nin = std::min<size_t>( noutput_items * decim - held - consumed,
+                                         len / BYTES_PER_SAMPLE );
+
+    if (!nin)
+      break;
+
+    if (_level.enabled())
+      produced += _decimator.convert( buf, nin, out + produced,
+          [&level]( const unsigned char *in, gr_complex *to, size_t n ) {
+            convert_u8_fc32_level( in, to, n, &level ); } );
+    else
+      produced += _decimator.convert( buf, nin, out + produced, convert_u8_fc32 );
+
+    consumed += nin;
+    _ring.consume( nin * BYTES_PER_SAMPLE );
+  }
+
+  _latency_stats.consumed( _ring.read_count(), _ring.size() );
+  _stats.produced( produced );
+  if (level.values)
+    _level.add( 0, level );
+
+  if (_tagger.enabled()) {
+    /* the samples held back come first in the next output sample */
+    _tagger.get_tags( 0, consumed, _tags );
+    for (gr::tag_t &tag : _tags) {
+      tag.offset = nitems_written(0) + (tag.offset + held) / decim;
+      if ( pmt::eq( tag.key, stream_tagger::RATE_KEY() ) )
+        tag.value = pmt::from_double( get_sample_rate() );
+      add_item_tag( 0, tag );
     }
   }
 
-  return (out - ((gr_complex *)output_items[0]));
+  return produced;
 }
 
 std::vector<std::string> rtl_source_c::get_devices()
@@ -432,13 +893,37 @@ osmosdr::meta_range_t rtl_source_c::get_sample_rates()
 //  range += osmosdr::range_t( 3000000 ); // may work
 //  range += osmosdr::range_t( 3200000 ); // max rate
 
+  if (_decimator.decimation() > 1) {
+    osmosdr::meta_range_t decimated;
+    for (const osmosdr::range_t &r : range)
+      decimated.push_back( osmosdr::range_t( r.start() / _decimator.decimation() ) );
+    return decimated;
+  }
+
   return range;
 }
 
 double rtl_source_c::set_sample_rate(double rate)
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if (_dev) {
-    rtlsdr_set_sample_rate( _dev, (uint32_t)rate );
+    rtlsdr_set_sample_rate( _dev, (uint32_t)(rate * _decimator.decimation()) );
+    _level.set_sample_rate( get_device_rate() );
+
+    if (_running && !_snapshot.enabled()) {
+      /* the reader flushes what came at the old rate and tags the new one */
+      _rerate_rate.store( get_device_rate() );
+      _rerate.store( true, std::memory_order_release );
+
+      /* the latency target wants other transfers, read_async starts over */
+      if (_latency > 0 && !_zero_copy && latency_len() != _buf_len) {
+        _resize = true;
+        rtlsdr_cancel_async( _dev );
+      }
+    } else {
+      _tagger.set_rate( get_device_rate() );
+    }
   }
 
   return get_sample_rate();
@@ -446,6 +931,14 @@ double rtl_source_c::set_sample_rate(double rate)
 
 double rtl_source_c::get_sample_rate()
 {
+  return get_device_rate() / _decimator.decimation();
+}
+
+/* of the samples coming from the dongle, before decimation */
+double rtl_source_c::get_device_rate()
+{
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if (_dev)
     return (double)rtlsdr_get_sample_rate( _dev );
 
@@ -488,14 +981,27 @@ osmosdr::freq_range_t rtl_source_c::get_freq_range( size_t chan )
 
 double rtl_source_c::set_center_freq( double freq, size_t chan )
 {
-  if (_dev)
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
+  if (_dev) {
     rtlsdr_set_center_freq( _dev, (uint32_t)freq );
 
+    if (_fast_retune) {
+      /* the reader thread picks it up with the next transfer */
+      _retune_freq.store( get_center_freq( chan ) );
+      _retune.store( true, std::memory_order_release );
+    } else {
+      _tagger.retune( get_center_freq( chan ) );
+    }
+  }
+
   return get_center_freq( chan );
 }
 
 double rtl_source_c::get_center_freq( size_t chan )
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if (_dev)
     return (double)rtlsdr_get_center_freq( _dev );
 
@@ -504,6 +1010,8 @@ double rtl_source_c::get_center_freq( size_t chan )
 
 double rtl_source_c::set_freq_corr( double ppm, size_t chan )
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if ( _dev )
     rtlsdr_set_freq_correction( _dev, (int)ppm );
 
@@ -512,6 +1020,8 @@ double rtl_source_c::set_freq_corr( double ppm, size_t chan )
 
 double rtl_source_c::get_freq_corr( size_t chan )
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if ( _dev )
     return (double)rtlsdr_get_freq_correction( _dev );
 
@@ -568,6 +1078,8 @@ osmosdr::gain_range_t rtl_source_c::get_gain_range( const std::string & name, si
 
 bool rtl_source_c::set_gain_mode( bool automatic, size_t chan )
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if (_dev) {
     if (!rtlsdr_set_tuner_gain_mode(_dev, int(!automatic))) {
       _auto_gain = automatic;
@@ -586,6 +1098,8 @@ bool rtl_source_c::get_gain_mode( size_t chan )
 
 double rtl_source_c::set_gain( double gain, size_t chan )
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   osmosdr::gain_range_t rf_gains = rtl_source_c::get_gain_range( chan );
 
   if (_dev) {
@@ -606,6 +1120,8 @@ double rtl_source_c::set_gain( double gain, const std::string & name, size_t cha
 
 double rtl_source_c::get_gain( size_t chan )
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if ( _dev )
     return ((double)rtlsdr_get_tuner_gain( _dev )) / 10.0;
 
@@ -623,6 +1139,8 @@ double rtl_source_c::get_gain( const std::string & name, size_t chan )
 
 double rtl_source_c::set_if_gain(double gain, size_t chan)
 {
+  std::lock_guard<std::recursive_mutex> lock( _dev_mutex );
+
   if ( _dev ) {
     if ( rtlsdr_get_tuner_type(_dev) != RTLSDR_TUNER_E4000 ) {
       _if_gain = 0;
@@ -704,3 +1222,31 @@ std::string rtl_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t rtl_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats;
+
+  _stats.get_stats( stats );
+
+  stats.fill = _ring.size() / BYTES_PER_SAMPLE;
+  stats.fill_max = _ring.fill_max() / BYTES_PER_SAMPLE;
+  stats.capacity = _ring.capacity() / BYTES_PER_SAMPLE;
+  _latency_stats.get_stats( stats, BYTES_PER_SAMPLE );
+  _level.get_stats( chan, stats );
+
+  return stats;
+}
+
+/* 8 bit samples are handed out as they come, without going through float */
+bool rtl_source_c::set_output_type( const std::string &type )
+{
+  /* decimated samples are fc32, source_impl converts them */
+  if ( "sc8" != type || _decimator.decimation() > 1 )
+    return "fc32" == type;
+
+  _sc8 = true;
+  set_output_signature( gr::io_signature::make(MIN_OUT, MAX_OUT, item_type_to_size(type)) );
+
+  return true;
+}
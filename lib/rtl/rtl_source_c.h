@@ -22,14 +22,26 @@
 #ifndef INCLUDED_RTLSDR_SOURCE_C_H
 #define INCLUDED_RTLSDR_SOURCE_C_H
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
 #include <gnuradio/sync_block.h>
 
 #include <gnuradio/thread/thread.h>
 
-#include <mutex>
-#include <condition_variable>
-
+#include "buffer_pool.h"
+#include "halfband_decimator.h"
+#include "latency_stats.h"
+#include "stream_counters.h"
+#include "level_meter.h"
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "stream_tagger.h"
+#include "snapshot_timer.h"
+#include "stream_watchdog.h"
+#include "thread_sched.h"
 
 class rtl_source_c;
 typedef struct rtlsdr_dev rtlsdr_dev_t;
@@ -113,6 +125,10 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  bool set_output_type( const std::string &type );
+
 protected:
   bool start();
   bool stop();
@@ -122,27 +138,79 @@ private:
   void rtlsdr_callback(unsigned char *buf, uint32_t len);
   static void _rtlsdr_wait(rtl_source_c *obj);
   void rtlsdr_wait();
-
-  std::vector<float> _lut;
+  void rtlsdr_read_loop();
+  void apply_latency();
+  unsigned int latency_len();
+  int work_decimated( int noutput_items, gr_complex *out );
+  double get_device_rate();
+  size_t settle_samples( size_t nsamples );
+  bool restart_stream();
+  void stream_ended();
+  bool read_snapshot();
 
   rtlsdr_dev_t *_dev;
+  std::shared_ptr< rtlsdr_dev_t > _handle;  // owns _dev, from the device pool
   gr::thread::thread _thread;
-  unsigned char **_buf;
+  thread_sched_t _sched;
+  spsc_ring<unsigned char> _ring;
+  unsigned char *_buf_drop;
+  buffer_opts_t _buf_opts;
   unsigned int _buf_num;
-  unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  std::mutex _buf_mutex;
-  std::condition_variable _buf_cond;
+  std::atomic<unsigned int> _buf_len;   // changed by the reader with latency=
+  unsigned int _min_buffers;
+  double _latency;
   bool _running;
-
-  unsigned int _buf_offset;
-  int _samp_avail;
+  bool _zero_copy;
+  stream_counters _stats;
+  latency_stats _latency_stats;
+  level_meter _level;
+  bool _sc8;
+  halfband_decimator _decimator;
+  stream_tagger _tagger;
+  std::vector<gr::tag_t> _tags;
+
+  bool _fast_retune;
+  size_t _settle;
+  size_t _settle_left;
+  std::atomic<bool> _retune;
+  std::atomic<double> _retune_freq;
+  std::atomic<size_t> _flush_mark;
+
+  /* a rate change while streaming, applied by the reader like a retune */
+  std::atomic<bool> _rerate;
+  std::atomic<double> _rerate_rate;
+  std::atomic<bool> _resize;            // the transfers get sized for the new rate
 
   bool _no_tuner;
   bool _auto_gain;
   double _if_gain;
   unsigned int _skipped;
+
+  /* watchdog=, the device is reopened by it while the reader is gone */
+  std::recursive_mutex _dev_mutex;
+  stream_watchdog _watchdog;
+  double _watchdog_timeout;
+  std::atomic<bool> _restarting;
+  double _linger;                       // linger=, handed to the device pool
+  std::string _pool_key;
+  unsigned int _dev_index;
+  std::string _serial;
+  int _bias_tee;
+
+  /* snapshot=, the timer thread streams the windows */
+  snapshot_timer _snapshot;
+
+  struct resume_t
+  {
+    uint32_t rate;
+    uint32_t freq;
+    uint32_t rtl_xtal;
+    uint32_t tuner_xtal;
+    int ppm;
+    int gain;
+    int direct_samp;
+    int offset_tune;
+  } _resume;
 };
 
 #endif /* INCLUDED_RTLSDR_SOURCE_C_H */
@@ -0,0 +1,63 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef RTL_TCP_EXT_H
+#define RTL_TCP_EXT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Extension of the rtl_tcp protocol between rtl_tcp_source_c and
+ * rtl_tcp_server_c, so the server decimates and sends a payload format
+ * other than the 8 bit unsigned IQ of rtl_tcp.
+ *
+ * Right after the dongle_info header the client sends RTL_TCP_EXT_CMD,
+ * with the format in the upper and the decimation in the lower 16 bits of
+ * the parameter, before any other command. A server that knows it holds
+ * the samples back until the first command or RTL_TCP_EXT_WAIT_MS, and
+ * answers RTL_TCP_EXT_CMD with an rtl_tcp_ext_reply_t telling what it will
+ * send, which is the plain stream if it can't do what was asked. rtl_tcp
+ * itself ignores unknown commands and just streams, so the client goes on
+ * with the full rate if the reply isn't the first thing it gets.
+ */
+
+#define RTL_TCP_EXT_CMD       0x80
+#define RTL_TCP_EXT_MAGIC     "OSX0"
+#define RTL_TCP_EXT_WAIT_MS   100
+
+enum rtl_tcp_ext_format_t {
+  RTL_TCP_EXT_U8 = 0,     // unsigned 8 bit, as rtl_tcp
+  RTL_TCP_EXT_CS16 = 1,   // signed 16 bit little endian, full scale 32767
+  RTL_TCP_EXT_CS8 = 2,    // signed 8 bit, full scale 127
+};
+
+typedef struct { /* the same size as dongle_info_t */
+  char magic[4];
+  uint32_t format;
+  uint32_t decimation;
+} rtl_tcp_ext_reply_t;
+
+/* bytes of one I/Q pair */
+inline size_t rtl_tcp_ext_sample_size( uint32_t format )
+{
+  return RTL_TCP_EXT_CS16 == format ? 4 : 2;
+}
+
+#endif // RTL_TCP_EXT_H
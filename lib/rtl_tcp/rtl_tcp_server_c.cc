@@ -0,0 +1,621 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "rtl_tcp_server_c.h"
+#include "rtl_tcp_ext.h"
+#include "arg_helpers.h"
+#include "sample_convert.h"
+
+#if defined(_WIN32)
+#pragma comment(lib, "ws2_32.lib")
+#define USING_WINSOCK
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define SHUT_RDWR 2
+#else
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define BYTES_PER_SAMPLE  2 // rtl_tcp clients expect 8 bit unsigned IQ data
+
+#define RING_SIZE         (8 * 1024 * 1024) // ~1.7s at 2.4 Msps
+#define SEND_CHUNK        (64 * 1024)
+#define POLL_TIMEOUT_MS   10  // also the latency of newly written samples
+#define MAX_CLIENTS       16
+
+#define RTLSDR_TUNER_R820T 5  // makes clients offer the full gain range
+
+/* copied from rtl sdr code */
+typedef struct { /* structure size must be multiple of 2 bytes */
+  char magic[4];
+  uint32_t tuner_type;
+  uint32_t tuner_gain_count;
+} dongle_info_t;
+
+static void close_socket( int sock )
+{
+  if (sock == -1)
+    return;
+
+  shutdown(sock, SHUT_RDWR);
+#if defined(USING_WINSOCK)
+  closesocket(sock);
+#else
+  ::close(sock);
+#endif
+}
+
+static bool would_block()
+{
+#if defined(USING_WINSOCK)
+  int werr = WSAGetLastError();
+  return werr == WSAEWOULDBLOCK || werr == WSAEINTR;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+static void set_nonblocking( int sock )
+{
+#if defined(USING_WINSOCK)
+  u_long mode = 1;
+  ioctlsocket(sock, FIONBIO, &mode);
+#else
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+rtl_tcp_server_c_sptr make_rtl_tcp_server_c( const std::string &args,
+                                             osmosdr::source *source,
+                                             size_t chan,
+                                             size_t itemsize )
+{
+  return gnuradio::get_initial_sptr(new rtl_tcp_server_c(args, source, chan, itemsize));
+}
+
+rtl_tcp_server_c::rtl_tcp_server_c( const std::string &args,
+                                    osmosdr::source *source,
+                                    size_t chan,
+                                    size_t itemsize ) :
+  gr::sync_block("rtl_tcp_server_c",
+                 gr::io_signature::make(1, 1, itemsize),
+                 gr::io_signature::make(0, 0, 0)),
+  _source(source),
+  _chan(chan),
+  _itemsize(itemsize),
+  _control(CONTROL_FIRST),
+  _listener(-1),
+  _running(false),
+  _written(0)
+{
+  std::string host = "127.0.0.1";
+  std::string port = "1234";
+  size_t ring_size = RING_SIZE;
+
+  dict_t dict = params_to_dict(args);
+
+  if (dict.count("serve")) {
+    std::vector< std::string > tokens;
+    boost::algorithm::split( tokens, dict["serve"], boost::is_any_of(":") );
+
+    if ( tokens.size() == 1 && tokens[0].length() ) {
+      port = tokens[0];
+    } else if ( tokens.size() == 2 ) {
+      if ( tokens[0].length() )
+        host = tokens[0];
+      if ( tokens[1].length() )
+        port = tokens[1];
+    }
+  }
+
+  if (dict.count("serve_ring"))
+    ring_size = boost::lexical_cast< size_t >( dict["serve_ring"] );
+
+  if (dict.count("control")) {
+    std::string control = dict["control"];
+
+    if ("first" == control)
+      _control = CONTROL_FIRST;
+    else if ("all" == control)
+      _control = CONTROL_ALL;
+    else if ("none" == control)
+      _control = CONTROL_NONE;
+    else
+      throw std::runtime_error("rtl_tcp server: control must be first, all or none");
+  }
+
+  if (_itemsize != sizeof(gr_complex) && _itemsize != 4 && _itemsize != 2)
+    throw std::runtime_error("rtl_tcp server: unsupported item size");
+
+  /* keep I/Q pairs from being split at the end of the ring */
+  ring_size -= ring_size % BYTES_PER_SAMPLE;
+  _ring.resize( std::max( ring_size, size_t(SEND_CHUNK) * 4 ) );
+
+#if defined(USING_WINSOCK)
+  WSADATA wsaData;
+  if ( WSAStartup( MAKEWORD(2,2), &wsaData ) != NO_ERROR )
+    throw std::runtime_error("rtl_tcp server: WSAStartup failed");
+#endif
+
+  struct addrinfo hints, *addr;
+  memset( &hints, 0, sizeof(hints) );
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  hints.ai_flags = AI_PASSIVE;
+
+  if ( getaddrinfo(host.c_str(), port.c_str(), &hints, &addr) != 0 )
+    throw std::runtime_error("rtl_tcp server: can't resolve " + host);
+
+  _listener = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+  if (_listener == -1) {
+    freeaddrinfo(addr);
+    throw std::runtime_error("rtl_tcp server: can't open socket");
+  }
+
+  int opt = 1;
+  setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&opt, sizeof(opt));
+
+  int ret = ::bind(_listener, addr->ai_addr, addr->ai_addrlen);
+  freeaddrinfo(addr);
+
+  if ( ret != 0 || listen(_listener, MAX_CLIENTS) != 0 ) {
+    close_socket(_listener);
+    throw std::runtime_error("rtl_tcp server: can't listen on " + host + ":" + port);
+  }
+
+  set_nonblocking(_listener);
+
+  std::cerr << "Serving rtl_tcp clients on " << host << ":" << port << std::endl;
+}
+
+rtl_tcp_server_c::~rtl_tcp_server_c()
+{
+  stop();
+
+  close_socket(_listener);
+
+#if defined(USING_WINSOCK)
+  WSACleanup();
+#endif
+}
+
+bool rtl_tcp_server_c::start()
+{
+  _running = true;
+  _thread = gr::thread::thread(_serve, this);
+
+  return true;
+}
+
+bool rtl_tcp_server_c::stop()
+{
+  _running = false;
+  if (_thread.joinable())
+    _thread.join();
+
+  close_clients();
+
+  return true;
+}
+
+void rtl_tcp_server_c::_serve(rtl_tcp_server_c *obj)
+{
+  obj->serve();
+}
+
+void rtl_tcp_server_c::serve()
+{
+  std::vector< struct pollfd > fds;
+
+  while (_running) {
+    const uint64_t written = _written.load( std::memory_order_acquire );
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    /* no command in time, a plain rtl_tcp client */
+    for (client_t &client : _clients) {
+      if (client.negotiating && now >= client.deadline) {
+        client.negotiating = false;
+        client.pos = written;
+      }
+    }
+
+    fds.resize( _clients.size() + 1 );
+
+    fds[0].fd = _listener;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+
+    size_t i = 1;
+    for (client_t &client : _clients) {
+      fds[i].fd = client.sock;
+      bool pending = client.pos != written || client.out_sent < client.out.size();
+      fds[i].events = POLLIN | (!client.negotiating && pending ? POLLOUT : 0);
+      fds[i].revents = 0;
+      i++;
+    }
+
+#if defined(USING_WINSOCK)
+    int ready = WSAPoll(&fds[0], fds.size(), POLL_TIMEOUT_MS);
+#else
+    int ready = poll(&fds[0], fds.size(), POLL_TIMEOUT_MS);
+#endif
+
+    if (ready <= 0)
+      continue;
+
+    i = 1;
+    for (std::list< client_t >::iterator it = _clients.begin(); it != _clients.end(); i++) {
+      const short revents = fds[i].revents;
+      bool control = CONTROL_ALL == _control ||
+                     (CONTROL_FIRST == _control && it == _clients.begin());
+      bool alive = true;
+
+      if (revents & (POLLIN | POLLHUP | POLLERR))
+        alive = recv_commands( *it, control );
+
+      if (alive && (revents & POLLOUT))
+        alive = send_samples( *it );
+
+      if (!alive) {
+        close_socket(it->sock);
+        it = _clients.erase(it);
+        std::cerr << "rtl_tcp client disconnected, " << _clients.size()
+                  << " remaining" << std::endl;
+      } else {
+        ++it;
+      }
+    }
+
+    if (fds[0].revents & POLLIN)
+      accept_client();
+  }
+}
+
+void rtl_tcp_server_c::accept_client()
+{
+  int sock = accept(_listener, NULL, NULL);
+  if (sock == -1)
+    return;
+
+  if (_clients.size() >= MAX_CLIENTS) {
+    close_socket(sock);
+    return;
+  }
+
+  /* the rtl_tcp clients use the gain count to size their gain tables */
+  uint32_t gain_count = 0;
+  try {
+    gain_count = _source->get_gain_range(_chan).values().size();
+  } catch (std::exception &) {
+  }
+
+  dongle_info_t info;
+  memcpy(info.magic, "RTL0", 4);
+  info.tuner_type = htonl(RTLSDR_TUNER_R820T);
+  info.tuner_gain_count = htonl(gain_count);
+
+  /* a fresh socket always takes the header */
+  if (send(sock, (const char *)&info, sizeof(info), MSG_NOSIGNAL) != sizeof(info)) {
+    close_socket(sock);
+    return;
+  }
+
+  set_nonblocking(sock);
+
+  client_t client;
+  client.sock = sock;
+  client.pos = _written.load( std::memory_order_acquire );
+  client.cmd_len = 0;
+  client.negotiating = true;
+  client.deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds( RTL_TCP_EXT_WAIT_MS );
+  client.format = RTL_TCP_EXT_U8;
+  client.out_sent = 0;
+
+  _clients.push_back(client);
+
+  std::cerr << "rtl_tcp client connected, " << _clients.size()
+            << " total" << std::endl;
+}
+
+/* read the commands sent by the client, returns false once it went away */
+bool rtl_tcp_server_c::recv_commands( client_t &client, bool control )
+{
+  while (true) {
+    int received = recv(client.sock, (char *)client.cmd + client.cmd_len,
+                        sizeof(client.cmd) - client.cmd_len, 0);
+
+    if (received == 0)
+      return false;
+
+    if (received < 0)
+      return would_block();
+
+    client.cmd_len += received;
+
+    if (client.cmd_len < sizeof(client.cmd))
+      continue;
+
+    client.cmd_len = 0;
+
+    uint32_t param;
+    memcpy(&param, client.cmd + 1, sizeof(param));
+
+    /* the stream starts with the first command, in the format it asks
+     * for if it is the extension */
+    if (client.negotiating) {
+      client.negotiating = false;
+      client.pos = _written.load( std::memory_order_acquire );
+
+      if (RTL_TCP_EXT_CMD == client.cmd[0]) {
+        if (!negotiate( client, ntohl(param) ))
+          return false;
+        continue;
+      }
+    }
+
+    /* commands from clients without control are dropped */
+    if (control)
+      apply_command( client.cmd[0], ntohl(param) );
+  }
+}
+
+/* set up what the extension command asks for and tell the client what
+ * it gets, returns false once it went away */
+bool rtl_tcp_server_c::negotiate( client_t &client, uint32_t param )
+{
+  uint32_t format = param >> 16;
+  uint32_t decim = param & 0xffff;
+
+  /* what the half-band cascade does, otherwise the plain stream */
+  if (format > RTL_TCP_EXT_CS8 || decim < 1 || decim > 16 || (decim & (decim - 1))) {
+    std::cerr << "rtl_tcp server: client asked for format " << format
+              << " with decimation " << decim << ", sending the plain stream"
+              << std::endl;
+    format = RTL_TCP_EXT_U8;
+    decim = 1;
+  }
+
+  if (format != RTL_TCP_EXT_U8 || decim != 1) {
+    client.format = format;
+    client.decim = std::make_shared< halfband_decimator >();
+    client.decim->set_decimation( decim );
+  }
+
+  rtl_tcp_ext_reply_t reply;
+  memcpy(reply.magic, RTL_TCP_EXT_MAGIC, 4);
+  reply.format = htonl(format);
+  reply.decimation = htonl(decim);
+
+  /* nothing else was sent since the header, this fits the socket buffer */
+  if (send(client.sock, (const char *)&reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply))
+    return false;
+
+  return true;
+}
+
+/* the producer never waits for us, skip ahead before it catches up,
+ * keeping the client on the same side of the I/Q pair */
+void rtl_tcp_server_c::skip_ahead( client_t &client, uint64_t written )
+{
+  if (written - client.pos > _ring.size() / 2) {
+    client.pos = written - (client.pos % BYTES_PER_SAMPLE);
+    std::cerr << "O" << std::flush;
+  }
+}
+
+/* decimate and convert the next chunk of the ring for a client of the
+ * extension, returns false when there is nothing new */
+bool rtl_tcp_server_c::convert_samples( client_t &client )
+{
+  const uint64_t written = _written.load( std::memory_order_acquire );
+
+  skip_ahead( client, written );
+
+  if (client.pos == written)
+    return false;
+
+  const size_t idx = client.pos % _ring.size();
+  const size_t len = std::min<uint64_t>( std::min<uint64_t>( written - client.pos,
+                                                             _ring.size() - idx ),
+                                         SEND_CHUNK );
+  const size_t nitems = len / BYTES_PER_SAMPLE;
+
+  _decimated.resize( nitems );
+  const size_t nout = client.decim->convert( &_ring[idx], nitems, &_decimated[0],
+      [](const uint8_t *in, gr_complex *out, size_t n) { convert_u8_fc32( in, out, n ); } );
+
+  client.out.resize( nout * rtl_tcp_ext_sample_size( client.format ) );
+  client.out_sent = 0;
+
+  if (RTL_TCP_EXT_CS16 == client.format) {
+    convert_fc32_sc16( &_decimated[0], (int16_t *)&client.out[0], nout );
+  } else {
+    convert_fc32_sc8( &_decimated[0], (int8_t *)&client.out[0], nout );
+    if (RTL_TCP_EXT_U8 == client.format)
+      for (size_t i = 0; i < client.out.size(); i++)
+        client.out[i] ^= 0x80;
+  }
+
+  client.pos += nitems * BYTES_PER_SAMPLE;
+
+  return true;
+}
+
+/* send what is ready for the client, returns false once it went away */
+bool rtl_tcp_server_c::send_samples( client_t &client )
+{
+  while (client.decim) {
+    if (client.out_sent == client.out.size()) {
+      if (!convert_samples( client ))
+        return true;
+      continue;
+    }
+
+    int sent = send(client.sock, (const char *)&client.out[client.out_sent],
+                    client.out.size() - client.out_sent, MSG_NOSIGNAL);
+
+    if (sent < 0)
+      return would_block();
+
+    client.out_sent += sent;
+
+    if (client.out_sent < client.out.size())
+      return true;
+  }
+
+  while (true) {
+    const uint64_t written = _written.load( std::memory_order_acquire );
+
+    skip_ahead( client, written );
+
+    if (client.pos == written)
+      break;
+
+    const size_t idx = client.pos % _ring.size();
+    const size_t len = std::min<uint64_t>( std::min<uint64_t>( written - client.pos,
+                                                               _ring.size() - idx ),
+                                           SEND_CHUNK );
+
+    int sent = send(client.sock, (const char *)&_ring[idx], len, MSG_NOSIGNAL);
+
+    if (sent < 0)
+      return would_block();
+
+    client.pos += sent;
+
+    if (size_t(sent) < len)
+      break;
+  }
+
+  return true;
+}
+
+void rtl_tcp_server_c::apply_command( unsigned char cmd, uint32_t param )
+{
+  try {
+    switch (cmd) {
+    case 0x01: // set frequency
+      _source->set_center_freq( param, _chan );
+      break;
+    case 0x02: // set sample rate
+      _source->set_sample_rate( param );
+      break;
+    case 0x03: // set gain mode, 1 is manual
+      _source->set_gain_mode( !param, _chan );
+      break;
+    case 0x04: // set gain in tenths of dB
+      _source->set_gain( int32_t(param) / 10.0, _chan );
+      break;
+    case 0x05: // set frequency correction in ppm
+      _source->set_freq_corr( int32_t(param), _chan );
+      break;
+    case 0x06: // set if gain, stage in the upper 16 bits
+      _source->set_if_gain( int16_t(param & 0xffff) / 10.0, _chan );
+      break;
+    case 0x0d: // set gain by index
+    {
+      std::vector< double > gains = _source->get_gain_range(_chan).values();
+      if (param < gains.size())
+        _source->set_gain( gains[param], _chan );
+      break;
+    }
+    default:
+      /* agc, direct sampling, offset tuning, xtal and bias tee are fixed by
+       * the device arguments */
+      break;
+    }
+  } catch (std::exception &ex) {
+    std::cerr << "rtl_tcp server: command 0x" << std::hex << int(cmd) << std::dec
+              << " failed: " << ex.what() << std::endl;
+  }
+}
+
+void rtl_tcp_server_c::close_clients()
+{
+  for (client_t &client : _clients)
+    close_socket(client.sock);
+
+  _clients.clear();
+}
+
+int rtl_tcp_server_c::work( int noutput_items,
+                            gr_vector_const_void_star &input_items,
+                            gr_vector_void_star &output_items )
+{
+  const char *in = (const char *)input_items[0];
+  uint64_t written = _written.load( std::memory_order_relaxed );
+
+  /* limit the amount per call, so a client being sent from the back of
+   * the ring never sees its bytes being overwritten */
+  const int nitems = std::min<size_t>( noutput_items, _ring.size() / 4 / BYTES_PER_SAMPLE );
+  int consumed = 0;
+
+  while (consumed < nitems) {
+    const size_t idx = written % _ring.size();
+    const size_t n = std::min<size_t>( nitems - consumed,
+                                       (_ring.size() - idx) / BYTES_PER_SAMPLE );
+    unsigned char *out = &_ring[idx];
+
+    /* quantize once for all clients, the sign flip yields offset binary */
+    if (_itemsize == sizeof(gr_complex)) {
+      convert_fc32_sc8( (const gr_complex *)in, (int8_t *)out, n );
+      for (size_t i = 0; i < n * BYTES_PER_SAMPLE; i++)
+        out[i] ^= 0x80;
+    } else if (_itemsize == 4) {
+      const int16_t *sc16 = (const int16_t *)in;
+      for (size_t i = 0; i < n * BYTES_PER_SAMPLE; i++)
+        out[i] = (uint8_t)(sc16[i] >> 8) ^ 0x80;
+    } else {
+      const uint8_t *sc8 = (const uint8_t *)in;
+      for (size_t i = 0; i < n * BYTES_PER_SAMPLE; i++)
+        out[i] = sc8[i] ^ 0x80;
+    }
+
+    in += n * _itemsize;
+    consumed += n;
+    written += n * BYTES_PER_SAMPLE;
+  }
+
+  _written.store( written, std::memory_order_release );
+
+  return consumed;
+}
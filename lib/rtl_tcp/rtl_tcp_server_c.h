@@ -0,0 +1,139 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef RTL_TCP_SERVER_C_H
+#define RTL_TCP_SERVER_C_H
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include <osmosdr/source.h>
+
+#include "halfband_decimator.h"
+
+class rtl_tcp_server_c;
+
+typedef std::shared_ptr< rtl_tcp_server_c > rtl_tcp_server_c_sptr;
+
+/*!
+ * \param args device arguments, serve=[host:]port selects the address
+ * \param source the source the client commands are applied to
+ * \param chan the channel of \p source the input is connected to
+ * \param itemsize size of the input items: fc32, sc16 or sc8
+ */
+rtl_tcp_server_c_sptr make_rtl_tcp_server_c( const std::string &args,
+                                             osmosdr::source *source,
+                                             size_t chan,
+                                             size_t itemsize );
+
+/*!
+ * Serves one channel of an osmosdr source to any number of rtl_tcp clients.
+ *
+ * work() quantizes the samples once into the unsigned 8 bit format of
+ * rtl_tcp and writes them to a shared ring. Every client has its own read
+ * cursor into that ring, so the same bytes are sent to all of them. The
+ * flowgraph is never held up by a client: one that falls behind by more
+ * than half the ring is moved forward to the newest samples.
+ *
+ * Clients that negotiate the extension of rtl_tcp_ext.h get the samples
+ * decimated and in the payload format they asked for instead. That is
+ * done per client on the server thread, from the same ring.
+ *
+ * Client commands are applied to the source, serialized by the server
+ * thread. With control=first only the longest connected client may change
+ * the settings, control=all accepts everyone, control=none nobody.
+ */
+class rtl_tcp_server_c : public gr::sync_block
+{
+private:
+  friend rtl_tcp_server_c_sptr make_rtl_tcp_server_c( const std::string &args,
+                                                      osmosdr::source *source,
+                                                      size_t chan,
+                                                      size_t itemsize );
+
+  rtl_tcp_server_c( const std::string &args, osmosdr::source *source,
+                    size_t chan, size_t itemsize );
+
+public:
+  ~rtl_tcp_server_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  enum control_t { CONTROL_NONE, CONTROL_FIRST, CONTROL_ALL };
+
+  struct client_t
+  {
+    int sock;
+    uint64_t pos;             // next ring byte to send
+    unsigned char cmd[5];     // partially received command
+    size_t cmd_len;
+
+    /* until the first command, which may ask for the extension */
+    bool negotiating;
+    std::chrono::steady_clock::time_point deadline;
+
+    /* only set up for the extension, the plain stream is sent from the
+     * ring as it is */
+    uint32_t format;
+    std::shared_ptr< halfband_decimator > decim;
+    std::vector< unsigned char > out;   // converted, from out_sent on unsent
+    size_t out_sent;
+  };
+
+  static void _serve(rtl_tcp_server_c *obj);
+  void serve();
+  void accept_client();
+  bool recv_commands( client_t &client, bool control );
+  bool negotiate( client_t &client, uint32_t param );
+  bool send_samples( client_t &client );
+  bool convert_samples( client_t &client );
+  void skip_ahead( client_t &client, uint64_t written );
+  void apply_command( unsigned char cmd, uint32_t param );
+  void close_clients();
+
+  osmosdr::source *_source;
+  size_t _chan;
+  size_t _itemsize;
+  control_t _control;
+
+  int _listener;
+  std::list< client_t > _clients;   // in order of connection
+
+  gr::thread::thread _thread;
+  std::atomic<bool> _running;
+
+  std::vector< unsigned char > _ring;
+  std::atomic<uint64_t> _written;   // free running byte count
+
+  std::vector< gr_complex > _decimated;   // of one client, by the server thread
+};
+
+#endif // RTL_TCP_SERVER_C_H
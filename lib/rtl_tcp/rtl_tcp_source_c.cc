@@ -28,7 +28,9 @@
 #include <gnuradio/io_signature.h>
 
 #include "rtl_tcp_source_c.h"
+#include "rtl_tcp_ext.h"
 #include "arg_helpers.h"
+#include "sample_convert.h"
 
 #if defined(_WIN32)
 // if not posix, assume winsock
@@ -45,6 +47,9 @@ typedef char* optval_t;
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
 typedef void* optval_t;
 #endif
 
@@ -59,7 +64,12 @@ typedef ptrdiff_t ssize_t;
 #include <WinSock2.h>
 #endif
 
-#define BYTES_PER_SAMPLE  2 // rtl_tcp device delivers 8 bit unsigned IQ data
+#define MAX_SAMPLE_SIZE   4 // the largest I/Q pair, cs16 of the extension
+
+#define RING_SIZE         (8 * 1024 * 1024) // ~1.7s at 2.4 Msps
+#define POLL_TIMEOUT_MS   100 // how often the reader checks for stop()
+#define EXT_TIMEOUT_MS    1000 // for the first bytes after the extension command
+#define CONNECT_TIMEOUT_MS 3000 // for the connection and the dongle info
 
 /* copied from rtl sdr code */
 typedef struct { /* structure size must be multiple of 2 bytes */
@@ -94,12 +104,15 @@ static int is_error( int perr )
   int werr = WSAGetLastError();
   switch( werr ) {
   case WSAETIMEDOUT:
+  case WSAEWOULDBLOCK:
     return( perr == EAGAIN );
+  case WSAEINTR:
+    return( perr == EINTR );
   case WSAENOPROTOOPT:
     return( perr == ENOPROTOOPT );
   default:
-    fprintf(stderr,"rtl_tcp_source_c: unknown error %d WS err %d \n", perr, werr );
-    throw std::runtime_error("internal error");
+    /* the reader thread can't throw, treat it as a lost connection */
+    return 0;
   }
   return 0;
 #else
@@ -121,6 +134,57 @@ static void report_error( const char *msg1, const char *msg2 )
   return;
 }
 
+/* connect() that gives up after timeout_ms, a host that has gone away
+ * would otherwise hold the caller for the system's TCP retry time */
+static int connect_timeout( int sock, const struct sockaddr *addr,
+                            socklen_t addrlen, int timeout_ms )
+{
+#if defined(USING_WINSOCK)
+  u_long nonblock = 1;
+  ioctlsocket(sock, FIONBIO, &nonblock);
+#else
+  int flags = fcntl(sock, F_GETFL, 0);
+  fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+#endif
+
+  int ret = ::connect(sock, addr, addrlen);
+
+#if defined(USING_WINSOCK)
+  bool pending = ( ret != 0 && is_error(EAGAIN) );
+#else
+  bool pending = ( ret != 0 && errno == EINPROGRESS );
+#endif
+
+  if (pending) {
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+
+#if defined(USING_WINSOCK)
+    int ready = WSAPoll(&pfd, 1, timeout_ms);
+#else
+    int ready = poll(&pfd, 1, timeout_ms);
+#endif
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (ready > 0 &&
+        getsockopt(sock, SOL_SOCKET, SO_ERROR, (optval_t)&err, &len) == 0 &&
+        err == 0)
+      ret = 0;
+  }
+
+#if defined(USING_WINSOCK)
+  nonblock = 0;
+  ioctlsocket(sock, FIONBIO, &nonblock);
+#else
+  fcntl(sock, F_SETFL, flags);
+#endif
+
+  return ret;
+}
+
 using namespace boost::assign;
 
 const char * rtl_tcp_source_c::get_tuner_name(void)
@@ -148,13 +212,25 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   d_socket(-1),
   _no_tuner(false),
   _auto_gain(false),
-  _if_gain(0)
+  _if_gain(0),
+  d_running(false),
+  d_batching(false),
+  d_host("127.0.0.1"),
+  d_port(1234),
+  d_rcvbuf(0),
+  d_direct_samp(0),
+  d_offset_tune(0),
+  d_bias_tee(0),
+  d_timeout(0),
+  d_reconnect(false),
+  d_want_format(RTL_TCP_EXT_U8),
+  d_want_decim(1),
+  d_format(RTL_TCP_EXT_U8),
+  d_decim(1),
+  d_sample_size(2)
 {
-  std::string host = "127.0.0.1";
-  unsigned short port = 1234;
   int payload_size = 16384;
-  unsigned int direct_samp = 0, offset_tune = 0;
-  int bias_tee = 0;
+  size_t ring_size = RING_SIZE;
 
   _freq = 0;
   _rate = 0;
@@ -163,38 +239,83 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
 
   dict_t dict = params_to_dict(args);
 
+  d_ring.set_buffer_opts(buffer_opts_from_dict(dict));
+  d_sched = thread_sched_from_dict(dict);
+
   if (dict.count("rtl_tcp")) {
     std::vector< std::string > tokens;
     boost::algorithm::split( tokens, dict["rtl_tcp"], boost::is_any_of(":") );
 
     if ( tokens[0].length() && (tokens.size() == 1 || tokens.size() == 2 ) )
-      host = tokens[0];
+      d_host = tokens[0];
 
     if ( tokens.size() == 2 ) // port given
-      port = boost::lexical_cast< unsigned short >( tokens[1] );
+      d_port = boost::lexical_cast< unsigned short >( tokens[1] );
   }
 
   if (dict.count("psize"))
     payload_size = boost::lexical_cast< int >( dict["psize"] );
 
+  /* kernel socket buffer, gives slack on top of the ring */
+  if (dict.count("rcvbuf"))
+    d_rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
+  if (dict.count("ring_size"))
+    ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
   if (dict.count("direct_samp"))
-    direct_samp = boost::lexical_cast< unsigned int >( dict["direct_samp"] );
+    d_direct_samp = boost::lexical_cast< unsigned int >( dict["direct_samp"] );
 
   if (dict.count("offset_tune"))
-    offset_tune = boost::lexical_cast< unsigned int >( dict["offset_tune"] );
+    d_offset_tune = boost::lexical_cast< unsigned int >( dict["offset_tune"] );
 
   if (dict.count("bias"))
-    bias_tee = boost::lexical_cast<bool>( dict["bias"] );
+    d_bias_tee = boost::lexical_cast<bool>( dict["bias"] );
+
+  /* seconds without data before the connection is considered dead */
+  if (dict.count("timeout"))
+    d_timeout = boost::lexical_cast< double >( dict["timeout"] );
+
+  /* connect again instead of ending the stream */
+  if (dict.count("reconnect"))
+    d_reconnect = boost::lexical_cast< bool >( dict["reconnect"] );
+
+  /* decimated on the server side, only an osmosdr server does that */
+  if (dict.count("decim"))
+    d_want_decim = boost::lexical_cast< size_t >( dict["decim"] );
+
+  if (dict.count("payload")) {
+    std::string payload = dict["payload"];
+
+    if ("u8" == payload)
+      d_want_format = RTL_TCP_EXT_U8;
+    else if ("cs16" == payload)
+      d_want_format = RTL_TCP_EXT_CS16;
+    else if ("cs8" == payload)
+      d_want_format = RTL_TCP_EXT_CS8;
+    else
+      throw std::runtime_error("rtl_tcp: payload must be u8, cs16 or cs8");
+  }
 
-  if (!host.length())
-    host = "127.0.0.1";
+  if (d_want_decim < 1 || d_want_decim > 16 || (d_want_decim & (d_want_decim - 1)))
+    throw std::runtime_error("rtl_tcp: decim must be 1, 2, 4, 8 or 16");
 
-  if (0 == port)
-    port = 1234;
+  if (!d_host.length())
+    d_host = "127.0.0.1";
+
+  if (0 == d_port)
+    d_port = 1234;
 
   if (payload_size <= 0)
     payload_size = 16384;
 
+  /* keep I/Q pairs from being split at the end of the ring */
+  ring_size -= ring_size % MAX_SAMPLE_SIZE;
+  ring_size = std::max( ring_size, size_t(payload_size) * 2 );
+
+  d_payload_size = payload_size;
+  d_ring.resize( ring_size );
+
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // initialize winsock DLL
   WSADATA wsaData;
@@ -204,6 +325,29 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   }
 #endif
 
+  connect_server();
+
+  if (d_tuner_type != RTLSDR_TUNER_UNKNOWN) {
+    std::cerr << "The RTL TCP server reports a "
+              << get_tuner_name()
+              << " tuner with "
+              << d_tuner_gain_count << " RF and "
+              << d_tuner_if_gain_count << " IF gains."
+              << std::endl;
+  }
+
+  set_gain_mode(false); /* enable manual gain mode by default */
+
+  if (d_direct_samp)
+    _no_tuner = true;
+}
+
+/* open the connection and send the settings given with the device args.
+ * With keep_format the payload format negotiated before has to come out
+ * again, work() may still be taking samples of it out of the ring; a
+ * server that agrees to another one is hung up on and false returned. */
+bool rtl_tcp_source_c::connect_server( bool keep_format )
+{
   // Set up the address stucture for the source address and port numbers
   // Get the source IP address from the host name
   struct addrinfo *ip_src;      // store the source IP address to use
@@ -214,62 +358,63 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   hints.ai_protocol = IPPROTO_TCP;
   hints.ai_flags = AI_PASSIVE;
   char port_str[12];
-  sprintf( port_str, "%d", port );
+  sprintf( port_str, "%d", d_port );
 
   // FIXME leaks if report_error throws below
-  int ret = getaddrinfo(host.c_str(), port_str, &hints, &ip_src);
+  int ret = getaddrinfo(d_host.c_str(), port_str, &hints, &ip_src);
   if (ret != 0)
     report_error("rtl_tcp_source_c/getaddrinfo",
                  "can't initialize source socket" );
 
-  d_temp_buff = new unsigned char[payload_size];   // allow it to hold up to payload_size bytes
-  d_LUT = new float[0x100];
-  for (int i = 0; i < 0x100; ++i)
-    d_LUT[i] = (((float)(i & 0xff)) - 127.4f) * (1.0f / 128.0f);
-
   // create socket
-  d_socket = socket(ip_src->ai_family, ip_src->ai_socktype,
+  int sock = socket(ip_src->ai_family, ip_src->ai_socktype,
                     ip_src->ai_protocol);
-  if (d_socket == -1)
+  if (sock == -1)
     report_error("socket open","can't open socket");
 
   // Turn on reuse address
   int opt_val = 1;
-  if (setsockopt(d_socket, SOL_SOCKET, SO_REUSEADDR, (optval_t)&opt_val, sizeof(int)) == -1)
+  if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (optval_t)&opt_val, sizeof(int)) == -1)
     report_error("SO_REUSEADDR","can't set socket option SO_REUSEADDR");
 
   // Don't wait when shutting down
   linger lngr;
   lngr.l_onoff  = 1;
   lngr.l_linger = 0;
-  if (setsockopt(d_socket, SOL_SOCKET, SO_LINGER, (optval_t)&lngr, sizeof(linger)) == -1)
+  if (setsockopt(sock, SOL_SOCKET, SO_LINGER, (optval_t)&lngr, sizeof(linger)) == -1)
     if (!is_error(ENOPROTOOPT)) // no SO_LINGER for SOCK_DGRAM on Windows
       report_error("SO_LINGER","can't set socket option SO_LINGER");
 
-#if USE_RCV_TIMEO
-  // Set a timeout on the receive function to not block indefinitely
-  // This value can (and probably should) be changed
-  // Ignored on Cygwin
-#if defined(USING_WINSOCK)
-  DWORD timeout = 1000;  // milliseconds
-#else
-  timeval timeout;
-  timeout.tv_sec = 1;
-  timeout.tv_usec = 0;
-#endif
-  if (setsockopt(d_socket, SOL_SOCKET, SO_RCVTIMEO, (optval_t)&timeout, sizeof(timeout)) == -1)
-    report_error("SO_RCVTIMEO","can't set socket option SO_RCVTIMEO");
-#endif // USE_RCV_TIMEO
+  // Must be set before connecting for the TCP window to scale with it
+  if (d_rcvbuf > 0)
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (optval_t)&d_rcvbuf, sizeof(d_rcvbuf)) == -1)
+      report_error("SO_RCVBUF","can't set socket option SO_RCVBUF");
 
-  if (::connect(d_socket, ip_src->ai_addr, ip_src->ai_addrlen) != 0)
+  if (connect_timeout(sock, ip_src->ai_addr, ip_src->ai_addrlen, CONNECT_TIMEOUT_MS) != 0) {
+    freeaddrinfo(ip_src);
+    close_socket(sock);
     report_error("rtl_tcp_source_c/connect","can't open TCP connection");
+  }
   freeaddrinfo(ip_src);
 
   int flag = 1;
-  setsockopt(d_socket, IPPROTO_TCP, TCP_NODELAY, (char *)&flag,sizeof(flag));
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&flag,sizeof(flag));
+
+  // Don't wait forever for a server that accepts but never talks. The
+  // reader only calls recv() once poll() said so, it isn't affected.
+#if defined(USING_WINSOCK)
+  DWORD rcvtimeo = CONNECT_TIMEOUT_MS;
+#else
+  struct timeval rcvtimeo;
+  rcvtimeo.tv_sec = CONNECT_TIMEOUT_MS / 1000;
+  rcvtimeo.tv_usec = (CONNECT_TIMEOUT_MS % 1000) * 1000;
+#endif
+  if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (optval_t)&rcvtimeo, sizeof(rcvtimeo)) == -1)
+    report_error("SO_RCVTIMEO","can't set socket option SO_RCVTIMEO");
 
   dongle_info_t dongle_info;
-  ret = recv(d_socket, (char*)&dongle_info, sizeof(dongle_info), 0);
+  memset(&dongle_info, 0, sizeof(dongle_info));
+  ret = recv(sock, (char*)&dongle_info, sizeof(dongle_info), 0);
   if (sizeof(dongle_info) != ret)
     fprintf(stderr,"failed to read dongle info\n");
 
@@ -284,49 +429,174 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
       d_tuner_if_gain_count = 53;
   }
 
-  if (d_tuner_type != RTLSDR_TUNER_UNKNOWN) {
-    std::cerr << "The RTL TCP server reports a "
-              << get_tuner_name()
-              << " tuner with "
-              << d_tuner_gain_count << " RF and "
-              << d_tuner_if_gain_count << " IF gains."
-              << std::endl;
-  }
+  uint32_t format = RTL_TCP_EXT_U8;
+  size_t decim = 1;
 
-  set_gain_mode(false); /* enable manual gain mode by default */
+  if (d_want_format != RTL_TCP_EXT_U8 || d_want_decim != 1)
+    negotiate( sock, format, decim );
 
-  // set direct sampling
-  struct command cmd;
+  /* work() reads these without a lock, only the first connection sets them */
+  if (!keep_format) {
+    d_format = format;
+    d_decim = decim;
+    d_sample_size = rtl_tcp_ext_sample_size( d_format );
+  } else if (format != d_format || decim != d_decim) {
+    close_socket(sock);
+    return false;
+  }
 
-  cmd = { 0x09, htonl(direct_samp) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
-  if (direct_samp)
-    _no_tuner = true;
+  {
+    gr::thread::scoped_lock lock(d_socket_mutex);
+    d_socket = sock;
+  }
 
-  // set offset tuning
-  cmd = { 0x0a, htonl(offset_tune) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command( 0x09, d_direct_samp ); // set direct sampling
+  send_command( 0x0a, d_offset_tune ); // set offset tuning
+  send_command( 0x0e, d_bias_tee );    // set bias tee
 
-  // set bias tee
-  cmd = { 0x0e, htonl(bias_tee) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  return true;
 }
 
-rtl_tcp_source_c::~rtl_tcp_source_c()
+/* ask for the extension of rtl_tcp_ext.h, it has to be the first
+ * command. A plain rtl_tcp server streams right away instead of
+ * answering, the bytes read in its place are dropped then. */
+void rtl_tcp_source_c::negotiate( int sock, uint32_t &format, size_t &decim )
 {
-  delete [] d_LUT;
-  delete [] d_temp_buff;
+  struct command c = { RTL_TCP_EXT_CMD, htonl(d_want_format << 16 | uint32_t(d_want_decim)) };
+  if (send(sock, (const char*)&c, sizeof(c), 0) != sizeof(c))
+    return;
+
+  rtl_tcp_ext_reply_t reply;
+  size_t got = 0;
+
+  while (got < sizeof(reply)) {
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
 
-  if (d_socket != -1) {
-    shutdown(d_socket, SHUT_RDWR);
 #if defined(USING_WINSOCK)
-    closesocket(d_socket);
+    int ready = WSAPoll(&pfd, 1, EXT_TIMEOUT_MS);
 #else
-    ::close(d_socket);
+    int ready = poll(&pfd, 1, EXT_TIMEOUT_MS);
 #endif
+    if (ready <= 0)
+      break;
+
+    ssize_t received = recv(sock, (char*)&reply + got, sizeof(reply) - got, 0);
+    if (received <= 0)
+      break;
+
+    got += received;
+  }
+
+  if (got == sizeof(reply) && memcmp(reply.magic, RTL_TCP_EXT_MAGIC, 4) == 0) {
+    format = ntohl(reply.format);
+    decim = ntohl(reply.decimation);
+  }
+
+  if (format != d_want_format || decim != d_want_decim)
+    std::cerr << "The rtl_tcp server doesn't decimate or convert, "
+              << "receiving the full rate as u8." << std::endl;
+  else
+    std::cerr << "The rtl_tcp server decimates by " << decim << "." << std::endl;
+}
+
+/* try to get the stream back after the server went away, gives up on stop() */
+bool rtl_tcp_source_c::reconnect()
+{
+  {
+    gr::thread::scoped_lock lock(d_socket_mutex);
+    close_socket(d_socket);
     d_socket = -1;
   }
 
+  /* a second between the attempts, cut short by stop() */
+  auto backoff = [this]() {
+    for (int ms = 0; ms < 1000 && d_running; ms += POLL_TIMEOUT_MS)
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(POLL_TIMEOUT_MS));
+  };
+
+  while (d_running) {
+    /* the ring holds the old format, a server that now sends another one
+     * can't continue the stream */
+    try {
+      if (!connect_server( true )) {
+        fprintf(stderr, "rtl_tcp server came back with another payload format\n");
+        backoff();
+        continue;
+      }
+    } catch ( std::exception &ex ) {
+      backoff();
+      continue;
+    }
+
+    /* the new server session starts out with its defaults */
+    begin_batch();
+    if (_rate > 0)
+      set_sample_rate( _rate );
+    if (_freq > 0)
+      set_center_freq( _freq );
+    set_freq_corr( _corr );
+    set_gain_mode( _auto_gain );
+    if (!_auto_gain)
+      set_gain( _gain );
+    if (_if_gain > 0)
+      set_if_gain( _if_gain );
+    send_batch();
+
+    std::cerr << "Reconnected to rtl_tcp server." << std::endl;
+    return true;
+  }
+
+  return false;
+}
+
+void rtl_tcp_source_c::close_socket( int sock )
+{
+  if (sock == -1)
+    return;
+
+  shutdown(sock, SHUT_RDWR);
+#if defined(USING_WINSOCK)
+  closesocket(sock);
+#else
+  ::close(sock);
+#endif
+}
+
+void rtl_tcp_source_c::send_command( unsigned char cmd, uint32_t param )
+{
+  struct command c = { cmd, htonl(param) };
+
+  gr::thread::scoped_lock lock(d_socket_mutex);
+  if (d_batching)
+    d_batch.insert(d_batch.end(), (const char*)&c, (const char*)&c + sizeof(c));
+  else if (d_socket != -1)
+    send(d_socket, (const char*)&c, sizeof(c), 0);
+}
+
+/* collect the commands until send_batch(), to send them in one write */
+void rtl_tcp_source_c::begin_batch()
+{
+  gr::thread::scoped_lock lock(d_socket_mutex);
+  d_batching = true;
+}
+
+void rtl_tcp_source_c::send_batch()
+{
+  gr::thread::scoped_lock lock(d_socket_mutex);
+  if (d_socket != -1 && d_batch.size())
+    send(d_socket, &d_batch[0], d_batch.size(), 0);
+  d_batch.clear();
+  d_batching = false;
+}
+
+rtl_tcp_source_c::~rtl_tcp_source_c()
+{
+  close_socket(d_socket);
+  d_socket = -1;
+
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // free winsock resources
   WSACleanup();
@@ -334,29 +604,158 @@ rtl_tcp_source_c::~rtl_tcp_source_c()
 }
 
 
+bool rtl_tcp_source_c::start()
+{
+  d_ring.reset();
+  d_running = true;
+  d_thread = gr::thread::thread(_tcp_reader, this);
+
+  return true;
+}
+
+bool rtl_tcp_source_c::stop()
+{
+  d_running = false;
+  if (d_thread.joinable())
+    d_thread.join();
+
+  return true;
+}
+
+void rtl_tcp_source_c::_tcp_reader(rtl_tcp_source_c *obj)
+{
+  obj->tcp_reader();
+}
+
+/* wait up to timeout_ms for the socket to become readable */
+int rtl_tcp_source_c::poll_socket( int timeout_ms )
+{
+  struct pollfd pfd;
+  pfd.fd = d_socket;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+#if defined(USING_WINSOCK)
+  return WSAPoll(&pfd, 1, timeout_ms);
+#else
+  return poll(&pfd, 1, timeout_ms);
+#endif
+}
+
+/* read whatever the socket has into the ring, so a late work() call
+ * doesn't hold up the TCP stream */
+void rtl_tcp_source_c::tcp_reader()
+{
+  thread_sched_apply(d_sched);
+
+  bool full = false;
+  double idle = 0;
+
+  while (d_running) {
+    size_t len;
+    unsigned char *buf = d_ring.write_ptr(len);
+
+    if (!len) {
+      /* ring is full, leave the rest to the kernel buffer and let TCP
+       * flow control slow down the server */
+      if (!full)
+        d_stats.overruns++;
+      full = true;
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+      continue;
+    }
+
+    full = false;
+
+    int ready = poll_socket( POLL_TIMEOUT_MS );
+
+    if (ready == 0) {
+      idle += POLL_TIMEOUT_MS / 1e3;
+      if (d_timeout <= 0 || idle < d_timeout)
+        continue;
+
+      fprintf(stderr, "rtl_tcp: no data for %g s\n", idle);
+    } else if (ready > 0) {
+      ssize_t received = recv(d_socket, (char*)buf, len, 0);
+
+      if (received > 0) {
+        d_ring.commit(received);
+        idle = 0;
+        continue;
+      }
+
+      /* spurious wakeup, nothing was read */
+      if (received == -1 && (is_error(EAGAIN) || is_error(EINTR)))
+        continue;
+
+      if (received == 0)
+        fprintf(stderr, "rtl_tcp server closed the connection\n");
+      else
+        report_error("rtl_tcp_source_c/recv", NULL);
+    } else {
+      if (is_error(EINTR))
+        continue;
+
+      report_error("rtl_tcp_source_c/poll", NULL);
+    }
+
+    if (!d_reconnect || !reconnect())
+      break;
+
+    idle = 0;
+    d_stats.overruns++;
+
+    /* a partial sample would swap I and Q from here on, a full ring is
+     * waited out unless stop() comes first */
+    unsigned char pad[MAX_SAMPLE_SIZE];
+    memset(pad, RTL_TCP_EXT_U8 == d_format ? 127 : 0, sizeof(pad));
+    while (d_running && d_ring.write_count() % d_sample_size) {
+      const size_t missing = d_sample_size - d_ring.write_count() % d_sample_size;
+      if (!d_ring.push(pad, missing))
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+    }
+  }
+
+  d_running = false;
+  d_ring.close();
+}
+
 int rtl_tcp_source_c::work(int noutput_items,
 			   gr_vector_const_void_star &input_items,
 			   gr_vector_void_star &output_items)
 {
   gr_complex *out = (gr_complex *)output_items[0];
-  int bytesleft = noutput_items * BYTES_PER_SAMPLE;
-  int index = 0;
-  int receivedbytes = 0;
-  while (bytesleft > 0) {
-    receivedbytes = recv(d_socket, (char*)&d_temp_buff[index], bytesleft, 0);
-
-    if (receivedbytes == -1 && !is_error(EAGAIN)) {
-      fprintf(stderr, "socket error\n");
-      return -1;
-    }
-    bytesleft -= receivedbytes;
-    index += receivedbytes;
+  int produced = 0;
+
+  size_t min_fill = std::min( size_t(noutput_items) * d_sample_size, d_payload_size );
+  min_fill = std::max( min_fill, d_sample_size );
+
+  if (!d_ring.wait( min_fill ) && d_ring.size() < d_sample_size)
+    return WORK_DONE;
+
+  while (produced < noutput_items) {
+    size_t len;
+    const unsigned char *buf = d_ring.read_ptr( len );
+    const int nout = std::min<size_t>(noutput_items - produced, len / d_sample_size);
+
+    if (!nout)
+      break;
+
+    if (RTL_TCP_EXT_CS16 == d_format)
+      convert_s16_fc32( (const int16_t *)buf, out, nout, 1.0f / CONVERT_SC16_SCALE );
+    else if (RTL_TCP_EXT_CS8 == d_format)
+      convert_s8_fc32( (const int8_t *)buf, out, nout );
+    else
+      convert_u8_fc32( buf, out, nout );
+    out += nout;
+
+    produced += nout;
+    d_ring.consume( nout * d_sample_size );
   }
 
-  for (int i = 0; i < noutput_items; i++)
-    out[i] = gr_complex(d_LUT[d_temp_buff[i * 2]], d_LUT[d_temp_buff[i * 2 + 1]]);
+  d_stats.samples += produced;
 
-  return noutput_items;
+  return produced;
 }
 
 std::string rtl_tcp_source_c::name()
@@ -401,13 +800,21 @@ osmosdr::meta_range_t rtl_tcp_source_c::get_sample_rates( void )
 //  range += osmosdr::range_t( 3000000 ); // may work
 //  range += osmosdr::range_t( 3200000 ); // max rate
 
-  return range;
+  if (d_decim == 1)
+    return range;
+
+  /* what comes out of the server side decimation */
+  osmosdr::meta_range_t decimated;
+  for (const osmosdr::range_t &r : range)
+    decimated += osmosdr::range_t( r.start() / d_decim );
+
+  return decimated;
 }
 
 double rtl_tcp_source_c::set_sample_rate( double rate )
 {
-  struct command cmd = { 0x02, htonl(rate) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  /* the dongle runs at the rate before the decimation */
+  send_command( 0x02, rate * d_decim );
 
   _rate = rate;
 
@@ -455,8 +862,7 @@ osmosdr::freq_range_t rtl_tcp_source_c::get_freq_range( size_t chan )
 
 double rtl_tcp_source_c::set_center_freq( double freq, size_t chan )
 {
-  struct command cmd = { 0x01, htonl(freq) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command( 0x01, freq );
 
   _freq = freq;
 
@@ -470,8 +876,7 @@ double rtl_tcp_source_c::get_center_freq( size_t chan )
 
 double rtl_tcp_source_c::set_freq_corr( double ppm, size_t chan )
 {
-  struct command cmd = { 0x05, htonl(ppm) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command( 0x05, ppm );
 
   _corr = ppm;
 
@@ -563,12 +968,10 @@ osmosdr::gain_range_t rtl_tcp_source_c::get_gain_range( const std::string & name
 bool rtl_tcp_source_c::set_gain_mode( bool automatic, size_t chan )
 {
   // gain mode
-  struct command cmd = { 0x03, htonl(!automatic) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command( 0x03, !automatic );
 
   // AGC mode
-  cmd = { 0x08, htonl(automatic) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command( 0x08, automatic );
 
   _auto_gain = automatic;
 
@@ -584,8 +987,7 @@ double rtl_tcp_source_c::set_gain( double gain, size_t chan )
 {
   osmosdr::gain_range_t gains = rtl_tcp_source_c::get_gain_range( chan );
 
-  struct command cmd = { 0x04, htonl(int(gains.clip(gain) * 10.0)) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command( 0x04, int(gains.clip(gain) * 10.0) );
 
   _gain = gain;
 
@@ -671,14 +1073,39 @@ double rtl_tcp_source_c::set_if_gain(double gain, size_t chan)
   for (unsigned int stage = 1; stage <= gains.size(); stage++) {
     int gain_i = int(gains[stage] * 10.0);
     uint32_t params = stage << 16 | (gain_i & 0xffff);
-    struct command cmd = { 0x06, htonl(params) };
-    send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+    send_command( 0x06, params );
   }
 
   _if_gain = gain;
   return gain;
 }
 
+/* every command is a round trip through the network and the server, the
+ * ones of a configuration go out in one write and retuning to the same
+ * frequency doesn't relock the PLL */
+void rtl_tcp_source_c::set_config( const osmosdr::device_t &config, size_t chan )
+{
+  osmosdr::device_t changed = config;
+
+  if ( changed.count("rate") && changed.cast< double >( "rate", 0 ) == _rate )
+    changed.erase("rate");
+  if ( changed.count("freq") && changed.cast< double >( "freq", 0 ) == _freq )
+    changed.erase("freq");
+  if ( changed.count("freq_corr") && changed.cast< double >( "freq_corr", 0 ) == _corr )
+    changed.erase("freq_corr");
+
+  begin_batch();
+
+  try {
+    source_iface::set_config( changed, chan );
+  } catch ( ... ) {
+    send_batch();
+    throw;
+  }
+
+  send_batch();
+}
+
 std::vector< std::string > rtl_tcp_source_c::get_antennas( size_t chan )
 {
   std::vector< std::string > antennas;
@@ -697,3 +1124,14 @@ std::string rtl_tcp_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t rtl_tcp_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = d_stats;
+
+  stats.fill = d_ring.size() / d_sample_size;
+  stats.fill_max = d_ring.fill_max() / d_sample_size;
+  stats.capacity = d_ring.capacity() / d_sample_size;
+
+  return stats;
+}
@@ -20,9 +20,14 @@
 #ifndef RTL_TCP_SOURCE_C_H
 #define RTL_TCP_SOURCE_C_H
 
+#include <atomic>
+
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
 
 class rtl_tcp_source_c;
 
@@ -54,6 +59,9 @@ private:
 public:
   ~rtl_tcp_source_c();
 
+  bool start();
+  bool stop();
+
   int work(int noutput_items,
 	   gr_vector_const_void_star &input_items,
 	   gr_vector_void_star &output_items);
@@ -90,7 +98,22 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  void set_config( const osmosdr::device_t &config, size_t chan = 0 );
+
 private:
+  static void _tcp_reader(rtl_tcp_source_c *obj);
+  void tcp_reader();
+  int poll_socket( int timeout_ms );
+  bool connect_server( bool keep_format = false );
+  void negotiate( int sock, uint32_t &format, size_t &decim );
+  bool reconnect();
+  static void close_socket( int sock );
+  void send_command( unsigned char cmd, uint32_t param );
+  void begin_batch();
+  void send_batch();
+
   int d_socket;		  // handle to socket
   double _freq, _rate, _gain, _corr;
   bool _no_tuner;
@@ -100,8 +123,33 @@ private:
   enum rtlsdr_tuner d_tuner_type;
   unsigned int d_tuner_gain_count;
   unsigned int d_tuner_if_gain_count;
-  unsigned char *d_temp_buff; // hold buffer between calls
-  float *d_LUT;
+
+  gr::thread::thread d_thread;  // fills the ring from the socket
+  thread_sched_t d_sched;
+  spsc_ring<unsigned char> d_ring;
+  size_t d_payload_size;        // bytes buffered before work() returns
+  std::atomic<bool> d_running;
+  osmosdr::stream_stats_t d_stats;
+
+  gr::thread::mutex d_socket_mutex; // d_socket may change on reconnect
+  bool d_batching;              // send_command() appends to d_batch
+  std::vector<char> d_batch;
+  std::string d_host;
+  unsigned short d_port;
+  int d_rcvbuf;
+  unsigned int d_direct_samp;
+  unsigned int d_offset_tune;
+  int d_bias_tee;
+  double d_timeout;             // stall timeout in seconds, 0 waits forever
+  bool d_reconnect;
+
+  /* asked for with payload= and decim=, and what the server agreed to,
+   * see rtl_tcp_ext.h */
+  uint32_t d_want_format;
+  size_t d_want_decim;
+  uint32_t d_format;
+  size_t d_decim;
+  size_t d_sample_size;         // bytes per I/Q pair in d_format
 };
 
 #endif // RTL_TCP_SOURCE_C_H
@@ -22,6 +22,7 @@
 
 
 #include <rtl_tcp_source_f.h>
+#include "sample_convert.h"
 #include <gnuradio/io_signature.h>
 #include <stdexcept>
 #include <errno.h>
@@ -43,6 +44,9 @@ typedef struct { /* structure size must be multiple of 2 bytes */
 
 #define USE_SELECT    1  // non-blocking receive on all platforms
 #define USE_RCV_TIMEO 0  // non-blocking receive on all but Cygwin
+
+#define RING_SIZE       (8 * 1024 * 1024)
+#define RECV_TIMEOUT_MS 100 // how often the reader checks for stop()
 #define SRC_VERBOSE 0
 #define SNK_VERBOSE 0
 
@@ -87,7 +91,9 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
                                    unsigned short port,
                                    int payload_size,
                                    bool eof,
-                                   bool wait)
+                                   bool wait,
+                                   int rcvbuf,
+                                   size_t ring_size)
   : gr::sync_block ("rtl_tcp_source_f",
                    gr::io_signature::make(0, 0, 0),
                    gr::io_signature::make(1, 1, sizeof(float))),
@@ -96,9 +102,13 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
     d_eof(eof),
     d_wait(wait),
     d_socket(-1),
-    d_temp_offset(0)
+    d_running(false)
 {
   int ret = 0;
+
+  if (0 == ring_size)
+    ring_size = RING_SIZE;
+  d_ring.resize( std::max( ring_size, size_t(d_payload_size) * 2 ) );
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // initialize winsock DLL
   WSADATA wsaData;
@@ -126,12 +136,6 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
     report_error("rtl_tcp_source_f/getaddrinfo",
                  "can't initialize source socket" );
 
-  // FIXME leaks if report_error throws below
-  d_temp_buff = new unsigned char[d_payload_size];   // allow it to hold up to payload_size bytes
-  d_LUT= new float[0xff+1];
-  for(int i=0; i <=(0xff);++i){
-    d_LUT[i] = (((float)(i&0xff))-127.4f)*(1.0f/128.0f);
-  }
   // create socket
   d_socket = socket(ip_src->ai_family, ip_src->ai_socktype,
                     ip_src->ai_protocol);
@@ -171,6 +175,13 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
   }
 #endif // USE_RCV_TIMEO
 
+  // Must be set before connecting for the TCP window to scale with it
+  if(rcvbuf > 0) {
+    if(setsockopt(d_socket, SOL_SOCKET, SO_RCVBUF, (optval_t)&rcvbuf, sizeof(rcvbuf)) == -1) {
+      report_error("SO_RCVBUF","can't set socket option SO_RCVBUF");
+    }
+  }
+
   while(connect(d_socket, ip_src->ai_addr, ip_src->ai_addrlen) != 0);
   freeaddrinfo(ip_src);
 
@@ -193,6 +204,18 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
     if ( RTLSDR_TUNER_E4000 == d_tuner_type )
       d_tuner_if_gain_count = 53;
   }
+
+  // From now on the reader thread must not block forever in recv()
+#if defined(USING_WINSOCK)
+  DWORD recv_timeout = RECV_TIMEOUT_MS;
+#else
+  timeval recv_timeout;
+  recv_timeout.tv_sec = 0;
+  recv_timeout.tv_usec = RECV_TIMEOUT_MS * 1000;
+#endif
+  if(setsockopt(d_socket, SOL_SOCKET, SO_RCVTIMEO, (optval_t)&recv_timeout, sizeof(recv_timeout)) == -1) {
+    report_error("SO_RCVTIMEO","can't set socket option SO_RCVTIMEO");
+  }
 }
 
 rtl_tcp_source_f_sptr make_rtl_tcp_source_f (size_t itemsize,
@@ -200,7 +223,9 @@ rtl_tcp_source_f_sptr make_rtl_tcp_source_f (size_t itemsize,
                                              unsigned short port,
                                              int payload_size,
                                              bool eof,
-                                             bool wait)
+                                             bool wait,
+                                             int rcvbuf,
+                                             size_t ring_size)
 {
   return gnuradio::get_initial_sptr(new rtl_tcp_source_f (
                                       itemsize,
@@ -208,13 +233,13 @@ rtl_tcp_source_f_sptr make_rtl_tcp_source_f (size_t itemsize,
                                       port,
                                       payload_size,
                                       eof,
-                                      wait));
+                                      wait,
+                                      rcvbuf,
+                                      ring_size));
 }
 
 rtl_tcp_source_f::~rtl_tcp_source_f ()
 {
-  delete [] d_temp_buff;
-
   if (d_socket != -1){
     shutdown(d_socket, SHUT_RDWR);
 #if defined(USING_WINSOCK)
@@ -231,32 +256,87 @@ rtl_tcp_source_f::~rtl_tcp_source_f ()
 #endif
 }
 
+bool rtl_tcp_source_f::start()
+{
+  d_ring.reset();
+  d_running = true;
+  d_thread = gr::thread::thread(_tcp_reader, this);
+
+  return true;
+}
+
+bool rtl_tcp_source_f::stop()
+{
+  d_running = false;
+  if (d_thread.joinable())
+    d_thread.join();
+
+  return true;
+}
+
+void rtl_tcp_source_f::_tcp_reader(rtl_tcp_source_f *obj)
+{
+  obj->tcp_reader();
+}
+
+void rtl_tcp_source_f::tcp_reader()
+{
+  while(d_running) {
+    size_t len;
+    unsigned char *buf = d_ring.write_ptr(len);
+
+    if(!len) {
+      // ring is full, leave the rest to the kernel buffer
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+      continue;
+    }
+
+    ssize_t received = recv(d_socket, (char*)buf, len, 0);
+
+    if(received > 0) {
+      d_ring.commit(received);
+      continue;
+    }
+
+    if(received == -1 && is_error(EAGAIN))
+      continue;
+
+    fprintf(stderr, "socket error\n");
+    break;
+  }
+
+  d_running = false;
+  d_ring.close();
+}
+
 int rtl_tcp_source_f::work (int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items)
 {
   float *out = (float *) output_items[0];
-  ssize_t r = 0;
+  int produced = 0;
 
-  int bytesleft = noutput_items;
-  int index = 0;
-  int receivedbytes = 0;
-  while(bytesleft > 0) {
-    receivedbytes = recv(d_socket, (char*)&d_temp_buff[index], bytesleft, 0);
+  size_t min_fill = std::min( size_t(noutput_items), size_t(d_payload_size) );
 
-    if(receivedbytes == -1 && !is_error(EAGAIN)){
-      fprintf(stderr, "socket error\n");
-      return -1;
-    }
-    bytesleft -= receivedbytes;
-    index += receivedbytes;
-  }
-  r = noutput_items;
+  if(!d_ring.wait( std::max( min_fill, size_t(1) ) ) && !d_ring.size())
+    return WORK_DONE;
+
+  while(produced < noutput_items) {
+    size_t len;
+    const unsigned char *buf = d_ring.read_ptr( len );
+    const int nout = std::min<size_t>(noutput_items - produced, len);
+
+    if(!nout)
+      break;
 
-  for(int i=0; i<r; ++i)
-    out[i]=d_LUT[*(d_temp_buff+d_temp_offset+i)];
+    convert_get_kernels().u8_f32(buf, out, nout);
+    out += nout;
+
+    produced += nout;
+    d_ring.consume( nout );
+  }
 
-  return r;
+  return produced;
 }
 
 #ifdef _WIN32
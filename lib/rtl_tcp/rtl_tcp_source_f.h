@@ -24,6 +24,10 @@
 #include <gnuradio/sync_block.h>
 #include <gnuradio/thread/thread.h>
 
+#include <atomic>
+
+#include "spsc_ring.h"
+
 #if defined(_WIN32)
 // if not posix, assume winsock
 #pragma comment(lib, "ws2_32.lib")
@@ -67,7 +71,9 @@ rtl_tcp_source_f_sptr make_rtl_tcp_source_f (
     unsigned short port,
     int payload_size,
     bool eof = false,
-    bool wait = false);
+    bool wait = false,
+    int rcvbuf = 0,
+    size_t ring_size = 0);
 
 class rtl_tcp_source_f : public gr::sync_block
 {
@@ -77,9 +83,10 @@ private:
   bool          d_eof;           // zero-length packet is EOF
   bool          d_wait;          // wait if data if not immediately available
   int           d_socket;        // handle to socket
-  unsigned char *d_temp_buff;    // hold buffer between calls
-  size_t        d_temp_offset;   // point to temp buffer location offset
-  float         *d_LUT;
+
+  gr::thread::thread d_thread;   // fills the ring from the socket
+  spsc_ring<unsigned char> d_ring;
+  std::atomic<bool> d_running;
 
   unsigned int d_tuner_type;
   unsigned int d_tuner_gain_count;
@@ -87,7 +94,11 @@ private:
 
 private:
   rtl_tcp_source_f(size_t itemsize, const char *host,
-                   unsigned short port, int payload_size, bool eof, bool wait);
+                   unsigned short port, int payload_size, bool eof, bool wait,
+                   int rcvbuf, size_t ring_size);
+
+  static void _tcp_reader(rtl_tcp_source_f *obj);
+  void tcp_reader();
 
   // The friend declaration allows make_source_c to
   // access the private constructor.
@@ -97,7 +108,9 @@ private:
       unsigned short port,
       int payload_size,
       bool eof,
-      bool wait);
+      bool wait,
+      int rcvbuf,
+      size_t ring_size);
 
 public:
   ~rtl_tcp_source_f();
@@ -106,6 +119,9 @@ public:
   unsigned int get_tuner_gain_count() { return d_tuner_gain_count; }
   unsigned int get_tuner_if_gain_count() { return d_tuner_if_gain_count; }
 
+  bool start();
+  bool stop();
+
   int work(int noutput_items,
            gr_vector_const_void_star &input_items,
            gr_vector_void_star &output_items);
@@ -0,0 +1,1607 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure.  It contains the results
+ * of probing for features, options etc.  It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "sample_convert.h"
+
+/*
+ * On x86 with gcc/clang every kernel is compiled for its own instruction set
+ * through target attributes and the best one is picked at runtime, so the
+ * library keeps working when built on a newer machine than it runs on.
+ * Other compilers get the best kernel the build flags allow.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CONVERT_X86_DISPATCH 1
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#elif defined(USE_SSE2) || defined(USE_AVX) || defined(_M_X64)
+#define CONVERT_X86_STATIC 1
+#include <immintrin.h>
+#define TARGET(isa)
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define U8_OFFSET  127.4f
+#define S8_SCALE   (1.0f/128.0f)
+
+#define S16_MAX    32767.0f
+#define S8_MAX     127.0f
+
+/*
+ * Generic kernels, also used for the tail of every SIMD kernel.
+ */
+
+static void u8_f32_generic( const uint8_t *in, float *out, size_t nvalues )
+{
+  for (size_t i = 0; i < nvalues; i++)
+    out[i] = (float(in[i]) - U8_OFFSET) * S8_SCALE;
+}
+
+static void s8_f32_generic( const int8_t *in, float *out, size_t nvalues )
+{
+  for (size_t i = 0; i < nvalues; i++)
+    out[i] = float(in[i]) * S8_SCALE;
+}
+
+static void s16_f32_generic( const int16_t *in, float *out, size_t nvalues, float scale )
+{
+  for (size_t i = 0; i < nvalues; i++)
+    out[i] = float(in[i]) * scale;
+}
+
+static void f32_s16_generic( const float *in, int16_t *out, size_t nvalues, float scale )
+{
+  for (size_t i = 0; i < nvalues; i++)
+    out[i] = int16_t( lrintf( std::max( -S16_MAX - 1, std::min( S16_MAX, in[i] * scale ) ) ) );
+}
+
+static void f32_s8_generic( const float *in, int8_t *out, size_t nvalues, float scale )
+{
+  for (size_t i = 0; i < nvalues; i++)
+    out[i] = int8_t( lrintf( std::max( -S8_MAX - 1, std::min( S8_MAX, in[i] * scale ) ) ) );
+}
+
+static void u8_s8_generic( const uint8_t *in, int8_t *out, size_t nvalues )
+{
+  for (size_t i = 0; i < nvalues; i++)
+    out[i] = int8_t( in[i] ^ 0x80 );
+}
+
+static void s16_f32_deint_generic( const int16_t *in, float *const *out, size_t nchan,
+                                   size_t nitems, float scale )
+{
+  for (size_t i = 0; i < nitems; i++) {
+    for (size_t n = 0; n < nchan; n++, in += 2) {
+      out[n][2 * i + 0] = float(in[0]) * scale;
+      out[n][2 * i + 1] = float(in[1]) * scale;
+    }
+  }
+}
+
+/* the SIMD kernels only know about 2 channels, the tail goes here */
+static void s16_f32_deint2_tail( const int16_t *in, float *const *out, size_t done,
+                                 size_t nitems, float scale )
+{
+  float *rest[2] = { out[0] + 2 * done, out[1] + 2 * done };
+
+  s16_f32_deint_generic( in + 4 * done, rest, 2, nitems - done, scale );
+}
+
+static inline int32_t s24_value( const uint8_t *in )
+{
+  return int32_t( uint32_t(in[0]) << 8 | uint32_t(in[1]) << 16 | uint32_t(in[2]) << 24 ) >> 8;
+}
+
+static void s24_f32_deint_generic( const uint8_t *in, float *const *out, size_t nchan,
+                                   size_t nitems, float scale )
+{
+  for (size_t i = 0; i < nitems; i++) {
+    for (size_t n = 0; n < nchan; n++, in += 6) {
+      out[n][2 * i + 0] = float(s24_value( in + 0 )) * scale;
+      out[n][2 * i + 1] = float(s24_value( in + 3 )) * scale;
+    }
+  }
+}
+
+static void s16_f32_split_generic( const int16_t *in_i, const int16_t *in_q, float *out,
+                                   size_t nitems, float scale )
+{
+  for (size_t i = 0; i < nitems; i++) {
+    out[2 * i + 0] = float(in_i[i]) * scale;
+    out[2 * i + 1] = float(in_q[i]) * scale;
+  }
+}
+
+static void f32_s16_intl_generic( const float *const *in, int16_t *out, size_t nchan,
+                                  size_t nitems, float scale )
+{
+  for (size_t i = 0; i < nitems; i++) {
+    for (size_t n = 0; n < nchan; n++, out += 2)
+      f32_s16_generic( in[n] + 2 * i, out, 2, scale );
+  }
+}
+
+/* the SIMD kernels only know about 2 channels, the tail goes here */
+static void f32_s16_intl2_tail( const float *const *in, int16_t *out, size_t done,
+                                size_t nitems, float scale )
+{
+  const float *rest[2] = { in[0] + 2 * done, in[1] + 2 * done };
+
+  f32_s16_intl_generic( rest, out + 4 * done, 2, nitems - done, scale );
+}
+
+static inline void level_add( convert_level_t *level, double power, size_t nvalues,
+                              uint64_t clipped )
+{
+  level->power += power;
+  level->values += nvalues;
+  level->clipped += clipped;
+}
+
+static void u8_f32_lvl_generic( const uint8_t *in, float *out, size_t nvalues,
+                                convert_level_t *level )
+{
+  float power = 0;
+  uint64_t clipped = 0;
+
+  for (size_t i = 0; i < nvalues; i++) {
+    out[i] = (float(in[i]) - U8_OFFSET) * S8_SCALE;
+    power += out[i] * out[i];
+    clipped += (0x00 == in[i]) | (0xff == in[i]);
+  }
+
+  level_add( level, power, nvalues, clipped );
+}
+
+static void s8_f32_lvl_generic( const int8_t *in, float *out, size_t nvalues,
+                                convert_level_t *level )
+{
+  float power = 0;
+  uint64_t clipped = 0;
+
+  for (size_t i = 0; i < nvalues; i++) {
+    out[i] = float(in[i]) * S8_SCALE;
+    power += out[i] * out[i];
+    clipped += (-128 == in[i]) | (127 == in[i]);
+  }
+
+  level_add( level, power, nvalues, clipped );
+}
+
+static void s16_f32_lvl_generic( const int16_t *in, float *out, size_t nvalues, float scale,
+                                 int16_t clip, convert_level_t *level )
+{
+  float power = 0;
+  uint64_t clipped = 0;
+
+  for (size_t i = 0; i < nvalues; i++) {
+    out[i] = float(in[i]) * scale;
+    power += out[i] * out[i];
+    clipped += (in[i] >= clip) | (in[i] <= -clip);
+  }
+
+  level_add( level, power, nvalues, clipped );
+}
+
+static void s16_f32_deint_lvl_generic( const int16_t *in, float *const *out, size_t nchan,
+                                       size_t nitems, float scale, int16_t clip,
+                                       convert_level_t *level )
+{
+  for (size_t n = 0; n < nchan; n++) {
+    float power = 0;
+    uint64_t clipped = 0;
+    const int16_t *p = in + 2 * n;
+
+    for (size_t i = 0; i < nitems; i++, p += 2 * nchan) {
+      const float a = float(p[0]) * scale;
+      const float b = float(p[1]) * scale;
+
+      out[n][2 * i + 0] = a;
+      out[n][2 * i + 1] = b;
+      power += a * a + b * b;
+      clipped += (p[0] >= clip) | (p[0] <= -clip);
+      clipped += (p[1] >= clip) | (p[1] <= -clip);
+    }
+
+    level_add( &level[n], power, 2 * nitems, clipped );
+  }
+}
+
+static void s16_f32_split_lvl_generic( const int16_t *in_i, const int16_t *in_q, float *out,
+                                       size_t nitems, float scale, int16_t clip,
+                                       convert_level_t *level )
+{
+  float power = 0;
+  uint64_t clipped = 0;
+
+  for (size_t i = 0; i < nitems; i++) {
+    const float a = float(in_i[i]) * scale;
+    const float b = float(in_q[i]) * scale;
+
+    out[2 * i + 0] = a;
+    out[2 * i + 1] = b;
+    power += a * a + b * b;
+    clipped += (in_i[i] >= clip) | (in_i[i] <= -clip);
+    clipped += (in_q[i] >= clip) | (in_q[i] <= -clip);
+  }
+
+  level_add( level, power, 2 * nitems, clipped );
+}
+
+static const convert_kernels_t generic_kernels = {
+  "generic",
+  u8_f32_generic,
+  s8_f32_generic,
+  s16_f32_generic,
+  f32_s16_generic,
+  f32_s8_generic,
+  u8_s8_generic,
+  s16_f32_deint_generic,
+  s24_f32_deint_generic,
+  s16_f32_split_generic,
+  f32_s16_intl_generic,
+  u8_f32_lvl_generic,
+  s8_f32_lvl_generic,
+  s16_f32_lvl_generic,
+  s16_f32_deint_lvl_generic,
+  s16_f32_split_lvl_generic
+};
+
+#if defined(CONVERT_X86_DISPATCH) || defined(CONVERT_X86_STATIC)
+
+/*
+ * SSE2 kernels, 16 values per iteration
+ */
+
+TARGET("sse2")
+static void u8_f32_sse2( const uint8_t *in, float *out, size_t nvalues )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 offset = _mm_set1_ps( U8_OFFSET );
+  const __m128 scale = _mm_set1_ps( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+    __m128i lo = _mm_unpacklo_epi8( v, zero );
+    __m128i hi = _mm_unpackhi_epi8( v, zero );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) );
+    __m128 f2 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) );
+    __m128 f3 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) );
+
+    _mm_storeu_ps( out + i +  0, _mm_mul_ps( _mm_sub_ps( f0, offset ), scale ) );
+    _mm_storeu_ps( out + i +  4, _mm_mul_ps( _mm_sub_ps( f1, offset ), scale ) );
+    _mm_storeu_ps( out + i +  8, _mm_mul_ps( _mm_sub_ps( f2, offset ), scale ) );
+    _mm_storeu_ps( out + i + 12, _mm_mul_ps( _mm_sub_ps( f3, offset ), scale ) );
+  }
+
+  u8_f32_generic( in + i, out + i, nvalues - i );
+}
+
+TARGET("sse2")
+static void s8_f32_sse2( const int8_t *in, float *out, size_t nvalues )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+    /* sign extend by moving the byte to the top of the lane and shifting back */
+    __m128i lo = _mm_srai_epi16( _mm_unpacklo_epi8( zero, v ), 8 );
+    __m128i hi = _mm_srai_epi16( _mm_unpackhi_epi8( zero, v ), 8 );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, lo ), 16 ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, lo ), 16 ) );
+    __m128 f2 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, hi ), 16 ) );
+    __m128 f3 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, hi ), 16 ) );
+
+    _mm_storeu_ps( out + i +  0, _mm_mul_ps( f0, scale ) );
+    _mm_storeu_ps( out + i +  4, _mm_mul_ps( f1, scale ) );
+    _mm_storeu_ps( out + i +  8, _mm_mul_ps( f2, scale ) );
+    _mm_storeu_ps( out + i + 12, _mm_mul_ps( f3, scale ) );
+  }
+
+  s8_f32_generic( in + i, out + i, nvalues - i );
+}
+
+TARGET("sse2")
+static void s16_f32_sse2( const int16_t *in, float *out, size_t nvalues, float scale )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 mul = _mm_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, v ), 16 ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, v ), 16 ) );
+
+    _mm_storeu_ps( out + i + 0, _mm_mul_ps( f0, mul ) );
+    _mm_storeu_ps( out + i + 4, _mm_mul_ps( f1, mul ) );
+  }
+
+  s16_f32_generic( in + i, out + i, nvalues - i, scale );
+}
+
+/* out of range values are clamped before the conversion, cvtps would
+ * return 0x80000000 for them which saturates to the wrong end */
+TARGET("sse2")
+static void f32_s16_sse2( const float *in, int16_t *out, size_t nvalues, float scale )
+{
+  const __m128 mul = _mm_set1_ps( scale );
+  const __m128 max = _mm_set1_ps( S16_MAX );
+  const __m128 min = _mm_set1_ps( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    __m128 f0 = _mm_mul_ps( _mm_loadu_ps( in + i + 0 ), mul );
+    __m128 f1 = _mm_mul_ps( _mm_loadu_ps( in + i + 4 ), mul );
+
+    __m128i i0 = _mm_cvtps_epi32( _mm_max_ps( _mm_min_ps( f0, max ), min ) );
+    __m128i i1 = _mm_cvtps_epi32( _mm_max_ps( _mm_min_ps( f1, max ), min ) );
+
+    _mm_storeu_si128( (__m128i *)(out + i), _mm_packs_epi32( i0, i1 ) );
+  }
+
+  f32_s16_generic( in + i, out + i, nvalues - i, scale );
+}
+
+TARGET("sse2")
+static void f32_s8_sse2( const float *in, int8_t *out, size_t nvalues, float scale )
+{
+  const __m128 mul = _mm_set1_ps( scale );
+  const __m128 max = _mm_set1_ps( S8_MAX );
+  const __m128 min = _mm_set1_ps( -S8_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v[4];
+
+    for (int j = 0; j < 4; j++) {
+      __m128 f = _mm_mul_ps( _mm_loadu_ps( in + i + j * 4 ), mul );
+      v[j] = _mm_cvtps_epi32( _mm_max_ps( _mm_min_ps( f, max ), min ) );
+    }
+
+    __m128i lo = _mm_packs_epi32( v[0], v[1] );
+    __m128i hi = _mm_packs_epi32( v[2], v[3] );
+
+    _mm_storeu_si128( (__m128i *)(out + i), _mm_packs_epi16( lo, hi ) );
+  }
+
+  f32_s8_generic( in + i, out + i, nvalues - i, scale );
+}
+
+TARGET("sse2")
+static void u8_s8_sse2( const uint8_t *in, int8_t *out, size_t nvalues )
+{
+  const __m128i sign = _mm_set1_epi8( (char)0x80 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+    _mm_storeu_si128( (__m128i *)(out + i), _mm_xor_si128( v, sign ) );
+  }
+
+  u8_s8_generic( in + i, out + i, nvalues - i );
+}
+
+/* every complex sample is one 32 bit lane, sort them by channel first */
+TARGET("sse2")
+static void s16_f32_deint_sse2( const int16_t *in, float *const *out, size_t nchan,
+                                size_t nitems, float scale )
+{
+  if (nchan != 2) {
+    s16_f32_deint_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 mul = _mm_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 2 <= nitems; i += 2) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + 4 * i) );
+    v = _mm_shuffle_epi32( v, _MM_SHUFFLE(3, 1, 2, 0) );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, v ), 16 ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, v ), 16 ) );
+
+    _mm_storeu_ps( out[0] + 2 * i, _mm_mul_ps( f0, mul ) );
+    _mm_storeu_ps( out[1] + 2 * i, _mm_mul_ps( f1, mul ) );
+  }
+
+  s16_f32_deint2_tail( in, out, i, nitems, scale );
+}
+
+/* interleave I and Q as int16 first, then widen like s16_f32 */
+TARGET("sse2")
+static void s16_f32_split_sse2( const int16_t *in_i, const int16_t *in_q, float *out,
+                                size_t nitems, float scale )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 mul = _mm_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 8 <= nitems; i += 8) {
+    __m128i vi = _mm_loadu_si128( (const __m128i *)(in_i + i) );
+    __m128i vq = _mm_loadu_si128( (const __m128i *)(in_q + i) );
+    __m128i lo = _mm_unpacklo_epi16( vi, vq );
+    __m128i hi = _mm_unpackhi_epi16( vi, vq );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, lo ), 16 ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, lo ), 16 ) );
+    __m128 f2 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, hi ), 16 ) );
+    __m128 f3 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, hi ), 16 ) );
+
+    _mm_storeu_ps( out + 2 * i +  0, _mm_mul_ps( f0, mul ) );
+    _mm_storeu_ps( out + 2 * i +  4, _mm_mul_ps( f1, mul ) );
+    _mm_storeu_ps( out + 2 * i +  8, _mm_mul_ps( f2, mul ) );
+    _mm_storeu_ps( out + 2 * i + 12, _mm_mul_ps( f3, mul ) );
+  }
+
+  s16_f32_split_generic( in_i + i, in_q + i, out + 2 * i, nitems - i, scale );
+}
+
+/* a complex sample is 64 bits, unpacking the channels as doubles
+ * interleaves them one sample at a time */
+TARGET("sse2")
+static void f32_s16_intl_sse2( const float *const *in, int16_t *out, size_t nchan,
+                               size_t nitems, float scale )
+{
+  if (nchan == 1) {
+    f32_s16_sse2( in[0], out, 2 * nitems, scale );
+    return;
+  }
+
+  if (nchan != 2) {
+    f32_s16_intl_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const __m128 mul = _mm_set1_ps( scale );
+  const __m128 max = _mm_set1_ps( S16_MAX );
+  const __m128 min = _mm_set1_ps( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 2 <= nitems; i += 2) {
+    __m128d a = _mm_castps_pd( _mm_loadu_ps( in[0] + 2 * i ) );
+    __m128d b = _mm_castps_pd( _mm_loadu_ps( in[1] + 2 * i ) );
+
+    __m128 f0 = _mm_mul_ps( _mm_castpd_ps( _mm_unpacklo_pd( a, b ) ), mul );
+    __m128 f1 = _mm_mul_ps( _mm_castpd_ps( _mm_unpackhi_pd( a, b ) ), mul );
+
+    __m128i i0 = _mm_cvtps_epi32( _mm_max_ps( _mm_min_ps( f0, max ), min ) );
+    __m128i i1 = _mm_cvtps_epi32( _mm_max_ps( _mm_min_ps( f1, max ), min ) );
+
+    _mm_storeu_si128( (__m128i *)(out + 4 * i), _mm_packs_epi32( i0, i1 ) );
+  }
+
+  f32_s16_intl2_tail( in, out, i, nitems, scale );
+}
+
+TARGET("sse2")
+static inline double hsum_sse2( __m128 v )
+{
+  float f[4];
+
+  _mm_storeu_ps( f, v );
+  return double(f[0]) + f[1] + f[2] + f[3];
+}
+
+/* the counts of sum_sse2() in the two halves */
+TARGET("sse2")
+static inline uint64_t hsum_sse2( __m128i v )
+{
+  uint64_t n[2];
+
+  _mm_storeu_si128( (__m128i *)n, v );
+  return n[0] + n[1];
+}
+
+/* the clipped values of a compare mask with one byte per value, summed
+ * up in 64 bit lanes so they can't overflow */
+TARGET("sse2")
+static inline __m128i sum_sse2( __m128i sum, __m128i mask )
+{
+  const __m128i one = _mm_set1_epi8( 1 );
+
+  return _mm_add_epi64( sum, _mm_sad_epu8( _mm_and_si128( mask, one ), _mm_setzero_si128() ) );
+}
+
+/* the level kernels square what they store, and count the clipped
+ * values with the mask of a compare */
+TARGET("sse2")
+static void u8_f32_lvl_sse2( const uint8_t *in, float *out, size_t nvalues,
+                             convert_level_t *level )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8( -1 );
+  const __m128 offset = _mm_set1_ps( U8_OFFSET );
+  const __m128 scale = _mm_set1_ps( S8_SCALE );
+  __m128 power[2] = { _mm_setzero_ps(), _mm_setzero_ps() };
+  __m128i clipped = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+    __m128i lo = _mm_unpacklo_epi8( v, zero );
+    __m128i hi = _mm_unpackhi_epi8( v, zero );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) );
+    __m128 f2 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) );
+    __m128 f3 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) );
+
+    f0 = _mm_mul_ps( _mm_sub_ps( f0, offset ), scale );
+    f1 = _mm_mul_ps( _mm_sub_ps( f1, offset ), scale );
+    f2 = _mm_mul_ps( _mm_sub_ps( f2, offset ), scale );
+    f3 = _mm_mul_ps( _mm_sub_ps( f3, offset ), scale );
+
+    _mm_storeu_ps( out + i +  0, f0 );
+    _mm_storeu_ps( out + i +  4, f1 );
+    _mm_storeu_ps( out + i +  8, f2 );
+    _mm_storeu_ps( out + i + 12, f3 );
+
+    power[0] = _mm_add_ps( power[0], _mm_add_ps( _mm_mul_ps( f0, f0 ), _mm_mul_ps( f1, f1 ) ) );
+    power[1] = _mm_add_ps( power[1], _mm_add_ps( _mm_mul_ps( f2, f2 ), _mm_mul_ps( f3, f3 ) ) );
+
+    __m128i m = _mm_or_si128( _mm_cmpeq_epi8( v, zero ), _mm_cmpeq_epi8( v, ones ) );
+    clipped = sum_sse2( clipped, m );
+  }
+
+  level_add( level, hsum_sse2( _mm_add_ps( power[0], power[1] ) ), i, hsum_sse2( clipped ) );
+  u8_f32_lvl_generic( in + i, out + i, nvalues - i, level );
+}
+
+TARGET("sse2")
+static void s8_f32_lvl_sse2( const int8_t *in, float *out, size_t nvalues,
+                             convert_level_t *level )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i min = _mm_set1_epi8( -128 );
+  const __m128i max = _mm_set1_epi8( 127 );
+  const __m128 scale = _mm_set1_ps( S8_SCALE );
+  __m128 power[2] = { _mm_setzero_ps(), _mm_setzero_ps() };
+  __m128i clipped = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+    __m128i lo = _mm_srai_epi16( _mm_unpacklo_epi8( zero, v ), 8 );
+    __m128i hi = _mm_srai_epi16( _mm_unpackhi_epi8( zero, v ), 8 );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, lo ), 16 ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, lo ), 16 ) );
+    __m128 f2 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, hi ), 16 ) );
+    __m128 f3 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, hi ), 16 ) );
+
+    f0 = _mm_mul_ps( f0, scale );
+    f1 = _mm_mul_ps( f1, scale );
+    f2 = _mm_mul_ps( f2, scale );
+    f3 = _mm_mul_ps( f3, scale );
+
+    _mm_storeu_ps( out + i +  0, f0 );
+    _mm_storeu_ps( out + i +  4, f1 );
+    _mm_storeu_ps( out + i +  8, f2 );
+    _mm_storeu_ps( out + i + 12, f3 );
+
+    power[0] = _mm_add_ps( power[0], _mm_add_ps( _mm_mul_ps( f0, f0 ), _mm_mul_ps( f1, f1 ) ) );
+    power[1] = _mm_add_ps( power[1], _mm_add_ps( _mm_mul_ps( f2, f2 ), _mm_mul_ps( f3, f3 ) ) );
+
+    __m128i m = _mm_or_si128( _mm_cmpeq_epi8( v, min ), _mm_cmpeq_epi8( v, max ) );
+    clipped = sum_sse2( clipped, m );
+  }
+
+  level_add( level, hsum_sse2( _mm_add_ps( power[0], power[1] ) ), i, hsum_sse2( clipped ) );
+  s8_f32_lvl_generic( in + i, out + i, nvalues - i, level );
+}
+
+TARGET("sse2")
+static void s16_f32_lvl_sse2( const int16_t *in, float *out, size_t nvalues, float scale,
+                              int16_t clip, convert_level_t *level )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i above = _mm_set1_epi16( int16_t( clip - 1 ) );
+  const __m128i below = _mm_set1_epi16( int16_t( 1 - clip ) );
+  const __m128 mul = _mm_set1_ps( scale );
+  __m128 power[2] = { _mm_setzero_ps(), _mm_setzero_ps() };
+  __m128i clipped = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+
+    __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( zero, v ), 16 ) );
+    __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( zero, v ), 16 ) );
+
+    f0 = _mm_mul_ps( f0, mul );
+    f1 = _mm_mul_ps( f1, mul );
+
+    _mm_storeu_ps( out + i + 0, f0 );
+    _mm_storeu_ps( out + i + 4, f1 );
+
+    power[0] = _mm_add_ps( power[0], _mm_mul_ps( f0, f0 ) );
+    power[1] = _mm_add_ps( power[1], _mm_mul_ps( f1, f1 ) );
+
+    __m128i m = _mm_or_si128( _mm_cmpgt_epi16( v, above ), _mm_cmplt_epi16( v, below ) );
+    clipped = sum_sse2( clipped, _mm_packs_epi16( m, zero ) );
+  }
+
+  level_add( level, hsum_sse2( _mm_add_ps( power[0], power[1] ) ), i, hsum_sse2( clipped ) );
+  s16_f32_lvl_generic( in + i, out + i, nvalues - i, scale, clip, level );
+}
+
+static const convert_kernels_t sse2_kernels = {
+  "sse2",
+  u8_f32_sse2,
+  s8_f32_sse2,
+  s16_f32_sse2,
+  f32_s16_sse2,
+  f32_s8_sse2,
+  u8_s8_sse2,
+  s16_f32_deint_sse2,
+  s24_f32_deint_generic,  /* needs a byte shuffle, SSSE3 */
+  s16_f32_split_sse2,
+  f32_s16_intl_sse2,
+  u8_f32_lvl_sse2,
+  s8_f32_lvl_sse2,
+  s16_f32_lvl_sse2,
+  s16_f32_deint_lvl_generic,
+  s16_f32_split_lvl_generic
+};
+
+#endif
+
+#if defined(CONVERT_X86_DISPATCH) || (defined(CONVERT_X86_STATIC) && defined(__AVX2__))
+
+/*
+ * AVX2 kernels, 32 values per iteration
+ */
+
+TARGET("avx2")
+static void u8_f32_avx2( const uint8_t *in, float *out, size_t nvalues )
+{
+  const __m256 offset = _mm256_set1_ps( U8_OFFSET );
+  const __m256 scale = _mm256_set1_ps( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    for (size_t j = 0; j < 32; j += 8) {
+      __m128i v = _mm_loadl_epi64( (const __m128i *)(in + i + j) );
+      __m256 f = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( v ) );
+      _mm256_storeu_ps( out + i + j, _mm256_mul_ps( _mm256_sub_ps( f, offset ), scale ) );
+    }
+  }
+
+  u8_f32_generic( in + i, out + i, nvalues - i );
+}
+
+TARGET("avx2")
+static void s8_f32_avx2( const int8_t *in, float *out, size_t nvalues )
+{
+  const __m256 scale = _mm256_set1_ps( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    for (size_t j = 0; j < 32; j += 8) {
+      __m128i v = _mm_loadl_epi64( (const __m128i *)(in + i + j) );
+      __m256 f = _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( v ) );
+      _mm256_storeu_ps( out + i + j, _mm256_mul_ps( f, scale ) );
+    }
+  }
+
+  s8_f32_generic( in + i, out + i, nvalues - i );
+}
+
+TARGET("avx2")
+static void s16_f32_avx2( const int16_t *in, float *out, size_t nvalues, float scale )
+{
+  const __m256 mul = _mm256_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m128i v0 = _mm_loadu_si128( (const __m128i *)(in + i + 0) );
+    __m128i v1 = _mm_loadu_si128( (const __m128i *)(in + i + 8) );
+    __m256 f0 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( v0 ) );
+    __m256 f1 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( v1 ) );
+    _mm256_storeu_ps( out + i + 0, _mm256_mul_ps( f0, mul ) );
+    _mm256_storeu_ps( out + i + 8, _mm256_mul_ps( f1, mul ) );
+  }
+
+  s16_f32_generic( in + i, out + i, nvalues - i, scale );
+}
+
+TARGET("avx2")
+static void f32_s16_avx2( const float *in, int16_t *out, size_t nvalues, float scale )
+{
+  const __m256 mul = _mm256_set1_ps( scale );
+  const __m256 max = _mm256_set1_ps( S16_MAX );
+  const __m256 min = _mm256_set1_ps( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m256 f0 = _mm256_mul_ps( _mm256_loadu_ps( in + i + 0 ), mul );
+    __m256 f1 = _mm256_mul_ps( _mm256_loadu_ps( in + i + 8 ), mul );
+
+    __m256i i0 = _mm256_cvtps_epi32( _mm256_max_ps( _mm256_min_ps( f0, max ), min ) );
+    __m256i i1 = _mm256_cvtps_epi32( _mm256_max_ps( _mm256_min_ps( f1, max ), min ) );
+
+    /* packs works per 128 bit lane, put the quadwords back in order */
+    __m256i s = _mm256_permute4x64_epi64( _mm256_packs_epi32( i0, i1 ), 0xd8 );
+
+    _mm256_storeu_si256( (__m256i *)(out + i), s );
+  }
+
+  f32_s16_sse2( in + i, out + i, nvalues - i, scale );
+}
+
+TARGET("avx2")
+static void f32_s8_avx2( const float *in, int8_t *out, size_t nvalues, float scale )
+{
+  const __m256 mul = _mm256_set1_ps( scale );
+  const __m256 max = _mm256_set1_ps( S8_MAX );
+  const __m256 min = _mm256_set1_ps( -S8_MAX - 1 );
+  const __m256i perm = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    __m256i v[4];
+
+    for (int j = 0; j < 4; j++) {
+      __m256 f = _mm256_mul_ps( _mm256_loadu_ps( in + i + j * 8 ), mul );
+      v[j] = _mm256_cvtps_epi32( _mm256_max_ps( _mm256_min_ps( f, max ), min ) );
+    }
+
+    __m256i lo = _mm256_packs_epi32( v[0], v[1] );
+    __m256i hi = _mm256_packs_epi32( v[2], v[3] );
+
+    /* two rounds of per lane packing leave the dwords interleaved */
+    __m256i s = _mm256_permutevar8x32_epi32( _mm256_packs_epi16( lo, hi ), perm );
+
+    _mm256_storeu_si256( (__m256i *)(out + i), s );
+  }
+
+  f32_s8_sse2( in + i, out + i, nvalues - i, scale );
+}
+
+TARGET("avx2")
+static void s16_f32_deint_avx2( const int16_t *in, float *const *out, size_t nchan,
+                                size_t nitems, float scale )
+{
+  if (nchan != 2) {
+    s16_f32_deint_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const __m256i order = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+  const __m256 mul = _mm256_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 4 <= nitems; i += 4) {
+    __m256i v = _mm256_loadu_si256( (const __m256i *)(in + 4 * i) );
+    v = _mm256_permutevar8x32_epi32( v, order );
+
+    __m256 f0 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm256_castsi256_si128( v ) ) );
+    __m256 f1 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm256_extracti128_si256( v, 1 ) ) );
+
+    _mm256_storeu_ps( out[0] + 2 * i, _mm256_mul_ps( f0, mul ) );
+    _mm256_storeu_ps( out[1] + 2 * i, _mm256_mul_ps( f1, mul ) );
+  }
+
+  s16_f32_deint2_tail( in, out, i, nitems, scale );
+}
+
+/* 8 values of 24 bit per iteration, each lane moves its 4 values into
+ * the upper three bytes of a 32 bit word and shifts them back down */
+TARGET("avx2")
+static void s24_f32_deint_avx2( const uint8_t *in, float *const *out, size_t nchan,
+                                size_t nitems, float scale )
+{
+  if (nchan != 1 && nchan != 2) {
+    s24_f32_deint_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const __m256i spread = _mm256_setr_epi8(
+      -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+      -1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15 );
+  const __m256i order = _mm256_setr_epi32( 0, 1, 4, 5, 2, 3, 6, 7 );
+  const __m256 mul = _mm256_set1_ps( scale );
+  const size_t nvalues = 2 * nchan * nitems;
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    const uint8_t *p = in + 3 * i;
+    __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i *)(p + 0) ) ),
+        _mm_loadu_si128( (const __m128i *)(p + 8) ), 1 );
+
+    v = _mm256_srai_epi32( _mm256_shuffle_epi8( v, spread ), 8 );
+    __m256 f = _mm256_mul_ps( _mm256_cvtepi32_ps( v ), mul );
+
+    if (nchan == 1) {
+      _mm256_storeu_ps( out[0] + i, f );
+    } else {
+      /* I1 Q1 I2 Q2 I1 Q1 I2 Q2 */
+      f = _mm256_permutevar8x32_ps( f, order );
+      _mm_storeu_ps( out[0] + i / 2, _mm256_castps256_ps128( f ) );
+      _mm_storeu_ps( out[1] + i / 2, _mm256_extractf128_ps( f, 1 ) );
+    }
+  }
+
+  const size_t done = i / (2 * nchan);
+  float *rest[2] = { out[0] + 2 * done, nchan == 2 ? out[1] + 2 * done : NULL };
+
+  s24_f32_deint_generic( in + 3 * i, rest, nchan, nitems - done, scale );
+}
+
+TARGET("avx2")
+static void s16_f32_split_avx2( const int16_t *in_i, const int16_t *in_q, float *out,
+                                size_t nitems, float scale )
+{
+  const __m256 mul = _mm256_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 8 <= nitems; i += 8) {
+    __m128i vi = _mm_loadu_si128( (const __m128i *)(in_i + i) );
+    __m128i vq = _mm_loadu_si128( (const __m128i *)(in_q + i) );
+    __m256 f0 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm_unpacklo_epi16( vi, vq ) ) );
+    __m256 f1 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm_unpackhi_epi16( vi, vq ) ) );
+    _mm256_storeu_ps( out + 2 * i + 0, _mm256_mul_ps( f0, mul ) );
+    _mm256_storeu_ps( out + 2 * i + 8, _mm256_mul_ps( f1, mul ) );
+  }
+
+  s16_f32_split_generic( in_i + i, in_q + i, out + 2 * i, nitems - i, scale );
+}
+
+/* the per lane unpack and packs cancel out, the samples come out in order */
+TARGET("avx2")
+static void f32_s16_intl_avx2( const float *const *in, int16_t *out, size_t nchan,
+                               size_t nitems, float scale )
+{
+  if (nchan == 1) {
+    f32_s16_avx2( in[0], out, 2 * nitems, scale );
+    return;
+  }
+
+  if (nchan != 2) {
+    f32_s16_intl_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const __m256 mul = _mm256_set1_ps( scale );
+  const __m256 max = _mm256_set1_ps( S16_MAX );
+  const __m256 min = _mm256_set1_ps( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 4 <= nitems; i += 4) {
+    __m256d a = _mm256_castps_pd( _mm256_loadu_ps( in[0] + 2 * i ) );
+    __m256d b = _mm256_castps_pd( _mm256_loadu_ps( in[1] + 2 * i ) );
+
+    /* A0 B0 | A2 B2 and A1 B1 | A3 B3 */
+    __m256 f0 = _mm256_mul_ps( _mm256_castpd_ps( _mm256_unpacklo_pd( a, b ) ), mul );
+    __m256 f1 = _mm256_mul_ps( _mm256_castpd_ps( _mm256_unpackhi_pd( a, b ) ), mul );
+
+    __m256i i0 = _mm256_cvtps_epi32( _mm256_max_ps( _mm256_min_ps( f0, max ), min ) );
+    __m256i i1 = _mm256_cvtps_epi32( _mm256_max_ps( _mm256_min_ps( f1, max ), min ) );
+
+    _mm256_storeu_si256( (__m256i *)(out + 4 * i), _mm256_packs_epi32( i0, i1 ) );
+  }
+
+  f32_s16_intl2_tail( in, out, i, nitems, scale );
+}
+
+TARGET("avx2")
+static inline double hsum_avx2( __m256 v )
+{
+  return hsum_sse2( _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) ) );
+}
+
+TARGET("avx2")
+static inline uint64_t hsum_avx2( __m256i v )
+{
+  return hsum_sse2( _mm_add_epi64( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) ) );
+}
+
+TARGET("avx2")
+static inline __m256i sum_avx2( __m256i sum, __m256i mask )
+{
+  const __m256i one = _mm256_set1_epi8( 1 );
+
+  return _mm256_add_epi64( sum, _mm256_sad_epu8( _mm256_and_si256( mask, one ),
+                                                 _mm256_setzero_si256() ) );
+}
+
+TARGET("avx2")
+static void u8_f32_lvl_avx2( const uint8_t *in, float *out, size_t nvalues,
+                             convert_level_t *level )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi8( -1 );
+  const __m256 offset = _mm256_set1_ps( U8_OFFSET );
+  const __m256 scale = _mm256_set1_ps( S8_SCALE );
+  __m256 power = _mm256_setzero_ps();
+  __m256i clipped = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    for (size_t j = 0; j < 32; j += 8) {
+      __m128i v = _mm_loadl_epi64( (const __m128i *)(in + i + j) );
+      __m256 f = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( v ) );
+      f = _mm256_mul_ps( _mm256_sub_ps( f, offset ), scale );
+      _mm256_storeu_ps( out + i + j, f );
+      power = _mm256_add_ps( power, _mm256_mul_ps( f, f ) );
+    }
+
+    __m256i v = _mm256_loadu_si256( (const __m256i *)(in + i) );
+    __m256i m = _mm256_or_si256( _mm256_cmpeq_epi8( v, zero ), _mm256_cmpeq_epi8( v, ones ) );
+    clipped = sum_avx2( clipped, m );
+  }
+
+  level_add( level, hsum_avx2( power ), i, hsum_avx2( clipped ) );
+  u8_f32_lvl_generic( in + i, out + i, nvalues - i, level );
+}
+
+TARGET("avx2")
+static void s8_f32_lvl_avx2( const int8_t *in, float *out, size_t nvalues,
+                             convert_level_t *level )
+{
+  const __m256i min = _mm256_set1_epi8( -128 );
+  const __m256i max = _mm256_set1_epi8( 127 );
+  const __m256 scale = _mm256_set1_ps( S8_SCALE );
+  __m256 power = _mm256_setzero_ps();
+  __m256i clipped = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    for (size_t j = 0; j < 32; j += 8) {
+      __m128i v = _mm_loadl_epi64( (const __m128i *)(in + i + j) );
+      __m256 f = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( v ) ), scale );
+      _mm256_storeu_ps( out + i + j, f );
+      power = _mm256_add_ps( power, _mm256_mul_ps( f, f ) );
+    }
+
+    __m256i v = _mm256_loadu_si256( (const __m256i *)(in + i) );
+    __m256i m = _mm256_or_si256( _mm256_cmpeq_epi8( v, min ), _mm256_cmpeq_epi8( v, max ) );
+    clipped = sum_avx2( clipped, m );
+  }
+
+  level_add( level, hsum_avx2( power ), i, hsum_avx2( clipped ) );
+  s8_f32_lvl_generic( in + i, out + i, nvalues - i, level );
+}
+
+TARGET("avx2")
+static void s16_f32_lvl_avx2( const int16_t *in, float *out, size_t nvalues, float scale,
+                              int16_t clip, convert_level_t *level )
+{
+  const __m256i above = _mm256_set1_epi16( int16_t( clip - 1 ) );
+  const __m256i below = _mm256_set1_epi16( int16_t( 1 - clip ) );
+  const __m256 mul = _mm256_set1_ps( scale );
+  __m256 power[2] = { _mm256_setzero_ps(), _mm256_setzero_ps() };
+  __m256i clipped = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    __m256i v = _mm256_loadu_si256( (const __m256i *)(in + i) );
+
+    __m256 f0 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm256_castsi256_si128( v ) ) );
+    __m256 f1 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm256_extracti128_si256( v, 1 ) ) );
+
+    f0 = _mm256_mul_ps( f0, mul );
+    f1 = _mm256_mul_ps( f1, mul );
+
+    _mm256_storeu_ps( out + i + 0, f0 );
+    _mm256_storeu_ps( out + i + 8, f1 );
+
+    power[0] = _mm256_add_ps( power[0], _mm256_mul_ps( f0, f0 ) );
+    power[1] = _mm256_add_ps( power[1], _mm256_mul_ps( f1, f1 ) );
+
+    __m256i m = _mm256_or_si256( _mm256_cmpgt_epi16( v, above ), _mm256_cmpgt_epi16( below, v ) );
+    clipped = sum_avx2( clipped, _mm256_packs_epi16( m, _mm256_setzero_si256() ) );
+  }
+
+  level_add( level, hsum_avx2( _mm256_add_ps( power[0], power[1] ) ), i, hsum_avx2( clipped ) );
+  s16_f32_lvl_generic( in + i, out + i, nvalues - i, scale, clip, level );
+}
+
+static const convert_kernels_t avx2_kernels = {
+  "avx2",
+  u8_f32_avx2,
+  s8_f32_avx2,
+  s16_f32_avx2,
+  f32_s16_avx2,
+  f32_s8_avx2,
+  u8_s8_sse2,
+  s16_f32_deint_avx2,
+  s24_f32_deint_avx2,
+  s16_f32_split_avx2,
+  f32_s16_intl_avx2,
+  u8_f32_lvl_avx2,
+  s8_f32_lvl_avx2,
+  s16_f32_lvl_avx2,
+  s16_f32_deint_lvl_generic,
+  s16_f32_split_lvl_generic
+};
+
+#endif
+
+#if defined(CONVERT_X86_DISPATCH)
+
+/*
+ * AVX-512 kernels, 64 values per iteration
+ */
+
+#if defined(__GNUC__) && !defined(__clang__)
+/* gcc warns about _mm512_undefined_*() used inside its own intrinsics */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+TARGET("avx512f")
+static void u8_f32_avx512( const uint8_t *in, float *out, size_t nvalues )
+{
+  const __m512 offset = _mm512_set1_ps( U8_OFFSET );
+  const __m512 scale = _mm512_set1_ps( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 64 <= nvalues; i += 64) {
+    for (size_t j = 0; j < 64; j += 16) {
+      __m128i v = _mm_loadu_si128( (const __m128i *)(in + i + j) );
+      __m512 f = _mm512_cvtepi32_ps( _mm512_cvtepu8_epi32( v ) );
+      _mm512_storeu_ps( out + i + j, _mm512_mul_ps( _mm512_sub_ps( f, offset ), scale ) );
+    }
+  }
+
+  u8_f32_avx2( in + i, out + i, nvalues - i );
+}
+
+TARGET("avx512f")
+static void s8_f32_avx512( const int8_t *in, float *out, size_t nvalues )
+{
+  const __m512 scale = _mm512_set1_ps( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 64 <= nvalues; i += 64) {
+    for (size_t j = 0; j < 64; j += 16) {
+      __m128i v = _mm_loadu_si128( (const __m128i *)(in + i + j) );
+      __m512 f = _mm512_cvtepi32_ps( _mm512_cvtepi8_epi32( v ) );
+      _mm512_storeu_ps( out + i + j, _mm512_mul_ps( f, scale ) );
+    }
+  }
+
+  s8_f32_avx2( in + i, out + i, nvalues - i );
+}
+
+TARGET("avx512f")
+static void s16_f32_avx512( const int16_t *in, float *out, size_t nvalues, float scale )
+{
+  const __m512 mul = _mm512_set1_ps( scale );
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    __m256i v0 = _mm256_loadu_si256( (const __m256i *)(in + i +  0) );
+    __m256i v1 = _mm256_loadu_si256( (const __m256i *)(in + i + 16) );
+    __m512 f0 = _mm512_cvtepi32_ps( _mm512_cvtepi16_epi32( v0 ) );
+    __m512 f1 = _mm512_cvtepi32_ps( _mm512_cvtepi16_epi32( v1 ) );
+    _mm512_storeu_ps( out + i +  0, _mm512_mul_ps( f0, mul ) );
+    _mm512_storeu_ps( out + i + 16, _mm512_mul_ps( f1, mul ) );
+  }
+
+  s16_f32_avx2( in + i, out + i, nvalues - i, scale );
+}
+
+/* the saturating down conversions of avx512f work in order, no packing */
+TARGET("avx512f")
+static void f32_s16_avx512( const float *in, int16_t *out, size_t nvalues, float scale )
+{
+  const __m512 mul = _mm512_set1_ps( scale );
+  const __m512 max = _mm512_set1_ps( S16_MAX );
+  const __m512 min = _mm512_set1_ps( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 32 <= nvalues; i += 32) {
+    for (size_t j = 0; j < 32; j += 16) {
+      __m512 f = _mm512_mul_ps( _mm512_loadu_ps( in + i + j ), mul );
+      __m512i v = _mm512_cvtps_epi32( _mm512_max_ps( _mm512_min_ps( f, max ), min ) );
+      _mm256_storeu_si256( (__m256i *)(out + i + j), _mm512_cvtsepi32_epi16( v ) );
+    }
+  }
+
+  f32_s16_avx2( in + i, out + i, nvalues - i, scale );
+}
+
+TARGET("avx512f")
+static void f32_s8_avx512( const float *in, int8_t *out, size_t nvalues, float scale )
+{
+  const __m512 mul = _mm512_set1_ps( scale );
+  const __m512 max = _mm512_set1_ps( S8_MAX );
+  const __m512 min = _mm512_set1_ps( -S8_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 64 <= nvalues; i += 64) {
+    for (size_t j = 0; j < 64; j += 16) {
+      __m512 f = _mm512_mul_ps( _mm512_loadu_ps( in + i + j ), mul );
+      __m512i v = _mm512_cvtps_epi32( _mm512_max_ps( _mm512_min_ps( f, max ), min ) );
+      _mm_storeu_si128( (__m128i *)(out + i + j), _mm512_cvtsepi32_epi8( v ) );
+    }
+  }
+
+  f32_s8_avx2( in + i, out + i, nvalues - i, scale );
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static const convert_kernels_t avx512_kernels = {
+  "avx512",
+  u8_f32_avx512,
+  s8_f32_avx512,
+  s16_f32_avx512,
+  f32_s16_avx512,
+  f32_s8_avx512,
+  u8_s8_sse2,
+  s16_f32_deint_avx2,
+  s24_f32_deint_avx2,
+  s16_f32_split_avx2,
+  f32_s16_intl_avx2,
+  u8_f32_lvl_avx2,
+  s8_f32_lvl_avx2,
+  s16_f32_lvl_avx2,
+  s16_f32_deint_lvl_generic,
+  s16_f32_split_lvl_generic
+};
+
+#endif
+
+#if defined(CONVERT_NEON)
+
+/*
+ * NEON kernels, 16 values per iteration
+ */
+
+static void u8_f32_neon( const uint8_t *in, float *out, size_t nvalues )
+{
+  const float32x4_t offset = vdupq_n_f32( U8_OFFSET );
+  const float32x4_t scale = vdupq_n_f32( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    uint8x16_t v = vld1q_u8( in + i );
+    uint16x8_t lo = vmovl_u8( vget_low_u8( v ) );
+    uint16x8_t hi = vmovl_u8( vget_high_u8( v ) );
+
+    float32x4_t f0 = vcvtq_f32_u32( vmovl_u16( vget_low_u16( lo ) ) );
+    float32x4_t f1 = vcvtq_f32_u32( vmovl_u16( vget_high_u16( lo ) ) );
+    float32x4_t f2 = vcvtq_f32_u32( vmovl_u16( vget_low_u16( hi ) ) );
+    float32x4_t f3 = vcvtq_f32_u32( vmovl_u16( vget_high_u16( hi ) ) );
+
+    vst1q_f32( out + i +  0, vmulq_f32( vsubq_f32( f0, offset ), scale ) );
+    vst1q_f32( out + i +  4, vmulq_f32( vsubq_f32( f1, offset ), scale ) );
+    vst1q_f32( out + i +  8, vmulq_f32( vsubq_f32( f2, offset ), scale ) );
+    vst1q_f32( out + i + 12, vmulq_f32( vsubq_f32( f3, offset ), scale ) );
+  }
+
+  u8_f32_generic( in + i, out + i, nvalues - i );
+}
+
+static void s8_f32_neon( const int8_t *in, float *out, size_t nvalues )
+{
+  const float32x4_t scale = vdupq_n_f32( S8_SCALE );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    int8x16_t v = vld1q_s8( in + i );
+    int16x8_t lo = vmovl_s8( vget_low_s8( v ) );
+    int16x8_t hi = vmovl_s8( vget_high_s8( v ) );
+
+    float32x4_t f0 = vcvtq_f32_s32( vmovl_s16( vget_low_s16( lo ) ) );
+    float32x4_t f1 = vcvtq_f32_s32( vmovl_s16( vget_high_s16( lo ) ) );
+    float32x4_t f2 = vcvtq_f32_s32( vmovl_s16( vget_low_s16( hi ) ) );
+    float32x4_t f3 = vcvtq_f32_s32( vmovl_s16( vget_high_s16( hi ) ) );
+
+    vst1q_f32( out + i +  0, vmulq_f32( f0, scale ) );
+    vst1q_f32( out + i +  4, vmulq_f32( f1, scale ) );
+    vst1q_f32( out + i +  8, vmulq_f32( f2, scale ) );
+    vst1q_f32( out + i + 12, vmulq_f32( f3, scale ) );
+  }
+
+  s8_f32_generic( in + i, out + i, nvalues - i );
+}
+
+static void s16_f32_neon( const int16_t *in, float *out, size_t nvalues, float scale )
+{
+  const float32x4_t mul = vdupq_n_f32( scale );
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    int16x8_t v = vld1q_s16( in + i );
+
+    float32x4_t f0 = vcvtq_f32_s32( vmovl_s16( vget_low_s16( v ) ) );
+    float32x4_t f1 = vcvtq_f32_s32( vmovl_s16( vget_high_s16( v ) ) );
+
+    vst1q_f32( out + i + 0, vmulq_f32( f0, mul ) );
+    vst1q_f32( out + i + 4, vmulq_f32( f1, mul ) );
+  }
+
+  s16_f32_generic( in + i, out + i, nvalues - i, scale );
+}
+
+static void u8_s8_neon( const uint8_t *in, int8_t *out, size_t nvalues )
+{
+  const uint8x16_t sign = vdupq_n_u8( 0x80 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16)
+    vst1q_s8( out + i, vreinterpretq_s8_u8( veorq_u8( vld1q_u8( in + i ), sign ) ) );
+
+  u8_s8_generic( in + i, out + i, nvalues - i );
+}
+
+/* vld2 splits the 32 bit complex samples by channel */
+static void s16_f32_deint_neon( const int16_t *in, float *const *out, size_t nchan,
+                                size_t nitems, float scale )
+{
+  if (nchan != 2) {
+    s16_f32_deint_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const float32x4_t mul = vdupq_n_f32( scale );
+  size_t i = 0;
+
+  for (; i + 4 <= nitems; i += 4) {
+    int32x4x2_t v = vld2q_s32( (const int32_t *)(in + 4 * i) );
+
+    for (size_t n = 0; n < 2; n++) {
+      int16x8_t s = vreinterpretq_s16_s32( v.val[n] );
+
+      float32x4_t f0 = vcvtq_f32_s32( vmovl_s16( vget_low_s16( s ) ) );
+      float32x4_t f1 = vcvtq_f32_s32( vmovl_s16( vget_high_s16( s ) ) );
+
+      vst1q_f32( out[n] + 2 * i + 0, vmulq_f32( f0, mul ) );
+      vst1q_f32( out[n] + 2 * i + 4, vmulq_f32( f1, mul ) );
+    }
+  }
+
+  s16_f32_deint2_tail( in, out, i, nitems, scale );
+}
+
+#if defined(__aarch64__)
+/*
+ * ARMv8 has the round to nearest even conversion of lrintf(), and
+ * vminnm/vmaxnm pick the number over a NaN just like std::min/max do.
+ * ARMv7 keeps the generic kernels for these, to round the same way.
+ */
+static void f32_s16_neon( const float *in, int16_t *out, size_t nvalues, float scale )
+{
+  const float32x4_t mul = vdupq_n_f32( scale );
+  const float32x4_t max = vdupq_n_f32( S16_MAX );
+  const float32x4_t min = vdupq_n_f32( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    float32x4_t f0 = vmulq_f32( vld1q_f32( in + i + 0 ), mul );
+    float32x4_t f1 = vmulq_f32( vld1q_f32( in + i + 4 ), mul );
+
+    int32x4_t i0 = vcvtnq_s32_f32( vmaxnmq_f32( vminnmq_f32( f0, max ), min ) );
+    int32x4_t i1 = vcvtnq_s32_f32( vmaxnmq_f32( vminnmq_f32( f1, max ), min ) );
+
+    vst1q_s16( out + i, vcombine_s16( vqmovn_s32( i0 ), vqmovn_s32( i1 ) ) );
+  }
+
+  f32_s16_generic( in + i, out + i, nvalues - i, scale );
+}
+
+static void f32_s8_neon( const float *in, int8_t *out, size_t nvalues, float scale )
+{
+  const float32x4_t mul = vdupq_n_f32( scale );
+  const float32x4_t max = vdupq_n_f32( S8_MAX );
+  const float32x4_t min = vdupq_n_f32( -S8_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    int16x4_t v[4];
+
+    for (int j = 0; j < 4; j++) {
+      float32x4_t f = vmulq_f32( vld1q_f32( in + i + j * 4 ), mul );
+      v[j] = vqmovn_s32( vcvtnq_s32_f32( vmaxnmq_f32( vminnmq_f32( f, max ), min ) ) );
+    }
+
+    int8x8_t lo = vqmovn_s16( vcombine_s16( v[0], v[1] ) );
+    int8x8_t hi = vqmovn_s16( vcombine_s16( v[2], v[3] ) );
+
+    vst1q_s8( out + i, vcombine_s8( lo, hi ) );
+  }
+
+  f32_s8_generic( in + i, out + i, nvalues - i, scale );
+}
+
+/* combining the halves interleaves the channels one sample at a time */
+static void f32_s16_intl_neon( const float *const *in, int16_t *out, size_t nchan,
+                               size_t nitems, float scale )
+{
+  if (nchan == 1) {
+    f32_s16_neon( in[0], out, 2 * nitems, scale );
+    return;
+  }
+
+  if (nchan != 2) {
+    f32_s16_intl_generic( in, out, nchan, nitems, scale );
+    return;
+  }
+
+  const float32x4_t mul = vdupq_n_f32( scale );
+  const float32x4_t max = vdupq_n_f32( S16_MAX );
+  const float32x4_t min = vdupq_n_f32( -S16_MAX - 1 );
+  size_t i = 0;
+
+  for (; i + 2 <= nitems; i += 2) {
+    float32x4_t a = vld1q_f32( in[0] + 2 * i );
+    float32x4_t b = vld1q_f32( in[1] + 2 * i );
+
+    float32x4_t f0 = vmulq_f32( vcombine_f32( vget_low_f32( a ), vget_low_f32( b ) ), mul );
+    float32x4_t f1 = vmulq_f32( vcombine_f32( vget_high_f32( a ), vget_high_f32( b ) ), mul );
+
+    int32x4_t i0 = vcvtnq_s32_f32( vmaxnmq_f32( vminnmq_f32( f0, max ), min ) );
+    int32x4_t i1 = vcvtnq_s32_f32( vmaxnmq_f32( vminnmq_f32( f1, max ), min ) );
+
+    vst1q_s16( out + 4 * i, vcombine_s16( vqmovn_s32( i0 ), vqmovn_s32( i1 ) ) );
+  }
+
+  f32_s16_intl2_tail( in, out, i, nitems, scale );
+}
+#else
+#define f32_s16_neon f32_s16_generic
+#define f32_s8_neon  f32_s8_generic
+#define f32_s16_intl_neon f32_s16_intl_generic
+#endif
+
+static void s16_f32_split_neon( const int16_t *in_i, const int16_t *in_q, float *out,
+                                size_t nitems, float scale )
+{
+  const float32x4_t mul = vdupq_n_f32( scale );
+  size_t i = 0;
+
+  for (; i + 8 <= nitems; i += 8) {
+    int16x8x2_t v = vzipq_s16( vld1q_s16( in_i + i ), vld1q_s16( in_q + i ) );
+
+    float32x4_t f0 = vcvtq_f32_s32( vmovl_s16( vget_low_s16( v.val[0] ) ) );
+    float32x4_t f1 = vcvtq_f32_s32( vmovl_s16( vget_high_s16( v.val[0] ) ) );
+    float32x4_t f2 = vcvtq_f32_s32( vmovl_s16( vget_low_s16( v.val[1] ) ) );
+    float32x4_t f3 = vcvtq_f32_s32( vmovl_s16( vget_high_s16( v.val[1] ) ) );
+
+    vst1q_f32( out + 2 * i +  0, vmulq_f32( f0, mul ) );
+    vst1q_f32( out + 2 * i +  4, vmulq_f32( f1, mul ) );
+    vst1q_f32( out + 2 * i +  8, vmulq_f32( f2, mul ) );
+    vst1q_f32( out + 2 * i + 12, vmulq_f32( f3, mul ) );
+  }
+
+  s16_f32_split_generic( in_i + i, in_q + i, out + 2 * i, nitems - i, scale );
+}
+
+static inline double hsum_neon_f32( float32x4_t v )
+{
+  return double(vgetq_lane_f32( v, 0 )) + vgetq_lane_f32( v, 1 ) +
+         vgetq_lane_f32( v, 2 ) + vgetq_lane_f32( v, 3 );
+}
+
+static inline uint64_t hsum_neon_u32( uint32x4_t v )
+{
+  return uint64_t(vgetq_lane_u32( v, 0 )) + vgetq_lane_u32( v, 1 ) +
+         vgetq_lane_u32( v, 2 ) + vgetq_lane_u32( v, 3 );
+}
+
+/* the clipped values are counted in the lanes, the compare masks shifted
+ * down to one and added pairwise */
+static void u8_f32_lvl_neon( const uint8_t *in, float *out, size_t nvalues,
+                             convert_level_t *level )
+{
+  const float32x4_t offset = vdupq_n_f32( U8_OFFSET );
+  const float32x4_t scale = vdupq_n_f32( S8_SCALE );
+  float32x4_t power = vdupq_n_f32( 0 );
+  uint32x4_t clipped = vdupq_n_u32( 0 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    uint8x16_t v = vld1q_u8( in + i );
+    uint16x8_t lo = vmovl_u8( vget_low_u8( v ) );
+    uint16x8_t hi = vmovl_u8( vget_high_u8( v ) );
+
+    float32x4_t f[4];
+    f[0] = vcvtq_f32_u32( vmovl_u16( vget_low_u16( lo ) ) );
+    f[1] = vcvtq_f32_u32( vmovl_u16( vget_high_u16( lo ) ) );
+    f[2] = vcvtq_f32_u32( vmovl_u16( vget_low_u16( hi ) ) );
+    f[3] = vcvtq_f32_u32( vmovl_u16( vget_high_u16( hi ) ) );
+
+    for (int j = 0; j < 4; j++) {
+      f[j] = vmulq_f32( vsubq_f32( f[j], offset ), scale );
+      vst1q_f32( out + i + 4 * j, f[j] );
+      power = vmlaq_f32( power, f[j], f[j] );
+    }
+
+    uint8x16_t m = vorrq_u8( vceqq_u8( v, vdupq_n_u8( 0x00 ) ), vceqq_u8( v, vdupq_n_u8( 0xff ) ) );
+    clipped = vpadalq_u16( clipped, vpaddlq_u8( vshrq_n_u8( m, 7 ) ) );
+  }
+
+  level_add( level, hsum_neon_f32( power ), i, hsum_neon_u32( clipped ) );
+  u8_f32_lvl_generic( in + i, out + i, nvalues - i, level );
+}
+
+static void s8_f32_lvl_neon( const int8_t *in, float *out, size_t nvalues,
+                             convert_level_t *level )
+{
+  const float32x4_t scale = vdupq_n_f32( S8_SCALE );
+  float32x4_t power = vdupq_n_f32( 0 );
+  uint32x4_t clipped = vdupq_n_u32( 0 );
+  size_t i = 0;
+
+  for (; i + 16 <= nvalues; i += 16) {
+    int8x16_t v = vld1q_s8( in + i );
+    int16x8_t lo = vmovl_s8( vget_low_s8( v ) );
+    int16x8_t hi = vmovl_s8( vget_high_s8( v ) );
+
+    float32x4_t f[4];
+    f[0] = vcvtq_f32_s32( vmovl_s16( vget_low_s16( lo ) ) );
+    f[1] = vcvtq_f32_s32( vmovl_s16( vget_high_s16( lo ) ) );
+    f[2] = vcvtq_f32_s32( vmovl_s16( vget_low_s16( hi ) ) );
+    f[3] = vcvtq_f32_s32( vmovl_s16( vget_high_s16( hi ) ) );
+
+    for (int j = 0; j < 4; j++) {
+      f[j] = vmulq_f32( f[j], scale );
+      vst1q_f32( out + i + 4 * j, f[j] );
+      power = vmlaq_f32( power, f[j], f[j] );
+    }
+
+    uint8x16_t m = vorrq_u8( vceqq_s8( v, vdupq_n_s8( -128 ) ), vceqq_s8( v, vdupq_n_s8( 127 ) ) );
+    clipped = vpadalq_u16( clipped, vpaddlq_u8( vshrq_n_u8( m, 7 ) ) );
+  }
+
+  level_add( level, hsum_neon_f32( power ), i, hsum_neon_u32( clipped ) );
+  s8_f32_lvl_generic( in + i, out + i, nvalues - i, level );
+}
+
+static void s16_f32_lvl_neon( const int16_t *in, float *out, size_t nvalues, float scale,
+                              int16_t clip, convert_level_t *level )
+{
+  const float32x4_t mul = vdupq_n_f32( scale );
+  const int16x8_t max = vdupq_n_s16( clip );
+  const int16x8_t min = vdupq_n_s16( int16_t( -clip ) );
+  float32x4_t power = vdupq_n_f32( 0 );
+  uint32x4_t clipped = vdupq_n_u32( 0 );
+  size_t i = 0;
+
+  for (; i + 8 <= nvalues; i += 8) {
+    int16x8_t v = vld1q_s16( in + i );
+
+    float32x4_t f0 = vmulq_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( v ) ) ), mul );
+    float32x4_t f1 = vmulq_f32( vcvtq_f32_s32( vmovl_s16( vget_high_s16( v ) ) ), mul );
+
+    vst1q_f32( out + i + 0, f0 );
+    vst1q_f32( out + i + 4, f1 );
+
+    power = vmlaq_f32( vmlaq_f32( power, f0, f0 ), f1, f1 );
+
+    uint16x8_t m = vorrq_u16( vcgeq_s16( v, max ), vcleq_s16( v, min ) );
+    clipped = vpadalq_u16( clipped, vshrq_n_u16( m, 15 ) );
+  }
+
+  level_add( level, hsum_neon_f32( power ), i, hsum_neon_u32( clipped ) );
+  s16_f32_lvl_generic( in + i, out + i, nvalues - i, scale, clip, level );
+}
+
+static const convert_kernels_t neon_kernels = {
+  "neon",
+  u8_f32_neon,
+  s8_f32_neon,
+  s16_f32_neon,
+  f32_s16_neon,
+  f32_s8_neon,
+  u8_s8_neon,
+  s16_f32_deint_neon,
+  s24_f32_deint_generic,
+  s16_f32_split_neon,
+  f32_s16_intl_neon,
+  u8_f32_lvl_neon,
+  s8_f32_lvl_neon,
+  s16_f32_lvl_neon,
+  s16_f32_deint_lvl_generic,
+  s16_f32_split_lvl_generic
+};
+
+#endif
+
+static const convert_kernels_t *select_kernels()
+{
+#if defined(CONVERT_X86_DISPATCH)
+  __builtin_cpu_init();
+
+  if ( __builtin_cpu_supports("avx512f") )
+    return &avx512_kernels;
+
+  if ( __builtin_cpu_supports("avx2") )
+    return &avx2_kernels;
+
+  if ( __builtin_cpu_supports("sse2") )
+    return &sse2_kernels;
+#elif defined(CONVERT_X86_STATIC) && defined(__AVX2__)
+  return &avx2_kernels;
+#elif defined(CONVERT_X86_STATIC)
+  return &sse2_kernels;
+#elif defined(CONVERT_NEON)
+  return &neon_kernels;
+#endif
+
+  return &generic_kernels;
+}
+
+const convert_kernels_t &convert_get_kernels()
+{
+  static const convert_kernels_t *kernels = select_kernels();
+
+  return *kernels;
+}
+
+std::vector< const convert_kernels_t * > convert_supported_kernels()
+{
+  std::vector< const convert_kernels_t * > kernels( 1, &generic_kernels );
+
+#if defined(CONVERT_X86_DISPATCH)
+  __builtin_cpu_init();
+
+  if ( __builtin_cpu_supports("sse2") )
+    kernels.push_back( &sse2_kernels );
+
+  if ( __builtin_cpu_supports("avx2") )
+    kernels.push_back( &avx2_kernels );
+
+  if ( __builtin_cpu_supports("avx512f") )
+    kernels.push_back( &avx512_kernels );
+#elif defined(CONVERT_X86_STATIC)
+  kernels.push_back( &sse2_kernels );
+#if defined(__AVX2__)
+  kernels.push_back( &avx2_kernels );
+#endif
+#elif defined(CONVERT_NEON)
+  kernels.push_back( &neon_kernels );
+#endif
+
+  return kernels;
+}
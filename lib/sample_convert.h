@@ -0,0 +1,212 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_SAMPLE_CONVERT_H
+#define OSMOSDR_SAMPLE_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gnuradio/gr_complex.h>
+
+/*!
+ * ADC level accumulated by the _lvl kernels as they convert: the sum of
+ * the squares of the converted I and Q values, how many there were and how
+ * many of them sat at full scale.
+ */
+struct convert_level_t
+{
+  convert_level_t() : power(0), values(0), clipped(0) {}
+
+  double power;
+  uint64_t values;
+  uint64_t clipped;
+};
+
+/*!
+ * Set of sample conversion kernels for one instruction set.
+ *
+ * All kernels work on individual I or Q values (\p nvalues is twice the
+ * number of complex samples), so they can be used for real streams too.
+ */
+struct convert_kernels_t
+{
+  const char *name;
+
+  /* unsigned 8 bit, centered at 127.4 (rtl, rtl_tcp) */
+  void (*u8_f32)( const uint8_t *in, float *out, size_t nvalues );
+  /* signed 8 bit (hackrf) */
+  void (*s8_f32)( const int8_t *in, float *out, size_t nvalues );
+  /* signed 16 bit, multiplied by scale (miri) */
+  void (*s16_f32)( const int16_t *in, float *out, size_t nvalues, float scale );
+
+  /* float to signed 16/8 bit, multiplied by scale, rounded and saturated */
+  void (*f32_s16)( const float *in, int16_t *out, size_t nvalues, float scale );
+  void (*f32_s8)( const float *in, int8_t *out, size_t nvalues, float scale );
+  /* unsigned 8 bit to signed 8 bit, centered at 128 */
+  void (*u8_s8)( const uint8_t *in, int8_t *out, size_t nvalues );
+
+  /* signed 16 bit of nchan interleaved channels, split up into one
+   * buffer per channel while converting (bladerf MIMO), nitems complex
+   * samples per channel */
+  void (*s16_f32_deint)( const int16_t *in, float *const *out, size_t nchan,
+                         size_t nitems, float scale );
+
+  /* packed little endian signed 24 bit, otherwise like s16_f32_deint
+   * (rfspace 24 bit mode) */
+  void (*s24_f32_deint)( const uint8_t *in, float *const *out, size_t nchan,
+                         size_t nitems, float scale );
+
+  /* I and Q in separate arrays into interleaved floats (sdrplay) */
+  void (*s16_f32_split)( const int16_t *in_i, const int16_t *in_q, float *out,
+                         size_t nitems, float scale );
+
+  /* one buffer of complex floats per channel into signed 16 bit with the
+   * nchan channels interleaved, otherwise like f32_s16 (bladerf MIMO TX),
+   * nitems complex samples per channel */
+  void (*f32_s16_intl)( const float *const *in, int16_t *out, size_t nchan,
+                        size_t nitems, float scale );
+
+  /* like u8_f32, s8_f32 and s16_f32, adding what they convert to *level.
+   * The 8 bit ones count the lowest and the highest code as clipped, s16
+   * every value at least clip (> 0) in magnitude */
+  void (*u8_f32_lvl)( const uint8_t *in, float *out, size_t nvalues,
+                      convert_level_t *level );
+  void (*s8_f32_lvl)( const int8_t *in, float *out, size_t nvalues,
+                      convert_level_t *level );
+  void (*s16_f32_lvl)( const int16_t *in, float *out, size_t nvalues, float scale,
+                       int16_t clip, convert_level_t *level );
+
+  /* like s16_f32_deint and s16_f32_split, level[nchan] for deint */
+  void (*s16_f32_deint_lvl)( const int16_t *in, float *const *out, size_t nchan,
+                             size_t nitems, float scale, int16_t clip,
+                             convert_level_t *level );
+  void (*s16_f32_split_lvl)( const int16_t *in_i, const int16_t *in_q, float *out,
+                             size_t nitems, float scale, int16_t clip,
+                             convert_level_t *level );
+};
+
+/*!
+ * Get the fastest set of kernels supported by the CPU we are running on.
+ * The selection is made once on first use.
+ */
+const convert_kernels_t &convert_get_kernels();
+
+/*!
+ * Every set of kernels the CPU supports, generic first and the one
+ * convert_get_kernels() picks last. Meant for benchmarks and tests.
+ */
+std::vector< const convert_kernels_t * > convert_supported_kernels();
+
+inline void convert_u8_fc32( const uint8_t *in, gr_complex *out, size_t nitems )
+{
+  convert_get_kernels().u8_f32( in, (float *)out, nitems * 2 );
+}
+
+inline void convert_s8_fc32( const int8_t *in, gr_complex *out, size_t nitems )
+{
+  convert_get_kernels().s8_f32( in, (float *)out, nitems * 2 );
+}
+
+inline void convert_s16_fc32( const int16_t *in, gr_complex *out, size_t nitems,
+                              float scale )
+{
+  convert_get_kernels().s16_f32( in, (float *)out, nitems * 2, scale );
+}
+
+inline void convert_s16_fc32_deinterleave( const int16_t *in, gr_complex *const *out,
+                                           size_t nchan, size_t nitems, float scale )
+{
+  convert_get_kernels().s16_f32_deint( in, (float *const *)out, nchan, nitems, scale );
+}
+
+inline void convert_s24_fc32_deinterleave( const uint8_t *in, gr_complex *const *out,
+                                           size_t nchan, size_t nitems, float scale )
+{
+  convert_get_kernels().s24_f32_deint( in, (float *const *)out, nchan, nitems, scale );
+}
+
+inline void convert_s16_split_fc32( const int16_t *in_i, const int16_t *in_q, gr_complex *out,
+                                   size_t nitems, float scale )
+{
+  convert_get_kernels().s16_f32_split( in_i, in_q, (float *)out, nitems, scale );
+}
+
+inline void convert_u8_fc32_level( const uint8_t *in, gr_complex *out, size_t nitems,
+                                  convert_level_t *level )
+{
+  convert_get_kernels().u8_f32_lvl( in, (float *)out, nitems * 2, level );
+}
+
+inline void convert_s8_fc32_level( const int8_t *in, gr_complex *out, size_t nitems,
+                                  convert_level_t *level )
+{
+  convert_get_kernels().s8_f32_lvl( in, (float *)out, nitems * 2, level );
+}
+
+inline void convert_s16_fc32_level( const int16_t *in, gr_complex *out, size_t nitems,
+                                    float scale, int16_t clip, convert_level_t *level )
+{
+  convert_get_kernels().s16_f32_lvl( in, (float *)out, nitems * 2, scale, clip, level );
+}
+
+inline void convert_s16_fc32_deinterleave_level( const int16_t *in, gr_complex *const *out,
+                                                 size_t nchan, size_t nitems, float scale,
+                                                 int16_t clip, convert_level_t *level )
+{
+  convert_get_kernels().s16_f32_deint_lvl( in, (float *const *)out, nchan, nitems,
+                                           scale, clip, level );
+}
+
+inline void convert_s16_split_fc32_level( const int16_t *in_i, const int16_t *in_q, gr_complex *out,
+                                         size_t nitems, float scale, int16_t clip,
+                                         convert_level_t *level )
+{
+  convert_get_kernels().s16_f32_split_lvl( in_i, in_q, (float *)out, nitems,
+                                           scale, clip, level );
+}
+
+/* full scale of the integer sample types, +/-1.0 in gr_complex */
+#define CONVERT_SC16_SCALE  32767.0f
+#define CONVERT_SC8_SCALE   127.0f
+
+inline void convert_fc32_sc16( const gr_complex *in, int16_t *out, size_t nitems )
+{
+  convert_get_kernels().f32_s16( (const float *)in, out, nitems * 2, CONVERT_SC16_SCALE );
+}
+
+inline void convert_fc32_s16_interleave( const gr_complex *const *in, int16_t *out,
+                                         size_t nchan, size_t nitems, float scale )
+{
+  convert_get_kernels().f32_s16_intl( (const float *const *)in, out, nchan, nitems, scale );
+}
+
+inline void convert_fc32_sc8( const gr_complex *in, int8_t *out, size_t nitems )
+{
+  convert_get_kernels().f32_s8( (const float *)in, out, nitems * 2, CONVERT_SC8_SCALE );
+}
+
+inline void convert_u8_sc8( const uint8_t *in, int8_t *out, size_t nitems )
+{
+  convert_get_kernels().u8_s8( in, out, nitems * 2 );
+}
+
+#endif // OSMOSDR_SAMPLE_CONVERT_H
@@ -36,6 +36,8 @@
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
@@ -44,6 +46,7 @@
 #include <mirsdrapi-rsp.h>
 
 #include "arg_helpers.h"
+#include "sample_convert.h"
 
 #define MAX_SUPPORTED_DEVICES   4
 
@@ -77,7 +80,9 @@ using namespace boost::assign;
 #define SDRPLAY_L_MIN     1450e6
 #define SDRPLAY_L_MAX     1675e6
 
-#define SDRPLAY_MAX_BUF_SIZE 504
+#define SDRPLAY_RING_SIZE  (1 << 21) // samples, ~175 ms at 12 Msps
+#define SDRPLAY_SCALE      (1.0f/2048.0f)
+#define SDRPLAY_CLIP       2047         // full scale of the 12 bit ADC
 
 /*
  * Create a new instance of sdrplay_source_c and return
@@ -128,13 +133,18 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
    _dev->gRdB = 60;
    set_gain_limits(_dev->rfHz);
    _dev->gain_dB = _dev->maxGain - _dev->gRdB;
-   
-   _bufi.reserve(SDRPLAY_MAX_BUF_SIZE);
-   _bufq.reserve(SDRPLAY_MAX_BUF_SIZE);   
 
-   _buf_mutex.lock();
-   _buf_offset = 0;
-   _buf_mutex.unlock();
+   dict_t dict = params_to_dict(args);
+
+   _ring.resize(SDRPLAY_RING_SIZE);
+   _sched = thread_sched_once(thread_sched_from_dict(dict));
+
+   double level_period = level_meter::period_from_dict(dict);
+   if (level_period > 0)
+   {
+      _level.attach(this, level_period);
+      _level.set_sample_rate(_dev->fsHz);
+   }
 }
 
 /*
@@ -142,40 +152,158 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
  */
 sdrplay_source_c::~sdrplay_source_c ()
 {
+   _uninit = true;
+   stop();
+
    free(_dev);
    _dev = NULL;
-   _buf_mutex.lock();
+}
+
+bool sdrplay_source_c::start()
+{
+   std::lock_guard<std::mutex> lock(_dev_mutex);
+
    if (_running)
    {
-      _running = false;
+      return true;
    }
-   _uninit = true;
-   _buf_mutex.unlock();
+
+   _ring.reset();
+   _latency_stats.reset();
+   _sched.reset();
+
+   int gRdBsystem = 0;
+   mir_sdr_ErrT err = mir_sdr_StreamInit(&_dev->gRdB, _dev->fsHz / 1e6, _dev->rfHz / 1e6,
+                                         _dev->bwType, _dev->ifType, 0, &gRdBsystem,
+                                         mir_sdr_USE_SET_GR, &_dev->samplesPerPacket,
+                                         stream_callback, gain_callback, (void *)this);
+   if (err != mir_sdr_Success)
+   {
+      std::cerr << "Failed to start RX streaming (" << err << ")" << std::endl;
+      return false;
+   }
+
+   if (_dev->dcMode)
+   {
+      mir_sdr_SetDcMode(4, 1);
+   }
+
+   _running = true;
+
+   return true;
 }
 
-void sdrplay_source_c::reinit_device()
+bool sdrplay_source_c::stop()
 {
-   std::cerr << "reinit_device started" << std::endl;
-   _buf_mutex.lock();
-   std::cerr << "after mutex.lock" << std::endl;
+   std::lock_guard<std::mutex> lock(_dev_mutex);
+
    if (_running)
    {
-      std::cerr << "mir_sdr_Uninit started" << std::endl;
-      mir_sdr_Uninit();
+      mir_sdr_StreamUninit();
+      _running = false;
    }
 
-   std::cerr << "mir_sdr_Init started" << std::endl;
-   mir_sdr_Init(_dev->gRdB, _dev->fsHz / 1e6, _dev->rfHz / 1e6, _dev->bwType, _dev->ifType, &_dev->samplesPerPacket);
+   /* release work() if it is waiting for samples */
+   _ring.close();
+
+   return true;
+}
+
+/* Called by the library from its own thread for every packet. The samples
+ * are converted right away, so the ring decouples work() from it. */
+void sdrplay_source_c::stream_callback(short *xi, short *xq, unsigned int firstSampleNum,
+                                       int grChanged, int rfChanged, int fsChanged,
+                                       unsigned int numSamples, unsigned int reset,
+                                       unsigned int hwRemoved, void *cbContext)
+{
+   sdrplay_source_c *obj = (sdrplay_source_c *)cbContext;
+
+   obj->_sched.apply();
+
+   if (hwRemoved)
+   {
+      std::cerr << "SDRplay device removed" << std::endl;
+      obj->_ring.close();
+      return;
+   }
+
+   obj->stream_data(xi, xq, numSamples);
+}
+
+void sdrplay_source_c::gain_callback(unsigned int gRdB, unsigned int lnaGRdB, void *cbContext)
+{
+}
+
+void sdrplay_source_c::stream_data(const short *xi, const short *xq, unsigned int numSamples)
+{
+   size_t done = 0;
+   convert_level_t level;
+
+   _latency_stats.arrival(_ring.write_count());
+
+   /* the free space may wrap around the end of the ring */
+   for (int i = 0; i < 2 && done < numSamples; i++)
+   {
+      size_t count = 0;
+      gr_complex *dst = _ring.write_ptr(count);
+
+      count = std::min(count, size_t(numSamples - done));
+      if (!count)
+      {
+         break;
+      }
+
+      if (_level.enabled())
+      {
+         convert_s16_split_fc32_level(xi + done, xq + done, dst, count, SDRPLAY_SCALE,
+                                      SDRPLAY_CLIP, &level);
+      }
+      else
+      {
+         convert_s16_split_fc32(xi + done, xq + done, dst, count, SDRPLAY_SCALE);
+      }
+      _ring.commit(count);
+      done += count;
+   }
+
+   if (level.values)
+   {
+      _level.add(0, level);
+   }
+
+   if (done < numSamples)
+   {
+      _stats.overrun( numSamples - done );
+      std::cerr << "O" << std::flush;
+   }
+}
+
+/* Apply bandwidth and larger rate or frequency changes without stopping
+ * the stream. Otherwise they are picked up by the next start(). */
+void sdrplay_source_c::reinit_device(int reason)
+{
+   std::lock_guard<std::mutex> lock(_dev_mutex);
+
+   if (!_running)
+   {
+      return;
+   }
+
+   int gRdBsystem = 0;
+   mir_sdr_ErrT err = mir_sdr_Reinit(&_dev->gRdB, _dev->fsHz / 1e6, _dev->rfHz / 1e6,
+                                     _dev->bwType, _dev->ifType, mir_sdr_LO_Auto, 0,
+                                     &gRdBsystem, mir_sdr_USE_SET_GR,
+                                     &_dev->samplesPerPacket,
+                                     (mir_sdr_ReasonForReinitT)reason);
+   if (err != mir_sdr_Success)
+   {
+      std::cerr << "mir_sdr_Reinit failed (" << err << ")" << std::endl;
+   }
 
    if (_dev->dcMode)
    {
-      std::cerr << "mir_sdr_SetDcMode started" << std::endl;
       mir_sdr_SetDcMode(4, 1);
    }
-
-   _buf_offset = 0;
-   _buf_mutex.unlock();
-   std::cerr << "reinit_device end" << std::endl;
 }
 
 void sdrplay_source_c::set_gain_limits(double freq)
@@ -212,57 +340,32 @@ int sdrplay_source_c::work( int noutput_items,
                             gr_vector_void_star &output_items )
 {
    gr_complex *out = (gr_complex *)output_items[0];
-   int cnt = noutput_items;
-   unsigned int sampNum;
-   int grChanged;
-   int rfChanged;
-   int fsChanged;
 
    if (_uninit)
    {
       return WORK_DONE;
    }
 
-   if (!_running)
+   /* wait for the stream callback, but take whatever it has by then */
+   while (!_ring.wait_for(1, std::chrono::milliseconds(100)))
    {
-      reinit_device();
-      _running = true;
-   }
-
-   _buf_mutex.lock();
-
-   if (_buf_offset)
-   {
-      for (int i = _buf_offset; i < _dev->samplesPerPacket; i++)
+      if (!_running)
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         return WORK_DONE;
       }
-      cnt -= (_dev->samplesPerPacket - _buf_offset);
    }
 
-   while ((cnt - _dev->samplesPerPacket) >= 0)
+   size_t nitems = std::min(size_t(noutput_items), _ring.size());
+   if (!nitems)
    {
-      mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
-      for (int i = 0; i < _dev->samplesPerPacket; i++)
-      {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
-      }
-      cnt -= _dev->samplesPerPacket;
+      return WORK_DONE; /* closed by stop() or a removed device */
    }
 
-   _buf_offset = 0;
-   if (cnt)
-   {
-      mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
-      for (int i = 0; i < cnt; i++)
-      {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
-      }
-      _buf_offset = cnt;
-   }
-   _buf_mutex.unlock();
+   _ring.pop(out, nitems);
+   _latency_stats.consumed(_ring.read_count(), _ring.size());
+   _stats.produced( nitems );
 
-   return noutput_items;
+   return nitems;
 }
 
 std::vector<std::string> sdrplay_source_c::get_devices()
@@ -312,6 +415,7 @@ double sdrplay_source_c::set_sample_rate(double rate)
    std::cerr << "set_sample_rate start" << std::endl;
    double diff = rate - _dev->fsHz;
    _dev->fsHz = rate;
+   _level.set_sample_rate(rate);
 
    std::cerr << "rate = " << rate << std::endl;
    std::cerr << "diff = " << diff << std::endl;
@@ -325,7 +429,7 @@ double sdrplay_source_c::set_sample_rate(double rate)
       else
       {
          std::cerr << "reinit_device started" << std::endl;
-         reinit_device();
+         reinit_device(mir_sdr_CHANGE_FS_FREQ);
       }
    }
    std::cerr << "set_sample_rate end" << std::endl;
@@ -375,7 +479,7 @@ double sdrplay_source_c::set_center_freq( double freq, size_t chan )
       else
       {
          std::cerr << "reinit_device started" << std::endl;
-         reinit_device();
+         reinit_device(mir_sdr_CHANGE_RF_FREQ);
       }
    }
 
@@ -562,7 +666,7 @@ double sdrplay_source_c::set_bandwidth( double bandwidth, size_t chan )
 
    if (_running) 
    {
-      reinit_device();
+      reinit_device(mir_sdr_CHANGE_BW_TYPE);
    }
 
    return get_bandwidth( chan );
@@ -598,3 +702,18 @@ osmosdr::freq_range_t sdrplay_source_c::get_bandwidth_range( size_t chan )
 
    return range;
 }
+
+osmosdr::stream_stats_t sdrplay_source_c::get_stream_stats( size_t chan )
+{
+   osmosdr::stream_stats_t stats;
+
+   _stats.get_stats( stats );
+
+   stats.fill = _ring.size();
+   stats.fill_max = _ring.fill_max();
+   stats.capacity = _ring.capacity();
+   _latency_stats.get_stats(stats);
+   _level.get_stats(chan, stats);
+
+   return stats;
+}
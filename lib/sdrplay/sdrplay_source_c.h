@@ -30,7 +30,12 @@
 
 #include "osmosdr/ranges.h"
 
+#include "latency_stats.h"
+#include "level_meter.h"
 #include "source_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+#include "stream_counters.h"
 
 class sdrplay_source_c;
 typedef struct sdrplay_dev sdrplay_dev_t;
@@ -79,6 +84,9 @@ private:
 public:
    ~sdrplay_source_c ();	// public destructor
 
+   bool start();
+   bool stop();
+
    int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -113,21 +121,33 @@ public:
 
    void set_dc_offset_mode( int mode, size_t chan = 0 );
    void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 );
+   bool has_dc_offset_correction( size_t chan = 0 ) { return true; }
 
    double set_bandwidth( double bandwidth, size_t chan = 0 );
    double get_bandwidth( size_t chan = 0 );
    osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+   osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
-   void reinit_device(void);
+   static void stream_callback(short *xi, short *xq, unsigned int firstSampleNum,
+                               int grChanged, int rfChanged, int fsChanged,
+                               unsigned int numSamples, unsigned int reset,
+                               unsigned int hwRemoved, void *cbContext);
+   static void gain_callback(unsigned int gRdB, unsigned int lnaGRdB, void *cbContext);
+   void stream_data(const short *xi, const short *xq, unsigned int numSamples);
+
+   void reinit_device(int reason);
    void set_gain_limits(double freq);
 
    sdrplay_dev_t *_dev;
 
-   std::vector< short > _bufi;
-   std::vector< short > _bufq;
-   int _buf_offset;
-   std::mutex _buf_mutex;
+   spsc_ring< gr_complex > _ring;
+   thread_sched_once _sched;
+   stream_counters _stats;
+   latency_stats _latency_stats;
+   level_meter _level;
+   std::mutex _dev_mutex;
 
    bool _running;
    bool _uninit;
@@ -0,0 +1,483 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shm_ring.h"
+
+#define SHM_MAGIC   0x6f736d72    // "osmr"
+#define SHM_VERSION 1
+#define SHM_PREFIX  "osmosdr-"
+#define PAGE_SIZE_  4096
+
+static_assert( ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+               "the shared counters must not need a lock" );
+
+static int futex_wait( std::atomic<uint32_t> *word, uint32_t val, int timeout_ms )
+{
+  struct timespec ts;
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = ( timeout_ms % 1000 ) * 1000000L;
+
+  return syscall( SYS_futex, (uint32_t *)word, FUTEX_WAIT, val, &ts, NULL, 0 );
+}
+
+static void futex_wake( std::atomic<uint32_t> *word )
+{
+  syscall( SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+}
+
+static bool process_alive( uint32_t pid )
+{
+  return 0 == kill( pid_t( pid ), 0 ) || EPERM == errno;
+}
+
+shm_ring::shm_ring() :
+  _hdr(NULL),
+  _data(NULL),
+  _size(0),
+  _item_size(0),
+  _writer(false),
+  _slot(-1),
+  _tag_read(0)
+{
+}
+
+shm_ring::~shm_ring()
+{
+  close();
+}
+
+std::string shm_ring::segment_name( const std::string &name )
+{
+  return "/" SHM_PREFIX + name;
+}
+
+std::vector< std::string > shm_ring::list()
+{
+  std::vector< std::string > names;
+  const std::string prefix = SHM_PREFIX;
+
+  DIR *dir = opendir( "/dev/shm" );
+  if ( ! dir )
+    return names;
+
+  while ( struct dirent *entry = readdir( dir ) ) {
+    const std::string file = entry->d_name;
+
+    if ( file.size() > prefix.size() && 0 == file.compare( 0, prefix.size(), prefix ) )
+      names.push_back( file.substr( prefix.size() ) );
+  }
+  closedir( dir );
+
+  std::sort( names.begin(), names.end() );
+
+  return names;
+}
+
+size_t shm_ring::data_offset() const
+{
+  return ( sizeof(shm_header_t) + PAGE_SIZE_ - 1 ) / PAGE_SIZE_ * PAGE_SIZE_;
+}
+
+void shm_ring::map( int fd, size_t size )
+{
+  void *addr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  ::close( fd );
+
+  if ( MAP_FAILED == addr )
+    throw std::runtime_error( std::string( "Failed to map the shared memory: " ) +
+                              strerror( errno ) );
+
+  _hdr = (shm_header_t *)addr;
+  _data = (char *)addr + data_offset();
+  _size = size;
+}
+
+void shm_ring::create( const std::string &name, size_t capacity, size_t item_size )
+{
+  close();
+
+  size_t items = 1;
+  while ( items < capacity )
+    items <<= 1;
+
+  const std::string segment = segment_name( name );
+  const size_t size = data_offset() + items * item_size;
+
+  int fd = shm_open( segment.c_str(), O_RDWR | O_CREAT, 0666 );
+  if ( fd < 0 )
+    throw std::runtime_error( "Failed to create shared memory " + segment + ": " +
+                              strerror( errno ) );
+
+  struct stat st;
+  bool reuse = 0 == fstat( fd, &st ) && size_t( st.st_size ) == size;
+
+  if ( ! reuse && ftruncate( fd, size ) < 0 ) {
+    ::close( fd );
+    throw std::runtime_error( "Failed to size shared memory " + segment + ": " +
+                              strerror( errno ) );
+  }
+
+  map( fd, size );
+  _item_size = item_size;
+  _writer = true;
+
+  reuse = reuse && SHM_MAGIC == _hdr->magic.load() &&
+          SHM_VERSION == _hdr->version && items == _hdr->capacity &&
+          item_size == _hdr->item_size;
+
+  if ( reuse ) {
+    const uint32_t pid = _hdr->writer_pid.load();
+    if ( pid && pid != uint32_t( getpid() ) && process_alive( pid ) ) {
+      close();
+      throw std::runtime_error( "Shared memory " + segment + " already has a writer." );
+    }
+
+    /* what a writer that died halfway through left behind is lost */
+    _hdr->write_claim.store( _hdr->write_count.load() );
+  } else {
+    _hdr->magic.store( 0 );
+    memset( (void *)_hdr, 0, data_offset() );
+
+    _hdr->version = SHM_VERSION;
+    _hdr->item_size = item_size;
+    _hdr->capacity = items;
+    _hdr->magic.store( SHM_MAGIC );
+  }
+
+  _hdr->writer_pid.store( getpid() );
+}
+
+void shm_ring::open( const std::string &name, size_t item_size )
+{
+  close();
+
+  const std::string segment = segment_name( name );
+
+  int fd = shm_open( segment.c_str(), O_RDWR, 0 );
+  if ( fd < 0 )
+    throw std::runtime_error( "Failed to open shared memory " + segment + ": " +
+                              strerror( errno ) + ", is the sink running?" );
+
+  struct stat st;
+  if ( fstat( fd, &st ) < 0 || size_t( st.st_size ) < data_offset() ) {
+    ::close( fd );
+    throw std::runtime_error( "Shared memory " + segment + " isn't set up." );
+  }
+
+  map( fd, st.st_size );
+  _item_size = item_size;
+  _writer = false;
+
+  if ( SHM_MAGIC != _hdr->magic.load() || SHM_VERSION != _hdr->version ||
+       item_size != _hdr->item_size ||
+       data_offset() + _hdr->capacity * item_size != _size ) {
+    close();
+    throw std::runtime_error( "Shared memory " + segment + " isn't an osmosdr ring." );
+  }
+}
+
+void shm_ring::close()
+{
+  if ( ! _hdr )
+    return;
+
+  if ( _writer ) {
+    _hdr->writer_pid.store( 0 );
+    _hdr->data_seq++;
+    futex_wake( &_hdr->data_seq );
+  } else {
+    detach();
+  }
+
+  munmap( (void *)_hdr, _size );
+  _hdr = NULL;
+  _data = NULL;
+  _size = 0;
+}
+
+size_t shm_ring::space()
+{
+  const uint64_t written = _hdr->write_count.load();
+  uint64_t slowest = written;
+
+  for ( shm_reader_t &reader : _hdr->readers ) {
+    uint32_t pid = reader.pid.load();
+    if ( ! pid )
+      continue;
+
+    /* a reader that went away without detaching would block us forever */
+    if ( ! process_alive( pid ) ) {
+      reader.pid.compare_exchange_strong( pid, 0 );
+      continue;
+    }
+
+    slowest = std::min( slowest, reader.read_count.load() );
+  }
+
+  return _hdr->capacity - std::min< uint64_t >( _hdr->capacity, written - slowest );
+}
+
+bool shm_ring::wait_space( int timeout_ms )
+{
+  _hdr->space_waiters++;
+  const uint32_t seq = _hdr->space_seq.load();
+  const bool ready = space() > 0;
+
+  if ( ! ready )
+    futex_wait( &_hdr->space_seq, seq, timeout_ms );
+  _hdr->space_waiters--;
+
+  return ready || space() > 0;
+}
+
+void shm_ring::copy_in( uint64_t pos, const void *items, size_t nitems )
+{
+  const size_t first = pos & ( _hdr->capacity - 1 );
+  const size_t n = std::min< size_t >( nitems, _hdr->capacity - first );
+
+  memcpy( _data + first * _item_size, items, n * _item_size );
+  memcpy( _data, (const char *)items + n * _item_size, ( nitems - n ) * _item_size );
+}
+
+void shm_ring::copy_out( uint64_t pos, void *out, size_t nitems ) const
+{
+  const size_t first = pos & ( _hdr->capacity - 1 );
+  const size_t n = std::min< size_t >( nitems, _hdr->capacity - first );
+
+  memcpy( out, _data + first * _item_size, n * _item_size );
+  memcpy( (char *)out + n * _item_size, _data, ( nitems - n ) * _item_size );
+}
+
+void shm_ring::write( const void *items, size_t nitems )
+{
+  const uint64_t pos = _hdr->write_count.load( std::memory_order_relaxed );
+
+  /* larger writes would overwrite their own beginning */
+  if ( nitems > _hdr->capacity ) {
+    items = (const char *)items + ( nitems - _hdr->capacity ) * _item_size;
+    _hdr->write_claim.store( pos + nitems - _hdr->capacity );
+    _hdr->write_count.store( pos + nitems - _hdr->capacity );
+    write( items, _hdr->capacity );
+    return;
+  }
+
+  _hdr->write_claim.store( pos + nitems, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_release );
+
+  copy_in( pos, items, nitems );
+
+  _hdr->write_count.store( pos + nitems, std::memory_order_release );
+
+  _hdr->data_seq++;
+  if ( _hdr->data_waiters.load() )
+    futex_wake( &_hdr->data_seq );
+}
+
+bool shm_ring::write_tag( uint64_t pos, const pmt::pmt_t &key, const pmt::pmt_t &value )
+{
+  const std::string k = pmt::symbol_to_string( key );
+  const std::string v = pmt::serialize_str( value );
+
+  if ( k.size() + v.size() > SHM_TAG_DATA )
+    return false;
+
+  const uint64_t count = _hdr->tag_count.load( std::memory_order_relaxed );
+  shm_tag_t &tag = _hdr->tags[ count % SHM_TAG_SLOTS ];
+
+  _hdr->tag_claim.store( count + 1, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_release );
+
+  tag.pos = pos;
+  tag.key_len = k.size();
+  tag.value_len = v.size();
+  memcpy( tag.data, k.data(), k.size() );
+  memcpy( tag.data + k.size(), v.data(), v.size() );
+
+  _hdr->tag_count.store( count + 1, std::memory_order_release );
+
+  return true;
+}
+
+void shm_ring::set_meta( double rate, double freq )
+{
+  _hdr->rate.store( rate );
+  _hdr->freq.store( freq );
+  _hdr->meta_seq++;
+}
+
+void shm_ring::attach()
+{
+  detach();
+
+  const uint32_t self = getpid();
+
+  for ( int pass = 0; pass < 2 && _slot < 0; pass++ ) {
+    for ( int i = 0; i < SHM_MAX_READERS; i++ ) {
+      shm_reader_t &reader = _hdr->readers[i];
+      uint32_t pid = reader.pid.load();
+
+      /* on the second pass take the slots of readers that went away */
+      if ( pid && ( 0 == pass || process_alive( pid ) ) )
+        continue;
+
+      if ( reader.pid.compare_exchange_strong( pid, self ) ) {
+        _slot = i;
+        break;
+      }
+    }
+  }
+
+  if ( _slot < 0 )
+    throw std::runtime_error( "All reader slots of the shared memory are taken." );
+
+  _hdr->readers[ _slot ].read_count.store( _hdr->write_count.load() );
+  _tag_read = _hdr->tag_count.load();
+}
+
+void shm_ring::detach()
+{
+  if ( _slot < 0 )
+    return;
+
+  _hdr->readers[ _slot ].pid.store( 0 );
+  _slot = -1;
+
+  /* the writer may be waiting for us */
+  _hdr->space_seq++;
+  if ( _hdr->space_waiters.load() )
+    futex_wake( &_hdr->space_seq );
+}
+
+bool shm_ring::wait_data( int timeout_ms )
+{
+  shm_reader_t &reader = _hdr->readers[ _slot ];
+
+  _hdr->data_waiters++;
+  const uint32_t seq = _hdr->data_seq.load();
+  const bool ready = _hdr->write_count.load() != reader.read_count.load();
+
+  if ( ! ready )
+    futex_wait( &_hdr->data_seq, seq, timeout_ms );
+  _hdr->data_waiters--;
+
+  return ready || _hdr->write_count.load() != reader.read_count.load();
+}
+
+size_t shm_ring::read( void *out, size_t nitems, uint64_t &pos, uint64_t &lost )
+{
+  shm_reader_t &reader = _hdr->readers[ _slot ];
+  const uint64_t cap = _hdr->capacity;
+  uint64_t r = reader.read_count.load( std::memory_order_relaxed );
+  size_t n = 0;
+
+  while ( true ) {
+    const uint64_t w = _hdr->write_count.load( std::memory_order_acquire );
+
+    if ( w - r > cap ) {
+      lost += w - r - cap;
+      r = w - cap;
+    }
+
+    n = std::min< uint64_t >( nitems, w - r );
+    copy_out( r, out, n );
+
+    /* what the writer started on meanwhile overwrote the oldest items */
+    std::atomic_thread_fence( std::memory_order_acquire );
+    const uint64_t claim = _hdr->write_claim.load( std::memory_order_relaxed );
+    if ( claim - r <= cap )
+      break;
+
+    lost += claim - cap - r;
+    r = claim - cap;
+  }
+
+  pos = r;
+  reader.read_count.store( r + n, std::memory_order_release );
+
+  _hdr->space_seq++;
+  if ( _hdr->space_waiters.load() )
+    futex_wake( &_hdr->space_seq );
+
+  return n;
+}
+
+void shm_ring::read_tags( uint64_t begin, uint64_t end, std::vector< tag_t > &tags )
+{
+  tags.clear();
+
+  const uint64_t count = _hdr->tag_count.load( std::memory_order_acquire );
+  if ( count - _tag_read > SHM_TAG_SLOTS )
+    _tag_read = count - SHM_TAG_SLOTS;
+
+  while ( _tag_read < count ) {
+    shm_tag_t tag;
+    memcpy( &tag, &_hdr->tags[ _tag_read % SHM_TAG_SLOTS ], sizeof(tag) );
+
+    /* overwritten while we copied it */
+    std::atomic_thread_fence( std::memory_order_acquire );
+    if ( _hdr->tag_claim.load( std::memory_order_relaxed ) > _tag_read + SHM_TAG_SLOTS ) {
+      _tag_read++;
+      continue;
+    }
+
+    if ( tag.pos >= end )
+      break;
+
+    _tag_read++;
+
+    /* of items the reader lost */
+    if ( tag.pos < begin || tag.key_len + tag.value_len > SHM_TAG_DATA )
+      continue;
+
+    tag_t t;
+    t.pos = tag.pos;
+    t.key = pmt::string_to_symbol( std::string( tag.data, tag.key_len ) );
+    t.value = pmt::deserialize_str( std::string( tag.data + tag.key_len, tag.value_len ) );
+    tags.push_back( t );
+  }
+}
+
+size_t shm_ring::fill() const
+{
+  if ( _slot < 0 )
+    return 0;
+
+  const uint64_t w = _hdr->write_count.load();
+  const uint64_t r = _hdr->readers[ _slot ].read_count.load();
+
+  return std::min< uint64_t >( _hdr->capacity, w - r );
+}
@@ -0,0 +1,182 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SHM_RING_H
+#define INCLUDED_SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <pmt/pmt.h>
+
+#define SHM_MAX_READERS 16
+#define SHM_TAG_SLOTS   1024
+#define SHM_TAG_DATA    496     // bytes for the key and the value of a tag
+
+/* a reader process, its slot is free while pid is 0 */
+struct shm_reader_t
+{
+  std::atomic<uint32_t> pid;
+  std::atomic<uint64_t> read_count;   // items consumed
+};
+
+/* a stream tag, the key symbol followed by the serialized value */
+struct shm_tag_t
+{
+  uint64_t pos;                       // of the item in the stream
+  uint32_t key_len;
+  uint32_t value_len;
+  char data[SHM_TAG_DATA];
+};
+
+/*!
+ * The start of the segment, the samples follow at data_offset().
+ *
+ * write_claim is raised before the writer overwrites anything and
+ * write_count once the items are complete, so a reader copying without
+ * a lock can tell afterwards if what it got was overwritten meanwhile.
+ * The tag ring is handled the same way. The *_seq words are bumped on
+ * every change and are what the other side sleeps on with a futex.
+ */
+struct shm_header_t
+{
+  std::atomic<uint32_t> magic;        // written last when set up
+  uint32_t version;
+  uint32_t item_size;
+  uint32_t reserved;
+  uint64_t capacity;                  // items, a power of two
+
+  std::atomic<uint32_t> writer_pid;   // 0 while no sink is attached
+
+  std::atomic<uint64_t> write_claim;
+  std::atomic<uint64_t> write_count;
+  std::atomic<uint32_t> data_seq;
+  std::atomic<uint32_t> data_waiters;
+  std::atomic<uint32_t> space_seq;
+  std::atomic<uint32_t> space_waiters;
+
+  std::atomic<uint32_t> meta_seq;     // bumped when rate or freq change
+  std::atomic<double> rate;
+  std::atomic<double> freq;
+
+  std::atomic<uint64_t> tag_claim;
+  std::atomic<uint64_t> tag_count;
+
+  shm_reader_t readers[SHM_MAX_READERS];
+  shm_tag_t tags[SHM_TAG_SLOTS];
+};
+
+/*!
+ * A ring of samples in POSIX shared memory, for one writing process and
+ * up to SHM_MAX_READERS reading ones, each with a cursor of its own.
+ *
+ * Neither side takes a lock. The writer doesn't wait for the readers
+ * unless asked to, a reader that falls behind by more than the ring
+ * holds loses the oldest samples. Sleeping is done with futexes on the
+ * shared sequence words, and only when the other side is known to wait
+ * does a change cost a system call.
+ *
+ * A writer coming back to a segment of the same size takes it over with
+ * the readers still attached, the stream just continues.
+ */
+class shm_ring
+{
+public:
+  struct tag_t
+  {
+    uint64_t pos;
+    pmt::pmt_t key;
+    pmt::pmt_t value;
+  };
+
+  shm_ring();
+  ~shm_ring();
+
+  /* shm=<name> as the name under /dev/shm */
+  static std::string segment_name( const std::string &name );
+
+  /* the names of the segments there are */
+  static std::vector< std::string > list();
+
+  /* as the writer, \p capacity items of \p item_size bytes */
+  void create( const std::string &name, size_t capacity, size_t item_size );
+
+  /* as a reader, of a segment the writer created */
+  void open( const std::string &name, size_t item_size );
+
+  void close();
+
+  size_t capacity() const { return _hdr ? _hdr->capacity : 0; }
+
+  /* writer */
+
+  /* room for that many items before the slowest reader is overwritten */
+  size_t space();
+  bool wait_space( int timeout_ms );
+
+  void write( const void *items, size_t nitems );
+  /* false for tags too large for a slot */
+  bool write_tag( uint64_t pos, const pmt::pmt_t &key, const pmt::pmt_t &value );
+  void set_meta( double rate, double freq );
+
+  uint64_t write_count() const { return _hdr->write_count.load(); }
+
+  /* reader */
+
+  /* take a reader slot, reading from the samples written next on */
+  void attach();
+  void detach();
+
+  bool wait_data( int timeout_ms );
+
+  /*!
+   * Copy up to \p nitems into \p out. \p pos gets the stream position
+   * of the first one, \p lost is increased by the items the reader lost
+   * to the writer before them.
+   */
+  size_t read( void *out, size_t nitems, uint64_t &pos, uint64_t &lost );
+
+  /* the tags of the items in [begin, end) the reader didn't get yet */
+  void read_tags( uint64_t begin, uint64_t end, std::vector< tag_t > &tags );
+
+  size_t fill() const;
+  double rate() const { return _hdr->rate.load(); }
+  double freq() const { return _hdr->freq.load(); }
+  uint32_t meta_seq() const { return _hdr->meta_seq.load(); }
+
+private:
+  void map( int fd, size_t size );
+  size_t data_offset() const;
+  void copy_in( uint64_t pos, const void *items, size_t nitems );
+  void copy_out( uint64_t pos, void *out, size_t nitems ) const;
+
+  shm_header_t *_hdr;
+  char *_data;
+  size_t _size;
+  size_t _item_size;
+  bool _writer;
+
+  int _slot;                  // of the reader, -1 while detached
+  uint64_t _tag_read;         // next tag the reader looks at
+};
+
+#endif /* INCLUDED_SHM_RING_H */
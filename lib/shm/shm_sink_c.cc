@@ -0,0 +1,279 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure.  It contains the results
+ * of probing for features, options etc.  It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <iostream>
+
+#include <sys/mman.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "shm_sink_c.h"
+#include "arg_helpers.h"
+
+#define DEFAULT_SIZE (1 << 22)  // samples, 32 MiB
+#define WAIT_MS      100
+
+shm_sink_c_sptr make_shm_sink_c (const std::string & args)
+{
+  return gnuradio::get_initial_sptr(new shm_sink_c (args));
+}
+
+static const int MIN_IN = 1;	// mininum number of input streams
+static const int MAX_IN = 1;	// maximum number of input streams
+static const int MIN_OUT = 0;	// minimum number of output streams
+static const int MAX_OUT = 0;	// maximum number of output streams
+
+shm_sink_c::shm_sink_c (const std::string &args)
+  : gr::sync_block ("shm_sink_c",
+        gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _block(false),
+    _unlink(false),
+    _running(false),
+    _rate(0),
+    _freq(0)
+{
+  dict_t dict = params_to_dict(args);
+
+  if ( ! dict.count("shm") || dict["shm"].empty() )
+    throw std::runtime_error("No shared memory name given, use shm=<name>.");
+
+  size_t size = DEFAULT_SIZE;
+  if ( dict.count("size") )
+    size = boost::lexical_cast< size_t >( dict["size"] );
+
+  /* wait for the slowest reader instead of overwriting what it missed */
+  if ( dict.count("block") )
+    _block = boost::lexical_cast< bool >( dict["block"] );
+
+  /* remove the segment when done, readers are left with what they mapped */
+  if ( dict.count("unlink") )
+    _unlink = boost::lexical_cast< bool >( dict["unlink"] );
+
+  _segment = shm_ring::segment_name( dict["shm"] );
+  _ring.create( dict["shm"], size, sizeof(gr_complex) );
+  _rate = _ring.rate();
+  _freq = _ring.freq();
+
+  std::cerr << "Using shared memory " << _segment << " of "
+            << _ring.capacity() << " samples." << std::endl;
+}
+
+shm_sink_c::~shm_sink_c ()
+{
+  _ring.close();
+
+  if ( _unlink )
+    shm_unlink( _segment.c_str() );
+}
+
+bool shm_sink_c::start()
+{
+  _running = true;
+
+  return true;
+}
+
+bool shm_sink_c::stop()
+{
+  _running = false;
+
+  return true;
+}
+
+int shm_sink_c::work( int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  size_t nitems = noutput_items;
+
+  if ( _block ) {
+    size_t space;
+
+    while ( 0 == ( space = _ring.space() ) ) {
+      if ( ! _running )
+        return WORK_DONE;
+
+      _ring.wait_space( WAIT_MS );
+    }
+
+    nitems = std::min( nitems, space );
+  }
+
+  /* the tags go first, a reader must have them once it sees their sample */
+  const uint64_t first = nitems_read(0);
+  const uint64_t pos = _ring.write_count();
+
+  get_tags_in_range( _tags, 0, first, first + nitems );
+  std::sort( _tags.begin(), _tags.end(), gr::tag_t::offset_compare );
+
+  for ( const gr::tag_t &tag : _tags ) {
+    if ( ! _ring.write_tag( pos + ( tag.offset - first ), tag.key, tag.value ) )
+      std::cerr << "Tag " << pmt::symbol_to_string( tag.key )
+                << " is too large for the shared memory, dropped." << std::endl;
+  }
+
+  _ring.write( in, nitems );
+  _stats.samples += nitems;
+
+  return nitems;
+}
+
+std::vector<std::string> shm_sink_c::get_devices()
+{
+  std::vector<std::string> devices;
+
+  devices.push_back( "shm=osmosdr,label='Shared Memory'" );
+
+  return devices;
+}
+
+size_t shm_sink_c::get_num_channels()
+{
+  return 1;
+}
+
+osmosdr::meta_range_t shm_sink_c::get_sample_rates()
+{
+  osmosdr::meta_range_t range;
+
+  range.push_back( osmosdr::range_t( 1, 1e9 ) );
+
+  return range;
+}
+
+/* only told to the readers, the samples are whatever comes in */
+double shm_sink_c::set_sample_rate( double rate )
+{
+  _rate = rate;
+  _ring.set_meta( _rate, _freq );
+
+  return get_sample_rate();
+}
+
+double shm_sink_c::get_sample_rate()
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t shm_sink_c::get_freq_range( size_t chan )
+{
+  osmosdr::freq_range_t range;
+
+  range.push_back( osmosdr::range_t( 0, 1e12 ) );
+
+  return range;
+}
+
+double shm_sink_c::set_center_freq( double freq, size_t chan )
+{
+  _freq = freq;
+  _ring.set_meta( _rate, _freq );
+
+  return get_center_freq( chan );
+}
+
+double shm_sink_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double shm_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double shm_sink_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> shm_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector<std::string>();
+}
+
+osmosdr::gain_range_t shm_sink_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t shm_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double shm_sink_c::set_gain( double gain, size_t chan )
+{
+  return get_gain( chan );
+}
+
+double shm_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double shm_sink_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double shm_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > shm_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string shm_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string shm_sink_c::get_antenna( size_t chan )
+{
+  return "SHM";
+}
+
+osmosdr::stream_stats_t shm_sink_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.capacity = _ring.capacity();
+  stats.fill = stats.capacity - _ring.space();
+
+  return stats;
+}
@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SHM_SINK_C_H
+#define INCLUDED_SHM_SINK_C_H
+
+#include <atomic>
+#include <vector>
+
+#include <gnuradio/sync_block.h>
+
+#include "sink_iface.h"
+#include "shm_ring.h"
+
+class shm_sink_c;
+
+typedef std::shared_ptr<shm_sink_c> shm_sink_c_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of shm_sink_c.
+ *
+ * To avoid accidental use of raw pointers, shm_sink_c's
+ * constructor is private.  make_shm_sink_c is the public
+ * interface for creating new instances.
+ */
+shm_sink_c_sptr make_shm_sink_c (const std::string & args = "");
+
+/*!
+ * \brief Hands the samples to shm= sources in other processes.
+ *
+ * work() copies the input into the shared ring along with its tags, the
+ * rate and frequency set here are what the sources report. By default
+ * a reader that is too slow loses samples, so a stuck process can't
+ * stall the acquisition. With block=1 the sink waits for the slowest
+ * reader instead.
+ * \ingroup block
+ */
+class shm_sink_c :
+    public gr::sync_block,
+    public sink_iface
+{
+private:
+  friend shm_sink_c_sptr make_shm_sink_c (const std::string & args);
+
+  shm_sink_c (const std::string & args);
+
+public:
+  ~shm_sink_c ();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices();
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+private:
+  shm_ring _ring;
+  std::string _segment;
+  bool _block;
+  bool _unlink;
+  std::atomic<bool> _running;
+  double _rate;
+  double _freq;
+  std::vector< gr::tag_t > _tags;
+
+  osmosdr::stream_stats_t _stats;
+};
+
+#endif /* INCLUDED_SHM_SINK_C_H */
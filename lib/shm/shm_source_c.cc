@@ -0,0 +1,256 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure.  It contains the results
+ * of probing for features, options etc.  It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <iostream>
+
+#include <gnuradio/io_signature.h>
+
+#include "shm_source_c.h"
+#include "arg_helpers.h"
+
+#define WAIT_MS 100     // before work() gives the scheduler a turn
+
+shm_source_c_sptr make_shm_source_c (const std::string & args)
+{
+  return gnuradio::get_initial_sptr(new shm_source_c (args));
+}
+
+static const int MIN_IN = 0;	// mininum number of input streams
+static const int MAX_IN = 0;	// maximum number of input streams
+static const int MIN_OUT = 1;	// minimum number of output streams
+static const int MAX_OUT = 1;	// maximum number of output streams
+
+shm_source_c::shm_source_c (const std::string &args)
+  : gr::sync_block ("shm_source_c",
+        gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _running(false),
+    _meta_seq(0),
+    _meta_tagged(false)
+{
+  dict_t dict = params_to_dict(args);
+
+  if ( ! dict.count("shm") || dict["shm"].empty() )
+    throw std::runtime_error("No shared memory name given, use shm=<name>.");
+
+  _ring.open( dict["shm"], sizeof(gr_complex) );
+  _id = pmt::string_to_symbol(args);
+
+  std::cerr << "Using shared memory " << shm_ring::segment_name( dict["shm"] )
+            << " of " << _ring.capacity() << " samples." << std::endl;
+}
+
+shm_source_c::~shm_source_c ()
+{
+}
+
+bool shm_source_c::start()
+{
+  /* from the samples written next on, like a device that was just started */
+  _ring.attach();
+  _meta_tagged = false;
+  _running = true;
+
+  return true;
+}
+
+bool shm_source_c::stop()
+{
+  _running = false;
+  _ring.detach();
+
+  return true;
+}
+
+int shm_source_c::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  if ( ! _running )
+    return WORK_DONE;
+
+  /* the sink may be gone for a while, e.g. restarting */
+  if ( ! _ring.wait_data( WAIT_MS ) )
+    return 0;
+
+  uint64_t pos, lost = 0;
+  const size_t produced = _ring.read( out, noutput_items, pos, lost );
+
+  if ( lost ) {
+    _stats.overruns++;
+    _stats.dropped += lost;
+    std::cerr << "O" << std::flush;
+  }
+
+  const uint64_t first = nitems_written(0);
+  const uint32_t seq = _ring.meta_seq();
+
+  if ( ! _meta_tagged || seq != _meta_seq ) {
+    add_item_tag( 0, first, pmt::string_to_symbol("rx_rate"),
+                  pmt::from_double( _ring.rate() ), _id );
+    add_item_tag( 0, first, pmt::string_to_symbol("rx_freq"),
+                  pmt::from_double( _ring.freq() ), _id );
+    _meta_seq = seq;
+    _meta_tagged = true;
+  }
+
+  _ring.read_tags( pos, pos + produced, _tags );
+  for ( const shm_ring::tag_t &tag : _tags )
+    add_item_tag( 0, first + ( tag.pos - pos ), tag.key, tag.value, _id );
+
+  _stats.samples += produced;
+
+  return produced;
+}
+
+std::vector<std::string> shm_source_c::get_devices()
+{
+  std::vector<std::string> devices;
+
+  for ( const std::string &name : shm_ring::list() )
+    devices.push_back( "shm=" + name + ",label='Shared Memory " + name + "'" );
+
+  return devices;
+}
+
+size_t shm_source_c::get_num_channels()
+{
+  return 1;
+}
+
+/* the sink decides, what we can do is report it */
+osmosdr::meta_range_t shm_source_c::get_sample_rates()
+{
+  osmosdr::meta_range_t range;
+
+  range.push_back( osmosdr::range_t( get_sample_rate() ) );
+
+  return range;
+}
+
+double shm_source_c::set_sample_rate( double rate )
+{
+  return get_sample_rate();
+}
+
+double shm_source_c::get_sample_rate()
+{
+  return _ring.rate();
+}
+
+osmosdr::freq_range_t shm_source_c::get_freq_range( size_t chan )
+{
+  osmosdr::freq_range_t range;
+
+  range.push_back( osmosdr::range_t( get_center_freq( chan ) ) );
+
+  return range;
+}
+
+double shm_source_c::set_center_freq( double freq, size_t chan )
+{
+  return get_center_freq( chan );
+}
+
+double shm_source_c::get_center_freq( size_t chan )
+{
+  return _ring.freq();
+}
+
+double shm_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double shm_source_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> shm_source_c::get_gain_names( size_t chan )
+{
+  return std::vector<std::string>();
+}
+
+osmosdr::gain_range_t shm_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t shm_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double shm_source_c::set_gain( double gain, size_t chan )
+{
+  return get_gain( chan );
+}
+
+double shm_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double shm_source_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double shm_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > shm_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string shm_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string shm_source_c::get_antenna( size_t chan )
+{
+  return "SHM";
+}
+
+osmosdr::stream_stats_t shm_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _ring.fill();
+  stats.capacity = _ring.capacity();
+
+  return stats;
+}
@@ -0,0 +1,111 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SHM_SOURCE_C_H
+#define INCLUDED_SHM_SOURCE_C_H
+
+#include <atomic>
+
+#include <gnuradio/sync_block.h>
+
+#include "source_iface.h"
+#include "shm_ring.h"
+
+class shm_source_c;
+
+typedef std::shared_ptr<shm_source_c> shm_source_c_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of shm_source_c.
+ *
+ * To avoid accidental use of raw pointers, shm_source_c's
+ * constructor is private.  make_shm_source_c is the public
+ * interface for creating new instances.
+ */
+shm_source_c_sptr make_shm_source_c (const std::string & args = "");
+
+/*!
+ * \brief Reads what a shm= sink in another process writes.
+ *
+ * The samples are copied straight from the shared ring into the output
+ * buffer, together with the tags the sink got. The rate and frequency
+ * are the ones set on the sink, a change of them is tagged with rx_rate
+ * and rx_freq at the next sample. Samples lost to a reader that fell
+ * behind are counted as overruns.
+ * \ingroup block
+ */
+class shm_source_c :
+    public gr::sync_block,
+    public source_iface
+{
+private:
+  friend shm_source_c_sptr make_shm_source_c (const std::string & args);
+
+  shm_source_c (const std::string & args);
+
+public:
+  ~shm_source_c ();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices();
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+private:
+  shm_ring _ring;
+  std::atomic<bool> _running;
+  pmt::pmt_t _id;
+  uint32_t _meta_seq;             // of the rate and freq last tagged
+  bool _meta_tagged;
+  std::vector< shm_ring::tag_t > _tags;
+
+  osmosdr::stream_stats_t _stats;
+};
+
+#endif /* INCLUDED_SHM_SOURCE_C_H */
@@ -0,0 +1,53 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "backend_registry.h"
+#include "sim_source_c.h"
+#include "sim_sink_c.h"
+
+static backend_t sim_backend()
+{
+  backend_t backend;
+
+  backend.name = "sim";
+  backend.order = 170;
+  backend.fakes = true;
+
+  /* only listed on request, it must not win the auto-detection */
+  backend.source_devices = []( bool fake ) {
+    return fake ? sim_source_c::get_devices() : std::vector< std::string >();
+  };
+  backend.make_source = []( const std::string &args ) -> backend_t::source_t {
+    sim_source_c_sptr src = make_sim_source_c( args );
+    return backend_t::source_t{ src, src.get() };
+  };
+
+  backend.sink_devices = []( bool fake ) {
+    return fake ? sim_sink_c::get_devices() : std::vector< std::string >();
+  };
+  backend.make_sink = []( const std::string &args ) -> backend_t::sink_t {
+    sim_sink_c_sptr sink = make_sim_sink_c( args );
+    return backend_t::sink_t{ sink, sink.get() };
+  };
+
+  return backend;
+}
+
+static backend_registrar registrar( sim_backend() );
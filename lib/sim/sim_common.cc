@@ -0,0 +1,218 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/lexical_cast.hpp>
+
+#include "sim_common.h"
+
+#define SIM_MAX_RATE 1e9
+
+sim_common::sim_common( const std::string &args, const std::string &fault_key ) :
+  _format(FORMAT_U8),
+  _xfer(SIM_DEFAULT_XFER),
+  _buf_num(SIM_DEFAULT_BUFFERS),
+  _realtime(true),
+  _fault_every(0),
+  _fault_count(0),
+  _sample_rate(SIM_DEFAULT_RATE),
+  _center_freq(100e6),
+  _freq_corr(0),
+  _gain(0),
+  _bandwidth(0)
+{
+  _dict = params_to_dict( args );
+
+  if ( _dict.count("format") ) {
+    const std::string &format = _dict["format"];
+
+    if ( "u8" == format )
+      _format = FORMAT_U8;
+    else if ( "s8" == format )
+      _format = FORMAT_S8;
+    else if ( "s16" == format )
+      _format = FORMAT_S16;
+    else
+      throw std::runtime_error( "Unsupported sim format '" + format + "', use u8, s8 or s16." );
+  }
+
+  if ( _dict.count("rate") )
+    set_sample_rate( boost::lexical_cast< double >( _dict["rate"] ) );
+
+  if ( _dict.count("freq") )
+    set_center_freq( boost::lexical_cast< double >( _dict["freq"] ) );
+
+  if ( _dict.count("xfer") )
+    _xfer = boost::lexical_cast< size_t >( _dict["xfer"] );
+
+  if ( _dict.count("buffers") )
+    _buf_num = boost::lexical_cast< size_t >( _dict["buffers"] );
+
+  if ( _dict.count("realtime") )
+    _realtime = boost::lexical_cast< bool >( _dict["realtime"] );
+
+  /* every n-th transfer gets lost */
+  if ( _dict.count(fault_key) )
+    _fault_every = boost::lexical_cast< size_t >( _dict[fault_key] );
+
+  if ( ! _xfer || _buf_num < 2 )
+    throw std::runtime_error( "sim needs xfer > 0 and at least 2 buffers." );
+}
+
+std::vector< std::string > sim_common::get_devices( const std::string &label )
+{
+  std::vector< std::string > devices;
+
+  devices.push_back( "sim=0,rate=2.4e6,format=u8,label='" + label + "'" );
+
+  return devices;
+}
+
+osmosdr::meta_range_t sim_common::get_sample_rates()
+{
+  osmosdr::meta_range_t range;
+
+  range.push_back( osmosdr::range_t( 1e3, SIM_MAX_RATE ) );
+
+  return range;
+}
+
+double sim_common::set_sample_rate( double rate )
+{
+  if ( rate <= 0 || rate > SIM_MAX_RATE )
+    throw std::runtime_error( "Unsupported sim sample rate." );
+
+  _sample_rate = rate;
+
+  return get_sample_rate();
+}
+
+double sim_common::get_sample_rate()
+{
+  return _sample_rate;
+}
+
+osmosdr::freq_range_t sim_common::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, 10e9 );
+}
+
+double sim_common::set_center_freq( double freq, size_t chan )
+{
+  _center_freq = freq;
+
+  return get_center_freq( chan );
+}
+
+double sim_common::get_center_freq( size_t chan )
+{
+  return _center_freq;
+}
+
+double sim_common::set_freq_corr( double ppm, size_t chan )
+{
+  _freq_corr = ppm;
+
+  return get_freq_corr( chan );
+}
+
+double sim_common::get_freq_corr( size_t chan )
+{
+  return _freq_corr;
+}
+
+osmosdr::gain_range_t sim_common::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t( 0, 50, 1 );
+}
+
+double sim_common::set_gain( double gain, size_t chan )
+{
+  _gain = get_gain_range( chan ).clip( gain, true );
+
+  return get_gain( chan );
+}
+
+double sim_common::get_gain( size_t chan )
+{
+  return _gain;
+}
+
+double sim_common::set_bandwidth( double bandwidth, size_t chan )
+{
+  _bandwidth = bandwidth;
+
+  return get_bandwidth( chan );
+}
+
+double sim_common::get_bandwidth( size_t chan )
+{
+  return _bandwidth ? _bandwidth : get_sample_rate();
+}
+
+osmosdr::freq_range_t sim_common::get_bandwidth_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, SIM_MAX_RATE );
+}
+
+void sim_common::clock_start()
+{
+  _next = clock_t::now();
+  _fault_count = 0;
+}
+
+size_t sim_common::clock_wait()
+{
+  if ( ! _realtime )
+    return 0;
+
+  const clock_t::duration period = std::chrono::duration_cast< clock_t::duration >(
+        std::chrono::duration< double >( _xfer / get_sample_rate() ) );
+  const clock_t::time_point now = clock_t::now();
+
+  _next += period;
+
+  /* the device buffers ran over while the thread wasn't scheduled */
+  if ( now > _next + period * _buf_num ) {
+    size_t lost = size_t( (now - _next) / period );
+    _next = now;
+    return lost;
+  }
+
+  std::this_thread::sleep_until( _next );
+
+  return 0;
+}
+
+bool sim_common::inject_fault()
+{
+  if ( ! _fault_every )
+    return false;
+
+  if ( ++_fault_count < _fault_every )
+    return false;
+
+  _fault_count = 0;
+  return true;
+}
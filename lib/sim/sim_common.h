@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SIM_COMMON_H
+#define INCLUDED_SIM_COMMON_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <osmosdr/ranges.h>
+
+#include "arg_helpers.h"
+
+#define SIM_DEFAULT_RATE    2.4e6
+#define SIM_DEFAULT_XFER    65536   // samples per transfer
+#define SIM_DEFAULT_BUFFERS 16
+
+/*!
+ * What the simulated source and sink have in common: the native sample
+ * format, the transfer size and the clock the transfers are paced with.
+ *
+ * The device is emulated as a thread that moves one transfer per period
+ * in and out of the same kind of ring the USB backends use, so work()
+ * sees the callback to ring to work() path of real hardware. Samples are
+ * converted with the same kernels, from or to the native format.
+ *
+ * With realtime=0 the transfers aren't paced, the stream then runs as
+ * fast as the flowgraph takes or gives samples.
+ */
+class sim_common
+{
+public:
+  /* \p fault_key names the argument injecting overruns or underruns */
+  sim_common( const std::string &args, const std::string &fault_key );
+
+protected:
+  enum format_t { FORMAT_U8, FORMAT_S8, FORMAT_S16 };
+
+  static std::vector< std::string > get_devices( const std::string &label );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+
+  double set_bandwidth( double bandwidth, size_t chan = 0 );
+  double get_bandwidth( size_t chan = 0 );
+  osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
+
+  size_t bytes_per_sample() const { return FORMAT_S16 == _format ? 4 : 2; }
+  size_t xfer_bytes() const { return _xfer * bytes_per_sample(); }
+
+  /* anchor the clock, the first transfer is due one period later */
+  void clock_start();
+
+  /*
+   * Sleep until the next transfer is due. Returns the number of transfers
+   * the device would have lost since the last one because the thread was
+   * late by more than the device buffers can hold.
+   */
+  size_t clock_wait();
+
+  /* true for the transfers the overrun= / underrun= argument drops */
+  bool inject_fault();
+
+  dict_t _dict;
+  format_t _format;
+  size_t _xfer;           // samples per transfer
+  size_t _buf_num;        // transfers the ring holds
+  bool _realtime;
+
+private:
+  typedef std::chrono::steady_clock clock_t;
+
+  size_t _fault_every;    // transfers, 0 disables the fault injection
+  size_t _fault_count;
+  clock_t::time_point _next;
+
+  std::atomic<double> _sample_rate;   // read by the device thread
+  double _center_freq;
+  double _freq_corr;
+  double _gain;
+  double _bandwidth;
+};
+
+#endif /* INCLUDED_SIM_COMMON_H */
@@ -0,0 +1,398 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure.  It contains the results
+ * of probing for features, options etc.  It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <boost/bind.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "sim_sink_c.h"
+#include "arg_helpers.h"
+#include "buffer_pool.h"
+#include "sample_convert.h"
+
+sim_sink_c_sptr make_sim_sink_c (const std::string & args)
+{
+  return gnuradio::get_initial_sptr(new sim_sink_c (args));
+}
+
+static const int MIN_IN = 1;	// mininum number of input streams
+static const int MAX_IN = 1;	// maximum number of input streams
+static const int MIN_OUT = 0;	// minimum number of output streams
+static const int MAX_OUT = 0;	// maximum number of output streams
+
+sim_sink_c::sim_sink_c (const std::string &args)
+  : gr::sync_block ("sim_sink_c",
+        gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    sim_common(args, "underrun"),
+    _running(false),
+    _stopping(false),
+    _wave_pos(0)
+{
+  _ring.set_buffer_opts( buffer_opts_from_dict( _dict ) );
+  _sched = thread_sched_from_dict( _dict, "tx" );
+
+  _ring.resize( _buf_num * xfer_bytes() );
+
+  std::cerr << "Using simulated sink, " << _buf_num << " buffers of "
+            << _xfer << " samples." << std::endl;
+}
+
+sim_sink_c::~sim_sink_c ()
+{
+  if ( _thread.joinable() )
+    stop();
+}
+
+bool sim_sink_c::start()
+{
+  _ring.reset();
+  _stopping = false;
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &sim_sink_c::sim_thread, this ) );
+
+  return true;
+}
+
+bool sim_sink_c::stop()
+{
+  _stopping = true;
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+/* the device, takes a transfer every period like a libusb event thread */
+void sim_sink_c::sim_thread()
+{
+  const size_t len = xfer_bytes();
+
+  thread_sched_apply( _sched );
+  clock_start();
+
+  while ( _running ) {
+    const size_t lost = clock_wait();
+    if ( lost ) {
+      _stats.underruns += lost;
+      std::cerr << "U" << std::flush;
+    }
+
+    if ( ! _realtime )
+      _ring.wait_for( len, std::chrono::milliseconds(100) );
+
+    if ( ! sim_callback( len ) )
+      break;
+  }
+
+  _running = false;
+
+  std::lock_guard<std::mutex> lock( _space_mutex );
+  _space_cond.notify_one();
+}
+
+/* returns false once the stream has been sent out after stop() */
+bool sim_sink_c::sim_callback( size_t len )
+{
+  const bool fault = inject_fault();
+
+  if ( fault || _ring.size() < len ) {
+    if ( _stopping ) {
+      _ring.consume( _ring.size() );
+      return false;
+    }
+
+    /* without pacing, running empty only counts when asked for */
+    if ( fault || _realtime ) {
+      _stats.underruns++;
+      std::cerr << "U" << std::flush;
+    }
+
+    if ( ! fault )
+      return true;
+  }
+
+  _ring.consume( std::min( len, _ring.size() ) );
+
+  std::lock_guard<std::mutex> lock( _space_mutex );
+  _space_cond.notify_one();
+
+  return true;
+}
+
+/* false once the device thread is gone */
+bool sim_sink_c::wait_space()
+{
+  std::unique_lock<std::mutex> lock( _space_mutex );
+
+  while ( _running && _ring.space() < bytes_per_sample() )
+    _space_cond.wait_for( lock, std::chrono::milliseconds(100) );
+
+  return _running;
+}
+
+void sim_sink_c::convert( const gr_complex *in, uint8_t *out, size_t nitems )
+{
+  switch ( _format ) {
+  case FORMAT_U8:
+    convert_fc32_sc8( in, (int8_t *)out, nitems );
+    for (size_t i = 0; i < nitems * 2; i++)
+      out[i] ^= 0x80;
+    break;
+  case FORMAT_S8:
+    convert_fc32_sc8( in, (int8_t *)out, nitems );
+    break;
+  case FORMAT_S16:
+    convert_fc32_sc16( in, (int16_t *)out, nitems );
+    break;
+  }
+}
+
+int sim_sink_c::work( int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  const size_t bps = bytes_per_sample();
+  int consumed = 0;
+
+  {
+    std::lock_guard<std::mutex> lock( _wave_mutex );
+
+    if ( ! _wave.empty() )
+      return work_waveform( noutput_items );
+  }
+
+  /* convert straight into the free space until we run out of input or
+   * room, only waiting for room if nothing could be taken yet */
+  while ( consumed < noutput_items ) {
+    size_t len;
+    uint8_t *buf = _ring.write_ptr( len );
+
+    if ( len < bps ) {
+      if ( consumed )
+        break;
+
+      if ( ! wait_space() )
+        return WORK_DONE;
+
+      continue;
+    }
+
+    const int nin = std::min< size_t >( noutput_items - consumed, len / bps );
+
+    convert( in, buf, nin );
+    in += nin;
+
+    _ring.commit( nin * bps );
+    consumed += nin;
+  }
+
+  _stats.samples += consumed;
+
+  return consumed;
+}
+
+/* copies the waveform into the ring, as much of the input is dropped */
+int sim_sink_c::work_waveform( int noutput_items )
+{
+  const size_t bps = bytes_per_sample();
+  size_t len;
+  uint8_t *buf = _ring.write_ptr( len );
+
+  if ( len < bps ) {
+    if ( ! wait_space() )
+      return WORK_DONE;
+
+    buf = _ring.write_ptr( len );
+    if ( len < bps )
+      return 0;
+  }
+
+  len = std::min( len / bps, size_t(noutput_items) ) * bps;
+
+  for (size_t done = 0; done < len; ) {
+    const size_t count = std::min( len - done, _wave.size() - _wave_pos );
+
+    memcpy( buf + done, &_wave[_wave_pos], count );
+    done += count;
+    _wave_pos = ( _wave_pos + count ) % _wave.size();
+  }
+
+  _ring.commit( len );
+  _stats.samples += len / bps;
+
+  return len / bps;
+}
+
+bool sim_sink_c::set_waveform( const std::vector< gr_complex > &samples, size_t chan )
+{
+  std::vector<uint8_t> wave( samples.size() * bytes_per_sample() );
+
+  if ( ! samples.empty() )
+    convert( &samples[0], &wave[0], samples.size() );
+
+  std::lock_guard<std::mutex> lock( _wave_mutex );
+
+  _wave.swap( wave );
+  _wave_pos = 0;
+
+  return true;
+}
+
+std::vector<std::string> sim_sink_c::get_devices()
+{
+  return sim_common::get_devices( "Simulated Sink" );
+}
+
+size_t sim_sink_c::get_num_channels()
+{
+  return 1;
+}
+
+osmosdr::meta_range_t sim_sink_c::get_sample_rates()
+{
+  return sim_common::get_sample_rates();
+}
+
+double sim_sink_c::set_sample_rate( double rate )
+{
+  return sim_common::set_sample_rate( rate );
+}
+
+double sim_sink_c::get_sample_rate()
+{
+  return sim_common::get_sample_rate();
+}
+
+osmosdr::freq_range_t sim_sink_c::get_freq_range( size_t chan )
+{
+  return sim_common::get_freq_range( chan );
+}
+
+double sim_sink_c::set_center_freq( double freq, size_t chan )
+{
+  return sim_common::set_center_freq( freq, chan );
+}
+
+double sim_sink_c::get_center_freq( size_t chan )
+{
+  return sim_common::get_center_freq( chan );
+}
+
+double sim_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  return sim_common::set_freq_corr( ppm, chan );
+}
+
+double sim_sink_c::get_freq_corr( size_t chan )
+{
+  return sim_common::get_freq_corr( chan );
+}
+
+std::vector<std::string> sim_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector<std::string>( 1, "RF" );
+}
+
+osmosdr::gain_range_t sim_sink_c::get_gain_range( size_t chan )
+{
+  return sim_common::get_gain_range( chan );
+}
+
+osmosdr::gain_range_t sim_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double sim_sink_c::set_gain( double gain, size_t chan )
+{
+  return sim_common::set_gain( gain, chan );
+}
+
+double sim_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double sim_sink_c::get_gain( size_t chan )
+{
+  return sim_common::get_gain( chan );
+}
+
+double sim_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > sim_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string sim_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string sim_sink_c::get_antenna( size_t chan )
+{
+  return "TX";
+}
+
+double sim_sink_c::set_bandwidth( double bandwidth, size_t chan )
+{
+  return sim_common::set_bandwidth( bandwidth, chan );
+}
+
+double sim_sink_c::get_bandwidth( size_t chan )
+{
+  return sim_common::get_bandwidth( chan );
+}
+
+osmosdr::freq_range_t sim_sink_c::get_bandwidth_range( size_t chan )
+{
+  return sim_common::get_bandwidth_range( chan );
+}
+
+osmosdr::stream_stats_t sim_sink_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _ring.size() / bytes_per_sample();
+  stats.fill_max = _ring.fill_max() / bytes_per_sample();
+  stats.capacity = _ring.capacity() / bytes_per_sample();
+
+  return stats;
+}
@@ -0,0 +1,137 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SIM_SINK_C_H
+#define INCLUDED_SIM_SINK_C_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include "sink_iface.h"
+#include "sim_common.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+
+class sim_sink_c;
+
+typedef std::shared_ptr<sim_sink_c> sim_sink_c_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of sim_sink_c.
+ *
+ * To avoid accidental use of raw pointers, sim_sink_c's
+ * constructor is private.  make_sim_sink_c is the public
+ * interface for creating new instances.
+ */
+sim_sink_c_sptr make_sim_sink_c (const std::string & args = "");
+
+/*!
+ * \brief Simulated transmitter, takes samples at the sample rate.
+ *
+ * work() converts into the ring in the native format, the device thread
+ * takes one transfer per period out of it and discards it. A transfer
+ * that isn't complete when it is due counts as an underrun. A waveform
+ * set with set_waveform() gets copied into the ring instead of the input.
+ * \ingroup block
+ */
+class sim_sink_c :
+    public gr::sync_block,
+    public sink_iface,
+    protected sim_common
+{
+private:
+  friend sim_sink_c_sptr make_sim_sink_c (const std::string & args);
+
+  sim_sink_c (const std::string & args);
+
+public:
+  ~sim_sink_c ();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices();
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  double set_bandwidth( double bandwidth, size_t chan = 0 );
+  double get_bandwidth( size_t chan = 0 );
+  osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  bool set_waveform( const std::vector< gr_complex > &samples, size_t chan = 0 );
+
+private:
+  void sim_thread();
+  bool sim_callback( size_t len );
+  bool wait_space();
+  void convert( const gr_complex *in, uint8_t *out, size_t nitems );
+  int work_waveform( int noutput_items );
+
+  spsc_ring<uint8_t> _ring;
+  thread_sched_t _sched;
+  gr::thread::thread _thread;
+  std::atomic<bool> _running;
+  std::atomic<bool> _stopping;    // send what is queued, then stop
+
+  /* work() waits for the device thread to make room */
+  std::mutex _space_mutex;
+  std::condition_variable _space_cond;
+
+  /* looped instead of the input, in the native format */
+  std::mutex _wave_mutex;
+  std::vector<uint8_t> _wave;
+  size_t _wave_pos;
+
+  osmosdr::stream_stats_t _stats;
+};
+
+#endif /* INCLUDED_SIM_SINK_C_H */
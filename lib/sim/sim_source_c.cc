@@ -0,0 +1,409 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure.  It contains the results
+ * of probing for features, options etc.  It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "sim_source_c.h"
+#include "arg_helpers.h"
+#include "buffer_pool.h"
+#include "sample_convert.h"
+
+#define SIGNAL_AMPLITUDE 0.5
+#define NOISE_AMPLITUDE  0.05
+
+sim_source_c_sptr make_sim_source_c (const std::string & args)
+{
+  return gnuradio::get_initial_sptr(new sim_source_c (args));
+}
+
+static const int MIN_IN = 0;	// mininum number of input streams
+static const int MAX_IN = 0;	// maximum number of input streams
+static const int MIN_OUT = 1;	// minimum number of output streams
+static const int MAX_OUT = 1;	// maximum number of output streams
+
+sim_source_c::sim_source_c (const std::string &args)
+  : gr::sync_block ("sim_source_c",
+        gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    sim_common(args, "overrun"),
+    _running(false),
+    _sc8(false)
+{
+  _ring.set_buffer_opts( buffer_opts_from_dict( _dict ) );
+  _sched = thread_sched_from_dict( _dict );
+
+  /* rx_time / rx_rate / rx_freq tags from the host clock */
+  if (_dict.count("timekey"))
+    _tagger.enable( boost::lexical_cast< bool >( _dict["timekey"] ) );
+  _tagger.set_id( pmt::string_to_symbol(args) );
+
+  make_signal();
+  _ring.resize( _buf_num * xfer_bytes() );
+
+  std::cerr << "Using simulated source, " << _buf_num << " buffers of "
+            << _xfer << " samples." << std::endl;
+}
+
+sim_source_c::~sim_source_c ()
+{
+  if ( _thread.joinable() )
+    stop();
+}
+
+/* a whole number of tone periods per transfer, so the transfers join up */
+void sim_source_c::make_signal()
+{
+  const size_t cycles = std::max< size_t >( 1, _xfer / 16 );
+  const double full_scale = FORMAT_S16 == _format ? 32767.0 : 127.0;
+  std::mt19937 gen( 0 );
+  std::normal_distribution< double > noise( 0.0, NOISE_AMPLITUDE );
+
+  _signal.resize( xfer_bytes() );
+
+  for (size_t i = 0; i < 2 * _xfer; i++) {
+    const double phase = 2 * M_PI * cycles * double(i / 2) / _xfer;
+    double value = SIGNAL_AMPLITUDE * ( i % 2 ? std::sin( phase ) : std::cos( phase ) );
+
+    value = std::max( -1.0, std::min( 1.0, value + noise( gen ) ) );
+
+    const long q = std::lround( value * full_scale );
+
+    switch ( _format ) {
+    case FORMAT_U8:
+      _signal[i] = uint8_t( q + 128 );
+      break;
+    case FORMAT_S8:
+      _signal[i] = uint8_t( int8_t( q ) );
+      break;
+    case FORMAT_S16:
+      {
+        const int16_t s = int16_t( q );
+        memcpy( &_signal[2 * i], &s, sizeof(s) );
+      }
+      break;
+    }
+  }
+}
+
+bool sim_source_c::start()
+{
+  _ring.reset();
+  _latency_stats.reset();
+  _tagger.start( get_sample_rate(), get_center_freq() );
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &sim_source_c::sim_thread, this ) );
+
+  return true;
+}
+
+bool sim_source_c::stop()
+{
+  _running = false;
+
+  {
+    std::lock_guard<std::mutex> lock( _space_mutex );
+    _space_cond.notify_one();
+  }
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+/* the device, delivers a transfer every period like a libusb event thread */
+void sim_source_c::sim_thread()
+{
+  const size_t len = xfer_bytes();
+
+  thread_sched_apply( _sched );
+  clock_start();
+
+  while ( _running ) {
+    const size_t lost = clock_wait();
+    if ( lost )
+      overrun( lost * len );
+
+    if ( ! _realtime ) {
+      std::unique_lock<std::mutex> lock( _space_mutex );
+
+      while ( _running && _ring.space() < len )
+        _space_cond.wait_for( lock, std::chrono::milliseconds(100) );
+
+      if ( ! _running )
+        break;
+    }
+
+    sim_callback( &_signal[0], len );
+  }
+
+  _ring.close();
+}
+
+void sim_source_c::sim_callback( const uint8_t *buf, size_t len )
+{
+  /* work() may still be converting the oldest transfer, so drop the new one */
+  if ( inject_fault() || _ring.space() < len ) {
+    overrun( len );
+    return;
+  }
+
+  _tagger.transfer( len / bytes_per_sample() );
+  _latency_stats.arrival( _ring.write_count() );
+  _ring.push( buf, len );
+}
+
+void sim_source_c::overrun( size_t len )
+{
+  _stats.overruns++;
+  _stats.dropped += len / bytes_per_sample();
+  _tagger.overrun( len / bytes_per_sample() );
+  std::cerr << "O" << std::flush;
+}
+
+int sim_source_c::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  int8_t *out8 = (int8_t *)output_items[0];
+  const size_t bps = bytes_per_sample();
+  int produced = 0;
+
+  _ring.wait( bps );
+
+  if ( ! _running )
+    return WORK_DONE;
+
+  while ( produced < noutput_items ) {
+    size_t len;
+    const uint8_t *buf = _ring.read_ptr( len );
+    const int nout = std::min< size_t >( noutput_items - produced, len / bps );
+
+    if ( ! nout )
+      break;
+
+    switch ( _format ) {
+    case FORMAT_U8:
+      if ( _sc8 )
+        convert_u8_sc8( buf, out8, nout );
+      else
+        convert_u8_fc32( buf, out, nout );
+      break;
+    case FORMAT_S8:
+      if ( _sc8 )
+        memcpy( out8, buf, nout * bps );
+      else
+        convert_s8_fc32( (const int8_t *)buf, out, nout );
+      break;
+    case FORMAT_S16:
+      convert_s16_fc32( (const int16_t *)buf, out, nout, 1.0f / 32768 );
+      break;
+    }
+    out += nout;
+    out8 += nout * 2;
+
+    produced += nout;
+    _ring.consume( nout * bps );
+  }
+
+  if ( ! _realtime ) {
+    std::lock_guard<std::mutex> lock( _space_mutex );
+    _space_cond.notify_one();
+  }
+
+  _latency_stats.consumed( _ring.read_count(), _ring.size() );
+  _stats.samples += produced;
+
+  if (_tagger.enabled()) {
+    _tagger.get_tags( nitems_written(0), produced, _tags );
+    for (const gr::tag_t &tag : _tags)
+      add_item_tag( 0, tag );
+  }
+
+  return produced;
+}
+
+std::vector<std::string> sim_source_c::get_devices()
+{
+  return sim_common::get_devices( "Simulated Source" );
+}
+
+size_t sim_source_c::get_num_channels()
+{
+  return 1;
+}
+
+osmosdr::meta_range_t sim_source_c::get_sample_rates()
+{
+  return sim_common::get_sample_rates();
+}
+
+double sim_source_c::set_sample_rate( double rate )
+{
+  double actual = sim_common::set_sample_rate( rate );
+
+  _tagger.set_rate( actual );
+
+  return actual;
+}
+
+double sim_source_c::get_sample_rate()
+{
+  return sim_common::get_sample_rate();
+}
+
+osmosdr::freq_range_t sim_source_c::get_freq_range( size_t chan )
+{
+  return sim_common::get_freq_range( chan );
+}
+
+double sim_source_c::set_center_freq( double freq, size_t chan )
+{
+  double actual = sim_common::set_center_freq( freq, chan );
+
+  _tagger.retune( actual );
+
+  return actual;
+}
+
+double sim_source_c::get_center_freq( size_t chan )
+{
+  return sim_common::get_center_freq( chan );
+}
+
+double sim_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return sim_common::set_freq_corr( ppm, chan );
+}
+
+double sim_source_c::get_freq_corr( size_t chan )
+{
+  return sim_common::get_freq_corr( chan );
+}
+
+std::vector<std::string> sim_source_c::get_gain_names( size_t chan )
+{
+  return std::vector<std::string>( 1, "RF" );
+}
+
+osmosdr::gain_range_t sim_source_c::get_gain_range( size_t chan )
+{
+  return sim_common::get_gain_range( chan );
+}
+
+osmosdr::gain_range_t sim_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double sim_source_c::set_gain( double gain, size_t chan )
+{
+  return sim_common::set_gain( gain, chan );
+}
+
+double sim_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double sim_source_c::get_gain( size_t chan )
+{
+  return sim_common::get_gain( chan );
+}
+
+double sim_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > sim_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string sim_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string sim_source_c::get_antenna( size_t chan )
+{
+  return "RX";
+}
+
+double sim_source_c::set_bandwidth( double bandwidth, size_t chan )
+{
+  return sim_common::set_bandwidth( bandwidth, chan );
+}
+
+double sim_source_c::get_bandwidth( size_t chan )
+{
+  return sim_common::get_bandwidth( chan );
+}
+
+osmosdr::freq_range_t sim_source_c::get_bandwidth_range( size_t chan )
+{
+  return sim_common::get_bandwidth_range( chan );
+}
+
+osmosdr::stream_stats_t sim_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _ring.size() / bytes_per_sample();
+  stats.fill_max = _ring.fill_max() / bytes_per_sample();
+  stats.capacity = _ring.capacity() / bytes_per_sample();
+  _latency_stats.get_stats( stats, bytes_per_sample() );
+
+  return stats;
+}
+
+bool sim_source_c::set_output_type( const std::string &type )
+{
+  if ( "sc8" != type )
+    return "fc32" == type;
+
+  if ( FORMAT_S16 == _format )
+    return false;
+
+  _sc8 = true;
+  set_output_signature( gr::io_signature::make(MIN_OUT, MAX_OUT, item_type_to_size(type)) );
+
+  return true;
+}
@@ -0,0 +1,135 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SIM_SOURCE_C_H
+#define INCLUDED_SIM_SOURCE_C_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include "source_iface.h"
+#include "sim_common.h"
+#include "latency_stats.h"
+#include "spsc_ring.h"
+#include "stream_tagger.h"
+#include "thread_sched.h"
+
+class sim_source_c;
+
+typedef std::shared_ptr<sim_source_c> sim_source_c_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of sim_source_c.
+ *
+ * To avoid accidental use of raw pointers, sim_source_c's
+ * constructor is private.  make_sim_source_c is the public
+ * interface for creating new instances.
+ */
+sim_source_c_sptr make_sim_source_c (const std::string & args = "");
+
+/*!
+ * \brief Simulated receiver, streams a synthetic signal at the sample rate.
+ *
+ * The signal is a tone at a sixteenth of the sample rate in some noise,
+ * generated once in the native format, so the device thread costs no
+ * more than the DMA of a real device would.
+ * \ingroup block
+ */
+class sim_source_c :
+    public gr::sync_block,
+    public source_iface,
+    protected sim_common
+{
+private:
+  friend sim_source_c_sptr make_sim_source_c (const std::string & args);
+
+  sim_source_c (const std::string & args);
+
+public:
+  ~sim_source_c ();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices();
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  double set_bandwidth( double bandwidth, size_t chan = 0 );
+  double get_bandwidth( size_t chan = 0 );
+  osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  bool set_output_type( const std::string &type );
+
+private:
+  void make_signal();
+  void sim_thread();
+  void sim_callback( const uint8_t *buf, size_t len );
+  void overrun( size_t len );
+
+  spsc_ring<uint8_t> _ring;
+  std::vector<uint8_t> _signal;   // one transfer in the native format
+  thread_sched_t _sched;
+  gr::thread::thread _thread;
+  std::atomic<bool> _running;
+  bool _sc8;
+
+  /* without pacing the device thread waits for work() to make room */
+  std::mutex _space_mutex;
+  std::condition_variable _space_cond;
+
+  osmosdr::stream_stats_t _stats;
+  latency_stats _latency_stats;
+  stream_tagger _tagger;
+  std::vector<gr::tag_t> _tags;
+};
+
+#endif /* INCLUDED_SIM_SOURCE_C_H */
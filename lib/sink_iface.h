@@ -21,9 +21,14 @@
 #ifndef OSMOSDR_SINK_IFACE_H
 #define OSMOSDR_SINK_IFACE_H
 
+#include <osmosdr/device.h>
 #include <osmosdr/ranges.h>
+#include <osmosdr/stream_stats.h>
 #include <osmosdr/time_spec.h>
 #include <gnuradio/basic_block.h>
+#include <gnuradio/gr_complex.h>
+
+#include "device_sync.h"
 
 /*!
  * TODO: document
@@ -258,6 +263,66 @@ public:
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 )
     { return osmosdr::freq_range_t(); }
 
+  /*!
+   * Get the streaming statistics of a channel.
+   * \param chan the channel index 0 to N-1
+   * \return counters for delivered and dropped samples, over/underruns
+   * and the host ring fill level
+   */
+  virtual osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 )
+    { return osmosdr::stream_stats_t(); }
+
+  /*!
+   * Apply several settings of a channel at once.
+   * Applies them one by one through the setters, backends where every
+   * setting is a transaction of its own override this to coalesce them.
+   * \param config rate, freq, freq_corr, gain_mode, gain, if_gain, bb_gain,
+   * gain:<name>, antenna and bandwidth
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_config( const osmosdr::device_t &config, size_t chan = 0 )
+  {
+    if ( config.count("rate") )
+      set_sample_rate( config.cast< double >( "rate", 0 ) );
+    if ( config.count("freq_corr") )
+      set_freq_corr( config.cast< double >( "freq_corr", 0 ), chan );
+    if ( config.count("freq") )
+      set_center_freq( config.cast< double >( "freq", 0 ), chan );
+    if ( config.count("gain_mode") )
+      set_gain_mode( config.cast< bool >( "gain_mode", false ), chan );
+    if ( config.count("gain") )
+      set_gain( config.cast< double >( "gain", 0 ), chan );
+    if ( config.count("if_gain") )
+      set_if_gain( config.cast< double >( "if_gain", 0 ), chan );
+    if ( config.count("bb_gain") )
+      set_bb_gain( config.cast< double >( "bb_gain", 0 ), chan );
+    for (const auto &entry : config)
+      if ( 0 == entry.first.compare( 0, 5, "gain:" ) )
+        set_gain( config.cast< double >( entry.first, 0 ), entry.first.substr( 5 ), chan );
+    if ( config.count("antenna") )
+      set_antenna( config.at("antenna"), chan );
+    if ( config.count("bandwidth") )
+      set_bandwidth( config.cast< double >( "bandwidth", 0 ), chan );
+  }
+
+  /*!
+   * Loop a waveform instead of transmitting the input, an empty one
+   * goes back to the input. See osmosdr::sink::set_waveform().
+   * \param samples one period of the waveform
+   * \param chan the channel index 0 to N-1
+   * \return false if the backend can't loop a waveform
+   */
+  virtual bool set_waveform( const std::vector< gr_complex > &samples, size_t chan = 0 )
+    { return false; }
+
+  /*!
+   * Hold the first samples after every start until the time \p start
+   * gives, which the device asks for when it starts.
+   * \param start shared by all devices of the sink
+   * \return false if the device can't start at a given time
+   */
+  virtual bool set_timed_start( const timed_start_sptr &start ) { return false; }
+
   /*!
    * Set the time source for the device.
    * This sets the method of time synchronization,
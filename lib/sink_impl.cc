@@ -27,35 +27,19 @@
 #include "config.h"
 #endif
 
+#include <fstream>
+#include <functional>
+#include <future>
+
 #include <gnuradio/io_signature.h>
 #include <gnuradio/constants.h>
 
-#ifdef ENABLE_UHD
-#include "uhd_sink_c.h"
-#endif
-#ifdef ENABLE_HACKRF
-#include "hackrf_sink_c.h"
-#endif
-#ifdef ENABLE_BLADERF
-#include "bladerf_sink_c.h"
-#endif
-#ifdef ENABLE_SOAPY
-#include "soapy_sink_c.h"
-#endif
-#ifdef ENABLE_REDPITAYA
-#include "redpitaya_sink_c.h"
-#endif
-#ifdef ENABLE_FREESRP
-#include <freesrp_sink_c.h>
-#endif
-#ifdef ENABLE_XTRX
-#include "xtrx_sink_c.h"
-#endif
-#ifdef ENABLE_FILE
-#include "file_sink_c.h"
-#endif
-
 #include "arg_helpers.h"
+#include "backend_registry.h"
+#include "command_handler.h"
+#include "device_cache.h"
+#include "device_sync.h"
+#include "sample_convert.h"
 #include "sink_impl.h"
 
 /*
@@ -82,89 +66,34 @@ sink_impl::sink_impl( const std::string &args )
 
   std::vector< std::string > arg_list = args_to_vector(args);
 
-  std::vector< std::string > dev_types;
-
-#ifdef ENABLE_UHD
-  dev_types.push_back("uhd");
-#endif
-#ifdef ENABLE_HACKRF
-  dev_types.push_back("hackrf");
-#endif
-#ifdef ENABLE_BLADERF
-  dev_types.push_back("bladerf");
-#endif
-#ifdef ENABLE_SOAPY
-  dev_types.push_back("soapy");
-#endif
-#ifdef ENABLE_REDPITAYA
-  dev_types.push_back("redpitaya");
-#endif
-#ifdef ENABLE_FREESRP
-  dev_types.push_back("freesrp");
-#endif
-#ifdef ENABLE_XTRX
-  dev_types.push_back("xtrx");
-#endif
-#ifdef ENABLE_FILE
-  dev_types.push_back("file");
-#endif
+  message_port_register_hier_in( pmt::mp("command") );
+  message_port_register_hier_out( pmt::mp("async_msgs") );
 
   std::cerr << "gr-osmosdr "
             << GR_OSMOSDR_VERSION << " (" << GR_OSMOSDR_LIBVER << ") "
             << "gnuradio " << gr::version() << std::endl;
-  std::cerr << "built-in sink types: ";
-  for (std::string dev_type : dev_types)
-    std::cerr << dev_type << " ";
-  std::cerr << std::endl;
 
-  for (std::string arg : arg_list) {
-    dict_t dict = params_to_dict(arg);
-    for (std::string dev_type : dev_types) {
-      if ( dict.count( dev_type ) ) {
-        device_specified = true;
-        break;
-      }
-    }
-  }
+  /* only looks up the backends named, their modules get loaded for it */
+  backend_t backend;
+  for (std::string arg : arg_list)
+    if ( find_backend( params_to_dict( arg ), backend ) )
+      device_specified = true;
 
   if ( ! device_specified ) {
+    /* in the order of preference, the first backend listing a device
+     * wins and the ones after it aren't probed at all */
     std::vector< std::string > dev_list;
-#ifdef ENABLE_UHD
-    for (std::string dev : uhd_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_BLADERF
-    for (std::string dev : bladerf_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_HACKRF
-    for (std::string dev : hackrf_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_SOAPY
-    for (std::string dev : soapy_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_REDPITAYA
-    for (std::string dev : redpitaya_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_FREESRP
-    for (std::string dev : freesrp_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_XTRX
-    for (std::string dev : xtrx_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_FILE
-    for (std::string dev : file_sink_c::get_devices())
-      dev_list.push_back( dev );
-#endif
 
-//    std::cerr << std::endl;
-//    for (std::string dev : dev_list)
-//      std::cerr << "'" << dev << "'" << std::endl;
+    for (const backend_t &candidate : get_backends()) {
+      if ( ! candidate.sink_devices )
+        continue;
+
+      dev_list = cached_devices( candidate.name + " sink", [&candidate]() {
+          return candidate.sink_devices( false );
+        } );
+      if ( dev_list.size() )
+        break;
+    }
 
     if ( dev_list.size() )
       arg_list.push_back( dev_list.front() );
@@ -172,8 +101,69 @@ sink_impl::sink_impl( const std::string &args )
       throw std::runtime_error("No supported devices found (check the connection and/or udev rules).");
   }
 
+  std::cerr << "built-in sink types: ";
+  for (std::string dev_type : get_backend_names( true ))
+    std::cerr << dev_type << " ";
+  std::cerr << std::endl;
+
+  std::vector< std::string > modules = get_unloaded_modules();
+  if ( modules.size() ) {
+    std::cerr << "loadable modules: ";
+    for (std::string module : modules)
+      std::cerr << module << " ";
+    std::cerr << std::endl;
+  }
+
+  /* sync=pps|time starts all devices at the same time, start_delay
+   * seconds after the first of them starts */
+  std::string sync;
+  double start_delay = 0.5;
   for (std::string arg : arg_list) {
+    dict_t dict = params_to_dict(arg);
+    if ( dict.count("sync") )
+      sync = dict["sync"];
+    if ( dict.count("start_delay") )
+      start_delay = boost::lexical_cast< double >( dict["start_delay"] );
+  }
+
+  if ( sync.size() && "pps" != sync && "time" != sync )
+    throw std::runtime_error("Unsupported sync mode " + sync + ", use pps or time.");
+
+  /* a tx_latency_ms=<ms> token of its own caps the queue of every device
+   * not given one itself */
+  std::string latency;
+  for (std::string arg : arg_list)
+    if ( is_global_argument()( arg ) && params_to_dict( arg ).count("tx_latency_ms") )
+      latency = params_to_dict( arg )["tx_latency_ms"];
+
+  if ( latency.size() )
+    for (std::string &arg : arg_list)
+      if ( find_backend( params_to_dict( arg ), backend ) &&
+           ! params_to_dict( arg ).count("tx_latency_ms") )
+        arg += ",tx_latency_ms=" + latency;
+
+  /* tx_spread=1 hands out the cores of tx_cpu= in the order of the
+   * devices here, see thread_sched.h */
+  size_t spread = 0;
+  for (std::string &arg : arg_list) {
+    const dict_t dict = params_to_dict( arg );
+
+    if ( dict.count("tx_spread") && boost::lexical_cast< bool >( dict.at("tx_spread") ) &&
+         ! dict.count("tx_spread_index") )
+      arg += ",tx_spread_index=" + std::to_string( spread++ );
+  }
 
+  /* some backends take seconds to open a device, open all of their
+   * devices at once */
+  std::vector< std::future< backend_t::sink_t > > opening( arg_list.size() );
+  for (size_t i = 0; i < arg_list.size(); i++)
+    if ( find_backend( params_to_dict( arg_list[i] ), backend ) &&
+         backend.make_sink && backend.slow_open )
+      opening[i] = std::async( std::launch::async, backend.make_sink, arg_list[i] );
+
+  for (size_t arg_index = 0; arg_index < arg_list.size(); arg_index++) {
+
+    const std::string &arg = arg_list[ arg_index ];
     dict_t dict = params_to_dict(arg);
 
 //    std::cerr << std::endl;
@@ -183,54 +173,22 @@ sink_impl::sink_impl( const std::string &args )
     sink_iface *iface = NULL;
     gr::basic_block_sptr block;
 
-#ifdef ENABLE_UHD
-    if ( dict.count("uhd") ) {
-      uhd_sink_c_sptr sink = make_uhd_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_HACKRF
-    if ( dict.count("hackrf") ) {
-      hackrf_sink_c_sptr sink = make_hackrf_sink_c( arg );
-      block = sink; iface = sink.get();
+    if ( opening[ arg_index ].valid() ) {
+      backend_t::sink_t sink = opening[ arg_index ].get();
+      block = sink.block; iface = sink.iface;
+    } else if ( find_backend( dict, backend ) && backend.make_sink ) {
+      backend_t::sink_t sink = backend.make_sink( arg );
+      block = sink.block; iface = sink.iface;
     }
-#endif
-#ifdef ENABLE_BLADERF
-    if ( dict.count("bladerf") ) {
-      bladerf_sink_c_sptr sink = make_bladerf_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_SOAPY
-    if ( dict.count("soapy") ) {
-      soapy_sink_c_sptr sink = make_soapy_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_REDPITAYA
-    if ( dict.count("redpitaya") ) {
-      redpitaya_sink_c_sptr sink = make_redpitaya_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_FREESRP
-    if ( dict.count("freesrp") ) {
-      freesrp_sink_c_sptr sink = make_freesrp_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_XTRX
-    if ( dict.count("xtrx") ) {
-      xtrx_sink_c_sptr sink = make_xtrx_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_FILE
-    if ( dict.count("file") ) {
-      file_sink_c_sptr sink = make_file_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
+
+    /* devices taking commands themselves, like file sinks with a trigger,
+     * get every one sent to the command port */
+    if ( block && block->has_msg_port( pmt::mp("command") ) )
+      msg_connect( self(), pmt::mp("command"), block, pmt::mp("command") );
+
+    /* and the ones reporting underflows and late packets pass them on */
+    if ( block && block->has_msg_port( pmt::mp("async_msgs") ) )
+      msg_connect( block, pmt::mp("async_msgs"), self(), pmt::mp("async_msgs") );
 
     if ( iface != NULL && long(block.get()) != 0 ) {
       _devs.push_back( iface );
@@ -246,30 +204,60 @@ sink_impl::sink_impl( const std::string &args )
   if (!_devs.size())
     throw std::runtime_error("No devices specified via device arguments.");
 
-  /* Populate the _gain and _gain_mode arrays with the hardware state */
+  if ( sync.size() ) {
+    sync_device_time( _devs, sync );
+
+    timed_start_sptr start( new timed_start( start_delay ) );
+    for (size_t i = 0; i < _devs.size(); i++)
+      if ( ! _devs[i]->set_timed_start( start ) )
+        std::cerr << "gr-osmosdr: sink device " << i << " can't start at a given time, "
+                  << "it transmits as soon as it starts" << std::endl;
+  }
+
+  /* route every channel to its device once, the setters and getters
+   * are called far too often to search the devices each time */
   for ( sink_iface *dev : _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      _gain_mode[dev_chan] = dev->get_gain_mode(dev_chan);
-      _gain[dev_chan] = dev->get_gain(dev_chan);
+      channel_t ch;
+      ch.dev = dev;
+      ch.dev_chan = dev_chan;
+      _chans.push_back( ch );
     }
+
+  _center_freq.resize( _chans.size(), 0 );
+  _freq_corr.resize( _chans.size(), 0 );
+  _gain_mode.resize( _chans.size(), false );
+  _gain.resize( _chans.size(), 0 );
+  _if_gain.resize( _chans.size(), 0 );
+  _bb_gain.resize( _chans.size(), 0 );
+  _antenna.resize( _chans.size() );
+  _bandwidth.resize( _chans.size(), 0 );
+  _caps.resize( _chans.size() );
+
+  /* Populate the _gain and _gain_mode arrays with the hardware state */
+  for (size_t chan = 0; chan < _chans.size(); chan++) {
+    _gain_mode[chan] = _chans[chan].dev->get_gain_mode( _chans[chan].dev_chan );
+    _gain[chan] = _chans[chan].dev->get_gain( _chans[chan].dev_chan );
+  }
+
+  /* commands sent to the port are applied on a thread of their own */
+  _command = make_command_handler(
+      [this]( const pmt::pmt_t &cmd ) { apply_command( *this, cmd ); },
+      [this]() { return _devs[0]->get_time_now( 0 ); } );
+  msg_connect( self(), pmt::mp("command"), _command, pmt::mp("command") );
 }
 
 size_t sink_impl::get_num_channels()
 {
-  size_t channels = 0;
-
-  for (sink_iface *dev : _devs)
-    channels += dev->get_num_channels();
-
-  return channels;
+  return _chans.size();
 }
 
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
 
 osmosdr::meta_range_t sink_impl::get_sample_rates()
 {
-  if ( ! _devs.empty() )
-    return _devs[0]->get_sample_rates(); // assume same devices used in the group
+  if ( ! _devs.empty() ) // the first device's, the group runs at one rate
+    return _caps.sample_rates( [this]() { return _devs[0]->get_sample_rates(); } );
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -289,6 +277,8 @@ double sink_impl::set_sample_rate(double rate)
     for (sink_iface *dev : _devs)
       sample_rate = dev->set_sample_rate(rate);
 
+    _caps.forget_all();
+
     _sample_rate = sample_rate;
   }
 
@@ -300,7 +290,7 @@ double sink_impl::get_sample_rate()
   double sample_rate = 0;
 
   if (!_devs.empty())
-    sample_rate = _devs[0]->get_sample_rate(); // assume same devices used in the group
+    sample_rate = _devs[0]->get_sample_rate(); // every device was set to it
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -310,297 +300,422 @@ double sink_impl::get_sample_rate()
 
 osmosdr::freq_range_t sink_impl::get_freq_range( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_range( dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::freq_range_t();
+
+  const channel_t &ch = _chans[ chan ];
 
-  return osmosdr::freq_range_t();
+  return _caps.get( chan, &capability_cache::entry_t::freq_range,
+                    [&ch]() { return ch.dev->get_freq_range( ch.dev_chan ); } );
 }
 
 double sink_impl::set_center_freq( double freq, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        } else { return _center_freq[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  if ( _center_freq[ chan ] != freq ) {
+    _center_freq[ chan ] = freq;
+    return ch.dev->set_center_freq( freq, ch.dev_chan );
+  }
+
+  return _center_freq[ chan ];
 }
 
 double sink_impl::get_center_freq( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  return ch.dev->get_center_freq( ch.dev_chan );
 }
 
 double sink_impl::set_freq_corr( double ppm, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        } else { return _freq_corr[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _freq_corr[ chan ] != ppm ) {
+    _freq_corr[ chan ] = ppm;
+    return ch.dev->set_freq_corr( ppm, ch.dev_chan );
+  }
 
-  return 0;
+  return _freq_corr[ chan ];
 }
 
 double sink_impl::get_freq_corr( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  return ch.dev->get_freq_corr( ch.dev_chan );
 }
 
 std::vector<std::string> sink_impl::get_gain_names( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_names( dev_chan );
+  if ( chan >= _chans.size() )
+    return std::vector< std::string >();
+
+  const channel_t &ch = _chans[ chan ];
 
-  return std::vector< std::string >();
+  return _caps.get( chan, &capability_cache::entry_t::gain_names,
+                    [&ch]() { return ch.dev->get_gain_names( ch.dev_chan ); } );
 }
 
 osmosdr::gain_range_t sink_impl::get_gain_range( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::gain_range_t();
 
-  return osmosdr::gain_range_t();
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::gain_range,
+                    [&ch]() { return ch.dev->get_gain_range( ch.dev_chan ); } );
 }
 
 osmosdr::gain_range_t sink_impl::get_gain_range( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( name, dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::gain_range_t();
+
+  const channel_t &ch = _chans[ chan ];
 
-  return osmosdr::gain_range_t();
+  return _caps.gain_range( chan, name,
+                          [&]() { return ch.dev->get_gain_range( name, ch.dev_chan ); } );
 }
 
 bool sink_impl::set_gain_mode( bool automatic, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        } else { return _gain_mode[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return false;
 
-  return false;
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _gain_mode[ chan ] != automatic ) {
+    _gain_mode[ chan ] = automatic;
+    bool mode = ch.dev->set_gain_mode( automatic, ch.dev_chan );
+    if (!automatic) // reapply gain value when switched to manual mode
+      ch.dev->set_gain( _gain[ chan ], ch.dev_chan );
+    return mode;
+  }
+
+  return _gain_mode[ chan ];
 }
 
 bool sink_impl::get_gain_mode( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+  if ( chan >= _chans.size() )
+    return false;
 
-  return false;
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_gain_mode( ch.dev_chan );
 }
 
 double sink_impl::set_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        } else { return _gain[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _gain[ chan ] != gain ) {
+    _gain[ chan ] = gain;
+    return ch.dev->set_gain( gain, ch.dev_chan );
+  }
 
-  return 0;
+  return _gain[ chan ];
 }
 
 double sink_impl::set_gain( double gain, const std::string & name, size_t chan)
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_gain( gain, name, dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->set_gain( gain, name, ch.dev_chan );
 }
 
 double sink_impl::get_gain( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  return ch.dev->get_gain( ch.dev_chan );
 }
 
 double sink_impl::get_gain( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( name, dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  return ch.dev->get_gain( name, ch.dev_chan );
 }
 
 double sink_impl::set_if_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _if_gain[ chan ] != gain ) {
-          _if_gain[ chan ] = gain;
-          return dev->set_if_gain( gain, dev_chan );
-        } else { return _if_gain[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _if_gain[ chan ] != gain ) {
+    _if_gain[ chan ] = gain;
+    return ch.dev->set_if_gain( gain, ch.dev_chan );
+  }
 
-  return 0;
+  return _if_gain[ chan ];
 }
 
 double sink_impl::set_bb_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bb_gain[ chan ] != gain ) {
-          _bb_gain[ chan ] = gain;
-          return dev->set_bb_gain( gain, dev_chan );
-        } else { return _bb_gain[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _bb_gain[ chan ] != gain ) {
+    _bb_gain[ chan ] = gain;
+    return ch.dev->set_bb_gain( gain, ch.dev_chan );
+  }
 
-  return 0;
+  return _bb_gain[ chan ];
 }
 
 std::vector< std::string > sink_impl::get_antennas( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antennas( dev_chan );
+  if ( chan >= _chans.size() )
+    return std::vector< std::string >();
 
-  return std::vector< std::string >();
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::antennas,
+                    [&ch]() { return ch.dev->get_antennas( ch.dev_chan ); } );
 }
 
 std::string sink_impl::set_antenna( const std::string & antenna, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _antenna[ chan ] != antenna ) {
-          _antenna[ chan ] = antenna;
-          return dev->set_antenna( antenna, dev_chan );
-        } else { return _antenna[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return "";
+
+  const channel_t &ch = _chans[ chan ];
 
-  return "";
+  if ( _antenna[ chan ] != antenna ) {
+    _antenna[ chan ] = antenna;
+    _caps.forget( chan );
+    return ch.dev->set_antenna( antenna, ch.dev_chan );
+  }
+
+  return _antenna[ chan ];
 }
 
 std::string sink_impl::get_antenna( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antenna( dev_chan );
+  if ( chan >= _chans.size() )
+    return "";
 
-  return "";
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_antenna( ch.dev_chan );
 }
 
 void sink_impl::set_dc_offset( const std::complex<double> &offset, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset( offset, dev_chan );
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+
+  ch.dev->set_dc_offset( offset, ch.dev_chan );
 }
 
 void sink_impl::set_iq_balance( const std::complex<double> &balance, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_iq_balance( balance, dev_chan );
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+
+  ch.dev->set_iq_balance( balance, ch.dev_chan );
 }
 
 double sink_impl::set_bandwidth( double bandwidth, size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
-          _bandwidth[ chan ] = bandwidth;
-          return dev->set_bandwidth( bandwidth, dev_chan );
-        } else { return _bandwidth[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
+    _bandwidth[ chan ] = bandwidth;
+    return ch.dev->set_bandwidth( bandwidth, ch.dev_chan );
+  }
+
+  return _bandwidth[ chan ];
 }
 
 double sink_impl::get_bandwidth( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_bandwidth( ch.dev_chan );
 }
 
 osmosdr::freq_range_t sink_impl::get_bandwidth_range( size_t chan )
 {
-  size_t channel = 0;
-  for (sink_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth_range( dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::freq_range_t();
+
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::bandwidth_range,
+                    [&ch]() { return ch.dev->get_bandwidth_range( ch.dev_chan ); } );
+}
+
+osmosdr::stream_stats_t sink_impl::get_stream_stats( size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return osmosdr::stream_stats_t();
+
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_stream_stats( ch.dev_chan );
+}
+
+void sink_impl::set_config( const osmosdr::device_t &config, size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+
+  /* the device only gets what the caches don't hold already */
+  osmosdr::device_t changed = config;
+
+  /* the rate is the one of all devices of the group */
+  bool forward_rate = ( 1 == _devs.size() );
+
+  if ( changed.count("rate") && ! forward_rate ) {
+    set_sample_rate( changed.cast< double >( "rate", 0 ) );
+    changed.erase("rate");
+  }
+  filter_cached( changed, "rate", _sample_rate );
+
+  filter_cached( changed, "freq", _center_freq[ chan ] );
+  filter_cached( changed, "freq_corr", _freq_corr[ chan ] );
+  filter_cached( changed, "gain", _gain[ chan ] );
+  filter_cached( changed, "if_gain", _if_gain[ chan ] );
+  filter_cached( changed, "bb_gain", _bb_gain[ chan ] );
+  filter_cached( changed, "antenna", _antenna[ chan ] );
+
+  if ( changed.count("gain_mode") ) {
+    bool automatic = changed.cast< bool >( "gain_mode", false );
+
+    if ( automatic == _gain_mode[ chan ] ) {
+      changed.erase("gain_mode");
+    } else {
+      _gain_mode[ chan ] = automatic;
+      if ( ! automatic && ! changed.count("gain") ) // reapply gain value when switched to manual mode
+        changed["gain"] = boost::lexical_cast< std::string >( _gain[ chan ] );
+    }
+  }
+
+  /* 0 selects the automatic filter, which may depend on the rate */
+  if ( changed.count("bandwidth") ) {
+    double bandwidth = changed.cast< double >( "bandwidth", 0 );
 
-  return osmosdr::freq_range_t();
+    if ( bandwidth != 0 && bandwidth == _bandwidth[ chan ] )
+      changed.erase("bandwidth");
+    else
+      _bandwidth[ chan ] = bandwidth;
+  }
+
+  if ( changed.count("rate") )
+    _caps.forget_all();
+  else if ( changed.count("antenna") )
+    _caps.forget( chan );
+
+  if ( ! changed.empty() )
+    ch.dev->set_config( changed, ch.dev_chan );
+
+  if ( changed.count("rate") )
+    _sample_rate = ch.dev->get_sample_rate();
+}
+
+void sink_impl::set_waveform( const std::vector< gr_complex > &samples, size_t chan )
+{
+  if ( chan >= _chans.size() )
+    throw std::runtime_error( "Channel " + std::to_string( chan ) + " doesn't exist." );
+
+  if ( samples.empty() )
+    throw std::runtime_error( "The waveform is empty." );
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( ! ch.dev->set_waveform( samples, ch.dev_chan ) )
+    throw std::runtime_error( "The device of channel " + std::to_string( chan ) +
+                              " can't loop a waveform." );
+}
+
+void sink_impl::load_waveform( const std::string &filename, const std::string &format,
+                               size_t chan )
+{
+  size_t item_size;
+
+  if ( "cf32" == format )
+    item_size = sizeof(gr_complex);
+  else if ( "cs16" == format )
+    item_size = 2 * sizeof(int16_t);
+  else if ( "cs8" == format )
+    item_size = 2 * sizeof(int8_t);
+  else
+    throw std::runtime_error( "Waveform format must be cf32, cs16 or cs8." );
+
+  std::ifstream file( filename, std::ios::binary );
+  if ( ! file )
+    throw std::runtime_error( "Failed to open waveform file " + filename + "." );
+
+  std::vector< char > raw( (std::istreambuf_iterator< char >( file )),
+                           std::istreambuf_iterator< char >() );
+
+  std::vector< gr_complex > samples( raw.size() / item_size );
+
+  if ( "cf32" == format )
+    std::copy( raw.begin(), raw.begin() + samples.size() * item_size,
+               (char *)samples.data() );
+  else if ( "cs16" == format )
+    convert_s16_fc32( (const int16_t *)raw.data(), samples.data(), samples.size(),
+                      1.0f / 32768.0f );
+  else
+    convert_s8_fc32( (const int8_t *)raw.data(), samples.data(), samples.size() );
+
+  set_waveform( samples, chan );
+}
+
+void sink_impl::clear_waveform( size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+
+  ch.dev->set_waveform( std::vector< gr_complex >(), ch.dev_chan );
 }
 
 void sink_impl::set_time_source(const std::string &source, const size_t mboard)
@@ -654,6 +769,9 @@ double sink_impl::get_clock_rate(size_t mboard)
 
 void sink_impl::set_clock_rate(double rate, size_t mboard)
 {
+  /* the sample rates the device offers follow from the clock */
+  _caps.forget_all();
+
   if (mboard != osmosdr::ALL_MBOARDS){
       _devs.at(mboard)->set_clock_rate( rate );
       return;
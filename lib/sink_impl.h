@@ -23,8 +23,10 @@
 #include "osmosdr/sink.h"
 
 #include "sink_iface.h"
+#include "capability_cache.h"
+#include "command_handler.h"
 
-#include <map>
+#include <vector>
 
 class sink_impl : public osmosdr::sink
 {
@@ -68,6 +70,15 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  void set_config( const osmosdr::device_t &config, size_t chan = 0 );
+
+  void set_waveform( const std::vector< gr_complex > &samples, size_t chan = 0 );
+  void load_waveform( const std::string &filename, const std::string &format = "cf32",
+                      size_t chan = 0 );
+  void clear_waveform( size_t chan = 0 );
+
   void set_time_source(const std::string &source, const size_t mboard = 0);
   std::string get_time_source(const size_t mboard);
   std::vector<std::string> get_time_sources(const size_t mboard);
@@ -83,18 +94,29 @@ public:
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
 private:
+  struct channel_t
+  {
+    sink_iface *dev;
+    size_t dev_chan;
+  };
+
   std::vector< sink_iface * > _devs;
+  std::vector< channel_t > _chans;      // indexed by the channel of the block
+  command_handler_sptr _command;
 
   /* cache to prevent multiple device calls with the same value coming from grc */
   double _sample_rate;
-  std::map< size_t, double > _center_freq;
-  std::map< size_t, double > _freq_corr;
-  std::map< size_t, bool > _gain_mode;
-  std::map< size_t, double > _gain;
-  std::map< size_t, double > _if_gain;
-  std::map< size_t, double > _bb_gain;
-  std::map< size_t, std::string > _antenna;
-  std::map< size_t, double > _bandwidth;
+  std::vector< double > _center_freq;
+  std::vector< double > _freq_corr;
+  std::vector< bool > _gain_mode;
+  std::vector< double > _gain;
+  std::vector< double > _if_gain;
+  std::vector< double > _bb_gain;
+  std::vector< std::string > _antenna;
+  std::vector< double > _bandwidth;
+
+  /* ranges and lists, until the antenna or the rate changes */
+  capability_cache _caps;
 };
 
 #endif /* INCLUDED_OSMOSDR_SINK_IMPL_H */
@@ -0,0 +1,148 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "snapshot_timer.h"
+
+snapshot_timer::snapshot_timer() :
+  _length(0),
+  _period(0),
+  _left(0),
+  _stop(false)
+{
+}
+
+snapshot_timer::~snapshot_timer()
+{
+  stop();
+}
+
+void snapshot_timer::configure( const dict_t &dict )
+{
+  if ( ! dict.count( "snapshot" ) )
+    return;
+
+  std::vector< std::string > tokens;
+  boost::algorithm::split( tokens, dict.at( "snapshot" ), boost::is_any_of( ":" ) );
+
+  if ( tokens.size() != 2 )
+    throw std::runtime_error( "snapshot= takes <len>:<period> in ms." );
+
+  _length = boost::lexical_cast< double >( tokens[0] ) / 1e3;
+  _period = boost::lexical_cast< double >( tokens[1] ) / 1e3;
+
+  if ( _length <= 0 || _period < _length )
+    throw std::runtime_error( "The snapshot length must be positive and at most the period." );
+}
+
+void snapshot_timer::start( const std::function< double() > &rate,
+                            const std::function< bool() > &begin,
+                            const std::function< void() > &end )
+{
+  stop();
+
+  if ( ! enabled() )
+    return;
+
+  _rate = rate;
+  _begin = begin;
+  _end = end;
+  _stop = false;
+  _thread = std::thread( &snapshot_timer::run, this );
+}
+
+void snapshot_timer::stop()
+{
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _stop = true;
+  }
+  _cond.notify_all();
+
+  if ( _thread.joinable() )
+    _thread.join();
+}
+
+size_t snapshot_timer::take( size_t nsamples )
+{
+  if ( _stop )
+    return 0;
+
+  /* only the callback takes, so nobody else lowers it meanwhile */
+  const size_t left = _left.load();
+  const size_t n = std::min( left, nsamples );
+
+  _left -= n;
+
+  if ( n && n == left ) {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _cond.notify_all();
+  }
+
+  return n;
+}
+
+void snapshot_timer::cut()
+{
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _left = 0;
+  }
+  _cond.notify_all();
+}
+
+void snapshot_timer::run()
+{
+  typedef std::chrono::steady_clock clock;
+  const clock::duration period =
+      std::chrono::duration_cast< clock::duration >( std::chrono::duration< double >( _period ) );
+
+  clock::time_point next = clock::now();
+  std::unique_lock< std::mutex > lock( _mutex );
+
+  while ( ! _cond.wait_until( lock, next, [this]() { return bool( _stop ); } ) ) {
+    _left = size_t( _length * _rate() + 0.5 );
+
+    lock.unlock();
+    const bool streaming = _begin();
+    lock.lock();
+
+    if ( streaming )
+      _cond.wait( lock, [this]() { return _stop || _left == 0; } );
+    _left = 0;
+
+    lock.unlock();
+    _end();
+    lock.lock();
+
+    const clock::time_point now = clock::now();
+    do
+      next += period;
+    while ( next <= now );
+  }
+}
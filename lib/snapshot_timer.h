@@ -0,0 +1,94 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SNAPSHOT_TIMER_H
+#define OSMOSDR_SNAPSHOT_TIMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * Streams a USB device only in short windows, with snapshot=<len>:<period>
+ * in ms: len out of every period, the device and the bus are idle in
+ * between.
+ *
+ * At the start of each window the timer thread calls begin, which starts
+ * streaming and re-anchors the rx_time tags. The callback of the device
+ * library hands every transfer to take(), which tells how much of it is
+ * still part of the window. Once the window is full the thread calls end
+ * to stop streaming. The windows stay on the grid of the period from
+ * start(), one that can't start in time is skipped.
+ */
+class OSMOSDR_API snapshot_timer
+{
+public:
+  snapshot_timer();
+  ~snapshot_timer();
+
+  /*! the windows from snapshot=<len>:<period>, disabled without it */
+  void configure( const dict_t &dict );
+
+  bool enabled() const { return _period > 0; }
+
+  /*!
+   * Capture from now on. \p rate is asked for the sample rate of every
+   * window before \p begin, which returns whether the device streams it.
+   * The window ends on the spot when it doesn't, either because it failed
+   * or because it blocked until the window was full.
+   */
+  void start( const std::function< double() > &rate,
+              const std::function< bool() > &begin,
+              const std::function< void() > &end );
+  void stop();
+
+  /*!
+   * Producer side: of \p nsamples arriving, the number at their start that
+   * belong to the window, less than asked once it's full or stopped.
+   */
+  size_t take( size_t nsamples );
+
+  /*! ends the window early, for a stream that got stopped in between */
+  void cut();
+
+private:
+  void run();
+
+  double _length;               // in s
+  double _period;               // in s, 0 when disabled
+
+  std::function< double() > _rate;
+  std::function< bool() > _begin;
+  std::function< void() > _end;
+
+  std::atomic< size_t > _left;  // samples the window still takes
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  std::atomic< bool > _stop;
+  std::thread _thread;
+};
+
+#endif // OSMOSDR_SNAPSHOT_TIMER_H
@@ -19,7 +19,11 @@
  */
 
 #include "soapy_common.h"
+#include <map>
+#include <memory>
 #include <SoapySDR/Version.hpp>
+#include <SoapySDR/Device.hpp>
+#include <SoapySDR/Formats.hpp>
 
 osmosdr::gain_range_t soapy_range_to_gain_range(const SoapySDR::Range &r)
 {
@@ -36,8 +40,45 @@ osmosdr::gain_range_t soapy_range_to_gain_range(const SoapySDR::Range &r)
     return osmosdr::gain_range_t(r.minimum(), r.maximum(), step);
 }
 
-std::mutex &get_soapy_maker_mutex(void)
+std::string soapy_host_stream_format(SoapySDR::Device *device, const int direction,
+                                     double &full_scale)
 {
-    static std::mutex m;
-    return m;
+    std::string format = device->getNativeStreamFormat(direction, 0, full_scale);
+
+    if (format == SOAPY_SDR_CS16 && full_scale > 0) return SOAPY_SDR_CS16;
+
+    //the driver widens CS12 to the full 16 bit range
+    if (format == SOAPY_SDR_CS12)
+    {
+        full_scale = 32768;
+        return SOAPY_SDR_CS16;
+    }
+
+    //the int8 kernels have their scale built in
+    if (format == SOAPY_SDR_CS8 && full_scale == 128) return SOAPY_SDR_CS8;
+
+    return SOAPY_SDR_CF32;
+}
+
+std::mutex &get_soapy_maker_mutex(const std::string &driver)
+{
+    static std::mutex map_mutex;
+    static std::map<std::string, std::unique_ptr<std::mutex>> mutexes;
+
+    std::lock_guard<std::mutex> l(map_mutex);
+
+    #if defined(SOAPY_SDR_API_VERSION) && (SOAPY_SDR_API_VERSION >= 0x00060000)
+    std::unique_ptr<std::mutex> &m = mutexes[driver];
+    #else
+    std::unique_ptr<std::mutex> &m = mutexes[""];
+    #endif
+
+    if (!m) m.reset(new std::mutex);
+    return *m;
+}
+
+std::string soapy_driver_key(const SoapySDR::Kwargs &args)
+{
+    SoapySDR::Kwargs::const_iterator it = args.find("driver");
+    return it == args.end() ? "" : it->second;
 }
@@ -24,8 +24,15 @@
 #include <osmosdr/ranges.h>
 #include <SoapySDR/Types.hpp>
 
+#include <string>
+
 #include <mutex>
 
+namespace SoapySDR
+{
+    class Device;
+}
+
 /*!
  * Convert a soapy range to a gain range.
  * Careful to deal with the step size when zero.
@@ -33,9 +40,28 @@
 osmosdr::gain_range_t soapy_range_to_gain_range(const SoapySDR::Range &r);
 
 /*!
- * Global mutex to protect factory routines.
- * (optional under 0.5 release above)
+ * Pick the format to stream in when samples are converted to or from
+ * gr_complex on the host, rather than by the driver's own converter.
+ * This is the native format of the device when we have a kernel for it,
+ * CS12 is asked for as CS16 since unpacking it is cheap for the driver.
+ * Returns CF32 when there is nothing to gain, otherwise \p full_scale is
+ * set to the magnitude of +/-1.0 in the returned format.
+ */
+std::string soapy_host_stream_format(SoapySDR::Device *device, const int direction,
+                                     double &full_scale);
+
+/*!
+ * Mutex to protect the factory routines of one driver, so devices of
+ * different drivers can be made and unmade at the same time. SoapySDR
+ * itself is safe to call concurrently from 0.6 on, before that there is
+ * only one mutex for all of them. Devices made without a driver key
+ * share the mutex of the "" driver.
+ */
+std::mutex &get_soapy_maker_mutex(const std::string &driver);
+
+/*!
+ * The driver key of the factory args, for get_soapy_maker_mutex().
  */
-std::mutex &get_soapy_maker_mutex(void);
+std::string soapy_driver_key(const SoapySDR::Kwargs &args);
 
 #endif /* INCLUDED_SOAPY_COMMON_H */
@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <algorithm> //find
+#include <cstring>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -40,8 +41,10 @@
 #include "arg_helpers.h"
 #include "soapy_sink_c.h"
 #include "soapy_common.h"
+#include "sample_convert.h"
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Version.hpp>
+#include <SoapySDR/Formats.hpp>
 
 using namespace boost::assign;
 
@@ -62,25 +65,66 @@ soapy_sink_c::soapy_sink_c (const std::string &args)
                     args_to_io_signature(args),
                     gr::io_signature::make (0, 0, 0))
 {
+    dict_t dict = params_to_dict(args);
+    _driver = soapy_driver_key(dict);
     {
-        std::lock_guard<std::mutex> l(get_soapy_maker_mutex());
-        _device = SoapySDR::Device::make(params_to_dict(args));
+        std::lock_guard<std::mutex> l(get_soapy_maker_mutex(_driver));
+        _device = SoapySDR::Device::make(dict);
     }
     _nchan = std::max(1, args_to_io_signature(args)->max_streams());
     std::vector<size_t> channels;
     for (size_t i = 0; i < _nchan; i++) channels.push_back(i);
-    _stream = _device->setupStream(SOAPY_SDR_TX, "CF32", channels);
+
+    //stream in the native format and convert with our own kernels,
+    //one below full scale so +1.0 does not wrap on the narrower DACs
+    double full_scale = 0;
+    _format = soapy_host_stream_format(_device, SOAPY_SDR_TX, full_scale);
+    _scale = float(full_scale - 1);
+    _stream = _device->setupStream(SOAPY_SDR_TX, _format, channels);
+
+    //the driver buffers are converted into in place, if it has any
+    _direct = dict.count("direct") && dict["direct"] != "0";
+    if (_direct && _device->getNumDirectAccessBuffers(_stream) == 0)
+    {
+        std::cerr << "-- Soapy driver has no direct access buffers, "
+                  << "using writeStream()" << std::endl;
+        _direct = false;
+    }
+    _direct_buffs.assign(_nchan, NULL);
+
+    if (_format != SOAPY_SDR_CF32 && !_direct)
+    {
+        _buf_items = std::max(_device->getStreamMTU(_stream), size_t(8192));
+        _buf.resize(_nchan);
+        for (size_t i = 0; i < _nchan; i++)
+        {
+            _buf[i].resize(_buf_items * SoapySDR::formatToSize(_format));
+            _buf_ptrs.push_back(&_buf[i][0]);
+        }
+    }
+
+    //the samples are only at hand for it when they are converted here
+    _pacer.init(tx_policy_from_dict(dict), _nchan);
+    if (_pacer.policy().underrun == tx_policy_t::UNDERRUN_REPEAT && _buf.empty())
+        std::cerr << "-- Soapy stream takes the samples as they are, "
+                  << "an underrun is filled with zeros" << std::endl;
+
+    _has_status = true;
+    _last_items = 0;
+    _tags_warned = false;
 }
 
 soapy_sink_c::~soapy_sink_c(void)
 {
     _device->closeStream(_stream);
-    std::lock_guard<std::mutex> l(get_soapy_maker_mutex());
+    std::lock_guard<std::mutex> l(get_soapy_maker_mutex(_driver));
     SoapySDR::Device::unmake(_device);
 }
 
 bool soapy_sink_c::start()
 {
+    _last_items = 0;
+    _pacer.start(get_sample_rate());
     return _device->activateStream(_stream) == 0;
 }
 
@@ -89,20 +133,249 @@ bool soapy_sink_c::stop()
     return _device->deactivateStream(_stream) == 0;
 }
 
+void soapy_sink_c::copy_in(const void *in, void *out, size_t nitems)
+{
+    const convert_kernels_t &kernels = convert_get_kernels();
+
+    if (_format == SOAPY_SDR_CS16)
+        kernels.f32_s16((const float *)in, (int16_t *)out, nitems * 2, _scale);
+    else if (_format == SOAPY_SDR_CS8)
+        kernels.f32_s8((const float *)in, (int8_t *)out, nitems * 2, _scale);
+    else
+        std::memcpy(out, in, nitems * sizeof(gr_complex));
+}
+
 int soapy_sink_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
+    check_underrun();
+
+    //the prefill is written in one go once it is complete
+    const bool held = _pacer.prefill(input_items, noutput_items);
+    if (held && !_tags_warned)
+    {
+        get_tags_in_window(_tags, 0, 0, noutput_items);
+        if (!_tags.empty())
+        {
+            std::cerr << "-- Soapy sink ignores the tags within the prefill" << std::endl;
+            _tags_warned = true;
+        }
+    }
+
+    while (_pacer.held())
+    {
+        int ret = write(_pacer.held_items(), int(_pacer.held()), false);
+        if (ret <= 0) return held ? noutput_items : 0; //call again
+        _pacer.consume_held(ret);
+    }
+
+    if (held) return noutput_items;
+
+    _pacer.throttle();
+
+    return write(input_items, noutput_items, true);
+}
+
+int soapy_sink_c::write( const gr_vector_const_void_star &items, int nitems, bool tagged )
+{
+    if (_direct) return write_direct(items, nitems, tagged);
+
     int flags = 0;
     long long timeNs = 0;
+
+    if (!_buf.empty())
+        nitems = std::min(nitems, int(_buf_items));
+
+    if (tagged)
+    {
+        nitems = apply_tune_tags(nitems);
+        nitems = apply_tags(nitems, flags, timeNs);
+    }
+
+    const void * const *buffs = &items[0];
+    if (!_buf.empty())
+    {
+        buffs = &_buf_ptrs[0];
+
+        for (size_t i = 0; i < _nchan; i++)
+            copy_in(items[i], &_buf[i][0], nitems);
+    }
+
     int ret = _device->writeStream(
-        _stream, &input_items[0],
-        noutput_items, flags, timeNs);
+        _stream, buffs,
+        nitems, flags, timeNs);
+
+    if (ret == SOAPY_SDR_UNDERFLOW)
+    {
+        _pacer.underrun();
+        _stats.underruns++;
+        std::cerr << "U" << std::flush;
+    }
 
     if (ret < 0) return 0; //call again
+
+    _pacer.written(ret);
+    _stats.samples += ret;
+    _last_items = ret;
     return ret;
 }
 
+int soapy_sink_c::write_direct( const gr_vector_const_void_star &items, int nitems, bool tagged )
+{
+    size_t handle;
+
+    int ret = _device->acquireWriteBuffer(_stream, handle, &_direct_buffs[0]);
+    if (ret < 0) return 0; //call again
+
+    int flags = 0;
+    long long timeNs = 0;
+
+    nitems = std::min(nitems, ret);
+    if (tagged)
+    {
+        nitems = apply_tune_tags(nitems);
+        nitems = apply_tags(nitems, flags, timeNs);
+    }
+
+    for (size_t i = 0; i < _nchan; i++)
+        copy_in(items[i], _direct_buffs[i], nitems);
+
+    _device->releaseWriteBuffer(_stream, handle, nitems, flags, timeNs);
+
+    _pacer.written(nitems);
+    _stats.samples += nitems;
+    return nitems;
+}
+
+/*
+ * Drivers with a stream status tell of their underflows, for the others
+ * the pacer guesses them from the host clock. With underrun=repeat the
+ * last converted buffer goes out again, with underrun=stop the burst ends
+ * and the next samples are prefilled again.
+ */
+void soapy_sink_c::check_underrun()
+{
+    bool underrun = false;
+
+    if (_has_status)
+    {
+        size_t chanMask = 0;
+        int flags = 0;
+        long long timeNs = 0;
+
+        int ret = _device->readStreamStatus(_stream, chanMask, flags, timeNs, 0);
+        if (ret == SOAPY_SDR_NOT_SUPPORTED)
+            _has_status = false;
+        else if (ret == SOAPY_SDR_UNDERFLOW)
+            underrun = true;
+
+        if (underrun)
+            _pacer.underrun();
+    }
+
+    if (!_has_status)
+        underrun = _pacer.starved();
+
+    if (!underrun) return;
+
+    _stats.underruns++;
+    std::cerr << "U" << std::flush;
+
+    if (_pacer.policy().underrun == tx_policy_t::UNDERRUN_REPEAT && !_buf.empty() && _last_items > 0)
+    {
+        int flags = 0;
+        _device->writeStream(_stream, &_buf_ptrs[0], _last_items, flags, 0);
+    }
+    else if (_pacer.policy().underrun == tx_policy_t::UNDERRUN_STOP)
+    {
+        int flags = SOAPY_SDR_END_BURST;
+        std::vector<const void *> none(_nchan, NULL);
+        _device->writeStream(_stream, &none[0], 0, flags, 0);
+    }
+}
+
+/*
+ * Turn the tx_time, tx_sob and tx_eob tags into stream flags. The samples
+ * are handed to the driver up to the next tag, so a tx_time always lands
+ * on the first sample of a write and tx_eob on the last one. Returns the
+ * number of samples to write now.
+ */
+int soapy_sink_c::apply_tags( int noutput_items, int &flags, long long &timeNs )
+{
+    static const pmt::pmt_t SOB_KEY = pmt::string_to_symbol("tx_sob");
+    static const pmt::pmt_t EOB_KEY = pmt::string_to_symbol("tx_eob");
+    static const pmt::pmt_t TIME_KEY = pmt::string_to_symbol("tx_time");
+
+    const uint64_t start = nitems_read(0);
+    const uint64_t end = start + noutput_items;
+
+    get_tags_in_range(_tags, 0, start, end);
+    std::sort(_tags.begin(), _tags.end(), gr::tag_t::offset_compare);
+
+    for (const gr::tag_t &tag : _tags)
+    {
+        if (tag.offset >= end) break;
+
+        if (pmt::equal(tag.key, TIME_KEY) || pmt::equal(tag.key, SOB_KEY))
+        {
+            //starts the next write
+            if (tag.offset > start)
+            {
+                noutput_items = int(tag.offset - start);
+                break;
+            }
+
+            if (pmt::equal(tag.key, TIME_KEY))
+            {
+                timeNs = (long long)pmt::to_uint64(pmt::tuple_ref(tag.value, 0)) * 1000000000LL +
+                         (long long)(pmt::to_double(pmt::tuple_ref(tag.value, 1)) * 1e9);
+                flags |= SOAPY_SDR_HAS_TIME;
+            }
+        }
+        else if (pmt::equal(tag.key, EOB_KEY))
+        {
+            //ends this one, inclusive
+            noutput_items = int(tag.offset - start + 1);
+            flags |= SOAPY_SDR_END_BURST;
+            break;
+        }
+    }
+
+    return noutput_items;
+}
+
+/*
+ * Soapy has no timed commands, so a write ends in front of a tx_freq or
+ * tx_gain tag. Once the samples before it went out, by the host clock,
+ * the change is made and the write starts with the tagged sample.
+ */
+int soapy_sink_c::apply_tune_tags( int noutput_items )
+{
+    const uint64_t start = nitems_read(0);
+    std::vector<tx_tune_t> tunes(_nchan);
+    bool tune = false;
+
+    for (size_t i = 0; i < _nchan; i++)
+    {
+        get_tags_in_range(_tags, i, start, start + noutput_items);
+        noutput_items = tx_tune_from_tags(_tags, start, noutput_items, tunes[i]);
+        tune |= !tunes[i].empty();
+    }
+
+    if (!tune) return noutput_items;
+
+    _pacer.drain();
+
+    for (size_t i = 0; i < _nchan; i++)
+    {
+        if (tunes[i].has_freq) set_center_freq(tunes[i].freq, i);
+        if (tunes[i].has_gain) set_gain(tunes[i].gain, i);
+    }
+
+    return noutput_items;
+}
+
 std::vector<std::string> soapy_sink_c::get_devices()
 {
     std::vector<std::string> result;
@@ -390,3 +663,14 @@ void soapy_sink_c::set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec)
     _device->setHardwareTime(time_spec.to_ticks(1e9), "UNKNOWN_PPS");
 }
 
+
+osmosdr::stream_stats_t soapy_sink_c::get_stream_stats( size_t chan )
+{
+    osmosdr::stream_stats_t stats = _stats;
+
+    //by the host clock, the driver doesn't tell its queue depth
+    stats.fill = _pacer.queued();
+    stats.capacity = _pacer.policy().latency_samples(get_sample_rate());
+
+    return stats;
+}
@@ -26,6 +26,8 @@
 
 #include "osmosdr/ranges.h"
 #include "sink_iface.h"
+#include "tx_policy.h"
+#include "tx_tune.h"
 
 class soapy_sink_c;
 
@@ -128,11 +130,37 @@ void set_time_now(const ::osmosdr::time_spec_t &time_spec,
                             size_t mboard);
 void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
 void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
+osmosdr::stream_stats_t get_stream_stats( size_t chan );
 
 private:
+    void copy_in(const void *in, void *out, size_t nitems);
+    int write(const gr_vector_const_void_star &items, int nitems, bool tagged);
+    int write_direct(const gr_vector_const_void_star &items, int nitems, bool tagged);
+    int apply_tags(int noutput_items, int &flags, long long &timeNs);
+    int apply_tune_tags(int noutput_items);
+    void check_underrun();
+
+    std::string _driver;
     SoapySDR::Device *_device;
     SoapySDR::Stream *_stream;
     size_t _nchan;
+
+    std::string _format;                    // what the stream takes
+    float _scale;                           // of gr_complex to the format
+    size_t _buf_items;
+    std::vector< std::vector<char> > _buf;  // per channel, unless CF32
+    std::vector<const void *> _buf_ptrs;
+
+    bool _direct;                           // direct=1, driver buffers
+    std::vector<void *> _direct_buffs;
+
+    std::vector<gr::tag_t> _tags;
+
+    tx_pacer _pacer;                        // prefill, underruns without a status
+    bool _has_status;                       // the driver reports underflows
+    int _last_items;                        // in _buf from the last write
+    bool _tags_warned;
+    osmosdr::stream_stats_t _stats;
 };
 
 #endif /* INCLUDED_SOAPY_SINK_C_H */
@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <algorithm> //find
+#include <cstring>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -40,9 +41,13 @@
 #include "arg_helpers.h"
 #include "soapy_source_c.h"
 #include "soapy_common.h"
+#include "sample_convert.h"
+#include "stream_tagger.h"
+#include "tick_time.h"
 #include "osmosdr/source.h"
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Version.hpp>
+#include <SoapySDR/Formats.hpp>
 
 using namespace boost::assign;
 
@@ -63,52 +68,254 @@ soapy_source_c::soapy_source_c (const std::string &args)
                     gr::io_signature::make (0, 0, 0),
                     args_to_io_signature(args))
 {
+    dict_t dict = params_to_dict(args);
+    _driver = soapy_driver_key(dict);
     {
-        std::lock_guard<std::mutex> l(get_soapy_maker_mutex());
-        _device = SoapySDR::Device::make(params_to_dict(args));
+        std::lock_guard<std::mutex> l(get_soapy_maker_mutex(_driver));
+        _device = SoapySDR::Device::make(dict);
     }
     _nchan = std::max(1, args_to_io_signature(args)->max_streams());
+
+    _direct = dict.count("direct") && dict["direct"] != "0";
+    _direct_left = 0;
+
+    _rate = 0;
+    _rate_changed = false;
+    _tag_time = true;
+    _have_time = false;
+    _next_ns = 0;
+
+    //stream in the native format and convert with our own kernels
+    double full_scale = 0;
+    std::string format = soapy_host_stream_format(_device, SOAPY_SDR_RX, full_scale);
+    _scale = format == SOAPY_SDR_CS16 ? float(1.0 / full_scale) : 1.0f;
+    _convert = format != SOAPY_SDR_CF32;
+    _convert_pool.set_threads(convert_pool::threads_from_dict(dict));
+    _stream = NULL;
+    setup_stream(format);
+}
+
+void soapy_source_c::setup_stream(const std::string &format)
+{
     std::vector<size_t> channels;
     for (size_t i = 0; i < _nchan; i++) channels.push_back(i);
-    _stream = _device->setupStream(SOAPY_SDR_RX, "CF32", channels);
+
+    if (_stream != NULL) _device->closeStream(_stream);
+    _stream = _device->setupStream(SOAPY_SDR_RX, format, channels);
+    _format = format;
+    _item_size = SoapySDR::formatToSize(format);
+
+    //the driver buffers are converted from in place, if it has any
+    if (_direct && _device->getNumDirectAccessBuffers(_stream) == 0)
+    {
+        std::cerr << "-- Soapy driver has no direct access buffers, "
+                  << "using readStream()" << std::endl;
+        _direct = false;
+    }
+    _direct_buffs.assign(_nchan, NULL);
+
+    _buf.clear();
+    _buf_ptrs.clear();
+    if (!_convert || _direct) return;
+
+    _buf_items = std::max(_device->getStreamMTU(_stream), size_t(8192));
+    _buf.resize(_nchan);
+    for (size_t i = 0; i < _nchan; i++)
+    {
+        _buf[i].resize(_buf_items * _item_size);
+        _buf_ptrs.push_back(&_buf[i][0]);
+    }
 }
 
 soapy_source_c::~soapy_source_c(void)
 {
     _device->closeStream(_stream);
-    std::lock_guard<std::mutex> l(get_soapy_maker_mutex());
+    std::lock_guard<std::mutex> l(get_soapy_maker_mutex(_driver));
     SoapySDR::Device::unmake(_device);
 }
 
 bool soapy_source_c::start()
 {
+    _rate = get_sample_rate();
+    _rate_changed = false;
+    _tag_time = true;
+    _have_time = false;
+
     return _device->activateStream(_stream) == 0;
 }
 
 bool soapy_source_c::stop()
 {
+    if (_direct_left)
+    {
+        _device->releaseReadBuffer(_stream, _direct_handle);
+        _direct_left = 0;
+    }
+
     return _device->deactivateStream(_stream) == 0;
 }
 
+void soapy_source_c::copy_out(const void *in, void *out, size_t nitems)
+{
+    if (!_convert)
+        std::memcpy(out, in, nitems * _item_size);
+    else if (_format == SOAPY_SDR_CS16)
+        convert_s16_fc32((const int16_t *)in, (gr_complex *)out, nitems, _scale);
+    else
+        convert_s8_fc32((const int8_t *)in, (gr_complex *)out, nitems);
+}
+
+/* every channel from \p offset on, in chunks spread over the conversion
+ * threads */
+void soapy_source_c::copy_out_all(const void *const *in, size_t offset,
+                                  gr_vector_void_star &out, size_t nitems)
+{
+    const size_t out_size = _convert ? sizeof(gr_complex) : _item_size;
+
+    _convert_pool.run(nitems, [&](size_t begin, size_t end) {
+        for (size_t i = 0; i < _nchan; i++)
+            copy_out((const char *)in[i] + (offset + begin) * _item_size,
+                     (char *)out[i] + begin * out_size, end - begin);
+    });
+}
+
 int soapy_source_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
+    if (_direct) return work_direct(noutput_items, output_items);
+
     int flags = 0;
     long long timeNs = 0;
-    int ret;
-    int retries = 1;
 
-    do {
-        ret = _device->readStream(
-            _stream, &output_items[0],
-            noutput_items, flags, timeNs);
-    } while (retries-- && (ret == SOAPY_SDR_OVERFLOW));
+    void * const *buffs = &output_items[0];
+    if (_convert)
+    {
+        buffs = &_buf_ptrs[0];
+        noutput_items = std::min(noutput_items, int(_buf_items));
+    }
+
+    int ret = _device->readStream(
+        _stream, buffs,
+        noutput_items, flags, timeNs);
 
+    if (ret == SOAPY_SDR_OVERFLOW) overflow();
     if (ret < 0) return 0; //call again
+
+    tag_time(flags, timeNs, ret);
+
+    if (_convert)
+        copy_out_all(&_buf_ptrs[0], 0, output_items, ret);
+
+    _stats.samples += ret;
+
     return ret;
 }
 
+void soapy_source_c::overflow(void)
+{
+    _stats.overruns++;
+    _tag_time = true;
+    std::cerr << "O" << std::flush;
+}
+
+/* rx_time, rx_rate and rx_freq go out at stream start, after an overflow
+ * and whenever the timestamps jump, which means samples got lost without
+ * the driver telling us. They are placed on the first of nitems samples
+ * about to be produced. */
+void soapy_source_c::tag_time(int flags, long long timeNs, size_t nitems)
+{
+    if (_rate_changed.exchange(false))
+    {
+        _rate = get_sample_rate();
+        _tag_time = true;
+        _have_time = false;
+    }
+
+    if (!(flags & SOAPY_SDR_HAS_TIME) || _rate <= 0)
+    {
+        _have_time = false;
+        return;
+    }
+
+    if (_have_time)
+    {
+        const long long gap = timeNs - _next_ns;
+        const long long tolerance = (long long)(1e9 / _rate) + 1;
+
+        //an overflow reported by the driver was counted already
+        if ((gap > tolerance || gap < -tolerance) && !_tag_time)
+        {
+            _stats.overruns++;
+            std::cerr << "O" << std::flush;
+            _tag_time = true;
+        }
+
+        if (gap > tolerance)
+            _stats.dropped += (uint64_t)(gap * _rate / 1e9 + 0.5);
+    }
+
+    if (_tag_time)
+    {
+        const pmt::pmt_t time = tick_time_t(timeNs, 1e9).to_rx_time();
+
+        for (size_t i = 0; i < _nchan; i++)
+        {
+            add_item_tag(i, nitems_written(i), stream_tagger::TIME_KEY(), time, alias_pmt());
+            add_item_tag(i, nitems_written(i), stream_tagger::RATE_KEY(),
+                         pmt::from_double(_rate), alias_pmt());
+            add_item_tag(i, nitems_written(i), stream_tagger::FREQ_KEY(),
+                         pmt::from_double(get_center_freq(i)), alias_pmt());
+        }
+    }
+
+    _tag_time = false;
+    _have_time = true;
+    _next_ns = timeNs + (long long)(nitems * 1e9 / _rate);
+}
+
+/* A driver buffer is usually larger than what the scheduler asks for,
+ * so it is held across work() calls until all of it got converted. */
+int soapy_source_c::work_direct( int noutput_items,
+                                 gr_vector_void_star &output_items )
+{
+    if (!_direct_left)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+
+        int ret = _device->acquireReadBuffer(
+            _stream, _direct_handle, &_direct_buffs[0],
+            flags, timeNs);
+
+        if (ret == SOAPY_SDR_OVERFLOW) overflow();
+        if (ret < 0) return 0; //call again
+        if (ret == 0)
+        {
+            _device->releaseReadBuffer(_stream, _direct_handle);
+            return 0;
+        }
+
+        tag_time(flags, timeNs, ret);
+
+        _direct_left = ret;
+        _direct_offset = 0;
+    }
+
+    size_t nitems = std::min(size_t(noutput_items), _direct_left);
+
+    copy_out_all(&_direct_buffs[0], _direct_offset, output_items, nitems);
+
+    _direct_offset += nitems;
+    _direct_left -= nitems;
+
+    if (!_direct_left) _device->releaseReadBuffer(_stream, _direct_handle);
+
+    _stats.samples += nitems;
+
+    return nitems;
+}
+
 std::vector<std::string> soapy_source_c::get_devices()
 {
     std::vector<std::string> result;
@@ -126,6 +333,23 @@ size_t soapy_source_c::get_num_channels( void )
     return _nchan;
 }
 
+bool soapy_source_c::set_output_type( const std::string &type )
+{
+    std::string format;
+    if (type == "sc16") format = SOAPY_SDR_CS16;
+    else if (type == "sc8") format = SOAPY_SDR_CS8;
+    else return type == "fc32";
+
+    //native samples are passed through as they come
+    _convert = false;
+    setup_stream(format);
+
+    set_output_signature(gr::io_signature::make(
+        _nchan, _nchan, item_type_to_size(type)));
+
+    return true;
+}
+
 osmosdr::meta_range_t soapy_source_c::get_sample_rates( void )
 {
     osmosdr::meta_range_t result;
@@ -146,6 +370,7 @@ osmosdr::meta_range_t soapy_source_c::get_sample_rates( void )
 double soapy_source_c::set_sample_rate( double rate )
 {
     _device->setSampleRate(SOAPY_SDR_RX, 0, rate);
+    _rate_changed = true;
     return this->get_sample_rate();
 }
 
@@ -320,6 +545,17 @@ void soapy_source_c::set_iq_balance( const std::complex<double> &balance, size_t
     _device->setIQBalance(SOAPY_SDR_RX, chan, balance);
 }
 
+bool soapy_source_c::has_dc_offset_correction( size_t chan )
+{
+    return _device->hasDCOffsetMode(SOAPY_SDR_RX, chan) ||
+           _device->hasDCOffset(SOAPY_SDR_RX, chan);
+}
+
+bool soapy_source_c::has_iq_balance_correction( size_t chan )
+{
+    return _device->hasIQBalance(SOAPY_SDR_RX, chan);
+}
+
 double soapy_source_c::set_bandwidth( double bandwidth, size_t chan )
 {
     if ( bandwidth == 0.0 ) /* bandwidth of 0 means automatic filter selection */
@@ -418,3 +654,8 @@ void soapy_source_c::set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spe
 {
     _device->setHardwareTime(time_spec.to_ticks(1e9), "UNKNOWN_PPS");
 }
+
+osmosdr::stream_stats_t soapy_source_c::get_stream_stats( size_t chan )
+{
+    return _stats;
+}
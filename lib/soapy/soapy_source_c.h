@@ -21,11 +21,14 @@
 #ifndef INCLUDED_SOAPY_SOURCE_C_H
 #define INCLUDED_SOAPY_SOURCE_C_H
 
+#include <atomic>
+
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
 
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
+#include "convert_pool.h"
 
 class soapy_source_c;
 
@@ -81,6 +84,7 @@ public:
   static std::vector< std::string > get_devices();
 
 size_t get_num_channels( void );
+bool set_output_type( const std::string &type );
 osmosdr::meta_range_t get_sample_rates( void );
 double set_sample_rate( double rate );
 double get_sample_rate( void );
@@ -111,6 +115,8 @@ void set_dc_offset_mode( int mode, size_t chan );
 void set_dc_offset( const std::complex<double> &offset, size_t chan );
 void set_iq_balance_mode( int mode, size_t chan );
 void set_iq_balance( const std::complex<double> &balance, size_t chan );
+bool has_dc_offset_correction( size_t chan );
+bool has_iq_balance_correction( size_t chan );
 double set_bandwidth( double bandwidth, size_t chan );
 double get_bandwidth( size_t chan ) ;
 osmosdr::freq_range_t get_bandwidth_range( size_t chan );
@@ -130,11 +136,43 @@ void set_time_now(const ::osmosdr::time_spec_t &time_spec,
                             size_t mboard);
 void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
 void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
+osmosdr::stream_stats_t get_stream_stats( size_t chan );
 
 private:
+    void setup_stream(const std::string &format);
+    void copy_out(const void *in, void *out, size_t nitems);
+    void copy_out_all(const void *const *in, size_t offset,
+                      gr_vector_void_star &out, size_t nitems);
+    int work_direct(int noutput_items, gr_vector_void_star &output_items);
+    void overflow(void);
+    void tag_time(int flags, long long timeNs, size_t nitems);
+
+    std::string _driver;
     SoapySDR::Device *_device;
     SoapySDR::Stream *_stream;
     size_t _nchan;
+
+    std::string _format;                    // what the stream delivers
+    bool _convert;                          // into gr_complex in work()
+    float _scale;                           // of CS16 to gr_complex
+    size_t _item_size;                      // of the stream format
+    convert_pool _convert_pool;             // convert_threads=
+    size_t _buf_items;
+    std::vector< std::vector<char> > _buf;  // per channel, when converting
+    std::vector<void *> _buf_ptrs;
+
+    bool _direct;                           // direct=1, driver buffers
+    size_t _direct_handle;
+    size_t _direct_offset;                  // already consumed
+    size_t _direct_left;                    // still to be consumed
+    std::vector<const void *> _direct_buffs;
+
+    osmosdr::stream_stats_t _stats;
+    double _rate;                           // what the timestamps count in
+    std::atomic<bool> _rate_changed;
+    bool _tag_time;                         // at the next timestamp
+    bool _have_time;
+    long long _next_ns;                     // expected next timestamp
 };
 
 #endif /* INCLUDED_SOAPY_SOURCE_C_H */
@@ -21,7 +21,9 @@
 #ifndef OSMOSDR_SOURCE_IFACE_H
 #define OSMOSDR_SOURCE_IFACE_H
 
+#include <osmosdr/device.h>
 #include <osmosdr/ranges.h>
+#include <osmosdr/stream_stats.h>
 #include <osmosdr/time_spec.h>
 #include <gnuradio/basic_block.h>
 
@@ -40,6 +42,14 @@ public:
    */
   virtual size_t get_num_channels( void ) = 0;
 
+  /*!
+   * Switch the block output to the given item type ("fc32", "sc16" or
+   * "sc8"). Called before the block gets connected.
+   * \return true if the backend delivers this type natively, otherwise
+   * it keeps producing gr_complex and the samples are converted for it
+   */
+  virtual bool set_output_type( const std::string &type ) { return "fc32" == type; }
+
   /*!
    * \brief seek file to \p seek_point relative to \p whence
    *
@@ -251,6 +261,15 @@ public:
    */
   virtual void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 ) { }
 
+  /*!
+   * Tell whether the device corrects the DC offset itself. The source
+   * corrects it in software for the ones that don't.
+   *
+   * \param chan the channel index 0 to N-1
+   * \return true when set_dc_offset_mode() and set_dc_offset() work
+   */
+  virtual bool has_dc_offset_correction( size_t chan = 0 ) { return false; }
+
   /*!
    * Set the RX frontend IQ balance mode.
    *
@@ -268,6 +287,15 @@ public:
    */
   virtual void set_iq_balance( const std::complex<double> &balance, size_t chan = 0 ) { }
 
+  /*!
+   * Tell whether the device corrects the IQ balance itself. The source
+   * corrects it in software for the ones that don't.
+   *
+   * \param chan the channel index 0 to N-1
+   * \return true when set_iq_balance_mode() and set_iq_balance() work
+   */
+  virtual bool has_iq_balance_correction( size_t chan = 0 ) { return false; }
+
   /*!
    * Set the bandpass filter on the radio frontend.
    * \param bandwidth the filter bandwidth in Hz, set to 0 for automatic selection
@@ -291,6 +319,76 @@ public:
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 )
     { return osmosdr::freq_range_t(); }
 
+  /*!
+   * Get the streaming statistics of a channel.
+   * \param chan the channel index 0 to N-1
+   * \return counters for delivered and dropped samples, over/underruns
+   * and the host ring fill level
+   */
+  virtual osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 )
+    { return osmosdr::stream_stats_t(); }
+
+  /*!
+   * Prepare a table of center frequencies for hop_center_freq().
+   * \param freqs the center frequencies in Hz
+   * \param chan the channel index 0 to N-1
+   * \return the number of entries prepared, 0 if not supported
+   */
+  virtual size_t set_hop_freqs( const std::vector<double> &freqs, size_t chan = 0 )
+    { return 0; }
+
+  /*!
+   * Hop to an entry of the table given to set_hop_freqs().
+   * \param index the entry of the table
+   * \param time when to retune in device time, 0 for now
+   * \param chan the channel index 0 to N-1
+   * \return the center frequency hopped to in Hz
+   */
+  virtual double hop_center_freq( size_t index, const ::osmosdr::time_spec_t &time,
+                                  size_t chan = 0 )
+    { return get_center_freq( chan ); }
+
+  /*!
+   * Whether hop_center_freq() with a time is carried out by the device
+   * at that time, by the clock get_time_now() reads.
+   * \param chan the channel index 0 to N-1
+   * \return true if hops can be scheduled ahead
+   */
+  virtual bool has_timed_hops( size_t chan = 0 ) { return false; }
+
+  /*!
+   * Apply several settings of a channel at once.
+   * Applies them one by one through the setters, backends where every
+   * setting is a transaction of its own override this to coalesce them.
+   * \param config rate, freq, freq_corr, gain_mode, gain, if_gain, bb_gain,
+   * gain:<name>, antenna and bandwidth
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_config( const osmosdr::device_t &config, size_t chan = 0 )
+  {
+    if ( config.count("rate") )
+      set_sample_rate( config.cast< double >( "rate", 0 ) );
+    if ( config.count("freq_corr") )
+      set_freq_corr( config.cast< double >( "freq_corr", 0 ), chan );
+    if ( config.count("freq") )
+      set_center_freq( config.cast< double >( "freq", 0 ), chan );
+    if ( config.count("gain_mode") )
+      set_gain_mode( config.cast< bool >( "gain_mode", false ), chan );
+    if ( config.count("gain") )
+      set_gain( config.cast< double >( "gain", 0 ), chan );
+    if ( config.count("if_gain") )
+      set_if_gain( config.cast< double >( "if_gain", 0 ), chan );
+    if ( config.count("bb_gain") )
+      set_bb_gain( config.cast< double >( "bb_gain", 0 ), chan );
+    for (const auto &entry : config)
+      if ( 0 == entry.first.compare( 0, 5, "gain:" ) )
+        set_gain( config.cast< double >( entry.first, 0 ), entry.first.substr( 5 ), chan );
+    if ( config.count("antenna") )
+      set_antenna( config.at("antenna"), chan );
+    if ( config.count("bandwidth") )
+      set_bandwidth( config.cast< double >( "bandwidth", 0 ), chan );
+  }
+
   /*!
    * Set the time source for the device.
    * This sets the method of time synchronization,
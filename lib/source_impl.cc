@@ -27,77 +27,27 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <functional>
+#include <future>
+
 #include <gnuradio/io_signature.h>
 #include <gnuradio/blocks/null_source.h>
 #include <gnuradio/blocks/throttle.h>
 #include <gnuradio/constants.h>
 
-#ifdef ENABLE_FCD
-#include <fcd_source_c.h>
-#endif
-
-#ifdef ENABLE_FILE
-#include <file_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL
-#include <rtl_source_c.h>
-#endif
-
 #ifdef ENABLE_RTL_TCP
-#include <rtl_tcp_source_c.h>
-#endif
-
-#ifdef ENABLE_UHD
-#include <uhd_source_c.h>
-#endif
-
-#ifdef ENABLE_MIRI
-#include <miri_source_c.h>
-#endif
-
-#ifdef ENABLE_SDRPLAY
-#include <sdrplay_source_c.h>
-#endif
-
-#ifdef ENABLE_HACKRF
-#include <hackrf_source_c.h>
-#endif
-
-#ifdef ENABLE_BLADERF
-#include <bladerf_source_c.h>
-#endif
-
-#ifdef ENABLE_RFSPACE
-#include <rfspace_source_c.h>
-#endif
-
-#ifdef ENABLE_AIRSPY
-#include <airspy_source_c.h>
-#endif
-
-#ifdef ENABLE_AIRSPYHF
-#include <airspyhf_source_c.h>
-#endif
-
-#ifdef ENABLE_SOAPY
-#include <soapy_source_c.h>
-#endif
-
-#ifdef ENABLE_REDPITAYA
-#include <redpitaya_source_c.h>
-#endif
-
-#ifdef ENABLE_FREESRP
-#include <freesrp_source_c.h>
-#endif
-
-#ifdef ENABLE_XTRX
-#include <xtrx_source_c.h>
+#include <rtl_tcp_server_c.h>
 #endif
 
 #include "arg_helpers.h"
+#include "backend_registry.h"
+#include "command_handler.h"
+#include "device_cache.h"
+#include "device_sync.h"
+#include "fc32_convert.h"
 #include "source_impl.h"
+#include "stream_aligner.h"
 
 /*
  * Create a new instance of source_impl and return
@@ -115,152 +65,40 @@ osmosdr::source::make( const std::string &args )
 source_impl::source_impl( const std::string &args )
   : gr::hier_block2 ("source_impl",
         gr::io_signature::make(0, 0, 0),
-        args_to_io_signature(args)),
+        args_to_io_signature(args, item_type_to_size(args_to_item_type(args)), true)),
     _sample_rate(NAN)
 {
   size_t channel = 0;
   bool device_specified = false;
+  const std::string type = args_to_item_type(args);
 
   std::vector< std::string > arg_list = args_to_vector(args);
 
-  std::vector< std::string > dev_types;
-
-#ifdef ENABLE_FILE
-  dev_types.push_back("file");
-#endif
-#ifdef ENABLE_FCD
-  dev_types.push_back("fcd");
-#endif
-#ifdef ENABLE_RTL
-  dev_types.push_back("rtl");
-#endif
-#ifdef ENABLE_RTL_TCP
-  dev_types.push_back("rtl_tcp");
-#endif
-#ifdef ENABLE_UHD
-  dev_types.push_back("uhd");
-#endif
-#ifdef ENABLE_MIRI
-  dev_types.push_back("miri");
-#endif
-#ifdef ENABLE_SDRPLAY
-  dev_types.push_back("sdrplay");
-#endif
-#ifdef ENABLE_HACKRF
-  dev_types.push_back("hackrf");
-#endif
-#ifdef ENABLE_BLADERF
-  dev_types.push_back("bladerf");
-#endif
-#ifdef ENABLE_RFSPACE
-  dev_types.push_back("rfspace");
-#endif
-#ifdef ENABLE_AIRSPY
-  dev_types.push_back("airspy");
-#endif
-#ifdef ENABLE_AIRSPYHF
-  dev_types.push_back("airspyhf");
-#endif
-#ifdef ENABLE_SOAPY
-  dev_types.push_back("soapy");
-#endif
-#ifdef ENABLE_REDPITAYA
-  dev_types.push_back("redpitaya");
-#endif
-#ifdef ENABLE_FREESRP
-  dev_types.push_back("freesrp");
-#endif
-#ifdef ENABLE_XTRX
-  dev_types.push_back("xtrx");
-#endif
   std::cerr << "gr-osmosdr "
             << GR_OSMOSDR_VERSION << " (" << GR_OSMOSDR_LIBVER << ") "
             << "gnuradio " << gr::version() << std::endl;
-  std::cerr << "built-in source types: ";
-  for (std::string dev_type : dev_types)
-    std::cerr << dev_type << " ";
-  std::cerr << std::endl;
-
-#ifdef ENABLE_RFSPACE
-  dev_types.push_back("sdr-iq"); /* additional aliases for rfspace backend */
-  dev_types.push_back("sdr-ip");
-  dev_types.push_back("netsdr");
-  dev_types.push_back("cloudiq");
-  dev_types.push_back("cloudsdr");
-#endif
 
-  for (std::string arg : arg_list) {
-    dict_t dict = params_to_dict(arg);
-    for (std::string dev_type : dev_types) {
-      if ( dict.count( dev_type ) ) {
-        device_specified = true;
-        break;
-      }
-    }
-  }
+  /* only looks up the backends named, their modules get loaded for it */
+  backend_t backend;
+  for (std::string arg : arg_list)
+    if ( find_backend( params_to_dict( arg ), backend ) )
+      device_specified = true;
 
   if ( ! device_specified ) {
+    /* in the order of preference, the first backend listing a device
+     * wins and the ones after it aren't probed at all */
     std::vector< std::string > dev_list;
-#ifdef ENABLE_FCD
-    for (std::string dev : fcd_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_RTL
-    for (std::string dev : rtl_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_UHD
-    for (std::string dev : uhd_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_MIRI
-    for (std::string dev : miri_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_SDRPLAY
-    for (std::string dev : sdrplay_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_BLADERF
-    for (std::string dev : bladerf_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_RFSPACE
-    for (std::string dev : rfspace_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_HACKRF
-    for (std::string dev : hackrf_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_AIRSPY
-    for (std::string dev : airspy_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_AIRSPYHF
-    for (std::string dev : airspyhf_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_SOAPY
-    for (std::string dev : soapy_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_REDPITAYA
-    for (std::string dev : redpitaya_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_FREESRP
-    for (std::string dev : freesrp_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_XTRX
-    for (std::string dev : xtrx_source_c::get_devices())
-      dev_list.push_back( dev );
-#endif
 
-//    std::cerr << std::endl;
-//    for (std::string dev : dev_list)
-//      std::cerr << "'" << dev << "'" << std::endl;
+    for (const backend_t &candidate : get_backends()) {
+      if ( ! candidate.source_devices )
+        continue;
+
+      dev_list = cached_devices( candidate.name, [&candidate]() {
+          return candidate.source_devices( false );
+        } );
+      if ( dev_list.size() )
+        break;
+    }
 
     if ( dev_list.size() )
       arg_list.push_back( dev_list.front() );
@@ -268,153 +106,252 @@ source_impl::source_impl( const std::string &args )
       throw std::runtime_error("No supported devices found (check the connection and/or udev rules).");
   }
 
-  for (std::string arg : arg_list) {
+  /* channels=f1:bw1,f2:bw2 are extracted here, the backends never see them */
+  std::vector< std::vector< std::string > > channel_specs;
+  for (std::string &arg : arg_list) {
+    channel_specs.push_back( split_channels_arg( arg ) );
 
-    dict_t dict = params_to_dict(arg);
+    if ( channel_specs.back().size() && "fc32" != type )
+      throw std::runtime_error("Extracting channels with channels= requires type=fc32.");
+  }
 
-//    std::cerr << std::endl;
-//    for (dict_t::value_type &entry : dict)
-//      std::cerr << "'" << entry.first << "' = '" << entry.second << "'" << std::endl;
+  std::cerr << "built-in source types: ";
+  for (std::string dev_type : get_backend_names( false ))
+    std::cerr << dev_type << " ";
+  std::cerr << std::endl;
 
-    source_iface *iface = NULL;
-    gr::basic_block_sptr block;
+  std::vector< std::string > modules = get_unloaded_modules();
+  if ( modules.size() ) {
+    std::cerr << "loadable modules: ";
+    for (std::string module : modules)
+      std::cerr << module << " ";
+    std::cerr << std::endl;
+  }
 
-#ifdef ENABLE_FCD
-    if ( dict.count("fcd") ) {
-      fcd_source_c_sptr src = make_fcd_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  /* sync=pps|time|host gives all devices a common start */
+  std::string sync;
+  for (std::string arg : arg_list) {
+    dict_t dict = params_to_dict(arg);
+    if ( dict.count("sync") )
+      sync = dict["sync"];
+  }
 
-#ifdef ENABLE_FILE
-    if ( dict.count("file") ) {
-      file_source_c_sptr src = make_file_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  if ( sync.size() && "pps" != sync && "time" != sync && "host" != sync )
+    throw std::runtime_error("Unsupported sync mode " + sync + ", use pps, time or host.");
 
-#ifdef ENABLE_RTL
-    if ( dict.count("rtl") ) {
-      rtl_source_c_sptr src = make_rtl_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  /* the aligner needs the time of the first sample of every channel */
+  stream_aligner_sptr aligner;
+  if ( sync.size() ) {
+    for (std::string &arg : arg_list)
+      if ( ! params_to_dict( arg ).count("timekey") )
+        arg += ",timekey=1";
 
-#ifdef ENABLE_RTL_TCP
-    if ( dict.count("rtl_tcp") ) {
-      rtl_tcp_source_c_sptr src = make_rtl_tcp_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    aligner = make_stream_aligner( output_signature()->max_streams(),
+                                   item_type_to_size( type ) );
+  }
 
-#ifdef ENABLE_UHD
-    if ( dict.count("uhd") ) {
-      uhd_source_c_sptr src = make_uhd_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  /* gate= segments are timed from the device where it can */
+  for (std::string &arg : arg_list) {
+    const dict_t dict = params_to_dict( arg );
 
-#ifdef ENABLE_MIRI
-    if ( dict.count("miri") ) {
-      miri_source_c_sptr src = make_miri_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( dict.count("gate") && "fc32" != type )
+      throw std::runtime_error("The power gate (gate=) requires type=fc32.");
 
-#ifdef ENABLE_SDRPLAY
-    if ( dict.count("sdrplay") ) {
-      sdrplay_source_c_sptr src = make_sdrplay_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( dict.count("gate") && ! dict.count("timekey") )
+      arg += ",timekey=1";
+  }
 
-#ifdef ENABLE_HACKRF
-    if ( dict.count("hackrf") ) {
-      hackrf_source_c_sptr src = make_hackrf_source_c( arg );
-      block = src; iface = src.get();
+  /* connects the next channel of the block, through the aligner and the
+   * power gate if any */
+  auto connect_output = [&]( gr::basic_block_sptr src, int port, power_gate_sptr gate ) {
+    if ( aligner ) {
+      connect(src, port, aligner, channel);
+      src = aligner;
+      port = channel;
     }
-#endif
-
-#ifdef ENABLE_BLADERF
-    if ( dict.count("bladerf") ) {
-      bladerf_source_c_sptr src = make_bladerf_source_c( arg );
-      block = src; iface = src.get();
+    if ( gate ) {
+      connect(src, port, gate, 0);
+      src = gate;
+      port = 0;
     }
-#endif
+    connect(src, port, self(), channel);
+    channel++;
+  };
+
+  /* devices measuring level= publish it here */
+  message_port_register_hier_out( pmt::mp("level") );
+
+  /* rx_spread=1 hands out the cores of rx_cpu= in the order of the
+   * devices here, see thread_sched.h */
+  size_t spread = 0;
+  for (std::string &arg : arg_list) {
+    const dict_t dict = params_to_dict( arg );
+
+    if ( dict.count("rx_spread") && boost::lexical_cast< bool >( dict.at("rx_spread") ) &&
+         ! dict.count("rx_spread_index") )
+      arg += ",rx_spread_index=" + std::to_string( spread++ );
+  }
 
-#ifdef ENABLE_RFSPACE
-    if ( dict.count("rfspace") ||
-         dict.count("sdr-iq") ||
-         dict.count("sdr-ip") ||
-         dict.count("netsdr") ||
-         dict.count("cloudiq") ||
-         dict.count("cloudsdr") ) {
-      rfspace_source_c_sptr src = make_rfspace_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  /* some backends take seconds to open a device, open all of their
+   * devices at once */
+  std::vector< std::future< backend_t::source_t > > opening( arg_list.size() );
+  for (size_t i = 0; i < arg_list.size(); i++)
+    if ( find_backend( params_to_dict( arg_list[i] ), backend ) &&
+         backend.make_source && backend.slow_open )
+      opening[i] = std::async( std::launch::async, backend.make_source, arg_list[i] );
 
-#ifdef ENABLE_AIRSPY
-    if ( dict.count("airspy") ) {
-      airspy_source_c_sptr src = make_airspy_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  for (size_t arg_index = 0; arg_index < arg_list.size(); arg_index++) {
 
-#ifdef ENABLE_AIRSPYHF
-    if ( dict.count("airspyhf") ) {
-      airspyhf_source_c_sptr src = make_airspyhf_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    const std::string &arg = arg_list[ arg_index ];
+    dict_t dict = params_to_dict(arg);
 
-#ifdef ENABLE_SOAPY
-    if ( dict.count("soapy") ) {
-      soapy_source_c_sptr src = make_soapy_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+//    std::cerr << std::endl;
+//    for (dict_t::value_type &entry : dict)
+//      std::cerr << "'" << entry.first << "' = '" << entry.second << "'" << std::endl;
 
-#ifdef ENABLE_REDPITAYA
-    if ( dict.count("redpitaya") ) {
-      redpitaya_source_c_sptr src = make_redpitaya_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    source_iface *iface = NULL;
+    gr::basic_block_sptr block;
 
-#ifdef ENABLE_FREESRP
-    if ( dict.count("freesrp") ) {
-      freesrp_source_c_sptr src = make_freesrp_source_c( arg );
-      block = src; iface = src.get();
+    /* of the software dc offset and iq balance estimation, in seconds */
+    double corr_tau = 0.1;
+    if ( dict.count("corr_tau") )
+      corr_tau = boost::lexical_cast< double >( dict["corr_tau"] );
+
+    if ( opening[ arg_index ].valid() ) {
+      backend_t::source_t src = opening[ arg_index ].get();
+      block = src.block; iface = src.iface;
+    } else if ( find_backend( dict, backend ) && backend.make_source ) {
+      backend_t::source_t src = backend.make_source( arg );
+      block = src.block; iface = src.iface;
     }
-#endif
 
-#ifdef ENABLE_XTRX
-    if ( dict.count("xtrx") ) {
-      xtrx_source_c_sptr src = make_xtrx_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( block && block->has_msg_port( pmt::mp("level") ) )
+      msg_connect( block, pmt::mp("level"), self(), pmt::mp("level") );
 
     if ( iface != NULL && long(block.get()) != 0 ) {
+      /* route every channel to its device once, the setters and getters
+       * are called far too often to search the devices each time */
+      channel_t ch;
+      ch.dev = iface;
+      ch.chain = std::string::npos;
+      ch.chz_port = 0;
+
       _devs.push_back( iface );
+      _dev_blocks.push_back( block );
 
-      for (size_t i = 0; i < iface->get_num_channels(); i++) {
-#ifdef HAVE_IQBALANCE
-        gr::iqbalance::optimize_c::sptr iq_opt = gr::iqbalance::optimize_c::make( 0 );
-        gr::iqbalance::fix_cc::sptr     iq_fix = gr::iqbalance::fix_cc::make();
+      /* a device given its own rate keeps it, set_sample_rate() of the
+       * group leaves it alone */
+      double dev_rate = 0;
+      if ( dict.count("rate") )
+        dev_rate = boost::lexical_cast< double >( dict["rate"] );
+      if ( dev_rate > 0 )
+        iface->set_sample_rate( dev_rate );
+      _dev_rate.push_back( dev_rate );
+
+      /* let the backend produce the type or convert on its behalf,
+       * iq balance correction only works with gr_complex */
+      bool native = "fc32" != type && iface->set_output_type( type );
+
+#ifdef ENABLE_RTL_TCP
+      if ( dict.count("serve") ) {
+        /* serves the first channel of the device as it comes out of the
+         * backend, commands are applied through this very source */
+        rtl_tcp_server_c_sptr server = make_rtl_tcp_server_c( arg, this, channel,
+              native ? item_type_to_size( type ) : sizeof(gr_complex) );
+        connect(block, 0, server, 0);
+      }
+#endif
+
+      if ( "fc32" != type ) {
+        for (size_t i = 0; i < iface->get_num_channels(); i++) {
+          ch.dev_chan = i;
+          _chans.push_back( ch );
 
-        connect(block, i, iq_fix, 0);
-        connect(iq_fix, 0, self(), channel++);
+          if ( native ) {
+            connect_output(block, i, power_gate_sptr());
+          } else {
+            fc32_convert_sptr conv = make_fc32_convert( type );
 
-        connect(block, i, iq_opt, 0);
-        msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
+            connect(block, i, conv, 0);
+            connect_output(conv, 0, power_gate_sptr());
+          }
+        }
+
+        continue;
+      }
 
-        _iq_opt.push_back( iq_opt.get() );
-        _iq_fix.push_back( iq_fix.get() );
+      const std::vector< std::string > &specs = channel_specs[ arg_index ];
+
+      /* drops what is below the threshold before the flowgraph sees it */
+      power_gate_opts_t gate_opts;
+      const bool gated = power_gate_from_dict( dict, gate_opts );
+
+      for (size_t i = 0; i < iface->get_num_channels(); i++) {
+        /* the channels given with channels= take the place of the first
+         * channel of the device, as outputs of one channelizer */
+        fft_channelizer_sptr chz;
+        if ( 0 == i && specs.size() ) {
+          std::vector< channel_spec_t > chz_specs;
+          for (const std::string &spec : specs)
+            chz_specs.push_back( channel_spec_from_string( spec ) );
+
+          chz = make_fft_channelizer( chz_specs, iface->get_sample_rate(),
+                                      iface->get_center_freq( 0 ) );
+        }
+
+        /* wired straight until a mode or a correction is set */
+        chain_t c;
+        c.dev = iface;
+        c.src = std::dynamic_pointer_cast< gr::block >( block );
+        c.src_port = i;
+        c.dst = chz ? gr::basic_block_sptr( chz ) : aligner;
+        c.dst_port = chz ? 0 : channel;
+        c.sw_dc = ! iface->has_dc_offset_correction( i );
+#ifdef HAVE_IQBALANCE
+        c.sw_iq = false;    /* gr-iqbalance takes care of it */
+        c.fix = gr::iqbalance::fix_cc::make();
+        c.opt = gr::iqbalance::optimize_c::make( 0 );
 #else
-        connect(block, i, self(), channel++);
-#endif
+        c.sw_iq = ! iface->has_iq_balance_correction( i );
+#endif
+        /* also there for a frequency correction the device can't do */
+        c.corr = make_iq_correct( corr_tau );
+        c.corr->set_sample_rate( iface->get_sample_rate() );
+        c.sw_ppm = 0;
+        c.optimizing = false;
+        _chains.push_back( c );
+
+        ch.dev_chan = i;
+        ch.chain = _chains.size() - 1;
+        ch.channelizer = chz;
+
+        if ( ! chz ) {
+          if ( gated ) {
+            ch.gate = make_power_gate( gate_opts, iface->get_sample_rate() );
+
+            /* the corrections go before the gate */
+            if ( ! aligner ) {
+              _chains.back().dst = ch.gate;
+              _chains.back().dst_port = 0;
+            }
+          }
+          _chans.push_back( ch );
+          connect_output(block, i, ch.gate);
+          continue;
+        }
+
+        connect(block, i, chz, 0);
+        for (size_t k = 0; k < specs.size(); k++) {
+          std::cerr << "Channel " << channel << ": " << specs[k] << " at "
+                    << chz->get_sample_rate( k ) << " sps" << std::endl;
+
+          /* at the rate of the channel, the channelizer tags changes of it */
+          if ( gated )
+            ch.gate = make_power_gate( gate_opts, chz->get_sample_rate( k ) );
+          ch.chz_port = k;
+          _chans.push_back( ch );
+          connect_output(chz, k, ch.gate);
+        }
       }
     } else if ( (iface != NULL) || (long(block.get()) != 0) )
       throw std::runtime_error("Either iface or block are NULL.");
@@ -424,41 +361,65 @@ source_impl::source_impl( const std::string &args )
   if (!_devs.size())
     throw std::runtime_error("No devices specified via device arguments.");
 
+  /* the aligner then trims the channels to the latest first timestamp */
+  if ( sync.size() )
+    sync_device_time( _devs, sync );
+
+  _center_freq.resize( _chans.size(), 0 );
+  _freq_corr.resize( _chans.size(), 0 );
+  _gain_mode.resize( _chans.size(), false );
+  _gain.resize( _chans.size(), 0 );
+  _if_gain.resize( _chans.size(), 0 );
+  _bb_gain.resize( _chans.size(), 0 );
+  _antenna.resize( _chans.size() );
+  _bandwidth.resize( _chans.size(), 0 );
+  _caps.resize( _chans.size() );
+
   /* Populate the _gain and _gain_mode arrays with the hardware state */
-  for ( source_iface *dev : _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      _gain_mode[dev_chan] = dev->get_gain_mode(dev_chan);
-      _gain[dev_chan] = dev->get_gain(dev_chan);
-    }
+  for (size_t chan = 0; chan < _chans.size(); chan++) {
+    _gain_mode[chan] = _chans[chan].dev->get_gain_mode( _chans[chan].dev_chan );
+    _gain[chan] = _chans[chan].dev->get_gain( _chans[chan].dev_chan );
+  }
+
+  /* commands sent to the port are applied on a thread of their own */
+  _command = make_command_handler(
+      [this]( const pmt::pmt_t &cmd ) { apply_command( *this, cmd ); },
+      [this]() { return _devs[0]->get_time_now( 0 ); } );
+  message_port_register_hier_in( pmt::mp("command") );
+  msg_connect( self(), pmt::mp("command"), _command, pmt::mp("command") );
 }
 
 size_t source_impl::get_num_channels()
 {
-  size_t channels = 0;
-
-  for (source_iface *dev : _devs)
-    channels += dev->get_num_channels();
-
-  return channels;
+  return _chans.size();
 }
 
 bool source_impl::seek( long seek_point, int whence, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->seek( seek_point, whence, dev_chan );
+  if ( chan >= _chans.size() )
+    return false;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return false;
+  return ch.dev->seek( seek_point, whence, ch.dev_chan );
 }
 
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
 
+/* the device the group rate is taken from, the first one not pinned */
+source_iface *source_impl::group_device()
+{
+  for (size_t i = 0; i < _devs.size(); i++)
+    if ( _dev_rate[i] <= 0 )
+      return _devs[i];
+
+  return _devs[0];
+}
+
 osmosdr::meta_range_t source_impl::get_sample_rates()
 {
-  if ( ! _devs.empty() )
-    return _devs[0]->get_sample_rates(); // assume same devices used in the group
+  if ( ! _devs.empty() ) // the range of the group rate, pinned devices have their own
+    return _caps.sample_rates( [this]() { return group_device()->get_sample_rates(); } );
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -466,6 +427,17 @@ osmosdr::meta_range_t source_impl::get_sample_rates()
   return osmosdr::meta_range_t();;
 }
 
+osmosdr::meta_range_t source_impl::get_sample_rates( size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return osmosdr::meta_range_t();
+
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::sample_rates,
+                    [&ch]() { return ch.dev->get_sample_rates(); } );
+}
+
 double source_impl::set_sample_rate(double rate)
 {
   double sample_rate = 0;
@@ -475,39 +447,50 @@ double source_impl::set_sample_rate(double rate)
     if (_devs.empty())
       throw std::runtime_error(NO_DEVICES_MSG);
 #endif
-    for (source_iface *dev : _devs)
-      sample_rate = dev->set_sample_rate(rate);
+    for (size_t i = 0; i < _devs.size(); i++)
+      if ( _dev_rate[i] <= 0 )
+        sample_rate = _devs[i]->set_sample_rate(rate);
 
-#ifdef HAVE_IQBALANCE
-    size_t channel = 0;
-    for (source_iface *dev : _devs) {
-      for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-        if ( channel < _iq_opt.size() ) {
-          gr::iqbalance::optimize_c *opt = _iq_opt[channel];
-
-          if ( opt->period() > 0 ) { /* optimize is enabled */
-            opt->set_period( dev->get_sample_rate() / 5 );
-            opt->reset();
-          }
-        }
+    _caps.forget_all();
 
-        channel++;
-      }
-    }
-#endif
+    for (size_t i = 0; i < _devs.size(); i++)
+      if ( _dev_rate[i] <= 0 )
+        follow_rate( _devs[i] );
 
-    _sample_rate = sample_rate;
+    _sample_rate = sample_rate ? sample_rate : get_sample_rate();
   }
 
   return _sample_rate;
 }
 
+double source_impl::set_sample_rate( double rate, size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return 0;
+
+  source_iface *dev = _chans[ chan ].dev;
+
+  for (size_t i = 0; i < _devs.size(); i++)
+    if ( _devs[i] == dev && _devs.size() > 1 )
+      _dev_rate[i] = rate;    /* now apart from the group */
+
+  dev->set_sample_rate( rate );
+
+  _caps.forget_all();
+  follow_rate( dev );
+
+  if ( dev == group_device() )
+    _sample_rate = dev->get_sample_rate();
+
+  return get_sample_rate( chan );
+}
+
 double source_impl::get_sample_rate()
 {
   double sample_rate = 0;
 
   if (!_devs.empty())
-    sample_rate = _devs[0]->get_sample_rate(); // assume same devices used in the group
+    sample_rate = group_device()->get_sample_rate(); // pinned devices may run at another
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -515,367 +498,727 @@ double source_impl::get_sample_rate()
   return sample_rate;
 }
 
+/* the rate the channel comes out at, a channelizer output is slower */
+double source_impl::get_sample_rate( size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( ch.channelizer )
+    return ch.channelizer->get_sample_rate( ch.chz_port );
+
+  return ch.dev->get_sample_rate();
+}
+
+/* the corrections, the optimizers and the channelizers of a device
+ * after its rate changed */
+void source_impl::follow_rate( source_iface *dev )
+{
+  for (chain_t &c : _chains) {
+    if ( c.dev != dev )
+      continue;
+
+    c.corr->set_sample_rate( dev->get_sample_rate() );
+#ifdef HAVE_IQBALANCE
+    gr::iqbalance::optimize_c::sptr opt = c.opt;
+
+    if ( opt->period() > 0 ) { /* optimize is enabled */
+      opt->set_period( dev->get_sample_rate() / 5 );
+      opt->reset();
+    }
+#endif
+  }
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+    if ( _chans[ chan ].dev == dev )
+      follow_device( chan );
+}
+
 osmosdr::freq_range_t source_impl::get_freq_range( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_range( dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::freq_range_t();
+
+  const channel_t &ch = _chans[ chan ];
 
-  return osmosdr::freq_range_t();
+  return _caps.get( chan, &capability_cache::entry_t::freq_range,
+                    [&ch]() { return ch.dev->get_freq_range( ch.dev_chan ); } );
 }
 
 double source_impl::set_center_freq( double freq, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        } else { return _center_freq[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _center_freq[ chan ] != freq ) {
+    _center_freq[ chan ] = freq;
+    freq = ch.dev->set_center_freq( freq, ch.dev_chan );
+    follow_device( chan );
+    return freq;
+  }
+
+  return _center_freq[ chan ];
 }
 
 double source_impl::get_center_freq( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  return ch.dev->get_center_freq( ch.dev_chan );
 }
 
 double source_impl::set_freq_corr( double ppm, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        } else { return _freq_corr[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _freq_corr[ chan ] != ppm ) {
+    _freq_corr[ chan ] = ppm;
+    double corr = ch.dev->set_freq_corr( ppm, ch.dev_chan );
+    chain_t *c = chain_of( chan );
+
+    /* the backends without a correction return 0, the samples are then
+     * shifted by the offset of the tuner instead */
+    if ( c && ( c->sw_ppm != 0 || ( ppm != 0 && corr == 0 ) ) ) {
+      c->sw_ppm = ppm;
+      follow_device( chan );
+      update_chain( *c );
+      return ppm;
+    }
 
-  return 0;
+    return corr;
+  }
+
+  return _freq_corr[ chan ];
 }
 
 double source_impl::get_freq_corr( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+  chain_t *c = chain_of( chan );
+
+  if ( c && c->sw_ppm != 0 )
+    return c->sw_ppm;
+
+  return ch.dev->get_freq_corr( ch.dev_chan );
 }
 
 std::vector<std::string> source_impl::get_gain_names( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_names( dev_chan );
+  if ( chan >= _chans.size() )
+    return std::vector< std::string >();
 
-  return std::vector< std::string >();
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::gain_names,
+                    [&ch]() { return ch.dev->get_gain_names( ch.dev_chan ); } );
 }
 
 osmosdr::gain_range_t source_impl::get_gain_range( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::gain_range_t();
 
-  return osmosdr::gain_range_t();
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::gain_range,
+                    [&ch]() { return ch.dev->get_gain_range( ch.dev_chan ); } );
 }
 
 osmosdr::gain_range_t source_impl::get_gain_range( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( name, dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::gain_range_t();
 
-  return osmosdr::gain_range_t();
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.gain_range( chan, name,
+                          [&]() { return ch.dev->get_gain_range( name, ch.dev_chan ); } );
 }
 
 bool source_impl::set_gain_mode( bool automatic, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        } else { return _gain_mode[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return false;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _gain_mode[ chan ] != automatic ) {
+    _gain_mode[ chan ] = automatic;
+    bool mode = ch.dev->set_gain_mode( automatic, ch.dev_chan );
+    if (!automatic) // reapply gain value when switched to manual mode
+      ch.dev->set_gain( _gain[ chan ], ch.dev_chan );
+    return mode;
+  }
 
-  return false;
+  return _gain_mode[ chan ];
 }
 
 bool source_impl::get_gain_mode( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+  if ( chan >= _chans.size() )
+    return false;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return false;
+  return ch.dev->get_gain_mode( ch.dev_chan );
 }
 
 double source_impl::set_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        } else { return _gain[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  if ( _gain[ chan ] != gain ) {
+    _gain[ chan ] = gain;
+    return ch.dev->set_gain( gain, ch.dev_chan );
+  }
+
+  return _gain[ chan ];
 }
 
 double source_impl::set_gain( double gain, const std::string & name, size_t chan)
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_gain( gain, name, dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
 
-  return 0;
+  return ch.dev->set_gain( gain, name, ch.dev_chan );
 }
 
 double source_impl::get_gain( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_gain( ch.dev_chan );
 }
 
 double source_impl::get_gain( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( name, dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_gain( name, ch.dev_chan );
 }
 
 double source_impl::set_if_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _if_gain[ chan ] != gain ) {
-          _if_gain[ chan ] = gain;
-          return dev->set_if_gain( gain, dev_chan );
-        } else { return _if_gain[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _if_gain[ chan ] != gain ) {
+    _if_gain[ chan ] = gain;
+    return ch.dev->set_if_gain( gain, ch.dev_chan );
+  }
 
-  return 0;
+  return _if_gain[ chan ];
 }
 
 double source_impl::set_bb_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bb_gain[ chan ] != gain ) {
-          _bb_gain[ chan ] = gain;
-          return dev->set_bb_gain( gain, dev_chan );
-        } else { return _bb_gain[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _bb_gain[ chan ] != gain ) {
+    _bb_gain[ chan ] = gain;
+    return ch.dev->set_bb_gain( gain, ch.dev_chan );
+  }
 
-  return 0;
+  return _bb_gain[ chan ];
 }
 
 std::vector< std::string > source_impl::get_antennas( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antennas( dev_chan );
+  if ( chan >= _chans.size() )
+    return std::vector< std::string >();
 
-  return std::vector< std::string >();
+  const channel_t &ch = _chans[ chan ];
+
+  return _caps.get( chan, &capability_cache::entry_t::antennas,
+                    [&ch]() { return ch.dev->get_antennas( ch.dev_chan ); } );
 }
 
 std::string source_impl::set_antenna( const std::string & antenna, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _antenna[ chan ] != antenna ) {
-          _antenna[ chan ] = antenna;
-          return dev->set_antenna( antenna, dev_chan );
-        } else { return _antenna[ chan ]; }
-      }
+  if ( chan >= _chans.size() )
+    return "";
+
+  const channel_t &ch = _chans[ chan ];
 
-  return "";
+  if ( _antenna[ chan ] != antenna ) {
+    _antenna[ chan ] = antenna;
+    forget_capabilities( chan );
+    return ch.dev->set_antenna( antenna, ch.dev_chan );
+  }
+
+  return _antenna[ chan ];
 }
 
 std::string source_impl::get_antenna( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antenna( dev_chan );
+  if ( chan >= _chans.size() )
+    return "";
 
-  return "";
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_antenna( ch.dev_chan );
 }
 
 void source_impl::set_dc_offset_mode( int mode, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset_mode( mode, dev_chan );
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+  chain_t *c = chain_of( chan );
+
+  if ( c && c->sw_dc ) {
+    c->corr->set_dc_offset_mode( mode );
+    update_chain( *c );
+    return;
+  }
+
+  ch.dev->set_dc_offset_mode( mode, ch.dev_chan );
 }
 
 void source_impl::set_dc_offset( const std::complex<double> &offset, size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset( offset, dev_chan );
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+  chain_t *c = chain_of( chan );
+
+  if ( c && c->sw_dc ) {
+    c->corr->set_dc_offset( offset );
+    update_chain( *c );
+    return;
+  }
+
+  ch.dev->set_dc_offset( offset, ch.dev_chan );
 }
 
 void source_impl::set_iq_balance_mode( int mode, size_t chan )
 {
-  size_t channel = 0;
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+  chain_t *c = chain_of( chan );
+
 #ifdef HAVE_IQBALANCE
-  for (source_iface *dev : _devs) {
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
-          gr::iqbalance::optimize_c *opt = _iq_opt[chan];
-          gr::iqbalance::fix_cc *fix = _iq_fix[chan];
-
-          if ( IQBalanceOff == mode  ) {
-            opt->set_period( 0 );
-            /* store current values in order to be able to restore them later */
-            _vals[ chan ] = std::pair< float, float >( fix->mag(), fix->phase() );
-            fix->set_mag( 0.0f );
-            fix->set_phase( 0.0f );
-          } else if ( IQBalanceManual == mode ) {
-            if ( opt->period() == 0 ) { /* transition from Off to Manual */
-              /* restore previous values */
-              std::pair< float, float > val = _vals[ chan ];
-              fix->set_mag( val.first );
-              fix->set_phase( val.second );
-            }
-            opt->set_period( 0 );
-          } else if ( IQBalanceAutomatic == mode ) {
-            opt->set_period( dev->get_sample_rate() / 5 );
-            opt->reset();
-          }
-        }
+  if ( c ) {
+    gr::iqbalance::optimize_c::sptr opt = c->opt;
+    gr::iqbalance::fix_cc::sptr fix = c->fix;
+
+    if ( IQBalanceOff == mode  ) {
+      opt->set_period( 0 );
+      /* store current values in order to be able to restore them later */
+      _vals[ chan ] = std::pair< float, float >( fix->mag(), fix->phase() );
+      fix->set_mag( 0.0f );
+      fix->set_phase( 0.0f );
+    } else if ( IQBalanceManual == mode ) {
+      if ( opt->period() == 0 ) { /* transition from Off to Manual */
+        /* restore previous values */
+        std::pair< float, float > val = _vals[ chan ];
+        fix->set_mag( val.first );
+        fix->set_phase( val.second );
       }
+      opt->set_period( 0 );
+    } else if ( IQBalanceAutomatic == mode ) {
+      opt->set_period( ch.dev->get_sample_rate() / 5 );
+      opt->reset();
     }
+
+    update_chain( *c );
   }
 #else
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_iq_balance_mode( mode, dev_chan );
+  if ( c && c->sw_iq ) {
+    c->corr->set_iq_balance_mode( mode );
+    update_chain( *c );
+    return;
+  }
+
+  ch.dev->set_iq_balance_mode( mode, ch.dev_chan );
 #endif
 }
 
 void source_impl::set_iq_balance( const std::complex<double> &balance, size_t chan )
 {
-  size_t channel = 0;
+  if ( chan >= _chans.size() )
+    return;
+
+  chain_t *c = chain_of( chan );
+
 #ifdef HAVE_IQBALANCE
-  for (source_iface *dev : _devs) {
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
-          gr::iqbalance::optimize_c *opt = _iq_opt[chan];
-          gr::iqbalance::fix_cc *fix = _iq_fix[chan];
-
-          if ( opt->period() == 0 ) { /* automatic optimization desabled */
-            fix->set_mag( balance.real() );
-            fix->set_phase( balance.imag() );
-          }
-        }
-      }
+  if ( c ) {
+    gr::iqbalance::optimize_c::sptr opt = c->opt;
+    gr::iqbalance::fix_cc::sptr fix = c->fix;
+
+    if ( opt->period() == 0 ) { /* automatic optimization desabled */
+      fix->set_mag( balance.real() );
+      fix->set_phase( balance.imag() );
+      update_chain( *c );
     }
   }
 #else
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_iq_balance( balance, dev_chan );
+  const channel_t &ch = _chans[ chan ];
+
+  if ( c && c->sw_iq ) {
+    c->corr->set_iq_balance( balance );
+    update_chain( *c );
+    return;
+  }
+
+  ch.dev->set_iq_balance( balance, ch.dev_chan );
 #endif
 }
 
-double source_impl::set_bandwidth( double bandwidth, size_t chan )
+source_impl::chain_t *source_impl::chain_of( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
-          _bandwidth[ chan ] = bandwidth;
-          return dev->set_bandwidth( bandwidth, dev_chan );
-        } else { return _bandwidth[ chan ]; }
+  const size_t chain = _chans[ chan ].chain;
+
+  return chain < _chains.size() ? &_chains[ chain ] : NULL;
+}
+
+/* the channels extracted from the same device channel share what it can do */
+void source_impl::forget_capabilities( size_t chan )
+{
+  for (size_t i = 0; i < _chans.size(); i++)
+    if ( _chans[i].dev == _chans[ chan ].dev && _chans[i].dev_chan == _chans[ chan ].dev_chan )
+      _caps.forget( i );
+}
+
+/* the channelizer works out the channels from the rate and the center
+ * frequency of the device, which a setter just may have changed */
+void source_impl::follow_device( size_t chan )
+{
+  const channel_t &ch = _chans[ chan ];
+  chain_t *c = chain_of( chan );
+
+  /* a tuner off by ppm puts the signal ppm of the frequency too low */
+  if ( c )
+    c->corr->set_freq_shift( c->sw_ppm * 1e-6 * ch.dev->get_center_freq( ch.dev_chan ) );
+
+  if ( ch.gate && ! ch.channelizer )
+    ch.gate->set_sample_rate( ch.dev->get_sample_rate() );
+
+  if ( ! ch.channelizer )
+    return;
+
+  ch.channelizer->set_sample_rate( ch.dev->get_sample_rate() );
+  ch.channelizer->set_center_freq( ch.dev->get_center_freq( ch.dev_chan ) );
+}
+
+/* Puts the corrections of a channel in its path only while they do
+ * something, each one otherwise costs a copy of every sample, and
+ * optimize_c a fanout on top. Once the block is in a flowgraph the
+ * rewiring happens under lock(), before that the connections are simply
+ * changed. */
+void source_impl::update_chain( chain_t &c )
+{
+  std::vector< gr::basic_block_sptr > path;
+  bool optimizing = false;
+
+  if ( c.corr && c.corr->enabled() )
+    path.push_back( c.corr );
+#ifdef HAVE_IQBALANCE
+  optimizing = c.opt->period() > 0;
+  if ( optimizing || c.fix->mag() != 0.0f || c.fix->phase() != 0.0f )
+    path.push_back( c.fix );
+#endif
+
+  if ( path == c.path && optimizing == c.optimizing )
+    return;
+
+  gr::basic_block_sptr dst = c.dst ? c.dst : gr::basic_block_sptr( self() );
+
+  /* connects or disconnects src -> path -> dst, the optimizer taps the
+   * input of fix_cc */
+  auto wire = [&]( const std::vector< gr::basic_block_sptr > &blocks,
+                   bool optimize, bool on ) {
+    gr::basic_block_sptr prev = c.src;
+    int port = c.src_port;
+
+    for (const gr::basic_block_sptr &next : blocks) {
+#ifdef HAVE_IQBALANCE
+      if ( optimize && next == c.fix ) {
+        if ( on ) {
+          connect(prev, port, c.opt, 0);
+          msg_connect(c.opt, "iqbal_corr", c.fix, "iqbal_corr");
+        } else {
+          disconnect(prev, port, c.opt, 0);
+          msg_disconnect(c.opt, "iqbal_corr", c.fix, "iqbal_corr");
+        }
       }
+#endif
+      if ( on )
+        connect(prev, port, next, 0);
+      else
+        disconnect(prev, port, next, 0);
+
+      prev = next;
+      port = 0;
+    }
+
+    if ( on )
+      connect(prev, port, dst, c.dst_port);
+    else
+      disconnect(prev, port, dst, c.dst_port);
+  };
+
+  /* the backend only gets a detail when a flowgraph sets it up */
+  bool live = c.src && c.src->detail();
+  if ( live )
+    lock();
+
+  wire( c.path, c.optimizing, false );
+  wire( path, optimizing, true );
+
+  c.path = path;
+  c.optimizing = optimizing;
+
+  if ( live )
+    unlock();
+}
+
+double source_impl::set_bandwidth( double bandwidth, size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
+    _bandwidth[ chan ] = bandwidth;
+    return ch.dev->set_bandwidth( bandwidth, ch.dev_chan );
+  }
+
+  return _bandwidth[ chan ];
 }
 
 double source_impl::get_bandwidth( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth( dev_chan );
+  if ( chan >= _chans.size() )
+    return 0;
 
-  return 0;
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_bandwidth( ch.dev_chan );
 }
 
 osmosdr::freq_range_t source_impl::get_bandwidth_range( size_t chan )
 {
-  size_t channel = 0;
-  for (source_iface *dev : _devs)
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth_range( dev_chan );
+  if ( chan >= _chans.size() )
+    return osmosdr::freq_range_t();
+
+  const channel_t &ch = _chans[ chan ];
 
-  return osmosdr::freq_range_t();
+  return _caps.get( chan, &capability_cache::entry_t::bandwidth_range,
+                    [&ch]() { return ch.dev->get_bandwidth_range( ch.dev_chan ); } );
+}
+
+osmosdr::stream_stats_t source_impl::get_stream_stats( size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return osmosdr::stream_stats_t();
+
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->get_stream_stats( ch.dev_chan );
+}
+
+size_t source_impl::set_hop_freqs( const std::vector<double> &freqs, size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  return ch.dev->set_hop_freqs( freqs, ch.dev_chan );
+}
+
+double source_impl::hop_center_freq( size_t index, const ::osmosdr::time_spec_t &time,
+                                     size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return 0;
+
+  const channel_t &ch = _chans[ chan ];
+
+  _center_freq[ chan ] = ch.dev->hop_center_freq( index, time, ch.dev_chan );
+  follow_device( chan );
+
+  return _center_freq[ chan ];
+}
+
+/* hops through the quick tune table when the device takes the whole list,
+ * they are only timed by the device when it does */
+bool source_impl::set_hop_schedule( const std::vector<double> &freqs,
+                                    const std::vector<double> &dwell,
+                                    const ::osmosdr::time_spec_t &start_time,
+                                    size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return false;
+
+  const channel_t &ch = _chans[ chan ];
+
+  _hoppers.resize( _chans.size() );
+  _hoppers[ chan ].reset();
+
+  if ( freqs.empty() )
+    return false;
+
+  const bool table = ch.dev->set_hop_freqs( freqs, ch.dev_chan ) == freqs.size();
+  const bool timed = table && ch.dev->has_timed_hops( ch.dev_chan );
+  source_iface *dev = ch.dev;
+
+  _hoppers[ chan ].reset( new hop_scheduler(
+    [this, freqs, table, chan]( size_t index, const ::osmosdr::time_spec_t &time ) {
+      if ( table )
+        hop_center_freq( index, time, chan );
+      else
+        set_center_freq( freqs[ index ], chan );
+    },
+    [dev]() { return dev->get_time_now(); },
+    freqs.size(), dwell, start_time, timed ) );
+
+  return timed;
+}
+
+void source_impl::set_config( const osmosdr::device_t &config, size_t chan )
+{
+  if ( chan >= _chans.size() )
+    return;
+
+  const channel_t &ch = _chans[ chan ];
+
+  /* the device only gets what the caches don't hold already */
+  osmosdr::device_t changed = config;
+
+  /* the rate goes to every device of the group that isn't pinned */
+  bool forward_rate = ( 1 == _devs.size() );
+#ifdef HAVE_IQBALANCE
+  forward_rate = false;    /* the optimizers follow the rate in set_sample_rate() */
+#endif
+
+  /* unless the device of the channel runs at a rate of its own */
+  bool pinned = false;
+  for (size_t i = 0; i < _devs.size(); i++)
+    if ( _devs[i] == ch.dev && _dev_rate[i] > 0 )
+      pinned = true;
+
+  if ( changed.count("rate") && pinned ) {
+    set_sample_rate( changed.cast< double >( "rate", 0 ), chan );
+    changed.erase("rate");
+  } else if ( changed.count("rate") && ! forward_rate ) {
+    set_sample_rate( changed.cast< double >( "rate", 0 ) );
+    changed.erase("rate");
+  }
+  filter_cached( changed, "rate", _sample_rate );
+
+  filter_cached( changed, "freq", _center_freq[ chan ] );
+  filter_cached( changed, "freq_corr", _freq_corr[ chan ] );
+  filter_cached( changed, "gain", _gain[ chan ] );
+  filter_cached( changed, "if_gain", _if_gain[ chan ] );
+  filter_cached( changed, "bb_gain", _bb_gain[ chan ] );
+  filter_cached( changed, "antenna", _antenna[ chan ] );
+
+  if ( changed.count("gain_mode") ) {
+    bool automatic = changed.cast< bool >( "gain_mode", false );
+
+    if ( automatic == _gain_mode[ chan ] ) {
+      changed.erase("gain_mode");
+    } else {
+      _gain_mode[ chan ] = automatic;
+      if ( ! automatic && ! changed.count("gain") ) // reapply gain value when switched to manual mode
+        changed["gain"] = boost::lexical_cast< std::string >( _gain[ chan ] );
+    }
+  }
+
+  /* 0 selects the automatic filter, which may depend on the rate */
+  if ( changed.count("bandwidth") ) {
+    double bandwidth = changed.cast< double >( "bandwidth", 0 );
+
+    if ( bandwidth != 0 && bandwidth == _bandwidth[ chan ] )
+      changed.erase("bandwidth");
+    else
+      _bandwidth[ chan ] = bandwidth;
+  }
+
+  if ( changed.count("rate") )
+    _caps.forget_all();
+  else if ( changed.count("antenna") )
+    forget_capabilities( chan );
+
+  if ( ! changed.empty() )
+    ch.dev->set_config( changed, ch.dev_chan );
+
+  if ( changed.count("rate") )
+    _sample_rate = ch.dev->get_sample_rate();
+
+  if ( changed.count("rate") || changed.count("freq") )
+    follow_device( chan );
+}
+
+source_impl::~source_impl()
+{
+  _hoppers.clear();
+  stop_read();
+}
+
+size_t source_impl::read( gr_complex *samples, size_t nitems, size_t chan )
+{
+  if ( _chains.empty() )
+    throw std::runtime_error( "Reading without a flowgraph requires type=fc32." );
+
+  const channel_t &ch = _chans.at( chan );
+  if ( ch.channelizer )
+    throw std::runtime_error( "Channels extracted with channels= can't be read without a flowgraph." );
+
+  const size_t dev = std::find( _devs.begin(), _devs.end(), ch.dev ) - _devs.begin();
+
+  std::lock_guard<std::mutex> lock( _read_mutex );
+
+  _readers.resize( _devs.size() );
+  if ( ! _readers[dev] )
+    _readers[dev].reset( new pull_reader( _dev_blocks[dev], ch.dev->get_num_channels() ) );
+
+  return _readers[dev]->read( samples, nitems, ch.dev_chan );
+}
+
+void source_impl::stop_read()
+{
+  std::lock_guard<std::mutex> lock( _read_mutex );
+
+  for ( std::unique_ptr< pull_reader > &reader : _readers )
+    if ( reader )
+      reader->stop();
 }
 
 void source_impl::set_time_source(const std::string &source, const size_t mboard)
@@ -929,6 +1272,9 @@ double source_impl::get_clock_rate(size_t mboard)
 
 void source_impl::set_clock_rate(double rate, size_t mboard)
 {
+  /* the sample rates the device offers follow from the clock */
+  _caps.forget_all();
+
   if (mboard != osmosdr::ALL_MBOARDS){
       _devs.at(mboard)->set_clock_rate( rate );
       return;
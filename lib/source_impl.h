@@ -28,13 +28,23 @@
 #endif
 
 #include <source_iface.h>
+#include "capability_cache.h"
+#include "command_handler.h"
+#include "fft_channelizer.h"
+#include "hop_scheduler.h"
+#include "iq_correct.h"
+#include "power_gate.h"
+#include "pull_reader.h"
 
 #include <map>
+#include <memory>
+#include <mutex>
 
 class source_impl : public osmosdr::source
 {
 public:
   source_impl( const std::string & args );
+  ~source_impl();
 
   size_t get_num_channels( void );
 
@@ -43,6 +53,9 @@ public:
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
+  osmosdr::meta_range_t get_sample_rates( size_t chan );
+  double set_sample_rate( double rate, size_t chan );
+  double get_sample_rate( size_t chan );
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
@@ -77,6 +90,22 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  size_t set_hop_freqs( const std::vector<double> &freqs, size_t chan = 0 );
+  double hop_center_freq( size_t index,
+                          const ::osmosdr::time_spec_t &time = ::osmosdr::time_spec_t(),
+                          size_t chan = 0 );
+  bool set_hop_schedule( const std::vector<double> &freqs,
+                         const std::vector<double> &dwell,
+                         const ::osmosdr::time_spec_t &start_time = ::osmosdr::time_spec_t(),
+                         size_t chan = 0 );
+
+  void set_config( const osmosdr::device_t &config, size_t chan = 0 );
+
+  size_t read( gr_complex *samples, size_t nitems, size_t chan = 0 );
+  void stop_read();
+
   void set_time_source(const std::string &source, const size_t mboard = 0);
   std::string get_time_source(const size_t mboard);
   std::vector<std::string> get_time_sources(const size_t mboard);
@@ -92,23 +121,74 @@ public:
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
 private:
+  struct chain_t;
+
+  chain_t *chain_of( size_t chan );
+  void update_chain( chain_t &c );
+  void follow_device( size_t chan );
+  void follow_rate( source_iface *dev );
+  source_iface *group_device();
+  void forget_capabilities( size_t chan );
+
+  struct channel_t
+  {
+    source_iface *dev;
+    size_t dev_chan;
+    size_t chain;                       // in _chains, npos without one
+    fft_channelizer_sptr channelizer;   // when extracted with channels=
+    size_t chz_port;                    // the output of the channelizer
+    power_gate_sptr gate;               // with gate=
+  };
+
   std::vector< source_iface * > _devs;
+  std::vector< gr::basic_block_sptr > _dev_blocks;  // the backends, like _devs
+  std::vector< double > _dev_rate;      // given with rate=, 0 in the group rate, like _devs
+  std::vector< channel_t > _chans;      // indexed by the channel of the block
+  command_handler_sptr _command;
+
+  /* the corrections are only put in the path of a channel while they're used */
+  struct chain_t
+  {
+    source_iface *dev;
+    gr::block_sptr src;                 // the backend
+    int src_port;
+    gr::basic_block_sptr dst;           // the channelizer, the aligner, the gate, or the block when NULL
+    int dst_port;
+    iq_correct_sptr corr;               // for what the device can't correct
+    bool sw_dc;
+    bool sw_iq;
+    double sw_ppm;                      // frequency correction of a device without one
+#ifdef HAVE_IQBALANCE
+    gr::iqbalance::fix_cc::sptr fix;
+    gr::iqbalance::optimize_c::sptr opt;
+#endif
+    std::vector< gr::basic_block_sptr > path;   // connected in series
+    bool optimizing;                    // opt connected in parallel to fix
+  };
+  std::vector< chain_t > _chains;       // one per device channel, empty unless type=fc32
+
+  /* read() drives the backends itself, created as they are read from */
+  std::mutex _read_mutex;
+  std::vector< std::unique_ptr< pull_reader > > _readers;  // like _devs
+
+  std::vector< std::unique_ptr< hop_scheduler > > _hoppers;  // like _chans
 
   /* cache to prevent multiple device calls with the same value coming from grc */
   double _sample_rate;
-  std::map< size_t, double > _center_freq;
-  std::map< size_t, double > _freq_corr;
-  std::map< size_t, bool > _gain_mode;
-  std::map< size_t, double > _gain;
-  std::map< size_t, double > _if_gain;
-  std::map< size_t, double > _bb_gain;
-  std::map< size_t, std::string > _antenna;
+  std::vector< double > _center_freq;
+  std::vector< double > _freq_corr;
+  std::vector< bool > _gain_mode;
+  std::vector< double > _gain;
+  std::vector< double > _if_gain;
+  std::vector< double > _bb_gain;
+  std::vector< std::string > _antenna;
 #ifdef HAVE_IQBALANCE
-  std::vector< gr::iqbalance::fix_cc * > _iq_fix;
-  std::vector< gr::iqbalance::optimize_c * > _iq_opt;
   std::map< size_t, std::pair<float, float> > _vals;
 #endif
-  std::map< size_t, double > _bandwidth;
+  std::vector< double > _bandwidth;
+
+  /* ranges and lists, until the antenna or the rate changes */
+  capability_cache _caps;
 };
 
 #endif /* INCLUDED_OSMOSDR_SOURCE_IMPL_H */
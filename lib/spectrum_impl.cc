@@ -0,0 +1,189 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "spectrum_impl.h"
+#include "stream_tagger.h"
+
+osmosdr::spectrum::sptr
+osmosdr::spectrum::make( double sample_rate, size_t fft_size, double frame_rate,
+                         size_t average, double freq )
+{
+  return gnuradio::get_initial_sptr(
+        new spectrum_impl( sample_rate, fft_size, frame_rate, average, freq ) );
+}
+
+spectrum_impl::spectrum_impl( double sample_rate, size_t fft_size, double frame_rate,
+                              size_t average, double freq )
+  : gr::sync_block( "spectrum",
+        gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+        gr::io_signature::make( 0, 0, 0 ) ),
+    _fft_size(fft_size), _average(average),
+    _rate(sample_rate), _freq(freq), _frame_rate(frame_rate),
+    _spectrum(std::max< size_t >(fft_size, 2)), _buf(fft_size),
+    _fill(0), _interval(0), _pos(0), _published(false), _frames(0)
+{
+  if ( _fft_size < 2 )
+    throw std::runtime_error( "spectrum needs an FFT size of at least 2." );
+
+  if ( sample_rate <= 0 || frame_rate <= 0 )
+    throw std::runtime_error( "spectrum needs a positive sample and frame rate." );
+
+  _port = pmt::mp( "power" );
+  message_port_register_out( _port );
+
+  restart();
+}
+
+void spectrum_impl::set_sample_rate( double rate )
+{
+  if ( rate > 0 )
+    _rate = rate;
+}
+
+void spectrum_impl::set_center_freq( double freq )
+{
+  _freq = freq;
+}
+
+void spectrum_impl::set_frame_rate( double frame_rate )
+{
+  if ( frame_rate > 0 )
+    _frame_rate = frame_rate;
+}
+
+uint64_t spectrum_impl::get_frames()
+{
+  return _frames;
+}
+
+bool spectrum_impl::start()
+{
+  restart();
+
+  return true;
+}
+
+/* begin a new frame, picking up rate changes */
+void spectrum_impl::restart()
+{
+  const size_t collect = _fft_size * std::max< size_t >( _average, 1 );
+
+  _interval = std::max( collect, size_t( std::llround( _rate / _frame_rate ) ) );
+  _pos = 0;
+  _fill = 0;
+  _published = false;
+  _spectrum.reset();
+}
+
+void spectrum_impl::process( const gr_complex *in, size_t nitems )
+{
+  size_t done = 0;
+
+  while ( done < nitems ) {
+    const size_t left = nitems - done;
+    size_t n;
+
+    /* whole FFTs only, the tail of the frame is skipped */
+    if ( ! _published && _pos + _fft_size - _fill <= _interval ) {
+      n = std::min( left, _fft_size - _fill );
+      std::copy( in + done, in + done + n, &_buf[_fill] );
+      _fill += n;
+
+      if ( _fill == _fft_size ) {
+        _spectrum.add( &_buf[0] );
+        _fill = 0;
+
+        if ( _average && _spectrum.count() == _average )
+          publish();
+      }
+    } else {
+      n = std::min( left, _interval - _pos );
+    }
+
+    done += n;
+    _pos += n;
+
+    if ( _pos == _interval ) {
+      if ( ! _published && _spectrum.count() )
+        publish();
+
+      restart();
+    }
+  }
+}
+
+void spectrum_impl::publish()
+{
+  const std::vector< float > power = _spectrum.dbfs();
+
+  pmt::pmt_t meta = pmt::make_dict();
+  meta = pmt::dict_add( meta, pmt::mp( "freq" ), pmt::from_double( _freq ) );
+  meta = pmt::dict_add( meta, pmt::mp( "rate" ), pmt::from_double( _rate ) );
+  meta = pmt::dict_add( meta, pmt::mp( "frame" ), pmt::from_uint64( _frames ) );
+
+  message_port_pub( _port, pmt::cons( meta, pmt::init_f32vector( power.size(), power ) ) );
+
+  _published = true;
+  _frames++;
+}
+
+int spectrum_impl::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  const uint64_t offset = nitems_read( 0 );
+  std::vector< gr::tag_t > tags;
+  size_t done = 0;
+
+  get_tags_in_range( tags, 0, offset, offset + noutput_items );
+  std::sort( tags.begin(), tags.end(), gr::tag_t::offset_compare );
+
+  /* a retune or rate change starts a new frame at the tagged sample */
+  for (const gr::tag_t &tag : tags) {
+    const bool freq = pmt::eq( tag.key, stream_tagger::FREQ_KEY() );
+    const bool rate = pmt::eq( tag.key, stream_tagger::RATE_KEY() );
+
+    if ( ! ( freq || rate ) || ! pmt::is_real( tag.value ) )
+      continue;
+
+    const size_t pos = size_t( tag.offset - offset );
+
+    process( in + done, pos - done );
+    done = pos;
+
+    if ( freq )
+      _freq = pmt::to_double( tag.value );
+    else if ( pmt::to_double( tag.value ) > 0 )
+      _rate = pmt::to_double( tag.value );
+
+    restart();
+  }
+
+  process( in + done, noutput_items - done );
+
+  return noutput_items;
+}
@@ -0,0 +1,70 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_SPECTRUM_IMPL_H
+#define INCLUDED_OSMOSDR_SPECTRUM_IMPL_H
+
+#include <atomic>
+#include <vector>
+
+#include <osmosdr/spectrum.h>
+
+#include "power_spectrum.h"
+
+class spectrum_impl : public osmosdr::spectrum
+{
+public:
+  spectrum_impl( double sample_rate, size_t fft_size, double frame_rate,
+                 size_t average, double freq );
+
+  void set_sample_rate( double rate );
+  void set_center_freq( double freq );
+  void set_frame_rate( double frame_rate );
+  uint64_t get_frames( void );
+
+  bool start();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  void restart();
+  void process( const gr_complex *in, size_t nitems );
+  void publish();
+
+  size_t _fft_size;
+  size_t _average;
+
+  std::atomic< double > _rate;
+  std::atomic< double > _freq;
+  std::atomic< double > _frame_rate;
+
+  power_spectrum _spectrum;
+  std::vector< gr_complex > _buf;
+  size_t _fill;                       // samples in _buf
+  size_t _interval;                   // samples per frame
+  size_t _pos;                        // samples of the current frame seen
+  bool _published;                    // the current frame went out
+
+  std::atomic< uint64_t > _frames;
+  pmt::pmt_t _port;
+};
+
+#endif // INCLUDED_OSMOSDR_SPECTRUM_IMPL_H
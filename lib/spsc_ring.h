@@ -0,0 +1,372 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_SPSC_RING_H
+#define OSMOSDR_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+
+#include "buffer_pool.h"
+
+#define SPSC_RING_CACHE_LINE 64
+
+/*!
+ * Lock-free single producer / single consumer ring of items.
+ *
+ * The producer (usually a libusb or reader thread) pushes whole transfers,
+ * the consumer (the block's work() function) pops as many items as it
+ * needs. Neither side takes a lock on the data path; the mutex is only
+ * touched by the producer when the consumer is blocked in wait() and the
+ * amount it asked for has become available.
+ *
+ * The read and write indices are free running counters, padded apart so
+ * the two threads don't keep stealing each others cache lines. Padding is
+ * used instead of alignas() since we still build as C++11 where over-aligned
+ * heap objects are not supported.
+ *
+ * The items live in a buffer from buffer_acquire(), so they must be
+ * trivially copyable. resize() keeps the buffer when the capacity stays
+ * the same, which makes restarting a stream free of allocations.
+ *
+ * resize(), set_buffer_opts() and reset() must only be called while no
+ * producer is running.
+ */
+template <typename T>
+class spsc_ring
+{
+public:
+  spsc_ring() :
+    _buf(NULL), _capacity(0),
+    _head(0), _tail_cache(0), _wanted(0),
+    _tail(0), _head_cache(0), _fill_max(0), _closed(false)
+  {
+  }
+
+  explicit spsc_ring( size_t capacity ) :
+    _buf(NULL), _capacity(0),
+    _head(0), _tail_cache(0), _wanted(0),
+    _tail(0), _head_cache(0), _fill_max(0), _closed(false)
+  {
+    resize( capacity );
+  }
+
+  ~spsc_ring()
+  {
+    buffer_release( _buf );
+  }
+
+  void resize( size_t capacity )
+  {
+    if ( capacity != _capacity )
+    {
+      buffer_release( _buf );
+      _buf = NULL;
+      _capacity = 0;
+
+      if ( capacity )
+        _buf = (T *)buffer_acquire( capacity * sizeof(T), _opts );
+      _capacity = capacity;
+    }
+
+    reset();
+  }
+
+  /* takes effect on the buffer allocated from now on */
+  void set_buffer_opts( const buffer_opts_t &opts )
+  {
+    if ( opts == _opts )
+      return;
+
+    _opts = opts;
+
+    size_t capacity = _capacity;
+    resize( 0 );
+    resize( capacity );
+  }
+
+  /* drop all items and re-open the ring after close() */
+  void reset()
+  {
+    _head.store( 0, std::memory_order_relaxed );
+    _tail.store( 0, std::memory_order_relaxed );
+    _head_cache = _tail_cache = 0;
+    _fill_max.store( 0, std::memory_order_relaxed );
+    _closed.store( false, std::memory_order_release );
+  }
+
+  size_t capacity() const { return _capacity; }
+
+  /* number of items ready to be read */
+  size_t size() const
+  {
+    return _tail.load( std::memory_order_acquire ) -
+           _head.load( std::memory_order_acquire );
+  }
+
+  /* highest number of readable items seen since the last reset() */
+  size_t fill_max() const
+  {
+    return _fill_max.load( std::memory_order_relaxed );
+  }
+
+  /* free running count of the items committed since the last reset() */
+  size_t write_count() const
+  {
+    return _tail.load( std::memory_order_acquire );
+  }
+
+  /* free running count of the items consumed since the last reset() */
+  size_t read_count() const
+  {
+    return _head.load( std::memory_order_acquire );
+  }
+
+  /* number of items that can be written without overrunning */
+  size_t space() const
+  {
+    return capacity() - size();
+  }
+
+  /*
+   * Producer side
+   */
+
+  /* contiguous region ready to be filled, commit() it afterwards */
+  T *write_ptr( size_t &count )
+  {
+    const size_t tail = _tail.load( std::memory_order_relaxed );
+    const size_t idx = tail % capacity();
+
+    _head_cache = _head.load( std::memory_order_acquire );
+
+    count = std::min( capacity() - (tail - _head_cache), capacity() - idx );
+
+    return &_buf[idx];
+  }
+
+  void commit( size_t count )
+  {
+    const size_t tail = _tail.load( std::memory_order_relaxed ) + count;
+
+    _tail.store( tail, std::memory_order_release );
+
+    /* pairs with the fence in prepare_wait() */
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    const size_t fill = tail - _head.load( std::memory_order_relaxed );
+    if ( fill > _fill_max.load( std::memory_order_relaxed ) )
+      _fill_max.store( fill, std::memory_order_relaxed );
+
+    size_t wanted = _wanted.load( std::memory_order_relaxed );
+    if ( wanted && fill >= wanted )
+    {
+      std::lock_guard<std::mutex> lock( _wait_mutex );
+      _wait_cond.notify_one();
+    }
+  }
+
+  /* copy up to count items into the ring, returns the number written */
+  size_t push( const T *items, size_t count )
+  {
+    const size_t tail = _tail.load( std::memory_order_relaxed );
+
+    if ( capacity() - (tail - _head_cache) < count )
+      _head_cache = _head.load( std::memory_order_acquire );
+
+    count = std::min( count, capacity() - (tail - _head_cache) );
+    if ( !count )
+      return 0;
+
+    const size_t idx = tail % capacity();
+    const size_t first = std::min( count, capacity() - idx );
+
+    std::memcpy( (void *)&_buf[idx], items, first * sizeof(T) );
+    std::memcpy( (void *)&_buf[0], items + first, (count - first) * sizeof(T) );
+
+    commit( count );
+
+    return count;
+  }
+
+  /* wake up the consumer for good, until the next reset() */
+  void close()
+  {
+    _closed.store( true, std::memory_order_release );
+
+    std::lock_guard<std::mutex> lock( _wait_mutex );
+    _wait_cond.notify_all();
+  }
+
+  bool closed() const { return _closed.load( std::memory_order_acquire ); }
+
+  /*
+   * Consumer side
+   */
+
+  /* contiguous region of readable items, consume() them afterwards */
+  const T *read_ptr( size_t &count )
+  {
+    const size_t head = _head.load( std::memory_order_relaxed );
+    const size_t idx = head % capacity();
+
+    _tail_cache = _tail.load( std::memory_order_acquire );
+
+    count = std::min( _tail_cache - head, capacity() - idx );
+
+    return &_buf[idx];
+  }
+
+  void consume( size_t count )
+  {
+    _head.store( _head.load( std::memory_order_relaxed ) + count,
+                 std::memory_order_release );
+  }
+
+  /* copy up to count items out of the ring, returns the number read */
+  size_t pop( T *items, size_t count )
+  {
+    const size_t head = _head.load( std::memory_order_relaxed );
+
+    if ( _tail_cache - head < count )
+      _tail_cache = _tail.load( std::memory_order_acquire );
+
+    count = std::min( count, _tail_cache - head );
+    if ( !count )
+      return 0;
+
+    const size_t idx = head % capacity();
+    const size_t first = std::min( count, capacity() - idx );
+
+    std::memcpy( (void *)items, &_buf[idx], first * sizeof(T) );
+    std::memcpy( (void *)(items + first), &_buf[0], (count - first) * sizeof(T) );
+
+    consume( count );
+
+    return count;
+  }
+
+  /* drop everything that has been written so far, consumer side */
+  void clear()
+  {
+    _tail_cache = _tail.load( std::memory_order_acquire );
+    _head.store( _tail_cache, std::memory_order_release );
+  }
+
+  /*!
+   * Drop the items committed before the producer's write_count() was
+   * \p mark, returns the number of items dropped.
+   */
+  size_t discard( size_t mark )
+  {
+    const size_t head = _head.load( std::memory_order_relaxed );
+    const size_t count = mark - head;
+
+    /* nothing to do if we already read past the mark */
+    if ( count > capacity() )
+      return 0;
+
+    /* pop() must not see a cached tail behind the new head */
+    _tail_cache = _tail.load( std::memory_order_acquire );
+    _head.store( mark, std::memory_order_release );
+    return count;
+  }
+
+  /*!
+   * Block until at least count items are readable or the ring got closed.
+   * Returns true if the items are available.
+   */
+  bool wait( size_t count )
+  {
+    if ( size() >= count )
+      return true;
+
+    std::unique_lock<std::mutex> lock( _wait_mutex );
+
+    while ( !prepare_wait( count ) )
+      _wait_cond.wait( lock );
+
+    return finish_wait( count );
+  }
+
+  template <class Rep, class Period>
+  bool wait_for( size_t count, const std::chrono::duration<Rep, Period> &timeout )
+  {
+    if ( size() >= count )
+      return true;
+
+    std::unique_lock<std::mutex> lock( _wait_mutex );
+
+    const std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + timeout;
+
+    while ( !prepare_wait( count ) )
+      if ( _wait_cond.wait_until( lock, deadline ) == std::cv_status::timeout )
+        break;
+
+    return finish_wait( count );
+  }
+
+private:
+  /* announce the waiter, returns true if there is no need to sleep */
+  bool prepare_wait( size_t count )
+  {
+    _wanted.store( count, std::memory_order_relaxed );
+
+    /* either the producer sees _wanted, or we see its updated _tail */
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    return size() >= count || closed();
+  }
+
+  bool finish_wait( size_t count )
+  {
+    _wanted.store( 0, std::memory_order_relaxed );
+
+    return size() >= count;
+  }
+
+  T *_buf;
+  size_t _capacity;
+  buffer_opts_t _opts;
+
+  /* consumer owned */
+  std::atomic<size_t> _head;
+  size_t _tail_cache;
+  std::atomic<size_t> _wanted;
+  char _pad0[SPSC_RING_CACHE_LINE];
+
+  /* producer owned */
+  std::atomic<size_t> _tail;
+  size_t _head_cache;
+  std::atomic<size_t> _fill_max;
+  char _pad1[SPSC_RING_CACHE_LINE];
+
+  std::atomic<bool> _closed;
+  std::mutex _wait_mutex;
+  std::condition_variable _wait_cond;
+};
+
+#endif // OSMOSDR_SPSC_RING_H
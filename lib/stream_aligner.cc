@@ -0,0 +1,167 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <gnuradio/io_signature.h>
+
+#include "stream_aligner.h"
+#include "stream_tagger.h"
+
+stream_aligner_sptr make_stream_aligner (size_t nchan, size_t itemsize)
+{
+  return gnuradio::get_initial_sptr(new stream_aligner (nchan, itemsize));
+}
+
+stream_aligner::stream_aligner (size_t nchan, size_t itemsize)
+  : gr::block ("stream_aligner",
+        gr::io_signature::make(nchan, nchan, itemsize),
+        gr::io_signature::make(nchan, nchan, itemsize)),
+    _itemsize(itemsize),
+    _aligned(false),
+    _chans(nchan)
+{
+  /* the offsets change by what is dropped, general_work() moves them */
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+void stream_aligner::forecast( int noutput_items, gr_vector_int &ninput_items_required )
+{
+  for (size_t i = 0; i < ninput_items_required.size(); i++)
+    ninput_items_required[i] = noutput_items;
+}
+
+/* called with the first sample of every channel at hand */
+void stream_aligner::align()
+{
+  std::vector< gr::tag_t > tags;
+  bool timed = false;
+
+  for (size_t chan = 0; chan < _chans.size(); chan++) {
+    channel_t &ch = _chans[chan];
+
+    ch.timed = false;
+    ch.rate = 0;
+    ch.freq = pmt::PMT_NIL;
+    ch.skip = 0;
+    ch.dropped = 0;
+
+    get_tags_in_range( tags, chan, 0, 1 );
+
+    for (const gr::tag_t &tag : tags) {
+      if ( pmt::equal( tag.key, stream_tagger::TIME_KEY() ) ) {
+        ch.time = ::osmosdr::time_spec_t(
+                    time_t( pmt::to_uint64( pmt::tuple_ref( tag.value, 0 ) ) ),
+                    pmt::to_double( pmt::tuple_ref( tag.value, 1 ) ) );
+        ch.timed = true;
+      } else if ( pmt::equal( tag.key, stream_tagger::RATE_KEY() ) ) {
+        ch.rate = pmt::to_double( tag.value );
+      } else if ( pmt::equal( tag.key, stream_tagger::FREQ_KEY() ) ) {
+        ch.freq = tag.value;
+      }
+    }
+
+    if ( ch.timed && ch.rate <= 0 )
+      ch.timed = false;
+
+    if ( ! ch.timed ) {
+      std::cerr << "Channel " << chan << " has no timestamp and can't be aligned."
+                << std::endl;
+      continue;
+    }
+
+    if ( ! timed || _start < ch.time )
+      _start = ch.time;
+    timed = true;
+  }
+
+  for (channel_t &ch : _chans) {
+    if ( ! ch.timed )
+      continue;
+
+    ::osmosdr::time_spec_t late = _start;
+    late -= ch.time;
+
+    ch.skip = uint64_t( std::llround( late.get_real_secs() * ch.rate ) );
+  }
+
+  _aligned = true;
+}
+
+int stream_aligner::general_work( int noutput_items,
+                                  gr_vector_int &ninput_items,
+                                  gr_vector_const_void_star &input_items,
+                                  gr_vector_void_star &output_items )
+{
+  if ( ! _aligned )
+    align();
+
+  std::vector< gr::tag_t > tags;
+
+  for (size_t chan = 0; chan < _chans.size(); chan++) {
+    channel_t &ch = _chans[chan];
+    const uint64_t nread = nitems_read(chan);
+    const size_t navail = ninput_items[chan];
+
+    size_t drop = size_t( std::min< uint64_t >( ch.skip, navail ) );
+    size_t copy = std::min( navail - drop, size_t(noutput_items) );
+
+    ch.skip -= drop;
+    ch.dropped += drop;
+
+    if ( copy ) {
+      const uint64_t nwritten = nitems_written(chan);
+
+      /* the tags of the first sample were dropped along with it */
+      if ( ch.dropped && nwritten == 0 ) {
+        add_item_tag( chan, 0, stream_tagger::TIME_KEY(),
+                      pmt::make_tuple( pmt::from_uint64( _start.get_full_secs() ),
+                                       pmt::from_double( _start.get_frac_secs() ) ),
+                      alias_pmt() );
+        add_item_tag( chan, 0, stream_tagger::RATE_KEY(),
+                      pmt::from_double( ch.rate ), alias_pmt() );
+        if ( ! pmt::is_null( ch.freq ) )
+          add_item_tag( chan, 0, stream_tagger::FREQ_KEY(), ch.freq, alias_pmt() );
+      }
+
+      get_tags_in_range( tags, chan, nread + drop, nread + drop + copy );
+      for (gr::tag_t tag : tags) {
+        tag.offset -= ch.dropped;
+        add_item_tag( chan, tag );
+      }
+
+      memcpy( output_items[chan],
+              (const char *)input_items[chan] + drop * _itemsize,
+              copy * _itemsize );
+    }
+
+    consume( chan, drop + copy );
+    produce( chan, copy );
+  }
+
+  return WORK_CALLED_PRODUCE;
+}
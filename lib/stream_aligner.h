@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_STREAM_ALIGNER_H
+#define INCLUDED_STREAM_ALIGNER_H
+
+#include <vector>
+
+#include <gnuradio/block.h>
+
+#include "osmosdr/time_spec.h"
+
+class stream_aligner;
+
+typedef std::shared_ptr<stream_aligner> stream_aligner_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of stream_aligner.
+ * \param nchan the number of channels passed through
+ * \param itemsize the size of the items of every channel
+ */
+stream_aligner_sptr make_stream_aligner (size_t nchan, size_t itemsize);
+
+/*!
+ * \brief Trims the start of the channels of several devices, so their
+ * first samples are taken at the same time.
+ *
+ * The time and rate of the first sample of every channel come from the
+ * rx_time and rx_rate tags the backends put on it. All channels start at
+ * the latest of these times, the samples before it are dropped and the
+ * first one passed gets rx_time / rx_rate / rx_freq tags of its own.
+ * Channels without a timestamp on their first sample are passed as they
+ * are.
+ *
+ * The result is as exact as the timestamps: to the sample for devices
+ * sharing a clock and PPS, within the host scheduling jitter for the
+ * ones timestamped by the host.
+ */
+class stream_aligner : public gr::block
+{
+private:
+  friend stream_aligner_sptr make_stream_aligner (size_t nchan, size_t itemsize);
+
+  stream_aligner (size_t nchan, size_t itemsize);  	// private constructor
+
+public:
+  void forecast( int noutput_items, gr_vector_int &ninput_items_required );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  struct channel_t
+  {
+    bool timed;
+    ::osmosdr::time_spec_t time;  // of the first sample
+    double rate;
+    pmt::pmt_t freq;              // rx_freq of the first sample, if any
+    uint64_t skip;                // samples still to drop
+    uint64_t dropped;
+  };
+
+  void align();
+
+  size_t _itemsize;
+  bool _aligned;
+  ::osmosdr::time_spec_t _start;
+  std::vector< channel_t > _chans;
+};
+
+#endif /* INCLUDED_STREAM_ALIGNER_H */
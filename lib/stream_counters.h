@@ -0,0 +1,65 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_STREAM_COUNTERS_H
+#define OSMOSDR_STREAM_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <osmosdr/stream_stats.h>
+
+/*!
+ * The counters of stream_stats_t a backend keeps itself. The overruns are
+ * counted on the thread of the device library, the samples in work() and
+ * get_stats() copies them from whichever thread asks, so they are relaxed
+ * atomics like the ones of latency_stats.
+ */
+class stream_counters
+{
+public:
+  stream_counters() : _samples(0), _dropped(0), _overruns(0), _restarts(0) {}
+
+  void produced( uint64_t nsamples ) { _samples.fetch_add( nsamples, std::memory_order_relaxed ); }
+
+  /* nsamples lost because the ring was full */
+  void overrun( uint64_t nsamples )
+  {
+    _overruns.fetch_add( 1, std::memory_order_relaxed );
+    _dropped.fetch_add( nsamples, std::memory_order_relaxed );
+  }
+
+  void restarted() { _restarts.fetch_add( 1, std::memory_order_relaxed ); }
+
+  void get_stats( osmosdr::stream_stats_t &stats ) const
+  {
+    stats.samples = _samples.load( std::memory_order_relaxed );
+    stats.dropped = _dropped.load( std::memory_order_relaxed );
+    stats.overruns = _overruns.load( std::memory_order_relaxed );
+    stats.restarts = _restarts.load( std::memory_order_relaxed );
+  }
+
+private:
+  std::atomic<uint64_t> _samples;
+  std::atomic<uint64_t> _dropped;
+  std::atomic<uint64_t> _overruns;
+  std::atomic<uint64_t> _restarts;
+};
+
+#endif // OSMOSDR_STREAM_COUNTERS_H
@@ -0,0 +1,334 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_STREAM_TAGGER_H
+#define OSMOSDR_STREAM_TAGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <gnuradio/tags.h>
+#include <pmt/pmt.h>
+
+#include "tick_time.h"
+
+/*!
+ * Generates rx_time / rx_rate / rx_freq stream tags from the host clock
+ * for backends without hardware timestamps.
+ *
+ * The producer (libusb callback) reports every transfer it put into the
+ * ring, and every transfer it had to drop. The time of the first sample of
+ * the stream is taken from the steady clock when the first transfer
+ * arrives and mapped to UTC once, later timestamps are derived from the
+ * sample counter including the dropped samples, so they don't carry the
+ * USB scheduling jitter along.
+ *
+ * Tags are only generated at stream start, for the first transfer after an
+ * overrun and for the first transfer after a retune. The consumer (work())
+ * picks them up with get_tags() for the range of items it produced.
+ *
+ * With only freq tags enabled, just the retunes get an rx_freq tag. With
+ * rate tags, the rate changes announced with rerate() get an rx_rate tag.
+ */
+class stream_tagger
+{
+public:
+  stream_tagger() :
+    _enabled(false), _freq_tags(false), _rate_tags(false),
+    _rate(0), _freq(0), _pending(false), _restart(false), _retuned(false), _rerated(false),
+    _written(0), _dropped(0), _t0_pos(0), _queued(0), _consumed(0)
+  {
+    _id = pmt::string_to_symbol("osmosdr");
+  }
+
+  void enable( bool enabled ) { _enabled = enabled; }
+  void enable_freq_tags( bool enabled ) { _freq_tags = enabled; }
+  void enable_rate_tags( bool enabled ) { _rate_tags = enabled; }
+  bool enabled() const { return _enabled || _freq_tags || _rate_tags; }
+
+  void set_id( const pmt::pmt_t &id ) { _id = id; }
+
+  /* reset the counters, must be called before the producer gets started */
+  void start( double rate, double freq )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    _rate = rate;
+    _freq = freq;
+    _written = _dropped = _consumed = 0;
+    _events.clear();
+    _queued.store( 0, std::memory_order_relaxed );
+    _restart = true;
+    _retuned = false;
+    _rerated = false;
+    _pending.store( true, std::memory_order_release );
+  }
+
+  /* the sample clock changed, re-anchor at the next transfer */
+  void set_rate( double rate )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    _rate = rate;
+    _restart = true;
+    _pending.store( true, std::memory_order_release );
+  }
+
+  /* like set_rate(), for the producer once the old rate is flushed,
+   * the next transfer gets rx_rate with rate tags enabled */
+  void rerate( double rate )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    _rate = rate;
+    _restart = true;
+    _rerated = true;
+    _pending.store( true, std::memory_order_release );
+  }
+
+  void retune( double freq )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    _freq = freq;
+    _retuned = true;
+    _pending.store( true, std::memory_order_release );
+  }
+
+  /*
+   * Producer side
+   */
+
+  /* nsamples are about to be written to the ring, called before they
+   * are published so work() can't take them ahead of their event */
+  void transfer( size_t nsamples )
+  {
+    if ( enabled() && _pending.load( std::memory_order_acquire ) )
+      add_event( nsamples );
+
+    _written += nsamples;
+  }
+
+  /* nsamples had to be dropped */
+  void overrun( size_t nsamples )
+  {
+    _dropped += nsamples;
+
+    if ( _enabled )
+      _pending.store( true, std::memory_order_release );
+  }
+
+  /* nsamples were thrown away on purpose, keeps the timestamps right */
+  void skip( size_t nsamples )
+  {
+    _dropped += nsamples;
+  }
+
+  /*
+   * Consumer side
+   */
+
+  /* tags for the nitems produced starting at absolute offset, resp. nitems_written() */
+  void get_tags( uint64_t offset, size_t nitems, std::vector<gr::tag_t> &tags )
+  {
+    tags.clear();
+
+    if ( _queued.load( std::memory_order_acquire ) )
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+
+      while ( _events.size() && _events.front().pos < _consumed + nitems )
+      {
+        const event_t &ev = _events.front();
+        const uint64_t at = offset + (ev.pos > _consumed ? ev.pos - _consumed : 0);
+
+        if ( ev.timed )
+          tags.push_back( make_tag( at, TIME_KEY(), ev.time.to_rx_time() ) );
+        if ( ev.timed || ev.rated )
+          tags.push_back( make_tag( at, RATE_KEY(), pmt::from_double( ev.rate ) ) );
+        tags.push_back( make_tag( at, FREQ_KEY(), pmt::from_double( ev.freq ) ) );
+
+        _events.pop_front();
+        _queued.fetch_sub( 1, std::memory_order_relaxed );
+      }
+    }
+
+    _consumed += nitems;
+  }
+
+  /* nitems were taken out of the ring without being produced */
+  void discard( size_t nitems )
+  {
+    _consumed += nitems;
+
+    if ( _queued.load( std::memory_order_acquire ) )
+    {
+      std::lock_guard<std::mutex> lock( _mutex );
+
+      while ( _events.size() && _events.front().pos < _consumed )
+      {
+        _events.pop_front();
+        _queued.fetch_sub( 1, std::memory_order_relaxed );
+      }
+    }
+  }
+
+  static const pmt::pmt_t &TIME_KEY()
+  {
+    static const pmt::pmt_t key = pmt::string_to_symbol("rx_time");
+    return key;
+  }
+
+  static const pmt::pmt_t &RATE_KEY()
+  {
+    static const pmt::pmt_t key = pmt::string_to_symbol("rx_rate");
+    return key;
+  }
+
+  static const pmt::pmt_t &FREQ_KEY()
+  {
+    static const pmt::pmt_t key = pmt::string_to_symbol("rx_freq");
+    return key;
+  }
+
+private:
+  struct event_t
+  {
+    uint64_t pos;
+    bool timed;
+    bool rated;
+    tick_time_t time;
+    double rate;
+    double freq;
+  };
+
+  void add_event( size_t nsamples )
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    _pending.store( false, std::memory_order_relaxed );
+
+    const bool retuned = _retuned;
+    const bool rerated = _rerated;
+    _retuned = _rerated = false;
+
+    if ( _rate <= 0 || !(_enabled || (retuned && _freq_tags) || (rerated && _rate_tags)) )
+      return;
+
+    const uint64_t pos = _written + _dropped;
+
+    if ( _restart )
+    {
+      /* the transfer just completed, so its first sample is nsamples old */
+      const std::chrono::steady_clock::duration since =
+          std::chrono::steady_clock::now() - anchor().steady;
+
+      _t0 = tick_time_t::from_secs( anchor().secs,
+                                    anchor().frac + std::chrono::duration<double>( since ).count(),
+                                    _rate ) - nsamples;
+      _t0_pos = pos;
+      _restart = false;
+    }
+
+    /* counted in samples from there, so the timestamps don't drift */
+    event_t ev;
+    ev.pos = _written;
+    ev.timed = _enabled;
+    ev.rated = rerated;
+    ev.time = _t0 + int64_t( pos - _t0_pos );
+    ev.rate = _rate;
+    ev.freq = _freq;
+
+    _events.push_back( ev );
+    _queued.fetch_add( 1, std::memory_order_release );
+  }
+
+  gr::tag_t make_tag( uint64_t offset, const pmt::pmt_t &key, const pmt::pmt_t &value )
+  {
+    gr::tag_t tag;
+    tag.offset = offset;
+    tag.key = key;
+    tag.value = value;
+    tag.srcid = _id;
+    return tag;
+  }
+
+  struct anchor_t
+  {
+    std::chrono::steady_clock::time_point steady;
+    uint64_t secs;
+    double frac;
+  };
+
+  /* the UTC time at one point of the steady clock, taken once so the
+   * timestamps never step along with the host clock */
+  static const anchor_t &anchor()
+  {
+    static const anchor_t a = make_anchor();
+    return a;
+  }
+
+  static anchor_t make_anchor()
+  {
+    anchor_t a;
+    a.steady = std::chrono::steady_clock::now();
+
+    const std::chrono::system_clock::duration utc =
+        std::chrono::system_clock::now().time_since_epoch();
+    const std::chrono::seconds secs =
+        std::chrono::duration_cast<std::chrono::seconds>( utc );
+
+    a.secs = secs.count();
+    a.frac = std::chrono::duration<double>( utc - secs ).count();
+    return a;
+  }
+
+  bool _enabled;
+  bool _freq_tags;
+  bool _rate_tags;
+  pmt::pmt_t _id;
+
+  std::mutex _mutex;
+  double _rate;
+  double _freq;
+  std::atomic<bool> _pending;
+  bool _restart;
+  bool _retuned;
+  bool _rerated;
+
+  /* producer owned */
+  uint64_t _written;
+  uint64_t _dropped;
+  uint64_t _t0_pos;
+  tick_time_t _t0;                 // of the sample at _t0_pos
+
+  std::deque<event_t> _events;
+  std::atomic<size_t> _queued;
+
+  /* consumer owned */
+  uint64_t _consumed;
+};
+
+#endif // OSMOSDR_STREAM_TAGGER_H
@@ -0,0 +1,132 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+#include "stream_watchdog.h"
+
+#define BACKOFF_MIN 0.1   // s between failed restarts, doubled up to
+#define BACKOFF_MAX 2.0
+
+stream_watchdog::stream_watchdog() :
+  _timeout(0),
+  _stalls(true),
+  _fed(false),
+  _restarts(0),
+  _ended(false),
+  _stop(false)
+{
+}
+
+stream_watchdog::~stream_watchdog()
+{
+  stop();
+}
+
+double stream_watchdog::timeout_from_dict( const dict_t &dict )
+{
+  if ( ! dict.count( "watchdog" ) )
+    return 0;
+
+  return std::max( 0.0, boost::lexical_cast< double >( dict.at( "watchdog" ) ) / 1e3 );
+}
+
+void stream_watchdog::start( double timeout, const std::function< bool() > &restart,
+                             bool stalls )
+{
+  stop();
+
+  _timeout = timeout;
+  _stalls = stalls;
+  _restart = restart;
+
+  if ( ! enabled() )
+    return;
+
+  _fed = false;
+  _ended = false;
+  _stop = false;
+  _thread = std::thread( &stream_watchdog::run, this );
+}
+
+void stream_watchdog::stop()
+{
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _stop = true;
+  }
+  _cond.notify_all();
+
+  if ( _thread.joinable() )
+    _thread.join();
+}
+
+void stream_watchdog::ended()
+{
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _ended = true;
+  }
+  _cond.notify_all();
+}
+
+void stream_watchdog::run()
+{
+  std::unique_lock< std::mutex > lock( _mutex );
+  double backoff = BACKOFF_MIN;
+
+  while ( ! _stop )
+  {
+    _cond.wait_for( lock, std::chrono::duration< double >( _timeout ),
+                    [this]() { return _stop || _ended; } );
+    if ( _stop )
+      break;
+
+    const bool fed = _fed.exchange( false, std::memory_order_relaxed );
+    if ( ( fed || ! _stalls ) && ! _ended )
+      continue;
+
+    std::cerr << "Stream " << ( _ended ? "ended" : "stalled" )
+              << ", restarting it." << std::endl;
+
+    /* the restart stops the producer, which may call ended() */
+    lock.unlock();
+    const bool restarted = _restart();
+    lock.lock();
+
+    if ( restarted ) {
+      _ended = false;
+      _fed = false;
+      _restarts++;
+      backoff = BACKOFF_MIN;
+      continue;
+    }
+
+    /* try again, a device just unplugged may take a while to be back */
+    _ended = true;
+    _cond.wait_for( lock, std::chrono::duration< double >( backoff ),
+                    [this]() { return _stop; } );
+    backoff = std::min( backoff * 2, BACKOFF_MAX );
+  }
+}
@@ -0,0 +1,86 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_STREAM_WATCHDOG_H
+#define OSMOSDR_STREAM_WATCHDOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * Keeps the stream of a USB device going instead of letting the flowgraph
+ * end with it, enabled with watchdog=<ms>.
+ *
+ * The producer calls feed() for every transfer and ended() when the device
+ * library stopped streaming. When it ended, or nothing came for the given
+ * number of ms, the restart function is called from the watchdog thread.
+ * It gets retried 100 ms to 2 s apart for as long as it fails. The backend
+ * meanwhile keeps work() waiting rather than returning WORK_DONE, and tags
+ * the first sample after the gap with rx_time.
+ */
+class OSMOSDR_API stream_watchdog
+{
+public:
+  stream_watchdog();
+  ~stream_watchdog();
+
+  /*! the stall timeout from watchdog=<ms>, 0 when not given */
+  static double timeout_from_dict( const dict_t &dict );
+
+  /*!
+   * Watch from now on, a stream that never started counts as stalled.
+   * Without \p stalls only a stream that ended is restarted.
+   */
+  void start( double timeout, const std::function< bool() > &restart,
+              bool stalls = true );
+  void stop();
+
+  bool enabled() const { return _timeout > 0; }
+
+  void feed() { _fed.store( true, std::memory_order_relaxed ); }
+  void ended();
+
+  uint64_t restarts() const { return _restarts.load(); }
+
+private:
+  void run();
+
+  double _timeout;
+  bool _stalls;
+  std::function< bool() > _restart;
+
+  std::atomic< bool > _fed;
+  std::atomic< uint64_t > _restarts;
+
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  bool _ended;
+  bool _stop;
+  std::thread _thread;
+};
+
+#endif // OSMOSDR_STREAM_WATCHDOG_H
@@ -0,0 +1,237 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "sweeper_impl.h"
+#include "stream_tagger.h"
+
+#define TAG_TIMEOUT 1.0     // seconds of samples to wait for the rx_freq tag
+
+osmosdr::sweeper::sptr
+osmosdr::sweeper::make( osmosdr::source::sptr src, double start, double stop, double step,
+                        size_t fft_size, size_t dwell, size_t settle, size_t chan )
+{
+  return gnuradio::get_initial_sptr(
+        new sweeper_impl( src, start, stop, step, fft_size, dwell, settle, chan ) );
+}
+
+sweeper_impl::sweeper_impl( osmosdr::source::sptr src, double start, double stop,
+                            double step, size_t fft_size, size_t dwell, size_t settle,
+                            size_t chan )
+  : gr::sync_block( "sweeper",
+        gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+        gr::io_signature::make( 0, 0, 0 ) ),
+    _src(src), _chan(chan), _fft_size(fft_size), _dwell(std::max< size_t >(dwell, 1)),
+    _settle(settle),
+    _state(STATE_TUNE), _step_index(0), _freq(0), _tuned(false),
+    _skip_left(0), _wait_left(0), _warned(false),
+    _spectrum(std::max< size_t >(fft_size, 2)), _buf(fft_size), _fill(0), _sweeps(0)
+{
+  if ( ! _src )
+    throw std::runtime_error( "sweeper needs a source to tune." );
+
+  if ( _fft_size < 2 )
+    throw std::runtime_error( "sweeper needs an FFT size of at least 2." );
+
+  set_range( start, stop, step );
+  _sweep_start = _start;
+  _sweep_stop = _stop;
+  _sweep_step = _step;
+
+  _port = pmt::mp( "power" );
+  message_port_register_out( _port );
+}
+
+void sweeper_impl::set_range( double start, double stop, double step )
+{
+  if ( step <= 0 || stop < start )
+    throw std::runtime_error( "sweeper needs start <= stop and a positive step." );
+
+  std::lock_guard< std::mutex > lock( _range_mutex );
+
+  _start = start;
+  _stop = stop;
+  _step = step;
+}
+
+uint64_t sweeper_impl::get_sweeps()
+{
+  return _sweeps;
+}
+
+bool sweeper_impl::start()
+{
+  _state = STATE_TUNE;
+  _step_index = 0;
+  _tuned = false;
+
+  return true;
+}
+
+/* retune for the next step, through the fast path if the source has one */
+void sweeper_impl::tune()
+{
+  if ( 0 == _step_index ) {
+    std::lock_guard< std::mutex > lock( _range_mutex );
+
+    _sweep_start = _start;
+    _sweep_stop = _stop;
+    _sweep_step = _step;
+  }
+
+  const double freq = _sweep_start + _step_index * _sweep_step;
+
+  _fill = 0;
+  _spectrum.reset();
+
+  /* a single step stays where it is, the source wouldn't tag it again */
+  if ( _tuned && std::abs( freq - _src->get_center_freq( _chan ) ) < 1.0 ) {
+    _state = STATE_COLLECT;
+    return;
+  }
+
+  _freq = _src->set_center_freq( freq, _chan );
+  _tuned = true;
+
+  if ( _settle ) {
+    _skip_left = _settle;
+    _state = STATE_SKIP;
+  } else {
+    _wait_left = size_t( _src->get_sample_rate() * TAG_TIMEOUT );
+    _state = STATE_WAIT_TAG;
+  }
+}
+
+/* number of the nitems leading samples that were received before the retune */
+size_t sweeper_impl::wait_tag( size_t nitems )
+{
+  std::vector< gr::tag_t > tags;
+  const uint64_t offset = nitems_read( 0 );
+
+  get_tags_in_range( tags, 0, offset, offset + nitems, stream_tagger::FREQ_KEY() );
+
+  for (const gr::tag_t &tag : tags) {
+    if ( ! pmt::is_real( tag.value ) )
+      continue;
+
+    if ( std::abs( pmt::to_double( tag.value ) - _freq ) < 1.0 ) {
+      _state = STATE_COLLECT;
+      return size_t( tag.offset - offset );
+    }
+  }
+
+  if ( nitems < _wait_left ) {
+    _wait_left -= nitems;
+    return nitems;
+  }
+
+  if ( ! _warned ) {
+    std::cerr << "sweeper: no rx_freq tag after retuning, open the source "
+              << "with settle=<samples> or give the sweeper a settle time."
+              << std::endl;
+    _warned = true;
+  }
+
+  _state = STATE_COLLECT;
+  return nitems;
+}
+
+void sweeper_impl::collect( const gr_complex *in, size_t nitems )
+{
+  std::copy( in, in + nitems, &_buf[_fill] );
+  _fill += nitems;
+
+  if ( _fill < _fft_size )
+    return;
+
+  _spectrum.add( &_buf[0] );
+  _fill = 0;
+
+  if ( _spectrum.count() < _dwell )
+    return;
+
+  publish();
+
+  const double next = _sweep_start + (_step_index + 1) * _sweep_step;
+
+  if ( next > _sweep_stop + 1.0 ) {
+    _step_index = 0;
+    _sweeps++;
+  } else {
+    _step_index++;
+  }
+
+  _state = STATE_TUNE;
+}
+
+void sweeper_impl::publish()
+{
+  const std::vector< float > power = _spectrum.dbfs();
+
+  pmt::pmt_t meta = pmt::make_dict();
+  meta = pmt::dict_add( meta, pmt::mp( "freq" ), pmt::from_double( _freq ) );
+  meta = pmt::dict_add( meta, pmt::mp( "rate" ), pmt::from_double( _src->get_sample_rate() ) );
+  meta = pmt::dict_add( meta, pmt::mp( "step" ), pmt::from_uint64( _step_index ) );
+  meta = pmt::dict_add( meta, pmt::mp( "sweep" ), pmt::from_uint64( _sweeps ) );
+
+  message_port_pub( _port, pmt::cons( meta, pmt::init_f32vector( power.size(), power ) ) );
+}
+
+int sweeper_impl::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  size_t done = 0;
+
+  while ( done < size_t(noutput_items) ) {
+    const size_t left = noutput_items - done;
+    size_t n = 0;
+
+    switch ( _state ) {
+    case STATE_TUNE:
+      tune();
+      break;
+    case STATE_WAIT_TAG:
+      n = wait_tag( left );
+      break;
+    case STATE_SKIP:
+      n = std::min( left, _skip_left );
+      _skip_left -= n;
+      if ( ! _skip_left )
+        _state = STATE_COLLECT;
+      break;
+    case STATE_COLLECT:
+      n = std::min( left, _fft_size - _fill );
+      collect( in + done, n );
+      break;
+    }
+
+    done += n;
+  }
+
+  return noutput_items;
+}
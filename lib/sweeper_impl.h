@@ -0,0 +1,81 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_SWEEPER_IMPL_H
+#define INCLUDED_OSMOSDR_SWEEPER_IMPL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <osmosdr/sweeper.h>
+
+#include "power_spectrum.h"
+
+class sweeper_impl : public osmosdr::sweeper
+{
+public:
+  sweeper_impl( osmosdr::source::sptr src, double start, double stop, double step,
+                size_t fft_size, size_t dwell, size_t settle, size_t chan );
+
+  void set_range( double start, double stop, double step );
+  uint64_t get_sweeps( void );
+
+  bool start();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  enum state_t { STATE_TUNE, STATE_WAIT_TAG, STATE_SKIP, STATE_COLLECT };
+
+  void tune();
+  size_t wait_tag( size_t nitems );
+  void collect( const gr_complex *in, size_t nitems );
+  void publish();
+
+  osmosdr::source::sptr _src;
+  size_t _chan;
+  size_t _fft_size;
+  size_t _dwell;
+  size_t _settle;
+
+  std::mutex _range_mutex;
+  double _start, _stop, _step;        // as set, applied at the next sweep
+  double _sweep_start, _sweep_stop, _sweep_step;
+
+  state_t _state;
+  size_t _step_index;
+  double _freq;                       // tuned, as the source reported it
+  bool _tuned;
+  size_t _skip_left;
+  size_t _wait_left;                  // samples until giving up on the tag
+  bool _warned;
+
+  power_spectrum _spectrum;
+  std::vector< gr_complex > _buf;
+  size_t _fill;                       // samples in _buf
+
+  std::atomic< uint64_t > _sweeps;
+  pmt::pmt_t _port;
+};
+
+#endif // INCLUDED_OSMOSDR_SWEEPER_IMPL_H
@@ -0,0 +1,136 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <boost/algorithm/string.hpp>
+
+#include <gnuradio/thread/thread.h>
+
+#include "thread_sched.h"
+
+thread_sched_t thread_sched_from_dict( const dict_t &dict, const std::string &dir )
+{
+  thread_sched_t sched;
+
+  if ( dict.count( dir + "_cpu" ) )
+  {
+    std::vector< std::string > tokens;
+    boost::algorithm::split( tokens, dict.at( dir + "_cpu" ), boost::is_any_of(":") );
+
+    for (const std::string &token : tokens)
+    {
+      std::vector< std::string > range;
+      boost::algorithm::split( range, token, boost::is_any_of("-") );
+
+      int first = boost::lexical_cast< int >( range.front() );
+      int last = boost::lexical_cast< int >( range.back() );
+      if ( range.size() > 2 || first < 0 || last < first )
+        throw std::runtime_error( "Invalid core range '" + token + "' in " + dir + "_cpu." );
+
+      for (int cpu = first; cpu <= last; cpu++)
+        sched.cpus.push_back( cpu );
+    }
+  }
+
+  /* each device takes the next core of the list, so the threads of many
+   * devices spread over the cores instead of all of them sharing all */
+  if ( dict.count( dir + "_spread" ) && boost::lexical_cast< bool >( dict.at( dir + "_spread" ) ) &&
+       ! sched.cpus.empty() )
+  {
+    size_t index = 0;
+    if ( dict.count( dir + "_spread_index" ) )
+      index = boost::lexical_cast< size_t >( dict.at( dir + "_spread_index" ) );
+
+    int cpu = sched.cpus[ index % sched.cpus.size() ];
+    sched.cpus.assign( 1, cpu );
+  }
+
+  if ( dict.count( dir + "_prio" ) )
+    sched.prio = boost::lexical_cast< int >( dict.at( dir + "_prio" ) );
+
+  if ( dict.count( dir + "_policy" ) )
+  {
+    sched.policy = dict.at( dir + "_policy" );
+
+    if ( "fifo" != sched.policy && "rr" != sched.policy && "other" != sched.policy )
+      throw std::runtime_error( "Unknown " + dir + "_policy '" + sched.policy +
+                                "', use fifo, rr or other." );
+  }
+  else if ( sched.prio )
+  {
+    sched.policy = "fifo";
+  }
+
+  return sched;
+}
+
+static void warn_once( std::atomic< bool > &warned, const std::string &what )
+{
+  if ( ! warned.exchange( true ) )
+    std::cerr << what << std::endl;
+}
+
+void thread_sched_apply( const thread_sched_t &sched )
+{
+  static std::atomic< bool > warned_prio( false );
+
+  if ( ! sched.cpus.empty() )
+    gr::thread::thread_bind_to_processor( sched.cpus );
+
+  if ( sched.policy.empty() )
+    return;
+
+#ifdef _WIN32
+  warn_once( warned_prio, "Thread scheduling policies are not supported on Windows." );
+#else
+  int policy = SCHED_OTHER;
+  if ( "fifo" == sched.policy )
+    policy = SCHED_FIFO;
+  else if ( "rr" == sched.policy )
+    policy = SCHED_RR;
+
+  struct sched_param param;
+  memset( &param, 0, sizeof(param) );
+
+  if ( SCHED_OTHER != policy )
+    param.sched_priority = std::max( sched_get_priority_min( policy ),
+                                     std::min( sched_get_priority_max( policy ), sched.prio ) );
+
+  int ret = pthread_setschedparam( pthread_self(), policy, &param );
+  if ( ret )
+    warn_once( warned_prio, "Could not set the " + sched.policy + " scheduling policy "
+               "of the streaming thread: " + strerror( ret ) +
+               " (check RLIMIT_RTPRIO, ulimit -r)." );
+#endif
+}
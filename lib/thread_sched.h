@@ -0,0 +1,95 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_THREAD_SCHED_H
+#define OSMOSDR_THREAD_SCHED_H
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * Where and how the streaming threads of a device are run, taken from
+ * the <dir>_cpu=, <dir>_prio= and <dir>_policy= device arguments, with
+ * dir being rx or tx.
+ *
+ * _cpu= is a list of cores separated by ':', with ranges like 2-3. With
+ * _spread=1 each device gets one core of the list: the source or sink
+ * numbers its devices given _spread=1 as <dir>_spread_index=, and the
+ * n-th of them takes the n-th core, starting over at the end of the list.
+ * _policy= is fifo (the default when a priority is given), rr or other.
+ *
+ * Applied by the airspy, airspyhf, freesrp, hackrf, miri, redpitaya,
+ * rfspace, rtl, rtl_tcp, sdrplay, sim, uhd (native=1) and vita49 sources,
+ * and the hackrf, redpitaya and sim sinks.
+ */
+struct thread_sched_t
+{
+  thread_sched_t() : prio(0) {}
+
+  std::vector< int > cpus;      // cores to run on, empty for any
+  int prio;                     // realtime priority, 0 to leave it
+  std::string policy;           // empty to leave it
+
+  bool empty() const { return cpus.empty() && 0 == prio && policy.empty(); }
+};
+
+OSMOSDR_API thread_sched_t thread_sched_from_dict( const dict_t &dict,
+                                                   const std::string &dir = "rx" );
+
+/*!
+ * Pin and prioritize the calling thread. Failures (usually missing
+ * permissions for realtime priorities) are reported once.
+ */
+OSMOSDR_API void thread_sched_apply( const thread_sched_t &sched );
+
+/*!
+ * For the threads of the device libraries, which we only get to see in
+ * their callbacks: apply() applies the settings once to every thread it
+ * is called from.
+ */
+class thread_sched_once
+{
+public:
+  thread_sched_once() {}
+  explicit thread_sched_once( const thread_sched_t &sched ) : _sched( sched ) {}
+
+  /* call while no callback is running, makes the next callback apply it */
+  void reset() { _thread = std::thread::id(); }
+
+  void apply()
+  {
+    if ( _sched.empty() || std::this_thread::get_id() == _thread )
+      return;
+
+    _thread = std::this_thread::get_id();
+    thread_sched_apply( _sched );
+  }
+
+private:
+  thread_sched_t _sched;
+  std::thread::id _thread;
+};
+
+#endif // OSMOSDR_THREAD_SCHED_H
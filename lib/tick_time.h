@@ -0,0 +1,117 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TICK_TIME_H
+#define OSMOSDR_TICK_TIME_H
+
+#include <cmath>
+#include <cstdint>
+
+#include <pmt/pmt.h>
+
+#include <osmosdr/time_spec.h>
+
+/*!
+ * A point in time as an integer count of ticks at a whole number of ticks
+ * per second, usually samples since the epoch at the sample rate.
+ *
+ * Moving such a time by a number of samples is exact, where time_spec_t
+ * adds up rounding errors of its fractional seconds. Only turning it into
+ * the (uint64 seconds, double fraction) tuple of an rx_time tag costs a
+ * division, and the fraction is off by no more than that double can tell.
+ *
+ * Rates with a fractional part (no device has them) are rounded.
+ */
+class tick_time_t
+{
+public:
+  tick_time_t() : _ticks(0), _rate(1) {}
+
+  tick_time_t( int64_t ticks, double rate ) :
+    _ticks(ticks), _rate( rate_of( rate ) ) {}
+
+  static tick_time_t from_secs( int64_t secs, double frac, double rate )
+  {
+    const int64_t r = rate_of( rate );
+    return tick_time_t( secs * r + std::llround( frac * r ), r, 0 );
+  }
+
+  static tick_time_t from_time_spec( const osmosdr::time_spec_t &time, double rate )
+  {
+    return from_secs( time.get_full_secs(), time.get_frac_secs(), rate );
+  }
+
+  /*! the value of an rx_time tag, zero ticks when it isn't one */
+  static tick_time_t from_rx_time( const pmt::pmt_t &value, double rate )
+  {
+    if ( ! pmt::is_tuple( value ) || pmt::length( value ) < 2 )
+      return tick_time_t( 0, rate );
+
+    return from_secs( pmt::to_uint64( pmt::tuple_ref( value, 0 ) ),
+                      pmt::to_double( pmt::tuple_ref( value, 1 ) ), rate );
+  }
+
+  int64_t ticks() const { return _ticks; }
+  int64_t rate() const { return _rate; }
+
+  /* whole seconds rounded down, the fraction is never negative */
+  int64_t full_secs() const
+  {
+    const int64_t secs = _ticks / _rate;
+    return secs - ( _ticks % _rate < 0 ? 1 : 0 );
+  }
+
+  double frac_secs() const
+  {
+    return double( _ticks - full_secs() * _rate ) / double( _rate );
+  }
+
+  osmosdr::time_spec_t to_time_spec() const
+  {
+    return osmosdr::time_spec_t( time_t( full_secs() ), frac_secs() );
+  }
+
+  pmt::pmt_t to_rx_time() const
+  {
+    const int64_t secs = full_secs();
+
+    return pmt::make_tuple( pmt::from_uint64( uint64_t( secs ) ),
+                            pmt::from_double( double( _ticks - secs * _rate ) / double( _rate ) ) );
+  }
+
+  tick_time_t &operator+=( int64_t ticks ) { _ticks += ticks; return *this; }
+  tick_time_t &operator-=( int64_t ticks ) { _ticks -= ticks; return *this; }
+
+  tick_time_t operator+( int64_t ticks ) const { return tick_time_t( _ticks + ticks, _rate, 0 ); }
+  tick_time_t operator-( int64_t ticks ) const { return tick_time_t( _ticks - ticks, _rate, 0 ); }
+
+private:
+  tick_time_t( int64_t ticks, int64_t rate, int ) : _ticks(ticks), _rate(rate) {}
+
+  static int64_t rate_of( double rate )
+  {
+    const int64_t r = std::llround( rate );
+    return r > 0 ? r : 1;
+  }
+
+  int64_t _ticks;
+  int64_t _rate;
+};
+
+#endif // OSMOSDR_TICK_TIME_H
@@ -0,0 +1,223 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/lexical_cast.hpp>
+
+#include "tx_policy.h"
+
+/* how much later than the first write the device may start to take them */
+#define START_SLACK 0.005     // seconds
+
+tx_policy_t tx_policy_from_dict( const dict_t &dict )
+{
+  tx_policy_t policy;
+
+  if ( dict.count("prefill") )
+    policy.prefill = boost::lexical_cast< size_t >( dict.at("prefill") );
+
+  if ( dict.count("underrun") ) {
+    const std::string &underrun = dict.at("underrun");
+
+    if ( "zero" == underrun )
+      policy.underrun = tx_policy_t::UNDERRUN_ZERO;
+    else if ( "repeat" == underrun )
+      policy.underrun = tx_policy_t::UNDERRUN_REPEAT;
+    else if ( "stop" == underrun )
+      policy.underrun = tx_policy_t::UNDERRUN_STOP;
+    else
+      throw std::runtime_error( "Unknown underrun policy '" + underrun +
+                                "', use zero, repeat or stop." );
+  }
+
+  if ( dict.count("tx_latency_ms") )
+    policy.latency = boost::lexical_cast< double >( dict.at("tx_latency_ms") ) / 1e3;
+
+  if ( policy.latency < 0 )
+    throw std::runtime_error( "tx_latency_ms must not be negative." );
+
+  return policy;
+}
+
+size_t tx_policy_t::latency_samples( double rate ) const
+{
+  if ( latency <= 0 || rate <= 0 )
+    return 0;
+
+  return std::max( size_t(1), size_t( std::ceil( latency * rate ) ) );
+}
+
+tx_pacer::tx_pacer() :
+  _itemsize(sizeof(gr_complex)),
+  _rate(0),
+  _prefilling(false),
+  _held_pos(0),
+  _clocked(false),
+  _written(0),
+  _underruns(0)
+{
+}
+
+void tx_pacer::init( const tx_policy_t &policy, size_t nchan, size_t itemsize )
+{
+  _policy = policy;
+  _itemsize = itemsize;
+  _held.assign( nchan, std::vector< char >() );
+  _held_items.assign( nchan, NULL );
+
+  for (std::vector< char > &held : _held)
+    held.reserve( _policy.prefill * _itemsize );
+}
+
+void tx_pacer::start( double rate )
+{
+  _rate = rate;
+  restart();
+}
+
+void tx_pacer::restart()
+{
+  for (std::vector< char > &held : _held)
+    held.clear();
+
+  _held_pos = 0;
+  _prefilling = _policy.prefill > 0;
+  _clocked = false;
+}
+
+bool tx_pacer::prefill( const gr_vector_const_void_star &in, size_t nitems )
+{
+  if ( ! _prefilling )
+    return false;
+
+  for (size_t i = 0; i < _held.size(); i++) {
+    const char *items = (const char *)in[i];
+    _held[i].insert( _held[i].end(), items, items + nitems * _itemsize );
+  }
+
+  if ( _held[0].size() >= _policy.prefill * _itemsize ) {
+    _prefilling = false;
+
+    for (size_t i = 0; i < _held.size(); i++)
+      _held_items[i] = &_held[i][0];
+  }
+
+  return true;
+}
+
+size_t tx_pacer::held() const
+{
+  if ( _prefilling || _held.empty() )
+    return 0;
+
+  return _held[0].size() / _itemsize - _held_pos;
+}
+
+void tx_pacer::consume_held( size_t nitems )
+{
+  _held_pos += nitems;
+
+  if ( held() ) {
+    for (size_t i = 0; i < _held.size(); i++)
+      _held_items[i] = &_held[i][ _held_pos * _itemsize ];
+    return;
+  }
+
+  for (std::vector< char > &held : _held)
+    held.clear();
+  _held_pos = 0;
+}
+
+bool tx_pacer::starved()
+{
+  if ( ! _clocked || _rate <= 0 )
+    return false;
+
+  std::chrono::duration< double > elapsed = clock::now() - _t0;
+  if ( ( elapsed.count() - START_SLACK ) * _rate <= double(_written) )
+    return false;
+
+  underrun();
+
+  return true;
+}
+
+void tx_pacer::underrun()
+{
+  _underruns++;
+  _clocked = false;
+
+  if ( tx_policy_t::UNDERRUN_STOP == _policy.underrun )
+    restart();
+}
+
+void tx_pacer::written( size_t nitems )
+{
+  if ( ! _clocked ) {
+    _clocked = true;
+    _t0 = clock::now();
+    _written = 0;
+  }
+
+  _written += nitems;
+}
+
+size_t tx_pacer::queued() const
+{
+  if ( ! _clocked )
+    return held();
+
+  std::chrono::duration< double > elapsed = clock::now() - _t0;
+  double sent = elapsed.count() * _rate;
+
+  return sent < double(_written) ? size_t( double(_written) - sent ) : 0;
+}
+
+void tx_pacer::throttle()
+{
+  const size_t limit = _policy.latency_samples( _rate );
+  if ( ! limit || ! _clocked )
+    return;
+
+  size_t queued = this->queued();
+  if ( queued > limit )
+    std::this_thread::sleep_for(
+          std::chrono::duration< double >( double(queued - limit) / _rate ) );
+}
+
+void tx_pacer::drain()
+{
+  if ( ! _clocked || _rate <= 0 )
+    return;
+
+  size_t queued = this->queued();
+  if ( queued )
+    std::this_thread::sleep_for(
+          std::chrono::duration< double >( double(queued) / _rate ) );
+}
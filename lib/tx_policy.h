@@ -0,0 +1,135 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TX_POLICY_H
+#define OSMOSDR_TX_POLICY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gnuradio/types.h>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * How a sink starts streaming and what it does when the flowgraph falls
+ * behind, taken from the prefill= and underrun= device arguments.
+ *
+ * prefill= is the number of samples queued before the device starts.
+ * underrun= is zero (silence, the default), repeat (the last buffer
+ * again) or stop (the stream ends and starts over, prefilled, with the
+ * next samples). tx_latency_ms= caps the samples queued on the host and
+ * in the device, writing blocks once more are.
+ */
+struct tx_policy_t
+{
+  enum underrun_t { UNDERRUN_ZERO, UNDERRUN_REPEAT, UNDERRUN_STOP };
+
+  tx_policy_t() : prefill(0), underrun(UNDERRUN_ZERO), latency(0) {}
+
+  size_t prefill;
+  underrun_t underrun;
+  double latency;         // seconds queued at most, 0 for no limit
+
+  /*! the tx_latency_ms= cap in samples at \p rate, 0 for no limit */
+  size_t latency_samples( double rate ) const;
+};
+
+OSMOSDR_API tx_policy_t tx_policy_from_dict( const dict_t &dict );
+
+/*!
+ * For the sinks handing samples to the device from work(), which don't
+ * hear from it when it runs dry.
+ *
+ * The samples of the prefill are kept here and written in one go. From
+ * then on the device is assumed to take them at the sample rate, so the
+ * host clock tells when it must have run out. With underrun=stop the
+ * prefill starts over after that.
+ */
+class OSMOSDR_API tx_pacer
+{
+public:
+  tx_pacer();
+
+  void init( const tx_policy_t &policy, size_t nchan,
+             size_t itemsize = sizeof(gr_complex) );
+  const tx_policy_t &policy() const { return _policy; }
+
+  /*! call from start(), the stream starts with a prefill */
+  void start( double rate );
+
+  /*!
+   * Keeps the \p nitems samples of every channel while prefilling and
+   * returns true, the caller consumes them without writing them. Once
+   * the prefill is complete held() tells how many wait to be written.
+   */
+  bool prefill( const gr_vector_const_void_star &in, size_t nitems );
+
+  size_t held() const;
+  const gr_vector_const_void_star &held_items() const { return _held_items; }
+  void consume_held( size_t nitems );
+
+  /*!
+   * Call before writing. True, and counted as an underrun, if the device
+   * ran out of samples since the last write.
+   */
+  bool starved();
+
+  /*! for the devices reporting an underrun themselves */
+  void underrun();
+
+  /*! call after \p nitems samples of every channel were written */
+  void written( size_t nitems );
+
+  /*! samples written the device hasn't sent yet, by the host clock */
+  size_t queued() const;
+
+  /*! blocks while more than the tx_latency_ms= cap is queued */
+  void throttle();
+
+  /*! blocks until all that was written went out */
+  void drain();
+
+  uint64_t underruns() const { return _underruns; }
+
+private:
+  typedef std::chrono::steady_clock clock;
+
+  void restart();
+
+  tx_policy_t _policy;
+  size_t _itemsize;
+  double _rate;
+
+  bool _prefilling;
+  std::vector< std::vector< char > > _held;   // per channel
+  size_t _held_pos;                           // samples already written
+  gr_vector_const_void_star _held_items;
+
+  bool _clocked;                // the device takes samples since _t0
+  clock::time_point _t0;
+  uint64_t _written;            // samples per channel since _t0
+  uint64_t _underruns;
+};
+
+#endif // OSMOSDR_TX_POLICY_H
@@ -0,0 +1,81 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cstring>
+
+#include <gnuradio/io_signature.h>
+
+#include "tx_start_tagger.h"
+
+tx_start_tagger_sptr make_tx_start_tagger( size_t nchan,
+                                           const timed_start_sptr &start,
+                                           const std::function< ::osmosdr::time_spec_t () > &now )
+{
+  return gnuradio::get_initial_sptr( new tx_start_tagger( nchan, start, now ) );
+}
+
+tx_start_tagger::tx_start_tagger( size_t nchan,
+                                  const timed_start_sptr &start,
+                                  const std::function< ::osmosdr::time_spec_t () > &now ) :
+  gr::sync_block( "tx_start_tagger",
+                  gr::io_signature::make( nchan, nchan, sizeof(gr_complex) ),
+                  gr::io_signature::make( nchan, nchan, sizeof(gr_complex) ) ),
+  _start( start ),
+  _now( now ),
+  _pending( false )
+{
+  /* the tags of every channel stay on it */
+  set_tag_propagation_policy( TPP_ONE_TO_ONE );
+}
+
+bool tx_start_tagger::start()
+{
+  _pending = true;
+
+  return true;
+}
+
+bool tx_start_tagger::stop()
+{
+  _start->reset();
+
+  return true;
+}
+
+int tx_start_tagger::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  if ( _pending ) {
+    const ::osmosdr::time_spec_t time = _start->get( _now() );
+    const pmt::pmt_t value = pmt::make_tuple( pmt::from_uint64( time.get_full_secs() ),
+                                              pmt::from_double( time.get_frac_secs() ) );
+
+    for (size_t i = 0; i < output_items.size(); i++)
+      add_item_tag( i, nitems_written(i), pmt::mp("tx_time"), value, alias_pmt() );
+
+    _pending = false;
+  }
+
+  for (size_t i = 0; i < output_items.size(); i++)
+    memcpy( output_items[i], input_items[i], noutput_items * sizeof(gr_complex) );
+
+  return noutput_items;
+}
@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_TX_START_TAGGER_H
+#define INCLUDED_TX_START_TAGGER_H
+
+#include <functional>
+
+#include <gnuradio/sync_block.h>
+
+#include "device_sync.h"
+
+class tx_start_tagger;
+
+typedef std::shared_ptr<tx_start_tagger> tx_start_tagger_sptr;
+
+/*!
+ * \brief Return a shared_ptr to a new instance of tx_start_tagger.
+ * \param nchan the number of channels passed through
+ * \param start the start time shared by the devices of the sink
+ * \param now the time of the device, in the time base of \p start
+ */
+tx_start_tagger_sptr make_tx_start_tagger( size_t nchan,
+                                           const timed_start_sptr &start,
+                                           const std::function< ::osmosdr::time_spec_t () > &now );
+
+/*!
+ * \brief Puts a tx_time tag on the first sample of every channel after a
+ * start, for the sinks which hold tagged samples until then themselves.
+ */
+class tx_start_tagger : public gr::sync_block
+{
+private:
+  friend tx_start_tagger_sptr make_tx_start_tagger( size_t nchan,
+                                                    const timed_start_sptr &start,
+                                                    const std::function< ::osmosdr::time_spec_t () > &now );
+
+  tx_start_tagger( size_t nchan,
+                   const timed_start_sptr &start,
+                   const std::function< ::osmosdr::time_spec_t () > &now );
+
+public:
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  timed_start_sptr _start;
+  std::function< ::osmosdr::time_spec_t () > _now;
+  bool _pending;                // the next sample is the first after start()
+};
+
+#endif /* INCLUDED_TX_START_TAGGER_H */
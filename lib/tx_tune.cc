@@ -0,0 +1,76 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <iostream>
+
+#include "tx_tune.h"
+
+const pmt::pmt_t &TX_FREQ_KEY()
+{
+  static const pmt::pmt_t key = pmt::string_to_symbol("tx_freq");
+  return key;
+}
+
+const pmt::pmt_t &TX_GAIN_KEY()
+{
+  static const pmt::pmt_t key = pmt::string_to_symbol("tx_gain");
+  return key;
+}
+
+int tx_tune_from_tags( const std::vector< gr::tag_t > &tags,
+                       uint64_t start, int nitems,
+                       tx_tune_t &tune )
+{
+  for (const gr::tag_t &tag : tags) {
+    const bool freq = pmt::eq( tag.key, TX_FREQ_KEY() );
+
+    if ( ! freq && ! pmt::eq( tag.key, TX_GAIN_KEY() ) )
+      continue;
+
+    if ( tag.offset < start || tag.offset >= start + nitems )
+      continue;
+
+    /* the write ends in front of it */
+    if ( tag.offset > start ) {
+      nitems = int( tag.offset - start );
+      continue;
+    }
+
+    if ( ! pmt::is_real( tag.value ) && ! pmt::is_integer( tag.value ) ) {
+      std::cerr << "Ignoring " << pmt::symbol_to_string( tag.key )
+                << " tag without a number." << std::endl;
+      continue;
+    }
+
+    if ( freq ) {
+      tune.has_freq = true;
+      tune.freq = pmt::to_double( tag.value );
+    } else {
+      tune.has_gain = true;
+      tune.gain = pmt::to_double( tag.value );
+    }
+  }
+
+  return nitems;
+}
@@ -0,0 +1,60 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TX_TUNE_H
+#define OSMOSDR_TX_TUNE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <gnuradio/tags.h>
+
+#include <osmosdr/api.h>
+
+/*!
+ * Retuning at a sample of the stream, asked for with tx_freq and tx_gain
+ * tags holding a number. The backends with timed commands apply them
+ * exactly at the tagged sample. The others end a write just before it,
+ * wait for what is queued to go out, and apply them before the next one.
+ */
+struct tx_tune_t
+{
+  tx_tune_t() : has_freq(false), freq(0), has_gain(false), gain(0) {}
+
+  bool empty() const { return !has_freq && !has_gain; }
+
+  bool has_freq;
+  double freq;
+  bool has_gain;
+  double gain;
+};
+
+OSMOSDR_API const pmt::pmt_t &TX_FREQ_KEY();
+OSMOSDR_API const pmt::pmt_t &TX_GAIN_KEY();
+
+/*!
+ * Go through the \p tags of one input, read before \p start + \p nitems.
+ * The tune tags at \p start are added to \p tune. Returns the number of
+ * samples up to the next tune tag after \p start, \p nitems if none.
+ */
+OSMOSDR_API int tx_tune_from_tags( const std::vector< gr::tag_t > &tags,
+                                   uint64_t start, int nitems,
+                                   tx_tune_t &tune );
+
+#endif // OSMOSDR_TX_TUNE_H
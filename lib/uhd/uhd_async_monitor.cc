@@ -0,0 +1,107 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/io_signature.h>
+
+#include "uhd_async_monitor.h"
+
+uhd_async_monitor_sptr make_uhd_async_monitor( size_t nchan )
+{
+  return gnuradio::get_initial_sptr( new uhd_async_monitor( nchan ) );
+}
+
+uhd_async_monitor::uhd_async_monitor( size_t nchan ) :
+  gr::block( "uhd_async_monitor",
+             gr::io_signature::make( 0, 0, 0 ),
+             gr::io_signature::make( 0, 0, 0 ) )
+{
+  for (size_t i = 0; i < nchan; i++) {
+    std::unique_ptr<counters_t> c( new counters_t );
+    c->underruns = 0;
+    c->late = 0;
+    c->seq_errors = 0;
+    c->bursts = 0;
+    _chans.push_back( std::move( c ) );
+  }
+
+  message_port_register_in( pmt::mp("in") );
+  message_port_register_out( pmt::mp("async_msgs") );
+  set_msg_handler( pmt::mp("in"),
+                   [this]( pmt::pmt_t msg ) { this->handle( msg ); } );
+}
+
+/* ("uhd_async_msg" . ((event_code . (<codes>)) (channel . <n>) ...)) */
+void uhd_async_monitor::handle( pmt::pmt_t msg )
+{
+  static const pmt::pmt_t EVENT_CODE_KEY = pmt::mp("event_code");
+  static const pmt::pmt_t CHANNEL_KEY = pmt::mp("channel");
+
+  message_port_pub( pmt::mp("async_msgs"), msg );
+
+  if ( ! pmt::is_pair( msg ) || ! pmt::is_dict( pmt::cdr( msg ) ) )
+    return;
+
+  const pmt::pmt_t dict = pmt::cdr( msg );
+
+  size_t chan = 0;
+  const pmt::pmt_t channel = pmt::dict_ref( dict, CHANNEL_KEY, pmt::PMT_NIL );
+  if ( pmt::is_integer( channel ) || pmt::is_uint64( channel ) )
+    chan = pmt::to_uint64( channel );
+
+  if ( chan >= _chans.size() )
+    return;
+
+  counters_t &c = *_chans[chan];
+
+  pmt::pmt_t codes = pmt::dict_ref( dict, EVENT_CODE_KEY, pmt::PMT_NIL );
+  if ( pmt::is_symbol( codes ) )
+    codes = pmt::list1( codes );
+
+  for ( ; pmt::is_pair( codes ); codes = pmt::cdr( codes ) )
+  {
+    const std::string code = pmt::symbol_to_string( pmt::car( codes ) );
+
+    if ( "underflow" == code || "underflow_in_packet" == code )
+      c.underruns++;
+    else if ( "time_error" == code )
+      c.late++;
+    else if ( "seq_error" == code || "seq_error_in_burst" == code )
+      c.seq_errors++;
+    else if ( "burst_ack" == code )
+      c.bursts++;
+  }
+}
+
+osmosdr::stream_stats_t uhd_async_monitor::get_stream_stats( size_t chan ) const
+{
+  osmosdr::stream_stats_t stats;
+
+  if ( chan >= _chans.size() )
+    return stats;
+
+  const counters_t &c = *_chans[chan];
+
+  stats.underruns = c.underruns;
+  stats.late = c.late;
+  stats.lost_packets = c.seq_errors;
+  stats.bursts = c.bursts;
+
+  return stats;
+}
@@ -0,0 +1,69 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef UHD_ASYNC_MONITOR_H
+#define UHD_ASYNC_MONITOR_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gnuradio/block.h>
+
+#include "osmosdr/stream_stats.h"
+
+class uhd_async_monitor;
+
+typedef std::shared_ptr< uhd_async_monitor > uhd_async_monitor_sptr;
+
+uhd_async_monitor_sptr make_uhd_async_monitor( size_t nchan );
+
+/*!
+ * Counts the async events usrp_sink reports on its async_msgs port, which
+ * its own thread takes from the tx_streamer's recv_async_msg(): underflows,
+ * time errors (late packets), sequence errors and burst acks. The messages
+ * are passed on unchanged for whoever wants to act on the events as they
+ * happen.
+ */
+class uhd_async_monitor : public gr::block
+{
+private:
+  friend uhd_async_monitor_sptr make_uhd_async_monitor( size_t nchan );
+
+  uhd_async_monitor( size_t nchan );
+
+public:
+  /* underruns, late, lost_packets and bursts of channel \p chan */
+  osmosdr::stream_stats_t get_stream_stats( size_t chan ) const;
+
+private:
+  void handle( pmt::pmt_t msg );
+
+  struct counters_t
+  {
+    std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> late;
+    std::atomic<uint64_t> seq_errors;
+    std::atomic<uint64_t> bursts;
+  };
+
+  std::vector< std::unique_ptr<counters_t> > _chans;
+};
+
+#endif // UHD_ASYNC_MONITOR_H
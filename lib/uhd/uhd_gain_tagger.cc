@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include <gnuradio/io_signature.h>
+
+#include "tx_tune.h"
+#include "uhd_gain_tagger.h"
+
+uhd_gain_tagger_sptr make_uhd_gain_tagger( size_t nchan )
+{
+  return gnuradio::get_initial_sptr( new uhd_gain_tagger( nchan ) );
+}
+
+uhd_gain_tagger::uhd_gain_tagger( size_t nchan ) :
+  gr::sync_block( "uhd_gain_tagger",
+                  gr::io_signature::make( nchan, nchan, sizeof(gr_complex) ),
+                  gr::io_signature::make( nchan, nchan, sizeof(gr_complex) ) )
+{
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+int uhd_gain_tagger::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  static const pmt::pmt_t COMMAND_KEY = pmt::string_to_symbol("tx_command");
+
+  for (size_t i = 0; i < output_items.size(); i++)
+  {
+    get_tags_in_window( _tags, i, 0, noutput_items );
+
+    for (const gr::tag_t &tag : _tags)
+    {
+      if ( ! pmt::eq( tag.key, TX_GAIN_KEY() ) ) {
+        add_item_tag( i, tag );
+        continue;
+      }
+
+      if ( ! pmt::is_real( tag.value ) && ! pmt::is_integer( tag.value ) ) {
+        std::cerr << "Ignoring tx_gain tag without a number." << std::endl;
+        continue;
+      }
+
+      pmt::pmt_t cmd = pmt::make_dict();
+      cmd = pmt::dict_add( cmd, pmt::mp("gain"), pmt::from_double( pmt::to_double( tag.value ) ) );
+      cmd = pmt::dict_add( cmd, pmt::mp("chan"), pmt::from_long( long(i) ) );
+
+      add_item_tag( i, tag.offset, COMMAND_KEY, cmd, alias_pmt() );
+    }
+
+    memcpy( output_items[i], input_items[i], noutput_items * sizeof(gr_complex) );
+  }
+
+  return noutput_items;
+}
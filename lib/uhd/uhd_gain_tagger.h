@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef UHD_GAIN_TAGGER_H
+#define UHD_GAIN_TAGGER_H
+
+#include <gnuradio/sync_block.h>
+
+class uhd_gain_tagger;
+
+typedef std::shared_ptr< uhd_gain_tagger > uhd_gain_tagger_sptr;
+
+uhd_gain_tagger_sptr make_uhd_gain_tagger( size_t nchan );
+
+/*!
+ * usrp_sink takes tx_freq tags itself but has gain changes within the
+ * stream come as tx_command tags. This turns the tx_gain tags into them,
+ * for the channel of their input, and passes the rest on unchanged.
+ */
+class uhd_gain_tagger : public gr::sync_block
+{
+private:
+  friend uhd_gain_tagger_sptr make_uhd_gain_tagger( size_t nchan );
+
+  uhd_gain_tagger( size_t nchan );
+
+public:
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  std::vector< gr::tag_t > _tags;
+};
+
+#endif // UHD_GAIN_TAGGER_H
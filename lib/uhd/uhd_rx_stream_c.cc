@@ -0,0 +1,413 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include <uhd/convert.hpp>
+
+#include "stream_tagger.h"
+#include "uhd_rx_stream_c.h"
+
+#define RECV_BATCH_PACKETS 64     // packets per recv() call, at most
+#define RECV_BATCH_DURATION 0.005 // seconds per recv() call, at most
+#define RECV_TIMEOUT 0.1          // seconds
+#define RING_DURATION 0.05        // seconds held by each channel ring
+#define RING_MIN_SAMPLES (1 << 18)
+#define XPORT_DURATION 0.02       // seconds buffered in the transport
+#define XPORT_FRAME_SIZE 8000     // assumed when recv_frame_size isn't given
+#define XPORT_MIN_FRAMES 32
+#define XPORT_MAX_FRAMES 4096
+#define START_DELAY 0.05          // seconds, lead of the timed stream command
+
+uhd_rx_stream_c_sptr make_uhd_rx_stream_c(::uhd::usrp::multi_usrp::sptr dev,
+                                          const ::uhd::stream_args_t &stream_args,
+                                          const buffer_opts_t &buf_opts,
+                                          const thread_sched_t &sched)
+{
+  return gnuradio::get_initial_sptr(new uhd_rx_stream_c(dev, stream_args, buf_opts, sched));
+}
+
+uhd_rx_stream_c::uhd_rx_stream_c(::uhd::usrp::multi_usrp::sptr dev,
+                                 const ::uhd::stream_args_t &stream_args,
+                                 const buffer_opts_t &buf_opts,
+                                 const thread_sched_t &sched) :
+  gr::sync_block("uhd_rx_stream_c",
+                 gr::io_signature::make(0, 0, 0),
+                 gr::io_signature::make(stream_args.channels.size(),
+                                        stream_args.channels.size(),
+                                        sizeof(gr_complex))),
+  _dev(dev),
+  _stream_args(stream_args),
+  _running(false),
+  _sched(sched)
+{
+  if ( "fc32" != _stream_args.cpu_format )
+    throw std::runtime_error("native streaming requires cpu_format=fc32");
+
+  for (size_t chan = 0; chan < _stream_args.channels.size(); chan++)
+  {
+    std::unique_ptr<channel_t> ch(new channel_t);
+    ch->ring.set_buffer_opts( buf_opts );
+    ch->batch = 0;
+    ch->read = 0;
+    ch->samples = 0;
+    ch->dropped = 0;
+    ch->overruns = 0;
+    _chans.push_back( std::move(ch) );
+  }
+}
+
+uhd_rx_stream_c::~uhd_rx_stream_c()
+{
+}
+
+/* Size the transport to hold XPORT_DURATION worth of samples, so the
+ * receive thread can be descheduled for a while without the NIC or the
+ * kernel running out of frames. Whatever the user gave is kept. */
+void uhd_rx_stream_c::set_xport_args( ::uhd::stream_args_t &args, double rate )
+{
+  size_t frame_size = XPORT_FRAME_SIZE;
+
+  if ( args.args.has_key("recv_frame_size") )
+    frame_size = boost::lexical_cast< size_t >( args.args["recv_frame_size"] );
+
+  double bytes = rate * XPORT_DURATION *
+                 ::uhd::convert::get_bytes_per_item( args.otw_format ) * 2;
+
+  size_t frames = size_t( std::ceil( bytes / frame_size ) );
+  frames = std::max( size_t(XPORT_MIN_FRAMES), std::min( size_t(XPORT_MAX_FRAMES), frames ) );
+
+  if ( ! args.args.has_key("num_recv_frames") )
+    args.args["num_recv_frames"] = boost::lexical_cast< std::string >( frames );
+
+  /* socket buffer of the network transports, ignored by the others */
+  if ( ! args.args.has_key("recv_buff_size") )
+    args.args["recv_buff_size"] = boost::lexical_cast< std::string >( frames * frame_size );
+}
+
+/* Ask for RECV_BATCH_PACKETS packets per recv(), but no more than
+ * RECV_BATCH_DURATION worth of them, so that at low rates the receive
+ * thread doesn't sit in recv() for the better part of a second before
+ * anything reaches the ring. At least one packet is always asked for. */
+size_t uhd_rx_stream_c::batch_len( size_t chan, double rate ) const
+{
+  const size_t packet = _chans[chan]->stream->get_max_num_samps();
+  const size_t len = size_t( rate * RECV_BATCH_DURATION );
+
+  return std::max( packet, std::min( packet * RECV_BATCH_PACKETS, len ) );
+}
+
+void uhd_rx_stream_c::update_rate()
+{
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+    if ( _chans[chan]->stream )
+      _chans[chan]->batch = batch_len( chan, _dev->get_rx_rate( _stream_args.channels[chan] ) );
+}
+
+bool uhd_rx_stream_c::start()
+{
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+  {
+    channel_t &ch = *_chans[chan];
+    double rate = _dev->get_rx_rate( _stream_args.channels[chan] );
+
+    ::uhd::stream_args_t args = _stream_args;
+    args.channels = std::vector<size_t>( 1, _stream_args.channels[chan] );
+    set_xport_args( args, rate );
+
+    ch.stream.reset();
+    ch.stream = _dev->get_rx_stream( args );
+    ch.batch = batch_len( chan, rate );
+
+    /* room for two of the largest batches a later rate change may ask for */
+    size_t capacity = std::max( size_t(RING_MIN_SAMPLES), size_t(rate * RING_DURATION) );
+    capacity = std::max( capacity, 2 * ch.stream->get_max_num_samps() * RECV_BATCH_PACKETS );
+    if ( ch.ring.capacity() != capacity )
+      ch.ring.resize( capacity );
+    else
+      ch.ring.reset();
+
+    ch.read = 0;
+    ch.events.clear();
+    ch.retunes.clear();
+  }
+
+  ::uhd::stream_cmd_t cmd( ::uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS );
+  cmd.num_samps = 0;
+  cmd.stream_now = ( _chans.size() == 1 );
+  if ( ! cmd.stream_now )
+    cmd.time_spec = _dev->get_time_now() + ::uhd::time_spec_t( START_DELAY );
+
+  _running = true;
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+  {
+    channel_t &ch = *_chans[chan];
+
+    ch.stream->issue_stream_cmd( cmd );
+    ch.thread = gr::thread::thread( boost::bind(&uhd_rx_stream_c::recv_loop, this, chan) );
+  }
+
+  return true;
+}
+
+bool uhd_rx_stream_c::stop()
+{
+  ::uhd::stream_cmd_t cmd( ::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS );
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+    if ( _chans[chan]->stream )
+      _chans[chan]->stream->issue_stream_cmd( cmd );
+
+  _running = false;
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+  {
+    channel_t &ch = *_chans[chan];
+
+    if ( ch.thread.joinable() )
+      ch.thread.join();
+
+    ch.ring.close();
+  }
+
+  /* drain what is still in flight, so the next start sees fresh samples */
+  std::vector<gr_complex> buf;
+  ::uhd::rx_metadata_t md;
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+  {
+    channel_t &ch = *_chans[chan];
+
+    if ( ! ch.stream )
+      continue;
+
+    buf.resize( ch.stream->get_max_num_samps() );
+    while ( ch.stream->recv( &buf[0], buf.size(), md, RECV_TIMEOUT, true ) )
+      ;
+  }
+
+  return true;
+}
+
+void uhd_rx_stream_c::recv_loop( size_t chan )
+{
+  channel_t &ch = *_chans[chan];
+  const double rate = _dev->get_rx_rate( _stream_args.channels[chan] );
+
+  thread_sched_apply( _sched );
+
+  std::vector<gr_complex> scratch( ch.stream->get_max_num_samps() * RECV_BATCH_PACKETS );
+  ::uhd::rx_metadata_t md;
+  ::uhd::time_spec_t next;
+  bool tag = true;
+  bool have_next = false;
+
+  while ( _running )
+  {
+    size_t count;
+    gr_complex *buf = ch.ring.write_ptr( count );
+    bool full = ( 0 == count );
+
+    /* keep the transport drained while the flowgraph falls behind */
+    if ( full ) {
+      buf = &scratch[0];
+      count = scratch.size();
+    }
+
+    count = std::min( count, ch.batch.load() );
+
+    size_t n = ch.stream->recv( buf, count, md, RECV_TIMEOUT, false );
+
+    switch ( md.error_code )
+    {
+    case ::uhd::rx_metadata_t::ERROR_CODE_NONE:
+      break;
+    case ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT:
+      break;                      // keeps what arrived before it
+    case ::uhd::rx_metadata_t::ERROR_CODE_OVERFLOW:
+      ch.overruns++;
+      tag = true;
+      std::cerr << "O" << std::flush;
+      break;
+    default:
+      std::cerr << "uhd: receive error on channel " << chan << ": "
+                << md.strerror() << std::endl;
+      tag = true;
+      break;
+    }
+
+    if ( ! n )
+      continue;
+
+    if ( full ) {
+      ch.overruns++;
+      ch.dropped += n;
+      tag = true;
+      have_next = false;
+      std::cerr << "O" << std::flush;
+      continue;
+    }
+
+    if ( md.has_time_spec ) {
+      const ::uhd::time_spec_t end = md.time_spec + ::uhd::time_spec_t::from_ticks( n, rate );
+      std::lock_guard<std::mutex> lock( ch.events_mutex );
+
+      if ( tag ) {
+        if ( have_next && md.time_spec > next )
+          ch.dropped += uint64_t( std::llround( (md.time_spec - next).get_real_secs() * rate ) );
+
+        ch.events.push_back( std::make_pair( uint64_t( ch.ring.write_count() ), md.time_spec ) );
+      }
+
+      while ( ! ch.hops.empty() && ch.hops.front().first < end ) {
+        const ::uhd::time_spec_t &time = ch.hops.front().first;
+        uint64_t pos = ch.ring.write_count();
+
+        if ( time > md.time_spec )
+          pos += uint64_t( std::llround( (time - md.time_spec).get_real_secs() * rate ) );
+
+        ch.retunes.push_back( std::make_pair( pos, ch.hops.front().second ) );
+        ch.hops.pop_front();
+      }
+
+      next = end;
+      have_next = true;
+      tag = false;
+    }
+
+    ch.ring.commit( n );
+    ch.samples += n;
+  }
+}
+
+/* rx_time, rx_rate and rx_freq at every position the stream (re)started */
+void uhd_rx_stream_c::add_tags( size_t chan, int noutput_items )
+{
+  channel_t &ch = *_chans[chan];
+  const size_t mchan = _stream_args.channels[chan];
+
+  std::lock_guard<std::mutex> lock( ch.events_mutex );
+
+  while ( ! ch.events.empty() && ch.events.front().first < ch.read + noutput_items )
+  {
+    const uint64_t pos = ch.events.front().first;
+    const ::uhd::time_spec_t &time = ch.events.front().second;
+    const uint64_t offset = nitems_written(chan) + ( pos > ch.read ? pos - ch.read : 0 );
+
+    add_item_tag( chan, offset, stream_tagger::TIME_KEY(),
+                  pmt::make_tuple( pmt::from_uint64( time.get_full_secs() ),
+                                   pmt::from_double( time.get_frac_secs() ) ),
+                  alias_pmt() );
+    add_item_tag( chan, offset, stream_tagger::RATE_KEY(),
+                  pmt::from_double( _dev->get_rx_rate( mchan ) ), alias_pmt() );
+    add_item_tag( chan, offset, stream_tagger::FREQ_KEY(),
+                  pmt::from_double( _dev->get_rx_freq( mchan ) ), alias_pmt() );
+
+    ch.events.pop_front();
+  }
+
+  while ( ! ch.retunes.empty() && ch.retunes.front().first < ch.read + noutput_items )
+  {
+    const uint64_t pos = ch.retunes.front().first;
+    const uint64_t offset = nitems_written(chan) + ( pos > ch.read ? pos - ch.read : 0 );
+
+    add_item_tag( chan, offset, stream_tagger::FREQ_KEY(),
+                  pmt::from_double( ch.retunes.front().second ), alias_pmt() );
+
+    ch.retunes.pop_front();
+  }
+}
+
+void uhd_rx_stream_c::add_hop( size_t chan, const ::uhd::time_spec_t &time, double freq )
+{
+  if ( chan >= _chans.size() )
+    return;
+
+  channel_t &ch = *_chans[chan];
+
+  std::lock_guard<std::mutex> lock( ch.events_mutex );
+
+  /* hops are scheduled in order, except when several schedules run */
+  auto pos = std::upper_bound( ch.hops.begin(), ch.hops.end(), time,
+                               []( const ::uhd::time_spec_t &t,
+                                   const std::pair< ::uhd::time_spec_t, double > &hop ) {
+                                 return t < hop.first;
+                               } );
+  ch.hops.insert( pos, std::make_pair( time, freq ) );
+}
+
+int uhd_rx_stream_c::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  size_t avail = noutput_items;
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+  {
+    channel_t &ch = *_chans[chan];
+
+    while ( ! ch.ring.wait_for( 1, std::chrono::milliseconds(100) ) )
+      if ( ! _running || ch.ring.closed() )
+        return WORK_DONE;
+
+    avail = std::min( avail, ch.ring.size() );
+  }
+
+  for (size_t chan = 0; chan < _chans.size(); chan++)
+  {
+    channel_t &ch = *_chans[chan];
+
+    add_tags( chan, avail );
+
+    ch.ring.pop( (gr_complex *)output_items[chan], avail );
+    ch.read += avail;
+  }
+
+  return avail;
+}
+
+osmosdr::stream_stats_t uhd_rx_stream_c::get_stream_stats( size_t chan ) const
+{
+  osmosdr::stream_stats_t stats;
+
+  if ( chan >= _chans.size() )
+    return stats;
+
+  const channel_t &ch = *_chans[chan];
+
+  stats.samples = ch.samples;
+  stats.dropped = ch.dropped;
+  stats.overruns = ch.overruns;
+  stats.fill = ch.ring.size();
+  stats.fill_max = ch.ring.fill_max();
+  stats.capacity = ch.ring.capacity();
+
+  return stats;
+}
@@ -0,0 +1,128 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef UHD_RX_STREAM_C_H
+#define UHD_RX_STREAM_C_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include <uhd/stream.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+
+#include "osmosdr/stream_stats.h"
+#include "buffer_pool.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+
+class uhd_rx_stream_c;
+
+typedef std::shared_ptr< uhd_rx_stream_c > uhd_rx_stream_c_sptr;
+
+uhd_rx_stream_c_sptr make_uhd_rx_stream_c(::uhd::usrp::multi_usrp::sptr dev,
+                                          const ::uhd::stream_args_t &stream_args,
+                                          const buffer_opts_t &buf_opts = buffer_opts_t(),
+                                          const thread_sched_t &sched = thread_sched_t());
+
+/*!
+ * Receives straight from UHD, without going through gr::uhd::usrp_source.
+ *
+ * Every channel gets its own rx_streamer and receive thread, which pulls
+ * many packets per recv() call into a ring. work() only copies out of the
+ * rings, so the flowgraph scheduler is off the receive path. Transport
+ * arguments the user didn't give are picked from the sample rate when the
+ * streamers are created in start().
+ *
+ * Since the channels are streamed independently they are started with a
+ * common timed command. An overflow on one channel shifts it against the
+ * others, which is what the rx_time tag attached after it tells.
+ */
+class uhd_rx_stream_c : public gr::sync_block
+{
+private:
+  friend uhd_rx_stream_c_sptr make_uhd_rx_stream_c(::uhd::usrp::multi_usrp::sptr dev,
+                                                   const ::uhd::stream_args_t &stream_args,
+                                                   const buffer_opts_t &buf_opts,
+                                                   const thread_sched_t &sched);
+
+  uhd_rx_stream_c(::uhd::usrp::multi_usrp::sptr dev,
+                  const ::uhd::stream_args_t &stream_args,
+                  const buffer_opts_t &buf_opts,
+                  const thread_sched_t &sched);
+
+public:
+  ~uhd_rx_stream_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan ) const;
+
+  /*! re-size the recv() batches after the sample rate was changed */
+  void update_rate();
+
+  /*! tag rx_freq \p freq at the sample received at device \p time */
+  void add_hop( size_t chan, const ::uhd::time_spec_t &time, double freq );
+
+private:
+  struct channel_t
+  {
+    ::uhd::rx_streamer::sptr stream;
+    std::atomic<size_t> batch;        // samples asked for per recv()
+    spsc_ring<gr_complex> ring;
+    uint64_t read;                    // samples taken out of the ring
+
+    /* ring positions where the stream (re)started, with the device time */
+    std::mutex events_mutex;
+    std::deque< std::pair< uint64_t, ::uhd::time_spec_t > > events;
+
+    /* timed retunes still to come, and the ring positions they took effect at */
+    std::deque< std::pair< ::uhd::time_spec_t, double > > hops;
+    std::deque< std::pair< uint64_t, double > > retunes;
+
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> overruns;
+
+    gr::thread::thread thread;
+  };
+
+  void set_xport_args( ::uhd::stream_args_t &args, double rate );
+  size_t batch_len( size_t chan, double rate ) const;
+  void recv_loop( size_t chan );
+  void add_tags( size_t chan, int noutput_items );
+
+  ::uhd::usrp::multi_usrp::sptr _dev;
+  ::uhd::stream_args_t _stream_args;
+  std::vector< std::unique_ptr<channel_t> > _chans;
+  std::atomic<bool> _running;
+  thread_sched_t _sched;
+};
+
+#endif // UHD_RX_STREAM_C_H
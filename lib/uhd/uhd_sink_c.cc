@@ -121,8 +121,21 @@ uhd_sink_c::uhd_sink_c(const std::string &args) :
   // TODO: setting the input signature is broken for hier blocks (gnuradio bug #719)
   set_input_signature( gr::io_signature::makev( nchan, nchan, sizes ) );
 #endif
-  for ( size_t i = 0; i < nchan; i++ )
-    connect( self(), i, _snk, i );
+  /* usrp_sink applies tx_freq and tx_command tags at their sample, timed
+   * when the stream is */
+  _gains = make_uhd_gain_tagger( nchan );
+
+  for ( size_t i = 0; i < nchan; i++ ) {
+    connect( self(), i, _gains, i );
+    connect( _gains, i, _snk, i );
+  }
+
+  /* underflows and late packets, as usrp_sink gets them from the streamer */
+  _async = make_uhd_async_monitor( nchan );
+  msg_connect( _snk, pmt::mp("async_msgs"), _async, pmt::mp("in") );
+
+  message_port_register_hier_out( pmt::mp("async_msgs") );
+  msg_connect( _async, pmt::mp("async_msgs"), self(), pmt::mp("async_msgs") );
 }
 
 uhd_sink_c::~uhd_sink_c()
@@ -422,3 +435,29 @@ void uhd_sink_c::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
 {
   _snk->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
 }
+
+/* the usrp sink holds the samples tagged with tx_time until then */
+bool uhd_sink_c::set_timed_start( const timed_start_sptr &start )
+{
+  if ( _tagger )
+    return true;
+
+  gr::uhd::usrp_sink::sptr snk = _snk;
+  _tagger = make_tx_start_tagger( get_num_channels(), start, [snk]() {
+      ::uhd::time_spec_t ts = snk->get_time_now();
+      return osmosdr::time_spec_t( ts.get_full_secs(), ts.get_frac_secs() );
+    } );
+
+  for ( size_t i = 0; i < get_num_channels(); i++ ) {
+    disconnect( self(), i, _gains, i );
+    connect( self(), i, _tagger, i );
+    connect( _tagger, i, _gains, i );
+  }
+
+  return true;
+}
+
+osmosdr::stream_stats_t uhd_sink_c::get_stream_stats( size_t chan )
+{
+  return _async->get_stream_stats( chan );
+}
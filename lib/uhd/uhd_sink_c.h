@@ -24,6 +24,9 @@
 #include <gnuradio/uhd/usrp_sink.h>
 
 #include "sink_iface.h"
+#include "tx_start_tagger.h"
+#include "uhd_async_monitor.h"
+#include "uhd_gain_tagger.h"
 
 class uhd_sink_c;
 
@@ -93,11 +96,18 @@ public:
   void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
+  bool set_timed_start( const timed_start_sptr &start );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   double _center_freq;
   double _freq_corr;
   double _lo_offset;
   gr::uhd::usrp_sink::sptr _snk;
+  tx_start_tagger_sptr _tagger;         // in front of _gains for a timed start
+  uhd_gain_tagger_sptr _gains;          // tx_gain tags to tx_command ones
+  uhd_async_monitor_sptr _async;        // counts the events of async_msgs
 };
 
 #endif // UHD_SINK_C_H
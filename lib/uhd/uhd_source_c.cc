@@ -80,6 +80,13 @@ uhd_source_c::uhd_source_c(const std::string &args) :
          "nchan" == entry.first ||
          "subdev" == entry.first ||
          "lo_offset" == entry.first ||
+         "native" == entry.first ||
+         "buf_huge" == entry.first ||
+         "buf_lock" == entry.first ||
+         "buf_node" == entry.first ||
+         "rx_cpu" == entry.first ||
+         "rx_prio" == entry.first ||
+         "rx_policy" == entry.first ||
          "uhd" == entry.first )
       continue;
 
@@ -122,8 +129,29 @@ uhd_source_c::uhd_source_c(const std::string &args) :
   // TODO: setting the output signature is broken for hier blocks (gnuradio bug #719)
   set_output_signature( gr::io_signature::makev( nchan, nchan, sizes ) );
 #endif
-  for ( size_t i = 0; i < nchan; i++ )
-    connect( _src, i, self(), i );
+
+  /* _src stays around for the control calls, it just isn't connected */
+  if (dict.count("native") && dict["native"] != "0")
+  {
+    const char *xport_keys[] = { "recv_frame_size", "num_recv_frames", "recv_buff_size" };
+
+    for (const char *key : xport_keys)
+      if (dict.count(key))
+        stream_args.args[key] = dict[key];
+
+    _rx = make_uhd_rx_stream_c( _src->get_device(), stream_args,
+                                buffer_opts_from_dict( dict ),
+                                thread_sched_from_dict( dict ) );
+
+    std::cerr << "-- Using native UHD streaming." << std::endl;
+  }
+
+  for ( size_t i = 0; i < nchan; i++ ) {
+    if ( _rx )
+      connect( _rx, i, self(), i );
+    else
+      connect( _src, i, self(), i );
+  }
 }
 
 uhd_source_c::~uhd_source_c()
@@ -199,6 +227,10 @@ osmosdr::meta_range_t uhd_source_c::get_sample_rates( void )
 double uhd_source_c::set_sample_rate( double rate )
 {
   _src->set_samp_rate( rate );
+
+  if ( _rx )
+    _rx->update_rate();
+
   return get_sample_rate();
 }
 
@@ -454,3 +486,46 @@ void uhd_source_c::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
 {
   _src->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
 }
+
+osmosdr::stream_stats_t uhd_source_c::get_stream_stats( size_t chan )
+{
+  if ( _rx )
+    return _rx->get_stream_stats( chan );
+
+  return osmosdr::stream_stats_t();
+}
+
+/* nothing to prepare, a hop is a full tune at the command time */
+size_t uhd_source_c::set_hop_freqs( const std::vector<double> &freqs, size_t chan )
+{
+  _hop_freqs[ chan ] = freqs;
+
+  return freqs.size();
+}
+
+double uhd_source_c::hop_center_freq( size_t index, const osmosdr::time_spec_t &time,
+                                      size_t chan )
+{
+  const std::vector<double> &freqs = _hop_freqs[ chan ];
+
+  if ( index >= freqs.size() )
+    throw std::runtime_error( "Hop index is out of range." );
+
+  const bool timed = time.get_real_secs() > 0;
+  const uhd::time_spec_t ts( time.get_full_secs(), time.get_frac_secs() );
+
+  if ( timed )
+    _src->set_command_time( ts );
+
+  set_center_freq( freqs[ index ], chan );
+
+  if ( timed ) {
+    _src->clear_command_time();
+
+    /* only the native stream knows the sample to tag, usrp_source does not */
+    if ( _rx )
+      _rx->add_hop( chan, ts, freqs[ index ] );
+  }
+
+  return freqs[ index ];
+}
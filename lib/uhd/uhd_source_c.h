@@ -20,10 +20,13 @@
 #ifndef UHD_SOURCE_C_H
 #define UHD_SOURCE_C_H
 
+#include <map>
+
 #include <gnuradio/hier_block2.h>
 #include <gnuradio/uhd/usrp_source.h>
 
 #include "source_iface.h"
+#include "uhd_rx_stream_c.h"
 
 class uhd_source_c;
 
@@ -73,9 +76,11 @@ public:
 
   void set_dc_offset_mode( int mode, size_t chan = 0 );
   void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 );
+  bool has_dc_offset_correction( size_t chan = 0 ) { return true; }
 
   void set_iq_balance_mode( int mode, size_t chan = 0 );
   void set_iq_balance( const std::complex<double> &balance, size_t chan = 0 );
+  bool has_iq_balance_correction( size_t chan = 0 ) { return true; }
 
   double set_bandwidth( double bandwidth, size_t chan = 0 );
   double get_bandwidth( size_t chan = 0 );
@@ -95,11 +100,20 @@ public:
   void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+  size_t set_hop_freqs( const std::vector<double> &freqs, size_t chan = 0 );
+  double hop_center_freq( size_t index, const osmosdr::time_spec_t &time,
+                          size_t chan = 0 );
+  bool has_timed_hops( size_t chan = 0 ) { return true; }
+
 private:
   double _center_freq;
   double _freq_corr;
   double _lo_offset;
   gr::uhd::usrp_source::sptr _src;
+  uhd_rx_stream_c_sptr _rx;   // native=1, streams in place of _src
+  std::map< size_t, std::vector<double> > _hop_freqs;
 };
 
 #endif // UHD_SOURCE_C_H
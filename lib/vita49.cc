@@ -0,0 +1,240 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "vita49.h"
+
+#define TYPE_DATA_SID 0x1
+#define TYPE_CONTEXT 0x4
+
+#define TSI_UTC 0x1
+#define TSF_REAL_TIME 0x2
+
+#define CIF_CHANGE (1u << 31)
+#define CIF_RF_FREQ (1u << 27)
+#define CIF_RATE (1u << 21)
+
+#define RADIX 1048576.0             // 20 bit fraction of the frequency fields
+
+static inline void put32( uint8_t *buf, uint32_t value )
+{
+  buf[0] = uint8_t( value >> 24 );
+  buf[1] = uint8_t( value >> 16 );
+  buf[2] = uint8_t( value >> 8 );
+  buf[3] = uint8_t( value );
+}
+
+static inline void put64( uint8_t *buf, uint64_t value )
+{
+  put32( buf, uint32_t( value >> 32 ) );
+  put32( buf + 4, uint32_t( value ) );
+}
+
+static inline uint32_t get32( const uint8_t *buf )
+{
+  return uint32_t( buf[0] ) << 24 | uint32_t( buf[1] ) << 16 |
+         uint32_t( buf[2] ) << 8 | uint32_t( buf[3] );
+}
+
+static inline uint64_t get64( const uint8_t *buf )
+{
+  return uint64_t( get32( buf ) ) << 32 | get32( buf + 4 );
+}
+
+static uint32_t header( unsigned type, bool class_id, unsigned count, size_t bytes )
+{
+  return type << 28 | ( class_id ? 1u << 27 : 0 ) |
+         TSI_UTC << 22 | TSF_REAL_TIME << 20 |
+         ( count & 0xf ) << 16 | uint32_t( bytes / 4 );
+}
+
+size_t vita49_data_header( uint8_t *buf, uint32_t stream_id,
+                           unsigned count, uint64_t secs, uint64_t ps,
+                           size_t payload_bytes )
+{
+  const size_t bytes = VITA49_HEADER_BYTES + payload_bytes;
+
+  put32( buf, header( TYPE_DATA_SID, false, count, bytes ) );
+  put32( buf + 4, stream_id );
+  put32( buf + 8, uint32_t( secs ) );
+  put64( buf + 12, ps );
+
+  return bytes;
+}
+
+size_t vita49_context( uint8_t *buf, uint32_t stream_id,
+                       unsigned count, uint64_t secs, uint64_t ps,
+                       vita49_format_t format,
+                       double freq, double rate )
+{
+  put32( buf, header( TYPE_CONTEXT, true, count, VITA49_CONTEXT_BYTES ) );
+  put32( buf + 4, stream_id );
+
+  /* no OUI, the packet class code tells the payload format */
+  put32( buf + 8, 0 );
+  put32( buf + 12, uint32_t( format ) );
+
+  put32( buf + 16, uint32_t( secs ) );
+  put64( buf + 20, ps );
+
+  put32( buf + 28, CIF_CHANGE | CIF_RF_FREQ | CIF_RATE );
+  put64( buf + 32, uint64_t( int64_t( std::llround( freq * RADIX ) ) ) );
+  put64( buf + 40, uint64_t( int64_t( std::llround( rate * RADIX ) ) ) );
+
+  return VITA49_CONTEXT_BYTES;
+}
+
+void vita49_pack( const gr_complex *in, uint8_t *out, size_t nitems,
+                  vita49_format_t format, float scale )
+{
+  const float *src = (const float *)in;
+
+  if ( VITA49_CS8 == format ) {
+    const float k = 127.0f * scale;
+
+    for (size_t i = 0; i < 2 * nitems; i++)
+      out[i] = uint8_t( int8_t( std::max( -128.0f, std::min( 127.0f, src[i] * k ) ) ) );
+  } else {
+    const float k = 32767.0f * scale;
+
+    for (size_t i = 0; i < 2 * nitems; i++) {
+      int16_t v = int16_t( std::max( -32768.0f, std::min( 32767.0f, src[i] * k ) ) );
+      out[2 * i] = uint8_t( uint16_t( v ) >> 8 );
+      out[2 * i + 1] = uint8_t( v );
+    }
+  }
+}
+
+void vita49_unpack( const uint8_t *in, gr_complex *out, size_t nitems,
+                    vita49_format_t format )
+{
+  float *dst = (float *)out;
+
+  if ( VITA49_CS8 == format ) {
+    for (size_t i = 0; i < 2 * nitems; i++)
+      dst[i] = int8_t( in[i] ) * ( 1.0f / 128.0f );
+  } else {
+    for (size_t i = 0; i < 2 * nitems; i++)
+      dst[i] = int16_t( uint16_t( in[2 * i] ) << 8 | in[2 * i + 1] ) * ( 1.0f / 32768.0f );
+  }
+}
+
+bool vita49_parse( const uint8_t *buf, size_t len, vita49_packet_t &pkt )
+{
+  if ( len < 8 )
+    return false;
+
+  const uint32_t word = get32( buf );
+  const unsigned type = word >> 28;
+  const size_t bytes = ( word & 0xffff ) * 4;
+
+  if ( ( TYPE_DATA_SID != type && TYPE_CONTEXT != type ) || bytes > len || bytes < 8 )
+    return false;
+
+  pkt.context = TYPE_CONTEXT == type;
+  pkt.count = ( word >> 16 ) & 0xf;
+  pkt.stream_id = get32( buf + 4 );
+  pkt.secs = pkt.ps = 0;
+  pkt.payload = NULL;
+  pkt.payload_bytes = 0;
+  pkt.has_format = pkt.has_freq = pkt.has_rate = false;
+
+  const uint8_t *p = buf + 8;
+  const uint8_t *end = buf + bytes;
+
+  /* data packets with a trailer end one word early */
+  if ( ! pkt.context && ( word & ( 1u << 26 ) ) )
+    end -= 4;
+
+  if ( word & ( 1u << 27 ) ) {
+    if ( end - p < 8 )
+      return false;
+
+    uint32_t code = get32( p + 4 ) & 0xffff;
+    if ( 0 == ( get32( p ) & 0xffffff ) && ( VITA49_CS8 == code || VITA49_CS16 == code ) ) {
+      pkt.has_format = true;
+      pkt.format = vita49_format_t( code );
+    }
+    p += 8;
+  }
+
+  if ( ( word >> 22 ) & 0x3 ) {
+    if ( end - p < 4 )
+      return false;
+    pkt.secs = get32( p );
+    p += 4;
+  }
+
+  const unsigned tsf = ( word >> 20 ) & 0x3;
+  if ( tsf ) {
+    if ( end - p < 8 )
+      return false;
+    if ( TSF_REAL_TIME == tsf )
+      pkt.ps = get64( p );
+    p += 8;
+  }
+
+  if ( ! pkt.context ) {
+    if ( end < p )
+      return false;
+    pkt.payload = p;
+    pkt.payload_bytes = size_t( end - p );
+    return true;
+  }
+
+  if ( end - p < 4 )
+    return false;
+
+  const uint32_t cif = get32( p );
+  p += 4;
+
+  /* the fields come in the order of their bits, stop after the rate */
+  static const struct { uint32_t bit; size_t words; } fields[] = {
+    { 1u << 30, 1 }, { 1u << 29, 2 }, { 1u << 28, 2 }, { 1u << 27, 2 },
+    { 1u << 26, 2 }, { 1u << 25, 2 }, { 1u << 24, 1 }, { 1u << 23, 1 },
+    { 1u << 22, 1 }, { 1u << 21, 2 },
+  };
+
+  for (const auto &field : fields) {
+    if ( ! ( cif & field.bit ) )
+      continue;
+
+    if ( size_t( end - p ) < field.words * 4 )
+      return false;
+
+    if ( CIF_RF_FREQ == field.bit ) {
+      pkt.has_freq = true;
+      pkt.freq = double( int64_t( get64( p ) ) ) / RADIX;
+    } else if ( CIF_RATE == field.bit ) {
+      pkt.has_rate = true;
+      pkt.rate = double( int64_t( get64( p ) ) ) / RADIX;
+    }
+
+    p += field.words * 4;
+  }
+
+  return true;
+}
@@ -0,0 +1,99 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_VITA49_H
+#define OSMOSDR_VITA49_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gnuradio/gr_complex.h>
+
+#include <osmosdr/api.h>
+
+/*!
+ * The subset of VITA-49.0 spoken by vita49_sink and the vita49 source:
+ * IF data packets with a stream ID, a UTC integer and a real time
+ * (picosecond) fractional timestamp and a big endian cs8 or cs16 payload,
+ * and IF context packets with the RF reference frequency, the sample rate
+ * and, as the only extension, the payload format in the class ID.
+ */
+
+#define VITA49_HEADER_BYTES 20      // header, stream ID, timestamps
+#define VITA49_CONTEXT_BYTES 48     // with class ID, frequency and rate
+#define VITA49_MAX_PACKET 65507     // what fits in an UDP datagram
+
+enum vita49_format_t { VITA49_CS8 = 8, VITA49_CS16 = 16 };
+
+struct vita49_packet_t
+{
+  bool context;                 // else IF data
+  uint32_t stream_id;
+  unsigned count;               // modulo 16
+  uint64_t secs;                // UTC
+  uint64_t ps;                  // picoseconds of the second
+
+  /* IF data */
+  const uint8_t *payload;
+  size_t payload_bytes;
+
+  /* IF context, valid when has_* is set */
+  bool has_format;
+  vita49_format_t format;
+  bool has_freq;
+  double freq;
+  bool has_rate;
+  double rate;
+};
+
+/*! bytes per sample of \p format */
+inline size_t vita49_sample_bytes( vita49_format_t format )
+{
+  return format / 4;
+}
+
+/*!
+ * Write the header of an IF data packet with \p payload_bytes following
+ * it to \p buf. Returns the size of the whole packet.
+ */
+OSMOSDR_API size_t vita49_data_header( uint8_t *buf, uint32_t stream_id,
+                                       unsigned count, uint64_t secs, uint64_t ps,
+                                       size_t payload_bytes );
+
+/*! Write an IF context packet to \p buf, returns its size. */
+OSMOSDR_API size_t vita49_context( uint8_t *buf, uint32_t stream_id,
+                                   unsigned count, uint64_t secs, uint64_t ps,
+                                   vita49_format_t format,
+                                   double freq, double rate );
+
+/*!
+ * Requantize \p nitems samples to big endian \p format, scaled by
+ * \p scale and clipped to full scale, writing them to \p out.
+ */
+OSMOSDR_API void vita49_pack( const gr_complex *in, uint8_t *out, size_t nitems,
+                              vita49_format_t format, float scale );
+
+/*! The reverse of vita49_pack() with a \p scale of 1 */
+OSMOSDR_API void vita49_unpack( const uint8_t *in, gr_complex *out, size_t nitems,
+                                vita49_format_t format );
+
+/*! false if \p buf isn't a packet of the subset above */
+OSMOSDR_API bool vita49_parse( const uint8_t *buf, size_t len, vita49_packet_t &pkt );
+
+#endif // OSMOSDR_VITA49_H
@@ -0,0 +1,579 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#endif
+
+#include <boost/bind.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "arg_helpers.h"
+#include "stream_tagger.h"
+
+#include "vita49_source_c.h"
+
+#define RECV_BATCH_PACKETS 16     // per recvmmsg() call
+#define RECV_POLL_MS 100
+#define RING_MIN_SAMPLES (1 << 20)
+#define DEFAULT_PORT 4991
+
+vita49_source_c_sptr make_vita49_source_c(const std::string &args)
+{
+  return gnuradio::get_initial_sptr(new vita49_source_c(args));
+}
+
+vita49_source_c::vita49_source_c(const std::string &args) :
+  gr::sync_block("vita49_source_c",
+                 gr::io_signature::make(0, 0, 0),
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _has_stream_id(false),
+  _stream_id(0),
+  _format(VITA49_CS16),
+  _rate(0),
+  _freq(0),
+  _synced(false),
+  _next_count(0),
+  _next_secs(0),
+  _next_ps(0),
+  _retuned(true),
+  _read(0),
+  _running(false),
+  _samples(0),
+  _dropped(0),
+  _overruns(0)
+{
+  std::string group, iface;
+  unsigned short port = DEFAULT_PORT;
+  size_t ring_size = RING_MIN_SAMPLES;
+  int rcvbuf = 4 * 1024 * 1024;
+
+#if defined(_WIN32)
+  WSADATA wsaData;
+  WSAStartup( MAKEWORD(2, 2), &wsaData );
+#endif
+
+  dict_t dict = params_to_dict( args );
+
+  _ring.set_buffer_opts( buffer_opts_from_dict( dict ) );
+  _sched = thread_sched_from_dict( dict );
+
+  if ( dict.count( "vita49" ) )
+  {
+    std::vector< std::string > tokens;
+    boost::algorithm::split( tokens, dict["vita49"], boost::is_any_of( ":" ) );
+
+    group = tokens[0];
+
+    if ( tokens.size() == 2 && tokens[1].length() )
+      port = boost::lexical_cast< unsigned short >( tokens[1] );
+  }
+
+  if ( dict.count( "iface" ) )
+    iface = dict["iface"];
+
+  if ( dict.count( "stream_id" ) ) {
+    _stream_id = boost::lexical_cast< uint32_t >( dict["stream_id"] );
+    _has_stream_id = true;
+  }
+
+  /* until the first context packet tells otherwise */
+  if ( dict.count( "format" ) ) {
+    if ( "cs8" == dict["format"] )
+      _format = VITA49_CS8;
+    else if ( "cs16" == dict["format"] )
+      _format = VITA49_CS16;
+    else
+      throw std::runtime_error( "vita49: format must be cs8 or cs16" );
+  }
+
+  if ( dict.count( "rate" ) )
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  if ( dict.count( "ring_size" ) )
+    ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
+  if ( dict.count( "rcvbuf" ) )
+    rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
+  _ring.resize( std::max( ring_size, size_t(64 * 1024) ) );
+
+  if ( ( _socket = socket( AF_INET, SOCK_DGRAM, 0 ) ) < 0 )
+    throw std::runtime_error( "vita49: could not create an UDP socket." );
+
+  int on = 1;
+  setsockopt( _socket, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on) );
+  setsockopt( _socket, SOL_SOCKET, SO_RCVBUF, (const char *)&rcvbuf, sizeof(rcvbuf) );
+
+  struct in_addr group_addr;
+  group_addr.s_addr = htonl( INADDR_ANY );
+  if ( group.length() && inet_pton( AF_INET, group.c_str(), &group_addr ) != 1 )
+    throw std::runtime_error( "vita49: " + group + " is not an IPv4 address." );
+
+  const bool multicast = IN_MULTICAST( ntohl( group_addr.s_addr ) );
+
+  /* bind to the group itself, so other groups on the port stay out */
+  struct sockaddr_in addr;
+  memset( &addr, 0, sizeof(addr) );
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons( port );
+  addr.sin_addr = group_addr;
+#if defined(_WIN32)
+  if ( multicast )
+    addr.sin_addr.s_addr = htonl( INADDR_ANY );
+#endif
+
+  if ( ::bind( _socket, (struct sockaddr *)&addr, sizeof(addr) ) < 0 )
+    throw std::runtime_error( "vita49: could not bind to port " +
+                              std::to_string( port ) + "." );
+
+  if ( multicast )
+  {
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr = group_addr;
+    mreq.imr_interface.s_addr = htonl( INADDR_ANY );
+
+    if ( iface.length() && inet_pton( AF_INET, iface.c_str(), &mreq.imr_interface ) != 1 )
+      throw std::runtime_error( "vita49: " + iface + " is not an IPv4 address." );
+
+    if ( setsockopt( _socket, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                     (const char *)&mreq, sizeof(mreq) ) < 0 )
+      throw std::runtime_error( "vita49: could not join " + group + "." );
+  }
+}
+
+vita49_source_c::~vita49_source_c()
+{
+  stop();
+
+#if defined(_WIN32)
+  ::closesocket( _socket );
+  WSACleanup();
+#else
+  ::close( _socket );
+#endif
+}
+
+bool vita49_source_c::start()
+{
+  if ( _running )
+    return true;
+
+  _ring.reset();
+  _read = 0;
+  _events.clear();
+  _synced = false;
+  _retuned = true;
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &vita49_source_c::reader_task, this ) );
+
+  return true;
+}
+
+bool vita49_source_c::stop()
+{
+  _running = false;
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+void vita49_source_c::handle_packet( const uint8_t *buf, size_t len )
+{
+  vita49_packet_t pkt;
+
+  if ( ! vita49_parse( buf, len, pkt ) )
+    return;
+
+  if ( _has_stream_id && pkt.stream_id != _stream_id )
+    return;
+
+  if ( pkt.context )
+  {
+    if ( pkt.has_format )
+      _format = pkt.format;
+
+    if ( pkt.has_rate && pkt.rate != _rate ) {
+      _rate = pkt.rate;
+      _retuned = true;
+    }
+
+    if ( pkt.has_freq && pkt.freq != _freq ) {
+      _freq = pkt.freq;
+      _retuned = true;
+    }
+
+    return;
+  }
+
+  const size_t bytes = vita49_sample_bytes( _format );
+  const size_t n = pkt.payload_bytes / bytes;
+
+  if ( ! n )
+    return;
+
+  bool timed = ! _synced || _retuned;
+
+  if ( _synced && pkt.count != _next_count )
+  {
+    /* the timestamps tell how much went missing, the count only that
+     * something did */
+    double gap = ( double(pkt.secs) - double(_next_secs) ) +
+                 ( double(pkt.ps) - double(_next_ps) ) * 1e-12;
+    if ( gap > 0 && _rate > 0 )
+      _dropped += uint64_t( std::llround( gap * _rate ) );
+
+    _overruns++;
+    timed = true;
+    std::cerr << "O" << std::flush;
+  }
+
+  if ( _ring.space() < n )
+  {
+    _dropped += n;
+    _overruns++;
+    _synced = false;
+    std::cerr << "O" << std::flush;
+    return;
+  }
+
+  if ( timed )
+  {
+    event_t ev;
+    ev.pos = _ring.write_count();
+    ev.timed = true;
+    ev.secs = pkt.secs;
+    ev.ps = pkt.ps;
+    ev.retuned = _retuned || ! _synced;
+    ev.rate = _rate;
+    ev.freq = _freq;
+
+    std::lock_guard<std::mutex> lock( _events_mutex );
+    _events.push_back( ev );
+  }
+
+  /* the free space may wrap around the end of the ring */
+  for ( size_t done = 0; done < n; )
+  {
+    size_t count;
+    gr_complex *out = _ring.write_ptr( count );
+    count = std::min( count, n - done );
+
+    vita49_unpack( pkt.payload + done * bytes, out, count, _format );
+    _ring.commit( count );
+    done += count;
+  }
+
+  _samples += n;
+  _synced = true;
+  _retuned = false;
+  _next_count = ( pkt.count + 1 ) & 0xf;
+
+  if ( _rate > 0 )
+  {
+    uint64_t ps = pkt.ps + uint64_t( std::llround( n * 1e12 / _rate ) );
+    _next_secs = pkt.secs + ps / 1000000000000ULL;
+    _next_ps = ps % 1000000000000ULL;
+  }
+}
+
+/* take the datagrams off the socket as they come, so the kernel buffer
+ * only has to cover the scheduling latency of this thread */
+void vita49_source_c::reader_task()
+{
+  thread_sched_apply( _sched );
+
+#if defined(__linux__)
+  std::vector< uint8_t > bufs( RECV_BATCH_PACKETS * VITA49_MAX_PACKET );
+  struct mmsghdr msgs[RECV_BATCH_PACKETS];
+  struct iovec iovs[RECV_BATCH_PACKETS];
+
+  for ( size_t i = 0; i < RECV_BATCH_PACKETS; i++ ) {
+    iovs[i].iov_base = &bufs[i * VITA49_MAX_PACKET];
+    iovs[i].iov_len = VITA49_MAX_PACKET;
+    memset( &msgs[i], 0, sizeof(msgs[i]) );
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+#else
+  std::vector< uint8_t > buf( VITA49_MAX_PACKET );
+#endif
+
+  while ( _running )
+  {
+#if defined(_WIN32)
+    fd_set fds;
+    FD_ZERO( &fds );
+    FD_SET( _socket, &fds );
+    struct timeval tv = { 0, RECV_POLL_MS * 1000 };
+    int ready = select( int(_socket) + 1, &fds, NULL, NULL, &tv );
+#else
+    struct pollfd pfd = { _socket, POLLIN, 0 };
+    int ready = poll( &pfd, 1, RECV_POLL_MS );
+#endif
+
+    if ( ready == 0 )
+      continue;
+
+    if ( ready < 0 ) {
+      if ( EINTR == errno )
+        continue;
+      std::cerr << "vita49: waiting for packets failed." << std::endl;
+      break;
+    }
+
+#if defined(__linux__)
+    int got = recvmmsg( _socket, msgs, RECV_BATCH_PACKETS, MSG_DONTWAIT, NULL );
+
+    if ( got < 0 ) {
+      if ( EINTR == errno || EAGAIN == errno || EWOULDBLOCK == errno )
+        continue;
+      std::cerr << "vita49: receiving packets failed: " << strerror( errno ) << std::endl;
+      break;
+    }
+
+    for ( int i = 0; i < got; i++ )
+      handle_packet( &bufs[i * VITA49_MAX_PACKET], msgs[i].msg_len );
+#else
+    int len = ::recv( _socket, (char *)&buf[0], int(buf.size()), 0 );
+
+    if ( len < 0 ) {
+      if ( EINTR == errno )
+        continue;
+      std::cerr << "vita49: receiving packets failed." << std::endl;
+      break;
+    }
+
+    handle_packet( &buf[0], size_t(len) );
+#endif
+  }
+
+  _running = false;
+
+  /* release work() if it is waiting for samples */
+  _ring.close();
+}
+
+/* rx_time at the first sample and after every gap, rx_rate and rx_freq
+ * along with it when the context changed */
+void vita49_source_c::add_tags( int noutput_items )
+{
+  std::lock_guard<std::mutex> lock( _events_mutex );
+
+  while ( ! _events.empty() && _events.front().pos < _read + noutput_items )
+  {
+    const event_t &ev = _events.front();
+    const uint64_t offset = nitems_written(0) + ( ev.pos > _read ? ev.pos - _read : 0 );
+
+    add_item_tag( 0, offset, stream_tagger::TIME_KEY(),
+                  pmt::make_tuple( pmt::from_uint64( ev.secs ),
+                                   pmt::from_double( ev.ps * 1e-12 ) ),
+                  alias_pmt() );
+
+    if ( ev.retuned ) {
+      if ( ev.rate > 0 )
+        add_item_tag( 0, offset, stream_tagger::RATE_KEY(),
+                      pmt::from_double( ev.rate ), alias_pmt() );
+      add_item_tag( 0, offset, stream_tagger::FREQ_KEY(),
+                    pmt::from_double( ev.freq ), alias_pmt() );
+    }
+
+    _events.pop_front();
+  }
+}
+
+int vita49_source_c::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  while ( ! _ring.wait_for( 1, std::chrono::milliseconds(RECV_POLL_MS) ) )
+    if ( ! _running || _ring.closed() )
+      return WORK_DONE;
+
+  size_t nitems = std::min( size_t(noutput_items), _ring.size() );
+  if ( ! nitems )
+    return WORK_DONE;
+
+  add_tags( nitems );
+
+  _ring.pop( out, nitems );
+  _read += nitems;
+
+  return nitems;
+}
+
+std::string vita49_source_c::name()
+{
+  return "VITA-49 Source";
+}
+
+std::vector<std::string> vita49_source_c::get_devices( bool fake )
+{
+  std::vector<std::string> devices;
+
+  if ( fake )
+  {
+    std::string args = "vita49=239.0.0.1:4991";
+    args += ",label='VITA-49 Stream'";
+    devices.push_back( args );
+  }
+
+  return devices;
+}
+
+size_t vita49_source_c::get_num_channels( void )
+{
+  return 1;
+}
+
+/* the sender owns rate and frequency, the setters only report them */
+osmosdr::meta_range_t vita49_source_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  range.push_back( osmosdr::range_t( get_sample_rate() ) );
+
+  return range;
+}
+
+double vita49_source_c::set_sample_rate( double rate )
+{
+  if ( 0 == _rate )
+    _rate = rate;
+
+  return get_sample_rate();
+}
+
+double vita49_source_c::get_sample_rate( void )
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t vita49_source_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( get_center_freq( chan ), get_center_freq( chan ) );
+}
+
+double vita49_source_c::set_center_freq( double freq, size_t chan )
+{
+  return get_center_freq( chan );
+}
+
+double vita49_source_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double vita49_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double vita49_source_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> vita49_source_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t vita49_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t vita49_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double vita49_source_c::set_gain( double gain, size_t chan )
+{
+  return get_gain( chan );
+}
+
+double vita49_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double vita49_source_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double vita49_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > vita49_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+std::string vita49_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string vita49_source_c::get_antenna( size_t chan )
+{
+  return "";
+}
+
+osmosdr::stream_stats_t vita49_source_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats;
+
+  stats.samples = _samples;
+  stats.dropped = _dropped;
+  stats.overruns = _overruns;
+  stats.fill = _ring.size();
+  stats.fill_max = _ring.fill_max();
+  stats.capacity = _ring.capacity();
+
+  return stats;
+}
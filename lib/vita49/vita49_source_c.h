@@ -0,0 +1,149 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef VITA49_SOURCE_C_H
+#define VITA49_SOURCE_C_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#endif
+
+#include "source_iface.h"
+#include "spsc_ring.h"
+#include "thread_sched.h"
+#include "vita49.h"
+
+class vita49_source_c;
+
+typedef std::shared_ptr< vita49_source_c > vita49_source_c_sptr;
+
+vita49_source_c_sptr make_vita49_source_c( const std::string & args = "" );
+
+/*!
+ * Receives the VITA-49 streams of osmosdr::vita49_sink, or any sender of
+ * the same subset, from an UDP port or a multicast group.
+ *
+ * A thread of its own takes the packets off the socket, with recvmmsg()
+ * on Linux, and unpacks them into a ring. The context packets tell the
+ * sample rate, frequency and format, which show up as rx_rate and rx_freq
+ * tags. rx_time tags come from the packet timestamps, at the start and
+ * after every lost packet, which the packet count tells.
+ */
+class vita49_source_c :
+    public gr::sync_block,
+    public source_iface
+{
+private:
+  friend vita49_source_c_sptr make_vita49_source_c(const std::string &args);
+
+  vita49_source_c(const std::string &args);
+
+public:
+  ~vita49_source_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  std::string name();
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+private:
+  struct event_t
+  {
+    uint64_t pos;                   // ring position
+    bool timed;
+    uint64_t secs, ps;
+    bool retuned;                   // rate or frequency changed
+    double rate, freq;
+  };
+
+  void reader_task();
+  void handle_packet( const uint8_t *buf, size_t len );
+  void add_tags( int noutput_items );
+
+#if defined(_WIN32)
+  SOCKET _socket;
+#else
+  int _socket;
+#endif
+
+  bool _has_stream_id;
+  uint32_t _stream_id;              // the only one taken, stream_id=
+  vita49_format_t _format;
+  std::atomic< double > _rate;
+  std::atomic< double > _freq;
+
+  bool _synced;                     // got a packet since start()
+  unsigned _next_count;
+  uint64_t _next_secs, _next_ps;    // expected timestamp of the next packet
+  bool _retuned;
+
+  spsc_ring< gr_complex > _ring;
+  uint64_t _read;                   // samples taken out of the ring
+  std::mutex _events_mutex;
+  std::deque< event_t > _events;
+
+  gr::thread::thread _thread;
+  thread_sched_t _sched;
+  std::atomic< bool > _running;
+
+  std::atomic< uint64_t > _samples;
+  std::atomic< uint64_t > _dropped;
+  std::atomic< uint64_t > _overruns;
+};
+
+#endif // VITA49_SOURCE_C_H
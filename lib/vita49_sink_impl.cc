@@ -0,0 +1,380 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#endif
+
+#include <gnuradio/io_signature.h>
+
+#include "stream_tagger.h"
+#include "vita49_sink_impl.h"
+
+#define BATCH_PACKETS 32        // per sendmmsg() call
+#define CONTEXT_INTERVAL 1.0    // seconds between the context packets
+
+osmosdr::vita49_sink::sptr
+osmosdr::vita49_sink::make( const std::string &address, int port, double sample_rate,
+                            const std::string &format, double freq,
+                            uint32_t stream_id, double scale,
+                            size_t packet_bytes, int ttl )
+{
+  return gnuradio::get_initial_sptr(
+        new vita49_sink_impl( address, port, sample_rate, format, freq,
+                              stream_id, scale, packet_bytes, ttl ) );
+}
+
+vita49_sink_impl::vita49_sink_impl( const std::string &address, int port, double sample_rate,
+                                    const std::string &format, double freq,
+                                    uint32_t stream_id, double scale,
+                                    size_t packet_bytes, int ttl )
+  : gr::sync_block( "vita49_sink",
+        gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+        gr::io_signature::make( 0, 0, 0 ) ),
+    _stream_id(stream_id), _packet_bytes(packet_bytes),
+    _rate(sample_rate), _freq(freq), _scale(float(scale)),
+    _sent_rate(0), _sent_freq(0), _context_due(true), _next_context(0),
+    _anchored(false), _t0_offset(0), _t0_rate(sample_rate),
+    _queued(0), _fill(0), _offset(0), _pkt_offset(0),
+    _count(0), _ctx_count(0), _warned(false), _packets(0)
+{
+  if ( "cs8" == format )
+    _format = VITA49_CS8;
+  else if ( "cs16" == format )
+    _format = VITA49_CS16;
+  else
+    throw std::runtime_error( "vita49_sink supports the cs8 and cs16 formats." );
+
+  if ( sample_rate <= 0 )
+    throw std::runtime_error( "vita49_sink needs a positive sample rate." );
+
+  if ( _packet_bytes > VITA49_MAX_PACKET ||
+       _packet_bytes < VITA49_HEADER_BYTES + 16 )
+    throw std::runtime_error( "vita49_sink packet size out of range." );
+
+  /* whole 32 bit words of payload */
+  _spp = ( _packet_bytes - VITA49_HEADER_BYTES ) / vita49_sample_bytes( _format );
+  _spp -= _spp % 2;
+
+  _bufs.resize( BATCH_PACKETS * _packet_bytes );
+  _lens.resize( BATCH_PACKETS );
+
+#if defined(_WIN32)
+  WSADATA wsaData;
+  WSAStartup( MAKEWORD(2, 2), &wsaData );
+#endif
+
+  struct addrinfo hints, *res = NULL;
+  memset( &hints, 0, sizeof(hints) );
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  if ( getaddrinfo( address.c_str(), NULL, &hints, &res ) != 0 || ! res )
+    throw std::runtime_error( "vita49_sink could not resolve " + address + "." );
+
+  memcpy( &_addr, res->ai_addr, sizeof(_addr) );
+  _addr.sin_port = htons( (unsigned short)port );
+  freeaddrinfo( res );
+
+  if ( ( _socket = socket( AF_INET, SOCK_DGRAM, 0 ) ) < 0 )
+    throw std::runtime_error( "vita49_sink could not create an UDP socket." );
+
+  if ( IN_MULTICAST( ntohl( _addr.sin_addr.s_addr ) ) ) {
+    unsigned char hops = (unsigned char)std::max( 0, std::min( 255, ttl ) );
+    setsockopt( _socket, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&hops, sizeof(hops) );
+  }
+
+  /* room for a few batches in the kernel */
+  int sndbuf = int( 4 * BATCH_PACKETS * _packet_bytes );
+  setsockopt( _socket, SOL_SOCKET, SO_SNDBUF, (const char *)&sndbuf, sizeof(sndbuf) );
+}
+
+vita49_sink_impl::~vita49_sink_impl()
+{
+#if defined(_WIN32)
+  ::closesocket( _socket );
+  WSACleanup();
+#else
+  ::close( _socket );
+#endif
+}
+
+void vita49_sink_impl::set_sample_rate( double rate )
+{
+  if ( rate > 0 )
+    _rate = rate;
+}
+
+void vita49_sink_impl::set_center_freq( double freq )
+{
+  _freq = freq;
+}
+
+void vita49_sink_impl::set_scale( double scale )
+{
+  _scale = float(scale);
+}
+
+uint64_t vita49_sink_impl::get_packets()
+{
+  return _packets;
+}
+
+bool vita49_sink_impl::start()
+{
+  _anchored = false;
+  _context_due = true;
+  _queued = 0;
+  _fill = 0;
+
+  return true;
+}
+
+/* what was started goes out, padded to the end of the packet */
+bool vita49_sink_impl::stop()
+{
+  finish_packet();
+  flush();
+
+  return true;
+}
+
+void vita49_sink_impl::anchor( uint64_t offset, const osmosdr::time_spec_t &time )
+{
+  _t0 = time;
+  _t0_offset = offset;
+  _t0_rate = _rate;
+  _anchored = true;
+}
+
+void vita49_sink_impl::timestamp( uint64_t offset, uint64_t &secs, uint64_t &ps )
+{
+  osmosdr::time_spec_t time = _t0;
+  time += osmosdr::time_spec_t::from_ticks( (long long)( offset - _t0_offset ), _t0_rate );
+
+  secs = uint64_t( time.get_full_secs() );
+  ps = std::min( uint64_t( std::llround( time.get_frac_secs() * 1e12 ) ),
+                 uint64_t( 999999999999ULL ) );
+}
+
+void vita49_sink_impl::queue_context( uint64_t offset )
+{
+  if ( _queued == BATCH_PACKETS )
+    flush();
+
+  uint64_t secs, ps;
+  timestamp( offset, secs, ps );
+
+  _sent_rate = _t0_rate;
+  _sent_freq = _freq;
+
+  _lens[ _queued ] = vita49_context( slot( _queued ), _stream_id, _ctx_count++,
+                                     secs, ps, _format, _sent_freq, _sent_rate );
+  _queued++;
+
+  _context_due = false;
+  _next_context = offset + uint64_t( CONTEXT_INTERVAL * _sent_rate );
+}
+
+void vita49_sink_impl::fill( const gr_complex *in, size_t nitems )
+{
+  const size_t sample_bytes = vita49_sample_bytes( _format );
+  const float scale = _scale;
+
+  while ( nitems ) {
+    if ( 0 == _fill ) {
+      if ( _context_due || _offset >= _next_context || _freq != _sent_freq )
+        queue_context( _offset );
+
+      if ( _queued == BATCH_PACKETS )
+        flush();
+
+      _pkt_offset = _offset;
+    }
+
+    size_t count = std::min( nitems, _spp - _fill );
+    vita49_pack( in, slot( _queued ) + VITA49_HEADER_BYTES + _fill * sample_bytes,
+                 count, _format, scale );
+
+    in += count;
+    nitems -= count;
+    _fill += count;
+    _offset += count;
+
+    if ( _fill == _spp )
+      finish_packet();
+  }
+}
+
+void vita49_sink_impl::finish_packet()
+{
+  if ( ! _fill )
+    return;
+
+  const size_t sample_bytes = vita49_sample_bytes( _format );
+
+  /* cs8 payloads of an odd number of samples get a silent one added */
+  size_t payload = _fill * sample_bytes;
+  if ( payload % 4 ) {
+    memset( slot( _queued ) + VITA49_HEADER_BYTES + payload, 0, 4 - payload % 4 );
+    payload += 4 - payload % 4;
+  }
+
+  uint64_t secs, ps;
+  timestamp( _pkt_offset, secs, ps );
+
+  _lens[ _queued ] = vita49_data_header( slot( _queued ), _stream_id, _count++,
+                                         secs, ps, payload );
+  _queued++;
+  _fill = 0;
+}
+
+void vita49_sink_impl::flush()
+{
+  size_t sent = 0;
+
+#if defined(__linux__)
+  struct mmsghdr msgs[ BATCH_PACKETS ];
+  struct iovec iovs[ BATCH_PACKETS ];
+
+  memset( msgs, 0, sizeof(msgs) );
+  for (size_t i = 0; i < _queued; i++) {
+    iovs[i].iov_base = slot( i );
+    iovs[i].iov_len = _lens[i];
+    msgs[i].msg_hdr.msg_name = &_addr;
+    msgs[i].msg_hdr.msg_namelen = sizeof(_addr);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  while ( sent < _queued ) {
+    int ret = sendmmsg( _socket, msgs + sent, unsigned( _queued - sent ), 0 );
+    if ( ret < 0 ) {
+      if ( EINTR == errno )
+        continue;
+      break;
+    }
+    sent += size_t( ret );
+  }
+#else
+  for (; sent < _queued; sent++)
+    if ( sendto( _socket, (const char *)slot( sent ), int( _lens[sent] ), 0,
+                 (const struct sockaddr *)&_addr, sizeof(_addr) ) < 0 )
+      break;
+#endif
+
+  if ( sent < _queued && ! _warned ) {
+    std::cerr << "vita49_sink: sending failed (" << strerror( errno )
+              << "), packets are dropped." << std::endl;
+    _warned = true;
+  }
+
+  for (size_t i = 0; i < sent; i++)
+    if ( ( slot( i )[0] >> 4 ) == 0x1 )      // IF data
+      _packets++;
+
+  /* the packet being built moves to the front */
+  if ( _fill && _queued )
+    memcpy( slot( 0 ) + VITA49_HEADER_BYTES, slot( _queued ) + VITA49_HEADER_BYTES,
+            _fill * vita49_sample_bytes( _format ) );
+
+  _queued = 0;
+}
+
+int vita49_sink_impl::work( int noutput_items,
+                            gr_vector_const_void_star &input_items,
+                            gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+
+  _offset = nitems_read(0);
+
+  if ( ! _anchored )
+    anchor( _offset, osmosdr::time_spec_t::get_system_time() );
+
+  /* a rate set from outside starts a new timeline where the stream is */
+  if ( _rate != _t0_rate ) {
+    finish_packet();
+    osmosdr::time_spec_t now = _t0;
+    now += osmosdr::time_spec_t::from_ticks( (long long)( _offset - _t0_offset ), _t0_rate );
+    anchor( _offset, now );
+    _context_due = true;
+  }
+
+  get_tags_in_window( _tags, 0, 0, noutput_items );
+  std::sort( _tags.begin(), _tags.end(), gr::tag_t::offset_compare );
+
+  int pos = 0;
+  for (const gr::tag_t &tag : _tags) {
+    const bool time = pmt::eq( tag.key, stream_tagger::TIME_KEY() );
+    const bool rate = pmt::eq( tag.key, stream_tagger::RATE_KEY() );
+    const bool freq = pmt::eq( tag.key, stream_tagger::FREQ_KEY() );
+
+    if ( ! time && ! rate && ! freq )
+      continue;
+
+    const int idx = int( tag.offset - nitems_read(0) );
+    fill( in + pos, size_t( idx - pos ) );
+    pos = idx;
+
+    /* a packet covers samples of one timeline only */
+    if ( time || rate )
+      finish_packet();
+
+    if ( time ) {
+      anchor( tag.offset, osmosdr::time_spec_t(
+                time_t( pmt::to_uint64( pmt::tuple_ref( tag.value, 0 ) ) ),
+                pmt::to_double( pmt::tuple_ref( tag.value, 1 ) ) ) );
+      _context_due = true;
+    } else if ( rate ) {
+      osmosdr::time_spec_t now = _t0;
+      now += osmosdr::time_spec_t::from_ticks( (long long)( tag.offset - _t0_offset ), _t0_rate );
+      _rate = pmt::to_double( tag.value );
+      anchor( tag.offset, now );
+      _context_due = true;
+    } else {
+      _freq = pmt::to_double( tag.value );
+    }
+  }
+
+  fill( in + pos, size_t( noutput_items - pos ) );
+
+  /* the partial packet waits for more samples, the full ones go out */
+  flush();
+
+  return noutput_items;
+}
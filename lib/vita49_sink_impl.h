@@ -0,0 +1,106 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_VITA49_SINK_IMPL_H
+#define INCLUDED_OSMOSDR_VITA49_SINK_IMPL_H
+
+#include <atomic>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#include <osmosdr/vita49_sink.h>
+#include <osmosdr/time_spec.h>
+
+#include "vita49.h"
+
+class vita49_sink_impl : public osmosdr::vita49_sink
+{
+public:
+  vita49_sink_impl( const std::string &address, int port, double sample_rate,
+                    const std::string &format, double freq, uint32_t stream_id,
+                    double scale, size_t packet_bytes, int ttl );
+  ~vita49_sink_impl();
+
+  void set_sample_rate( double rate );
+  void set_center_freq( double freq );
+  void set_scale( double scale );
+  uint64_t get_packets( void );
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  void fill( const gr_complex *in, size_t nitems );
+  void finish_packet();
+  void queue_context( uint64_t offset );
+  void flush();
+
+  void anchor( uint64_t offset, const osmosdr::time_spec_t &time );
+  void timestamp( uint64_t offset, uint64_t &secs, uint64_t &ps );
+  uint8_t *slot( size_t index ) { return &_bufs[ index * _packet_bytes ]; }
+
+#if defined(_WIN32)
+  SOCKET _socket;
+#else
+  int _socket;
+#endif
+  sockaddr_in _addr;
+
+  vita49_format_t _format;
+  uint32_t _stream_id;
+  size_t _packet_bytes;
+  size_t _spp;                      // samples per data packet
+
+  std::atomic< double > _rate;
+  std::atomic< double > _freq;
+  std::atomic< float > _scale;
+  double _sent_rate;                // in the last context packet
+  double _sent_freq;
+  bool _context_due;
+  uint64_t _next_context;           // offset of the periodic one
+
+  bool _anchored;
+  osmosdr::time_spec_t _t0;         // time of the sample at _t0_offset
+  uint64_t _t0_offset;
+  double _t0_rate;
+
+  std::vector< uint8_t > _bufs;     // a batch of packets
+  std::vector< size_t > _lens;
+  size_t _queued;                   // packets in the batch
+  size_t _fill;                     // samples in the data packet being built
+  uint64_t _offset;                 // of the next sample
+  uint64_t _pkt_offset;             // first sample of the data packet
+  unsigned _count;                  // of the data packets, modulo 16
+  unsigned _ctx_count;
+  bool _warned;
+
+  std::vector< gr::tag_t > _tags;
+  std::atomic< uint64_t > _packets;
+};
+
+#endif // INCLUDED_OSMOSDR_VITA49_SINK_IMPL_H
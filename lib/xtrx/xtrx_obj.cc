@@ -18,6 +18,7 @@
  * Boston, MA 02110-1301, USA.
  */
 #include "xtrx_obj.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <boost/thread.hpp>
@@ -136,3 +137,13 @@ xtrx_obj::~xtrx_obj()
     xtrx_close(_obj);
   }
 }
+
+unsigned xtrx_obj::packet_samples(double rate, double latency, unsigned max)
+{
+  unsigned samples = XTRX_MIN_PACKET;
+
+  while (samples < max && 2.0 * samples <= rate * latency)
+    samples *= 2;
+
+  return std::min(samples, max);
+}
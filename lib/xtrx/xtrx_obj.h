@@ -26,6 +26,9 @@
 #include <vector>
 #include <boost/thread/mutex.hpp>
 
+#define XTRX_MIN_PACKET 512           // samples
+#define XTRX_DEFAULT_LATENCY 0.001    // seconds of samples per packet, latency=
+
 class xtrx_obj;
 
 typedef std::shared_ptr<xtrx_obj> xtrx_obj_sptr;
@@ -50,6 +53,10 @@ public:
 
   void set_vio(unsigned vio) { _vio = vio; }
 
+  /*! samples per DMA packet holding \p latency seconds at \p rate, a power
+   * of two from XTRX_MIN_PACKET up to \p max */
+  static unsigned packet_samples(double rate, double latency, unsigned max);
+
   boost::mutex mtx;
 protected:
   xtrx_dev* _obj;
@@ -17,6 +17,7 @@
  * the Free Software Foundation, Inc., 51 Franklin Street,
  * Boston, MA 02110-1301, USA.
  */
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -36,7 +37,7 @@
 
 #include "arg_helpers.h"
 
-static const int max_burstsz = 4096;
+#define TX_MAX_PACKET 4096   // samples
 using namespace boost::assign;
 
 xtrx_sink_c_sptr make_xtrx_sink_c(const std::string &args)
@@ -75,9 +76,11 @@ xtrx_sink_c::xtrx_sink_c(const std::string &args) :
   _auto_gain(false),
   _otw(XTRX_WF_16),
   _mimo_mode(false),
+  _latency(XTRX_DEFAULT_LATENCY),
   _gain_tx(0),
   _channels(parse_nchan(args)),
   _ts(8192),
+  _start_pending(false),
   _swap_ab(false),
   _swap_iq(false),
   _tdd(false),
@@ -107,6 +110,10 @@ xtrx_sink_c::xtrx_sink_c(const std::string &args) :
 	_ts += 8192 * boost::lexical_cast< int >( dict["txdelay"] );
   }
 
+  if (dict.count("latency")) {
+    _latency = boost::lexical_cast< double >( dict["latency"] ) / 1000.0;
+  }
+
   if (dict.count("allowdis")) {
 	_allow_dis = boost::lexical_cast< bool >( dict["allowdis"] );
   }
@@ -153,9 +160,13 @@ xtrx_sink_c::xtrx_sink_c(const std::string &args) :
     xtrx_set_ref_clk(_xtrx->dev(), boost::lexical_cast< unsigned >( dict["extclk"] ), XTRX_CLKSRC_EXT);
   }
 
+  _ts_lead = _ts;
+  _pacer.init(tx_policy_from_dict(dict), _channels);
+
   std::cerr << "xtrx_sink_c::xtrx_sink_c()" << std::endl;
+  /* no output multiple, a short burst ending in tx_eob must not wait for
+   * more samples. libxtrx collects the rest into packets of latency= */
   set_alignment(32);
-  set_output_multiple(max_burstsz);
 }
 
 xtrx_sink_c::~xtrx_sink_c()
@@ -429,15 +440,78 @@ int xtrx_sink_c::work (int noutput_items,
 {
   int ninput_items = noutput_items;
   const uint64_t samp0_count = nitems_read(0);
-  get_tags_in_range(_tags, 0, samp0_count, samp0_count + ninput_items);
-  if (!_tags.empty())
-    tag_process(ninput_items);
 
+  /* the timestamps count samples since xtrx_run_ex(), the common start is
+   * put on them by the host clock */
+  if (_start_pending) {
+    ::osmosdr::time_spec_t now = ::osmosdr::time_spec_t::get_system_time();
+    double lead = (_timed_start->get(now) - _run_time).get_real_secs();
+
+    if (lead > 0)
+      _ts = std::max(_ts, uint64_t(lead * _rate));
+
+    _start_pending = false;
+  }
+
+  if (_pacer.starved())
+    handle_underrun();
+
+  if (_pacer.prefill(input_items, noutput_items)) {
+    get_tags_in_range(_tags, 0, samp0_count, samp0_count + ninput_items);
+    if (!_tags.empty())
+      std::cerr << "xtrx_sink_c: tags within the prefill are ignored" << std::endl;
+
+    if (_pacer.held()) {
+      send(_pacer.held_items(), _pacer.held());
+      _pacer.consume_held(_pacer.held());
+    }
+  } else {
+    int nitems = apply_tune_tags(noutput_items);
+    /* what is in front of a retune has to be out before it */
+    bool flush = nitems < noutput_items;
+
+    noutput_items = nitems;
+
+    /* a burst ends at its tx_eob, what comes after goes out next time */
+    get_tags_in_range(_tags, 0, samp0_count, samp0_count + noutput_items, EOB_KEY);
+    for (const gr::tag_t &tag : _tags) {
+      if (pmt::is_true(tag.value)) {
+        noutput_items = std::min(noutput_items, int(tag.offset - samp0_count) + 1);
+        flush = true;
+      }
+    }
+    ninput_items = noutput_items;
+
+    get_tags_in_range(_tags, 0, samp0_count, samp0_count + ninput_items);
+    if (!_tags.empty())
+      tag_process(ninput_items);
+
+    _pacer.throttle();
+    send(input_items, noutput_items, flush);
+
+    if (_pacer.policy().underrun == tx_policy_t::UNDERRUN_REPEAT) {
+      _last.resize(input_items.size());
+      for (unsigned i = 0; i < input_items.size(); i++) {
+        const gr_complex *in = (const gr_complex *)input_items[i];
+        _last[i].assign(in, in + noutput_items);
+      }
+    }
+  }
+
+  for (unsigned i = 0; i < input_items.size(); i++) {
+    consume(i, noutput_items);
+  }
+  return 0;
+}
+
+/* without flush libxtrx holds back what doesn't fill a packet */
+int xtrx_sink_c::send(const gr_vector_const_void_star &items, int nitems, bool flush)
+{
   xtrx_send_ex_info_t nfo;
-  nfo.samples = noutput_items;
-  nfo.buffer_count = input_items.size();
-  nfo.buffers = &input_items[0];
-  nfo.flags = XTRX_TX_DONT_BUFFER;
+  nfo.samples = nitems;
+  nfo.buffer_count = items.size();
+  nfo.buffers = &items[0];
+  nfo.flags = flush ? XTRX_TX_DONT_BUFFER : 0;
   if (!_allow_dis)
     nfo.flags |= XTRX_TX_NO_DISCARD;
   nfo.ts = _ts;
@@ -452,11 +526,64 @@ int xtrx_sink_c::work (int noutput_items,
     throw std::runtime_error( message.str() );
   }
 
-  _ts += noutput_items;
-  for (unsigned i = 0; i < input_items.size(); i++) {
-    consume(i, noutput_items);
+  _ts += nitems;
+  _pacer.written(nitems);
+  _stats.samples += nitems;
+
+  return nitems;
+}
+
+/* libxtrx tunes right away, so the samples in front of a tx_freq or
+ * tx_gain tag are sent on their own and given the time to go out first */
+int xtrx_sink_c::apply_tune_tags(int nitems)
+{
+  const uint64_t start = nitems_read(0);
+  std::vector<tx_tune_t> tunes(_channels);
+  bool tune = false;
+
+  for (unsigned i = 0; i < _channels; i++) {
+    get_tags_in_range(_tags, i, start, start + nitems);
+    nitems = tx_tune_from_tags(_tags, start, nitems, tunes[i]);
+    tune |= !tunes[i].empty();
+  }
+
+  if (!tune)
+    return nitems;
+
+  /* the timestamps put the samples _ts_lead behind the writes */
+  _pacer.drain();
+  if (_rate > 0)
+    boost::this_thread::sleep_for(boost::chrono::microseconds(int64_t(_ts_lead * 1e6 / _rate)));
+
+  for (unsigned i = 0; i < _channels; i++) {
+    if (tunes[i].has_freq)
+      set_center_freq(tunes[i].freq, i);
+    if (tunes[i].has_gain)
+      set_gain(tunes[i].gain, i);
+  }
+
+  return nitems;
+}
+
+/* The timestamps keep counting through an underrun, so with underrun=stop
+ * the next burst is put _ts_lead ahead of where the device is by now. */
+void xtrx_sink_c::handle_underrun()
+{
+  _stats.underruns++;
+  std::cerr << "U" << std::flush;
+
+  if (_pacer.policy().underrun == tx_policy_t::UNDERRUN_REPEAT && !_last.empty()) {
+    gr_vector_const_void_star items;
+    for (unsigned i = 0; i < _last.size(); i++)
+      items.push_back(&_last[i][0]);
+
+    send(items, _last[0].size());
+  } else if (_pacer.policy().underrun == tx_policy_t::UNDERRUN_STOP) {
+    ::osmosdr::time_spec_t now = ::osmosdr::time_spec_t::get_system_time();
+    uint64_t pos = uint64_t((now - _run_time).get_real_secs() * _rate);
+
+    _ts = std::max(_ts, pos + _ts_lead);
   }
-  return 0;
 }
 
 bool xtrx_sink_c::start()
@@ -479,7 +606,7 @@ bool xtrx_sink_c::start()
   params.tx.hfmt = XTRX_IQ_FLOAT32;
   params.tx.wfmt = _otw;
   params.tx.chs = XTRX_CH_AB;
-  params.tx.paketsize = 0;
+  params.tx.paketsize = xtrx_obj::packet_samples(_rate, _latency, TX_MAX_PACKET);
   params.rx_stream_start = 256*1024;
 
   int res = xtrx_run_ex(_xtrx->dev(), &params);
@@ -487,6 +614,11 @@ bool xtrx_sink_c::start()
     std::cerr << "Got error: " << res << std::endl;
   }
 
+  _run_time = ::osmosdr::time_spec_t::get_system_time();
+  _start_pending = static_cast<bool>(_timed_start);
+  _last.clear();
+  _pacer.start(_rate);
+
   return res == 0;
 }
 
@@ -496,6 +628,9 @@ bool xtrx_sink_c::stop()
 
   //TODO:
   std::cerr << "xtrx_sink_c::stop()" << std::endl;
+  if (_timed_start)
+    _timed_start->reset();
+
   int res = xtrx_stop(_xtrx->dev(), XTRX_TX);
   if (res) {
     std::cerr << "Got error: " << res << std::endl;
@@ -503,3 +638,20 @@ bool xtrx_sink_c::stop()
 
   return res == 0;
 }
+
+bool xtrx_sink_c::set_timed_start( const timed_start_sptr &start )
+{
+  _timed_start = start;
+
+  return true;
+}
+
+osmosdr::stream_stats_t xtrx_sink_c::get_stream_stats( size_t chan )
+{
+  osmosdr::stream_stats_t stats = _stats;
+
+  stats.fill = _pacer.queued();
+  stats.capacity = _pacer.policy().latency_samples(_rate);
+
+  return stats;
+}
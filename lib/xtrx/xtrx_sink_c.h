@@ -25,6 +25,8 @@
 #include <gnuradio/sync_block.h>
 
 #include "sink_iface.h"
+#include "tx_policy.h"
+#include "tx_tune.h"
 #include "xtrx_obj.h"
 
 
@@ -93,6 +95,13 @@ public:
   bool stop();
 
   void tag_process(int ninput_items);
+  int send(const gr_vector_const_void_star &items, int nitems, bool flush = true);
+  void handle_underrun();
+  int apply_tune_tags(int nitems);
+
+  bool set_timed_start( const timed_start_sptr &start );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
 
 private:
   xtrx_obj_sptr _xtrx;
@@ -109,6 +118,7 @@ private:
 
   xtrx_wire_format_t _otw;
   bool _mimo_mode;
+  double _latency;                      // seconds per packet, latency=
 
   int _gain_tx;
 
@@ -117,6 +127,15 @@ private:
 
   uint64_t _ts;
 
+  timed_start_sptr _timed_start;
+  bool _start_pending;                  // _ts is still to be set from it
+  ::osmosdr::time_spec_t _run_time;     // host time xtrx_run_ex() returned
+  uint64_t _ts_lead;                    // samples the first _ts is ahead
+
+  tx_pacer _pacer;
+  std::vector< std::vector<gr_complex> > _last;   // for underrun=repeat
+  osmosdr::stream_stats_t _stats;
+
   bool     _swap_ab;
   bool     _swap_iq;
 
@@ -35,6 +35,8 @@
 #include "xtrx_source_c.h"
 
 #include "arg_helpers.h"
+#include "tick_time.h"
+#include "sample_convert.h"
 
 using namespace boost::assign;
 
@@ -74,6 +76,8 @@ xtrx_source_c::xtrx_source_c(const std::string &args) :
   _auto_gain(false),
   _otw(XTRX_WF_16),
   _mimo_mode(false),
+  _latency(XTRX_DEFAULT_LATENCY),
+  _max_packet(0),
   _gain_lna(0),
   _gain_tia(0),
   _gain_pga(0),
@@ -84,7 +88,12 @@ xtrx_source_c::xtrx_source_c(const std::string &args) :
   _tdd(false),
   _fbctrl(false),
   _timekey(false),
-  _dsp(0)
+  _retag(true),
+  _have_next(false),
+  _next_sample(0),
+  _tag_freq(0),
+  _dsp(0),
+  _lo(0)
 {
   _id = pmt::string_to_symbol(args);
 
@@ -157,8 +166,19 @@ xtrx_source_c::xtrx_source_c(const std::string &args) :
     std::cerr << "xtrx_source_c: XTRX device: %s" << _dev.c_str();
   }
 
+  pingpong_sweep_opts_t sweep;
+  if (pingpong_sweep_from_dict(dict, sweep)) {
+    _sweep.reset(new pingpong_sweep(sweep, [this](size_t chan, double freq) {
+      return tune_sweep(chan, freq);
+    }));
+  }
+
   _xtrx = xtrx_obj::get(_dev.c_str(), loglevel, lmsreset);
-  if (_xtrx->dev_count() * 2 == _channels) {
+  if (_sweep) {
+    if (_xtrx->dev_count() != 1 || _channels != 1)
+      throw std::runtime_error("sweep= takes a single XTRX with nchan=1, it uses both of its channels");
+    _mimo_mode = true;
+  } else if (_xtrx->dev_count() * 2 == _channels) {
     _mimo_mode = true;
   } else if (_xtrx->dev_count() != _channels) {
     throw std::runtime_error("Number of requested channels != number of devices");
@@ -186,23 +206,25 @@ xtrx_source_c::xtrx_source_c(const std::string &args) :
     xtrx_val_set(_xtrx->dev(), XTRX_TRX, XTRX_CH_ALL, XTRX_LMS7_PWR_MODE, pmode);
   }
 
+  if (dict.count("latency")) {
+    _latency = boost::lexical_cast< double >( dict["latency"] ) / 1000.0;
+  }
+
   if (dict.count("timekey")) {
     _timekey = boost::lexical_cast< bool >( dict["timekey"] );
   }
 
+  _convert.set_threads( convert_pool::threads_from_dict( dict ) );
+
   std::cerr << "xtrx_source_c::xtrx_source_c()" << std::endl;
   set_alignment(32);
-  if (_otw == XTRX_WF_16) {
-    if (_mimo_mode)
-      set_output_multiple(4096);
-    else
-      set_output_multiple(8192);
-  } else if (_otw == XTRX_WF_8) {
-    if (_mimo_mode)
-      set_output_multiple(8192);
-    else
-      set_output_multiple(16384);
-  }
+  /* 32 KB packets by default, the buffers get allocated for them and
+   * start() goes down to what latency= allows at the rate */
+  if (_otw == XTRX_WF_8)
+    _max_packet = _mimo_mode ? 8192 : 16384;
+  else
+    _max_packet = _mimo_mode ? 4096 : 8192;
+  set_output_multiple(_max_packet);
 }
 
 xtrx_source_c::~xtrx_source_c()
@@ -231,6 +253,7 @@ double xtrx_source_c::set_sample_rate( double rate )
 {
   std::cerr << "Set sample rate " << rate << std::endl;
   _rate = _xtrx->set_smaplerate(rate, _master, false, _sample_flags);
+  _retag = true;
   return get_sample_rate();
 }
 
@@ -250,11 +273,16 @@ double xtrx_source_c::set_center_freq( double freq, size_t chan )
 {
   boost::mutex::scoped_lock lock(_xtrx->mtx);
 
+  if (_sweep)
+    return get_center_freq(chan);
+
   _freq = freq;
   double corr_freq = (freq)*(1.0 + (_corr) * 0.000001);
 
-  if (_tdd)
+  if (_tdd) {
+    _retag = true;
     return get_center_freq(chan);
+  }
 
   xtrx_channel_t xchan = (xtrx_channel_t)(XTRX_CH_A << chan);
 
@@ -267,14 +295,36 @@ double xtrx_source_c::set_center_freq( double freq, size_t chan )
 
   res = xtrx_tune_ex(_xtrx->dev(), XTRX_TUNE_BB_RX, xchan, _dsp, NULL);
 
+  _retag = true;
+
   return get_center_freq(chan);
 }
 
 double xtrx_source_c::get_center_freq( size_t chan )
 {
+  if (_sweep)
+    return _sweep->freq();
+
   return _freq;
 }
 
+/* The LMS7002M has a single RX PLL for both channels, only the NCOs of
+ * the RxTSP are per channel. So the sweep stays within the band the ADC
+ * sees around the LO, which start() puts into its middle. */
+double xtrx_source_c::tune_sweep( size_t chan, double freq )
+{
+  double actual = 0;
+  xtrx_channel_t xchan = (xtrx_channel_t)(XTRX_CH_A << chan);
+
+  int res = xtrx_tune_ex(_xtrx->dev(), XTRX_TUNE_BB_RX, xchan, freq - _lo, &actual);
+  if (res) {
+    std::cerr << "Unable to move channel " << chan << " to " << freq
+              << ", it is out of the NCO range around " << _lo << std::endl;
+  }
+
+  return _lo + actual;
+}
+
 double xtrx_source_c::set_freq_corr( double ppm, size_t chan )
 {
   _corr = ppm;
@@ -500,10 +550,33 @@ int xtrx_source_c::work (int noutput_items,
                          gr_vector_const_void_star &input_items,
                          gr_vector_void_star &output_items)
 {
+  const bool convert = _convert.threads() > 1;
+
+  /* when sweeping both channels are received here and stitched into
+   * the single output */
+  if (_sweep) {
+    _sweep_ptrs.resize(2);
+    for (size_t i = 0; i < 2; i++) {
+      _sweep_buf[i].resize(noutput_items);
+      _sweep_ptrs[i] = &_sweep_buf[i][0];
+    }
+  }
+
+  gr_vector_void_star &outs = _sweep ? _sweep_ptrs : output_items;
+
+  if (convert) {
+    _buf.resize(outs.size());
+    _buf_ptrs.resize(outs.size());
+    for (size_t i = 0; i < _buf.size(); i++) {
+      _buf[i].resize(2 * noutput_items);
+      _buf_ptrs[i] = &_buf[i][0];
+    }
+  }
+
   xtrx_recv_ex_info_t ri;
   ri.samples = noutput_items;
-  ri.buffer_count = output_items.size();
-  ri.buffers = &output_items[0];
+  ri.buffer_count = outs.size();
+  ri.buffers = convert ? &_buf_ptrs[0] : &outs[0];
   ri.flags = RCVEX_DONT_INSER_ZEROS | RCVEX_DROP_OLD_ON_OVERFLOW;
   ri.timeout = 1000;
 
@@ -514,24 +587,71 @@ int xtrx_source_c::work (int noutput_items,
     throw std::runtime_error( message.str() );
   }
 
-  if (_timekey) {
-    uint64_t seconds = (ri.out_first_sample / _rate);
-    double fractional = (ri.out_first_sample - (uint64_t)(_rate * seconds)) / _rate;
+  if (convert) {
+    _convert.run(ri.out_samples, [&](size_t begin, size_t end) {
+      for (size_t i = 0; i < _buf.size(); i++)
+        convert_s16_fc32(&_buf[i][2 * begin], (gr_complex *)outs[i] + begin,
+                         end - begin, 1.0f / CONVERT_SC16_SCALE);
+    });
+  }
+
+  int produced = ri.out_samples;
+  uint64_t first_sample = ri.out_first_sample;
+  std::vector< std::pair< size_t, double > > hops;
+
+  if (_sweep) {
+    boost::mutex::scoped_lock lock(_xtrx->mtx);
+
+    size_t skipped = 0;
+    double freq = _sweep->freq();
+    produced = _sweep->process((const gr_complex *)outs[0], (const gr_complex *)outs[1],
+                               ri.out_samples, (gr_complex *)output_items[0],
+                               skipped, hops);
+    first_sample += skipped;
+
+    /* still settling, the time gets tagged at the first sample out */
+    if (!produced) {
+      _have_next = false;
+      return 0;
+    }
+
+    _tag_freq = (!hops.empty() && hops[0].first == 0) ? hops[0].second : freq;
+  }
 
-    //std::cerr << "Time " << seconds << ":" << fractional << std::endl;
-    const pmt::pmt_t val = pmt::make_tuple
-        (pmt::from_uint64(seconds),
-         pmt::from_double(fractional));
+  /* only where the sample counter does not simply continue, or the
+   * rate or frequency changed since the last tags */
+  bool retag = _retag.exchange(false);
+  bool gap = _have_next && ri.out_first_sample != _next_sample;
+
+  bool tagged = false;
+
+  if (_timekey && (retag || gap || !_have_next)) {
+    if (!_sweep && (retag || !_have_next))
+      _tag_freq = this->get_center_freq(0);
+
+    const pmt::pmt_t val = tick_time_t(first_sample, _rate).to_rx_time();
     for(size_t i = 0; i < output_items.size(); i++) {
       this->add_item_tag(i, nitems_written(0), TIME_KEY,
                          val, _id);
       this->add_item_tag(i, nitems_written(0), RATE_KEY,
                          pmt::from_double(_rate), _id);
       this->add_item_tag(i, nitems_written(0), FREQ_KEY,
-                         pmt::from_double(this->get_center_freq(i)), _id);
+                         pmt::from_double(_tag_freq), _id);
     }
+    tagged = true;
   }
-  return ri.out_samples;
+
+  for (size_t i = 0; i < hops.size(); i++) {
+    if (tagged && hops[i].first == 0)
+      continue;
+    this->add_item_tag(0, nitems_written(0) + hops[i].first, FREQ_KEY,
+                       pmt::from_double(hops[i].second), _id);
+  }
+
+  _have_next = true;
+  _next_sample = ri.out_first_sample + ri.out_samples;
+
+  return produced;
 }
 
 bool xtrx_source_c::start()
@@ -551,20 +671,36 @@ bool xtrx_source_c::start()
   if (_swap_iq)
     params.rx.flags |= XTRX_RSP_SWAP_IQ;
 
-  params.rx.hfmt = XTRX_IQ_FLOAT32;
+  params.rx.hfmt = (_convert.threads() > 1) ? XTRX_IQ_INT16 : XTRX_IQ_FLOAT32;
   params.rx.wfmt = _otw;
   params.rx.chs = XTRX_CH_AB;
-  params.rx.paketsize = 0;
+  params.rx.paketsize = xtrx_obj::packet_samples(_rate, _latency, _max_packet);
+  set_output_multiple(params.rx.paketsize);
   params.rx_stream_start = 256*1024;
 
   params.nflags = (_loopback) ? XTRX_RUN_DIGLOOPBACK : 0;
 
+  if (_sweep) {
+    const std::vector<double> &steps = _sweep->steps();
+    double lo = (steps.front() + steps.back()) / 2;
+    int res = xtrx_tune_ex(_xtrx->dev(), XTRX_TUNE_RX_FDD, XTRX_CH_AB,
+                           lo * (1.0 + (_corr) * 0.000001), &_lo);
+    if (res) {
+      std::cerr << "Unable to deliver frequency " << lo << std::endl;
+    }
+  }
+
   int res = xtrx_run_ex(_xtrx->dev(), &params);
   if (res) {
     std::cerr << "Got error: " << res << std::endl;
   }
 
-  res = xtrx_tune_ex(_xtrx->dev(), XTRX_TUNE_BB_RX, XTRX_CH_ALL, _dsp, NULL);
+  if (_sweep)
+    _sweep->reset(_rate);
+  else
+    res = xtrx_tune_ex(_xtrx->dev(), XTRX_TUNE_BB_RX, XTRX_CH_ALL, _dsp, NULL);
+
+  _have_next = false;
 
   return res == 0;
 }
@@ -20,11 +20,17 @@
 #ifndef XTRX_SOURCE_C_H
 #define XTRX_SOURCE_C_H
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
 
 #include "source_iface.h"
 #include "xtrx_obj.h"
+#include "convert_pool.h"
+#include "pingpong_sweep.h"
 
 static const pmt::pmt_t TIME_KEY = pmt::string_to_symbol("rx_time");
 static const pmt::pmt_t RATE_KEY = pmt::string_to_symbol("rx_rate");
@@ -92,6 +98,8 @@ public:
   bool stop();
 
 private:
+  double tune_sweep( size_t chan, double freq );
+
   xtrx_obj_sptr _xtrx;
   pmt::pmt_t _id;
 
@@ -105,6 +113,8 @@ private:
 
   xtrx_wire_format_t _otw;
   bool _mimo_mode;
+  double _latency;            // seconds per packet, latency=
+  unsigned _max_packet;       // samples, the default packet of the format
 
   int _gain_lna;
   int _gain_tia;
@@ -119,9 +129,26 @@ private:
   bool     _tdd;
   bool     _fbctrl;
   bool     _timekey;
+  std::atomic<bool> _retag;   // after a retune or rate change
+  bool     _have_next;
+  uint64_t _next_sample;      // where the last block ended
+  double   _tag_freq;
 
   double   _dsp;
   std::string _dev;
+
+  /* convert_threads=, libxtrx then delivers int16 which gets converted
+   * by the pool instead of on the receiving thread */
+  convert_pool _convert;
+  std::vector< std::vector<int16_t> > _buf;
+  std::vector<void *> _buf_ptrs;
+
+  /* sweep=, both channels of the board receive around a common LO and
+   * their NCOs take turns, the one in capture goes to output 0 */
+  std::unique_ptr<pingpong_sweep> _sweep;
+  double _lo;
+  std::vector<gr_complex> _sweep_buf[2];
+  std::vector<void *> _sweep_ptrs;
 };
 
 #endif // XTRX_SOURCE_C_H
@@ -14,6 +14,8 @@ void bind_device(py::module& m)
         .def("to_pp_string", &device_t::to_pp_string)
         .def("to_string", &device_t::to_string);
 
+    py::implicitly_convertible<std::string, device_t>();
+
 
     using devices_t = ::osmosdr::devices_t;
 
@@ -23,5 +25,6 @@ void bind_device(py::module& m)
     using device = ::osmosdr::device;
 
     py::class_<device>(m, "device")
-        .def_static("find", &device::find, py::arg("hint") = device_t());
+        .def_static("find", &device::find, py::arg("hint") = device_t(),
+                    py::call_guard<py::gil_scoped_release>());
 }
@@ -112,6 +112,21 @@
  static const char *__doc_osmosdr_sink_get_bandwidth_range = R"doc()doc";
 
 
+ static const char *__doc_osmosdr_sink_get_stream_stats = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_sink_set_config = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_sink_set_waveform = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_sink_load_waveform = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_sink_clear_waveform = R"doc()doc";
+
+
  static const char *__doc_osmosdr_sink_set_time_source = R"doc()doc";
 
 
@@ -34,13 +34,22 @@
  static const char *__doc_osmosdr_source_seek = R"doc()doc";
 
 
- static const char *__doc_osmosdr_source_get_sample_rates = R"doc()doc";
+ static const char *__doc_osmosdr_source_get_sample_rates_0 = R"doc()doc";
 
 
- static const char *__doc_osmosdr_source_set_sample_rate = R"doc()doc";
+ static const char *__doc_osmosdr_source_get_sample_rates_1 = R"doc()doc";
 
 
- static const char *__doc_osmosdr_source_get_sample_rate = R"doc()doc";
+ static const char *__doc_osmosdr_source_set_sample_rate_0 = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_set_sample_rate_1 = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_get_sample_rate_0 = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_get_sample_rate_1 = R"doc()doc";
 
 
  static const char *__doc_osmosdr_source_get_freq_range = R"doc()doc";
@@ -121,6 +130,30 @@
  static const char *__doc_osmosdr_source_get_bandwidth_range = R"doc()doc";
 
 
+ static const char *__doc_osmosdr_source_get_stream_stats = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_set_hop_freqs = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_hop_center_freq = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_set_hop_schedule = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_set_config = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_read = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_read_into = R"doc()doc";
+
+
+ static const char *__doc_osmosdr_source_stop_read = R"doc()doc";
+
+
  static const char *__doc_osmosdr_source_set_time_source = R"doc()doc";
 
 
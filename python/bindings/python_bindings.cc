@@ -27,6 +27,10 @@ namespace py = pybind11;
 
 void bind_device(py::module& m);
 void bind_ranges(py::module& m);
+void bind_stream_stats(py::module& m);
+void bind_spectrum(py::module& m);
+void bind_vita49_sink(py::module& m);
+void bind_sweeper(py::module& m);
 void bind_time_spec(py::module& m);
 
 
@@ -61,5 +65,9 @@ PYBIND11_MODULE(osmosdr_python, m)
 
     bind_device(m);
     bind_ranges(m);
+    bind_stream_stats(m);
+    bind_spectrum(m);
+    bind_vita49_sink(m);
+    bind_sweeper(m);
     bind_time_spec(m);
 }
@@ -14,7 +14,7 @@
 /* BINDTOOL_GEN_AUTOMATIC(1)                                                       */
 /* BINDTOOL_USE_PYGCCXML(0)                                                        */
 /* BINDTOOL_HEADER_FILE(sink.h)                                        */
-/* BINDTOOL_HEADER_FILE_HASH(d4331eb8a19b7a2aa4ed0100039f7a0e)                     */
+/* BINDTOOL_HEADER_FILE_HASH(219357e6e83858b2cbf6e23729ce033d)                     */
 /***********************************************************************************/
 
 #include <pybind11/complex.h>
@@ -36,7 +36,12 @@ void bind_sink(py::module& m)
     py::class_<sink, gr::hier_block2,
         std::shared_ptr<sink>>(m, "sink", D(sink))
 
-        .def(py::init(&sink::make),
+        /* opening the devices can take seconds, the instance itself
+         * needs the GIL when it is set up afterwards */
+        .def(py::init([](const std::string &args) {
+                py::gil_scoped_release release;
+                return sink::make(args);
+            }),
            py::arg("args") = "",
            D(sink,make)
         )
@@ -46,28 +51,33 @@ void bind_sink(py::module& m)
 
 
         .def("get_num_channels",&sink::get_num_channels,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_num_channels)
         )
 
 
         .def("get_sample_rates",&sink::get_sample_rates,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_sample_rates)
         )
 
 
         .def("set_sample_rate",&sink::set_sample_rate,
             py::arg("rate"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_sample_rate)
         )
 
 
         .def("get_sample_rate",&sink::get_sample_rate,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_sample_rate)
         )
 
 
         .def("get_freq_range",&sink::get_freq_range,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_freq_range)
         )
 
@@ -75,12 +85,14 @@ void bind_sink(py::module& m)
         .def("set_center_freq",&sink::set_center_freq,
             py::arg("freq"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_center_freq)
         )
 
 
         .def("get_center_freq",&sink::get_center_freq,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_center_freq)
         )
 
@@ -88,24 +100,28 @@ void bind_sink(py::module& m)
         .def("set_freq_corr",&sink::set_freq_corr,
             py::arg("ppm"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_freq_corr)
         )
 
 
         .def("get_freq_corr",&sink::get_freq_corr,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_freq_corr)
         )
 
 
         .def("get_gain_names",&sink::get_gain_names,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_gain_names)
         )
 
 
         .def("get_gain_range",(osmosdr::gain_range_t (sink::*)(size_t))&sink::get_gain_range,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_gain_range,0)
         )
 
@@ -113,6 +129,7 @@ void bind_sink(py::module& m)
         .def("get_gain_range",(osmosdr::gain_range_t (sink::*)(std::string const &, size_t))&sink::get_gain_range,
             py::arg("name"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_gain_range,1)
         )
 
@@ -120,12 +137,14 @@ void bind_sink(py::module& m)
         .def("set_gain_mode",&sink::set_gain_mode,
             py::arg("automatic"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_gain_mode)
         )
 
 
         .def("get_gain_mode",&sink::get_gain_mode,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_gain_mode)
         )
 
@@ -133,6 +152,7 @@ void bind_sink(py::module& m)
         .def("set_gain",(double (sink::*)(double, size_t))&sink::set_gain,
             py::arg("gain"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_gain,0)
         )
 
@@ -141,12 +161,14 @@ void bind_sink(py::module& m)
             py::arg("gain"),
             py::arg("name"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_gain,1)
         )
 
 
         .def("get_gain",(double (sink::*)(size_t))&sink::get_gain,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_gain,0)
         )
 
@@ -154,6 +176,7 @@ void bind_sink(py::module& m)
         .def("get_gain",(double (sink::*)(std::string const &, size_t))&sink::get_gain,
             py::arg("name"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_gain,1)
         )
 
@@ -161,6 +184,7 @@ void bind_sink(py::module& m)
         .def("set_if_gain",&sink::set_if_gain,
             py::arg("gain"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_if_gain)
         )
 
@@ -168,12 +192,14 @@ void bind_sink(py::module& m)
         .def("set_bb_gain",&sink::set_bb_gain,
             py::arg("gain"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_bb_gain)
         )
 
 
         .def("get_antennas",&sink::get_antennas,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_antennas)
         )
 
@@ -181,12 +207,14 @@ void bind_sink(py::module& m)
         .def("set_antenna",&sink::set_antenna,
             py::arg("antenna"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_antenna)
         )
 
 
         .def("get_antenna",&sink::get_antenna,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_antenna)
         )
 
@@ -194,6 +222,7 @@ void bind_sink(py::module& m)
         .def("set_dc_offset",&sink::set_dc_offset,
             py::arg("offset"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_dc_offset)
         )
 
@@ -201,6 +230,7 @@ void bind_sink(py::module& m)
         .def("set_iq_balance",&sink::set_iq_balance,
             py::arg("balance"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_iq_balance)
         )
 
@@ -208,37 +238,82 @@ void bind_sink(py::module& m)
         .def("set_bandwidth",&sink::set_bandwidth,
             py::arg("bandwidth"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_bandwidth)
         )
 
 
         .def("get_bandwidth",&sink::get_bandwidth,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_bandwidth)
         )
 
 
         .def("get_bandwidth_range",&sink::get_bandwidth_range,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_bandwidth_range)
         )
 
 
+        .def("get_stream_stats",&sink::get_stream_stats,
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(sink,get_stream_stats)
+        )
+
+
+        .def("set_config",&sink::set_config,
+            py::arg("config"),
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(sink,set_config)
+        )
+
+
+        .def("set_waveform",&sink::set_waveform,
+            py::arg("samples"),
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(sink,set_waveform)
+        )
+
+
+        .def("load_waveform",&sink::load_waveform,
+            py::arg("filename"),
+            py::arg("format") = "cf32",
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(sink,load_waveform)
+        )
+
+
+        .def("clear_waveform",&sink::clear_waveform,
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(sink,clear_waveform)
+        )
+
+
         .def("set_time_source",&sink::set_time_source,
             py::arg("source"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_time_source)
         )
 
 
         .def("get_time_source",&sink::get_time_source,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_time_source)
         )
 
 
         .def("get_time_sources",&sink::get_time_sources,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_time_sources)
         )
 
@@ -246,24 +321,28 @@ void bind_sink(py::module& m)
         .def("set_clock_source",&sink::set_clock_source,
             py::arg("source"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_clock_source)
         )
 
 
         .def("get_clock_source",&sink::get_clock_source,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_clock_source)
         )
 
 
         .def("get_clock_sources",&sink::get_clock_sources,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_clock_sources)
         )
 
 
         .def("get_clock_rate",&sink::get_clock_rate,
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_clock_rate)
         )
 
@@ -271,18 +350,21 @@ void bind_sink(py::module& m)
         .def("set_clock_rate",&sink::set_clock_rate,
             py::arg("rate"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_clock_rate)
         )
 
 
         .def("get_time_now",&sink::get_time_now,
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_time_now)
         )
 
 
         .def("get_time_last_pps",&sink::get_time_last_pps,
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,get_time_last_pps)
         )
 
@@ -290,18 +372,21 @@ void bind_sink(py::module& m)
         .def("set_time_now",&sink::set_time_now,
             py::arg("time_spec"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_time_now)
         )
 
 
         .def("set_time_next_pps",&sink::set_time_next_pps,
             py::arg("time_spec"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_time_next_pps)
         )
 
 
         .def("set_time_unknown_pps",&sink::set_time_unknown_pps,
             py::arg("time_spec"),
+            py::call_guard<py::gil_scoped_release>(),
             D(sink,set_time_unknown_pps)
         )
 
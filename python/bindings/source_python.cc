@@ -14,10 +14,11 @@
 /* BINDTOOL_GEN_AUTOMATIC(1)                                                       */
 /* BINDTOOL_USE_PYGCCXML(0)                                                        */
 /* BINDTOOL_HEADER_FILE(source.h)                                        */
-/* BINDTOOL_HEADER_FILE_HASH(d1a3d9ea3d815fe4f18acc3eef21f1b6)                     */
+/* BINDTOOL_HEADER_FILE_HASH(7b6c03d548a3779e7c86e8dc56331027)                     */
 /***********************************************************************************/
 
 #include <pybind11/complex.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -36,7 +37,12 @@ void bind_source(py::module& m)
     py::class_<source, gr::hier_block2,
         std::shared_ptr<source>>(m, "source", D(source))
 
-        .def(py::init(&source::make),
+        /* opening the devices can take seconds, the instance itself
+         * needs the GIL when it is set up afterwards */
+        .def(py::init([](const std::string &args) {
+                py::gil_scoped_release release;
+                return source::make(args);
+            }),
            py::arg("args") = "",
            D(source,make)
         )
@@ -46,6 +52,7 @@ void bind_source(py::module& m)
 
 
         .def("get_num_channels",&source::get_num_channels,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_num_channels)
         )
 
@@ -54,28 +61,55 @@ void bind_source(py::module& m)
             py::arg("seek_point"),
             py::arg("whence"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,seek)
         )
 
 
-        .def("get_sample_rates",&source::get_sample_rates,
-            D(source,get_sample_rates)
+        .def("get_sample_rates",(osmosdr::meta_range_t (source::*)())&source::get_sample_rates,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,get_sample_rates,0)
         )
 
 
-        .def("set_sample_rate",&source::set_sample_rate,
+        .def("set_sample_rate",(double (source::*)(double))&source::set_sample_rate,
             py::arg("rate"),
-            D(source,set_sample_rate)
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,set_sample_rate,0)
         )
 
 
-        .def("get_sample_rate",&source::get_sample_rate,
-            D(source,get_sample_rate)
+        .def("get_sample_rate",(double (source::*)())&source::get_sample_rate,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,get_sample_rate,0)
+        )
+
+
+        .def("get_sample_rates",(osmosdr::meta_range_t (source::*)(size_t))&source::get_sample_rates,
+            py::arg("chan"),
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,get_sample_rates,1)
+        )
+
+
+        .def("set_sample_rate",(double (source::*)(double, size_t))&source::set_sample_rate,
+            py::arg("rate"),
+            py::arg("chan"),
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,set_sample_rate,1)
+        )
+
+
+        .def("get_sample_rate",(double (source::*)(size_t))&source::get_sample_rate,
+            py::arg("chan"),
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,get_sample_rate,1)
         )
 
 
         .def("get_freq_range",&source::get_freq_range,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_freq_range)
         )
 
@@ -83,12 +117,14 @@ void bind_source(py::module& m)
         .def("set_center_freq",&source::set_center_freq,
             py::arg("freq"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_center_freq)
         )
 
 
         .def("get_center_freq",&source::get_center_freq,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_center_freq)
         )
 
@@ -96,24 +132,28 @@ void bind_source(py::module& m)
         .def("set_freq_corr",&source::set_freq_corr,
             py::arg("ppm"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_freq_corr)
         )
 
 
         .def("get_freq_corr",&source::get_freq_corr,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_freq_corr)
         )
 
 
         .def("get_gain_names",&source::get_gain_names,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_gain_names)
         )
 
 
         .def("get_gain_range",(osmosdr::gain_range_t (source::*)(size_t))&source::get_gain_range,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_gain_range,0)
         )
 
@@ -121,6 +161,7 @@ void bind_source(py::module& m)
         .def("get_gain_range",(osmosdr::gain_range_t (source::*)(std::string const &, size_t))&source::get_gain_range,
             py::arg("name"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_gain_range,1)
         )
 
@@ -128,12 +169,14 @@ void bind_source(py::module& m)
         .def("set_gain_mode",&source::set_gain_mode,
             py::arg("automatic"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_gain_mode)
         )
 
 
         .def("get_gain_mode",&source::get_gain_mode,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_gain_mode)
         )
 
@@ -141,6 +184,7 @@ void bind_source(py::module& m)
         .def("set_gain",(double (source::*)(double, size_t))&source::set_gain,
             py::arg("gain"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_gain,0)
         )
 
@@ -149,12 +193,14 @@ void bind_source(py::module& m)
             py::arg("gain"),
             py::arg("name"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_gain,1)
         )
 
 
         .def("get_gain",(double (source::*)(size_t))&source::get_gain,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_gain,0)
         )
 
@@ -162,6 +208,7 @@ void bind_source(py::module& m)
         .def("get_gain",(double (source::*)(std::string const &, size_t))&source::get_gain,
             py::arg("name"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_gain,1)
         )
 
@@ -169,6 +216,7 @@ void bind_source(py::module& m)
         .def("set_if_gain",&source::set_if_gain,
             py::arg("gain"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_if_gain)
         )
 
@@ -176,12 +224,14 @@ void bind_source(py::module& m)
         .def("set_bb_gain",&source::set_bb_gain,
             py::arg("gain"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_bb_gain)
         )
 
 
         .def("get_antennas",&source::get_antennas,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_antennas)
         )
 
@@ -189,12 +239,14 @@ void bind_source(py::module& m)
         .def("set_antenna",&source::set_antenna,
             py::arg("antenna"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_antenna)
         )
 
 
         .def("get_antenna",&source::get_antenna,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_antenna)
         )
 
@@ -202,6 +254,7 @@ void bind_source(py::module& m)
         .def("set_dc_offset_mode",&source::set_dc_offset_mode,
             py::arg("mode"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_dc_offset_mode)
         )
 
@@ -209,6 +262,7 @@ void bind_source(py::module& m)
         .def("set_dc_offset",&source::set_dc_offset,
             py::arg("offset"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_dc_offset)
         )
 
@@ -216,6 +270,7 @@ void bind_source(py::module& m)
         .def("set_iq_balance_mode",&source::set_iq_balance_mode,
             py::arg("mode"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_iq_balance_mode)
         )
 
@@ -223,6 +278,7 @@ void bind_source(py::module& m)
         .def("set_iq_balance",&source::set_iq_balance,
             py::arg("balance"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_iq_balance)
         )
 
@@ -230,37 +286,124 @@ void bind_source(py::module& m)
         .def("set_bandwidth",&source::set_bandwidth,
             py::arg("bandwidth"),
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_bandwidth)
         )
 
 
         .def("get_bandwidth",&source::get_bandwidth,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_bandwidth)
         )
 
 
         .def("get_bandwidth_range",&source::get_bandwidth_range,
             py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_bandwidth_range)
         )
 
 
+        .def("get_stream_stats",&source::get_stream_stats,
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,get_stream_stats)
+        )
+
+
+        .def("set_hop_freqs",&source::set_hop_freqs,
+            py::arg("freqs"),
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,set_hop_freqs)
+        )
+
+
+        .def("hop_center_freq",&source::hop_center_freq,
+            py::arg("index"),
+            py::arg("time"),
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,hop_center_freq)
+        )
+
+
+        .def("set_hop_schedule",&source::set_hop_schedule,
+            py::arg("freqs"),
+            py::arg("dwell"),
+            py::arg("start_time"),
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,set_hop_schedule)
+        )
+
+
+        .def("set_config",&source::set_config,
+            py::arg("config"),
+            py::arg("chan") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,set_config)
+        )
+
+
+        .def("read",
+            [](source &self, size_t nitems, size_t chan) {
+                py::array_t<gr_complex> samples(nitems);
+                size_t n;
+                {
+                    py::gil_scoped_release release;
+                    n = self.read(samples.mutable_data(), nitems, chan);
+                }
+                if (n < nitems)
+                    samples.resize({ n });
+                return samples;
+            },
+            py::arg("nitems"),
+            py::arg("chan") = 0,
+            D(source,read)
+        )
+
+
+        .def("read_into",
+            [](source &self,
+               py::array_t<gr_complex, py::array::c_style> samples,
+               size_t chan) {
+                gr_complex *buf = samples.mutable_data();
+                const size_t nitems = samples.size();
+                py::gil_scoped_release release;
+                return self.read(buf, nitems, chan);
+            },
+            py::arg("samples"),
+            py::arg("chan") = 0,
+            D(source,read_into)
+        )
+
+
+        .def("stop_read",&source::stop_read,
+            py::call_guard<py::gil_scoped_release>(),
+            D(source,stop_read)
+        )
+
+
         .def("set_time_source",&source::set_time_source,
             py::arg("source"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_time_source)
         )
 
 
         .def("get_time_source",&source::get_time_source,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_time_source)
         )
 
 
         .def("get_time_sources",&source::get_time_sources,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_time_sources)
         )
 
@@ -268,24 +411,28 @@ void bind_source(py::module& m)
         .def("set_clock_source",&source::set_clock_source,
             py::arg("source"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_clock_source)
         )
 
 
         .def("get_clock_source",&source::get_clock_source,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_clock_source)
         )
 
 
         .def("get_clock_sources",&source::get_clock_sources,
             py::arg("mboard"),
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_clock_sources)
         )
 
 
         .def("get_clock_rate",&source::get_clock_rate,
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_clock_rate)
         )
 
@@ -293,18 +440,21 @@ void bind_source(py::module& m)
         .def("set_clock_rate",&source::set_clock_rate,
             py::arg("rate"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_clock_rate)
         )
 
 
         .def("get_time_now",&source::get_time_now,
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_time_now)
         )
 
 
         .def("get_time_last_pps",&source::get_time_last_pps,
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,get_time_last_pps)
         )
 
@@ -312,18 +462,21 @@ void bind_source(py::module& m)
         .def("set_time_now",&source::set_time_now,
             py::arg("time_spec"),
             py::arg("mboard") = 0,
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_time_now)
         )
 
 
         .def("set_time_next_pps",&source::set_time_next_pps,
             py::arg("time_spec"),
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_time_next_pps)
         )
 
 
         .def("set_time_unknown_pps",&source::set_time_unknown_pps,
             py::arg("time_spec"),
+            py::call_guard<py::gil_scoped_release>(),
             D(source,set_time_unknown_pps)
         )
 
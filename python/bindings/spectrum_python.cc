@@ -0,0 +1,31 @@
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include <osmosdr/spectrum.h>
+
+void bind_spectrum(py::module& m)
+{
+    using spectrum = ::osmosdr::spectrum;
+
+    py::class_<spectrum, gr::sync_block, gr::block, gr::basic_block,
+        std::shared_ptr<spectrum>>(m, "spectrum")
+
+        .def(py::init(&spectrum::make),
+           py::arg("sample_rate"),
+           py::arg("fft_size") = 1024,
+           py::arg("frame_rate") = 10,
+           py::arg("average") = 8,
+           py::arg("freq") = 0)
+
+        .def("set_sample_rate", &spectrum::set_sample_rate,
+            py::arg("rate"))
+
+        .def("set_center_freq", &spectrum::set_center_freq,
+            py::arg("freq"))
+
+        .def("set_frame_rate", &spectrum::set_frame_rate,
+            py::arg("frame_rate"))
+
+        .def("get_frames", &spectrum::get_frames);
+}
@@ -0,0 +1,31 @@
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include <osmosdr/stream_stats.h>
+
+void bind_stream_stats(py::module& m)
+{
+    using stream_stats_t = ::osmosdr::stream_stats_t;
+
+    py::class_<stream_stats_t>(m, "stream_stats_t")
+        .def(py::init())
+        .def_readwrite("samples", &stream_stats_t::samples)
+        .def_readwrite("dropped", &stream_stats_t::dropped)
+        .def_readwrite("overruns", &stream_stats_t::overruns)
+        .def_readwrite("underruns", &stream_stats_t::underruns)
+        .def_readwrite("lost_packets", &stream_stats_t::lost_packets)
+        .def_readwrite("late", &stream_stats_t::late)
+        .def_readwrite("bursts", &stream_stats_t::bursts)
+        .def_readwrite("clipped", &stream_stats_t::clipped)
+        .def_readwrite("restarts", &stream_stats_t::restarts)
+        .def_readwrite("fill", &stream_stats_t::fill)
+        .def_readwrite("fill_max", &stream_stats_t::fill_max)
+        .def_readwrite("capacity", &stream_stats_t::capacity)
+        .def_readwrite("latency_p50", &stream_stats_t::latency_p50)
+        .def_readwrite("latency_p99", &stream_stats_t::latency_p99)
+        .def_readwrite("latency_max", &stream_stats_t::latency_max)
+        .def_readwrite("fill_p50", &stream_stats_t::fill_p50)
+        .def_readwrite("fill_p99", &stream_stats_t::fill_p99)
+        .def_readwrite("power", &stream_stats_t::power);
+}
@@ -0,0 +1,30 @@
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include <osmosdr/sweeper.h>
+
+void bind_sweeper(py::module& m)
+{
+    using sweeper = ::osmosdr::sweeper;
+
+    py::class_<sweeper, gr::sync_block, gr::block, gr::basic_block,
+        std::shared_ptr<sweeper>>(m, "sweeper")
+
+        .def(py::init(&sweeper::make),
+           py::arg("src"),
+           py::arg("start"),
+           py::arg("stop"),
+           py::arg("step"),
+           py::arg("fft_size") = 1024,
+           py::arg("dwell") = 8,
+           py::arg("settle") = 0,
+           py::arg("chan") = 0)
+
+        .def("set_range", &sweeper::set_range,
+            py::arg("start"),
+            py::arg("stop"),
+            py::arg("step"))
+
+        .def("get_sweeps", &sweeper::get_sweeps);
+}
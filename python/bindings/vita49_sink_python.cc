@@ -0,0 +1,35 @@
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include <osmosdr/vita49_sink.h>
+
+void bind_vita49_sink(py::module& m)
+{
+    using vita49_sink = ::osmosdr::vita49_sink;
+
+    py::class_<vita49_sink, gr::sync_block, gr::block, gr::basic_block,
+        std::shared_ptr<vita49_sink>>(m, "vita49_sink")
+
+        .def(py::init(&vita49_sink::make),
+           py::arg("address"),
+           py::arg("port"),
+           py::arg("sample_rate"),
+           py::arg("format") = "cs16",
+           py::arg("freq") = 0,
+           py::arg("stream_id") = 0,
+           py::arg("scale") = 1.0,
+           py::arg("packet_bytes") = 1472,
+           py::arg("ttl") = 1)
+
+        .def("set_sample_rate", &vita49_sink::set_sample_rate,
+            py::arg("rate"))
+
+        .def("set_center_freq", &vita49_sink::set_center_freq,
+            py::arg("freq"))
+
+        .def("set_scale", &vita49_sink::set_scale,
+            py::arg("scale"))
+
+        .def("get_packets", &vita49_sink::get_packets);
+}